@@ -24,6 +24,13 @@
 		PLAYBACK and RECORDING means threads feeding/reading ACTUAL
 		HARDWARE ONLY.
 		0 means don't care
+
+	Threads that need to run for a certain time in every period, like audio
+	threads, can instead be guaranteed that with set_thread_deadline(). Such
+	a thread gets \a runtime of CPU time within \a deadline after the start
+	of each \a period, before any thread with a normal priority, as long as
+	it does not run longer. The call fails with B_BUSY if that could not be
+	guaranteed anymore. A \a runtime of 0 makes it a normal thread again.
 */
 
 /* bitmasks for suggest_thread_priority() */
@@ -63,6 +70,9 @@ int32 suggest_thread_priority(uint32 task_flags = B_DEFAULT_MEDIA_PRIORITY,
 bigtime_t estimate_max_scheduling_latency(thread_id th = -1);
 	/* default is current thread */
 
+status_t set_thread_deadline(thread_id thread, bigtime_t runtime,
+	bigtime_t deadline, bigtime_t period);
+
 status_t set_scheduler_mode(int32 mode);
 int32 get_scheduler_mode(void);
 
@@ -75,6 +85,9 @@ int32 suggest_thread_priority(uint32 what, int32 period, bigtime_t jitter,
 bigtime_t estimate_max_scheduling_latency(thread_id th);
 	/* default is current thread */
 
+status_t set_thread_deadline(thread_id thread, bigtime_t runtime,
+	bigtime_t deadline, bigtime_t period);
+
 status_t set_scheduler_mode(int32 mode);
 int32 get_scheduler_mode(void);
 
@@ -63,8 +63,10 @@ public:
 			status_t		SetVolume(const BVolume* volume);
 			status_t		SetPredicate(const char* expression);
 			status_t		SetTarget(BMessenger messenger);
+			status_t		SetFlags(uint32 flags);
 
 			bool			IsLive() const;
+			uint32			Flags() const;
 
 			status_t		GetPredicate(char* buffer, size_t length);
 			status_t		GetPredicate(BString* predicate);
@@ -106,7 +108,8 @@ private:
 			port_id			fPort;
 			long			fToken;
 			int				fQueryFd;
-			int32			_reservedData[4];
+			uint32			fFlags;
+			int32			_reservedData[3];
 };
 
 #endif	// _QUERY_H
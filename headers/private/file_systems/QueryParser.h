@@ -20,6 +20,7 @@
 // are.
 
 #ifdef FS_SHELL
+#	include <algorithm>
 #	include <new>
 
 #	include "fssh_api_wrapper.h"
@@ -73,6 +74,7 @@ namespace QueryParser {
 
 template<typename QueryPolicy> class Equation;
 template<typename QueryPolicy> class Expression;
+template<typename QueryPolicy> class Operator;
 template<typename QueryPolicy> class Term;
 template<typename QueryPolicy> class Query;
 
@@ -95,6 +97,22 @@ enum ops {
 };
 
 
+// The query planner assumes that reading an index entry costs only this
+// fraction of loading a node, as index entries are read sequentially, and
+// many of them share a single block.
+static const off_t kIndexEntryCostDivisor = 32;
+
+// The maximum number of node IDs the planner collects from a single index
+static const int32 kMaxPlannedNodeIDs = 32768;
+
+// Children of an AND operator the planner collects the node IDs for
+enum {
+	COLLECT_LEFT	= 0x01,
+	COLLECT_RIGHT	= 0x02,
+	COLLECT_BOTH	= COLLECT_LEFT | COLLECT_RIGHT
+};
+
+
 template<typename QueryPolicy>
 union value {
 	int64	Int64;
@@ -107,6 +125,150 @@ union value {
 };
 
 
+/*!	The query planner's estimate for evaluating a term by collecting the node
+	IDs of the matching index entries.
+*/
+struct plan_estimate {
+	off_t	scanned;
+		// index entries to read
+	off_t	matches;
+		// node IDs in the resulting set
+	off_t	total;
+		// entries in the largest index involved
+	bool	exact;
+		// the set does not need to be matched against the nodes again
+};
+
+
+/*!	A sorted set of node IDs, as collected from an index scan. Sets of
+	different index scans can be intersected or united without having to
+	look at the nodes themselves.
+*/
+class NodeIDSet {
+public:
+	NodeIDSet()
+		:
+		fIDs(NULL),
+		fCount(0),
+		fCapacity(0)
+	{
+	}
+
+	~NodeIDSet()
+	{
+		free(fIDs);
+	}
+
+	int32 Count() const
+	{
+		return fCount;
+	}
+
+	ino_t IDAt(int32 index) const
+	{
+		return fIDs[index];
+	}
+
+	void MakeEmpty()
+	{
+		free(fIDs);
+		fIDs = NULL;
+		fCount = 0;
+		fCapacity = 0;
+	}
+
+	/*!	Adds the ID to the end of the set; you need to call Sort() after
+		you're done adding IDs.
+	*/
+	status_t Add(ino_t id)
+	{
+		if (fCount == fCapacity) {
+			int32 capacity = fCapacity > 0 ? fCapacity * 2 : 64;
+			ino_t* ids = (ino_t*)realloc(fIDs, capacity * sizeof(ino_t));
+			if (ids == NULL)
+				return B_NO_MEMORY;
+
+			fIDs = ids;
+			fCapacity = capacity;
+		}
+
+		fIDs[fCount++] = id;
+		return B_OK;
+	}
+
+	void Sort()
+	{
+		std::sort(fIDs, fIDs + fCount);
+		fCount = std::unique(fIDs, fIDs + fCount) - fIDs;
+	}
+
+	void Intersect(const NodeIDSet& other)
+	{
+		int32 count = 0;
+		int32 i = 0;
+		int32 j = 0;
+
+		while (i < fCount && j < other.fCount) {
+			if (fIDs[i] < other.fIDs[j])
+				i++;
+			else if (fIDs[i] > other.fIDs[j])
+				j++;
+			else {
+				fIDs[count++] = fIDs[i++];
+				j++;
+			}
+		}
+
+		fCount = count;
+	}
+
+	status_t Unite(const NodeIDSet& other)
+	{
+		if (other.fCount == 0)
+			return B_OK;
+
+		int32 capacity = fCount + other.fCount;
+		ino_t* ids = (ino_t*)malloc(capacity * sizeof(ino_t));
+		if (ids == NULL)
+			return B_NO_MEMORY;
+
+		fCount = std::set_union(fIDs, fIDs + fCount, other.fIDs,
+			other.fIDs + other.fCount, ids) - ids;
+		free(fIDs);
+		fIDs = ids;
+		fCapacity = capacity;
+		return B_OK;
+	}
+
+private:
+	NodeIDSet(const NodeIDSet& other);
+	NodeIDSet& operator=(const NodeIDSet& other);
+		// no implementation
+
+	ino_t*	fIDs;
+	int32	fCount;
+	int32	fCapacity;
+};
+
+
+static inline const char*
+getOperatorSymbol(int8 op)
+{
+	switch (op) {
+		case OP_EQUAL: return "==";
+		case OP_UNEQUAL: return "!=";
+		case OP_GREATER_THAN: return ">";
+		case OP_GREATER_THAN_OR_EQUAL: return ">=";
+		case OP_LESS_THAN: return "<";
+		case OP_LESS_THAN_OR_EQUAL: return "<=";
+		case OP_AND: return "&&";
+		case OP_OR: return "||";
+	}
+	return "???";
+}
+
+
+
 template<typename QueryPolicy>
 class Query {
 public:
@@ -147,10 +309,22 @@ public:
 
 private:
 			status_t		_GetNextEntry(struct dirent* dirent, size_t size);
+			status_t		_GetNextNodeIDEntry(struct dirent* dirent,
+								size_t size);
 			void			_SendEntryNotification(Entry* entry,
 								status_t (*notify)(port_id, int32, dev_t, ino_t,
 									const char*, ino_t));
 
+			void			_Plan();
+			off_t			_IndexScanCost(Term<QueryPolicy>* term);
+			bool			_EstimateNodeIDs(Term<QueryPolicy>* term,
+								plan_estimate& estimate);
+			uint32			_ChooseChildren(Operator<QueryPolicy>* op,
+								plan_estimate& estimate);
+			status_t		_CollectNodeIDs(Term<QueryPolicy>* term,
+								NodeIDSet& set);
+			void			_PrintPlan(Term<QueryPolicy>* term, int32 level);
+
 private:
 			Context*		fContext;
 			Expression<QueryPolicy>* fExpression;
@@ -159,6 +333,12 @@ private:
 			Index			fIndex;
 			Stack<Equation<QueryPolicy>*> fStack;
 
+			NodeIDSet		fNodeIDs;
+			int32			fNodeIDIndex;
+			bool			fUseNodeIDs;
+			bool			fNodeIDsCollected;
+			bool			fNodeIDsExact;
+
 			uint32			fFlags;
 			port_id			fPort;
 			int32			fToken;
@@ -252,10 +432,21 @@ public:
 			status_t	GetNextMatching(Context* context,
 							IndexIterator* iterator, struct dirent* dirent,
 							size_t bufferSize);
+			status_t	CollectMatching(IndexIterator* iterator,
+							NodeIDSet& set, int32 maxCount);
 
 	virtual	void		CalculateScore(Index &index);
 	virtual	int32		Score() const { return fScore; }
 
+			const char*	Attribute() const { return fAttribute; }
+			const char*	String() const { return fString; }
+			bool		HasIndex() const { return fHasIndex; }
+
+			off_t		EstimatedMatches() const
+							{ return fEstimatedMatches; }
+			off_t		EstimatedScan() const { return fEstimatedScan; }
+			off_t		EstimatedTotal() const { return fEstimatedTotal; }
+
 	virtual	bool		NeedsEntry();
 
 #ifdef DEBUG_QUERY
@@ -271,6 +462,8 @@ private:
 			bool		CompareTo(const uint8* value, size_t size);
 			uint8*		Value() const { return (uint8*)&fValue; }
 
+			void		_EstimateMatches(Index& index);
+
 			char*		fAttribute;
 			char*		fString;
 			union value<QueryPolicy> fValue;
@@ -280,6 +473,10 @@ private:
 
 			int32		fScore;
 			bool		fHasIndex;
+
+			off_t		fEstimatedMatches;
+			off_t		fEstimatedScan;
+			off_t		fEstimatedTotal;
 };
 
 
@@ -358,6 +555,27 @@ private:
 };
 
 
+template<typename QueryPolicy>
+static void
+fillDirent(typename QueryPolicy::Context* context,
+	typename QueryPolicy::Entry* entry, struct dirent* dirent,
+	size_t bufferSize)
+{
+	ssize_t nameLength = QueryPolicy::EntryGetName(entry, dirent->d_name,
+		(const char*)dirent + bufferSize - dirent->d_name);
+	if (nameLength < 0) {
+		// Invalid or unknown name.
+		nameLength = 0;
+	}
+
+	dirent->d_dev = QueryPolicy::ContextGetVolumeID(context);
+	dirent->d_ino = QueryPolicy::EntryGetNodeID(entry);
+	dirent->d_pdev = dirent->d_dev;
+	dirent->d_pino = QueryPolicy::EntryGetParentID(entry);
+	dirent->d_reclen = offsetof(struct dirent, d_name) + nameLength;
+}
+
+
 //	#pragma mark -
 
 
@@ -369,7 +587,11 @@ Equation<QueryPolicy>::Equation(const char** expr)
 	fString(NULL),
 	fType(0),
 	fIsPattern(false),
-	fScore(INT32_MAX)
+	fScore(INT32_MAX),
+	fHasIndex(false),
+	fEstimatedMatches(-1),
+	fEstimatedScan(-1),
+	fEstimatedTotal(-1)
 {
 	const char* string = *expr;
 	const char* start = string;
@@ -760,12 +982,27 @@ Equation<QueryPolicy>::CalculateScore(Index &index)
 	// As always, these values could be tuned and refined.
 	// And the code could also need some real world testing :-)
 
+	fEstimatedMatches = -1;
+	fEstimatedScan = -1;
+	fEstimatedTotal = -1;
+
 	// do we have to operate on a "foreign" index?
 	if (QueryPolicy::IndexSetTo(index, fAttribute) < B_OK) {
 		fScore = INT32_MAX;
 		return;
 	}
 
+	// If the file system can estimate the number of matching entries, this
+	// is better than any guess based on the size of the index
+	_EstimateMatches(index);
+	if (fEstimatedMatches >= 0) {
+		// OP_UNEQUAL has to load all nodes of the whole index
+		off_t nodes = Term<QueryPolicy>::fOp == OP_UNEQUAL
+			? fEstimatedScan : fEstimatedMatches;
+		fScore = nodes < INT32_MAX ? (int32)nodes : INT32_MAX - 1;
+		return;
+	}
+
 	fScore = QueryPolicy::IndexGetSize(index);
 
 	if (Term<QueryPolicy>::fOp == OP_UNEQUAL) {
@@ -793,6 +1030,112 @@ Equation<QueryPolicy>::CalculateScore(Index &index)
 }
 
 
+/*!	Estimates how many entries of the \a index match the equation, and how
+	many index entries have to be read to find them, from the statistics the
+	file system can provide about the index.
+	Leaves the estimates at -1 if that is not possible.
+*/
+template<typename QueryPolicy>
+void
+Equation<QueryPolicy>::_EstimateMatches(Index& index)
+{
+	if (ConvertValue(QueryPolicy::IndexGetType(index),
+			QueryPolicy::IndexGetKeySize(index)) != B_OK)
+		return;
+
+	off_t before;
+	off_t equal;
+	off_t total;
+	off_t matches;
+	off_t scan;
+
+	if (fIsPattern) {
+		// Only the part in front of the first wildcard narrows down the range
+		// of keys that has to be scanned
+		int32 prefixLength = getFirstPatternSymbol(fString);
+		if (prefixLength <= 0) {
+			if (QueryPolicy::IndexEstimateEntries(index, NULL, 0, &before,
+					&equal, &total) != B_OK)
+				return;
+
+			scan = total;
+		} else {
+			if (QueryPolicy::IndexEstimateEntries(index, fValue.String,
+					prefixLength, &before, &equal, &total) != B_OK)
+				return;
+
+			// find the first key that follows all keys with that prefix
+			char end[QueryPolicy::kMaxFileNameLength];
+			memcpy(end, fValue.String, prefixLength);
+			int32 endLength = prefixLength;
+			while (endLength > 0 && (uint8)end[endLength - 1] == 0xff)
+				endLength--;
+
+			off_t endBefore = total;
+			if (endLength > 0) {
+				end[endLength - 1]++;
+				if (QueryPolicy::IndexEstimateEntries(index, end, endLength,
+						&endBefore, &equal, &total) != B_OK)
+					return;
+			}
+			scan = endBefore - before;
+		}
+
+		matches = scan;
+		if (Term<QueryPolicy>::fOp == OP_UNEQUAL) {
+			matches = total - matches;
+			scan = total;
+		}
+	} else {
+		// the empty string is looked up with its terminating null byte, see
+		// PrepareQuery()
+		int32 keySize = fSize > 0 ? fSize : 1;
+		if (QueryPolicy::IndexEstimateEntries(index, Value(), keySize, &before,
+				&equal, &total) != B_OK)
+			return;
+
+		switch (Term<QueryPolicy>::fOp) {
+			case OP_EQUAL:
+				matches = scan = equal;
+				break;
+			case OP_UNEQUAL:
+				matches = total - equal;
+				scan = total;
+				break;
+			case OP_LESS_THAN:
+				matches = scan = before;
+				break;
+			case OP_LESS_THAN_OR_EQUAL:
+				matches = scan = before + equal;
+				break;
+			case OP_GREATER_THAN:
+				matches = total - before - equal;
+				scan = total - before;
+				break;
+			case OP_GREATER_THAN_OR_EQUAL:
+			default:
+				matches = scan = total - before;
+				break;
+		}
+	}
+
+	if (total < 0)
+		total = 0;
+	if (matches < 0)
+		matches = 0;
+	else if (matches > total)
+		matches = total;
+	if (scan < matches)
+		scan = matches;
+	else if (scan > total)
+		scan = total;
+
+	fEstimatedMatches = matches;
+	fEstimatedScan = scan;
+	fEstimatedTotal = total;
+}
+
+
 template<typename QueryPolicy>
 status_t
 Equation<QueryPolicy>::PrepareQuery(Context* /*context*/, Index& index,
@@ -972,25 +1315,58 @@ Equation<QueryPolicy>::GetNextMatching(Context* context,
 		}
 
 		if (status == MATCH_OK) {
-			ssize_t nameLength = QueryPolicy::EntryGetName(entry,
-				dirent->d_name,
-				(const char*)dirent + bufferSize - dirent->d_name);
-			if (nameLength < 0) {
-				// Invalid or unknown name.
-				nameLength = 0;
-			}
+			fillDirent<QueryPolicy>(context, entry, dirent, bufferSize);
+			return B_OK;
+		}
+	}
+	QUERY_RETURN_ERROR(B_ERROR);
+}
+
+
+/*!	Adds the IDs of all nodes whose index entries match the equation to
+	\a set, without loading the nodes. The \a iterator must have been
+	prepared by PrepareQuery() for an equation that has an index.
+	Returns \c B_BUFFER_OVERFLOW if more than \a maxCount entries match.
+*/
+template<typename QueryPolicy>
+status_t
+Equation<QueryPolicy>::CollectMatching(IndexIterator* iterator,
+	NodeIDSet& set, int32 maxCount)
+{
+	while (true) {
+		union value<QueryPolicy> indexValue;
+		size_t keyLength;
+		size_t duplicate = 0;
+
+		status_t status = QueryPolicy::IndexIteratorFetchNextEntry(iterator,
+			&indexValue, &keyLength, (size_t)sizeof(indexValue), &duplicate);
+		if (status == B_ENTRY_NOT_FOUND)
+			break;
+		if (status != B_OK)
+			return status;
 
-			dirent->d_dev = QueryPolicy::ContextGetVolumeID(context);
-			dirent->d_ino = QueryPolicy::EntryGetNodeID(entry);
-			dirent->d_pdev = dirent->d_dev;
-			dirent->d_pino = QueryPolicy::EntryGetParentID(entry);
-			dirent->d_reclen = offsetof(struct dirent, d_name) + nameLength;
+		// see GetNextMatching()
+		if (duplicate < 2 && !CompareTo((uint8*)&indexValue, keyLength)) {
+			if (Term<QueryPolicy>::fOp == OP_LESS_THAN
+				|| Term<QueryPolicy>::fOp == OP_LESS_THAN_OR_EQUAL
+				|| (Term<QueryPolicy>::fOp == OP_EQUAL && !fIsPattern))
+				break;
+
+			if (duplicate > 0)
+				QueryPolicy::IndexIteratorSkipDuplicates(iterator);
+			continue;
 		}
 
-		if (status == MATCH_OK)
-			return B_OK;
+		if (set.Count() >= maxCount)
+			return B_BUFFER_OVERFLOW;
+
+		status = set.Add(QueryPolicy::IndexIteratorGetNodeID(iterator));
+		if (status != B_OK)
+			return status;
 	}
-	QUERY_RETURN_ERROR(B_ERROR);
+
+	set.Sort();
+	return B_OK;
 }
 
 
@@ -1155,16 +1531,8 @@ template<typename QueryPolicy>
 void
 Equation<QueryPolicy>::PrintToStream()
 {
-	const char* symbol = "???";
-	switch (Term<QueryPolicy>::fOp) {
-		case OP_EQUAL: symbol = "=="; break;
-		case OP_UNEQUAL: symbol = "!="; break;
-		case OP_GREATER_THAN: symbol = ">"; break;
-		case OP_GREATER_THAN_OR_EQUAL: symbol = ">="; break;
-		case OP_LESS_THAN: symbol = "<"; break;
-		case OP_LESS_THAN_OR_EQUAL: symbol = "<="; break;
-	}
-	QUERY_D(__out("[\"%s\" %s \"%s\"]", fAttribute, symbol, fString));
+	QUERY_D(__out("[\"%s\" %s \"%s\"]", fAttribute,
+		getOperatorSymbol(Term<QueryPolicy>::fOp), fString));
 }
 
 #endif	// DEBUG_QUERY
@@ -1415,6 +1783,10 @@ Query<QueryPolicy>::Query(Context* context, Expression<QueryPolicy>* expression,
 	fCurrent(NULL),
 	fIterator(NULL),
 	fIndex(context),
+	fNodeIDIndex(0),
+	fUseNodeIDs(false),
+	fNodeIDsCollected(false),
+	fNodeIDsExact(false),
 	fFlags(flags),
 	fPort(port),
 	fToken(token),
@@ -1432,6 +1804,7 @@ Query<QueryPolicy>::Query(Context* context, Expression<QueryPolicy>* expression,
 
 	fNeedsEntry = fExpression->Root()->NeedsEntry();
 
+	_Plan();
 	Rewind();
 }
 
@@ -1487,6 +1860,10 @@ Query<QueryPolicy>::Rewind()
 	fIterator = NULL;
 	fCurrent = NULL;
 
+	fNodeIDs.MakeEmpty();
+	fNodeIDIndex = 0;
+	fNodeIDsCollected = false;
+
 	// put the whole expression on the stack
 
 	Stack<Term<QueryPolicy>*> stack;
@@ -1644,6 +2021,30 @@ template<typename QueryPolicy>
 status_t
 Query<QueryPolicy>::_GetNextEntry(struct dirent* dirent, size_t size)
 {
+	if (fUseNodeIDs) {
+		if (!fNodeIDsCollected) {
+			fNodeIDsCollected = true;
+
+			status_t status = _CollectNodeIDs(fExpression->Root(), fNodeIDs);
+			if (status != B_OK) {
+				// The estimates were too far off, or we ran out of memory;
+				// use the index scan instead
+				if ((fFlags & B_QUERY_DEBUG_PLAN) != 0) {
+					QUERY_INFORM("query plan: collecting node IDs failed: %s, "
+						"falling back to index scan\n", strerror(status));
+				}
+				fUseNodeIDs = false;
+				fNodeIDs.MakeEmpty();
+			} else if ((fFlags & B_QUERY_DEBUG_PLAN) != 0) {
+				QUERY_INFORM("query plan: collected %" B_PRId32 " node IDs\n",
+					fNodeIDs.Count());
+			}
+		}
+
+		if (fUseNodeIDs)
+			return _GetNextNodeIDEntry(dirent, size);
+	}
+
 	// If we don't have an equation to use yet/anymore, get a new one
 	// from the stack
 	while (true) {
@@ -1679,6 +2080,337 @@ Query<QueryPolicy>::_GetNextEntry(struct dirent* dirent, size_t size)
 }
 
 
+/*!	Returns the next entry from the set of node IDs collected by
+	_CollectNodeIDs(). Unless the set is exact, the nodes are matched
+	against the whole expression.
+*/
+template<typename QueryPolicy>
+status_t
+Query<QueryPolicy>::_GetNextNodeIDEntry(struct dirent* dirent, size_t size)
+{
+	while (fNodeIDIndex < fNodeIDs.Count()) {
+		NodeHolder nodeHolder;
+		Entry* entry;
+		status_t status = QueryPolicy::ContextGetEntry(fContext,
+			fNodeIDs.IDAt(fNodeIDIndex++), nodeHolder, &entry);
+		if (status != B_OK) {
+			// the node might have been removed in the mean time
+			continue;
+		}
+
+		if (!fNodeIDsExact) {
+			status = fExpression->Root()->Match(entry,
+				QueryPolicy::EntryGetNode(entry));
+			if (status != MATCH_OK) {
+				if (status < 0)
+					QUERY_REPORT_ERROR(status);
+				continue;
+			}
+		}
+
+		fillDirent<QueryPolicy>(fContext, entry, dirent, size);
+		return B_OK;
+	}
+
+	return B_ENTRY_NOT_FOUND;
+}
+
+
+/*!	Decides how the query is evaluated.
+	The default plan is to scan a single index for every path through the
+	OR operators, and to match the nodes found there against the rest of the
+	expression. If the file system can estimate the number of matching index
+	entries, the planner can instead collect the node IDs of several index
+	scans, and intersect or unite them before any node is loaded. The plan
+	with the lower estimated cost is chosen.
+*/
+template<typename QueryPolicy>
+void
+Query<QueryPolicy>::_Plan()
+{
+	Term<QueryPolicy>* root = fExpression->Root();
+
+	off_t scanCost = _IndexScanCost(root);
+	off_t nodeIDCost = -1;
+
+	plan_estimate estimate;
+	if (scanCost >= 0 && _EstimateNodeIDs(root, estimate)
+		&& estimate.scanned <= kMaxPlannedNodeIDs) {
+		nodeIDCost = estimate.scanned / kIndexEntryCostDivisor
+			+ estimate.matches;
+		if (nodeIDCost < scanCost) {
+			fUseNodeIDs = true;
+			fNodeIDsExact = estimate.exact;
+		}
+	}
+
+	if ((fFlags & B_QUERY_DEBUG_PLAN) == 0)
+		return;
+
+	if (fUseNodeIDs) {
+		QUERY_INFORM("query plan: %s node ID sets, cost %" B_PRIdOFF
+			" (index scan: %" B_PRIdOFF ")\n",
+			fNodeIDsExact ? "exact" : "matched", nodeIDCost, scanCost);
+	} else if (scanCost >= 0) {
+		QUERY_INFORM("query plan: index scan, cost %" B_PRIdOFF
+			" (node ID sets: %" B_PRIdOFF ")\n", scanCost, nodeIDCost);
+	} else
+		QUERY_INFORM("query plan: index scan, no estimates available\n");
+
+	_PrintPlan(root, 1);
+}
+
+
+/*!	Returns the estimated cost of evaluating \a term the way Rewind() and
+	_GetNextEntry() do, or -1 if that cannot be estimated.
+*/
+template<typename QueryPolicy>
+off_t
+Query<QueryPolicy>::_IndexScanCost(Term<QueryPolicy>* term)
+{
+	if (term->Op() == OP_AND || term->Op() == OP_OR) {
+		Operator<QueryPolicy>* op = (Operator<QueryPolicy>*)term;
+
+		if (op->Op() == OP_AND) {
+			// Rewind() only scans the child with the better score
+			if (op->Right()->Score() < op->Left()->Score())
+				return _IndexScanCost(op->Right());
+			return _IndexScanCost(op->Left());
+		}
+
+		off_t left = _IndexScanCost(op->Left());
+		off_t right = _IndexScanCost(op->Right());
+		if (left < 0 || right < 0)
+			return -1;
+		return left + right;
+	}
+
+	Equation<QueryPolicy>* equation = (Equation<QueryPolicy>*)term;
+	if (equation->EstimatedMatches() < 0)
+		return -1;
+
+	// every node found is loaded; for OP_UNEQUAL, that's all of them
+	off_t nodes = term->Op() == OP_UNEQUAL
+		? equation->EstimatedScan() : equation->EstimatedMatches();
+	return equation->EstimatedScan() / kIndexEntryCostDivisor + nodes;
+}
+
+
+/*!	Estimates the cost of evaluating \a term by collecting node IDs.
+	Returns \c false if that's not possible.
+*/
+template<typename QueryPolicy>
+bool
+Query<QueryPolicy>::_EstimateNodeIDs(Term<QueryPolicy>* term,
+	plan_estimate& estimate)
+{
+	if (term->Op() == OP_AND)
+		return _ChooseChildren((Operator<QueryPolicy>*)term, estimate) != 0;
+
+	if (term->Op() == OP_OR) {
+		Operator<QueryPolicy>* op = (Operator<QueryPolicy>*)term;
+
+		plan_estimate left;
+		plan_estimate right;
+		if (!_EstimateNodeIDs(op->Left(), left)
+			|| !_EstimateNodeIDs(op->Right(), right))
+			return false;
+
+		// assume both sets are independent from each other
+		estimate.total = max_c(left.total, right.total);
+		estimate.scanned = left.scanned + right.scanned;
+		estimate.matches = left.matches + right.matches;
+		if (estimate.total > 0) {
+			estimate.matches -= left.matches * right.matches / estimate.total;
+			estimate.matches = max_c(estimate.matches,
+				max_c(left.matches, right.matches));
+		}
+		estimate.exact = left.exact && right.exact;
+		return true;
+	}
+
+	// OP_UNEQUAL is evaluated on the "name" index, and can't be collected
+	Equation<QueryPolicy>* equation = (Equation<QueryPolicy>*)term;
+	if (equation->EstimatedMatches() < 0 || term->Op() == OP_UNEQUAL)
+		return false;
+
+	estimate.scanned = equation->EstimatedScan();
+	estimate.matches = equation->EstimatedMatches();
+	estimate.total = equation->EstimatedTotal();
+	estimate.exact = true;
+	return true;
+}
+
+
+/*!	Decides which children of the AND operator \a op should be collected;
+	it is only worth to intersect both if the other child is selective, and
+	cheap enough to scan.
+	Returns the COLLECT_* mask, or 0 if no child can be collected.
+*/
+template<typename QueryPolicy>
+uint32
+Query<QueryPolicy>::_ChooseChildren(Operator<QueryPolicy>* op,
+	plan_estimate& estimate)
+{
+	plan_estimate left;
+	plan_estimate right;
+	bool hasLeft = _EstimateNodeIDs(op->Left(), left);
+	bool hasRight = _EstimateNodeIDs(op->Right(), right);
+
+	uint32 children = 0;
+	off_t bestCost = -1;
+
+	if (hasLeft) {
+		children = COLLECT_LEFT;
+		estimate = left;
+		bestCost = left.scanned / kIndexEntryCostDivisor + left.matches;
+	}
+	if (hasRight) {
+		off_t cost = right.scanned / kIndexEntryCostDivisor + right.matches;
+		if (bestCost < 0 || cost < bestCost) {
+			children = COLLECT_RIGHT;
+			estimate = right;
+			bestCost = cost;
+		}
+	}
+	if (hasLeft && hasRight) {
+		// assume both sets are independent from each other
+		plan_estimate both;
+		both.total = max_c(left.total, right.total);
+		both.scanned = left.scanned + right.scanned;
+		both.matches = both.total > 0
+			? left.matches * right.matches / both.total : 0;
+		both.exact = left.exact && right.exact;
+
+		off_t cost = both.scanned / kIndexEntryCostDivisor + both.matches;
+		if (cost < bestCost) {
+			children = COLLECT_BOTH;
+			estimate = both;
+		}
+	}
+
+	// if only one child is collected, the nodes need to be matched
+	if (children != COLLECT_BOTH)
+		estimate.exact = false;
+
+	return children;
+}
+
+
+/*!	Collects the IDs of the nodes matching \a term into \a set, following the
+	decisions of _EstimateNodeIDs().
+*/
+template<typename QueryPolicy>
+status_t
+Query<QueryPolicy>::_CollectNodeIDs(Term<QueryPolicy>* term, NodeIDSet& set)
+{
+	if (term->Op() == OP_AND || term->Op() == OP_OR) {
+		Operator<QueryPolicy>* op = (Operator<QueryPolicy>*)term;
+
+		uint32 children = COLLECT_BOTH;
+		if (op->Op() == OP_AND) {
+			plan_estimate estimate;
+			children = _ChooseChildren(op, estimate);
+			if (children == 0)
+				return B_NOT_SUPPORTED;
+		}
+
+		if (children == COLLECT_RIGHT)
+			return _CollectNodeIDs(op->Right(), set);
+
+		status_t status = _CollectNodeIDs(op->Left(), set);
+		if (status != B_OK || children == COLLECT_LEFT)
+			return status;
+
+		if (op->Op() == OP_AND && set.Count() == 0)
+			return B_OK;
+
+		NodeIDSet other;
+		status = _CollectNodeIDs(op->Right(), other);
+		if (status != B_OK)
+			return status;
+
+		if (op->Op() == OP_AND) {
+			set.Intersect(other);
+			return B_OK;
+		}
+
+		status = set.Unite(other);
+		if (status == B_OK && set.Count() > kMaxPlannedNodeIDs)
+			return B_BUFFER_OVERFLOW;
+		return status;
+	}
+
+	Equation<QueryPolicy>* equation = (Equation<QueryPolicy>*)term;
+	IndexIterator* iterator = NULL;
+
+	status_t status = equation->PrepareQuery(fContext, fIndex, &iterator,
+		false);
+	if (status == B_OK) {
+		if (equation->HasIndex()) {
+			status = equation->CollectMatching(iterator, set,
+				kMaxPlannedNodeIDs);
+		} else
+			status = B_NOT_SUPPORTED;
+	} else if (status == B_ENTRY_NOT_FOUND && iterator != NULL) {
+		// the key is not in the index
+		status = B_OK;
+	}
+
+	QueryPolicy::IndexIteratorDelete(iterator);
+	return status;
+}
+
+
+template<typename QueryPolicy>
+void
+Query<QueryPolicy>::_PrintPlan(Term<QueryPolicy>* term, int32 level)
+{
+	if (term->Op() == OP_AND || term->Op() == OP_OR) {
+		Operator<QueryPolicy>* op = (Operator<QueryPolicy>*)term;
+
+		const char* action = "";
+		if (fUseNodeIDs && op->Op() == OP_OR)
+			action = " unite";
+		else if (fUseNodeIDs) {
+			plan_estimate estimate;
+			switch (_ChooseChildren(op, estimate)) {
+				case COLLECT_BOTH:
+					action = " intersect";
+					break;
+				case COLLECT_LEFT:
+					action = " left only";
+					break;
+				case COLLECT_RIGHT:
+					action = " right only";
+					break;
+			}
+		}
+
+		QUERY_INFORM("%*s%s%s\n", (int)level * 2, "",
+			getOperatorSymbol(op->Op()), action);
+		_PrintPlan(op->Left(), level + 1);
+		_PrintPlan(op->Right(), level + 1);
+		return;
+	}
+
+	Equation<QueryPolicy>* equation = (Equation<QueryPolicy>*)term;
+	if (equation->EstimatedMatches() < 0) {
+		QUERY_INFORM("%*s\"%s\" %s \"%s\": score %" B_PRId32 "\n",
+			(int)level * 2, "", equation->Attribute(),
+			getOperatorSymbol(term->Op()), equation->String(),
+			term->Score());
+		return;
+	}
+
+	QUERY_INFORM("%*s\"%s\" %s \"%s\": %" B_PRIdOFF " of %" B_PRIdOFF
+		" entries, scans %" B_PRIdOFF "\n", (int)level * 2, "",
+		equation->Attribute(), getOperatorSymbol(term->Op()),
+		equation->String(), equation->EstimatedMatches(),
+		equation->EstimatedTotal(), equation->EstimatedScan());
+}
+
+
 template<typename QueryPolicy>
 void
 Query<QueryPolicy>::_SendEntryNotification(Entry* entry,
@@ -12,6 +12,7 @@
 #define ACPI_MADT_SIGNATURE		"APIC"
 #define ACPI_MCFG_SIGNATURE		"MCFG"
 #define ACPI_SPCR_SIGNATURE		"SPCR"
+#define ACPI_SRAT_SIGNATURE		"SRAT"
 
 #define ACPI_LOCAL_APIC_ENABLED	0x01
 
@@ -292,6 +293,55 @@ enum {
 	ACPI_SPCR_INTERFACE_TYPE_PL011 = 3,
 };
 
+typedef struct acpi_srat {
+	acpi_descriptor_header	header;	/* "SRAT" signature */
+	uint32	reserved1;				/* must be 1 */
+	uint64	reserved2;
+} _PACKED acpi_srat;
+
+enum {
+	ACPI_SRAT_LOCAL_APIC_AFFINITY = 0,
+	ACPI_SRAT_MEMORY_AFFINITY = 1,
+	ACPI_SRAT_LOCAL_X2_APIC_AFFINITY = 2
+};
+
+#define ACPI_SRAT_AFFINITY_ENABLED		0x01
+#define ACPI_SRAT_MEMORY_HOT_PLUGGABLE	0x02
+
+typedef struct acpi_srat_local_apic_affinity {
+	uint8	type;					/* 0 = processor local APIC affinity */
+	uint8	length;					/* 16 bytes */
+	uint8	proximity_domain_low;	/* bits 0-7 of the proximity domain */
+	uint8	apic_id;				/* the id of the processor's APIC */
+	uint32	flags;					/* 1 = enabled */
+	uint8	local_sapic_eid;
+	uint8	proximity_domain_high[3];	/* bits 8-31 of the proximity domain */
+	uint32	clock_domain;
+} _PACKED acpi_srat_local_apic_affinity;
+
+typedef struct acpi_srat_memory_affinity {
+	uint8	type;					/* 1 = memory affinity */
+	uint8	length;					/* 40 bytes */
+	uint32	proximity_domain;
+	uint16	reserved1;
+	uint64	base_address;			/* physical base address of the range */
+	uint64	length_bytes;			/* length of the range in bytes */
+	uint32	reserved2;
+	uint32	flags;					/* 1 = enabled, 2 = hot pluggable */
+	uint64	reserved3;
+} _PACKED acpi_srat_memory_affinity;
+
+typedef struct acpi_srat_local_x2_apic_affinity {
+	uint8	type;					/* 2 = processor local x2APIC affinity */
+	uint8	length;					/* 24 bytes */
+	uint16	reserved1;
+	uint32	proximity_domain;
+	uint32	x2apic_id;				/* the id of the processor's x2APIC */
+	uint32	flags;					/* 1 = enabled */
+	uint32	clock_domain;
+	uint32	reserved2;
+} _PACKED acpi_srat_local_x2_apic_affinity;
+
 
 /* The following definitions are adapted from acpica/include/acrestyp.h */
 
@@ -9,6 +9,25 @@
 #include <SupportDefs.h>
 
 
+#define BLOCK_CACHE_SYSCALLS "block_cache"
+
+#define BLOCK_CACHE_GET_STATS	1
+
+
+struct block_cache_stats {
+	size_t		block_size;
+	off_t		max_blocks;
+	uint32		unused_blocks;
+	uint32		dirty_blocks;
+	uint64		hits;
+	uint64		misses;
+	uint64		prefetched_blocks;
+	uint64		prefetch_hits;
+	uint64		prefetch_wasted;
+	uint32		prefetch_window;
+};
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
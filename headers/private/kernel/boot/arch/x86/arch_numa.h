@@ -0,0 +1,20 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BOOT_ARCH_NUMA_H
+#define BOOT_ARCH_NUMA_H
+
+#include <SupportDefs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void numa_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* BOOT_ARCH_NUMA_H */
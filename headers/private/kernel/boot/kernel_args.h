@@ -23,6 +23,8 @@
 
 #define CURRENT_KERNEL_ARGS_VERSION	1
 #define MAX_KERNEL_ARGS_RANGE		20
+#define MAX_NUMA_MEMORY_RANGES		32
+#define MAX_NUMA_NODES				8
 
 // names of common boot_volume fields
 #define BOOT_METHOD						"boot method"
@@ -42,6 +44,12 @@ enum {
 	BOOT_METHOD_DEFAULT		= BOOT_METHOD_HARD_DISK
 };
 
+typedef struct numa_addr_range {
+	uint64		start;
+	uint64		size;
+	uint32		node;
+} _PACKED numa_addr_range;
+
 typedef struct kernel_args {
 	uint32		kernel_args_size;
 	uint32		version;
@@ -109,10 +117,20 @@ typedef struct kernel_args {
 	FixedWidthPointer<void> ucode_data;
 	uint32	ucode_data_size;
 
+	// NUMA topology, if the firmware describes one; nodes are numbered from
+	// 0 to num_numa_nodes - 1
+	uint32		num_numa_nodes;
+	uint32		num_numa_memory_ranges;
+	numa_addr_range numa_memory_range[MAX_NUMA_MEMORY_RANGES];
+	uint8		cpu_numa_node[SMP_MAX_CPUS];
+
 } _PACKED kernel_args;
 
 
-const size_t kernel_args_size_v1 = sizeof(kernel_args)
+const size_t kernel_args_size_v2 = sizeof(kernel_args)
+	- 2 * sizeof(uint32) - sizeof(numa_addr_range) * MAX_NUMA_MEMORY_RANGES
+	- sizeof(uint8) * SMP_MAX_CPUS;
+const size_t kernel_args_size_v1 = kernel_args_size_v2
 	- sizeof(FixedWidthPointer<void>) - sizeof(uint32);
 
 
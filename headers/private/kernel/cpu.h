@@ -78,6 +78,7 @@ typedef struct CACHE_LINE_ALIGN cpu_ent {
 	// CPU topology information
 	int				topology_id[CPU_TOPOLOGY_LEVELS];
 	int				cache_id[CPU_MAX_CACHE_LEVEL];
+	int32			numa_node;
 
 	// IRQs assigned to this CPU
 	struct list		irqs;
@@ -91,6 +92,7 @@ typedef struct CACHE_LINE_ALIGN cpu_ent {
 extern cpu_ent gCPU[];
 extern uint32 gCPUCacheLevelCount;
 extern CPUSet gCPUEnabled;
+extern int32 gNUMANodeCount;
 
 
 #ifdef __cplusplus
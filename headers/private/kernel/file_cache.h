@@ -23,6 +23,8 @@
 #define FILE_CACHE_LOADED_COMPLETELY	0x02
 #define FILE_CACHE_NO_IO				0x04
 
+struct iovec;
+
 struct cache_module_info {
 	module_info	info;
 
@@ -45,6 +47,11 @@ extern void cache_node_launched(size_t argCount, char * const *args);
 extern void cache_prefetch_vnode(struct vnode *vnode, off_t offset, size_t size);
 extern void cache_prefetch(dev_t mountID, ino_t vnodeID, off_t offset, size_t size);
 
+extern status_t file_cache_wire_pages(struct vnode *vnode, void *cookie,
+				off_t offset, size_t *_size, struct iovec *vecs,
+				uint32 *_vecCount, void **_wiredCookie);
+extern void file_cache_unwire_pages(void *wiredCookie);
+
 extern status_t file_map_init(void);
 extern status_t file_cache_init_post_boot_device(void);
 extern status_t file_cache_init(void);
@@ -44,6 +44,12 @@ void scheduler_reschedule(int32 next_state);
 */
 int32 scheduler_set_thread_priority(Thread* thread, int32 priority);
 
+/*!	Sets the given thread's CPU affinity. Fails with \c B_BUSY if the thread
+	is a deadline thread, and no core in \a mask can take its load.
+	The caller must hold the thread's lock.
+*/
+status_t scheduler_set_thread_affinity(Thread* thread, const CPUSet& mask);
+
 /*!	Called when the Thread structure is first created.
 	Per-thread housekeeping resources can be allocated.
 	Interrupts must be enabled.
@@ -92,6 +98,9 @@ bigtime_t _user_estimate_max_scheduling_latency(thread_id thread);
 status_t _user_analyze_scheduling(bigtime_t from, bigtime_t until, void* buffer,
 	size_t size, struct scheduling_analysis* analysis);
 
+status_t _user_set_thread_deadline(thread_id thread, bigtime_t runtime,
+	bigtime_t deadline, bigtime_t period);
+
 status_t _user_set_scheduler_mode(int32 mode);
 int32 _user_get_scheduler_mode(void);
 
@@ -14,7 +14,6 @@
 struct DepotMagazine;
 
 typedef struct object_depot {
-	rw_lock					outer_lock;
 	spinlock				inner_lock;
 	DepotMagazine*			full;
 	DepotMagazine*			empty;
@@ -22,6 +21,9 @@ typedef struct object_depot {
 	size_t					empty_count;
 	size_t					max_count;
 	size_t					magazine_capacity;
+	size_t					min_magazine_capacity;
+	size_t					max_magazine_capacity;
+	size_t					contention_count;
 	struct depot_cpu_store*	stores;
 	void*					cookie;
 
@@ -29,6 +31,13 @@ typedef struct object_depot {
 		void* object, uint32 flags);
 } object_depot;
 
+typedef struct object_depot_stats {
+	uint64					alloc_hits;
+	uint64					alloc_misses;
+	uint64					free_hits;
+	uint64					free_misses;
+} object_depot_stats;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +54,8 @@ void object_depot_store(object_depot* depot, void* object, uint32 flags);
 
 void object_depot_make_empty(object_depot* depot, uint32 flags);
 
+void object_depot_get_stats(object_depot* depot, object_depot_stats* stats);
+
 #if PARANOID_KERNEL_FREE
 bool object_depot_contains_object(object_depot* depot, void* object);
 #endif
@@ -98,6 +98,10 @@ const char* thread_state_to_text(Thread* thread, int32 state);
 
 int32 thread_get_io_priority(thread_id id);
 void thread_set_io_priority(int32 priority);
+void thread_set_cpu_affinity(const CPUSet& mask);
+
+bool thread_check_permissions(const Thread* currentThread,
+	const Thread* thread, bool kernel);
 
 #define thread_get_current_thread arch_thread_get_current_thread
 
@@ -445,12 +445,21 @@ struct Thread : TeamThreadIteratorEntry<thread_id>, KernelReferenceable {
 	bool			going_to_suspend;	// protected by scheduler lock
 	int32			priority;		// protected by scheduler lock
 	int32			io_priority;	// protected by fLock
+	int32			inherited_priority_count;
+									// number of user mutexes the thread has
+									// inherited a priority through,
+									// protected by fLock
+	int32			base_priority;	// priority to return to when the
+									// inherited priorities are dropped,
+									// protected by fLock
 	int32			state;			// protected by scheduler lock
 	struct cpu_ent	*cpu;			// protected by scheduler lock
 	struct cpu_ent	*previous_cpu;	// protected by scheduler lock
 	CPUSet			cpumask;
 	int32			pinned_to_cpu;	// only accessed by this thread or in the
 									// scheduler, when thread is not running
+	int32			numa_node;		// preferred NUMA node or -1, only written
+									// by this thread
 	spinlock		scheduler_lock;
 
 	sigset_t		sig_block_mask;	// protected by team->signal_lock,
@@ -6,7 +6,7 @@
 #define _KERNEL_USER_MUTEX_H
 
 
-#include <SupportDefs.h>
+#include <OS.h>
 
 
 #ifdef __cplusplus
@@ -20,6 +20,8 @@ void		delete_user_mutex_context(struct user_mutex_context* context);
 
 status_t	_user_mutex_lock(int32* mutex, const char* name, uint32 flags,
 				bigtime_t timeout);
+status_t	_user_mutex_lock_inherit(int32* mutex, thread_id owner,
+				uint32 flags, bigtime_t timeout);
 status_t	_user_mutex_unblock(int32* mutex, uint32 flags);
 status_t	_user_mutex_switch_lock(int32* fromMutex, uint32 fromFlags,
 				int32* toMutex, const char* name, uint32 toFlags, bigtime_t timeout);
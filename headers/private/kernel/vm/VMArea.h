@@ -115,6 +115,8 @@ public:
 	VMCache*				cache;
 	off_t					cache_offset;
 	uint32					cache_type;
+	int32					fault_around_pages;
+		// changed atomically by concurrent page faults
 	VMAreaMappings			mappings;
 	uint8*					page_protections;
 
@@ -173,6 +173,9 @@ public:
 
 	virtual	status_t			Fault(struct VMAddressSpace *aspace,
 									off_t offset);
+	virtual	status_t			PrepareLargePage(
+									struct VMAddressSpace* aspace,
+									off_t offset, off_t size);
 
 	virtual	void				Merge(VMCache* source);
 
@@ -380,7 +383,9 @@ vm_page::DecrementWiredCount()
 {
 	ASSERT_PRINT(fWiredCount > 0, "page: %#" B_PRIx64, physical_page_number * B_PAGE_SIZE);
 
-	if (--fWiredCount == 0)
+	// A page that was removed from its cache while still wired has no cache
+	// anymore; whoever unwires it last has to free it.
+	if (--fWiredCount == 0 && cache_ref != NULL)
 		cache_ref->cache->DecrementWiredPagesCount();
 }
 
@@ -39,6 +39,12 @@ public:
 									vm_page_reservation* reservation) = 0;
 	virtual	status_t			Unmap(addr_t start, addr_t end) = 0;
 
+	virtual	size_t				LargePageSize() const;
+	virtual	status_t			MapLargePage(addr_t virtualAddress,
+									phys_addr_t physicalAddress,
+									uint32 attributes, uint32 memoryType,
+									vm_page_reservation* reservation);
+
 	virtual	status_t			DebugMarkRangePresent(addr_t start, addr_t end,
 									bool markPresent);
 
@@ -91,6 +97,10 @@ protected:
 									VMAreaMappings* mappingsQueue = NULL);
 			void				UnaccessedPageUnmapped(VMArea* area,
 									page_num_t pageNumber);
+			void				LargePageFlagsCleared(page_num_t firstPage,
+									page_num_t pageCount,
+									page_num_t exceptPage, bool accessed,
+									bool modified);
 
 protected:
 			recursive_lock		fLock;
@@ -173,6 +173,10 @@ status_t _user_sync_memory(void *address, size_t size, uint32 flags);
 status_t _user_memory_advice(void* address, size_t size, uint32 advice);
 status_t _user_get_memory_properties(team_id teamID, const void *address,
 			uint32 *_protected, uint32 *_lock);
+status_t _user_get_vm_fault_stats(struct vm_fault_stats* userStats,
+			size_t size);
+status_t _user_get_vm_numa_stats(struct vm_numa_node_stats* userStats,
+			uint32* _userCount);
 
 status_t _user_mlock(const void* address, size_t size);
 status_t _user_munlock(const void* address, size_t size);
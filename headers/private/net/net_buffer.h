@@ -22,6 +22,9 @@ enum net_buffer_flags {
 };
 
 
+typedef void (*net_buffer_free_func)(void* cookie);
+
+
 typedef struct net_buffer {
 	struct list_link		link;
 
@@ -42,6 +45,9 @@ typedef struct net_buffer {
 	uint32					size;
 	uint8					protocol;
 	uint16					buffer_flags;
+	uint16					segment_size;
+		// if non-zero, the buffer contains several TCP segments of this size
+		// that are split by the datalink layer, or by the device
 } net_buffer;
 
 struct ancillary_data_container;
@@ -108,6 +114,11 @@ struct net_buffer_module_info {
 	void			(*swap_addresses)(net_buffer* buffer);
 
 	void			(*dump)(net_buffer* buffer);
+
+	// later additions go here, so that the v1 layout stays intact
+	status_t		(*append_external)(net_buffer* buffer,
+						const struct iovec* vecs, uint32 vecCount,
+						net_buffer_free_func freeFunction, void* cookie);
 };
 
 
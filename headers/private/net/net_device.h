@@ -14,6 +14,11 @@
 typedef struct net_buffer net_buffer;
 
 
+// net_device::offload
+#define NET_DEVICE_OFFLOAD_TCP_SEGMENTATION	0x01
+	// the device can send buffers with a net_buffer::segment_size itself
+
+
 struct net_hardware_address {
 	uint8	data[64];
 	uint8	length;
@@ -31,6 +36,7 @@ typedef struct net_device {
 	uint64	link_speed;
 	uint32	link_quality;
 	size_t	header_length;
+	uint32	offload;	// NET_DEVICE_OFFLOAD_TCP_SEGMENTATION, ...
 
 	struct net_hardware_address address;
 
@@ -75,6 +75,11 @@ struct net_stack_interface_module_info {
 
 	status_t (*get_next_socket_stat)(int family, uint32 *cookie,
 					struct net_stat *stat);
+
+	// new hooks must be appended, older modules rely on the v1 layout
+	ssize_t (*send_external)(net_socket* socket, const struct iovec* vecs,
+					uint32 vecCount, void (*freeFunction)(void* cookie),
+					void* cookie, int flags);
 };
 
 
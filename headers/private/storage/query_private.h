@@ -7,4 +7,8 @@
 // notifications if the entry stays in the query.
 #define B_ATTR_CHANGE_NOTIFICATION		0x0000F000
 
+// B_QUERY_DEBUG_PLAN lets the file system report how it is going to evaluate
+// the query to the syslog.
+#define B_QUERY_DEBUG_PLAN				0x00010000
+
 #endif
@@ -12,7 +12,8 @@
 #define COMMPAGE_ENTRY_MAGIC				0
 #define COMMPAGE_ENTRY_VERSION				1
 #define COMMPAGE_ENTRY_REAL_TIME_DATA		2
-#define COMMPAGE_ENTRY_FIRST_ARCH_SPECIFIC	3
+#define COMMPAGE_ENTRY_CPU_THREADS			3
+#define COMMPAGE_ENTRY_FIRST_ARCH_SPECIFIC	4
 
 #define COMMPAGE_SIZE (0x8000)
 #define COMMPAGE_TABLE_ENTRIES 64
@@ -20,6 +21,10 @@
 #define COMMPAGE_SIGNATURE 'COMM'
 #define COMMPAGE_VERSION 1
 
+/* The COMMPAGE_ENTRY_CPU_THREADS entry contains the ID of the thread running
+   on each CPU as an int32, each in its own cache line. */
+#define COMMPAGE_CPU_THREAD_STRIDE 64
+
 #ifdef COMMPAGE_COMPAT
 #include <arch/x86/arch_commpage_defs.h>
 #else
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_SCHEDULER_STATS_H
+#define _SYSTEM_SCHEDULER_STATS_H
+
+#include <OS.h>
+
+
+#define SCHEDULER_STATS						"scheduler stats"
+
+#define SCHEDULER_STATS_SET_ENABLED			0x01
+#define SCHEDULER_STATS_GET_INFO			0x02
+#define SCHEDULER_STATS_GET_CPU_INFO		0x03
+#define SCHEDULER_STATS_READ_EVENTS			0x04
+
+// scheduler_stats_event::flags
+#define SCHEDULER_STATS_EVENT_WAKEUP		0x01
+	// the thread had been blocked, otherwise it was preempted
+
+enum {
+	SCHEDULER_STATS_LOCK_CPU_RUN_QUEUE = 0,
+	SCHEDULER_STATS_LOCK_CORE_RUN_QUEUE,
+	SCHEDULER_STATS_LOCK_CPU_HEAP,
+
+	SCHEDULER_STATS_LOCK_COUNT
+};
+
+
+/*!	Written whenever a thread is scheduled, after it waited in a run queue. */
+typedef struct scheduler_stats_event {
+	thread_id	thread;
+	int16		cpu;
+	int16		previous_cpu;
+		// the CPU the thread ran on before, -1 if it never ran
+	bigtime_t	time;
+		// when the thread started running
+	bigtime_t	latency;
+		// how long the thread has been waiting in the run queue
+	int32		priority;
+	uint32		flags;
+} scheduler_stats_event;
+
+typedef struct scheduler_stats_info {
+	uint32		enabled;
+	int32		cpu_count;
+	uint32		buffer_size;
+		// number of events each CPU can buffer
+} scheduler_stats_info;
+
+typedef struct scheduler_stats_cpu_info {
+	uint64		events;
+	uint64		lost_events;
+	uint64		migrations;
+	uint64		lock_contended[SCHEDULER_STATS_LOCK_COUNT];
+	nanotime_t	lock_wait_time[SCHEDULER_STATS_LOCK_COUNT];
+} scheduler_stats_cpu_info;
+
+typedef struct scheduler_stats_read_events {
+	scheduler_stats_event*	events;
+	uint32					count;
+		// in: size of the events array, out: number of events read
+} scheduler_stats_read_events;
+
+
+#endif	/* _SYSTEM_SCHEDULER_STATS_H */
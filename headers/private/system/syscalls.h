@@ -41,6 +41,8 @@ struct signal_frame_data;
 struct stat;
 struct system_profiler_parameters;
 struct user_timer_info;
+struct vm_fault_stats;
+struct vm_numa_node_stats;
 
 struct disk_device_job_progress_info;
 struct partitionable_space_data;
@@ -84,6 +86,8 @@ extern ssize_t		_kern_event_queue_wait(int queue, struct event_wait_info* infos,
 /* user mutex functions */
 extern status_t		_kern_mutex_lock(int32* mutex, const char* name,
 						uint32 flags, bigtime_t timeout);
+extern status_t		_kern_mutex_lock_inherit(int32* mutex, thread_id owner,
+						uint32 flags, bigtime_t timeout);
 extern status_t		_kern_mutex_unblock(int32* mutex, uint32 flags);
 extern status_t		_kern_mutex_switch_lock(int32* fromMutex, uint32 fromFlags,
 						int32* toMutex, const char* name, uint32 toFlags,
@@ -210,6 +214,10 @@ extern status_t		_kern_unblock_threads(thread_id* threads, uint32 count,
 
 extern bigtime_t	_kern_estimate_max_scheduling_latency(thread_id thread);
 
+extern status_t		_kern_set_thread_deadline(thread_id thread,
+						bigtime_t runtime, bigtime_t deadline,
+						bigtime_t period);
+
 extern status_t		_kern_set_scheduler_mode(int32 mode);
 extern int32		_kern_get_scheduler_mode(void);
 
@@ -378,6 +386,8 @@ extern ssize_t		_kern_sendto(int socket, const void *data, size_t length,
 						socklen_t addressLength);
 extern ssize_t		_kern_sendmsg(int socket, const struct msghdr *message,
 						int flags);
+extern ssize_t		_kern_sendfile(int outFD, int inFD, off_t *offset,
+						size_t count);
 extern status_t		_kern_getsockopt(int socket, int level, int option,
 						void *value, socklen_t *_length);
 extern status_t		_kern_setsockopt(int socket, int level, int option,
@@ -462,6 +472,10 @@ extern status_t		_kern_memory_advice(void *address, size_t size,
 
 extern status_t		_kern_get_memory_properties(team_id teamID,
 						const void *address, uint32* _protected, uint32* _lock);
+extern status_t		_kern_get_vm_fault_stats(struct vm_fault_stats* stats,
+						size_t size);
+extern status_t		_kern_get_vm_numa_stats(struct vm_numa_node_stats* stats,
+						uint32* _count);
 
 extern status_t		_kern_mlock(const void* address, size_t size);
 extern status_t		_kern_munlock(const void* address, size_t size);
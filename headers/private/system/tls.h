@@ -22,6 +22,7 @@ enum {
 	TLS_USER_THREAD_SLOT,
 	TLS_DYNAMIC_THREAD_VECTOR,
 	TLS_LOCALE_SLOT,
+	TLS_MALLOC_SLOT,
 
 	// Note: these entries can safely be changed between
 	// releases; 3rd party code always calls tls_allocate()
@@ -13,6 +13,9 @@
 #define B_USER_MUTEX_UNBLOCK_ALL	0x80000000
 	// All threads currently waiting on the mutex will be unblocked. The mutex
 	// state will be locked.
+#define B_USER_MUTEX_PRIO_INHERIT	0x20000000
+	// The owner of the mutex inherits the priority of the threads waiting
+	// for it.
 
 
 // mutex value flags
@@ -26,9 +26,12 @@
 #define B_KERNEL_AREA			(1 << 14)
 	// Usable from userland according to its protection flags, but the area
 	// itself is not deletable, resizable, etc from userland.
+#define B_LARGE_PAGES_AREA		(1 << 15)
+	// Hint that the area should be mapped with large pages where possible.
 
 #define B_USER_AREA_FLAGS		\
-	(B_USER_PROTECTION | B_OVERCOMMITTING_AREA | B_CLONEABLE_AREA)
+	(B_USER_PROTECTION | B_OVERCOMMITTING_AREA | B_CLONEABLE_AREA \
+	| B_LARGE_PAGES_AREA)
 #define B_KERNEL_AREA_FLAGS \
 	(B_KERNEL_PROTECTION | B_SHARED_AREA)
 
@@ -46,5 +49,21 @@ enum {
 
 #define MEMORY_TYPE_SHIFT		28
 
+// as returned by _kern_get_vm_fault_stats()
+struct vm_fault_stats {
+	uint32	page_faults;
+	uint32	fault_around_faults;
+		// faults that also mapped neighbouring pages
+	uint32	fault_around_pages;
+		// number of neighbouring pages mapped that way
+};
+
+// as returned by _kern_get_vm_numa_stats(), one per NUMA node
+struct vm_numa_node_stats {
+	uint64	total_pages;
+	uint64	free_pages;
+		// free and clear pages, including those cached per CPU
+};
+
 
 #endif	/* _SYSTEM_VM_DEFS_H */
@@ -245,7 +245,7 @@ BFSPartitionHandle::Repair(bool checkOnly)
 	struct check_control result;
 	memset(&result, 0, sizeof(result));
 	result.magic = BFS_IOCTL_CHECK_MAGIC;
-	result.flags = 0;
+	result.flags = BFS_CHECK_IN_PARALLEL;
 	if (!checkOnly) {
 		//printf("will fix any severe errors!\n");
 		result.flags |= BFS_FIX_BITMAP_ERRORS | BFS_REMOVE_WRONG_TYPES
@@ -18,6 +18,8 @@
 #include "Utility.h"
 
 #if !_BOOT_MODE
+#	include <algorithm>
+
 #	include "Inode.h"
 #else
 #	include "Stream.h"
@@ -126,6 +128,12 @@ private:
 };
 
 
+// limits for the entry estimation of the query planner
+static const uint32 kMaxEstimateLevels = 32;
+static const int32 kMaxEstimateDuplicateSamples = 8;
+static const int32 kMaxEstimateDuplicateNodes = 16;
+
+
 struct TreeCheck {
 	TreeCheck(BPlusTree* tree)
 		:
@@ -2262,6 +2270,671 @@ BPlusTree::Replace(Transaction& transaction, const uint8* key, uint16 keyLength,
 #endif // !_BOOT_MODE
 
 
+//	#pragma mark - bulk loading
+
+
+#if !_BOOT_MODE
+static const size_t kBulkLoadChunkSize = 64 * 1024;
+static const int32 kBulkLoadNodesPerTransaction = 1024;
+
+
+struct bulk_load_chunk {
+	bulk_load_chunk*	next;
+	size_t				used;
+	uint8				data[0];
+};
+
+struct bulk_load_entry {
+	off_t				value;
+	uint16				key_length;
+	uint8				key[0];
+} _PACKED;
+
+struct bulk_load_state {
+	bulk_load_state()
+		:
+		fragment_offset(BPLUSTREE_NULL),
+		fragment_index(0),
+		nodes_written(0)
+	{
+	}
+
+	off_t				fragment_offset;
+	uint32				fragment_index;
+	int32				nodes_written;
+};
+
+
+/*!	Sorts the entries by key, and the duplicates of a key by value, as
+	required by the duplicate arrays.
+*/
+struct BulkLoadCompare {
+	BulkLoadCompare(BPlusTree* tree)
+		:
+		fTree(tree)
+	{
+	}
+
+	bool operator()(const bulk_load_entry* a, const bulk_load_entry* b) const
+	{
+		int32 compare = fTree->_CompareKeys(a->key, a->key_length, b->key,
+			b->key_length);
+		if (compare != 0)
+			return compare < 0;
+
+		return a->value < b->value;
+	}
+
+private:
+	BPlusTree*			fTree;
+};
+
+
+/*!	The offsets of the nodes of one level of the tree that is being built,
+	together with the largest key that can be found below each of them.
+*/
+class BulkLoadLevel {
+public:
+	BulkLoadLevel()
+		:
+		fOffsets(NULL),
+		fLargest(NULL),
+		fCount(0),
+		fCapacity(0)
+	{
+	}
+
+	~BulkLoadLevel()
+	{
+		free(fOffsets);
+		free(fLargest);
+	}
+
+	status_t Add(off_t offset, const bulk_load_entry* largest)
+	{
+		if (fCount == fCapacity) {
+			int32 capacity = max_c(fCapacity * 2, 64);
+			off_t* offsets = (off_t*)realloc(fOffsets,
+				capacity * sizeof(off_t));
+			if (offsets == NULL)
+				return B_NO_MEMORY;
+			fOffsets = offsets;
+
+			const bulk_load_entry** largestEntries
+				= (const bulk_load_entry**)realloc(fLargest,
+					capacity * sizeof(bulk_load_entry*));
+			if (largestEntries == NULL)
+				return B_NO_MEMORY;
+			fLargest = largestEntries;
+
+			fCapacity = capacity;
+		}
+
+		fOffsets[fCount] = offset;
+		fLargest[fCount] = largest;
+		fCount++;
+		return B_OK;
+	}
+
+	void MoveFrom(BulkLoadLevel& other)
+	{
+		free(fOffsets);
+		free(fLargest);
+
+		fOffsets = other.fOffsets;
+		fLargest = other.fLargest;
+		fCount = other.fCount;
+		fCapacity = other.fCapacity;
+
+		other.fOffsets = NULL;
+		other.fLargest = NULL;
+		other.fCount = other.fCapacity = 0;
+	}
+
+	int32 CountNodes() const { return fCount; }
+	off_t OffsetAt(int32 index) const { return fOffsets[index]; }
+	const bulk_load_entry* LargestAt(int32 index) const
+		{ return fLargest[index]; }
+
+private:
+	off_t*					fOffsets;
+	const bulk_load_entry**	fLargest;
+	int32					fCount;
+	int32					fCapacity;
+};
+
+
+/*!	Collects the keys of a node in memory until it is full, so that it can
+	be written in one go.
+*/
+class BulkLoadNode {
+public:
+	BulkLoadNode(int32 nodeSize)
+		:
+		fNodeSize(nodeSize),
+		fCount(0),
+		fKeyLength(0)
+	{
+		int32 maxCount = nodeSize / (sizeof(uint16) + sizeof(off_t));
+		fEntries = (const bulk_load_entry**)malloc(
+			maxCount * sizeof(bulk_load_entry*));
+		fValues = (off_t*)malloc(maxCount * sizeof(off_t));
+	}
+
+	~BulkLoadNode()
+	{
+		free(fEntries);
+		free(fValues);
+	}
+
+	status_t InitCheck() const
+	{
+		return fEntries != NULL && fValues != NULL ? B_OK : B_NO_MEMORY;
+	}
+
+	//! Uses the same fill limit as BPlusTree::Insert().
+	bool Fits(uint16 keyLength) const
+	{
+		return int32(key_align(sizeof(bplustree_node) + fKeyLength
+				+ keyLength) + (fCount + 1) * (sizeof(uint16)
+				+ sizeof(off_t))) < fNodeSize;
+	}
+
+	void Add(const bulk_load_entry* entry, off_t value)
+	{
+		fEntries[fCount] = entry;
+		fValues[fCount] = value;
+		fKeyLength += entry->key_length;
+		fCount++;
+	}
+
+	void RemoveLast()
+	{
+		fCount--;
+		fKeyLength -= fEntries[fCount]->key_length;
+	}
+
+	void MakeEmpty()
+	{
+		fCount = 0;
+		fKeyLength = 0;
+	}
+
+	int32 CountKeys() const { return fCount; }
+	const bulk_load_entry* Last() const { return fEntries[fCount - 1]; }
+
+	void WriteTo(bplustree_node* node, off_t leftLink, off_t rightLink,
+		off_t overflowLink) const
+	{
+		memset(node, 0, fNodeSize);
+
+		node->left_link = HOST_ENDIAN_TO_BFS_INT64(leftLink);
+		node->right_link = HOST_ENDIAN_TO_BFS_INT64(rightLink);
+		node->overflow_link = HOST_ENDIAN_TO_BFS_INT64(overflowLink);
+		node->all_key_count = HOST_ENDIAN_TO_BFS_INT16(fCount);
+		node->all_key_length = HOST_ENDIAN_TO_BFS_INT16(fKeyLength);
+
+		uint8* keys = node->Keys();
+		Unaligned<uint16>* keyLengths = node->KeyLengths();
+		Unaligned<off_t>* values = node->Values();
+		uint16 length = 0;
+
+		for (int32 i = 0; i < fCount; i++) {
+			const bulk_load_entry* entry = fEntries[i];
+			memcpy(keys + length, entry->key, entry->key_length);
+			length += entry->key_length;
+
+			keyLengths[i] = HOST_ENDIAN_TO_BFS_INT16(length);
+			values[i] = HOST_ENDIAN_TO_BFS_INT64(fValues[i]);
+		}
+	}
+
+private:
+	int32					fNodeSize;
+	const bulk_load_entry**	fEntries;
+	off_t*					fValues;
+	int32					fCount;
+	int32					fKeyLength;
+};
+
+
+/*!	Builds the tree from the key/value pairs collected by the \a loader.
+	The pairs are sorted, and written into fully packed leaf nodes; the index
+	nodes are then built bottom-up from the leaves, and finally, the new root
+	replaces the old one. This is much faster than inserting the keys one by
+	one, and results in a tree that is about half as large.
+
+	The tree must be empty. Since none of the new nodes is reachable before
+	the root is replaced, the \a transaction is committed and restarted from
+	time to time to keep it from outgrowing the log, unless it's part of
+	another transaction. The caller must therefore make sure that no one
+	else changes the tree in the mean time, ie. by locking the journal.
+	You need to have the inode write locked.
+*/
+status_t
+BPlusTree::BulkLoad(Transaction& transaction, TreeLoader& loader)
+{
+	ASSERT_WRITE_LOCKED_INODE(fStream);
+
+	off_t oldRoot = fHeader.RootNode();
+
+	CachedNode cached(this);
+	const bplustree_node* root = cached.SetTo(oldRoot);
+	if (root == NULL)
+		RETURN_ERROR(B_IO_ERROR);
+	if (!root->IsLeaf() || root->NumKeys() != 0)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	cached.Unset();
+
+	int32 count = loader.CountEntries();
+	if (count == 0)
+		return B_OK;
+
+	bulk_load_entry** entries = loader.fEntries;
+	std::sort(entries, entries + count, BulkLoadCompare(this));
+
+	if (!fAllowDuplicates) {
+		for (int32 i = 1; i < count; i++) {
+			if (_CompareKeys(entries[i - 1]->key, entries[i - 1]->key_length,
+					entries[i]->key, entries[i]->key_length) == 0)
+				return B_NAME_IN_USE;
+		}
+	}
+
+	BulkLoadNode node(fNodeSize);
+	if (node.InitCheck() != B_OK)
+		return B_NO_MEMORY;
+
+	BulkLoadLevel level;
+	bulk_load_state state;
+
+	// Fill the leaves
+
+	off_t previousOffset = BPLUSTREE_NULL;
+	off_t nodeOffset;
+	status_t status = _BulkLoadAllocate(transaction, state, &nodeOffset);
+	if (status != B_OK)
+		return status;
+
+	for (int32 i = 0; i < count;) {
+		bulk_load_entry* entry = entries[i];
+
+		int32 duplicates = 1;
+		while (i + duplicates < count
+			&& _CompareKeys(entry->key, entry->key_length,
+				entries[i + duplicates]->key,
+				entries[i + duplicates]->key_length) == 0) {
+			duplicates++;
+		}
+
+		if (!node.Fits(entry->key_length)) {
+			// The leaf is full; we need to know where the next one goes
+			// before it can be written
+			off_t nextOffset;
+			status = _BulkLoadAllocate(transaction, state, &nextOffset);
+			if (status == B_OK) {
+				status = _BulkLoadWriteNode(transaction, node, nodeOffset,
+					previousOffset, nextOffset, BPLUSTREE_NULL);
+			}
+			if (status == B_OK)
+				status = level.Add(nodeOffset, node.Last());
+			if (status == B_OK)
+				status = _BulkLoadSplitTransaction(transaction, state);
+			if (status != B_OK)
+				return status;
+
+			node.MakeEmpty();
+			previousOffset = nodeOffset;
+			nodeOffset = nextOffset;
+		}
+
+		off_t value = entry->value;
+		if (duplicates > 1) {
+			status = _BulkLoadDuplicates(transaction, state, entries + i,
+				duplicates, &value);
+			if (status != B_OK)
+				return status;
+		}
+
+		node.Add(entry, value);
+		i += duplicates;
+	}
+
+	status = _BulkLoadWriteNode(transaction, node, nodeOffset, previousOffset,
+		BPLUSTREE_NULL, BPLUSTREE_NULL);
+	if (status == B_OK)
+		status = level.Add(nodeOffset, node.Last());
+	if (status != B_OK)
+		return status;
+
+	// Build the index nodes on top of them, until only the root is left
+
+	uint32 levels = 1;
+	while (level.CountNodes() > 1) {
+		BulkLoadLevel parents;
+		status = _BulkLoadIndexLevel(transaction, state, node, level, parents);
+		if (status != B_OK)
+			return status;
+
+		level.MoveFrom(parents);
+		levels++;
+	}
+
+	// Make the new tree visible, and free the old root
+
+	bplustree_header* header = cached.SetToWritableHeader(transaction);
+	if (header == NULL)
+		return B_IO_ERROR;
+
+	header->root_node_pointer = HOST_ENDIAN_TO_BFS_INT64(level.OffsetAt(0));
+	header->max_number_of_levels = HOST_ENDIAN_TO_BFS_INT32(levels);
+
+	cached.Unset();
+
+	if (cached.SetToWritable(transaction, oldRoot, false) == NULL)
+		return B_IO_ERROR;
+
+	return cached.Free(transaction, oldRoot);
+}
+
+
+status_t
+BPlusTree::_BulkLoadAllocate(Transaction& transaction, bulk_load_state& state,
+	off_t* _offset)
+{
+	CachedNode cached(this);
+	bplustree_node* node;
+	status_t status = cached.Allocate(transaction, &node, _offset);
+	if (status != B_OK)
+		RETURN_ERROR(status);
+
+	state.nodes_written++;
+	return B_OK;
+}
+
+
+/*!	Stores the \a count values of the \a entries, which all share the same
+	key, like _InsertDuplicate() would: up to NUM_FRAGMENT_VALUES values go
+	into a fragment, more into a list of duplicate nodes. The link to them
+	is returned in \a _link.
+*/
+status_t
+BPlusTree::_BulkLoadDuplicates(Transaction& transaction,
+	bulk_load_state& state, bulk_load_entry** entries, int32 count,
+	off_t* _link)
+{
+	if (count <= NUM_FRAGMENT_VALUES) {
+		CachedNode cached(this);
+		bplustree_node* fragment;
+
+		uint32 maxFragments = bplustree_node::MaxFragments(fNodeSize);
+		if (state.fragment_offset == BPLUSTREE_NULL
+			|| state.fragment_index >= maxFragments) {
+			status_t status = cached.Allocate(transaction, &fragment,
+				&state.fragment_offset);
+			if (status != B_OK)
+				RETURN_ERROR(status);
+
+			memset(fragment, 0, fNodeSize);
+			state.fragment_index = 0;
+			state.nodes_written++;
+		} else {
+			fragment = cached.SetToWritable(transaction, state.fragment_offset,
+				false);
+			if (fragment == NULL)
+				return B_IO_ERROR;
+		}
+
+		duplicate_array* array = fragment->FragmentAt(state.fragment_index);
+		array->count = HOST_ENDIAN_TO_BFS_INT64(count);
+		for (int32 i = 0; i < count; i++)
+			array->SetValueAt(i, entries[i]->value);
+
+		*_link = bplustree_node::MakeLink(BPLUSTREE_DUPLICATE_FRAGMENT,
+			state.fragment_offset, state.fragment_index++);
+		return B_OK;
+	}
+
+	// The previous node stays in the cache until the next one is linked to it
+	CachedNode cachedFirst(this);
+	CachedNode cachedSecond(this);
+	CachedNode* cached = &cachedFirst;
+	CachedNode* cachedPrevious = &cachedSecond;
+	bplustree_node* previous = NULL;
+	off_t previousOffset = BPLUSTREE_NULL;
+
+	for (int32 i = 0; i < count; i += NUM_DUPLICATE_VALUES) {
+		bplustree_node* duplicate;
+		off_t offset;
+		status_t status = cached->Allocate(transaction, &duplicate, &offset);
+		if (status != B_OK)
+			RETURN_ERROR(status);
+
+		state.nodes_written++;
+
+		duplicate->left_link = HOST_ENDIAN_TO_BFS_INT64(previousOffset);
+
+		int32 arrayCount = min_c(count - i, NUM_DUPLICATE_VALUES);
+		duplicate_array* array = duplicate->DuplicateArray();
+		array->count = HOST_ENDIAN_TO_BFS_INT64(arrayCount);
+		for (int32 j = 0; j < arrayCount; j++)
+			array->SetValueAt(j, entries[i + j]->value);
+
+		if (previous != NULL)
+			previous->right_link = HOST_ENDIAN_TO_BFS_INT64(offset);
+		else {
+			*_link = bplustree_node::MakeLink(BPLUSTREE_DUPLICATE_NODE,
+				offset);
+		}
+
+		previous = duplicate;
+		previousOffset = offset;
+
+		CachedNode* swap = cachedPrevious;
+		cachedPrevious = cached;
+		cached = swap;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+BPlusTree::_BulkLoadWriteNode(Transaction& transaction,
+	const BulkLoadNode& node, off_t offset, off_t leftLink, off_t rightLink,
+	off_t overflowLink)
+{
+	CachedNode cached(this);
+	bplustree_node* writableNode = cached.SetToWritable(transaction, offset,
+		false);
+	if (writableNode == NULL)
+		return B_IO_ERROR;
+
+	node.WriteTo(writableNode, leftLink, rightLink, overflowLink);
+	return B_OK;
+}
+
+
+/*!	Builds the level of index nodes above the \a children. The key for each
+	child is the largest key found below it, the last child of an index node
+	is put into its overflow link.
+*/
+status_t
+BPlusTree::_BulkLoadIndexLevel(Transaction& transaction,
+	bulk_load_state& state, BulkLoadNode& node, const BulkLoadLevel& children,
+	BulkLoadLevel& parents)
+{
+	int32 count = children.CountNodes();
+	off_t previousOffset = BPLUSTREE_NULL;
+	off_t nodeOffset;
+	status_t status = _BulkLoadAllocate(transaction, state, &nodeOffset);
+	if (status != B_OK)
+		return status;
+
+	for (int32 first = 0; first < count;) {
+		node.MakeEmpty();
+
+		int32 last = first;
+		while (last + 1 < count
+			&& node.Fits(children.LargestAt(last)->key_length)) {
+			node.Add(children.LargestAt(last), children.OffsetAt(last));
+			last++;
+		}
+
+		if (last + 2 == count && node.CountKeys() > 1) {
+			// Don't leave the last node with just an overflow link
+			node.RemoveLast();
+			last--;
+		}
+
+		off_t nextOffset = BPLUSTREE_NULL;
+		if (last + 1 < count) {
+			status = _BulkLoadAllocate(transaction, state, &nextOffset);
+			if (status != B_OK)
+				return status;
+		}
+
+		status = _BulkLoadWriteNode(transaction, node, nodeOffset,
+			previousOffset, nextOffset, children.OffsetAt(last));
+		if (status == B_OK)
+			status = parents.Add(nodeOffset, children.LargestAt(last));
+		if (status == B_OK)
+			status = _BulkLoadSplitTransaction(transaction, state);
+		if (status != B_OK)
+			return status;
+
+		previousOffset = nodeOffset;
+		nodeOffset = nextOffset;
+		first = last + 1;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Commits the bulk load transaction, and starts a new one, if enough nodes
+	have been written to it.
+*/
+status_t
+BPlusTree::_BulkLoadSplitTransaction(Transaction& transaction,
+	bulk_load_state& state)
+{
+	if (state.nodes_written < kBulkLoadNodesPerTransaction
+		|| transaction.HasParent())
+		return B_OK;
+
+	state.nodes_written = 0;
+
+	status_t status = transaction.Done();
+	if (status == B_OK) {
+		status = transaction.Start(fStream->GetVolume(),
+			fStream->BlockNumber());
+	}
+	if (status != B_OK)
+		return status;
+
+	fStream->WriteLockInTransaction(transaction);
+	return B_OK;
+}
+
+
+//	#pragma mark - TreeLoader
+
+
+TreeLoader::TreeLoader(size_t maxMemory)
+	:
+	fEntries(NULL),
+	fCount(0),
+	fCapacity(0),
+	fChunks(NULL),
+	fMemoryUsed(0),
+	fMaxMemory(maxMemory)
+{
+}
+
+
+TreeLoader::~TreeLoader()
+{
+	MakeEmpty();
+}
+
+
+/*!	Adds the key/value pair to the loader. Returns \c B_BUFFER_OVERFLOW when
+	this would use more memory than allowed; the caller should then bulk
+	load the pairs collected so far, and insert the remaining ones one by
+	one.
+*/
+status_t
+TreeLoader::Add(const uint8* key, uint16 keyLength, off_t value)
+{
+	if (keyLength < BPLUSTREE_MIN_KEY_LENGTH
+		|| keyLength > BPLUSTREE_MAX_KEY_LENGTH)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	if (fCount == fCapacity) {
+		int32 capacity = max_c(fCapacity * 2, 1024);
+		size_t added = (capacity - fCapacity) * sizeof(bulk_load_entry*);
+		if (fMemoryUsed + added > fMaxMemory)
+			return B_BUFFER_OVERFLOW;
+
+		bulk_load_entry** entries = (bulk_load_entry**)realloc(fEntries,
+			capacity * sizeof(bulk_load_entry*));
+		if (entries == NULL)
+			return B_NO_MEMORY;
+
+		fEntries = entries;
+		fCapacity = capacity;
+		fMemoryUsed += added;
+	}
+
+	size_t size = round_up(sizeof(bulk_load_entry) + keyLength,
+		sizeof(off_t));
+	if (fChunks == NULL || fChunks->used + size > kBulkLoadChunkSize) {
+		if (fMemoryUsed + kBulkLoadChunkSize > fMaxMemory)
+			return B_BUFFER_OVERFLOW;
+
+		bulk_load_chunk* chunk = (bulk_load_chunk*)malloc(
+			sizeof(bulk_load_chunk) + kBulkLoadChunkSize);
+		if (chunk == NULL)
+			return B_NO_MEMORY;
+
+		chunk->next = fChunks;
+		chunk->used = 0;
+		fChunks = chunk;
+		fMemoryUsed += kBulkLoadChunkSize;
+	}
+
+	bulk_load_entry* entry
+		= (bulk_load_entry*)(fChunks->data + fChunks->used);
+	entry->value = value;
+	entry->key_length = keyLength;
+	memcpy(entry->key, key, keyLength);
+
+	fChunks->used += size;
+	fEntries[fCount++] = entry;
+	return B_OK;
+}
+
+
+void
+TreeLoader::MakeEmpty()
+{
+	while (fChunks != NULL) {
+		bulk_load_chunk* next = fChunks->next;
+		free(fChunks);
+		fChunks = next;
+	}
+
+	free(fEntries);
+	fEntries = NULL;
+	fCount = 0;
+	fCapacity = 0;
+	fMemoryUsed = 0;
+}
+#endif // !_BOOT_MODE
+
+
 /*!	Searches the key in the tree, and stores the offset found in _value,
 	if successful.
 	It's very similar to BPlusTree::SeekDown(), but doesn't fill a stack
@@ -2327,6 +3000,150 @@ BPlusTree::Find(const uint8* key, uint16 keyLength, off_t* _value)
 
 
 #if !_BOOT_MODE
+/*!	Estimates the number of entries in the tree that sort before \a key, and
+	the number of entries that have exactly that key, without iterating over
+	the tree.
+	Only the nodes on the path to the leaf that contains (or would contain)
+	the key are read. Every node on that path is assumed to be representative
+	for its level, and the duplicates of the keys in the leaf give the average
+	number of entries per key. Therefore, the results are rough estimates only,
+	as needed by the query planner.
+	If \a key is \c NULL, only \a _total is valid.
+*/
+status_t
+BPlusTree::EstimateKeyRange(const uint8* key, uint16 keyLength, off_t* _before,
+	off_t* _equal, off_t* _total)
+{
+	if (key != NULL && (keyLength < BPLUSTREE_MIN_KEY_LENGTH
+			|| keyLength > BPLUSTREE_MAX_KEY_LENGTH))
+		RETURN_ERROR(B_BAD_VALUE);
+
+	InodeReadLocker locker(fStream);
+
+	// remember the fan-out and the position of the path through every level
+	uint16 fanOut[kMaxEstimateLevels];
+	uint16 position[kMaxEstimateLevels];
+	uint32 levels = 0;
+
+	off_t nodeOffset = fHeader.RootNode();
+	CachedNode cached(this);
+	const bplustree_node* node;
+	uint16 keyIndex = 0;
+	status_t status = B_ENTRY_NOT_FOUND;
+
+	while ((node = cached.SetTo(nodeOffset)) != NULL) {
+		off_t nextOffset = node->OverflowLink();
+		keyIndex = 0;
+
+		if (key != NULL) {
+			status = _FindKey(node, key, keyLength, &keyIndex, &nextOffset);
+			if (status != B_OK && status != B_ENTRY_NOT_FOUND)
+				return status;
+		} else if (node->NumKeys() > 0)
+			nextOffset = BFS_ENDIAN_TO_HOST_INT64(node->Values()[0]);
+
+		if (node->OverflowLink() == BPLUSTREE_NULL)
+			break;
+
+		if (nextOffset == nodeOffset || levels == kMaxEstimateLevels
+			|| levels > fHeader.MaxNumberOfLevels())
+			RETURN_ERROR(B_BAD_DATA);
+
+		fanOut[levels] = node->NumKeys() + 1;
+		position[levels] = keyIndex;
+		levels++;
+
+		nodeOffset = nextOffset;
+	}
+	if (node == NULL)
+		RETURN_ERROR(B_IO_ERROR);
+
+	// Count the entries in the leaf; only the duplicates of the first few keys
+	// are actually counted, the others are assumed to have the average of
+	// those
+
+	Unaligned<off_t>* values = node->Values();
+	CachedNode duplicates(this);
+	off_t before = 0;
+	off_t equal = 0;
+	off_t entries = 0;
+	off_t sampledEntries = 0;
+	int32 sampled = 0;
+
+	for (int32 i = 0; i < node->NumKeys(); i++) {
+		off_t value = BFS_ENDIAN_TO_HOST_INT64(values[i]);
+		bool isKey = status == B_OK && i == keyIndex;
+		off_t count = 1;
+
+		if (bplustree_node::IsDuplicate(value)) {
+			if (isKey || sampled < kMaxEstimateDuplicateSamples) {
+				count = _EstimateDuplicates(duplicates, value, isKey);
+				sampledEntries += count;
+				sampled++;
+			} else
+				count = sampledEntries / sampled;
+		}
+
+		if (i < keyIndex)
+			before += count;
+		if (isKey)
+			equal = count;
+		entries += count;
+	}
+
+	// Walk back up, and scale the leaf's numbers to the whole tree
+	while (levels-- > 0) {
+		before += position[levels] * entries;
+		entries *= fanOut[levels];
+	}
+
+	if (_before != NULL)
+		*_before = before;
+	if (_equal != NULL)
+		*_equal = equal;
+	if (_total != NULL)
+		*_total = entries;
+	return B_OK;
+}
+
+
+/*!	Returns the number of duplicates stored for the duplicate \a link. Unless
+	\a countAll is \c true, only the first duplicate node is actually read.
+*/
+off_t
+BPlusTree::_EstimateDuplicates(CachedNode& cached, off_t link, bool countAll)
+{
+	const bplustree_node* node = cached.SetTo(
+		bplustree_node::FragmentOffset(link), false);
+	if (node == NULL)
+		return 1;
+
+	if (bplustree_node::LinkType(link) == BPLUSTREE_DUPLICATE_FRAGMENT)
+		return node->CountDuplicates(link, true);
+
+	off_t count = node->CountDuplicates(link, false);
+	int32 nodes = 1;
+
+	for (off_t next = node->RightLink(); next != BPLUSTREE_NULL;
+			next = node->RightLink()) {
+		if (!countAll || nodes >= kMaxEstimateDuplicateNodes) {
+			// assume there is at least one more full node
+			count += NUM_DUPLICATE_VALUES;
+			break;
+		}
+
+		node = cached.SetTo(next, false);
+		if (node == NULL)
+			break;
+
+		count += node->CountDuplicates(next, false);
+		nodes++;
+	}
+
+	return count;
+}
+
+
 status_t
 BPlusTree::_ValidateChildren(TreeCheck& check, uint32 level, off_t offset,
 	const uint8* largestKey, uint16 largestKeyLength,
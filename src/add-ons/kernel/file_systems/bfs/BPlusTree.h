@@ -161,6 +161,16 @@ enum bplustree_traversing {
 class BPlusTree;
 struct TreeCheck;
 class TreeIterator;
+class TreeLoader;
+
+#if !_BOOT_MODE
+struct bulk_load_chunk;
+struct bulk_load_entry;
+struct bulk_load_state;
+struct BulkLoadCompare;
+class BulkLoadLevel;
+class BulkLoadNode;
+#endif
 
 
 #if !_BOOT_MODE
@@ -302,10 +312,18 @@ public:
 			status_t			Replace(Transaction& transaction,
 									const uint8* key, uint16 keyLength,
 									off_t value);
+
+			status_t			BulkLoad(Transaction& transaction,
+									TreeLoader& loader);
 #endif // !_BOOT_MODE
 
 			status_t			Find(const uint8* key, uint16 keyLength,
 									off_t* value);
+#if !_BOOT_MODE
+			status_t			EstimateKeyRange(const uint8* key,
+									uint16 keyLength, off_t* _before,
+									off_t* _equal, off_t* _total);
+#endif
 
 #if !_BOOT_MODE
 	static	int32				TypeCodeToKeyType(type_code code);
@@ -329,6 +347,8 @@ private:
 #if !_BOOT_MODE
 			status_t			_SeekDown(Stack<node_and_key>& stack,
 									const uint8* key, uint16 keyLength);
+			off_t				_EstimateDuplicates(CachedNode& cached,
+									off_t link, bool countAll);
 
 			status_t			_FindFreeDuplicateFragment(
 									Transaction& transaction,
@@ -353,6 +373,25 @@ private:
 									off_t value);
 			void				_RemoveKey(bplustree_node* node, uint16 index);
 
+			status_t			_BulkLoadAllocate(Transaction& transaction,
+									bulk_load_state& state, off_t* _offset);
+			status_t			_BulkLoadDuplicates(Transaction& transaction,
+									bulk_load_state& state,
+									bulk_load_entry** entries, int32 count,
+									off_t* _link);
+			status_t			_BulkLoadWriteNode(Transaction& transaction,
+									const BulkLoadNode& node, off_t offset,
+									off_t leftLink, off_t rightLink,
+									off_t overflowLink);
+			status_t			_BulkLoadIndexLevel(Transaction& transaction,
+									bulk_load_state& state,
+									BulkLoadNode& node,
+									const BulkLoadLevel& children,
+									BulkLoadLevel& parents);
+			status_t			_BulkLoadSplitTransaction(
+									Transaction& transaction,
+									bulk_load_state& state);
+
 			void				_UpdateIterators(off_t offset, off_t nextOffset,
 									uint16 keyIndex, uint16 splitAt,
 									int8 change);
@@ -374,6 +413,9 @@ private:
 			friend class TreeIterator;
 			friend class CachedNode;
 			friend struct TreeCheck;
+#if !_BOOT_MODE
+			friend struct BulkLoadCompare;
+#endif
 
 			Inode*				fStream;
 			bplustree_header	fHeader;
@@ -439,6 +481,39 @@ private:
 };
 
 
+#if !_BOOT_MODE
+/*!	Collects the key/value pairs for BPlusTree::BulkLoad() in memory. */
+class TreeLoader {
+public:
+								TreeLoader(size_t maxMemory
+									= 32 * 1024 * 1024);
+								~TreeLoader();
+
+			status_t			Add(const uint8* key, uint16 keyLength,
+									off_t value);
+			void				MakeEmpty();
+
+			int32				CountEntries() const { return fCount; }
+			size_t				MemoryUsed() const { return fMemoryUsed; }
+
+private:
+								TreeLoader(const TreeLoader& other);
+								TreeLoader& operator=(const TreeLoader& other);
+									// no implementation
+
+private:
+			friend class BPlusTree;
+
+			bulk_load_entry**	fEntries;
+			int32				fCount;
+			int32				fCapacity;
+			bulk_load_chunk*	fChunks;
+			size_t				fMemoryUsed;
+			size_t				fMaxMemory;
+};
+#endif // !_BOOT_MODE
+
+
 //	#pragma mark - BPlusTree's inline functions
 //	(most of them may not be needed)
 
@@ -30,6 +30,15 @@
 // group can span several blocks in the block bitmap, the AllocationBlock
 // class is there to make handling those easier.
 
+// To not have to scan the bitmap for every allocation, each allocation group
+// also keeps an in-memory index of its free extents, sorted by offset and by
+// size. It is built at mount time, and kept up to date on every allocation
+// and free. Since the bitmap blocks are reverted when a transaction is
+// aborted, but the index is not, any range taken from the index is verified
+// against the bitmap before it is used, and the index is rebuilt if needed.
+// If a group is too fragmented, its index is dropped, and the bitmap is
+// scanned instead, as before.
+
 // The current implementation is only slightly optimized and could probably
 // be improved a lot. Furthermore, the allocation policies used here should
 // have some real world tests.
@@ -167,6 +176,88 @@ private:
 #endif
 
 
+static const int32 kMaxFreeExtentsPerGroup = 2048;
+	// limits the memory used for the index of a single group to 64 kB
+
+
+struct free_extent {
+	SplayTreeLink<free_extent>	offsetLink;
+	free_extent*				offsetNext;
+	SplayTreeLink<free_extent>	sizeLink;
+	int32						start;
+	int32						length;
+
+	int32 End() const { return start + length; }
+};
+
+
+struct FreeExtentOffsetTreeDefinition {
+	typedef int32 KeyType;
+	typedef free_extent NodeType;
+
+	static KeyType GetKey(const NodeType* node)
+	{
+		return node->start;
+	}
+
+	static SplayTreeLink<NodeType>* GetLink(NodeType* node)
+	{
+		return &node->offsetLink;
+	}
+
+	static int Compare(KeyType key, const NodeType* node)
+	{
+		return key == node->start ? 0 : (key < node->start ? -1 : 1);
+	}
+
+	static NodeType** GetListLink(NodeType* node)
+	{
+		return &node->offsetNext;
+	}
+};
+
+
+struct free_extent_size {
+	int32	length;
+	int32	start;
+
+	free_extent_size(int32 length, int32 start)
+		:
+		length(length),
+		start(start)
+	{
+	}
+};
+
+
+struct FreeExtentSizeTreeDefinition {
+	typedef free_extent_size KeyType;
+	typedef free_extent NodeType;
+
+	static KeyType GetKey(const NodeType* node)
+	{
+		return free_extent_size(node->length, node->start);
+	}
+
+	static SplayTreeLink<NodeType>* GetLink(NodeType* node)
+	{
+		return &node->sizeLink;
+	}
+
+	static int Compare(const KeyType& key, const NodeType* node)
+	{
+		if (key.length != node->length)
+			return key.length < node->length ? -1 : 1;
+
+		return key.start == node->start ? 0 : (key.start < node->start ? -1 : 1);
+	}
+};
+
+
+typedef IteratableSplayTree<FreeExtentOffsetTreeDefinition> FreeExtentOffsetTree;
+typedef SplayTree<FreeExtentSizeTreeDefinition> FreeExtentSizeTree;
+
+
 class AllocationBlock : public CachedBlock {
 public:
 	AllocationBlock(Volume* volume);
@@ -192,23 +283,45 @@ private:
 };
 
 
-class AllocationGroup {
+class AllocationGroup : public TransactionListener {
 public:
 	AllocationGroup();
+	virtual ~AllocationGroup();
 
+	void Reset();
 	void AddFreeRange(int32 start, int32 blocks);
 	bool IsFull() const { return fFreeBits == 0; }
 
 	status_t Allocate(Transaction& transaction, uint16 start, int32 length);
 	status_t Free(Transaction& transaction, uint16 start, int32 length);
 
+	bool HasFreeExtents() const { return fExtentsValid; }
+	bool FindFreeExtent(int32 start, int32 maximum, int32& _start,
+		int32& _length);
+
 	uint32 NumBits() const { return fNumBits; }
 	uint32 NumBitmapBlocks() const { return fNumBitmapBlocks; }
 	int32 Start() const { return fStart; }
 
+	virtual void TransactionDone(bool success);
+	virtual void RemovedFromTransaction();
+
+private:
+	void _AddToTransaction(Transaction& transaction);
+	void _AddExtent(int32 start, int32 length);
+	void _InsertExtent(free_extent* extent);
+	void _RemoveExtent(free_extent* extent);
+	void _AllocateExtents(int32 start, int32 length);
+	void _FreeExtents(int32 start, int32 length);
+	void _ClearExtents();
+	void _InvalidateExtents();
+
 private:
 	friend class BlockAllocator;
 
+	BlockAllocator* fAllocator;
+	bool	fInTransaction;
+
 	uint32	fNumBits;
 	uint32	fNumBitmapBlocks;
 	int32	fStart;
@@ -218,6 +331,11 @@ private:
 	int32	fLargestStart;
 	int32	fLargestLength;
 	bool	fLargestValid;
+
+	FreeExtentOffsetTree fExtentsByOffset;
+	FreeExtentSizeTree fExtentsBySize;
+	int32	fExtentCount;
+	bool	fExtentsValid;
 };
 
 
@@ -368,10 +486,35 @@ AllocationBlock::Free(uint16 start, uint16 numBlocks)
 */
 AllocationGroup::AllocationGroup()
 	:
+	fAllocator(NULL),
+	fInTransaction(false),
 	fFirstFree(-1),
 	fFreeBits(0),
-	fLargestValid(false)
+	fLargestValid(false),
+	fExtentCount(0),
+	fExtentsValid(true)
+{
+}
+
+
+AllocationGroup::~AllocationGroup()
+{
+	_ClearExtents();
+}
+
+
+/*!	Forgets everything about the free space in this group, so that it can be
+	filled in again using AddFreeRange().
+*/
+void
+AllocationGroup::Reset()
 {
+	_ClearExtents();
+	fExtentsValid = true;
+
+	fFirstFree = -1;
+	fFreeBits = 0;
+	fLargestValid = false;
 }
 
 
@@ -391,6 +534,40 @@ AllocationGroup::AddFreeRange(int32 start, int32 blocks)
 	}
 
 	fFreeBits += blocks;
+
+	_AddExtent(start, blocks);
+}
+
+
+/*!	Looks up a free extent for an allocation of \a maximum blocks. If the
+	free space at \a start is large enough, it is preferred, so that files
+	can grow contiguously. Otherwise, the smallest extent that can hold
+	\a maximum blocks is chosen, or the largest one, if there is none.
+	Returns \c false if the group has no free extents.
+*/
+bool
+AllocationGroup::FindFreeExtent(int32 start, int32 maximum, int32& _start,
+	int32& _length)
+{
+	ASSERT(fExtentsValid);
+
+	free_extent* extent = fExtentsByOffset.FindClosest(start, false, true);
+	if (extent != NULL && extent->End() - start >= maximum) {
+		_start = start;
+		_length = extent->End() - start;
+		return true;
+	}
+
+	extent = fExtentsBySize.FindClosest(free_extent_size(maximum, 0), true,
+		true);
+	if (extent == NULL)
+		extent = fExtentsBySize.FindMax();
+	if (extent == NULL)
+		return false;
+
+	_start = extent->start;
+	_length = extent->length;
+	return true;
 }
 
 
@@ -433,6 +610,9 @@ AllocationGroup::Allocate(Transaction& transaction, uint16 start, int32 length)
 		}
 	}
 
+	_AllocateExtents(start, length);
+	_AddToTransaction(transaction);
+
 	Volume* volume = transaction.GetVolume();
 
 	// calculate block in the block bitmap and position within
@@ -484,6 +664,9 @@ AllocationGroup::Free(Transaction& transaction, uint16 start, int32 length)
 	ASSERT(!fLargestValid || start + length <= fLargestStart
 		|| start > fLargestStart);
 
+	int32 firstBit = start;
+	int32 totalLength = length;
+
 	if (fLargestValid
 		&& (start + length == fLargestStart
 			|| fLargestStart + fLargestLength == start
@@ -494,6 +677,8 @@ AllocationGroup::Free(Transaction& transaction, uint16 start, int32 length)
 		fLargestValid = false;
 	}
 
+	_AddToTransaction(transaction);
+
 	Volume* volume = transaction.GetVolume();
 
 	// calculate block in the block bitmap and position within
@@ -519,10 +704,202 @@ AllocationGroup::Free(Transaction& transaction, uint16 start, int32 length)
 		T(Block("free-2", block, cached.Block(), volume->BlockSize()));
 		block++;
 	}
+
+	// Only add the range to the index after it has been freed successfully
+	_FreeExtents(firstBit, totalLength);
 	return B_OK;
 }
 
 
+void
+AllocationGroup::TransactionDone(bool success)
+{
+	if (success)
+		return;
+
+	// The journal has reverted our part of the block bitmap, but neither the
+	// free extents nor the other free space information - read them in again
+	RecursiveLocker locker(fAllocator->Lock());
+
+	int32 index = this - fAllocator->fGroups;
+	if (fAllocator->_RescanGroup(index) != B_OK) {
+		FATAL(("could not rescan allocation group %" B_PRId32 " after an "
+			"aborted transaction\n", index));
+	}
+}
+
+
+void
+AllocationGroup::RemovedFromTransaction()
+{
+	fInTransaction = false;
+}
+
+
+/*!	Makes sure the group is notified when \a transaction is aborted, so that
+	it can update the free space information it changed.
+*/
+void
+AllocationGroup::_AddToTransaction(Transaction& transaction)
+{
+	if (fInTransaction)
+		return;
+
+	transaction.AddListener(this);
+	fInTransaction = true;
+}
+
+
+void
+AllocationGroup::_AddExtent(int32 start, int32 length)
+{
+	if (!fExtentsValid)
+		return;
+
+	if (fExtentCount >= kMaxFreeExtentsPerGroup) {
+		// this group is too fragmented, let's fall back to the bitmap
+		_InvalidateExtents();
+		return;
+	}
+
+	free_extent* extent = new(std::nothrow) free_extent;
+	if (extent == NULL) {
+		_InvalidateExtents();
+		return;
+	}
+
+	extent->start = start;
+	extent->length = length;
+	_InsertExtent(extent);
+	fExtentCount++;
+}
+
+
+void
+AllocationGroup::_InsertExtent(free_extent* extent)
+{
+	fExtentsByOffset.Insert(extent);
+	fExtentsBySize.Insert(extent);
+}
+
+
+void
+AllocationGroup::_RemoveExtent(free_extent* extent)
+{
+	fExtentsByOffset.Remove(extent);
+	fExtentsBySize.Remove(extent);
+}
+
+
+/*!	Removes the specified range from the free extents. */
+void
+AllocationGroup::_AllocateExtents(int32 start, int32 length)
+{
+	if (!fExtentsValid)
+		return;
+
+	int32 end = start + length;
+
+	free_extent* extent = fExtentsByOffset.FindClosest(start, false, true);
+	if (extent == NULL || extent->End() <= start)
+		extent = fExtentsByOffset.FindClosest(start, true, false);
+
+	while (extent != NULL && extent->start < end) {
+		free_extent* next = extent->offsetNext;
+		_RemoveExtent(extent);
+
+		int32 extentEnd = extent->End();
+		if (extent->start < start) {
+			// keep the part in front of the range
+			extent->length = start - extent->start;
+			_InsertExtent(extent);
+
+			if (extentEnd > end) {
+				_AddExtent(end, extentEnd - end);
+				return;
+			}
+		} else if (extentEnd > end) {
+			// keep the part behind the range
+			extent->start = end;
+			extent->length = extentEnd - end;
+			_InsertExtent(extent);
+		} else {
+			delete extent;
+			fExtentCount--;
+		}
+
+		extent = next;
+	}
+}
+
+
+/*!	Adds the specified range to the free extents, and merges it with its
+	neighbours.
+*/
+void
+AllocationGroup::_FreeExtents(int32 start, int32 length)
+{
+	if (!fExtentsValid)
+		return;
+
+	int32 end = start + length;
+
+	free_extent* previous = fExtentsByOffset.FindClosest(start, false, false);
+	free_extent* next = fExtentsByOffset.FindClosest(start, true, true);
+
+	if ((previous != NULL && previous->End() > start)
+		|| (next != NULL && next->start < end)) {
+		// The range was already partially free - the index doesn't match the
+		// bitmap anymore
+		_InvalidateExtents();
+		return;
+	}
+
+	bool mergePrevious = previous != NULL && previous->End() == start;
+	bool mergeNext = next != NULL && next->start == end;
+
+	if (mergePrevious) {
+		fExtentsBySize.Remove(previous);
+		previous->length += length;
+
+		if (mergeNext) {
+			previous->length += next->length;
+			_RemoveExtent(next);
+			delete next;
+			fExtentCount--;
+		}
+
+		fExtentsBySize.Insert(previous);
+	} else if (mergeNext) {
+		_RemoveExtent(next);
+		next->start = start;
+		next->length += length;
+		_InsertExtent(next);
+	} else
+		_AddExtent(start, length);
+}
+
+
+void
+AllocationGroup::_ClearExtents()
+{
+	while (free_extent* extent = fExtentsByOffset.FindMin()) {
+		_RemoveExtent(extent);
+		delete extent;
+	}
+
+	fExtentCount = 0;
+}
+
+
+void
+AllocationGroup::_InvalidateExtents()
+{
+	_ClearExtents();
+	fExtentsValid = false;
+}
+
+
 //	#pragma mark -
 
 
@@ -555,6 +932,9 @@ BlockAllocator::Initialize(bool full)
 	if (fGroups == NULL)
 		return B_NO_MEMORY;
 
+	for (int32 i = 0; i < fNumGroups; i++)
+		fGroups[i].fAllocator = this;
+
 	if (!full)
 		return B_OK;
 
@@ -610,9 +990,8 @@ BlockAllocator::InitializeAndClearBitmap(Transaction& transaction)
 			fGroups[i].fNumBitmapBlocks = fBlocksPerGroup;
 		}
 		fGroups[i].fStart = offset;
-		fGroups[i].fFirstFree = fGroups[i].fLargestStart = 0;
-		fGroups[i].fFreeBits = fGroups[i].fLargestLength = fGroups[i].fNumBits;
-		fGroups[i].fLargestValid = true;
+		fGroups[i].Reset();
+		fGroups[i].AddFreeRange(0, fGroups[i].fNumBits);
 
 		offset += fBlocksPerGroup;
 	}
@@ -767,6 +1146,8 @@ BlockAllocator::AllocateBlocks(Transaction& transaction, int32 groupIndex,
 	RecursiveLocker lock(fLock);
 
 	uint32 bitsPerFullBlock = fVolume->BlockSize() << 3;
+	int32 firstGroup = groupIndex;
+	uint16 firstStart = start;
 
 	// Find the block_run that can fulfill the request best
 	int32 bestGroup = -1;
@@ -782,6 +1163,24 @@ BlockAllocator::AllocateBlocks(Transaction& transaction, int32 groupIndex,
 		if (start >= group.NumBits() || group.IsFull())
 			continue;
 
+		if (group.HasFreeExtents()) {
+			// We don't need to look at the bitmap at all
+			int32 extentStart;
+			int32 extentLength;
+			if (group.FindFreeExtent(start, maximum, extentStart,
+					extentLength)
+				&& extentLength > bestLength) {
+				bestGroup = groupIndex;
+				bestStart = extentStart;
+				bestLength = extentLength;
+			}
+
+			if (bestLength >= maximum)
+				break;
+
+			continue;
+		}
+
 		// The wanted maximum is smaller than the largest free block in the
 		// group or already smaller than the minimum
 
@@ -920,6 +1319,21 @@ BlockAllocator::AllocateBlocks(Transaction& transaction, int32 groupIndex,
 		bestLength = round_down(bestLength, minimum);
 	}
 
+	if (fGroups[bestGroup].HasFreeExtents()
+		&& CheckBlocks(((off_t)bestGroup << fVolume->AllocationGroupShift())
+			+ bestStart, bestLength, false) != B_OK) {
+		// The index does not match the bitmap; aborted transactions rescan
+		// the groups they changed, so this should not happen, but better be
+		// safe than sorry - rebuild it, and try again
+		INFORM(("free extents of group %" B_PRId32 " are out of date\n",
+			bestGroup));
+		if (_RescanGroup(bestGroup) != B_OK)
+			RETURN_ERROR(B_IO_ERROR);
+
+		return AllocateBlocks(transaction, firstGroup, firstStart, maximum,
+			minimum, run);
+	}
+
 	if (fGroups[bestGroup].Allocate(transaction, bestStart, bestLength) != B_OK)
 		RETURN_ERROR(B_IO_ERROR);
 
@@ -1086,6 +1500,71 @@ BlockAllocator::Free(Transaction& transaction, block_run run)
 }
 
 
+/*!	Reads in the block bitmap again, and updates the free space information of
+	all allocation groups. This is needed after the bitmap has been changed
+	directly, like by checkfs.
+	The allocator lock must be held.
+*/
+status_t
+BlockAllocator::RescanBitmap()
+{
+	ASSERT_LOCKED_RECURSIVE(&fLock);
+
+	for (int32 i = 0; i < fNumGroups; i++) {
+		status_t status = _RescanGroup(i);
+		if (status != B_OK)
+			return status;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Rebuilds the free space information of the given allocation group from
+	the block bitmap.
+*/
+status_t
+BlockAllocator::_RescanGroup(int32 groupIndex)
+{
+	AllocationGroup& group = fGroups[groupIndex];
+	group.Reset();
+
+	AllocationBlock cached(fVolume);
+	uint32 bitsPerFullBlock = fVolume->BlockSize() << 3;
+	int32 start = -1;
+
+	for (uint32 block = 0; block < group.NumBitmapBlocks(); block++) {
+		if (cached.SetTo(group, block) != B_OK) {
+			group._InvalidateExtents();
+			RETURN_ERROR(B_IO_ERROR);
+		}
+
+		int32 offset = block * bitsPerFullBlock;
+		uint32 bit = 0;
+
+		while (bit < cached.NumBlockBits()) {
+			if (!cached.IsUsed(bit)) {
+				if (start < 0)
+					start = offset + bit;
+				bit++;
+				continue;
+			}
+
+			if (start >= 0) {
+				group.AddFreeRange(start, offset + bit - start);
+				start = -1;
+			}
+			bit = cached.NextFree(bit);
+		}
+	}
+
+	if (start >= 0)
+		group.AddFreeRange(start, group.NumBits() - start);
+
+	return B_OK;
+}
+
+
 #ifdef DEBUG_FRAGMENTER
 void
 BlockAllocator::Fragment()
@@ -1187,6 +1666,14 @@ BlockAllocator::_CheckGroup(int32 groupIndex) const
 			fVolume, (int)groupIndex, (int)group.fLargestStart,
 			(int)group.fLargestLength, (int)largestStart, (int)largestLength);
 	}
+
+	free_extent* largest = group.fExtentsBySize.FindMax();
+	if (group.fExtentsValid && largest != NULL
+		&& largest->length != largestLength) {
+		panic("bfs %p: group %d largest free extent differs: %d.%d, checked "
+			"%d.%d.\n", fVolume, (int)groupIndex, (int)largest->start,
+			(int)largest->length, (int)largestStart, (int)largestLength);
+	}
 }
 #endif	// DEBUG_ALLOCATION_GROUPS
 
@@ -1213,11 +1700,8 @@ BlockAllocator::Trim(uint64 offset, uint64 size, uint64& trimmedSize)
 	RecursiveLocker locker(fLock);
 
 	// TODO: take given offset and size into account!
-	int32 lastGroup = fNumGroups - 1;
-	uint32 firstBlock = 0;
-	uint32 firstBit = 0;
-	uint64 currentBlock = 0;
 	uint32 blockShift = fVolume->BlockShift();
+	uint32 bitsPerFullBlock = fVolume->BlockSize() << 3;
 
 	uint64 firstFree = 0;
 	uint64 freeLength = 0;
@@ -1226,44 +1710,53 @@ BlockAllocator::Trim(uint64 offset, uint64 size, uint64& trimmedSize)
 	trimmedSize = 0;
 
 	AllocationBlock cached(fVolume);
-	for (int32 groupIndex = 0; groupIndex <= lastGroup; groupIndex++) {
+	for (int32 groupIndex = 0; groupIndex < fNumGroups; groupIndex++) {
 		AllocationGroup& group = fGroups[groupIndex];
+		uint64 groupOffset
+			= (uint64)groupIndex << fVolume->AllocationGroupShift();
+
+		if (group.HasFreeExtents() && !_FreeExtentsMatchBitmap(groupIndex)) {
+			// We must never trim anything that is in use
+			status_t status = _RescanGroup(groupIndex);
+			if (status != B_OK)
+				return status;
+		}
 
-		for (uint32 block = firstBlock; block < group.NumBitmapBlocks(); block++) {
-			cached.SetTo(group, block);
-
-			for (uint32 i = firstBit; i < cached.NumBlockBits(); i++) {
-				if (cached.IsUsed(i)) {
-					// Block is in use
-					if (freeLength > 0) {
-						// Overflow is unlikely to happen, but check it anyway
-						if ((firstFree << blockShift) >> blockShift
-								!= firstFree
-							|| (freeLength << blockShift) >> blockShift
-								!= freeLength) {
-							FATAL(("BlockAllocator::Trim:"
-								" Overflow detected!\n"));
-							return B_ERROR;
-						}
-						status_t status = _TrimNext(*trimData, kTrimRanges,
-							firstFree << blockShift, freeLength << blockShift,
-							false, trimmedSize);
-						if (status != B_OK)
-							return status;
+		if (group.HasFreeExtents()) {
+			FreeExtentOffsetTree::Iterator iterator
+				= group.fExtentsByOffset.GetIterator();
+			while (free_extent* extent = iterator.Next()) {
+				status_t status = _TrimFree(*trimData, kTrimRanges,
+					groupOffset + extent->start, extent->length, firstFree,
+					freeLength, trimmedSize);
+				if (status != B_OK)
+					return status;
+			}
+			continue;
+		}
 
-						freeLength = 0;
-					}
-				} else if (freeLength++ == 0) {
-					// Block is free, start new free range
-					firstFree = currentBlock;
-				}
+		for (uint32 block = 0; block < group.NumBitmapBlocks(); block++) {
+			if (cached.SetTo(group, block) != B_OK)
+				RETURN_ERROR(B_IO_ERROR);
+
+			uint64 offset = groupOffset + block * bitsPerFullBlock;
+			uint32 bit = cached.NextFree(0);
+
+			while (bit < cached.NumBlockBits()) {
+				uint32 start = bit;
+				while (bit < cached.NumBlockBits() && !cached.IsUsed(bit))
+					bit++;
 
-				currentBlock++;
+				status_t status = _TrimFree(*trimData, kTrimRanges,
+					offset + start, bit - start, firstFree, freeLength,
+					trimmedSize);
+				if (status != B_OK)
+					return status;
+
+				if (bit < cached.NumBlockBits())
+					bit = cached.NextFree(bit);
 			}
 		}
-
-		firstBlock = 0;
-		firstBit = 0;
 	}
 
 	return _TrimNext(*trimData, kTrimRanges, firstFree << blockShift,
@@ -1360,6 +1853,64 @@ BlockAllocator::CheckBlockRun(block_run run, const char* type, bool allocated)
 }
 
 
+/*!	Checks all free extents of the given allocation group against the block
+	bitmap.
+*/
+bool
+BlockAllocator::_FreeExtentsMatchBitmap(int32 groupIndex)
+{
+	AllocationGroup& group = fGroups[groupIndex];
+	off_t groupOffset = (off_t)groupIndex << fVolume->AllocationGroupShift();
+
+	FreeExtentOffsetTree::Iterator iterator
+		= group.fExtentsByOffset.GetIterator();
+	while (free_extent* extent = iterator.Next()) {
+		if (CheckBlocks(groupOffset + extent->start, extent->length, false)
+				!= B_OK)
+			return false;
+	}
+
+	return true;
+}
+
+
+/*!	Adds the free range of \a length blocks at \a block to the free range
+	that is currently collected in \a firstFree and \a freeLength, or trims
+	the latter, if the two cannot be joined.
+*/
+status_t
+BlockAllocator::_TrimFree(fs_trim_data& trimData, uint32 maxRanges,
+	uint64 block, uint64 length, uint64& firstFree, uint64& freeLength,
+	uint64& trimmedSize)
+{
+	if (freeLength > 0 && firstFree + freeLength == block) {
+		freeLength += length;
+		return B_OK;
+	}
+
+	if (freeLength > 0) {
+		uint32 blockShift = fVolume->BlockShift();
+
+		// Overflow is unlikely to happen, but check it anyway
+		if ((firstFree << blockShift) >> blockShift != firstFree
+			|| (freeLength << blockShift) >> blockShift != freeLength) {
+			FATAL(("BlockAllocator::Trim: Overflow detected!\n"));
+			return B_ERROR;
+		}
+
+		status_t status = _TrimNext(trimData, maxRanges,
+			firstFree << blockShift, freeLength << blockShift, false,
+			trimmedSize);
+		if (status != B_OK)
+			return status;
+	}
+
+	firstFree = block;
+	freeLength = length;
+	return B_OK;
+}
+
+
 bool
 BlockAllocator::_AddTrim(fs_trim_data& trimData, uint32 maxRanges,
 	uint64 offset, uint64 size)
@@ -1435,6 +1986,17 @@ BlockAllocator::Dump(int32 index)
 			group.fLargestValid ? "" : "  (invalid)");
 		kprintf("      largest length: %" B_PRId32 "\n", group.fLargestLength);
 		kprintf("      free bits:      %" B_PRId32 "\n", group.fFreeBits);
+
+		if (!group.fExtentsValid) {
+			kprintf("      free extents:   (none, using bitmap)\n");
+			continue;
+		}
+
+		free_extent* largest = group.fExtentsBySize.FindMax();
+		kprintf("      free extents:   %" B_PRId32 ", largest %" B_PRId32
+			".%" B_PRId32 "\n", group.fExtentCount,
+			largest != NULL ? largest->start : -1,
+			largest != NULL ? largest->length : 0);
 	}
 }
 
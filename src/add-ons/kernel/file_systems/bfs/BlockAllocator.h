@@ -46,6 +46,8 @@ public:
 			status_t		Trim(uint64 offset, uint64 size,
 								uint64& trimmedSize);
 
+			status_t		RescanBitmap();
+
 			status_t		CheckBlocks(off_t start, off_t length,
 								bool allocated = true,
 								off_t* firstError = NULL);
@@ -68,6 +70,13 @@ private:
 #ifdef DEBUG_ALLOCATION_GROUPS
 			void			_CheckGroup(int32 group) const;
 #endif
+			status_t		_RescanGroup(int32 group);
+			bool			_FreeExtentsMatchBitmap(int32 group);
+
+			status_t		_TrimFree(fs_trim_data& trimData,
+								uint32 maxRanges, uint64 block, uint64 length,
+								uint64& firstFree, uint64& freeLength,
+								uint64& trimmedSize);
 			bool			_AddTrim(fs_trim_data& trimData, uint32 maxRanges,
 								uint64 offset, uint64 size);
 			status_t		_TrimNext(fs_trim_data& trimData, uint32 maxRanges,
@@ -77,6 +86,8 @@ private:
 	static	status_t		_Initialize(BlockAllocator* self);
 
 private:
+	friend class AllocationGroup;
+
 			Volume*			fVolume;
 			recursive_lock	fLock;
 			AllocationGroup* fGroups;
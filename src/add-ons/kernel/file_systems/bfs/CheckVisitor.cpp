@@ -10,12 +10,22 @@
 
 #include "CheckVisitor.h"
 
+#ifndef FS_SHELL
+#	include <algorithm>
+
+#	include <smp.h>
+#endif
+
 #include "BlockAllocator.h"
 #include "BPlusTree.h"
 #include "Inode.h"
 #include "Volume.h"
 
 
+static const int32 kMaxCheckWorkers = 16;
+static const int32 kMaxPendingItemsPerWorker = 64;
+
+
 struct check_index {
 	check_index()
 		:
@@ -28,17 +38,52 @@ struct check_index {
 	Inode*				inode;
 };
 
+/*!	An inode that has been visited, but whose blocks and B+tree are checked
+	by a worker thread. The result is handed out by CheckNextNode().
+*/
+struct check_item : DoublyLinkedListLinkImpl<check_item> {
+	Inode*				inode;
+	ino_t				id;
+	uint32				mode;
+	uint32				errors;
+	status_t			status;
+	bool				failed;
+	bool				index;
+	bool				repairTree;
+	char				name[B_FILE_NAME_LENGTH];
+};
+
+/*!	Every worker checks the inodes of a fixed subset of the allocation
+	groups, and collects its statistics in its own check_control; they are
+	merged into the visitor's when the bitmap pass is done.
+*/
+struct check_worker {
+	CheckVisitor*		visitor;
+	thread_id			thread;
+	sem_id				sem;
+	CheckItemList		queue;
+	check_control		control;
+};
+
 
 CheckVisitor::CheckVisitor(Volume* volume)
 	:
 	FileSystemVisitor(volume),
-	fCheckBitmap(NULL)
+	fCheckBitmap(NULL),
+	fWorkers(NULL),
+	fWorkerCount(0),
+	fCompletedSem(-1),
+	fPendingItems(0),
+	fUnfinishedItems(0),
+	fTraversalDone(false),
+	fTraversalStatus(B_OK)
 {
 }
 
 
 CheckVisitor::~CheckVisitor()
 {
+	_StopWorkers();
 	free(fCheckBitmap);
 }
 
@@ -73,6 +118,17 @@ CheckVisitor::StartBitmapPass()
 	Control().pass = BFS_CHECK_PASS_BITMAP;
 	Control().stats.block_size = GetVolume()->BlockSize();
 
+	if ((Control().flags & BFS_CHECK_IN_PARALLEL) != 0) {
+		status_t status = _StartWorkers();
+		if (status != B_OK) {
+			free(fCheckBitmap);
+			fCheckBitmap = NULL;
+			recursive_lock_unlock(&GetVolume()->Allocator().Lock());
+			GetVolume()->GetJournal(0)->Unlock(NULL, true);
+			return status;
+		}
+	}
+
 	// TODO: check reserved area in bitmap!
 
 	Start(VISIT_REGULAR | VISIT_INDICES | VISIT_REMOVED
@@ -82,6 +138,21 @@ CheckVisitor::StartBitmapPass()
 }
 
 
+/*!	Advances the check to the next node, and fills in the check_control
+	with the results for that node.
+	In parallel mode, the file system traversal runs ahead of the reported
+	node, and the inodes it finds are checked by the worker threads.
+*/
+status_t
+CheckVisitor::CheckNextNode()
+{
+	if (fWorkers != NULL)
+		return _NextParallel();
+
+	return Next();
+}
+
+
 status_t
 CheckVisitor::WriteBackCheckBitmap()
 {
@@ -92,7 +163,6 @@ CheckVisitor::WriteBackCheckBitmap()
 	size_t size = _BitmapSize();
 	off_t usedBlocks = 0LL;
 
-	// TODO: update the allocation groups used blocks info
 	for (uint32 i = size >> 2; i-- > 0;) {
 		uint32 compare = 1;
 		// Count the number of bits set
@@ -153,6 +223,9 @@ CheckVisitor::WriteBackCheckBitmap()
 			}
 			transaction.Done();
 		}
+
+		// the allocation groups need to learn about the changes, too
+		return GetVolume()->Allocator().RescanBitmap();
 	}
 
 	return B_OK;
@@ -190,6 +263,7 @@ CheckVisitor::StopChecking()
 	if (Control().status != B_ENTRY_NOT_FOUND)
 		FATAL(("CheckVisitor didn't run through\n"));
 
+	_StopWorkers();
 	_FreeIndices();
 
 	recursive_lock_unlock(&GetVolume()->Allocator().Lock());
@@ -227,6 +301,7 @@ CheckVisitor::VisitDirectoryEntry(Inode* inode, Inode* parent,
 
 			if ((Control().flags & BFS_FIX_NAME_MISMATCHES) != 0) {
 				// Rename the inode
+				_WaitForWorkers();
 				Transaction transaction(GetVolume(), inode->BlockNumber());
 
 				// Note, this may need extra blocks, but the inode will
@@ -293,32 +368,21 @@ CheckVisitor::VisitInode(Inode* inode, const char* treeName)
 	switch (Pass()) {
 		case BFS_CHECK_PASS_BITMAP:
 		{
-			status = _CheckInodeBlocks(inode, NULL);
+			if (fWorkers != NULL)
+				return _QueueInode(inode, treeName);
+
+			bool repairTree = false;
+			status = _CheckInode(Control(), inode, repairTree);
 			if (status != B_OK)
 				return status;
 
-			// Check the B+tree as well
-			if (inode->IsContainer()) {
-				bool repairErrors = (Control().flags & BFS_FIX_BPLUSTREES) != 0;
-				bool errorsFound = false;
-
-				status = inode->Tree()->Validate(repairErrors, errorsFound);
-
-				if (errorsFound) {
-					Control().errors |= BFS_INVALID_BPLUSTREE;
-					if (inode->IsIndex() && treeName != NULL && repairErrors) {
-						// We completely rebuild corrupt indices
-						check_index* index = new(std::nothrow) check_index;
-						if (index == NULL)
-							return B_NO_MEMORY;
-
-						strlcpy(index->name, treeName, sizeof(index->name));
-						index->run = inode->BlockRun();
-						Indices().Push(index);
-					}
-				}
+			if (repairTree && inode->IsIndex() && treeName != NULL) {
+				status = _AddIndexToRebuild(treeName, inode->BlockRun());
+				if (status != B_OK)
+					return status;
 			}
 
+			status = Control().status;
 			break;
 		}
 
@@ -394,6 +458,7 @@ CheckVisitor::_RemoveInvalidNode(Inode* parent, BPlusTree* tree,
 	// won't touch the block bitmap (which we hold the lock for)
 	// if we set the INODE_DONT_FREE_SPACE flag - since we fix
 	// the bitmap anyway.
+	_WaitForWorkers();
 	Transaction transaction(GetVolume(), parent->BlockNumber());
 	status_t status;
 
@@ -457,6 +522,23 @@ CheckVisitor::_SetCheckBitmapAt(off_t block)
 }
 
 
+/*!	Sets the bit of the block in the check bitmap, and returns whether or
+	not it had been set already. This is safe to be called from several
+	workers at once.
+*/
+bool
+CheckVisitor::_TestAndSetCheckBitmapAt(off_t block)
+{
+	size_t size = _BitmapSize();
+	uint32 index = block / 32;	// 32bit resolution
+	if (index > size / 4)
+		return false;
+
+	int32 mask = HOST_ENDIAN_TO_BFS_INT32(1UL << (block & 0x1f));
+	return (atomic_or((int32*)&fCheckBitmap[index], mask) & mask) != 0;
+}
+
+
 size_t
 CheckVisitor::_BitmapSize() const
 {
@@ -464,10 +546,46 @@ CheckVisitor::_BitmapSize() const
 }
 
 
+/*!	Checks the blocks of the inode, and validates its B+tree, if any.
+	Errors that prevent the check from continuing, like I/O errors, are
+	returned, and abort the check; damage that was found is reported in
+	\a control.
+*/
+status_t
+CheckVisitor::_CheckInode(check_control& control, Inode* inode,
+	bool& _repairTree)
+{
+	status_t status = _CheckInodeBlocks(control, inode);
+	if (status != B_OK)
+		return status;
+
+	control.status = B_OK;
+
+	// Check the B+tree as well
+	if (inode->IsContainer()) {
+		bool repairErrors = (control.flags & BFS_FIX_BPLUSTREES) != 0;
+		bool errorsFound = false;
+
+		// Validate() reports damage via errorsFound, it only fails if the
+		// tree could not be checked at all
+		status = inode->Tree()->Validate(repairErrors, errorsFound);
+		if (status != B_OK)
+			return status;
+
+		if (errorsFound) {
+			control.errors |= BFS_INVALID_BPLUSTREE;
+			_repairTree = repairErrors;
+		}
+	}
+
+	return B_OK;
+}
+
+
 status_t
-CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
+CheckVisitor::_CheckInodeBlocks(check_control& control, Inode* inode)
 {
-	status_t status = _CheckAllocated(inode->BlockRun(), "inode");
+	status_t status = _CheckAllocated(control, inode->BlockRun(), "inode");
 	if (status != B_OK)
 		return status;
 
@@ -488,12 +606,12 @@ CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
 			if (data->direct[i].IsZero())
 				break;
 
-			status = _CheckAllocated(data->direct[i], "direct");
+			status = _CheckAllocated(control, data->direct[i], "direct");
 			if (status < B_OK)
 				return status;
 
-			Control().stats.direct_block_runs++;
-			Control().stats.blocks_in_direct
+			control.stats.direct_block_runs++;
+			control.stats.blocks_in_direct
 				+= data->direct[i].Length();
 		}
 	}
@@ -503,7 +621,7 @@ CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
 	// check the indirect range
 
 	if (data->max_indirect_range) {
-		status = _CheckAllocated(data->indirect, "indirect");
+		status = _CheckAllocated(control, data->indirect, "indirect");
 		if (status != B_OK)
 			return status;
 
@@ -521,15 +639,16 @@ CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
 				if (runs[index].IsZero())
 					break;
 
-				status = _CheckAllocated(runs[index], "indirect->run");
+				status = _CheckAllocated(control, runs[index],
+					"indirect->run");
 				if (status < B_OK)
 					return status;
 
-				Control().stats.indirect_block_runs++;
-				Control().stats.blocks_in_indirect
+				control.stats.indirect_block_runs++;
+				control.stats.blocks_in_indirect
 					+= runs[index].Length();
 			}
-			Control().stats.indirect_array_blocks++;
+			control.stats.indirect_array_blocks++;
 
 			if (index < runsPerBlock)
 				break;
@@ -539,7 +658,8 @@ CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
 	// check the double indirect range
 
 	if (data->max_double_indirect_range) {
-		status = _CheckAllocated(data->double_indirect, "double indirect");
+		status = _CheckAllocated(control, data->double_indirect,
+			"double indirect");
 		if (status != B_OK)
 			return status;
 
@@ -562,7 +682,8 @@ CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
 			if (indirect.IsZero())
 				return B_OK;
 
-			status = _CheckAllocated(indirect, "double indirect->runs");
+			status = _CheckAllocated(control, indirect,
+				"double indirect->runs");
 			if (status != B_OK)
 				return status;
 
@@ -583,18 +704,18 @@ CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
 					if (runs[index % runsPerBlock].IsZero())
 						return B_OK;
 
-					status = _CheckAllocated(runs[index % runsPerBlock],
-						"double indirect->runs->run");
+					status = _CheckAllocated(control,
+						runs[index % runsPerBlock], "double indirect->runs->run");
 					if (status != B_OK)
 						return status;
 
-					Control().stats.double_indirect_block_runs++;
-					Control().stats.blocks_in_double_indirect
+					control.stats.double_indirect_block_runs++;
+					control.stats.blocks_in_double_indirect
 						+= runs[index % runsPerBlock].Length();
 				} while ((++index % runsPerBlock) != 0);
 			}
 
-			Control().stats.double_indirect_array_blocks++;
+			control.stats.double_indirect_array_blocks++;
 		}
 	}
 
@@ -603,13 +724,14 @@ CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
 
 
 status_t
-CheckVisitor::_CheckAllocated(block_run run, const char* type)
+CheckVisitor::_CheckAllocated(check_control& control, block_run run,
+	const char* type)
 {
 	BlockAllocator& allocator = GetVolume()->Allocator();
 
 	// make sure the block run is valid
 	if (!allocator.IsValidBlockRun(run, type)) {
-		Control().errors |= BFS_INVALID_BLOCK_RUN;
+		control.errors |= BFS_INVALID_BLOCK_RUN;
 		return B_OK;
 	}
 
@@ -642,7 +764,7 @@ CheckVisitor::_CheckAllocated(block_run run, const char* type)
 			type, run.AllocationGroup(), run.Start(),
 			run.Length(), firstMissing, afterLastMissing - 1));
 
-		Control().stats.missing += afterLastMissing - firstMissing;
+		control.stats.missing += afterLastMissing - firstMissing;
 
 		block = afterLastMissing;
 	}
@@ -651,12 +773,12 @@ CheckVisitor::_CheckAllocated(block_run run, const char* type)
 	off_t firstSet = -1;
 
 	for (block = start; block < end; block++) {
-		if (_CheckBitmapIsUsedAt(block)) {
+		if (_TestAndSetCheckBitmapAt(block)) {
 			if (firstSet == -1) {
 				firstSet = block;
-				Control().errors |= BFS_BLOCKS_ALREADY_SET;
+				control.errors |= BFS_BLOCKS_ALREADY_SET;
 			}
-			Control().stats.already_set++;
+			control.stats.already_set++;
 		} else {
 			if (firstSet != -1) {
 				FATAL(("%s: block_run(%d, %u, %u): blocks %" B_PRIdOFF
@@ -665,7 +787,6 @@ CheckVisitor::_CheckAllocated(block_run run, const char* type)
 					firstSet, block - 1));
 				firstSet = -1;
 			}
-			_SetCheckBitmapAt(block);
 		}
 	}
 
@@ -673,6 +794,22 @@ CheckVisitor::_CheckAllocated(block_run run, const char* type)
 }
 
 
+/*!	Remembers the index to be rebuilt in the index pass. */
+status_t
+CheckVisitor::_AddIndexToRebuild(const char* name, block_run run)
+{
+	// We completely rebuild corrupt indices
+	check_index* index = new(std::nothrow) check_index;
+	if (index == NULL)
+		return B_NO_MEMORY;
+
+	strlcpy(index->name, name, sizeof(index->name));
+	index->run = run;
+	Indices().Push(index);
+	return B_OK;
+}
+
+
 status_t
 CheckVisitor::_PrepareIndices()
 {
@@ -772,3 +909,306 @@ CheckVisitor::_AddInodeToIndex(Inode* inode)
 
 	return transaction.Done();
 }
+
+
+//	#pragma mark - parallel checking
+
+
+/*!	Starts one worker thread per CPU. If no threads can be started (like in
+	the fs_shell), the inodes are checked by the calling thread, but still
+	take the same route through the work queues.
+*/
+status_t
+CheckVisitor::_StartWorkers()
+{
+#ifdef FS_SHELL
+	int32 threadCount = 0;
+#else
+	int32 threadCount = std::min(smp_get_num_cpus(), kMaxCheckWorkers);
+#endif
+
+	fWorkers = new(std::nothrow) check_worker[std::max(threadCount, (int32)1)];
+	if (fWorkers == NULL)
+		return B_NO_MEMORY;
+
+	fCompletedSem = create_sem(0, "bfs check completed");
+	if (fCompletedSem < 0) {
+		delete[] fWorkers;
+		fWorkers = NULL;
+		return fCompletedSem;
+	}
+
+	mutex_init(&fWorkLock, "bfs check workers");
+	fPendingItems = 0;
+	fUnfinishedItems = 0;
+	fTraversalDone = false;
+	fTraversalStatus = B_OK;
+
+	for (fWorkerCount = 0; fWorkerCount < threadCount; fWorkerCount++) {
+		check_worker& worker = fWorkers[fWorkerCount];
+		worker.visitor = this;
+		worker.sem = create_sem(0, "bfs check worker");
+		if (worker.sem < 0)
+			break;
+
+		worker.thread = spawn_kernel_thread(&CheckVisitor::_Worker,
+			"bfs check worker", B_NORMAL_PRIORITY, &worker);
+		if (worker.thread < 0) {
+			delete_sem(worker.sem);
+			break;
+		}
+
+		memset(&worker.control, 0, sizeof(check_control));
+		worker.control.flags = Control().flags;
+		resume_thread(worker.thread);
+	}
+
+	if (fWorkerCount == 0) {
+		check_worker& worker = fWorkers[0];
+		worker.visitor = this;
+		worker.thread = -1;
+		worker.sem = -1;
+		memset(&worker.control, 0, sizeof(check_control));
+		worker.control.flags = Control().flags;
+		fWorkerCount = 1;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Stops the worker threads, and merges their statistics into the
+	visitor's check_control.
+*/
+void
+CheckVisitor::_StopWorkers()
+{
+	if (fWorkers == NULL)
+		return;
+
+	for (int32 i = 0; i < fWorkerCount; i++) {
+		check_worker& worker = fWorkers[i];
+		if (worker.thread >= 0) {
+			delete_sem(worker.sem);
+			wait_for_thread(worker.thread, NULL);
+		}
+
+		while (check_item* item = worker.queue.RemoveHead())
+			_FreeItem(item);
+
+#define MERGE_STATS(field) \
+		Control().stats.field += worker.control.stats.field
+		MERGE_STATS(missing);
+		MERGE_STATS(already_set);
+		MERGE_STATS(direct_block_runs);
+		MERGE_STATS(indirect_block_runs);
+		MERGE_STATS(indirect_array_blocks);
+		MERGE_STATS(double_indirect_block_runs);
+		MERGE_STATS(double_indirect_array_blocks);
+		MERGE_STATS(blocks_in_direct);
+		MERGE_STATS(blocks_in_indirect);
+		MERGE_STATS(blocks_in_double_indirect);
+		MERGE_STATS(partial_block_runs);
+#undef MERGE_STATS
+	}
+
+	while (check_item* item = fCompletedItems.RemoveHead())
+		_FreeItem(item);
+
+	delete_sem(fCompletedSem);
+	fCompletedSem = -1;
+	mutex_destroy(&fWorkLock);
+
+	delete[] fWorkers;
+	fWorkers = NULL;
+	fWorkerCount = 0;
+}
+
+
+/*!	Waits until the workers have checked all inodes handed to them so far.
+	This must be called before anything is written to the volume, so that
+	all changes are made while the workers are idle.
+*/
+void
+CheckVisitor::_WaitForWorkers()
+{
+	if (fWorkers == NULL)
+		return;
+
+	MutexLocker locker(fWorkLock);
+	while (fUnfinishedItems > 0) {
+		locker.Unlock();
+		acquire_sem(fCompletedSem);
+		locker.Lock();
+	}
+}
+
+
+status_t
+CheckVisitor::_NextParallel()
+{
+	// Let the traversal run ahead, so that the workers always have
+	// something to do
+	while (!fTraversalDone
+		&& fPendingItems < kMaxPendingItemsPerWorker * fWorkerCount) {
+		status_t status = Next();
+		if (status != B_OK) {
+			fTraversalDone = true;
+			fTraversalStatus = status;
+		}
+	}
+
+	check_item* item = _GetCompletedItem();
+	if (item == NULL) {
+		// All nodes have been checked, we no longer need the workers
+		_StopWorkers();
+		return fTraversalStatus;
+	}
+
+	if (item->failed) {
+		// The inode could not be checked, this ends the check like in
+		// sequential mode
+		status_t status = item->status;
+		_FreeItem(item);
+		return status;
+	}
+
+	Control().inode = item->id;
+	Control().mode = item->mode;
+	Control().errors = item->errors;
+	Control().status = item->status;
+	strlcpy(Control().name, item->name, B_FILE_NAME_LENGTH);
+
+	status_t status = B_OK;
+	if (item->repairTree && item->index)
+		status = _AddIndexToRebuild(item->name, item->inode->BlockRun());
+
+	_FreeItem(item);
+	return status;
+}
+
+
+/*!	Hands the inode over to the worker responsible for its allocation
+	group. The errors found so far during the traversal are reported
+	together with the results of the worker.
+*/
+status_t
+CheckVisitor::_QueueInode(Inode* inode, const char* treeName)
+{
+	check_item* item = new(std::nothrow) check_item;
+	if (item == NULL)
+		return B_NO_MEMORY;
+
+	status_t status = acquire_vnode(GetVolume()->FSVolume(), inode->ID());
+	if (status != B_OK) {
+		delete item;
+		return status;
+	}
+
+	item->inode = inode;
+	item->id = inode->ID();
+	item->mode = inode->Mode();
+	item->errors = Control().errors;
+	item->status = B_OK;
+	item->failed = false;
+	item->index = inode->IsIndex() && treeName != NULL;
+	item->repairTree = false;
+	strlcpy(item->name, Control().name, B_FILE_NAME_LENGTH);
+
+	Control().errors = 0;
+	fPendingItems++;
+
+	check_worker& worker
+		= fWorkers[inode->BlockRun().AllocationGroup() % fWorkerCount];
+	if (worker.thread < 0) {
+		_CheckItem(worker, item);
+
+		MutexLocker locker(fWorkLock);
+		fCompletedItems.Add(item);
+		return B_OK;
+	}
+
+	MutexLocker locker(fWorkLock);
+	worker.queue.Add(item);
+	fUnfinishedItems++;
+	locker.Unlock();
+
+	release_sem(worker.sem);
+	return B_OK;
+}
+
+
+/*!	Returns the next item the workers are done with, and waits for one if
+	necessary. Returns \c NULL if there are no more items.
+*/
+check_item*
+CheckVisitor::_GetCompletedItem()
+{
+	MutexLocker locker(fWorkLock);
+	while (true) {
+		check_item* item = fCompletedItems.RemoveHead();
+		if (item != NULL) {
+			fPendingItems--;
+			return item;
+		}
+		if (fUnfinishedItems == 0)
+			return NULL;
+
+		locker.Unlock();
+		acquire_sem(fCompletedSem);
+		locker.Lock();
+	}
+}
+
+
+void
+CheckVisitor::_CheckItem(check_worker& worker, check_item* item)
+{
+	worker.control.errors = 0;
+
+	status_t status = _CheckInode(worker.control, item->inode,
+		item->repairTree);
+	if (status != B_OK) {
+		item->status = status;
+		item->failed = true;
+	} else
+		item->status = worker.control.status;
+
+	item->errors |= worker.control.errors;
+}
+
+
+void
+CheckVisitor::_FreeItem(check_item* item)
+{
+	put_vnode(GetVolume()->FSVolume(), item->id);
+	delete item;
+}
+
+
+/*static*/ status_t
+CheckVisitor::_Worker(void* _worker)
+{
+	check_worker* worker = (check_worker*)_worker;
+	CheckVisitor* visitor = worker->visitor;
+
+	while (acquire_sem(worker->sem) == B_OK) {
+		MutexLocker locker(visitor->fWorkLock);
+		check_item* item = worker->queue.RemoveHead();
+		locker.Unlock();
+
+		if (item == NULL)
+			continue;
+
+		visitor->_CheckItem(*worker, item);
+
+		locker.Lock();
+		visitor->fCompletedItems.Add(item);
+		visitor->fUnfinishedItems--;
+		locker.Unlock();
+
+		release_sem(visitor->fCompletedSem);
+	}
+
+	return B_OK;
+}
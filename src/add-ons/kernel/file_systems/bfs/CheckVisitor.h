@@ -17,8 +17,11 @@
 class BlockAllocator;
 class BPlusTree;
 struct check_index;
+struct check_item;
+struct check_worker;
 
 typedef Stack<check_index*> IndexStack;
+typedef DoublyLinkedList<check_item> CheckItemList;
 
 
 class CheckVisitor : public FileSystemVisitor {
@@ -31,6 +34,7 @@ public:
 			uint32				Pass() { return control.pass; }
 
 			status_t			StartBitmapPass();
+			status_t			CheckNextNode();
 			status_t			WriteBackCheckBitmap();
 			status_t			StartIndexPass();
 			status_t			StopChecking();
@@ -54,22 +58,49 @@ private:
 			bool				_ControlValid();
 			bool				_CheckBitmapIsUsedAt(off_t block) const;
 			void				_SetCheckBitmapAt(off_t block);
-			status_t			_CheckInodeBlocks(Inode* inode,
-									const char* name);
-			status_t			_CheckAllocated(block_run run,
-									const char* type);
+			bool				_TestAndSetCheckBitmapAt(off_t block);
+			status_t			_CheckInode(check_control& control,
+									Inode* inode, bool& _repairTree);
+			status_t			_CheckInodeBlocks(check_control& control,
+									Inode* inode);
+			status_t			_CheckAllocated(check_control& control,
+									block_run run, const char* type);
 
 			size_t				_BitmapSize() const;
 
+			status_t			_AddIndexToRebuild(const char* name,
+									block_run run);
 			status_t			_PrepareIndices();
 			void				_FreeIndices();
 			status_t			_AddInodeToIndex(Inode* inode);
 
+			status_t			_StartWorkers();
+			void				_StopWorkers();
+			void				_WaitForWorkers();
+			status_t			_NextParallel();
+			status_t			_QueueInode(Inode* inode, const char* treeName);
+			check_item*			_GetCompletedItem();
+			void				_CheckItem(check_worker& worker,
+									check_item* item);
+			void				_FreeItem(check_item* item);
+	static	status_t			_Worker(void* _worker);
+
 private:
 			check_control		control;
 			IndexStack			indices;
 
 			uint32*				fCheckBitmap;
+
+			// parallel checking
+			check_worker*		fWorkers;
+			int32				fWorkerCount;
+			mutex				fWorkLock;
+			sem_id				fCompletedSem;
+			CheckItemList		fCompletedItems;
+			int32				fPendingItems;
+			int32				fUnfinishedItems;
+			bool				fTraversalDone;
+			status_t			fTraversalStatus;
 };
 
 
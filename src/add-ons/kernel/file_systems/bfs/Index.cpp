@@ -12,11 +12,163 @@
 #include <file_systems/QueryParserUtils.h>
 
 #include "Debug.h"
+#include "FileSystemVisitor.h"
 #include "Volume.h"
 #include "Inode.h"
 #include "BPlusTree.h"
 
 
+/*!	Collects the keys of all files on the volume for a single index, and
+	feeds them to BPlusTree::BulkLoad(). If there are more keys than fit
+	into the TreeLoader's memory budget, the collected keys are bulk loaded,
+	and the remaining ones are inserted one by one.
+*/
+class IndexRebuildVisitor : public FileSystemVisitor {
+public:
+								IndexRebuildVisitor(Volume* volume,
+									Inode* index, const char* name);
+
+	virtual status_t			VisitInode(Inode* inode, const char* treeName);
+
+			status_t			Finish();
+
+private:
+			bool				_GetKey(Inode* inode, uint8* key,
+									uint16* _length);
+			status_t			_BulkLoad();
+			status_t			_Insert(Inode* inode, const uint8* key,
+									uint16 length);
+
+private:
+			Inode*				fIndex;
+			const char*			fName;
+			TreeLoader			fLoader;
+			bool				fBulkLoaded;
+};
+
+
+IndexRebuildVisitor::IndexRebuildVisitor(Volume* volume, Inode* index,
+	const char* name)
+	:
+	FileSystemVisitor(volume),
+	fIndex(index),
+	fName(name),
+	fBulkLoaded(false)
+{
+}
+
+
+status_t
+IndexRebuildVisitor::VisitInode(Inode* inode, const char* treeName)
+{
+	// one more byte for the terminating null of a name
+	uint8 key[MAX_INDEX_KEY_LENGTH + 1];
+	uint16 length;
+	if (!_GetKey(inode, key, &length))
+		return B_OK;
+
+	if (!fBulkLoaded) {
+		status_t status = fLoader.Add(key, length, inode->ID());
+		if (status != B_BUFFER_OVERFLOW)
+			return status;
+
+		// We ran out of memory; load what we have, and insert the rest
+		status = _BulkLoad();
+		if (status != B_OK)
+			return status;
+	}
+
+	return _Insert(inode, key, length);
+}
+
+
+status_t
+IndexRebuildVisitor::Finish()
+{
+	if (fBulkLoaded)
+		return B_OK;
+
+	return _BulkLoad();
+}
+
+
+bool
+IndexRebuildVisitor::_GetKey(Inode* inode, uint8* key, uint16* _length)
+{
+	if (!strcmp(fName, "name")) {
+		if (!inode->InNameIndex()
+			|| inode->GetName((char*)key, MAX_INDEX_KEY_LENGTH + 1) != B_OK)
+			return false;
+
+		*_length = strlen((char*)key);
+	} else if (!strcmp(fName, "last_modified")) {
+		if (!inode->InLastModifiedIndex())
+			return false;
+
+		int64 modified = inode->OldLastModified();
+		memcpy(key, &modified, sizeof(int64));
+		*_length = sizeof(int64);
+	} else if (!strcmp(fName, "size")) {
+		if (!inode->InSizeIndex())
+			return false;
+
+		int64 size = inode->Size();
+		memcpy(key, &size, sizeof(int64));
+		*_length = sizeof(int64);
+	} else {
+		size_t length = MAX_INDEX_KEY_LENGTH;
+		if (inode->ReadAttribute(fName, B_ANY_TYPE, 0, key, &length) != B_OK)
+			return false;
+
+		*_length = length;
+	}
+
+	return *_length > 0;
+}
+
+
+status_t
+IndexRebuildVisitor::_BulkLoad()
+{
+	BPlusTree* tree = fIndex->Tree();
+	if (tree == NULL)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	Transaction transaction(GetVolume(), fIndex->BlockNumber());
+	fIndex->WriteLockInTransaction(transaction);
+
+	status_t status = tree->BulkLoad(transaction, fLoader);
+	if (status == B_OK)
+		status = transaction.Done();
+
+	fLoader.MakeEmpty();
+	fBulkLoaded = true;
+
+	RETURN_ERROR(status);
+}
+
+
+status_t
+IndexRebuildVisitor::_Insert(Inode* inode, const uint8* key, uint16 length)
+{
+	BPlusTree* tree = fIndex->Tree();
+	if (tree == NULL)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	Transaction transaction(GetVolume(), inode->BlockNumber());
+	fIndex->WriteLockInTransaction(transaction);
+
+	status_t status = tree->Insert(transaction, key, length, inode->ID());
+	if (status != B_OK)
+		return status;
+
+	return transaction.Done();
+}
+
+
+//	#pragma mark -
+
+
 Index::Index(Volume* volume)
 	:
 	fVolume(volume),
@@ -210,6 +362,45 @@ Index::Create(Transaction& transaction, const char* name, uint32 type)
 }
 
 
+/*!	Throws away the contents of the index, and fills it again with the keys
+	of all files on the volume.
+	The tree is built bottom-up via BPlusTree::BulkLoad(), which is much
+	faster than inserting the keys one by one, and leaves the nodes densely
+	packed. The journal stays locked during the whole operation, so the
+	index cannot change behind our back.
+*/
+status_t
+Index::Rebuild()
+{
+	if (fNode == NULL || fName == NULL)
+		return B_BAD_VALUE;
+
+	BPlusTree* tree = fNode->Tree();
+	if (tree == NULL)
+		return B_BAD_VALUE;
+
+	Journal* journal = fVolume->GetJournal(0);
+	journal->Lock(NULL, true);
+
+	status_t status = tree->MakeEmpty();
+	if (status == B_OK) {
+		IndexRebuildVisitor visitor(fVolume, fNode, fName);
+		visitor.Start(VISIT_REGULAR);
+
+		do {
+			status = visitor.Next();
+		} while (status == B_OK);
+		visitor.Stop();
+
+		if (status == B_ENTRY_NOT_FOUND)
+			status = visitor.Finish();
+	}
+
+	journal->Unlock(NULL, true);
+	RETURN_ERROR(status);
+}
+
+
 /*!	Updates the specified index, the oldKey will be removed from, the newKey
 	inserted into the tree.
 	If the method returns B_BAD_INDEX, it means the index couldn't be found -
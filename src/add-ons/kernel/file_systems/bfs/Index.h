@@ -28,6 +28,7 @@ public:
 
 			status_t		Create(Transaction& transaction, const char* name,
 								uint32 type);
+			status_t		Rebuild();
 
 			status_t		Update(Transaction& transaction, const char* name,
 								int32 type, const uint8* oldKey,
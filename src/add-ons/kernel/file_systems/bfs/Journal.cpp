@@ -15,6 +15,11 @@
 #include "Inode.h"
 
 
+static const bigtime_t kDefaultGroupCommitLatency = 2000;
+	// how long the log flusher waits for more transactions to join a log
+	// write that has been requested via Journal::CommitLog()
+
+
 struct run_array {
 	int32		count;
 	int32		max_runs;
@@ -407,10 +412,20 @@ Journal::Journal(Volume* volume)
 	fUsed(0),
 	fUnwrittenTransactions(0),
 	fHasSubtransaction(false),
-	fSeparateSubTransactions(false)
+	fSeparateSubTransactions(false),
+	fCommitWaiters(0),
+	fLastCommitWaiters(0),
+	fCommitsStarted(0),
+	fCommitsDone(0),
+	fCommitStatus(B_OK),
+	fCommitRequested(false),
+	fGroupCommitLatency(kDefaultGroupCommitLatency)
 {
 	recursive_lock_init(&fLock, "bfs journal");
 	mutex_init(&fEntriesLock, "bfs journal entries");
+	mutex_init(&fCommitLock, "bfs journal commit");
+
+	fCommitSem = create_sem(0, "bfs log commit");
 
 	fLogFlusherSem = create_sem(0, "bfs log flusher");
 	fLogFlusher = spawn_kernel_thread(&Journal::_LogFlusher, "bfs log flusher",
@@ -431,6 +446,9 @@ Journal::~Journal()
 	fLogFlusherSem = -1;
 	delete_sem(logFlusher);
 	wait_for_thread(fLogFlusher, NULL);
+
+	delete_sem(fCommitSem);
+	mutex_destroy(&fCommitLock);
 }
 
 
@@ -713,12 +731,52 @@ Journal::_LogFlusher(void* _journal)
 		if (acquire_sem(journal->fLogFlusherSem) != B_OK)
 			continue;
 
-		journal->_FlushLog(false, false);
+		if (journal->fCommitRequested)
+			journal->_GroupCommit();
+		else
+			journal->_FlushLog(false, false);
 	}
 	return B_OK;
 }
 
 
+/*!	Writes all pending transactions to the log on behalf of the threads
+	waiting in CommitLog(), and wakes them up in one go.
+	If the previous commit had to serve more than one thread, the log flusher
+	waits a bit before actually writing the log, so that more transactions
+	can join this log write, and share its drive cache flush.
+*/
+void
+Journal::_GroupCommit()
+{
+	if (fGroupCommitLatency > 0 && fLastCommitWaiters > 1)
+		snooze(fGroupCommitLatency);
+
+	MutexLocker locker(fCommitLock);
+	fCommitRequested = false;
+	int32 commit = ++fCommitsStarted;
+	locker.Unlock();
+
+	status_t status = _FlushLog(true, false);
+	if (status != B_OK) {
+		FATAL(("group commit %" B_PRId32 " failed: %s\n", commit,
+			strerror(status)));
+	}
+
+	locker.Lock();
+	fCommitsDone = commit;
+	fCommitStatus = status;
+
+	int32 waiters = fCommitWaiters;
+	fCommitWaiters = 0;
+	fLastCommitWaiters = waiters;
+	locker.Unlock();
+
+	if (waiters > 0)
+		release_sem_etc(fCommitSem, waiters, 0);
+}
+
+
 /*!	Writes the blocks that are part of current transaction into the log,
 	and ends the current transaction.
 	If the current transaction is too large to fit into the log, it will
@@ -966,6 +1024,55 @@ Journal::FlushLogAndBlocks()
 }
 
 
+/*!	Makes sure that all transactions that have been completed up to now are
+	safely stored in the log, but does not write back the blocks themselves.
+	Concurrent callers are coalesced into a single log write that is done by
+	the log flusher thread (group commit).
+*/
+status_t
+Journal::CommitLog()
+{
+	if (fUnwrittenTransactions == 0) {
+		// Everything has already been written to the log; this is only
+		// reset after the log has been written and the drive cache flushed
+		return B_OK;
+	}
+
+	if (fLogFlusher < 0 || fCommitSem < 0
+		|| recursive_lock_get_recursion(&fLock) > 0) {
+		// We cannot wait for the log flusher, if we're inside a transaction
+		return _FlushLog(true, false);
+	}
+
+	MutexLocker locker(fCommitLock);
+
+	// Only a commit that starts after this point will contain all
+	// transactions that have been completed so far
+	int32 commit = fCommitsStarted + 1;
+
+	while (fCommitsDone - commit < 0) {
+		fCommitWaiters++;
+
+		bool request = !fCommitRequested;
+		fCommitRequested = true;
+		locker.Unlock();
+
+		if (request)
+			release_sem(fLogFlusherSem);
+
+		// All waiters are woken up after each commit, and have to check
+		// whether it was the one they were waiting for
+		status_t status = acquire_sem(fCommitSem);
+		if (status != B_OK)
+			return status;
+
+		locker.Lock();
+	}
+
+	return fCommitStatus;
+}
+
+
 status_t
 Journal::Lock(Transaction* owner, bool separateSubTransactions)
 {
@@ -1118,6 +1225,10 @@ Journal::Dump()
 	kprintf("  transaction ID:       %" B_PRId32 "\n", fTransactionID);
 	kprintf("  has subtransaction:   %d\n", fHasSubtransaction);
 	kprintf("  separate sub-trans.:  %d\n", fSeparateSubTransactions);
+	kprintf("  commits:              %" B_PRId32 " (%" B_PRId32 " done, "
+		"%" B_PRId32 " waiting, last group %" B_PRId32 ")\n", fCommitsStarted,
+		fCommitsDone, fCommitWaiters, fLastCommitWaiters);
+	kprintf("  commit latency:       %" B_PRId64 "\n", fGroupCommitLatency);
 	kprintf("entries:\n");
 	kprintf("  address        id  start length\n");
 
@@ -36,11 +36,17 @@ public:
 			bool			CurrentTransactionTooLarge() const;
 
 			status_t		FlushLogAndBlocks();
+			status_t		CommitLog();
 			Volume*			GetVolume() const { return fVolume; }
 			int32			TransactionID() const { return fTransactionID; }
 
 	inline	uint32			FreeLogBlocks() const;
 
+			void			SetGroupCommitLatency(bigtime_t latency)
+								{ fGroupCommitLatency = latency; }
+			bigtime_t		GroupCommitLatency() const
+								{ return fGroupCommitLatency; }
+
 #ifdef BFS_DEBUGGER_COMMANDS
 			void			Dump();
 #endif
@@ -50,6 +56,7 @@ private:
 								{ return fHasSubtransaction; }
 
 			status_t		_FlushLog(bool canWait, bool flushBlocks);
+			void			_GroupCommit();
 			uint32			_TransactionSize() const;
 			status_t		_WriteTransactionToLog();
 			status_t		_CheckRunArray(const run_array* array);
@@ -79,6 +86,16 @@ private:
 
 			thread_id		fLogFlusher;
 			sem_id			fLogFlusherSem;
+
+			mutex			fCommitLock;
+			sem_id			fCommitSem;
+			int32			fCommitWaiters;
+			int32			fLastCommitWaiters;
+			int32			fCommitsStarted;
+			int32			fCommitsDone;
+			status_t		fCommitStatus;
+			bool			fCommitRequested;
+			bigtime_t		fGroupCommitLatency;
 };
 
 
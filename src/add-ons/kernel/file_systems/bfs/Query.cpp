@@ -130,6 +130,36 @@ struct Query::QueryPolicy {
 		return size;
 	}
 
+	static status_t IndexEstimateEntries(Index& index, const void* key,
+		size_t keyLength, off_t* _before, off_t* _equal, off_t* _total)
+	{
+		BPlusTree* tree = index.Node()->Tree();
+		if (tree == NULL)
+			return B_BAD_VALUE;
+
+		if (key == NULL || !index.isSpecialTime) {
+			return tree->EstimateKeyRange((const uint8*)key, keyLength,
+				_before, _equal, _total);
+		}
+
+		// The time index contains shifted values with a unique part in the
+		// lower bits, so all entries for the same time form a range.
+		int64 start = *(int64*)key << INODE_TIME_SHIFT;
+		int64 end = (*(int64*)key + 1) << INODE_TIME_SHIFT;
+		off_t endBefore;
+		status_t status = tree->EstimateKeyRange((const uint8*)&start,
+			sizeof(start), _before, NULL, _total);
+		if (status == B_OK) {
+			status = tree->EstimateKeyRange((const uint8*)&end, sizeof(end),
+				&endBefore, NULL, NULL);
+		}
+		if (status != B_OK)
+			return status;
+
+		*_equal = endBefore > *_before ? endBefore - *_before : 0;
+		return B_OK;
+	}
+
 	static type_code IndexGetType(Index& index)
 	{
 		return index.Type();
@@ -206,6 +236,11 @@ struct Query::QueryPolicy {
 		return B_OK;
 	}
 
+	static ino_t IndexIteratorGetNodeID(IndexIterator* iterator)
+	{
+		return iterator->offset;
+	}
+
 	static void IndexIteratorSkipDuplicates(IndexIterator* iterator)
 	{
 		iterator->SkipDuplicates();
@@ -289,6 +324,13 @@ struct Query::QueryPolicy {
 	{
 		return context->fVolume->ID();
 	}
+
+	static status_t ContextGetEntry(Context* context, ino_t id,
+		NodeHolder& holder, Inode** _entry)
+	{
+		holder.vnode.SetTo(context->fVolume, id);
+		return holder.vnode.Get(_entry);
+	}
 };
 
 
@@ -84,6 +84,10 @@ struct check_control {
 	 */
 #define BFS_FIX_NAME_MISMATCHES	8
 #define BFS_FIX_BPLUSTREES		16
+#define BFS_CHECK_IN_PARALLEL	32
+	/* checks the inodes using one thread per CPU; the nodes are still
+	 * reported one by one, but no longer in traversal order
+	 */
 
 /* values for the errors field */
 #define BFS_MISSING_BLOCKS		1
@@ -103,5 +107,13 @@ struct check_control {
  */
 #define BFS_IOCTL_RESIZE		14205
 
+/* Rebuilds an index from scratch using the keys of all files on the volume.
+ * The parameter is the name of the index.
+ */
+#define BFS_IOCTL_REBUILD_INDEX	14206
+
+/* fs_create_index() flag: fill the new index with the existing files */
+#define BFS_INDEX_EXISTING_FILES	0x01
+
 
 #endif	/* BFS_CONTROL_H */
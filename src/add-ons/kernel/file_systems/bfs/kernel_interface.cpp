@@ -185,6 +185,19 @@ bfs_mount(fs_volume* _volume, const char* device, uint32 flags,
 		RETURN_ERROR(status);
 	}
 
+	if (args != NULL) {
+		void* handle = parse_driver_settings_string(args);
+		if (handle != NULL) {
+			const char* latency = get_driver_parameter(handle,
+				"group_commit_latency", NULL, NULL);
+			if (latency != NULL) {
+				volume->GetJournal(0)->SetGroupCommitLatency(
+					strtoul(latency, NULL, 0));
+			}
+			unload_driver_settings(handle);
+		}
+	}
+
 	_volume->private_volume = volume;
 	_volume->ops = &gBFSVolumeOps;
 	*_rootID = volume->ToVnode(volume->Root());
@@ -740,7 +753,7 @@ bfs_ioctl(fs_volume* _volume, fs_vnode* _node, void* _cookie, uint32 cmd,
 
 			checker->Control().errors = 0;
 
-			status_t status = checker->Next();
+			status_t status = checker->CheckNextNode();
 			if (status == B_ENTRY_NOT_FOUND) {
 				checker->Control().status = B_ENTRY_NOT_FOUND;
 					// tells StopChecking() that we finished the pass
@@ -793,6 +806,28 @@ bfs_ioctl(fs_volume* _volume, fs_vnode* _node, void* _cookie, uint32 cmd,
 			ResizeVisitor resizer(volume);
 			return resizer.Resize(size, -1);
 		}
+		case BFS_IOCTL_REBUILD_INDEX:
+		{
+			if (volume->IsReadOnly())
+				return B_READ_ONLY_DEVICE;
+			if (geteuid() != 0)
+				return B_NOT_ALLOWED;
+
+			char name[B_FILE_NAME_LENGTH];
+			ssize_t length = user_strlcpy(name, (const char*)buffer,
+				sizeof(name));
+			if (length < 0)
+				return B_BAD_ADDRESS;
+			if ((size_t)length >= sizeof(name))
+				return B_NAME_TOO_LONG;
+
+			Index index(volume);
+			status_t status = index.SetTo(name);
+			if (status != B_OK)
+				return status;
+
+			return index.Rebuild();
+		}
 
 #ifdef DEBUG_FRAGMENTER
 		case 56741:
@@ -853,8 +888,18 @@ bfs_fsync(fs_volume* _volume, fs_vnode* _node)
 {
 	FUNCTION();
 
+	Volume* volume = (Volume*)_volume->private_volume;
 	Inode* inode = (Inode*)_node->private_node;
-	return inode->Sync();
+
+	status_t status = inode->Sync();
+	if (status != B_OK)
+		return status;
+
+	// make sure the changes to the inode itself are on disk, too
+	if (volume->IsReadOnly())
+		return B_OK;
+
+	return volume->GetJournal(0)->CommitLog();
 }
 
 
@@ -2197,6 +2242,14 @@ bfs_create_index(fs_volume* _volume, const char* name, uint32 type,
 	if (status == B_OK)
 		status = transaction.Done();
 
+	if (status == B_OK && (flags & BFS_INDEX_EXISTING_FILES) != 0) {
+		// the index has been created already, so a failure here only
+		// leaves it incomplete
+		status = index.SetTo(name);
+		if (status == B_OK)
+			status = index.Rebuild();
+	}
+
 	RETURN_ERROR(status);
 }
 
@@ -8,15 +8,21 @@
 
 #ifdef FS_SHELL
 
+#include <algorithm>
+	// needs to be included before the wrapper
+
 #include "fssh_api_wrapper.h"
 #include "fssh_auto_deleter.h"
 
+#include <kernel/util/SplayTree.h>
+
 #else	// !FS_SHELL
 
 #include <AutoDeleter.h>
 #include <util/AutoLock.h>
 #include <util/DoublyLinkedList.h>
 #include <util/SinglyLinkedList.h>
+#include <util/SplayTree.h>
 #include <util/Stack.h>
 
 #include <ByteOrder.h>
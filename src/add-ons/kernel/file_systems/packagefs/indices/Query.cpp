@@ -99,6 +99,12 @@ struct Query::QueryPolicy {
 		return index.index->CountEntries();
 	}
 
+	static status_t IndexEstimateEntries(Index& index, const void* key,
+		size_t keyLength, off_t* _before, off_t* _equal, off_t* _total)
+	{
+		return B_NOT_SUPPORTED;
+	}
+
 	static type_code IndexGetType(Index& index)
 	{
 		return index.index->Type();
@@ -157,6 +163,11 @@ struct Query::QueryPolicy {
 		return B_OK;
 	}
 
+	static ino_t IndexIteratorGetNodeID(IndexIterator* indexIterator)
+	{
+		return indexIterator->entry->ID();
+	}
+
 	static void IndexIteratorSkipDuplicates(IndexIterator* indexIterator)
 	{
 		// Nothing to do.
@@ -226,6 +237,12 @@ struct Query::QueryPolicy {
 	{
 		return context->fVolume->ID();
 	}
+
+	static status_t ContextGetEntry(Context* context, ino_t id,
+		NodeHolder& holder, Entry** _entry)
+	{
+		return B_NOT_SUPPORTED;
+	}
 };
 
 
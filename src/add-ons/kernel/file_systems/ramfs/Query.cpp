@@ -180,6 +180,12 @@ struct Query::QueryPolicy {
 		return index.index->CountEntries();
 	}
 
+	static status_t IndexEstimateEntries(Index& index, const void* key,
+		size_t keyLength, off_t* _before, off_t* _equal, off_t* _total)
+	{
+		return B_NOT_SUPPORTED;
+	}
+
 	static type_code IndexGetType(Index& index)
 	{
 		return index.index->GetType();
@@ -225,6 +231,11 @@ struct Query::QueryPolicy {
 		return B_OK;
 	}
 
+	static ino_t IndexIteratorGetNodeID(IndexIterator* indexIterator)
+	{
+		return indexIterator->entry->GetNode()->GetID();
+	}
+
 	static void IndexIteratorSkipDuplicates(IndexIterator* indexIterator)
 	{
 		// Nothing to do.
@@ -282,6 +293,12 @@ struct Query::QueryPolicy {
 	{
 		return context->fVolume->GetID();
 	}
+
+	static status_t ContextGetEntry(Context* context, ino_t id,
+		NodeHolder& holder, Entry** _entry)
+	{
+		return B_NOT_SUPPORTED;
+	}
 };
 
 
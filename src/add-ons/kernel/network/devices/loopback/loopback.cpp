@@ -61,6 +61,8 @@ loopback_init(const char *name, net_device **_device)
 	device->type = IFT_LOOP;
 	device->mtu = 65536;
 	device->media = IFM_ACTIVE;
+	device->offload = NET_DEVICE_OFFLOAD_TCP_SEGMENTATION;
+		// there is no wire, so we don't need to split anything
 
 	*_device = device;
 	return B_OK;
@@ -329,6 +329,9 @@ enum {
 static const int kTimestampFactor = 1000;
 	// conversion factor between usec system time and msec tcp time
 
+static const uint32 kMaxSegmentOffloadSize = 65535 - 60 - 60;
+	// the maximum IPv4 packet size minus the maximum IP and TCP header sizes
+
 
 static inline bigtime_t
 absolute_timeout(bigtime_t timeout)
@@ -2127,6 +2130,11 @@ TCPEndpoint::_PrepareAndSend(tcp_segment_header& segment, net_buffer* buffer,
 	PeerAddress().CopyTo(buffer->destination);
 
 	uint32 size = buffer->size, segmentLength = size;
+	uint32 segmentCount = 1;
+	if (buffer->segment_size != 0) {
+		segmentCount = (segmentLength + buffer->segment_size - 1)
+			/ buffer->segment_size;
+	}
 	segment.sequence = fSendNext.Number();
 
 	TRACE("_PrepareAndSend(): buffer %p (%" B_PRIu32 " bytes) address %s to "
@@ -2172,7 +2180,7 @@ TCPEndpoint::_PrepareAndSend(tcp_segment_header& segment, net_buffer* buffer,
 	fReceiveMaxAdvertised = fReceiveNext + segment.AdvertisedWindow(fReceiveWindowShift);
 
 	if (segmentLength != 0 && fState == ESTABLISHED)
-		--fSendMaxSegments;
+		fSendMaxSegments -= min_c(segmentCount, fSendMaxSegments);
 
 	if (fSendTime == 0 && !isRetransmit
 			&& (segmentLength != 0 || (segment.flags & TCP_FLAG_SYNCHRONIZE) != 0)) {
@@ -2311,10 +2319,25 @@ TCPEndpoint::_SendQueued(bool force)
 		length = min_c(length, fSendMaxSegmentSize);
 	}
 
+	// IPv4 buffers may contain several segments that are only split by the
+	// datalink layer, or the device (segmentation offload)
+	bool segmentOffload = !retransmit && Domain()->family == AF_INET
+		&& (segment.flags & TCP_FLAG_URGENT) == 0;
+
 	do {
 		uint32 segmentMaxSize = fSendMaxSegmentSize
 			- tcp_options_length(segment);
 		uint32 segmentLength = min_c(length, segmentMaxSize);
+		uint32 segmentCount = 1;
+
+		if (segmentOffload && length >= 2 * segmentMaxSize) {
+			segmentCount = min_c(length, kMaxSegmentOffloadSize)
+				/ segmentMaxSize;
+			if (fState == ESTABLISHED)
+				segmentCount = min_c(segmentCount, fSendMaxSegments);
+			if (segmentCount > 1)
+				segmentLength = segmentCount * segmentMaxSize;
+		}
 
 		if ((fSendNext + segmentLength) == fSendQueue.LastSequence() && !force) {
 			if (state_needs_finish(fState))
@@ -2324,8 +2347,9 @@ TCPEndpoint::_SendQueued(bool force)
 		}
 
 		// Determine if we should really send this segment
-		if (!force && !retransmit && !_ShouldSendSegment(segment, segmentLength,
-				segmentMaxSize, flightSize)) {
+		if (!force && !retransmit && !_ShouldSendSegment(segment,
+				min_c(segmentLength, segmentMaxSize), segmentMaxSize,
+				flightSize)) {
 			if (fSendQueue.Available()
 				&& !gStackModule->is_timer_active(&fPersistTimer)
 				&& !gStackModule->is_timer_active(&fRetransmitTimer))
@@ -2345,6 +2369,9 @@ TCPEndpoint::_SendQueued(bool force)
 			return status;
 		}
 
+		if (segmentCount > 1)
+			buffer->segment_size = segmentMaxSize;
+
 		sendWindow -= buffer->size;
 
 		status = _PrepareAndSend(segment, buffer, retransmit);
@@ -27,6 +27,7 @@
 #include "device_interfaces.h"
 #include "domains.h"
 #include "interfaces.h"
+#include "offload.h"
 #include "routes.h"
 #include "stack_private.h"
 #include "utility.h"
@@ -356,6 +357,41 @@ datalink_control(net_domain* _domain, int32 option, void* value,
 }
 
 
+/*!	Splits the \a buffer into segments that fit the MTU, and sends them one
+	by one. The caller only keeps ownership of the \a buffer in case of an
+	error.
+*/
+static status_t
+send_segments(domain_datalink* datalink, net_buffer* buffer)
+{
+	struct list segments;
+	status_t status = segment_buffer(buffer, &segments);
+	if (status != B_OK)
+		return status;
+
+	net_buffer* segment;
+	bool sent = false;
+	while ((segment = (net_buffer*)list_remove_head_item(&segments)) != NULL) {
+		if (status == B_OK) {
+			status = datalink->first_info->send_data(datalink->first_protocol,
+				segment);
+		}
+		if (status != B_OK) {
+			// If we could not send all of it, the remaining segments are lost
+			// just like on the wire.
+			gNetBufferModule.free(segment);
+		} else
+			sent = true;
+	}
+
+	if (!sent)
+		return status;
+
+	gNetBufferModule.free(buffer);
+	return B_OK;
+}
+
+
 static status_t
 datalink_send_routed_data(struct net_route* route, net_buffer* buffer)
 {
@@ -393,8 +429,8 @@ datalink_send_routed_data(struct net_route* route, net_buffer* buffer)
 
 		// this one goes back to the domain directly
 		const size_t packetSize = buffer->size;
-		status_t status = fifo_enqueue_buffer(
-			&interface->DeviceInterface()->receive_queue, buffer);
+		status_t status = device_interface_enqueue_buffer(
+			interface->DeviceInterface(), buffer);
 		update_device_send_stats(interface->DeviceInterface()->device,
 			status, packetSize);
 		return status;
@@ -413,6 +449,14 @@ datalink_send_routed_data(struct net_route* route, net_buffer* buffer)
 	// this goes out to the datalink protocols
 	domain_datalink* datalink
 		= interface->DomainDatalink(address->domain->family);
+
+	if (buffer->segment_size != 0
+		&& (interface->device->offload
+			& NET_DEVICE_OFFLOAD_TCP_SEGMENTATION) == 0) {
+		// the device can't split the buffer itself
+		return send_segments(datalink, buffer);
+	}
+
 	return datalink->first_info->send_data(datalink->first_protocol, buffer);
 }
 
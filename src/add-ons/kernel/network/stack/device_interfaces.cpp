@@ -10,18 +10,22 @@
 #include "device_interfaces.h"
 #include "domains.h"
 #include "interfaces.h"
+#include "offload.h"
 #include "stack_private.h"
 #include "utility.h"
 
 #include <net_device.h>
 
 #include <lock.h>
+#include <smp.h>
+#include <thread.h>
 #include <util/AutoLock.h>
 
 #include <KernelExport.h>
 
 #include <net/if_dl.h>
 #include <netinet/in.h>
+#include <netinet/ip.h>
 #include <new>
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,13 +40,145 @@
 #endif
 
 
+static const uint32 kFlowTableSize = 4096;
+
+struct flow_entry {
+	int16	desired_cpu;
+		// the CPU the socket of this flow has last been read from
+	int16	current_cpu;
+		// the CPU whose receive queue the flow is currently steered to
+	uint32	last_queued;
+		// the "queued" count of that receive queue after the last packet of
+		// the flow has been put into it
+};
+
 static mutex sLock;
 static DeviceInterfaceList sInterfaces;
 static uint32 sDeviceIndex;
+static flow_entry sFlowTable[kFlowTableSize];
+
+
+static inline uint32
+mix_flow_hash(uint32 hash, uint32 value)
+{
+	hash = (hash ^ value) * 0x9e3779b1;
+	return hash ^ (hash >> 15);
+}
+
+
+/*!	Computes the hash of a flow from its addresses, and ports. \a source is
+	always the address of the remote end, both addresses consist of \a words
+	32 bit words, and are in network byte order, as are the \a ports.
+*/
+static uint32
+flow_hash(const uint32* source, const uint32* destination, int32 words,
+	uint32 ports)
+{
+	uint32 hash = 0;
+	for (int32 i = 0; i < words; i++) {
+		hash = mix_flow_hash(hash, source[i]);
+		hash = mix_flow_hash(hash, destination[i]);
+	}
+
+	return mix_flow_hash(hash, ports);
+}
+
+
+/*!	Computes the flow hash of a received IPv4 or IPv6 packet. The ports are
+	only included for TCP and UDP packets that aren't fragmented.
+	Returns \c false if the packet is neither IPv4 nor IPv6.
+*/
+static bool
+packet_flow_hash(net_buffer* buffer, uint32& _hash)
+{
+	int family;
+	if (buffer->interface_address != NULL)
+		family = buffer->interface_address->domain->family;
+	else if (buffer->type == B_NET_FRAME_TYPE_IPV4)
+		family = AF_INET;
+	else if (buffer->type == B_NET_FRAME_TYPE_IPV6)
+		family = AF_INET6;
+	else
+		return false;
+
+	uint8 header[40];
+	uint32 ports = 0;
+	uint32 addresses[8];
+	int32 words;
+	uint8 protocol;
+	size_t headerLength;
+
+	if (family == AF_INET) {
+		if (gNetBufferModule.read(buffer, 0, header, 20) != B_OK)
+			return false;
+
+		uint16 fragmentOffset = (header[6] << 8) | header[7];
+		headerLength = (header[0] & 0xf) * 4;
+		protocol = (fragmentOffset & (IP_MF | IP_OFFMASK)) == 0
+			? header[9] : 0;
+		memcpy(addresses, header + 12, 8);
+		words = 1;
+	} else if (family == AF_INET6) {
+		if (gNetBufferModule.read(buffer, 0, header, 40) != B_OK)
+			return false;
+
+		headerLength = 40;
+		protocol = header[6];
+		memcpy(addresses, header + 8, 32);
+		words = 4;
+	} else
+		return false;
+
+	if (protocol == IPPROTO_TCP || protocol == IPPROTO_UDP)
+		gNetBufferModule.read(buffer, headerLength, &ports, sizeof(ports));
+
+	_hash = flow_hash(addresses, addresses + words, words, ports);
+	return true;
+}
+
+
+/*!	Chooses the receive queue for the given \a buffer: all packets of a flow
+	go to the same queue, preferably to that of the CPU its socket is read
+	from. If the buffer belongs to a flow, its entry is returned in \a _entry.
+*/
+static net_receive_queue*
+steer_buffer(net_device_interface* interface, net_buffer* buffer,
+	flow_entry*& _entry)
+{
+	_entry = NULL;
+
+	int32 count = interface->receive_queue_count;
+	uint32 hash;
+	if (count == 1 || !packet_flow_hash(buffer, hash))
+		return &interface->receive_queues[0];
+
+	flow_entry& entry = sFlowTable[hash % kFlowTableSize];
+	int32 cpu = entry.current_cpu;
+	int32 desiredCPU = entry.desired_cpu;
+	_entry = &entry;
+
+	if (desiredCPU >= 0 && desiredCPU < count && desiredCPU != cpu) {
+		// Only move the flow over once the consumer of the queue it used is
+		// done with the last packet of the flow, so that its packets cannot
+		// overtake each other.
+		if (cpu < 0 || cpu >= count
+			|| (int32)((uint32)atomic_get(
+					(int32*)&interface->receive_queues[cpu].processed)
+				- entry.last_queued) >= 0) {
+			entry.current_cpu = desiredCPU;
+			cpu = desiredCPU;
+		}
+	}
+
+	if (cpu < 0 || cpu >= count)
+		cpu = hash % count;
+
+	return &interface->receive_queues[cpu];
+}
 
 
 /*!	A service thread for each device interface. It just reads as many packets
-	as available, deframes them, and puts them into the receive queue of the
+	as available, deframes them, and puts them into the receive queues of the
 	device interface.
 */
 static status_t
@@ -69,7 +205,7 @@ device_reader_thread(void* _interface)
 			}
 
 			const size_t packetSize = buffer->size;
-			status = fifo_enqueue_buffer(&interface->receive_queue, buffer);
+			status = device_interface_enqueue_buffer(interface, buffer);
 			if (status == B_OK) {
 				atomic_add((int32*)&device->stats.receive.packets, 1);
 				atomic_add64((int64*)&device->stats.receive.bytes, packetSize);
@@ -94,19 +230,44 @@ device_reader_thread(void* _interface)
 
 
 static status_t
-device_consumer_thread(void* _interface)
+device_consumer_thread(void* _queue)
 {
-	net_device_interface* interface = (net_device_interface*)_interface;
+	net_receive_queue* queue = (net_receive_queue*)_queue;
+	net_device_interface* interface = queue->interface;
 	net_device* device = interface->device;
 	net_buffer* buffer;
+	net_buffer* next = NULL;
+
+	if (interface->receive_queue_count > 1) {
+		// stay on the CPU this queue belongs to
+		CPUSet mask;
+		mask.SetBit(queue->cpu);
+		thread_set_cpu_affinity(mask);
+	}
 
 	while (atomic_get(&interface->ref_count) > 0) {
-		ssize_t status = fifo_dequeue_buffer(&interface->receive_queue, 0,
-			B_INFINITE_TIMEOUT, &buffer);
-		if (status != B_OK) {
-			if (status == B_INTERRUPTED)
-				continue;
-			break;
+		uint32 count = 1;
+		if (next != NULL) {
+			buffer = next;
+			next = NULL;
+		} else {
+			ssize_t status = fifo_dequeue_buffer(&queue->fifo, 0,
+				B_INFINITE_TIMEOUT, &buffer);
+			if (status != B_OK) {
+				if (status == B_INTERRUPTED)
+					continue;
+				break;
+			}
+		}
+
+		// Merge the TCP segments following this one that are already waiting
+		// in the queue, so that the protocols only have to handle them once
+		while (fifo_dequeue_buffer(&queue->fifo, MSG_DONTWAIT, 0, &next)
+				== B_OK) {
+			if (!coalesce_buffers(buffer, next))
+				break;
+			next = NULL;
+			count++;
 		}
 
 		if (buffer->interface_address != NULL) {
@@ -143,8 +304,13 @@ device_consumer_thread(void* _interface)
 
 		if (buffer != NULL)
 			gNetBufferModule.free(buffer);
+
+		atomic_add((int32*)&queue->processed, count);
 	}
 
+	if (next != NULL)
+		gNetBufferModule.free(next);
+
 	return B_OK;
 }
 
@@ -176,6 +342,70 @@ find_device_interface(const char* name)
 }
 
 
+/*!	Stops the consumer threads, and frees the first \a count receive queues
+	of the \a interface.
+*/
+static void
+uninit_receive_queues(net_device_interface* interface, int32 count)
+{
+	for (int32 i = 0; i < count; i++) {
+		net_receive_queue& queue = interface->receive_queues[i];
+		uninit_fifo(&queue.fifo);
+		if (queue.consumer_thread >= 0)
+			wait_for_thread(queue.consumer_thread, NULL);
+	}
+
+	delete[] interface->receive_queues;
+}
+
+
+static status_t
+init_receive_queues(net_device_interface* interface)
+{
+	int32 count = smp_get_num_cpus();
+	interface->receive_queues = new(std::nothrow) net_receive_queue[count];
+	if (interface->receive_queues == NULL)
+		return B_NO_MEMORY;
+
+	interface->receive_queue_count = count;
+
+	// the queues share the space a single queue would have
+	size_t maxBytes = max_c(16 * 1024 * 1024 / count, 2 * 1024 * 1024);
+
+	for (int32 i = 0; i < count; i++) {
+		net_receive_queue& queue = interface->receive_queues[i];
+		queue.interface = interface;
+		queue.cpu = i;
+		queue.queued = 0;
+		queue.processed = 0;
+
+		char name[128];
+		snprintf(name, sizeof(name), "%s receive queue %" B_PRId32,
+			interface->device->name, i);
+
+		status_t status = init_fifo(&queue.fifo, name, maxBytes);
+		if (status != B_OK) {
+			uninit_receive_queues(interface, i);
+			return status;
+		}
+
+		snprintf(name, sizeof(name), "%s consumer %" B_PRId32,
+			interface->device->name, i);
+
+		queue.consumer_thread = spawn_kernel_thread(device_consumer_thread,
+			name, B_DISPLAY_PRIORITY, &queue);
+		if (queue.consumer_thread < 0) {
+			status = queue.consumer_thread;
+			uninit_receive_queues(interface, i + 1);
+			return status;
+		}
+		resume_thread(queue.consumer_thread);
+	}
+
+	return B_OK;
+}
+
+
 static net_device_interface*
 allocate_device_interface(net_device* device, net_device_module_info* module)
 {
@@ -186,12 +416,6 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	recursive_lock_init(&interface->receive_lock, "device interface receive");
 	recursive_lock_init(&interface->monitor_lock, "device interface monitors");
 
-	char name[128];
-	snprintf(name, sizeof(name), "%s receive queue", device->name);
-
-	if (init_fifo(&interface->receive_queue, name, 16 * 1024 * 1024) < B_OK)
-		goto error1;
-
 	interface->device = device;
 	interface->up_count = 0;
 	interface->ref_count = 1;
@@ -199,15 +423,14 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	interface->monitor_count = 0;
 	interface->deframe_func = NULL;
 	interface->deframe_ref_count = 0;
+	interface->reader_thread = -1;
 
-	snprintf(name, sizeof(name), "%s consumer", device->name);
-
-	interface->reader_thread   = -1;
-	interface->consumer_thread = spawn_kernel_thread(device_consumer_thread,
-		name, B_DISPLAY_PRIORITY, interface);
-	if (interface->consumer_thread < B_OK)
-		goto error2;
-	resume_thread(interface->consumer_thread);
+	if (init_receive_queues(interface) != B_OK) {
+		recursive_lock_destroy(&interface->receive_lock);
+		recursive_lock_destroy(&interface->monitor_lock);
+		delete interface;
+		return NULL;
+	}
 
 	// TODO: proper interface index allocation
 	device->index = ++sDeviceIndex;
@@ -215,15 +438,6 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 
 	sInterfaces.Add(interface);
 	return interface;
-
-error2:
-	uninit_fifo(&interface->receive_queue);
-error1:
-	recursive_lock_destroy(&interface->receive_lock);
-	recursive_lock_destroy(&interface->monitor_lock);
-	delete interface;
-
-	return NULL;
 }
 
 
@@ -261,7 +475,13 @@ dump_device_interface(int argc, char** argv)
 	kprintf("ref_count:         %" B_PRId32 "\n", interface->ref_count);
 	kprintf("deframe_func:      %p\n", interface->deframe_func);
 	kprintf("deframe_ref_count: %" B_PRId32 "\n", interface->ref_count);
-	kprintf("consumer_thread:   %" B_PRId32 "\n", interface->consumer_thread);
+	kprintf("receive_queues:    %" B_PRId32 "\n",
+		interface->receive_queue_count);
+	for (int32 i = 0; i < interface->receive_queue_count; i++) {
+		net_receive_queue& queue = interface->receive_queues[i];
+		kprintf("  %p  cpu %" B_PRId32 ", consumer thread %" B_PRId32 "\n",
+			&queue.fifo, queue.cpu, queue.consumer_thread);
+	}
 
 	kprintf("monitor_count:     %" B_PRId32 "\n", interface->monitor_count);
 	kprintf("monitor_lock:      %p\n", &interface->monitor_lock);
@@ -272,7 +492,6 @@ dump_device_interface(int argc, char** argv)
 		kprintf("  %p\n", monitorIterator.Next());
 
 	kprintf("receive_lock:      %p\n", &interface->receive_lock);
-	kprintf("receive_queue:     %p\n", &interface->receive_queue);
 	kprintf("receive_funcs:\n");
 	DeviceHandlerList::Iterator handlerIterator
 		= interface->receive_funcs.GetIterator();
@@ -400,8 +619,7 @@ put_device_interface(struct net_device_interface* interface)
 	sInterfaces.Remove(interface);
 	locker.Unlock();
 
-	uninit_fifo(&interface->receive_queue);
-	wait_for_thread(interface->consumer_thread, NULL);
+	uninit_receive_queues(interface, interface->receive_queue_count);
 
 	net_device* device = interface->device;
 	const char* moduleName = device->module->info.name;
@@ -838,13 +1056,72 @@ device_enqueue_buffer(net_device* device, net_buffer* buffer)
 		return status;
 	}
 
-	status = fifo_enqueue_buffer(&interface->receive_queue, buffer);
+	status = device_interface_enqueue_buffer(interface, buffer);
 
 	put_device_interface(interface);
 	return status;
 }
 
 
+/*!	Puts the \a buffer into the receive queue of the \a interface that is
+	responsible for its flow.
+*/
+status_t
+device_interface_enqueue_buffer(net_device_interface* interface,
+	net_buffer* buffer)
+{
+	flow_entry* entry;
+	net_receive_queue* queue = steer_buffer(interface, buffer, entry);
+
+	// Count the buffer before it can be dequeued, so that the count read
+	// back afterwards is never lower than its position in the queue
+	atomic_add((int32*)&queue->queued, 1);
+
+	status_t status = fifo_enqueue_buffer(&queue->fifo, buffer);
+	if (status != B_OK) {
+		atomic_add((int32*)&queue->queued, -1);
+		return status;
+	}
+
+	if (entry != NULL)
+		entry->last_queued = (uint32)atomic_get((int32*)&queue->queued);
+
+	return B_OK;
+}
+
+
+/*!	Remembers the CPU the current thread is running on for the flow of the
+	given connected \a socket, so that its incoming packets will be processed
+	on that CPU as well.
+*/
+void
+steer_socket_flow(net_socket* socket)
+{
+	uint32 hash;
+	if (socket->family == AF_INET && socket->peer.ss_len != 0) {
+		sockaddr_in& peer = *(sockaddr_in*)&socket->peer;
+		sockaddr_in& local = *(sockaddr_in*)&socket->address;
+		uint16 ports[2] = { peer.sin_port, local.sin_port };
+
+		hash = flow_hash(&peer.sin_addr.s_addr, &local.sin_addr.s_addr, 1,
+			*(uint32*)ports);
+	} else if (socket->family == AF_INET6 && socket->peer.ss_len != 0) {
+		sockaddr_in6& peer = *(sockaddr_in6*)&socket->peer;
+		sockaddr_in6& local = *(sockaddr_in6*)&socket->address;
+		uint16 ports[2] = { peer.sin6_port, local.sin6_port };
+
+		hash = flow_hash((uint32*)&peer.sin6_addr, (uint32*)&local.sin6_addr,
+			4, *(uint32*)ports);
+	} else
+		return;
+
+	flow_entry& entry = sFlowTable[hash % kFlowTableSize];
+	int16 cpu = smp_get_current_cpu();
+	if (entry.desired_cpu != cpu)
+		entry.desired_cpu = cpu;
+}
+
+
 //	#pragma mark -
 
 
@@ -856,6 +1133,12 @@ init_device_interfaces()
 	new (&sInterfaces) DeviceInterfaceList;
 		// static C++ objects are not initialized in the module startup
 
+	for (uint32 i = 0; i < kFlowTableSize; i++) {
+		sFlowTable[i].desired_cpu = -1;
+		sFlowTable[i].current_cpu = -1;
+		sFlowTable[i].last_queued = 0;
+	}
+
 #if ENABLE_DEBUGGER_COMMANDS
 	add_debugger_command("net_device_interface", &dump_device_interface,
 		"Dump the given network device interface");
@@ -26,6 +26,19 @@ typedef DoublyLinkedList<net_device_handler> DeviceHandlerList;
 typedef DoublyLinkedList<net_device_monitor,
 	DoublyLinkedListCLink<net_device_monitor> > DeviceMonitorList;
 
+struct net_device_interface;
+
+struct net_receive_queue {
+	net_device_interface* interface;
+	int32				cpu;
+	thread_id			consumer_thread;
+	net_fifo			fifo;
+	uint32				queued;
+		// number of buffers that have been put into the queue
+	uint32				processed;
+		// number of buffers the consumer thread is done with
+};
+
 struct net_device_interface : DoublyLinkedListLinkImpl<net_device_interface> {
 	struct net_device*	device;
 	thread_id			reader_thread;
@@ -44,8 +57,9 @@ struct net_device_interface : DoublyLinkedListLinkImpl<net_device_interface> {
 	DeviceHandlerList	receive_funcs;
 	recursive_lock		receive_lock;
 
-	thread_id			consumer_thread;
-	net_fifo			receive_queue;
+	net_receive_queue*	receive_queues;
+	int32				receive_queue_count;
+		// there is a receive queue with its own consumer thread for each CPU
 };
 
 typedef DoublyLinkedList<net_device_interface> DeviceInterfaceList;
@@ -63,6 +77,9 @@ struct net_device_interface* get_device_interface(const char* name,
 	bool create = true);
 void device_interface_monitor_receive(net_device_interface* interface,
 	net_buffer* buffer);
+status_t device_interface_enqueue_buffer(net_device_interface* interface,
+	net_buffer* buffer);
+void steer_socket_flow(net_socket* socket);
 status_t up_device_interface(net_device_interface* interface);
 void down_device_interface(net_device_interface* interface);
 
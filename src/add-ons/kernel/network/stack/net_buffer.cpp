@@ -42,6 +42,8 @@
 
 #define BUFFER_SIZE 2048
 	// maximum implementation derived buffer size is 65536
+#define MAX_EXTERNAL_NODE_SIZE 32768
+	// data_node::used is only 16 bit wide
 
 #define ENABLE_DEBUGGER_COMMANDS	1
 #define ENABLE_STATS				1
@@ -70,6 +72,9 @@ struct data_header {
 	uint8*			data_end;
 	header_space	space;
 	uint16			tail_space;
+	net_buffer_free_func free_function;
+		// only set for headers of external data
+	void*			free_cookie;
 };
 
 struct data_node {
@@ -161,6 +166,9 @@ static status_t remove_header(net_buffer* _buffer, size_t bytes);
 static status_t remove_trailer(net_buffer* _buffer, size_t bytes);
 static status_t append_cloned_data(net_buffer* _buffer, net_buffer* _source,
 					uint32 offset, size_t bytes);
+static status_t append_external_data(net_buffer* _buffer, const iovec* vecs,
+					uint32 vecCount, net_buffer_free_func freeFunction,
+					void* cookie);
 static status_t read_data(net_buffer* _buffer, size_t offset, void* data,
 					size_t size);
 
@@ -814,6 +822,8 @@ create_data_header(size_t headerSpace)
 	header->tail_space = (uint8*)header + BUFFER_SIZE - header->data_end
 		- headerSpace;
 	header->first_free = NULL;
+	header->free_function = NULL;
+	header->free_cookie = NULL;
 
 	TRACE(("%d:   create new data header %p\n", find_thread(NULL), header));
 	T2(CreateDataHeader(header));
@@ -830,6 +840,10 @@ release_data_header(data_header* header)
 		return;
 
 	TRACE(("%d:   free header %p\n", find_thread(NULL), header));
+
+	if (header->free_function != NULL)
+		header->free_function(header->free_cookie);
+
 	free_data_header(header);
 }
 
@@ -1076,6 +1090,7 @@ copy_metadata(net_buffer* destination, const net_buffer* source)
 
 	destination->msg_flags = source->msg_flags;
 	destination->buffer_flags = source->buffer_flags;
+	destination->segment_size = source->segment_size;
 	destination->interface_address = source->interface_address;
 	if (destination->interface_address != NULL)
 		((InterfaceAddress*)destination->interface_address)->AcquireReference();
@@ -1130,6 +1145,7 @@ create_buffer(size_t headerSpace)
 	buffer->offset = 0;
 	buffer->msg_flags = 0;
 	buffer->buffer_flags = 0;
+	buffer->segment_size = 0;
 	buffer->size = 0;
 
 	CHECK_BUFFER(buffer);
@@ -2011,6 +2027,77 @@ append_cloned_data(net_buffer* _buffer, net_buffer* _source, uint32 offset,
 }
 
 
+/*!	Appends the memory described by \a vecs to \a buffer without copying it.
+	The data is only referenced read-only, and must stay valid until
+	\a freeFunction is called with \a cookie, which happens as soon as the
+	last buffer referring to any part of it is freed.
+	If this function fails, \a freeFunction is not called, and the memory
+	remains the caller's.
+*/
+static status_t
+append_external_data(net_buffer* _buffer, const iovec* vecs, uint32 vecCount,
+	net_buffer_free_func freeFunction, void* cookie)
+{
+	net_buffer_private* buffer = (net_buffer_private*)_buffer;
+	TRACE(("%d: append_external_data(buffer %p, vecs %p, count %" B_PRIu32
+		")\n", find_thread(NULL), buffer, vecs, vecCount));
+
+	ParanoiaChecker _(buffer);
+
+	// The header does not contain any data, it only keeps track of the
+	// references to the external memory.
+	data_header* header = create_data_header(0);
+	if (header == NULL)
+		return ENOBUFS;
+
+	header->tail_space = 0;
+	header->free_function = freeFunction;
+	header->free_cookie = cookie;
+
+	size_t sizeAppended = 0;
+	status_t status = B_OK;
+
+	for (uint32 i = 0; i < vecCount && status == B_OK; i++) {
+		uint8* data = (uint8*)vecs[i].iov_base;
+		size_t bytes = vecs[i].iov_len;
+
+		while (bytes > 0) {
+			data_node* node = add_data_node(buffer, header);
+			if (node == NULL) {
+				status = ENOBUFS;
+				break;
+			}
+
+			node->offset = buffer->size;
+			node->start = data;
+			node->used = min_c(bytes, MAX_EXTERNAL_NODE_SIZE);
+			node->flags = DATA_NODE_READ_ONLY;
+
+			list_add_item(&buffer->buffers, node);
+
+			data += node->used;
+			bytes -= node->used;
+			buffer->size += node->used;
+			sizeAppended += node->used;
+		}
+	}
+
+	if (status != B_OK) {
+		remove_trailer(buffer, sizeAppended);
+		header->free_function = NULL;
+	}
+
+	// drop our initial reference; the nodes keep the header alive
+	release_data_header(header);
+
+	CHECK_BUFFER(buffer);
+	SET_PARANOIA_CHECK(PARANOIA_SUSPICIOUS, buffer, &buffer->size,
+		sizeof(buffer->size));
+
+	return status;
+}
+
+
 void
 set_ancillary_data(net_buffer* buffer, ancillary_data_container* container)
 {
@@ -2405,5 +2492,7 @@ net_buffer_module_info gNetBufferModule = {
 	swap_addresses,
 
 	dump_buffer,	// dump
+
+	append_external_data,
 };
 
@@ -34,6 +34,7 @@
 #include <net_stat.h>
 
 #include "ancillary_data.h"
+#include "device_interfaces.h"
 #include "utility.h"
 
 
@@ -1159,6 +1160,9 @@ socket_receive(net_socket* socket, msghdr* header, void* data, size_t length,
 	if (status != B_OK)
 		return status;
 
+	// have incoming packets of this flow be processed on our CPU
+	steer_socket_flow(socket);
+
 	// process ancillary data
 	if (header != NULL) {
 		if (buffer != NULL && header->msg_control != NULL) {
@@ -1417,6 +1421,72 @@ socket_send(net_socket* socket, msghdr* header, const void* data, size_t length,
 }
 
 
+/*!	Sends the memory described by \a vecs over the connected stream
+	\a socket without copying it; see net_buffer::append_external().
+	The socket always takes over the memory: \a freeFunction is called with
+	\a cookie once the stack is done with it, even if this function fails.
+	Returns \c B_NOT_SUPPORTED if the protocol of the socket cannot be fed
+	with external data, in which case the caller should copy the data instead.
+*/
+ssize_t
+socket_send_external(net_socket* socket, const iovec* vecs, uint32 vecCount,
+	net_buffer_free_func freeFunction, void* cookie, int flags)
+{
+	const bool nosignal = ((flags & MSG_NOSIGNAL) != 0);
+	flags &= ~MSG_NOSIGNAL;
+
+	if (socket->type != SOCK_STREAM
+		|| socket->first_info->send_data_no_buffer != NULL
+		|| (socket->first_info->flags & NET_PROTOCOL_ATOMIC_MESSAGES) != 0) {
+		freeFunction(cookie);
+		return B_NOT_SUPPORTED;
+	}
+
+	if (socket->peer.ss_len == 0) {
+		freeFunction(cookie);
+		return ENOTCONN;
+	}
+
+	net_buffer* buffer = gNetBufferModule.create(256);
+	if (buffer == NULL) {
+		freeFunction(cookie);
+		return ENOBUFS;
+	}
+
+	status_t status = gNetBufferModule.append_external(buffer, vecs, vecCount,
+		freeFunction, cookie);
+	if (status != B_OK) {
+		gNetBufferModule.free(buffer);
+		freeFunction(cookie);
+		return status;
+	}
+
+	size_t bufferSize = buffer->size;
+	buffer->msg_flags = flags;
+	memcpy(buffer->source, &socket->address, socket->address.ss_len);
+	memcpy(buffer->destination, &socket->peer, socket->peer.ss_len);
+
+	status = socket->first_info->send_data(socket->first_protocol, buffer);
+	if (status != B_OK) {
+		// we only send signals when called from userland
+		if (status == EPIPE && is_syscall() && !nosignal)
+			send_signal(find_thread(NULL), SIGPIPE);
+
+		size_t sizeAfterSend = buffer->size;
+		gNetBufferModule.free(buffer);
+
+		if (sizeAfterSend != bufferSize
+			&& (status == B_INTERRUPTED || status == B_WOULD_BLOCK)) {
+			// this appears to be a partial write
+			return bufferSize - sizeAfterSend;
+		}
+		return status;
+	}
+
+	return bufferSize;
+}
+
+
 status_t
 socket_set_option(net_socket* socket, int level, int option, const void* value,
 	int length)
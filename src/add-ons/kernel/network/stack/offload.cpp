@@ -0,0 +1,346 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Generic segmentation and receive coalescing for TCP over IPv4.
+
+	TCP may pass down a single buffer that covers several segments (see
+	net_buffer::segment_size). It is only split into packets that fit the MTU
+	right before it is handed to a device that cannot do this itself.
+	On the receiving side, in-order segments of the same connection that are
+	already waiting in the receive queue of a device are merged before they
+	are passed on to the protocols, so that they only have to be processed
+	once.
+*/
+
+
+#include "offload.h"
+
+#include "interfaces.h"
+#include "stack_private.h"
+#include "utility.h"
+
+#include <net_datalink.h>
+#include <net_stack.h>
+#include <NetUtilities.h>
+
+#include <ByteOrder.h>
+
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <string.h>
+
+
+#define TCP_FLAG_FINISH			0x01
+#define TCP_FLAG_PUSH			0x08
+#define TCP_FLAG_ACKNOWLEDGE	0x10
+
+
+struct ipv4_header {
+#if B_HOST_IS_LENDIAN == 1
+	uint8		header_length : 4;	// header length in 32-bit words
+	uint8		version : 4;
+#else
+	uint8		version : 4;
+	uint8		header_length : 4;
+#endif
+	uint8		service_type;
+	uint16		total_length;
+	uint16		id;
+	uint16		fragment_offset;
+	uint8		time_to_live;
+	uint8		protocol;
+	uint16		checksum;
+	in_addr_t	source;
+	in_addr_t	destination;
+} _PACKED;
+
+struct tcp_header {
+	uint16		source_port;
+	uint16		destination_port;
+	uint32		sequence;
+	uint32		acknowledge;
+#if B_HOST_IS_LENDIAN == 1
+	uint8		reserved : 4;
+	uint8		header_length : 4;	// header length in 32-bit words
+#else
+	uint8		header_length : 4;
+	uint8		reserved : 4;
+#endif
+	uint8		flags;
+	uint16		advertised_window;
+	uint16		checksum;
+	uint16		urgent_offset;
+} _PACKED;
+
+static const size_t kMaxHeaderLength = 60 + 60;
+	// the maximum size of an IPv4 header followed by a TCP header
+
+
+/*!	Reads the IPv4 and TCP headers at the start of \a buffer into \a header.
+*/
+static status_t
+read_headers(net_buffer* buffer, uint8* header, size_t& _ipLength,
+	size_t& _tcpLength)
+{
+	if (buffer->size < sizeof(ipv4_header) + sizeof(tcp_header)
+		|| gNetBufferModule.read(buffer, 0, header, sizeof(ipv4_header))
+			!= B_OK)
+		return B_BAD_DATA;
+
+	ipv4_header& ipHeader = *(ipv4_header*)header;
+	size_t ipLength = ipHeader.header_length * 4;
+	if (ipHeader.version != IPVERSION || ipHeader.protocol != IPPROTO_TCP
+		|| ipLength < sizeof(ipv4_header)
+		|| buffer->size < ipLength + sizeof(tcp_header)
+		|| gNetBufferModule.read(buffer, sizeof(ipv4_header),
+			header + sizeof(ipv4_header),
+			ipLength - sizeof(ipv4_header) + sizeof(tcp_header)) != B_OK)
+		return B_BAD_DATA;
+
+	tcp_header& tcpHeader = *(tcp_header*)(header + ipLength);
+	size_t tcpLength = tcpHeader.header_length * 4;
+	if (tcpLength < sizeof(tcp_header)
+		|| buffer->size < ipLength + tcpLength
+		|| gNetBufferModule.read(buffer, ipLength + sizeof(tcp_header),
+			header + ipLength + sizeof(tcp_header),
+			tcpLength - sizeof(tcp_header)) != B_OK)
+		return B_BAD_DATA;
+
+	_ipLength = ipLength;
+	_tcpLength = tcpLength;
+	return B_OK;
+}
+
+
+/*!	Returns the TCP checksum for a segment of \a length bytes (header
+	included), whose contents sum up to \a sum.
+*/
+static uint16
+tcp_checksum(const ipv4_header& ipHeader, uint32 sum, size_t length)
+{
+	Checksum checksum;
+	checksum << (uint32)ipHeader.source << (uint32)ipHeader.destination
+		<< (uint16)htons(IPPROTO_TCP) << (uint16)htons(length) << sum;
+	return checksum;
+}
+
+
+static void
+copy_segment_metadata(net_buffer* segment, const net_buffer* buffer)
+{
+	memcpy(segment->source, buffer->source,
+		min_c(buffer->source->sa_len, sizeof(sockaddr_storage)));
+	memcpy(segment->destination, buffer->destination,
+		min_c(buffer->destination->sa_len, sizeof(sockaddr_storage)));
+
+	segment->msg_flags = buffer->msg_flags;
+	segment->buffer_flags = buffer->buffer_flags;
+	segment->interface_address = buffer->interface_address;
+	if (segment->interface_address != NULL)
+		((InterfaceAddress*)segment->interface_address)->AcquireReference();
+
+	segment->offset = buffer->offset;
+	segment->protocol = buffer->protocol;
+}
+
+
+/*!	Parses the headers of a received \a buffer, and checks if it is a TCP
+	segment that may be merged with another one. Its checksums are verified
+	in this case, as we must never merge corrupted data.
+*/
+static bool
+parse_received_segment(net_buffer* buffer, uint8* header, size_t& _ipLength,
+	size_t& _tcpLength)
+{
+	if (buffer->interface_address != NULL) {
+		// the buffer was delivered locally
+		if (buffer->interface_address->domain->family != AF_INET)
+			return false;
+	} else if (buffer->type != B_NET_FRAME_TYPE_IPV4)
+		return false;
+
+	size_t ipLength;
+	size_t tcpLength;
+	if (read_headers(buffer, header, ipLength, tcpLength) != B_OK)
+		return false;
+
+	ipv4_header& ipHeader = *(ipv4_header*)header;
+	tcp_header& tcpHeader = *(tcp_header*)(header + ipLength);
+
+	if (ipLength != sizeof(ipv4_header)
+		|| (ntohs(ipHeader.fragment_offset) & (IP_MF | IP_OFFMASK)) != 0
+		|| ntohs(ipHeader.total_length) != buffer->size
+		|| buffer->size == ipLength + tcpLength
+		|| (tcpHeader.flags & ~TCP_FLAG_PUSH) != TCP_FLAG_ACKNOWLEDGE)
+		return false;
+
+	if ((buffer->buffer_flags & NET_BUFFER_L3_CHECKSUM_VALID) == 0) {
+		if (gNetBufferModule.checksum(buffer, 0, ipLength, true) != 0)
+			return false;
+		buffer->buffer_flags |= NET_BUFFER_L3_CHECKSUM_VALID;
+	}
+	if ((buffer->buffer_flags & NET_BUFFER_L4_CHECKSUM_VALID) == 0) {
+		size_t length = buffer->size - ipLength;
+		if (tcp_checksum(ipHeader,
+				gNetBufferModule.checksum(buffer, ipLength, length, false),
+				length) != 0)
+			return false;
+		buffer->buffer_flags |= NET_BUFFER_L4_CHECKSUM_VALID;
+	}
+
+	_ipLength = ipLength;
+	_tcpLength = tcpLength;
+	return true;
+}
+
+
+//	#pragma mark -
+
+
+/*!	Splits a \a buffer containing an IPv4 packet with a TCP segment larger
+	than net_buffer::segment_size into separate packets, and adds them to the
+	\a segments list. The payload is not copied, but shared with \a buffer.
+	\a buffer itself is left untouched, and remains the caller's.
+*/
+status_t
+segment_buffer(net_buffer* buffer, struct list* segments)
+{
+	uint8 header[kMaxHeaderLength];
+	size_t ipLength;
+	size_t tcpLength;
+	status_t status = read_headers(buffer, header, ipLength, tcpLength);
+	if (status != B_OK)
+		return status;
+
+	ipv4_header& ipHeader = *(ipv4_header*)header;
+	tcp_header& tcpHeader = *(tcp_header*)(header + ipLength);
+	size_t headerLength = ipLength + tcpLength;
+	uint32 segmentSize = buffer->segment_size;
+	if (segmentSize == 0 || buffer->size <= headerLength)
+		return B_BAD_VALUE;
+
+	uint32 dataLength = buffer->size - headerLength;
+	uint32 sequence = ntohl(tcpHeader.sequence);
+	uint16 id = ntohs(ipHeader.id);
+	uint8 flags = tcpHeader.flags;
+
+	list_init(segments);
+
+	for (uint32 offset = 0; offset < dataLength; offset += segmentSize) {
+		uint32 length = min_c(segmentSize, dataLength - offset);
+
+		net_buffer* segment = gNetBufferModule.create(headerLength);
+		if (segment == NULL) {
+			status = B_NO_MEMORY;
+			break;
+		}
+		list_add_item(segments, segment);
+
+		status = gNetBufferModule.append_cloned(segment, buffer,
+			headerLength + offset, length);
+		if (status != B_OK)
+			break;
+
+		copy_segment_metadata(segment, buffer);
+
+		// only the last segment keeps the FIN and PUSH flags
+		tcpHeader.flags = flags;
+		if (offset + length < dataLength)
+			tcpHeader.flags &= ~(TCP_FLAG_FINISH | TCP_FLAG_PUSH);
+		tcpHeader.sequence = htonl(sequence + offset);
+		tcpHeader.checksum = 0;
+
+		tcpHeader.checksum = tcp_checksum(ipHeader,
+			(uint32)compute_checksum((uint8*)&tcpHeader, tcpLength)
+				+ gNetBufferModule.checksum(segment, 0, length, false),
+			tcpLength + length);
+
+		ipHeader.total_length = htons(headerLength + length);
+		ipHeader.id = htons(id++);
+		ipHeader.checksum = 0;
+		ipHeader.checksum = checksum(header, ipLength);
+
+		status = gNetBufferModule.prepend(segment, header, headerLength);
+		if (status != B_OK)
+			break;
+	}
+
+	if (status != B_OK) {
+		while (net_buffer* segment
+				= (net_buffer*)list_remove_head_item(segments)) {
+			gNetBufferModule.free(segment);
+		}
+	}
+
+	return status;
+}
+
+
+/*!	Appends the data of the TCP segment in \a next to the one in \a buffer,
+	if both belong to the same connection, and \a next directly follows
+	\a buffer. In this case, \a next is freed, and \c true is returned.
+	Otherwise, both buffers are left untouched.
+*/
+bool
+coalesce_buffers(net_buffer* buffer, net_buffer* next)
+{
+	if (buffer->interface_address != next->interface_address
+		|| (buffer->interface_address == NULL && buffer->type != next->type))
+		return false;
+
+	uint8 header[kMaxHeaderLength];
+	uint8 nextHeader[kMaxHeaderLength];
+	size_t ipLength;
+	size_t tcpLength;
+	size_t nextIPLength;
+	size_t nextTCPLength;
+	if (!parse_received_segment(buffer, header, ipLength, tcpLength)
+		|| !parse_received_segment(next, nextHeader, nextIPLength,
+			nextTCPLength))
+		return false;
+
+	ipv4_header& ipHeader = *(ipv4_header*)header;
+	tcp_header& tcpHeader = *(tcp_header*)(header + ipLength);
+	ipv4_header& nextIPHeader = *(ipv4_header*)nextHeader;
+	tcp_header& nextTCPHeader = *(tcp_header*)(nextHeader + nextIPLength);
+
+	size_t headerLength = ipLength + tcpLength;
+	uint32 dataLength = buffer->size - headerLength;
+	uint32 nextDataLength = next->size - headerLength;
+
+	// A segment with the PUSH flag set ends the chain, and the headers must
+	// be identical except for the sequence number, and the length.
+	if ((tcpHeader.flags & TCP_FLAG_PUSH) != 0
+		|| tcpLength != nextTCPLength
+		|| buffer->size + nextDataLength > IP_MAXPACKET
+		|| ipHeader.source != nextIPHeader.source
+		|| ipHeader.destination != nextIPHeader.destination
+		|| ipHeader.service_type != nextIPHeader.service_type
+		|| tcpHeader.source_port != nextTCPHeader.source_port
+		|| tcpHeader.destination_port != nextTCPHeader.destination_port
+		|| tcpHeader.acknowledge != nextTCPHeader.acknowledge
+		|| tcpHeader.advertised_window != nextTCPHeader.advertised_window
+		|| ntohl(nextTCPHeader.sequence)
+			!= ntohl(tcpHeader.sequence) + dataLength
+		|| memcmp(&tcpHeader + 1, &nextTCPHeader + 1,
+			tcpLength - sizeof(tcp_header)) != 0)
+		return false;
+
+	if (gNetBufferModule.append_cloned(buffer, next, headerLength,
+			nextDataLength) != B_OK)
+		return false;
+
+	tcpHeader.flags |= nextTCPHeader.flags;
+	ipHeader.total_length = htons(buffer->size);
+	ipHeader.checksum = 0;
+	ipHeader.checksum = checksum(header, ipLength);
+
+	// The TCP checksum is not updated, as it has already been verified
+	gNetBufferModule.write(buffer, 0, header, headerLength);
+	gNetBufferModule.free(next);
+
+	return true;
+}
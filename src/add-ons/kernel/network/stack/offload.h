@@ -0,0 +1,18 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef NET_OFFLOAD_H
+#define NET_OFFLOAD_H
+
+
+#include <net_buffer.h>
+
+#include <util/list.h>
+
+
+status_t	segment_buffer(net_buffer* buffer, struct list* segments);
+bool		coalesce_buffers(net_buffer* buffer, net_buffer* next);
+
+
+#endif	// NET_OFFLOAD_H
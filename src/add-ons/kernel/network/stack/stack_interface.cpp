@@ -161,6 +161,16 @@ stack_interface_sendmsg(net_socket* socket, const struct msghdr* message,
 }
 
 
+static ssize_t
+stack_interface_send_external(net_socket* socket, const struct iovec* vecs,
+	uint32 vecCount, void (*freeFunction)(void* cookie), void* cookie,
+	int flags)
+{
+	return socket_send_external(socket, vecs, vecCount, freeFunction, cookie,
+		flags);
+}
+
+
 static status_t
 stack_interface_getsockopt(net_socket* socket, int level, int option,
 	void* value, socklen_t* _length)
@@ -298,5 +308,7 @@ net_stack_interface_module_info gNetStackInterfaceModule = {
 	&stack_interface_select,
 	&stack_interface_deselect,
 
-	&stack_interface_get_next_socket_stat
+	&stack_interface_get_next_socket_stat,
+
+	&stack_interface_send_external
 };
@@ -43,6 +43,11 @@ status_t get_domain_datalink_protocols(Interface* interface,
 status_t put_domain_datalink_protocols(Interface* interface,
 	net_domain* domain);
 
+// net_socket.cpp
+ssize_t socket_send_external(net_socket* socket, const struct iovec* vecs,
+	uint32 vecCount, net_buffer_free_func freeFunction, void* cookie,
+	int flags);
+
 // notifications.cpp
 status_t notify_interface_added(net_interface* interface);
 status_t notify_interface_removed(net_interface* interface);
@@ -23,6 +23,8 @@
 #include <SupportDefs.h>
 #include <String.h>
 
+#include <query_private.h>
+
 #include "FilteredQuery.h"
 
 extern const char *__progname;
@@ -59,12 +61,14 @@ FilterByFolder(const entry_ref *ref, void *arg)
 bool o_all_volumes = false;       // Query all volumes?
 bool o_escaping = true;       // Escape metacharacters?
 bool o_subfolders = false;
+bool o_debug_plan = false;	// Report the query plan?
 
 void
 usage(void)
 {
-	printf("usage: %s [ -e ] [ -p <path-to-search> ] [ -s ] [ -a || -v <path-to-volume> ] expression\n"
+	printf("usage: %s [ -ed ] [ -p <path-to-search> ] [ -s ] [ -a || -v <path-to-volume> ] expression\n"
 		"  -e\t\tdon't escape meta-characters\n"
+		"  -d\t\tlet the file system write the query plan to the syslog\n"
 		"  -p <path>\tsearch only in the given path. Defaults to the current directory.\n"
 		"  -s\t\tinclude subfolders\n"
 		"  -a\t\tperform the query on all volumes\n"
@@ -84,6 +88,8 @@ perform_query(BVolume &volume, const char *predicate, const char *filterpath)
 	// Set up the volume and predicate for the query.
 	query.SetVolume(&volume);
 	query.SetPredicate(predicate);
+	if (o_debug_plan)
+		query.SetFlags(B_QUERY_DEBUG_PLAN);
 	folder_params options;
 	if (filterpath != NULL) {
 		options.path = filterpath;
@@ -137,7 +143,7 @@ main(int32 argc, const char **argv)
 
 	// Parse command-line arguments.
 	int opt;
-	while ((opt = getopt(argc, (char **)argv, "easv:p:")) != -1) {
+	while ((opt = getopt(argc, (char **)argv, "easdv:p:")) != -1) {
 		switch(opt) {
 		case 'a':
 			o_all_volumes = true;
@@ -159,6 +165,10 @@ main(int32 argc, const char **argv)
 			o_subfolders = true;
 			break;
 
+		case 'd':
+			o_debug_plan = true;
+			break;
+
 		default:
 			usage();
 			break;
@@ -26,6 +26,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <query_private.h>
+
 
 extern const char *__progname;
 static const char *kProgramName = __progname;
@@ -35,15 +37,17 @@ static bool sAllVolumes = false;		// Query all volumes?
 static bool sEscapeMetaChars = true;	// Escape metacharacters?
 static bool sFilesOnly = false;			// Show only files?
 static bool sLocalizedAppNames = false;	// match localized names
+static bool sDebugPlan = false;			// Report the query plan?
 
 
 void
 usage(void)
 {
-	printf("usage: %s [ -ef ] [ -a || -v <path-to-volume> ] expression\n"
+	printf("usage: %s [ -efd ] [ -a || -v <path-to-volume> ] expression\n"
 		"  -e\t\tdon't escape meta-characters\n"
 		"  -f\t\tshow only files (ie. no directories or symbolic links)\n"
 		"  -l\t\tmatch expression with localized application names\n"
+		"  -d\t\tlet the file system write the query plan to the syslog\n"
 		"  -a\t\tperform the query on all volumes\n"
 		"  -v <file>\tperform the query on just one volume; <file> can be any\n"
 		"\t\tfile on that volume. Defaults to the current volume.\n"
@@ -58,6 +62,8 @@ perform_query(BVolume &volume, const char *predicate)
 {
 	BQuery query;
 	query.SetVolume(&volume);
+	if (sDebugPlan)
+		query.SetFlags(B_QUERY_DEBUG_PLAN);
 
 	if (sLocalizedAppNames)
 		query.SetPredicate("BEOS:APP_SIG=*");
@@ -124,7 +130,7 @@ main(int argc, char **argv)
 
 	// Parse command-line arguments.
 	int opt;
-	while ((opt = getopt(argc, argv, "efalv:")) != -1) {
+	while ((opt = getopt(argc, argv, "efaldv:")) != -1) {
 		switch(opt) {
 			case 'e':
 				sEscapeMetaChars = false;
@@ -138,6 +144,9 @@ main(int argc, char **argv)
 			case 'l':
 				sLocalizedAppNames = true;
 				break;
+			case 'd':
+				sDebugPlan = true;
+				break;
 			case 'v':
 				strlcpy(volumePath, optarg, B_FILE_NAME_LENGTH);
 				break;
@@ -6,10 +6,12 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <new>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <Directory.h>
 #include <Entry.h>
@@ -22,6 +24,8 @@
 #include <fs_index.h>
 #include <fs_info.h>
 
+#include "bfs_control.h"
+
 
 extern const char *__progname;
 static const char *kProgramName = __progname;
@@ -31,6 +35,7 @@ bool gVerbose = false;
 char *gAttrPattern;
 bool gIsPattern = false;
 bool gFromVolume = false;	// copy indices from another volume
+bool gRebuild = false;		// let the file system rebuild the indices
 BList gAttrList;				// list of indices of that volume
 
 
@@ -303,14 +308,70 @@ copyIndicesFromVolume(const char *path, BEntry &to)
 }
 
 
+/*!	Asks the file system to rebuild all matching indices of the volume
+	\a entry lives on from scratch. This is much faster than rewriting the
+	attributes of every single file, but only BFS supports it.
+*/
+void
+rebuildIndices(BEntry &entry)
+{
+	static dev_t sLastDevice = -1;
+
+	entry_ref ref;
+	BPath path;
+	if (entry.GetRef(&ref) != B_OK || entry.GetPath(&path) != B_OK) {
+		fprintf(stderr, "%s: Could not open target volume.\n", kProgramName);
+		return;
+	}
+
+	// every volume only needs to be rebuilt once
+	if (ref.device == sLastDevice)
+		return;
+	sLastDevice = ref.device;
+
+	int fd = open(path.Path(), O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "%s: Could not open \"%s\": %s\n", kProgramName,
+			path.Path(), strerror(errno));
+		return;
+	}
+
+	DIR *indexDirectory = fs_open_index_dir(ref.device);
+	if (indexDirectory == NULL) {
+		close(fd);
+		return;
+	}
+
+	while (dirent *index = fs_read_index_dir(indexDirectory)) {
+		if (gFromVolume) {
+			if (!isAttrInList(index->d_name))
+				continue;
+		} else if (!nameMatchesPattern(index->d_name))
+			continue;
+
+		if (ioctl(fd, BFS_IOCTL_REBUILD_INDEX, index->d_name,
+				strlen(index->d_name) + 1) != 0) {
+			fprintf(stderr, "%s: Could not rebuild index \"%s\": %s\n",
+				kProgramName, index->d_name, strerror(errno));
+		} else if (gVerbose)
+			printf("rebuilt index \"%s\"\n", index->d_name);
+	}
+
+	fs_close_index_dir(indexDirectory);
+	close(fd);
+}
+
+
 void
 printUsage(char *cmd)
 {
-	printf("usage: %s [-rvf] attr <list of filenames and/or directories>\n"
+	printf("usage: %s [-rvfb] attr <list of filenames and/or directories>\n"
 		"  -r\tenter directories recursively\n"
 		"  -v\tverbose output\n"
 		"  -f\tcreate/update all indices from the source volume,\n\t\"attr\" is "
-			"the path to the source volume\n", cmd);
+			"the path to the source volume\n"
+		"  -b\trebuild the matching indices of the volumes the files are on\n"
+		"\tas a whole, instead of rewriting the attributes (BFS only)\n", cmd);
 }
 
 
@@ -327,6 +388,9 @@ main(int argc, char **argv)
 	while (*++argv && **argv == '-') {
 		for (int i = 1; (*argv)[i]; i++) {
 			switch ((*argv)[i]) {
+				case 'b':
+					gRebuild = true;
+					break;
 				case 'f':
 					gFromVolume = true;
 					break;
@@ -353,7 +417,10 @@ main(int argc, char **argv)
 		if (entry.InitCheck() == B_OK) {
 			if (gFromVolume)
 				copyIndicesFromVolume(gAttrPattern, entry);
-			handleFile(&entry, &node);
+			if (gRebuild)
+				rebuildIndices(entry);
+			else
+				handleFile(&entry, &node);
 		} else
 			fprintf(stderr, "%s: could not find \"%s\".\n", kProgramName, *argv);
 	}
@@ -0,0 +1,382 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Records scheduler statistics for a while, and prints how long threads
+	had to wait until they could run, after they had been woken up, or
+	preempted. This helps to find out why a thread misses its deadlines.
+*/
+
+
+#include <OS.h>
+
+#include <generic_syscall_defs.h>
+#include <scheduler_stats.h>
+#include <syscalls.h>
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+
+static const int32 kHistogramBuckets = 25;
+	// the last bucket covers everything from 2^23 us (about 8 s) upwards
+static const bigtime_t kPollInterval = 100000;
+
+static const char* kLockNames[SCHEDULER_STATS_LOCK_COUNT] = {
+	"CPU run queue",
+	"core run queue",
+	"CPU heap",
+};
+
+
+struct latency_histogram {
+	uint64		count;
+	bigtime_t	total;
+	bigtime_t	maximum;
+	uint64		buckets[kHistogramBuckets];
+
+	void Add(bigtime_t latency)
+	{
+		int32 bucket = 0;
+		while (bucket < kHistogramBuckets - 1
+			&& latency >= (bigtime_t(1) << bucket)) {
+			bucket++;
+		}
+
+		buckets[bucket]++;
+		count++;
+		total += latency;
+		maximum = std::max(maximum, latency);
+	}
+
+	bigtime_t Average() const
+	{
+		return count > 0 ? total / count : 0;
+	}
+
+	/*!	Returns the upper bound of the bucket the given percentile falls
+		into, or the maximum, if that is lower.
+	*/
+	bigtime_t Percentile(uint32 percent) const
+	{
+		uint64 threshold = (count * percent + 99) / 100;
+		uint64 sum = 0;
+		for (int32 i = 0; i < kHistogramBuckets; i++) {
+			sum += buckets[i];
+			if (sum >= threshold && sum > 0)
+				return std::min(bigtime_t(1) << i, maximum);
+		}
+		return maximum;
+	}
+};
+
+struct thread_stats {
+	char				name[B_OS_NAME_LENGTH];
+	int32				priority;
+	uint64				migrations;
+	latency_histogram	wakeup;
+	latency_histogram	preempted;
+};
+
+typedef std::map<thread_id, thread_stats> ThreadMap;
+
+
+extern const char* __progname;
+static const char* kProgramName = __progname;
+
+static volatile sig_atomic_t sQuit;
+
+
+static void
+usage(int status)
+{
+	fprintf(stderr, "usage: %s [-d <seconds>] [-n <count>] [-t <thread>]\n"
+		"Records how long threads wait in the run queues until they can run.\n"
+		"  -d <seconds>  Records for the given time, default is 5 seconds.\n"
+		"  -n <count>    Lists the given number of threads with the highest\n"
+		"                latencies, default is 20.\n"
+		"  -t <thread>   Prints the latency histograms of the given thread.\n",
+		kProgramName);
+
+	exit(status);
+}
+
+
+static void
+signal_handler(int signal)
+{
+	sQuit = 1;
+}
+
+
+static status_t
+set_enabled(bool enabled)
+{
+	uint32 value = enabled;
+	return _kern_generic_syscall(SCHEDULER_STATS, SCHEDULER_STATS_SET_ENABLED,
+		&value, sizeof(value));
+}
+
+
+static status_t
+get_cpu_stats(std::vector<scheduler_stats_cpu_info>& infos)
+{
+	return _kern_generic_syscall(SCHEDULER_STATS, SCHEDULER_STATS_GET_CPU_INFO,
+		&infos[0], infos.size() * sizeof(scheduler_stats_cpu_info));
+}
+
+
+static void
+add_events(ThreadMap& threads, const scheduler_stats_event* events,
+	uint32 count)
+{
+	for (uint32 i = 0; i < count; i++) {
+		const scheduler_stats_event& event = events[i];
+
+		ThreadMap::iterator found = threads.find(event.thread);
+		if (found == threads.end()) {
+			thread_stats stats = {};
+			thread_info info;
+			if (get_thread_info(event.thread, &info) == B_OK)
+				strlcpy(stats.name, info.name, sizeof(stats.name));
+			else
+				strlcpy(stats.name, "<gone>", sizeof(stats.name));
+
+			found = threads.insert(std::make_pair(event.thread, stats)).first;
+		}
+
+		thread_stats& stats = found->second;
+		stats.priority = event.priority;
+		if (event.previous_cpu >= 0 && event.previous_cpu != event.cpu)
+			stats.migrations++;
+
+		if ((event.flags & SCHEDULER_STATS_EVENT_WAKEUP) != 0)
+			stats.wakeup.Add(event.latency);
+		else
+			stats.preempted.Add(event.latency);
+	}
+}
+
+
+static void
+print_histogram(const char* title, const latency_histogram& histogram)
+{
+	printf("%s: %" B_PRIu64 " times, average %" B_PRIdBIGTIME " us, "
+		"maximum %" B_PRIdBIGTIME " us\n", title, histogram.count,
+		histogram.Average(), histogram.maximum);
+	if (histogram.count == 0)
+		return;
+
+	uint64 largest = *std::max_element(histogram.buckets,
+		histogram.buckets + kHistogramBuckets);
+
+	for (int32 i = 0; i < kHistogramBuckets; i++) {
+		if (histogram.buckets[i] == 0)
+			continue;
+
+		int barLength = histogram.buckets[i] * 40 / largest;
+		char bar[41];
+		memset(bar, '#', barLength);
+		bar[barLength] = '\0';
+
+		if (i == kHistogramBuckets - 1) {
+			printf("  %8" B_PRIdBIGTIME " us and more %10" B_PRIu64 " %s\n",
+				bigtime_t(1) << (i - 1), histogram.buckets[i], bar);
+		} else {
+			printf("  < %8" B_PRIdBIGTIME " us      %10" B_PRIu64 " %s\n",
+				bigtime_t(1) << i, histogram.buckets[i], bar);
+		}
+	}
+}
+
+
+static void
+print_thread(thread_id id, const thread_stats& stats)
+{
+	printf("thread %" B_PRId32 " \"%s\", priority %" B_PRId32 ", %" B_PRIu64
+		" migrations\n", id, stats.name, stats.priority, stats.migrations);
+	print_histogram("woken up", stats.wakeup);
+	print_histogram("preempted", stats.preempted);
+}
+
+
+static bool
+compare_by_maximum(const ThreadMap::const_iterator& a,
+	const ThreadMap::const_iterator& b)
+{
+	return std::max(a->second.wakeup.maximum, a->second.preempted.maximum)
+		> std::max(b->second.wakeup.maximum, b->second.preempted.maximum);
+}
+
+
+static void
+print_threads(const ThreadMap& threads, size_t count)
+{
+	std::vector<ThreadMap::const_iterator> sorted;
+	for (ThreadMap::const_iterator it = threads.begin(); it != threads.end();
+			it++) {
+		sorted.push_back(it);
+	}
+	std::sort(sorted.begin(), sorted.end(), &compare_by_maximum);
+
+	printf("                                          ----- woken up (us) -----"
+		"  --- preempted (us) ---\n");
+	printf("thread  name                      prio   count   avg   99%%    max"
+		"   count   avg    max  migr\n");
+
+	count = std::min(count, sorted.size());
+	for (size_t i = 0; i < count; i++) {
+		const thread_stats& stats = sorted[i]->second;
+		printf("%6" B_PRId32 "  %-24.24s %5" B_PRId32 " %7" B_PRIu64 " %5"
+			B_PRIdBIGTIME " %5" B_PRIdBIGTIME " %6" B_PRIdBIGTIME " %7"
+			B_PRIu64 " %5" B_PRIdBIGTIME " %6" B_PRIdBIGTIME " %5" B_PRIu64
+			"\n", sorted[i]->first, stats.name, stats.priority,
+			stats.wakeup.count, stats.wakeup.Average(),
+			stats.wakeup.Percentile(99), stats.wakeup.maximum,
+			stats.preempted.count, stats.preempted.Average(),
+			stats.preempted.maximum, stats.migrations);
+	}
+}
+
+
+static void
+print_cpus(const std::vector<scheduler_stats_cpu_info>& start,
+	const std::vector<scheduler_stats_cpu_info>& end)
+{
+	printf("\ncpu   events    lost  migr");
+	for (int32 i = 0; i < SCHEDULER_STATS_LOCK_COUNT; i++)
+		printf("  %21s", kLockNames[i]);
+	printf("\n");
+
+	for (size_t cpu = 0; cpu < end.size(); cpu++) {
+		const scheduler_stats_cpu_info& a = start[cpu];
+		const scheduler_stats_cpu_info& b = end[cpu];
+
+		printf("%3zu %8" B_PRIu64 " %7" B_PRIu64 " %5" B_PRIu64, cpu,
+			b.events - a.events, b.lost_events - a.lost_events,
+			b.migrations - a.migrations);
+
+		for (int32 i = 0; i < SCHEDULER_STATS_LOCK_COUNT; i++) {
+			// contended acquisitions and the time spent waiting for them
+			printf("  %8" B_PRIu64 "x %8" B_PRId64 " us",
+				b.lock_contended[i] - a.lock_contended[i],
+				(b.lock_wait_time[i] - a.lock_wait_time[i]) / 1000);
+		}
+		printf("\n");
+	}
+}
+
+
+int
+main(int argc, char** argv)
+{
+	bigtime_t duration = 5000000;
+	size_t count = 20;
+	thread_id thread = -1;
+
+	int c;
+	while ((c = getopt(argc, argv, "d:n:t:h")) != -1) {
+		switch (c) {
+			case 'd':
+				duration = strtol(optarg, NULL, 0) * 1000000LL;
+				if (duration <= 0)
+					usage(1);
+				break;
+			case 'n':
+				count = strtoul(optarg, NULL, 0);
+				break;
+			case 't':
+				thread = strtol(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+	if (optind < argc)
+		usage(1);
+
+	scheduler_stats_info info;
+	status_t status = _kern_generic_syscall(SCHEDULER_STATS,
+		SCHEDULER_STATS_GET_INFO, &info, sizeof(info));
+	if (status != B_OK) {
+		fprintf(stderr, "%s: Scheduler statistics are not available: %s\n",
+			kProgramName, strerror(status));
+		return 1;
+	}
+
+	bool wasEnabled = info.enabled != 0;
+	if (!wasEnabled) {
+		status = set_enabled(true);
+		if (status != B_OK) {
+			fprintf(stderr, "%s: Could not enable scheduler statistics: %s\n",
+				kProgramName, strerror(status));
+			return 1;
+		}
+	}
+
+	signal(SIGINT, &signal_handler);
+
+	std::vector<scheduler_stats_cpu_info> startInfo(info.cpu_count);
+	std::vector<scheduler_stats_cpu_info> endInfo(info.cpu_count);
+	get_cpu_stats(startInfo);
+
+	// each poll should be able to drain all buffers
+	std::vector<scheduler_stats_event> events(
+		info.cpu_count * info.buffer_size);
+	ThreadMap threads;
+
+	bigtime_t end = system_time() + duration;
+	while (!sQuit) {
+		scheduler_stats_read_events read;
+		read.events = &events[0];
+		read.count = events.size();
+		status = _kern_generic_syscall(SCHEDULER_STATS,
+			SCHEDULER_STATS_READ_EVENTS, &read, sizeof(read));
+		if (status != B_OK) {
+			fprintf(stderr, "%s: Could not read events: %s\n", kProgramName,
+				strerror(status));
+			break;
+		}
+
+		add_events(threads, read.events, read.count);
+
+		bigtime_t now = system_time();
+		if (now >= end)
+			break;
+
+		snooze(std::min(kPollInterval, end - now));
+	}
+
+	get_cpu_stats(endInfo);
+
+	if (!wasEnabled)
+		set_enabled(false);
+
+	if (thread >= 0) {
+		ThreadMap::const_iterator found = threads.find(thread);
+		if (found == threads.end()) {
+			fprintf(stderr, "%s: Thread %" B_PRId32 " did not run.\n",
+				kProgramName, thread);
+			return 1;
+		}
+		print_thread(thread, found->second);
+	} else
+		print_threads(threads, count);
+
+	print_cpus(startInfo, endInfo);
+	return 0;
+}
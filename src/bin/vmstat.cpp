@@ -11,6 +11,9 @@
 
 #include <system_info.h>
 
+#include <syscalls.h>
+#include <vm_defs.h>
+
 
 static struct option const kLongOptions[] = {
 	{"periodic", no_argument, 0, 'p'},
@@ -85,14 +88,37 @@ main(int argc, char** argv)
 		info.free_swap_pages * B_PAGE_SIZE);
 	printf("page faults:\t\t%" B_PRIu32 "\n", info.page_faults);
 
+	vm_fault_stats faultStats;
+	memset(&faultStats, 0, sizeof(faultStats));
+	_kern_get_vm_fault_stats(&faultStats, sizeof(faultStats));
+
+	printf("fault-around faults:\t%" B_PRIu32 "\n",
+		faultStats.fault_around_faults);
+	printf("fault-around pages:\t%" B_PRIu32 "\n",
+		faultStats.fault_around_pages);
+
+	vm_numa_node_stats nodeStats[8];
+	uint32 nodeCount = sizeof(nodeStats) / sizeof(nodeStats[0]);
+	if (_kern_get_vm_numa_stats(nodeStats, &nodeCount) == B_OK
+		&& nodeCount > 1) {
+		for (uint32 i = 0; i < nodeCount; i++) {
+			printf("node %" B_PRIu32 " memory:\t\t%" B_PRIu64 " (%" B_PRIu64
+				" free)\n", i, nodeStats[i].total_pages * B_PAGE_SIZE,
+				nodeStats[i].free_pages * B_PAGE_SIZE);
+		}
+	}
+
 	if (periodically) {
-		puts("\npage faults  used memory    used swap  block cache");
+		puts("\npage faults  used memory    used swap  block cache  "
+			"fault-around");
 		system_info lastInfo = info;
+		vm_fault_stats lastFaultStats = faultStats;
 
 		while (true) {
 			snooze(rate);
 
 			get_system_info(&info);
+			_kern_get_vm_fault_stats(&faultStats, sizeof(faultStats));
 
 			int32 pageFaults = info.page_faults - lastInfo.page_faults;
 			int64 usedMemory
@@ -105,10 +131,14 @@ main(int argc, char** argv)
 			int64 blockCache
 				= (info.block_cache_pages - lastInfo.block_cache_pages)
 					* B_PAGE_SIZE;
+			int32 faultAroundPages = faultStats.fault_around_pages
+				- lastFaultStats.fault_around_pages;
 			printf("%11" B_PRId32 "  %11" B_PRId64 "  %11" B_PRId64 "  %11"
-				B_PRId64 "\n", pageFaults, usedMemory, usedSwap, blockCache);
+				B_PRId64 "  %12" B_PRId32 "\n", pageFaults, usedMemory, usedSwap,
+				blockCache, faultAroundPages);
 
 			lastInfo = info;
+			lastFaultStats = faultStats;
 		}
 	}
 
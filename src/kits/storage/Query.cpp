@@ -42,7 +42,8 @@ BQuery::BQuery()
 	fLive(false),
 	fPort(B_ERROR),
 	fToken(0),
-	fQueryFd(-1)
+	fQueryFd(-1),
+	fFlags(0)
 {
 }
 
@@ -74,6 +75,7 @@ BQuery::Clear()
 	fLive = false;
 	fPort = B_ERROR;
 	fToken = 0;
+	fFlags = 0;
 	return error;
 }
 
@@ -232,6 +234,20 @@ BQuery::SetTarget(BMessenger messenger)
 }
 
 
+// Sets additional flags the query is opened with.
+status_t
+BQuery::SetFlags(uint32 flags)
+{
+	// live queries need a target, see SetTarget()
+	status_t error = ((flags & B_LIVE_QUERY) == 0 ? B_OK : B_BAD_VALUE);
+	if (error == B_OK && _HasFetched())
+		error = B_NOT_ALLOWED;
+	if (error == B_OK)
+		fFlags = flags;
+	return error;
+}
+
+
 // Gets whether the query associated with this object is live.
 bool
 BQuery::IsLive() const
@@ -240,6 +256,14 @@ BQuery::IsLive() const
 }
 
 
+// Gets the additional flags the query is opened with.
+uint32
+BQuery::Flags() const
+{
+	return fFlags;
+}
+
+
 // Fills out buffer with the predicate string assigned to the BQuery object.
 status_t
 BQuery::GetPredicate(char* buffer, size_t length)
@@ -311,7 +335,7 @@ BQuery::Fetch()
 	_ParseDates(parsedPredicate);
 
 	fQueryFd = _kern_open_query(fDevice, parsedPredicate.String(),
-		parsedPredicate.Length(), fLive ? B_LIVE_QUERY : 0, fPort, fToken);
+		parsedPredicate.Length(), (fLive ? B_LIVE_QUERY : 0) | fFlags, fPort, fToken);
 	if (fQueryFd < 0)
 		return fQueryFd;
 
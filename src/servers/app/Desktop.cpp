@@ -26,6 +26,7 @@
 #include <syslog.h>
 
 #include <Debug.h>
+#include <TLS.h>
 #include <debugger.h>
 #include <DirectWindow.h>
 #include <Entry.h>
@@ -75,6 +76,10 @@
 #endif
 
 
+// the time the window lock was read locked by the current thread
+static int32 sReadLockTimeSlot = tls_allocate();
+
+
 static inline float
 square_vector_length(float x, float y)
 {
@@ -269,7 +274,10 @@ MouseFilter::Filter(BMessage* message, EventTarget** _target, int32* _viewToken,
 	if (message->FindInt32("buttons", &buttons) != B_OK)
 		buttons = 0;
 
-	if (!fDesktop->LockAllWindows())
+	// Mouse moves are by far the most frequent events, and only need to stop
+	// the windows from drawing that they actually change.
+	bool moved = message->what == B_MOUSE_MOVED;
+	if (!(moved ? fDesktop->LockClipping() : fDesktop->LockAllWindows()))
 		return B_DISPATCH_MESSAGE;
 
 	int32 viewToken = B_NULL_TOKEN;
@@ -385,7 +393,10 @@ MouseFilter::Filter(BMessage* message, EventTarget** _target, int32* _viewToken,
 
 	fDesktop->NotifyMouseEvent(message);
 
-	fDesktop->UnlockAllWindows();
+	if (moved)
+		fDesktop->UnlockClipping();
+	else
+		fDesktop->UnlockAllWindows();
 
 	return B_DISPATCH_MESSAGE;
 }
@@ -434,6 +445,15 @@ Desktop::Desktop(uid_t userID, const char* targetScreen)
 
 	fWorkspacesLock("workspaces list"),
 	fWindowLock("window lock"),
+	fWindowLockNesting(0),
+	fWindowLockTime(0),
+	fBlockedWindows(20, false),
+	fDrawingBlockTime(0),
+	fReadLockWait("window lock read wait"),
+	fReadLockHold("window lock read hold"),
+	fWriteLockWait("window lock write wait"),
+	fWriteLockHold("window lock write hold"),
+	fDrawingBlocked("window drawing blocked"),
 
 	fMouseEventWindow(NULL),
 	fWindowUnderMouse(NULL),
@@ -674,6 +694,101 @@ Desktop::KeyEvent(uint32 what, int32 key, int32 modifiers)
 }
 
 
+// #pragma mark - Locking
+
+
+bool
+Desktop::LockSingleWindow()
+{
+	if (fWindowLock.IsWriteLocked())
+		return fWindowLock.ReadLock();
+
+	bigtime_t start = system_time();
+	if (!fWindowLock.ReadLock())
+		return false;
+
+	bigtime_t now = system_time();
+	fReadLockWait.Add(now - start);
+	tls_set(sReadLockTimeSlot, (void*)(addr_t)now);
+	return true;
+}
+
+
+void
+Desktop::UnlockSingleWindow()
+{
+	if (!fWindowLock.IsWriteLocked()) {
+		// on 32 bit systems, only the lower bits of the time fit, but that
+		// doesn't matter for the difference
+		addr_t start = (addr_t)tls_get(sReadLockTimeSlot);
+		fReadLockHold.Add((addr_t)system_time() - start);
+	}
+
+	fWindowLock.ReadUnlock();
+}
+
+
+/*!	Write locks the windows, and prevents all of them from drawing until the
+	lock is released again.
+	This is needed whenever windows are added, removed, or their order changes.
+*/
+bool
+Desktop::LockAllWindows()
+{
+	if (!_WriteLockWindows())
+		return false;
+
+	_BlockAllDrawing();
+	return true;
+}
+
+
+void
+Desktop::UnlockAllWindows()
+{
+	_WriteUnlockWindows();
+}
+
+
+/*!	Write locks the windows, but lets them continue to draw. Every window
+	whose clipping or contents are changed blocks its drawing via
+	BlockDrawing() before doing so, and stays blocked until the lock is
+	released again.
+	This is used when moving and resizing windows, so that only the windows
+	that are actually affected have to wait.
+*/
+bool
+Desktop::LockClipping()
+{
+	return _WriteLockWindows();
+}
+
+
+void
+Desktop::UnlockClipping()
+{
+	_WriteUnlockWindows();
+}
+
+
+/*!	Waits until  window has finished drawing, and keeps it from drawing
+	again until the window lock is released.
+	Does nothing if the window lock is not write locked by the caller.
+*/
+void
+Desktop::BlockDrawing(Window* window)
+{
+	if (!fWindowLock.IsWriteLocked() || window->IsDrawingLocked())
+		return;
+
+	if (fBlockedWindows.IsEmpty())
+		fDrawingBlockTime = system_time();
+
+	if (window->LockDrawing())
+		fBlockedWindows.AddItem(window);
+}
+
+
 // #pragma mark - Mouse and cursor methods
 
 
@@ -743,7 +858,7 @@ status_t
 Desktop::SetScreenMode(int32 workspace, int32 id, const display_mode& mode,
 	bool makeDefault)
 {
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	if (workspace == B_CURRENT_WORKSPACE_INDEX)
 		workspace = fCurrentWorkspace;
@@ -879,7 +994,7 @@ Desktop::RevertScreenModes(uint32 workspaces)
 	if (workspaces == 0)
 		return;
 
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	for (int32 workspace = 0; workspace < kMaxWorkspaces; workspace++) {
 		if ((workspaces & (1U << workspace)) == 0)
@@ -1141,7 +1256,7 @@ Desktop::ActivateWindow(Window* window)
 	if (window->Workspaces() == 0 && window->IsNormal())
 		return;
 
-	AutoWriteLocker allWindowLocker(fWindowLock);
+	AllWindowsLocker allWindowLocker(this);
 
 	NotifyWindowActivated(window);
 
@@ -1332,7 +1447,7 @@ Desktop::ShowWindow(Window* window)
 	if (!window->IsHidden())
 		return;
 
-	AutoWriteLocker locker(fWindowLock);
+	AllWindowsLocker locker(this);
 
 	window->SetHidden(false);
 	fFocusList.AddWindow(window);
@@ -1450,7 +1565,7 @@ Desktop::MoveWindowBy(Window* window, float x, float y, int32 workspace)
 	if (x == 0 && y == 0)
 		return;
 
-	AutoWriteLocker _(fWindowLock);
+	ClippingLocker _(this);
 
 	Window* topWindow = window->TopLayerStackWindow();
 	if (topWindow != NULL)
@@ -1490,6 +1605,9 @@ Desktop::MoveWindowBy(Window* window, float x, float y, int32 workspace)
 	// stop direct frame buffer access
 	bool direct = false;
 	if (window->ServerWindow()->IsDirectlyAccessing()) {
+		// HandleDirectConnection() updates the window's visible content
+		// region, which its own thread must not use while drawing
+		BlockDrawing(window);
 		window->ServerWindow()->HandleDirectConnection(B_DIRECT_STOP);
 		direct = true;
 	}
@@ -1510,8 +1628,8 @@ Desktop::MoveWindowBy(Window* window, float x, float y, int32 workspace)
 	// moved into the dirty region (for now)
 	newDirtyRegion.Include(&window->VisibleRegion());
 
-	// NOTE: Having all windows locked should prevent any
-	// problems with locking the drawing engine here.
+	// NOTE: Having all affected windows blocked from drawing
+	// should prevent any problems with locking the drawing engine here.
 	if (GetDrawingEngine()->LockParallelAccess()) {
 		GetDrawingEngine()->CopyRegion(&copyRegion, (int32)x, (int32)y);
 		GetDrawingEngine()->UnlockParallelAccess();
@@ -1544,7 +1662,7 @@ Desktop::ResizeWindowBy(Window* window, float x, float y)
 	if (x == 0 && y == 0)
 		return;
 
-	AutoWriteLocker _(fWindowLock);
+	ClippingLocker _(this);
 
 	Window* topWindow = window->TopLayerStackWindow();
 	if (topWindow)
@@ -1556,6 +1674,9 @@ Desktop::ResizeWindowBy(Window* window, float x, float y)
 		return;
 	}
 
+	// we need its current content region
+	BlockDrawing(window);
+
 	// The dirty region for the inside of the window is constructed by the window itself in
 	// ResizeBy()
 	BRegion newDirtyRegion;
@@ -1611,7 +1732,7 @@ Desktop::ResizeWindowBy(Window* window, float x, float y)
 void
 Desktop::SetWindowOutlinesDelta(Window* window, BPoint delta)
 {
-	AutoWriteLocker _(fWindowLock);
+	ClippingLocker _(this);
 
 	if (!window->IsVisible())
 		return;
@@ -1630,7 +1751,7 @@ Desktop::SetWindowOutlinesDelta(Window* window, BPoint delta)
 bool
 Desktop::SetWindowTabLocation(Window* window, float location, bool isShifting)
 {
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	BRegion dirty;
 	bool changed = window->SetTabLocation(location, isShifting, dirty);
@@ -1646,7 +1767,7 @@ Desktop::SetWindowTabLocation(Window* window, float location, bool isShifting)
 bool
 Desktop::SetWindowDecoratorSettings(Window* window, const BMessage& settings)
 {
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	BRegion dirty;
 	bool changed = window->SetDecoratorSettings(settings, dirty);
@@ -1725,6 +1846,10 @@ Desktop::RemoveWindow(Window *window)
 
 	NotifyWindowRemoved(window);
 
+	// the window might already be gone when an outer lock is released
+	if (fBlockedWindows.RemoveItem(window))
+		window->UnlockDrawing();
+
 	UnlockAllWindows();
 
 	// make sure this window won't get any events anymore
@@ -1757,7 +1882,7 @@ Desktop::RemoveWindowFromSubset(Window* subset, Window* window)
 void
 Desktop::FontsChanged(Window* window)
 {
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	BRegion dirty;
 	window->FontsChanged(&dirty);
@@ -1769,7 +1894,7 @@ Desktop::FontsChanged(Window* window)
 void
 Desktop::ColorUpdated(Window* window, color_which which, rgb_color color)
 {
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	window->TopView()->ColorUpdated(which, color);
 
@@ -1797,7 +1922,7 @@ Desktop::SetWindowLook(Window* window, window_look newLook)
 	if (window->Look() == newLook)
 		return;
 
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	BRegion dirty;
 	window->SetLook(newLook, &dirty);
@@ -1919,7 +2044,7 @@ Desktop::SetWindowFlags(Window *window, uint32 newFlags)
 	if (window->Flags() == newFlags)
 		return;
 
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	BRegion dirty;
 	window->SetFlags(newFlags, &dirty);
@@ -1933,7 +2058,7 @@ Desktop::SetWindowFlags(Window *window, uint32 newFlags)
 void
 Desktop::SetWindowTitle(Window *window, const char* title)
 {
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	BRegion dirty;
 	window->SetTitle(title, dirty);
@@ -2131,7 +2256,7 @@ Desktop::SetFocusWindow(Window* nextFocus)
 void
 Desktop::SetFocusLocked(const Window* window)
 {
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	if (window != NULL) {
 		// Don't allow this to be set when no mouse buttons
@@ -2179,11 +2304,11 @@ Desktop::MarkDirty(BRegion& dirtyRegion, BRegion& exposeRegion)
 	if (dirtyRegion.CountRects() == 0)
 		return;
 
-	if (LockAllWindows()) {
+	if (LockClipping()) {
 		// send redraw messages to all windows intersecting the dirty region
 		_TriggerWindowRedrawing(dirtyRegion, exposeRegion);
 
-		UnlockAllWindows();
+		UnlockClipping();
 	}
 }
 
@@ -2240,7 +2365,7 @@ Desktop::RedrawBackground()
 bool
 Desktop::ReloadDecor(DecorAddOn* oldDecor)
 {
-	AutoWriteLocker _(fWindowLock);
+	AllWindowsLocker _(this);
 
 	bool returnValue = true;
 
@@ -2281,7 +2406,7 @@ Desktop::ReloadDecor(DecorAddOn* oldDecor)
 void
 Desktop::MinimizeApplication(team_id team)
 {
-	AutoWriteLocker locker(fWindowLock);
+	AllWindowsLocker locker(this);
 
 	// Just minimize all windows of that application
 
@@ -2298,7 +2423,7 @@ Desktop::MinimizeApplication(team_id team)
 void
 Desktop::BringApplicationToFront(team_id team)
 {
-	AutoWriteLocker locker(fWindowLock);
+	AllWindowsLocker locker(this);
 
 	// TODO: for now, just maximize all windows of that application
 	// TODO: have the ability to lock the current workspace
@@ -2345,7 +2470,7 @@ Desktop::WindowAction(int32 windowToken, int32 action)
 void
 Desktop::WriteWindowList(team_id team, BPrivate::LinkSender& sender)
 {
-	AutoWriteLocker locker(fWindowLock);
+	AllWindowsLocker locker(this);
 
 	// compute the number of windows
 
@@ -2388,7 +2513,7 @@ Desktop::WriteWindowList(team_id team, BPrivate::LinkSender& sender)
 void
 Desktop::WriteWindowInfo(int32 serverToken, BPrivate::LinkSender& sender)
 {
-	AutoWriteLocker locker(fWindowLock);
+	AllWindowsLocker locker(this);
 	BAutolock tokenLocker(BPrivate::gDefaultTokens);
 
 	::ServerWindow* window;
@@ -2743,6 +2868,10 @@ Desktop::_DispatchMessage(int32 code, BPrivate::LinkReceiver& link)
 			break;
 		}
 
+		case AS_DUMP_LOCK_STATISTICS:
+			_DumpLockStatistics();
+			break;
+
 		case AS_EVENT_STREAM_CLOSED:
 			_LaunchInputServer();
 			break;
@@ -2790,7 +2919,7 @@ Desktop::_DispatchMessage(int32 code, BPrivate::LinkReceiver& link)
 				break;
 
 			BPrivate::LinkSender reply(clientReplyPort);
-			AutoWriteLocker locker(fWindowLock);
+			AllWindowsLocker locker(this);
 			if (MessageForListener(NULL, link, reply) != true) {
 				// unhandled message, at least send an error if needed
 				if (link.NeedsReply()) {
@@ -3451,6 +3580,7 @@ Desktop::_RebuildClippingForAllWindows(BRegion& stillAvailableOnScreen)
 			window->SetScreen(_DetermineScreenFor(window->Frame()));
 
 			if (window->ServerWindow()->IsDirectlyAccessing()) {
+				BlockDrawing(window);
 				window->ServerWindow()->HandleDirectConnection(
 					B_DIRECT_MODIFY | B_CLIPPING_MODIFIED);
 			}
@@ -3527,6 +3657,7 @@ Desktop::RebuildAndRedrawAfterWindowChange(Window* changedWindow,
 			window->SetScreen(_DetermineScreenFor(window->Frame()));
 
 			if (window->ServerWindow()->IsDirectlyAccessing()) {
+				BlockDrawing(window);
 				window->ServerWindow()->HandleDirectConnection(
 					B_DIRECT_MODIFY | B_CLIPPING_MODIFIED);
 			}
@@ -3543,6 +3674,73 @@ Desktop::RebuildAndRedrawAfterWindowChange(Window* changedWindow,
 }
 
 
+bool
+Desktop::_WriteLockWindows()
+{
+	bigtime_t start = system_time();
+	if (!fWindowLock.WriteLock())
+		return false;
+
+	if (fWindowLockNesting++ == 0) {
+		fWindowLockTime = system_time();
+		fWriteLockWait.Add(fWindowLockTime - start);
+	}
+	return true;
+}
+
+
+void
+Desktop::_WriteUnlockWindows()
+{
+	if (--fWindowLockNesting == 0) {
+		bigtime_t now = system_time();
+
+		if (!fBlockedWindows.IsEmpty()) {
+			fDrawingBlocked.Add(now - fDrawingBlockTime);
+
+			for (int32 i = 0; i < fBlockedWindows.CountItems(); i++)
+				fBlockedWindows.ItemAt(i)->UnlockDrawing();
+			fBlockedWindows.MakeEmpty();
+		}
+
+		fWriteLockHold.Add(now - fWindowLockTime);
+	}
+
+	fWindowLock.WriteUnlock();
+}
+
+
+void
+Desktop::_BlockAllDrawing()
+{
+	for (Window* window = fAllWindows.FirstWindow(); window != NULL;
+			window = window->NextWindow(kAllWindowList)) {
+		BlockDrawing(window);
+	}
+}
+
+
+/*!	Prints how long the window lock has been waited for and held since the
+	last call, and resets the statistics.
+	Triggered by "app_server_debug -l".
+*/
+void
+Desktop::_DumpLockStatistics()
+{
+	fReadLockWait.Dump();
+	fReadLockHold.Dump();
+	fWriteLockWait.Dump();
+	fWriteLockHold.Dump();
+	fDrawingBlocked.Dump();
+
+	fReadLockWait.Reset();
+	fReadLockHold.Reset();
+	fWriteLockWait.Reset();
+	fWriteLockHold.Reset();
+	fDrawingBlocked.Reset();
+}
+
+
 //! Suspend all windows with direct access to the frame buffer
 void
 Desktop::_SuspendDirectFrameBufferAccess()
@@ -3579,7 +3777,7 @@ Desktop::_ResumeDirectFrameBufferAccess()
 void
 Desktop::ScreenChanged(Screen* screen)
 {
-	AutoWriteLocker windowLocker(fWindowLock);
+	AllWindowsLocker windowLocker(this);
 
 	AutoWriteLocker screenLocker(fScreenLock);
 	screen->SetPreferredMode();
@@ -3636,7 +3834,7 @@ Desktop::_ActivateApp(team_id team)
 {
 	// search for an unhidden window in the current workspace
 
-	AutoWriteLocker locker(fWindowLock);
+	AllWindowsLocker locker(this);
 
 	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
 			window = window->PreviousWindow(fCurrentWorkspace)) {
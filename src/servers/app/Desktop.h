@@ -18,6 +18,7 @@
 
 
 #include <AutoDeleter.h>
+#include <AutoLocker.h>
 #include <Autolock.h>
 #include <InterfaceDefs.h>
 #include <List.h>
@@ -34,6 +35,7 @@
 #include "DesktopListener.h"
 #include "DesktopSettings.h"
 #include "EventDispatcher.h"
+#include "LockHistogram.h"
 #include "MessageLooper.h"
 #include "MultiLocker.h"
 #include "Screen.h"
@@ -89,15 +91,18 @@ public:
 			filter_result		KeyEvent(uint32 what, int32 key,
 									int32 modifiers);
 	// Locking
-			bool				LockSingleWindow()
-									{ return fWindowLock.ReadLock(); }
-			void				UnlockSingleWindow()
-									{ fWindowLock.ReadUnlock(); }
+			bool				LockSingleWindow();
+			void				UnlockSingleWindow();
 
-			bool				LockAllWindows()
-									{ return fWindowLock.WriteLock(); }
-			void				UnlockAllWindows()
-									{ fWindowLock.WriteUnlock(); }
+			bool				LockAllWindows();
+			void				UnlockAllWindows();
+
+			// Like LockAllWindows(), but windows can continue to draw until
+			// they are passed to BlockDrawing(), or LockAllWindows() is
+			// called as well.
+			bool				LockClipping();
+			void				UnlockClipping();
+			void				BlockDrawing(Window* window);
 
 			const MultiLocker&	WindowLocker() { return fWindowLock; }
 
@@ -319,6 +324,11 @@ private:
 
 			status_t			_ActivateApp(team_id team);
 
+			bool				_WriteLockWindows();
+			void				_WriteUnlockWindows();
+			void				_BlockAllDrawing();
+			void				_DumpLockStatistics();
+
 			void				_SuspendDirectFrameBufferAccess();
 			void				_ResumeDirectFrameBufferAccess();
 
@@ -367,6 +377,16 @@ private:
 			ServerCursorReference fManagementCursor;
 
 			MultiLocker			fWindowLock;
+			int32				fWindowLockNesting;
+			bigtime_t			fWindowLockTime;
+			BObjectList<Window>	fBlockedWindows;
+			bigtime_t			fDrawingBlockTime;
+
+			LockHistogram		fReadLockWait;
+			LockHistogram		fReadLockHold;
+			LockHistogram		fWriteLockWait;
+			LockHistogram		fWriteLockHold;
+			LockHistogram		fDrawingBlocked;
 
 			BRegion				fBackgroundRegion;
 			BRegion				fScreenRegion;
@@ -387,4 +407,37 @@ private:
 			BMessage			fPendingColors;
 };
 
+
+class AllWindowsLocking {
+public:
+	inline bool Lock(Desktop* desktop)
+	{
+		return desktop->LockAllWindows();
+	}
+
+	inline void Unlock(Desktop* desktop)
+	{
+		desktop->UnlockAllWindows();
+	}
+};
+
+
+class ClippingLocking {
+public:
+	inline bool Lock(Desktop* desktop)
+	{
+		return desktop->LockClipping();
+	}
+
+	inline void Unlock(Desktop* desktop)
+	{
+		desktop->UnlockClipping();
+	}
+};
+
+
+typedef AutoLocker<Desktop, AllWindowsLocking> AllWindowsLocker;
+typedef AutoLocker<Desktop, ClippingLocking> ClippingLocker;
+
+
 #endif	// DESKTOP_H
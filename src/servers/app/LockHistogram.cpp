@@ -0,0 +1,76 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "LockHistogram.h"
+
+#include <string.h>
+
+#include <SupportDefs.h>
+
+
+LockHistogram::LockHistogram(const char* name)
+	:
+	fName(name)
+{
+	Reset();
+}
+
+
+void
+LockHistogram::Add(bigtime_t time)
+{
+	int32 bucket = 0;
+	while (bucket < kBucketCount - 1 && time >= kFirstBucketLimit << bucket)
+		bucket++;
+
+	atomic_add(&fBuckets[bucket], 1);
+	atomic_add(&fCount, 1);
+	atomic_add64(&fTotal, time);
+
+	int64 max = atomic_get64(&fMax);
+	while (time > max) {
+		int64 previous = atomic_test_and_set64(&fMax, time, max);
+		if (previous == max)
+			break;
+		max = previous;
+	}
+}
+
+
+void
+LockHistogram::Reset()
+{
+	memset(fBuckets, 0, sizeof(fBuckets));
+	fCount = 0;
+	fTotal = 0;
+	fMax = 0;
+}
+
+
+void
+LockHistogram::Dump() const
+{
+	if (fCount == 0) {
+		debug_printf("%s: never\n", fName);
+		return;
+	}
+
+	debug_printf("%s: %" B_PRId32 " times, %" B_PRId64 " us average, %"
+		B_PRId64 " us max\n", fName, fCount, fTotal / fCount, fMax);
+
+	for (int32 i = 0; i < kBucketCount; i++) {
+		if (fBuckets[i] == 0)
+			continue;
+
+		if (i < kBucketCount - 1) {
+			debug_printf("  < %7" B_PRId64 " us: %" B_PRId32 "\n",
+				kFirstBucketLimit << i, fBuckets[i]);
+		} else {
+			debug_printf("  >= %6" B_PRId64 " us: %" B_PRId32 "\n",
+				kFirstBucketLimit << (i - 1), fBuckets[i]);
+		}
+	}
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef LOCK_HISTOGRAM_H
+#define LOCK_HISTOGRAM_H
+
+
+#include <OS.h>
+
+
+/*!	Counts how long a lock was held or waited for, in buckets that double in
+	size. Times can be added from any number of threads at once.
+*/
+class LockHistogram {
+public:
+								LockHistogram(const char* name);
+
+			void				Add(bigtime_t time);
+			void				Reset();
+
+			void				Dump() const;
+
+private:
+	static	const int32			kBucketCount = 16;
+	static	const bigtime_t		kFirstBucketLimit = 8;
+
+			const char*			fName;
+			int32				fBuckets[kBucketCount];
+			int32				fCount;
+			int64				fTotal;
+			int64				fMax;
+};
+
+
+#endif	// LOCK_HISTOGRAM_H
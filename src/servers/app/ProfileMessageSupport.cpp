@@ -9,6 +9,8 @@
 
 #include "ProfileMessageSupport.h"
 
+#include <stdio.h>
+
 #include <ServerProtocol.h>
 
 
@@ -327,3 +329,20 @@ string_for_message_code(uint32 code)
 }
 
 
+
+
+void
+print_frame_profile(const frame_profile& profile, bigtime_t interval)
+{
+	if (profile.frames == 0 || interval <= 0)
+		return;
+
+	printf("frames: %.1f/s, %" B_PRId64 " damaged rects copied as %" B_PRId64
+		", %.2f Mpixels/s\n", profile.frames * 1000000.0 / interval,
+		profile.damage_rects, profile.copied_rects,
+		profile.copied_pixels * 1.0 / interval);
+	printf("  copy time: %" B_PRId64 " us average, %" B_PRId64 " us max\n",
+		profile.copy_time / profile.frames, profile.max_copy_time);
+	printf("  latency: %" B_PRId64 " us average, %" B_PRId64 " us max\n",
+		profile.latency / profile.frames, profile.max_latency);
+}
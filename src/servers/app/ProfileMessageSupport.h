@@ -9,10 +9,29 @@
 #define PROFILE_MESSAGE_SUPPORT_H
 
 
+#include <OS.h>
 #include <String.h>
 
 
+// profiles the message loops of the ServerWindows, and the frames copied to
+// the screen by the UpdateQueue
+//#define PROFILE_MESSAGE_LOOP
+
+
+struct frame_profile {
+	int32		frames;
+	int64		damage_rects;
+	int64		copied_rects;
+	int64		copied_pixels;
+	bigtime_t	copy_time;
+	bigtime_t	max_copy_time;
+	bigtime_t	latency;
+	bigtime_t	max_latency;
+};
+
+
 const char* string_for_message_code(uint32 code);
+void print_frame_profile(const frame_profile& profile, bigtime_t interval);
 
 
 #endif // PROFILE_MESSAGE_SUPPORT_H
@@ -123,7 +123,6 @@ static const char* kDrawingModeMap[] = {
 #	define GTRACE(x) ;
 #endif
 
-//#define PROFILE_MESSAGE_LOOP
 #ifdef PROFILE_MESSAGE_LOOP
 struct profile { int32 code; int32 count; bigtime_t time; };
 static profile sMessageProfile[AS_LAST_CODE];
@@ -2475,7 +2474,8 @@ fDesktop->LockSingleWindow();
 
 
 /*!	Dispatches all view drawing messages.
-	The desktop clipping must be read locked when entering this method.
+	The desktop clipping must be read locked, or the window's drawing lock
+	must be held when entering this method.
 	Requires a valid fCurrentView.
 */
 void
@@ -4186,6 +4186,7 @@ ServerWindow::_MessageLooper()
 		int32 messagesProcessed = 0;
 		bigtime_t processingStart = system_time();
 		bool lockedDesktopSingleWindow = false;
+		bool lockedWindowDrawing = false;
 
 		while (true) {
 			if (code == AS_DELETE_WINDOW || code == kMsgQuitLooper) {
@@ -4200,6 +4201,8 @@ ServerWindow::_MessageLooper()
 
 				if (lockedDesktopSingleWindow)
 					fDesktop->UnlockSingleWindow();
+				if (lockedWindowDrawing)
+					fWindow->UnlockDrawing();
 
 				quitLoop = true;
 
@@ -4211,15 +4214,42 @@ ServerWindow::_MessageLooper()
 
 			// Acquire the appropriate lock
 			bool needsAllWindowsLocked = _MessageNeedsAllWindowsLocked(code);
-			if (needsAllWindowsLocked) {
+			bool needsClippingLocked = _MessageNeedsClippingLocked(code);
+			bool onlyDraws = _MessageOnlyDraws(code)
+				&& atomic_get(&fRedrawRequested) == 0;
+
+			if (onlyDraws) {
+				// Drawing only needs to keep the Desktop from changing our
+				// clipping, so that other windows can be moved meanwhile.
+				if (lockedDesktopSingleWindow) {
+					fDesktop->UnlockSingleWindow();
+					lockedDesktopSingleWindow = false;
+				}
+				if (!lockedWindowDrawing) {
+					fWindow->LockDrawing();
+					lockedWindowDrawing = true;
+				}
+			} else {
+				// The Desktop might be waiting for us to stop drawing while
+				// holding its lock, so we must not wait for it in turn.
+				if (lockedWindowDrawing) {
+					fWindow->UnlockDrawing();
+					lockedWindowDrawing = false;
+				}
+			}
+
+			if (needsAllWindowsLocked || needsClippingLocked) {
 				// We may already still hold the read-lock from the previous
 				// inner-loop iteration.
 				if (lockedDesktopSingleWindow) {
 					fDesktop->UnlockSingleWindow();
 					lockedDesktopSingleWindow = false;
 				}
-				fDesktop->LockAllWindows();
-			} else {
+				if (needsAllWindowsLocked)
+					fDesktop->LockAllWindows();
+				else
+					fDesktop->LockClipping();
+			} else if (!onlyDraws) {
 				// We never keep the write-lock across inner-loop iterations,
 				// so there is nothing else to do besides read-locking unless
 				// we already have the read-lock from the previous iteration.
@@ -4229,7 +4259,7 @@ ServerWindow::_MessageLooper()
 				}
 			}
 
-			if (atomic_and(&fRedrawRequested, 0) != 0) {
+			if (!onlyDraws && atomic_and(&fRedrawRequested, 0) != 0) {
 #ifdef PROFILE_MESSAGE_LOOP
 				bigtime_t redrawStart = system_time();
 #endif
@@ -4268,6 +4298,8 @@ ServerWindow::_MessageLooper()
 
 			if (needsAllWindowsLocked)
 				fDesktop->UnlockAllWindows();
+			else if (needsClippingLocked)
+				fDesktop->UnlockClipping();
 
 			// Only process up to 70 waiting messages at once (we have the
 			// Desktop locked), but don't hold the lock longer than 10 ms
@@ -4275,6 +4307,8 @@ ServerWindow::_MessageLooper()
 				|| system_time() - processingStart > 10000) {
 				if (lockedDesktopSingleWindow)
 					fDesktop->UnlockSingleWindow();
+				if (lockedWindowDrawing)
+					fWindow->UnlockDrawing();
 				break;
 			}
 
@@ -4285,6 +4319,8 @@ ServerWindow::_MessageLooper()
 				printf("Someone deleted our message port!\n");
 				if (lockedDesktopSingleWindow)
 					fDesktop->UnlockSingleWindow();
+				if (lockedWindowDrawing)
+					fWindow->UnlockDrawing();
 
 				// try to let our client die happily
 				NotifyQuitRequested();
@@ -4347,6 +4383,11 @@ ServerWindow::HandleDirectConnection(int32 bufferState, int32 driverState)
 	STRACE(("HandleDirectConnection(bufferState = %" B_PRId32 ", driverState = "
 		"%" B_PRId32 ")\n", bufferState, driverState));
 
+	if ((bufferState & B_DIRECT_MODE_MASK) != B_DIRECT_STOP) {
+		// queued updates must not overwrite what the client draws directly
+		fDesktop->HWInterface()->FlushUpdates();
+	}
+
 	status_t status = fDirectWindowInfo->SetState(
 		(direct_buffer_state)bufferState, (direct_driver_state)driverState,
 		fDesktop->HWInterface()->FrontBuffer(), fWindow->Frame(),
@@ -4450,8 +4491,6 @@ ServerWindow::_MessageNeedsAllWindowsLocked(uint32 code) const
 		case AS_SET_FEEL:
 		case AS_SET_FLAGS:
 		case AS_SET_WORKSPACES:
-		case AS_WINDOW_MOVE:
-		case AS_WINDOW_RESIZE:
 		case AS_SET_SIZE_LIMITS:
 		case AS_SYSTEM_FONT_CHANGED:
 		case AS_SET_DECORATOR_SETTINGS:
@@ -4467,6 +4506,83 @@ ServerWindow::_MessageNeedsAllWindowsLocked(uint32 code) const
 }
 
 
+/*!	These only change the clipping of windows, and don't need to stop the
+	windows from drawing that aren't affected.
+*/
+bool
+ServerWindow::_MessageNeedsClippingLocked(uint32 code) const
+{
+	switch (code) {
+		case AS_WINDOW_MOVE:
+		case AS_WINDOW_RESIZE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+
+/*!	These only draw into the window, or change the drawing state of the
+	current view, and can be done while holding the window's drawing lock
+	instead of the Desktop's read lock.
+*/
+bool
+ServerWindow::_MessageOnlyDraws(uint32 code) const
+{
+	switch (code) {
+		case AS_SET_CURRENT_VIEW:
+
+		case AS_VIEW_SET_HIGH_COLOR:
+		case AS_VIEW_SET_LOW_COLOR:
+		case AS_VIEW_SET_PEN_LOC:
+		case AS_VIEW_SET_PEN_SIZE:
+		case AS_VIEW_SET_PATTERN:
+		case AS_VIEW_SET_DRAWING_MODE:
+		case AS_VIEW_SET_BLENDING_MODE:
+		case AS_VIEW_SET_LINE_MODE:
+
+		case AS_STROKE_LINE:
+		case AS_VIEW_INVERT_RECT:
+		case AS_STROKE_RECT:
+		case AS_FILL_RECT:
+		case AS_FILL_RECT_GRADIENT:
+		case AS_VIEW_DRAW_BITMAP:
+		case AS_STROKE_ARC:
+		case AS_FILL_ARC:
+		case AS_FILL_ARC_GRADIENT:
+		case AS_STROKE_BEZIER:
+		case AS_FILL_BEZIER:
+		case AS_FILL_BEZIER_GRADIENT:
+		case AS_STROKE_ELLIPSE:
+		case AS_FILL_ELLIPSE:
+		case AS_FILL_ELLIPSE_GRADIENT:
+		case AS_STROKE_ROUNDRECT:
+		case AS_FILL_ROUNDRECT:
+		case AS_FILL_ROUNDRECT_GRADIENT:
+		case AS_STROKE_TRIANGLE:
+		case AS_FILL_TRIANGLE:
+		case AS_FILL_TRIANGLE_GRADIENT:
+		case AS_STROKE_POLYGON:
+		case AS_FILL_POLYGON:
+		case AS_FILL_POLYGON_GRADIENT:
+		case AS_STROKE_SHAPE:
+		case AS_FILL_SHAPE:
+		case AS_FILL_SHAPE_GRADIENT:
+		case AS_FILL_REGION:
+		case AS_FILL_REGION_GRADIENT:
+		case AS_STROKE_LINEARRAY:
+		case AS_DRAW_STRING:
+		case AS_DRAW_STRING_WITH_DELTA:
+		case AS_DRAW_STRING_WITH_OFFSETS:
+		case AS_VIEW_DRAW_PICTURE:
+		case AS_VIEW_END_LAYER:
+			return true;
+		default:
+			return false;
+	}
+}
+
+
 void
 ServerWindow::_ResizeToFullScreen()
 {
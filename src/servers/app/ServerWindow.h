@@ -147,6 +147,9 @@ private:
 
 			bool				_MessageNeedsAllWindowsLocked(
 									uint32 code) const;
+			bool				_MessageNeedsClippingLocked(
+									uint32 code) const;
+			bool				_MessageOnlyDraws(uint32 code) const;
 
 private:
 			char*				fTitle;
@@ -94,6 +94,7 @@ Window::Window(const BRect& frame, const char *name,
 	fWindow(window),
 	fDrawingEngine(drawingEngine),
 	fDesktop(window->Desktop()),
+	fDrawingLock("window drawing"),
 
 	fCurrentUpdateSession(&fUpdateSessions[0]),
 	fPendingUpdateSession(&fUpdateSessions[1]),
@@ -195,10 +196,18 @@ Window::SetClipping(BRegion* stillAvailableOnScreen)
 	// this function is only called from the Desktop thread
 
 	// start from full region (as if the window was fully visible)
-	GetFullRegion(&fVisibleRegion);
+	BRegion visibleRegion;
+	GetFullRegion(&visibleRegion);
 	// clip to region still available on screen
-	fVisibleRegion.IntersectWith(stillAvailableOnScreen);
+	visibleRegion.IntersectWith(stillAvailableOnScreen);
 
+	// windows that are not affected can continue to draw
+	if (visibleRegion == fVisibleRegion)
+		return;
+
+	_BlockDrawing();
+
+	fVisibleRegion = visibleRegion;
 	fVisibleContentRegionValid = false;
 	fEffectiveDrawingRegionValid = false;
 }
@@ -282,6 +291,8 @@ Window::MoveBy(int32 x, int32 y, bool moveStack)
 	if (x == 0 && y == 0)
 		return;
 
+	_BlockDrawing();
+
 	fFrame.OffsetBy(x, y);
 	_PropagatePosition();
 
@@ -334,6 +345,8 @@ Window::ResizeBy(int32 x, int32 y, BRegion* dirtyRegion, bool resizeStack)
 {
 	// this function is only called from the desktop thread
 
+	_BlockDrawing();
+
 	int32 wantWidth = fFrame.IntegerWidth() + x;
 	int32 wantHeight = fFrame.IntegerHeight() + y;
 
@@ -398,6 +411,8 @@ Window::ResizeBy(int32 x, int32 y, BRegion* dirtyRegion, bool resizeStack)
 void
 Window::SetOutlinesDelta(BPoint delta, BRegion* dirtyRegion)
 {
+	_BlockDrawing();
+
 	float wantWidth = fFrame.IntegerWidth() + delta.x;
 	float wantHeight = fFrame.IntegerHeight() + delta.y;
 
@@ -746,6 +761,8 @@ Window::ProcessDirtyRegion(const BRegion& dirtyRegion, const BRegion& exposeRegi
 	// have the read lock and the desktop thread
 	// is blocking to get the write lock. IAW, this
 	// is only executed in one thread.
+	// The window thread doesn't look at the dirty region while it only holds
+	// the drawing lock, so there is no need to block its drawing here.
 	if (fDirtyRegion.CountRects() == 0) {
 		// the window needs to be informed
 		// when the dirty region was empty.
@@ -823,6 +840,8 @@ Window::MarkContentDirty(BRegion& dirtyRegion, BRegion& exposeRegion)
 	if (fHidden || IsOffscreenWindow())
 		return;
 
+	_BlockDrawing();
+
 	dirtyRegion.IntersectWith(&VisibleContentRegion());
 	exposeRegion.IntersectWith(&VisibleContentRegion());
 	_TriggerContentRedraw(dirtyRegion, exposeRegion);
@@ -836,6 +855,8 @@ Window::MarkContentDirtyAsync(BRegion& dirtyRegion)
 	if (fHidden || IsOffscreenWindow())
 		return;
 
+	_BlockDrawing();
+
 	dirtyRegion.IntersectWith(&VisibleContentRegion());
 
 	if (fDirtyRegion.CountRects() == 0) {
@@ -850,6 +871,8 @@ void
 Window::InvalidateView(View* view, BRegion& viewRegion)
 {
 	if (view && IsVisible() && view->IsVisible()) {
+		_BlockDrawing();
+
 		if (!fContentRegionValid)
 			_UpdateContentRegion();
 
@@ -870,6 +893,7 @@ Window::InvalidateView(View* view, BRegion& viewRegion)
 void
 Window::DisableUpdateRequests()
 {
+	_BlockDrawing();
 	fUpdatesEnabled = false;
 }
 
@@ -878,6 +902,7 @@ Window::DisableUpdateRequests()
 void
 Window::EnableUpdateRequests()
 {
+	_BlockDrawing();
 	fUpdatesEnabled = true;
 	if (!fUpdateRequested && fPendingUpdateSession->IsUsed())
 		_SendUpdateMessage();
@@ -907,6 +932,9 @@ Window::MouseDown(BMessage* message, BPoint where,
 	const ClickTarget& lastClickTarget, int32& clickCount,
 	ClickTarget& _clickTarget)
 {
+	// the window behaviour might draw the decorator right away
+	_BlockDrawing();
+
 	// If the previous click hit our decorator, get the hit region.
 	int32 windowToken = fWindow->ServerToken();
 	int32 lastHitRegion = 0;
@@ -971,6 +999,8 @@ Window::MouseDown(BMessage* message, BPoint where,
 void
 Window::MouseUp(BMessage* message, BPoint where, int32* _viewToken)
 {
+	_BlockDrawing();
+
 	fWindowBehaviour->MouseUp(message, where);
 
 	if (View* view = ViewAt(where)) {
@@ -995,6 +1025,8 @@ Window::MouseMoved(BMessage *message, BPoint where, int32* _viewToken,
 	if (!isLatestMouseMoved)
 		return;
 
+	_BlockDrawing();
+
 	fWindowBehaviour->MouseMoved(message, where, isFake);
 
 	// mouse cursor
@@ -1012,6 +1044,7 @@ Window::MouseMoved(BMessage *message, BPoint where, int32* _viewToken,
 void
 Window::ModifiersChanged(int32 modifiers)
 {
+	_BlockDrawing();
 	fWindowBehaviour->ModifiersChanged(modifiers);
 }
 
@@ -1107,6 +1140,7 @@ Window::SetHidden(bool hidden)
 {
 	// the desktop takes care of dirty regions
 	if (fHidden != hidden) {
+		_BlockDrawing();
 		fHidden = hidden;
 
 		fTopView->SetHidden(hidden);
@@ -1122,6 +1156,7 @@ Window::SetShowLevel(int32 showLevel)
 	if (showLevel == fShowLevel)
 		return;
 
+	_BlockDrawing();
 	fShowLevel = showLevel;
 }
 
@@ -1132,10 +1167,22 @@ Window::SetMinimized(bool minimized)
 	if (minimized == fMinimized)
 		return;
 
+	_BlockDrawing();
 	fMinimized = minimized;
 }
 
 
+void
+Window::SetCurrentWorkspace(int32 index)
+{
+	if (index == fCurrentWorkspace)
+		return;
+
+	_BlockDrawing();
+	fCurrentWorkspace = index;
+}
+
+
 bool
 Window::IsVisible() const
 {
@@ -2013,6 +2060,18 @@ Window::_UpdateContentRegion()
 }
 
 
+/*!	Must be called before anything that the ServerWindow might be using while
+	drawing is changed from another thread. Does nothing unless the caller has
+	write locked the clipping.
+*/
+void
+Window::_BlockDrawing()
+{
+	if (fDesktop != NULL)
+		fDesktop->BlockDrawing(this);
+}
+
+
 void
 Window::_ObeySizeLimits()
 {
@@ -22,6 +22,7 @@
 #include "WindowList.h"
 
 #include <AutoDeleter.h>
+#include <Locker.h>
 #include <ObjectList.h>
 #include <Referenceable.h>
 #include <Region.h>
@@ -114,7 +115,7 @@ public:
 			// setting and getting the "hard" clipping, you need to have
 			// WriteLock()ed the clipping!
 			void				SetClipping(BRegion* stillAvailableOnScreen);
-			// you need to have ReadLock()ed the clipping!
+			// you need to have ReadLock()ed the clipping, or locked the drawing!
 	inline	BRegion&			VisibleRegion() { return fVisibleRegion; }
 			BRegion&			VisibleContentRegion();
 
@@ -174,6 +175,13 @@ public:
 			DrawingEngine*		GetDrawingEngine() const
 									{ return fDrawingEngine.Get(); }
 
+			// held by the ServerWindow while it draws without the clipping
+			// being read locked, see Desktop::BlockDrawing()
+			bool				LockDrawing() { return fDrawingLock.Lock(); }
+			void				UnlockDrawing() { fDrawingLock.Unlock(); }
+			bool				IsDrawingLocked() const
+									{ return fDrawingLock.IsLocked(); }
+
 			// managing a region pool
 			::RegionPool*		RegionPool()
 									{ return &fRegionPool; }
@@ -221,8 +229,7 @@ public:
 			void				SetMinimized(bool minimized);
 	inline	bool				IsMinimized() const { return fMinimized; }
 
-			void				SetCurrentWorkspace(int32 index)
-									{ fCurrentWorkspace = index; }
+			void				SetCurrentWorkspace(int32 index);
 			int32				CurrentWorkspace() const
 									{ return fCurrentWorkspace; }
 			bool				IsVisible() const;
@@ -332,6 +339,8 @@ protected:
 
 			void				_UpdateContentRegion();
 
+			void				_BlockDrawing();
+
 			void				_ObeySizeLimits();
 			void				_PropagatePosition();
 
@@ -381,6 +390,7 @@ protected:
 			ObjectDeleter<DrawingEngine>
 								fDrawingEngine;
 			::Desktop*			fDesktop;
+			BLocker				fDrawingLock;
 
 			// The synchronization, which client drawing commands
 			// belong to the redraw of which dirty region is handled
@@ -21,6 +21,7 @@
 #include "DrawingEngine.h"
 #include "RenderingBuffer.h"
 #include "SystemPalette.h"
+#include "UpdateQueue.h"
 
 
 using std::nothrow;
@@ -290,6 +291,11 @@ HWInterface::DrawingBuffer() const
 status_t
 HWInterface::InvalidateRegion(const BRegion& region)
 {
+	if (fUpdateQueue.IsSet() && IsDoubleBuffered()) {
+		fUpdateQueue->AddRegion(region);
+		return B_OK;
+	}
+
 	int32 count = region.CountRects();
 	for (int32 i = 0; i < count; i++) {
 		status_t result = Invalidate(region.RectAt(i));
@@ -352,6 +358,50 @@ HWInterface::CopyBackToFront(const BRect& frame)
 }
 
 
+/*!	Copies the regions passed to InvalidateRegion() that are waiting for the
+	next frame to the front buffer right away. The caller must not hold the
+	parallel access lock.
+*/
+void
+HWInterface::FlushUpdates()
+{
+	if (fUpdateQueue.IsSet())
+		fUpdateQueue->Flush();
+}
+
+
+/*!	From now on, InvalidateRegion() only queues the regions, and they are
+	copied to the front buffer in one go once per frame.
+*/
+status_t
+HWInterface::_StartUpdateQueue()
+{
+	if (fUpdateQueue.IsSet())
+		return B_OK;
+
+	fUpdateQueue.SetTo(new(nothrow) UpdateQueue(this));
+	if (!fUpdateQueue.IsSet())
+		return B_NO_MEMORY;
+
+	status_t status = fUpdateQueue->InitCheck();
+	if (status != B_OK)
+		fUpdateQueue.Unset();
+
+	return status;
+}
+
+
+/*!	Copies what is still queued, and waits for the UpdateQueue thread to
+	quit. The caller must not hold the parallel access lock.
+*/
+void
+HWInterface::_StopUpdateQueue()
+{
+	FlushUpdates();
+	fUpdateQueue.Unset();
+}
+
+
 void
 HWInterface::_CopyBackToFront(/*const*/ BRegion& region)
 {
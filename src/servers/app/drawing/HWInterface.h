@@ -150,10 +150,17 @@ public:
 	// while as CopyBackToFront() actually performs the operation
 	// either directly or asynchronously by the UpdateQueue thread
 	virtual	status_t			CopyBackToFront(const BRect& frame);
+	// copies the regions that are still queued right away
+			void				FlushUpdates();
 
 protected:
 	virtual	void				_CopyBackToFront(/*const*/ BRegion& region);
 
+	// derived classes that are double buffered may start the UpdateQueue
+	// once they are initialized, and must stop it before they shut down
+			status_t			_StartUpdateQueue();
+			void				_StopUpdateQueue();
+
 public:
 	// TODO: Just a quick and primitive way to get single buffered mode working.
 	// Later, the implementation should be smarter, right now, it will
@@ -248,7 +255,11 @@ protected:
 			int					fVGADevice;
 
 private:
+	friend class UpdateQueue;
+
 			BList				fListeners;
+			ObjectDeleter<UpdateQueue>
+								fUpdateQueue;
 };
 
 #endif // HW_INTERFACE_H
@@ -54,6 +54,7 @@
 
 #include "AlphaMask.h"
 #include "BitmapPainter.h"
+#include "BlendKernels.h"
 #include "DrawingMode.h"
 #include "GlobalSubpixelSettings.h"
 #include "PatternHandler.h"
@@ -61,6 +62,8 @@
 #include "ServerBitmap.h"
 #include "ServerFont.h"
 #include "SystemPalette.h"
+#include "TileFunctions.h"
+#include "TiledRenderer.h"
 
 #include "AppServer.h"
 
@@ -104,11 +107,14 @@ using std::nothrow;
 #define fClippedAlphaMask		fInternal.fClippedAlphaMask
 #define fPath					fInternal.fPath
 #define fCurve					fInternal.fCurve
+#define fTiledPath				fInternal.fTiledPath
 
 
 static uint32 detect_simd();
+static const blend_kernels* select_blend_kernels();
 
 uint32 gSIMDFlags = detect_simd();
+const blend_kernels* gBlendKernels = select_blend_kernels();
 
 
 /*!	Detect SIMD flags for use in AppServer. Checks all CPUs in the system
@@ -117,7 +123,7 @@ uint32 gSIMDFlags = detect_simd();
 static uint32
 detect_simd()
 {
-#if __i386__
+#if defined(__i386__) || defined(__x86_64__)
 	// Only scan CPUs for which we are certain the SIMD flags are properly
 	// defined.
 	const char* vendorNames[] = {
@@ -152,16 +158,43 @@ detect_simd()
 			if (strcmp(vendor, vendorNames[i]) == 0)
 				vendorFound = true;
 		}
+#ifdef __x86_64__
+		// all of them report their features the same way
+		vendorFound = true;
+#endif
 
 		uint32 cpuSIMD = 0;
 		uint32 maxStdFunc = cpuInfo.regs.eax;
 		if (vendorFound && maxStdFunc >= 1) {
 			get_cpuid(&cpuInfo, 1, 0);
 			uint32 edx = cpuInfo.regs.edx;
+#ifdef __i386__
+			// the MMX/SSE bilinear scaler is only built for x86
 			if (edx & (1 << 23))
 				cpuSIMD |= APPSERVER_SIMD_MMX;
 			if (edx & (1 << 25))
 				cpuSIMD |= APPSERVER_SIMD_SSE;
+#endif
+			if (edx & (1 << 26))
+				cpuSIMD |= APPSERVER_SIMD_SSE2;
+
+#if APPSERVER_SIMD_DRAWING_MODES
+			// AVX2 also needs the OS to save the AVX registers (OSXSAVE
+			// and AVX set, and XCR0 enabling the SSE and AVX state)
+			uint32 ecx = cpuInfo.regs.ecx;
+			if (maxStdFunc >= 7 && (ecx & (1 << 27)) != 0
+				&& (ecx & (1 << 28)) != 0) {
+				uint32 xcr0Low, xcr0High;
+				asm volatile("xgetbv" : "=a" (xcr0Low), "=d" (xcr0High)
+					: "c" (0));
+
+				get_cpuid(&cpuInfo, 7, 0);
+				if ((xcr0Low & 0x6) == 0x6
+					&& (cpuInfo.regs.ebx & (1 << 5)) != 0) {
+					cpuSIMD |= APPSERVER_SIMD_AVX2;
+				}
+			}
+#endif
 		} else {
 			// no flags can be identified
 			cpuSIMD = 0;
@@ -169,12 +202,28 @@ detect_simd()
 		systemSIMD &= cpuSIMD;
 	}
 	return systemSIMD;
-#else	// !__i386__
+#else	// !__i386__ && !__x86_64__
 	return 0;
 #endif
 }
 
 
+/*!	Chooses the widest blend kernels that all CPUs support, or none, if
+	there are only the scalar drawing modes.
+*/
+static const blend_kernels*
+select_blend_kernels()
+{
+#if APPSERVER_SIMD_DRAWING_MODES
+	if ((gSIMDFlags & APPSERVER_SIMD_AVX2) != 0)
+		return &gBlendKernelsAVX2;
+	if ((gSIMDFlags & APPSERVER_SIMD_SSE2) != 0)
+		return &gBlendKernelsSSE2;
+#endif
+	return NULL;
+}
+
+
 // Gradients and strings don't use patterns, but we want the special handling
 // we have for solid patterns in certain modes to get the expected results for
 // border antialiasing.
@@ -207,6 +256,7 @@ Painter::Painter()
 	fSubpixelPrecise(false),
 	fValidClipping(false),
 	fAttached(false),
+	fTiledRendering(true),
 
 	fPenSize(1.0),
 	fClippingRegion(NULL),
@@ -216,6 +266,7 @@ Painter::Painter()
 	fLineCapMode(B_BUTT_CAP),
 	fLineJoinMode(B_MITER_JOIN),
 	fMiterLimit(B_DEFAULT_MITER_LIMIT),
+	fFillingRule(agg::fill_non_zero),
 
 	fPatternHandler(),
 	fTextRenderer(fSubpixRenderer, fRenderer, fRendererBin, fUnpackedScanline,
@@ -450,11 +501,11 @@ Painter::SetStrokeMode(cap_mode lineCap, join_mode joinMode, float miterLimit)
 void
 Painter::SetFillRule(int32 fillRule)
 {
-	agg::filling_rule_e aggFillRule = fillRule == B_EVEN_ODD
+	fFillingRule = fillRule == B_EVEN_ODD
 		? agg::fill_even_odd : agg::fill_non_zero;
 
-	fRasterizer.filling_rule(aggFillRule);
-	fSubpixRasterizer.filling_rule(aggFillRule);
+	fRasterizer.filling_rule(fFillingRule);
+	fSubpixRasterizer.filling_rule(fFillingRule);
 }
 
 
@@ -1513,6 +1564,13 @@ Painter::SetRendererOffset(int32 offsetX, int32 offsetY)
 }
 
 
+void
+Painter::SetTiledRendering(bool enabled)
+{
+	fTiledRendering = enabled;
+}
+
+
 // #pragma mark - private
 
 
@@ -1568,6 +1626,23 @@ Painter::_Clipped(const BRect& rect) const
 }
 
 
+/*!	Returns the renderer to render a primitive with the given (clipped)
+	bounds in tiles, or \c NULL if it should be rendered right away.
+*/
+TiledRenderer*
+Painter::_TiledRendererFor(const BRect& bounds) const
+{
+	if (!fTiledRendering)
+		return NULL;
+
+	TiledRenderer* renderer = TiledRenderer::Default();
+	if (renderer == NULL || !renderer->IsWorthwhile(bounds))
+		return NULL;
+
+	return renderer;
+}
+
+
 // _UpdateDrawingMode
 void
 Painter::_UpdateDrawingMode()
@@ -1850,6 +1925,22 @@ template<class VertexSource>
 BRect
 Painter::_RasterizePath(VertexSource& path) const
 {
+	BRect bounds = _Clipped(_BoundingBox(path));
+
+	TiledRenderer* tiledRenderer = _TiledRendererFor(bounds);
+	if (tiledRenderer != NULL) {
+		fTiledPath.remove_all();
+		fTiledPath.concat_path(path);
+
+		SolidTileFunction function(fTiledPath, fBaseRenderer, fRenderer.color(),
+			fFillingRule, fMaskedUnpackedScanline != NULL
+				? fClippedAlphaMask : NULL, gSubpixelAntialiasing);
+		if (tiledRenderer->Render(bounds, fClippingRegion->FrameInt(),
+				function)) {
+			return bounds;
+		}
+	}
+
 	if (fMaskedUnpackedScanline != NULL) {
 		// TODO: we can't do both alpha-masking and subpixel AA.
 		fRasterizer.reset();
@@ -1867,7 +1958,7 @@ Painter::_RasterizePath(VertexSource& path) const
 		agg::render_scanlines(fRasterizer, fPackedScanline, fRenderer);
 	}
 
-	return _Clipped(_BoundingBox(path));
+	return bounds;
 }
 
 
@@ -2123,6 +2214,23 @@ Painter::_RasterizePath(VertexSource& path, const BGradient& gradient,
 
 	_MakeGradient(colorArray, gradient);
 
+	BRect bounds = _Clipped(_BoundingBox(path));
+
+	TiledRenderer* tiledRenderer = _TiledRendererFor(bounds);
+	if (tiledRenderer != NULL) {
+		fTiledPath.remove_all();
+		fTiledPath.concat_path(path);
+
+		GradientTileFunction<GradientFunction, color_array_type> tileFunction(
+			fTiledPath, fBaseRenderer, fFillingRule,
+			fMaskedUnpackedScanline != NULL ? fClippedAlphaMask : NULL,
+			gradientTransform, function, colorArray, gradientStop);
+		if (tiledRenderer->Render(bounds, fClippingRegion->FrameInt(),
+				tileFunction)) {
+			return;
+		}
+	}
+
 	span_gradient_type spanGradient(spanInterpolator, function, colorArray,
 		0, gradientStop);
 
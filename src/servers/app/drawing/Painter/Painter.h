@@ -41,11 +41,14 @@ class FontCacheReference;
 class RenderingBuffer;
 class ServerBitmap;
 class ServerFont;
+class TiledRenderer;
 
 
 // Defines for SIMD support.
 #define APPSERVER_SIMD_MMX	(1 << 0)
 #define APPSERVER_SIMD_SSE	(1 << 1)
+#define APPSERVER_SIMD_SSE2	(1 << 2)
+#define APPSERVER_SIMD_AVX2	(1 << 3)
 
 
 class Painter {
@@ -252,6 +255,11 @@ public:
 			void				SetRendererOffset(int32 offsetX,
 									int32 offsetY);
 
+								// large primitives are rendered on all CPUs
+			void				SetTiledRendering(bool enabled);
+	inline	bool				TiledRendering() const
+									{ return fTiledRendering; }
+
 private:
 			float				_Align(float coord, bool round,
 									bool centerOffset) const;
@@ -278,6 +286,8 @@ private:
 									const BPoint& viewToScreenOffset,
 									float viewScale) const;
 
+			TiledRenderer*		_TiledRendererFor(const BRect& bounds) const;
+
 			void				_InvertRect32(BRect r) const;
 			void				_BlendRect32(const BRect& r,
 									const rgb_color& c) const;
@@ -336,6 +346,7 @@ private:
 			bool				fValidClipping : 1;
 			bool				fAttached : 1;
 			bool				fIdentityTransform : 1;
+			bool				fTiledRendering : 1;
 
 			Transformable		fTransform;
 			float				fPenSize;
@@ -346,6 +357,7 @@ private:
 			cap_mode			fLineCapMode;
 			join_mode			fLineJoinMode;
 			float				fMiterLimit;
+			agg::filling_rule_e	fFillingRule;
 
 			PatternHandler		fPatternHandler;
 
@@ -31,7 +31,8 @@ struct PainterAggInterface {
 		fMaskedUnpackedScanline(NULL),
 		fClippedAlphaMask(NULL),
 		fPath(),
-		fCurve(fPath)
+		fCurve(fPath),
+		fTiledPath()
 	{
 	}
 
@@ -63,6 +64,9 @@ struct PainterAggInterface {
 
 	agg::path_storage		fPath;
 	agg::conv_curve<agg::path_storage> fCurve;
+
+	// a copy of the path that is rendered in tiles, see TiledRenderer
+	agg::path_storage		fTiledPath;
 };
 
 
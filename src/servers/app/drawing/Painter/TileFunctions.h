@@ -0,0 +1,137 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TILE_FUNCTIONS_H
+#define TILE_FUNCTIONS_H
+
+
+#include <agg_span_gradient.h>
+#include <agg_span_interpolator_linear.h>
+
+#include "TiledRenderer.h"
+
+
+/*!	Renders a recorded path in a solid color, like Painter::_RasterizePath()
+	does, but only within a tile.
+*/
+class SolidTileFunction {
+public:
+	SolidTileFunction(const agg::path_storage& path,
+		renderer_base& baseRenderer, const agg::rgba8& color,
+		agg::filling_rule_e fillingRule, agg::clipped_alpha_mask* alphaMask,
+		bool subpixelAntialiasing)
+		:
+		fPath(path),
+		fBaseRenderer(baseRenderer),
+		fColor(color),
+		fFillingRule(fillingRule),
+		fAlphaMask(alphaMask),
+		fSubpixelAntialiasing(subpixelAntialiasing)
+	{
+	}
+
+	void operator()(TileContext& context, const clipping_rect& tile) const
+	{
+		renderer_base baseRenderer(fBaseRenderer.ren());
+		baseRenderer.copy_clipping_from(fBaseRenderer);
+
+		if (fAlphaMask != NULL) {
+			scanline_unpacked_masked_type scanline(*fAlphaMask);
+			renderer_type renderer(baseRenderer);
+			renderer.color(fColor);
+
+			rasterize_tile(context.rasterizer, fPath, tile, fFillingRule);
+			agg::render_scanlines(context.rasterizer, scanline, renderer);
+		} else if (fSubpixelAntialiasing) {
+			renderer_subpix_type renderer(baseRenderer);
+			renderer.color(fColor);
+
+			rasterize_tile(context.subpixRasterizer, fPath, tile,
+				fFillingRule);
+			agg::render_scanlines(context.subpixRasterizer,
+				context.subpixPackedScanline, renderer);
+		} else {
+			renderer_type renderer(baseRenderer);
+			renderer.color(fColor);
+
+			rasterize_tile(context.rasterizer, fPath, tile, fFillingRule);
+			agg::render_scanlines(context.rasterizer, context.packedScanline,
+				renderer);
+		}
+	}
+
+private:
+	const agg::path_storage&	fPath;
+	renderer_base&				fBaseRenderer;
+	agg::rgba8					fColor;
+	agg::filling_rule_e			fFillingRule;
+	agg::clipped_alpha_mask*	fAlphaMask;
+	bool						fSubpixelAntialiasing;
+};
+
+
+/*!	Renders a recorded path with a gradient within a tile. */
+template<class GradientFunction, class ColorArray>
+class GradientTileFunction {
+public:
+	GradientTileFunction(const agg::path_storage& path,
+		renderer_base& baseRenderer, agg::filling_rule_e fillingRule,
+		agg::clipped_alpha_mask* alphaMask,
+		const agg::trans_affine& gradientTransform,
+		const GradientFunction& function, const ColorArray& colors,
+		int gradientStop)
+		:
+		fPath(path),
+		fBaseRenderer(baseRenderer),
+		fFillingRule(fillingRule),
+		fAlphaMask(alphaMask),
+		fGradientTransform(gradientTransform),
+		fFunction(function),
+		fColors(colors),
+		fGradientStop(gradientStop)
+	{
+	}
+
+	void operator()(TileContext& context, const clipping_rect& tile) const
+	{
+		typedef agg::span_interpolator_linear<> interpolator_type;
+		typedef agg::span_allocator<agg::rgba8> span_allocator_type;
+		typedef agg::span_gradient<agg::rgba8, interpolator_type,
+					GradientFunction, ColorArray> span_gradient_type;
+		typedef agg::renderer_scanline_aa<renderer_base, span_allocator_type,
+					span_gradient_type> renderer_gradient_type;
+
+		renderer_base baseRenderer(fBaseRenderer.ren());
+		baseRenderer.copy_clipping_from(fBaseRenderer);
+		// the interpolator keeps its position, every tile needs its own
+		interpolator_type spanInterpolator(fGradientTransform);
+		span_gradient_type spanGradient(spanInterpolator, fFunction, fColors,
+			0, fGradientStop);
+		renderer_gradient_type gradientRenderer(baseRenderer,
+			context.spanAllocator, spanGradient);
+
+		rasterize_tile(context.rasterizer, fPath, tile, fFillingRule);
+		if (fAlphaMask == NULL) {
+			agg::render_scanlines(context.rasterizer, context.unpackedScanline,
+				gradientRenderer);
+		} else {
+			scanline_unpacked_masked_type scanline(*fAlphaMask);
+			agg::render_scanlines(context.rasterizer, scanline,
+				gradientRenderer);
+		}
+	}
+
+private:
+	const agg::path_storage&	fPath;
+	renderer_base&				fBaseRenderer;
+	agg::filling_rule_e			fFillingRule;
+	agg::clipped_alpha_mask*	fAlphaMask;
+	const agg::trans_affine&	fGradientTransform;
+	const GradientFunction&		fFunction;
+	const ColorArray&			fColors;
+	int							fGradientStop;
+};
+
+
+#endif	// TILE_FUNCTIONS_H
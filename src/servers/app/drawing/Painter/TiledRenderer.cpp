@@ -0,0 +1,166 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "TiledRenderer.h"
+
+#include <new>
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+
+
+static const int32 kMaxThreads = 16;
+
+// Primitives covering less pixels are rendered by the calling thread alone,
+// waking up the other threads would take longer than rendering them.
+static const int32 kMinTiledArea = 256 * 256;
+
+// Tiles are kept small enough that threads which are done with theirs can
+// take over some of the others, if the primitive is not evenly distributed.
+static const int32 kTilesPerThread = 4;
+static const int32 kMinTileHeight = 16;
+
+static TiledRenderer* sDefaultRenderer;
+static pthread_once_t sDefaultRendererInitOnce = PTHREAD_ONCE_INIT;
+
+
+TiledRenderer::TiledRenderer()
+	:
+	fLock("tiled renderer"),
+	fThreadCount(1),
+	fContexts(NULL),
+	fStartSemaphore(-1),
+	fDoneSemaphore(-1),
+	fNextContext(1)
+{
+	system_info info;
+	if (get_system_info(&info) != B_OK || info.cpu_count < 2)
+		return;
+
+	int32 threadCount = min_c((int32)info.cpu_count, kMaxThreads);
+
+	fContexts = new(std::nothrow) TileContext[threadCount];
+	fStartSemaphore = create_sem(0, "tiled renderer start");
+	fDoneSemaphore = create_sem(0, "tiled renderer done");
+	if (fContexts == NULL || fStartSemaphore < 0 || fDoneSemaphore < 0)
+		return;
+
+	// the calling thread renders tiles, too
+	for (int32 i = 1; i < threadCount; i++) {
+		char name[B_OS_NAME_LENGTH];
+		snprintf(name, sizeof(name), "tiled renderer %" B_PRId32, i);
+
+		thread_id thread = spawn_thread(&_WorkerThread, name,
+			B_DISPLAY_PRIORITY, this);
+		if (thread < 0)
+			break;
+
+		resume_thread(thread);
+		fThreadCount++;
+	}
+}
+
+
+/*static*/ TiledRenderer*
+TiledRenderer::Default()
+{
+	pthread_once(&sDefaultRendererInitOnce, &_InitDefault);
+	return sDefaultRenderer;
+}
+
+
+bool
+TiledRenderer::IsWorthwhile(const BRect& bounds) const
+{
+	if (fThreadCount < 2 || !bounds.IsValid())
+		return false;
+
+	return (bounds.Width() + 1) * (bounds.Height() + 1) >= kMinTiledArea;
+}
+
+
+bool
+TiledRenderer::_Render(const BRect& bounds, const clipping_rect& clip,
+	tile_hook hook, void* cookie)
+{
+	if (!IsWorthwhile(bounds))
+		return false;
+
+	// Anti-aliasing touches every row the primitive reaches into; the
+	// columns are left to the clipping, like for the serial rasterizer.
+	clipping_rect tiledBounds = clip;
+	tiledBounds.top = max_c(clip.top, (int32)floorf(bounds.top));
+	tiledBounds.bottom = min_c(clip.bottom, (int32)floorf(bounds.bottom));
+
+	int32 height = tiledBounds.bottom - tiledBounds.top + 1;
+	int32 tileCount = min_c(fThreadCount * kTilesPerThread,
+		height / kMinTileHeight);
+	if (tileCount < 2)
+		return false;
+
+	// Don't wait for another window to finish its primitive, rendering this
+	// one alone is faster than that.
+	if (fLock.LockWithTimeout(0) != B_OK)
+		return false;
+
+	fHook = hook;
+	fCookie = cookie;
+	fBounds = tiledBounds;
+	fTileHeight = (height + tileCount - 1) / tileCount;
+	fTileCount = (height + fTileHeight - 1) / fTileHeight;
+	fNextTile = 0;
+
+	int32 workerCount = min_c(fThreadCount, fTileCount) - 1;
+	release_sem_etc(fStartSemaphore, workerCount, B_DO_NOT_RESCHEDULE);
+
+	_RenderTiles(fContexts[0]);
+
+	acquire_sem_etc(fDoneSemaphore, workerCount, 0, 0);
+
+	fLock.Unlock();
+	return true;
+}
+
+
+void
+TiledRenderer::_RenderTiles(TileContext& context)
+{
+	while (true) {
+		int32 tile = atomic_add(&fNextTile, 1);
+		if (tile >= fTileCount)
+			return;
+
+		clipping_rect rect = fBounds;
+		rect.top = fBounds.top + tile * fTileHeight;
+		rect.bottom = min_c(rect.top + fTileHeight - 1, fBounds.bottom);
+
+		fHook(fCookie, context, rect);
+	}
+}
+
+
+/*static*/ void
+TiledRenderer::_InitDefault()
+{
+	sDefaultRenderer = new(std::nothrow) TiledRenderer;
+}
+
+
+/*static*/ status_t
+TiledRenderer::_WorkerThread(void* data)
+{
+	TiledRenderer* renderer = (TiledRenderer*)data;
+	TileContext& context
+		= renderer->fContexts[atomic_add(&renderer->fNextContext, 1)];
+
+	while (acquire_sem(renderer->fStartSemaphore) == B_OK) {
+		renderer->_RenderTiles(context);
+		release_sem_etc(renderer->fDoneSemaphore, 1, B_DO_NOT_RESCHEDULE);
+	}
+
+	return B_OK;
+}
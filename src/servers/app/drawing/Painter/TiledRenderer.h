@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TILED_RENDERER_H
+#define TILED_RENDERER_H
+
+
+#include <Locker.h>
+#include <OS.h>
+#include <Rect.h>
+#include <Region.h>
+
+#include <agg_path_storage.h>
+#include <agg_span_allocator.h>
+
+#include "defines.h"
+
+
+/*!	The rasterizers and scanlines one thread renders its tiles with. They are
+	kept around, so that their cell and span buffers are reused.
+*/
+struct TileContext {
+	rasterizer_type					rasterizer;
+	rasterizer_subpix_type			subpixRasterizer;
+	scanline_packed_type			packedScanline;
+	scanline_unpacked_type			unpackedScanline;
+	scanline_packed_subpix_type		subpixPackedScanline;
+	agg::span_allocator<agg::rgba8>	spanAllocator;
+};
+
+
+/*!	Iterates over a path without changing it, so that several threads can
+	add the same path to their rasterizers at once.
+*/
+class PathReader {
+public:
+	PathReader(const agg::path_storage& path)
+		:
+		fPath(path),
+		fIndex(0)
+	{
+	}
+
+	void rewind(unsigned)
+	{
+		fIndex = 0;
+	}
+
+	unsigned vertex(double* x, double* y)
+	{
+		if (fIndex >= fPath.total_vertices())
+			return agg::path_cmd_stop;
+		return fPath.vertex(fIndex++, x, y);
+	}
+
+private:
+	const agg::path_storage&	fPath;
+	unsigned					fIndex;
+};
+
+
+/*!	Splits large primitives into horizontal tiles, and rasterizes them on
+	all CPUs at once. The calling thread renders tiles as well.
+
+	A tile function is called as function(TileContext&, const clipping_rect&)
+	for every tile; it has to rasterize the primitive clipped to the tile, and
+	must not touch any pixels outside of it. Only one primitive is rendered at
+	a time; when the threads are busy with another one, Render() returns false
+	right away, and the caller has to render the primitive itself.
+*/
+class TiledRenderer {
+public:
+	static	TiledRenderer*		Default();
+
+			int32				CountThreads() const
+									{ return fThreadCount; }
+
+			bool				IsWorthwhile(const BRect& bounds) const;
+
+			template<class TileFunction>
+			bool				Render(const BRect& bounds,
+									const clipping_rect& clip,
+									TileFunction& function);
+
+private:
+			typedef void (*tile_hook)(void* cookie, TileContext& context,
+				const clipping_rect& tile);
+
+								TiledRenderer();
+
+			bool				_Render(const BRect& bounds,
+									const clipping_rect& clip, tile_hook hook,
+									void* cookie);
+			void				_RenderTiles(TileContext& context);
+
+	template<class TileFunction>
+	static	void				_CallTileFunction(void* cookie,
+									TileContext& context,
+									const clipping_rect& tile);
+
+	static	void				_InitDefault();
+	static	status_t			_WorkerThread(void* data);
+
+private:
+			BLocker				fLock;
+			int32				fThreadCount;
+			TileContext*		fContexts;
+			sem_id				fStartSemaphore;
+			sem_id				fDoneSemaphore;
+			int32				fNextContext;
+
+			// the primitive being rendered
+			tile_hook			fHook;
+			void*				fCookie;
+			clipping_rect		fBounds;
+			int32				fTileHeight;
+			int32				fTileCount;
+			int32				fNextTile;
+};
+
+
+template<class TileFunction>
+bool
+TiledRenderer::Render(const BRect& bounds, const clipping_rect& clip,
+	TileFunction& function)
+{
+	return _Render(bounds, clip, &_CallTileFunction<TileFunction>, &function);
+}
+
+
+template<class TileFunction>
+/*static*/ void
+TiledRenderer::_CallTileFunction(void* cookie, TileContext& context,
+	const clipping_rect& tile)
+{
+	(*(TileFunction*)cookie)(context, tile);
+}
+
+
+/*!	Prepares \a rasterizer to render the part of \a path within \a tile. */
+template<class Rasterizer>
+static inline void
+rasterize_tile(Rasterizer& rasterizer, const agg::path_storage& path,
+	const clipping_rect& tile, agg::filling_rule_e fillingRule)
+{
+	rasterizer.reset();
+	rasterizer.filling_rule(fillingRule);
+	rasterizer.clip_box(tile.left, tile.top, tile.right + 1, tile.bottom + 1);
+
+	PathReader reader(path);
+	rasterizer.add_path(reader);
+}
+
+
+#endif	// TILED_RENDERER_H
@@ -135,6 +135,18 @@ namespace agg
 			}
 		}
 
+		//--------------------------------------------------------------------
+		// Takes over the clipping and offset of another renderer, so that
+		// several threads can render into the same buffer at once.
+		void copy_clipping_from(const renderer_region<PixelFormat>& other)
+		{
+			m_region = other.m_region;
+			m_curr_cb = 0;
+			m_bounds = other.m_bounds;
+			m_offset_x = other.m_offset_x;
+			m_offset_y = other.m_offset_y;
+		}
+
 		//--------------------------------------------------------------------
 		void set_offset(int offset_x, int offset_y)
 		{
@@ -8,7 +8,10 @@
 #ifndef DRAW_BITMAP_GENERIC_H
 #define DRAW_BITMAP_GENERIC_H
 
+#include <agg_bounding_rect.h>
+
 #include "Painter.h"
+#include "TiledRenderer.h"
 
 
 struct Fill {};
@@ -29,6 +32,55 @@ struct ImageAccessor<PixFmt, Tile> {
 };
 
 
+/*!	Renders the part of a bitmap within a tile. */
+template<typename SourceType, typename SpanGenerator>
+struct BitmapTileFunction {
+	typedef typename SourceType::pixfmt_type pixfmt_image;
+	typedef agg::span_interpolator_linear<> interpolator_type;
+
+	BitmapTileFunction(const agg::path_storage& path,
+		renderer_base& baseRenderer, agg::clipped_alpha_mask* alphaMask,
+		const pixfmt_image& image, const agg::trans_affine& imageMatrix)
+		:
+		fPath(path),
+		fBaseRenderer(baseRenderer),
+		fAlphaMask(alphaMask),
+		fImage(image),
+		fImageMatrix(imageMatrix)
+	{
+	}
+
+	void operator()(TileContext& context, const clipping_rect& tile) const
+	{
+		renderer_base baseRenderer(fBaseRenderer.ren());
+		baseRenderer.copy_clipping_from(fBaseRenderer);
+
+		// the image accessor and the interpolator keep their position
+		SourceType source(fImage);
+		interpolator_type interpolator(fImageMatrix);
+		SpanGenerator spanGenerator(source, interpolator);
+
+		rasterize_tile(context.rasterizer, fPath, tile, agg::fill_non_zero);
+		if (fAlphaMask == NULL) {
+			agg::render_scanlines_aa(context.rasterizer,
+				context.unpackedScanline, baseRenderer, context.spanAllocator,
+				spanGenerator);
+		} else {
+			scanline_unpacked_masked_type scanline(*fAlphaMask);
+			agg::render_scanlines_aa(context.rasterizer, scanline,
+				baseRenderer, context.spanAllocator, spanGenerator);
+		}
+	}
+
+private:
+	const agg::path_storage&	fPath;
+	renderer_base&				fBaseRenderer;
+	agg::clipped_alpha_mask*	fAlphaMask;
+	const pixfmt_image&			fImage;
+	const agg::trans_affine&	fImageMatrix;
+};
+
+
 template<typename FillMode>
 struct DrawBitmapGeneric {
 	static void
@@ -89,6 +141,11 @@ struct DrawBitmapGeneric {
 
 		agg::conv_transform<agg::path_storage> transformedPath(path,
 			srcMatrix);
+		if (_DrawTiled(painter, aggInterface, transformedPath, pixf_img,
+				imgMatrix, options)) {
+			return;
+		}
+
 		rasterizer.reset();
 		rasterizer.add_path(transformedPath);
 
@@ -126,6 +183,54 @@ struct DrawBitmapGeneric {
 			}
 		}
 	}
+
+private:
+	template<typename PixFmt, typename VertexSource>
+	static bool
+	_DrawTiled(const Painter* painter, PainterAggInterface& aggInterface,
+		VertexSource& path, const PixFmt& image,
+		const agg::trans_affine& imageMatrix, uint32 options)
+	{
+		if (!painter->TiledRendering())
+			return false;
+
+		double left = 0.0;
+		double top = 0.0;
+		double right = -1.0;
+		double bottom = -1.0;
+		agg::bounding_rect_single(path, 0, &left, &top, &right, &bottom);
+		BRect bounds = BRect(left, top, right, bottom)
+			& painter->ClippingRegion()->Frame();
+
+		TiledRenderer* renderer = TiledRenderer::Default();
+		if (renderer == NULL || !renderer->IsWorthwhile(bounds))
+			return false;
+
+		aggInterface.fTiledPath.remove_all();
+		aggInterface.fTiledPath.concat_path(path);
+
+		typedef typename ImageAccessor<PixFmt, FillMode>::type source_type;
+		typedef agg::span_interpolator_linear<> interpolator_type;
+
+		agg::clipped_alpha_mask* alphaMask
+			= aggInterface.fMaskedUnpackedScanline != NULL
+				? aggInterface.fClippedAlphaMask : NULL;
+		clipping_rect clip = painter->ClippingRegion()->FrameInt();
+
+		if ((options & B_FILTER_BITMAP_BILINEAR) != 0) {
+			BitmapTileFunction<source_type,
+				agg::span_image_filter_rgba_bilinear<source_type,
+					interpolator_type> > function(aggInterface.fTiledPath,
+				aggInterface.fBaseRenderer, alphaMask, image, imageMatrix);
+			return renderer->Render(bounds, clip, function);
+		}
+
+		BitmapTileFunction<source_type,
+			agg::span_image_filter_rgba_nn<source_type, interpolator_type> >
+			function(aggInterface.fTiledPath, aggInterface.fBaseRenderer,
+				alphaMask, image, imageMatrix);
+		return renderer->Render(bounds, clip, function);
+	}
 };
 
 
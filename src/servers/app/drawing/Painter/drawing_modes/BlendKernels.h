@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BLEND_KERNELS_H
+#define BLEND_KERNELS_H
+
+
+#include <SupportDefs.h>
+
+
+// The vectorized kernels need intrinsics, which the legacy compiler does
+// not have; the Jamfile builds them under the same conditions.
+#if (defined(__i386__) || defined(__x86_64__)) && __GNUC__ > 2
+#	define APPSERVER_SIMD_DRAWING_MODES 1
+#else
+#	define APPSERVER_SIMD_DRAWING_MODES 0
+#endif
+
+
+/*!	Vectorized loops over a span of B_RGBA32 pixels, which produce exactly
+	the same pixels as the BLEND() and BLEND16() macros in DrawingMode.h. The
+	\a color arguments are opaque B_RGBA32 pixels, and \a colors are those of
+	a span generator, in agg::rgba8 byte order.
+
+	They only depend on plain types, as some of them are compiled for
+	instruction sets that not every CPU supports, and must not provide any
+	code to the rest of the app_server.
+*/
+struct blend_kernels {
+	// assigns the color
+	void	(*fill)(uint8* pixels, unsigned count, uint32 color);
+
+	// BLEND() with the cover for all pixels
+	void	(*blend)(uint8* pixels, unsigned count, uint32 color,
+				uint8 cover);
+
+	// BLEND() with a cover per pixel: 0 leaves it alone, 255 assigns
+	void	(*blend_covers)(uint8* pixels, unsigned count, uint32 color,
+				const uint8* covers);
+
+	// BLEND16() with alpha * cover per pixel: 0 leaves it alone,
+	// 255 * 255 assigns
+	void	(*blend16_covers)(uint8* pixels, unsigned count, uint32 color,
+				uint8 alpha, const uint8* covers);
+
+	// BLEND_SUBPIX() with the covers at \a blue, 1 and \a red of three
+	// covers per pixel; \a blue and \a red are either 0 and 2, or 2 and 0
+	void	(*blend_subpixel)(uint8* pixels, unsigned count, uint32 color,
+				const uint8* covers, int blue, int red);
+
+	// BLEND16_SUBPIX() with alpha times the covers as above; both subpixel
+	// kernels are NULL when they would be slower than the scalar code
+	void	(*blend16_subpixel)(uint8* pixels, unsigned count, uint32 color,
+				uint8 alpha, const uint8* covers, int blue, int red);
+
+	// Like blend_covers with the cover for all pixels when \a covers is
+	// NULL, and optionally leaving fully transparent colors alone
+	void	(*blend_colors)(uint8* pixels, unsigned count,
+				const uint32* colors, const uint8* covers, uint8 cover,
+				bool skipTransparent);
+
+	// Like blend16_covers with the alpha of every color; without covers,
+	// \a alpha times \a cover is used for all pixels
+	void	(*blend16_colors)(uint8* pixels, unsigned count,
+				const uint32* colors, const uint8* covers, uint8 alpha,
+				uint8 cover);
+};
+
+
+#if APPSERVER_SIMD_DRAWING_MODES
+extern const blend_kernels gBlendKernelsSSE2;
+extern const blend_kernels gBlendKernelsAVX2;
+#endif
+
+// The kernels for the CPU we run on, or NULL; set up by the Painter.
+extern const blend_kernels* gBlendKernels;
+
+
+#endif	// BLEND_KERNELS_H
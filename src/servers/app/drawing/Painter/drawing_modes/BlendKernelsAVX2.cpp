@@ -0,0 +1,177 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	This file is compiled with AVX2 enabled, and must only be used when the
+	CPU supports it.
+*/
+
+
+#include <immintrin.h>
+
+#include "BlendKernelsSIMD.h"
+
+
+namespace {
+
+
+struct AVX2Vector {
+	typedef __m256i Type;
+
+	static const int32 kPixels = 8;
+
+	static inline Type Load(const void* address)
+	{
+		return _mm256_loadu_si256((const __m256i*)address);
+	}
+
+	static inline void Store(void* address, Type value)
+	{
+		_mm256_storeu_si256((__m256i*)address, value);
+	}
+
+	static inline Type LoadCovers(const uint8* covers)
+	{
+		Type vector = _mm256_cvtepu8_epi32(
+			_mm_loadl_epi64((const __m128i*)covers));
+		return _mm256_mullo_epi32(vector, _mm256_set1_epi32(0x01010101));
+	}
+
+	static inline Type Set(const uint32* values)
+	{
+		return _mm256_setr_epi32(values[0], values[1], values[2], values[3],
+			values[4], values[5], values[6], values[7]);
+	}
+
+	static inline Type Zero()
+	{
+		return _mm256_setzero_si256();
+	}
+
+	static inline Type Set32(uint32 value)
+	{
+		return _mm256_set1_epi32(value);
+	}
+
+	static inline Type And(Type a, Type b)
+	{
+		return _mm256_and_si256(a, b);
+	}
+
+	static inline Type Or(Type a, Type b)
+	{
+		return _mm256_or_si256(a, b);
+	}
+
+	static inline Type Select(Type mask, Type a, Type b)
+	{
+		return _mm256_blendv_epi8(b, a, mask);
+	}
+
+	static inline Type Equal32(Type a, Type b)
+	{
+		return _mm256_cmpeq_epi32(a, b);
+	}
+
+	static inline bool All(Type mask)
+	{
+		return _mm256_movemask_epi8(mask) == -1;
+	}
+
+	static inline bool None(Type mask)
+	{
+		return _mm256_movemask_epi8(mask) == 0;
+	}
+
+	static inline Type ShiftLeft32(Type a, int count)
+	{
+		return _mm256_slli_epi32(a, count);
+	}
+
+	static inline Type ShiftRight32(Type a, int count)
+	{
+		return _mm256_srli_epi32(a, count);
+	}
+
+	static inline Type ShiftRightArithmetic32(Type a, int count)
+	{
+		return _mm256_srai_epi32(a, count);
+	}
+
+	static inline Type UnpackLow8(Type a)
+	{
+		return _mm256_unpacklo_epi8(a, _mm256_setzero_si256());
+	}
+
+	static inline Type UnpackHigh8(Type a)
+	{
+		return _mm256_unpackhi_epi8(a, _mm256_setzero_si256());
+	}
+
+	static inline Type Pack16(Type low, Type high)
+	{
+		return _mm256_packus_epi16(low, high);
+	}
+
+	static inline Type Pack32(Type low, Type high)
+	{
+		return _mm256_packs_epi32(low, high);
+	}
+
+	static inline Type InterleaveLow16(Type a, Type b)
+	{
+		return _mm256_unpacklo_epi16(a, b);
+	}
+
+	static inline Type InterleaveHigh16(Type a, Type b)
+	{
+		return _mm256_unpackhi_epi16(a, b);
+	}
+
+	static inline Type Add16(Type a, Type b)
+	{
+		return _mm256_add_epi16(a, b);
+	}
+
+	static inline Type Sub16(Type a, Type b)
+	{
+		return _mm256_sub_epi16(a, b);
+	}
+
+	static inline Type Mul16(Type a, Type b)
+	{
+		return _mm256_mullo_epi16(a, b);
+	}
+
+	static inline Type MulAdd16(Type a, Type b)
+	{
+		return _mm256_madd_epi16(a, b);
+	}
+
+	static inline Type ShiftLeft16(Type a, int count)
+	{
+		return _mm256_slli_epi16(a, count);
+	}
+
+	static inline Type ShiftRight16(Type a, int count)
+	{
+		return _mm256_srli_epi16(a, count);
+	}
+};
+
+
+}	// namespace
+
+
+const blend_kernels gBlendKernelsAVX2 = {
+	&simd_fill<AVX2Vector>,
+	&simd_blend<AVX2Vector>,
+	&simd_blend_covers<AVX2Vector>,
+	&simd_blend16_covers<AVX2Vector>,
+	&simd_blend_subpixel<AVX2Vector>,
+	&simd_blend16_subpixel<AVX2Vector>,
+	&simd_blend_colors<AVX2Vector>,
+	&simd_blend16_colors<AVX2Vector>
+};
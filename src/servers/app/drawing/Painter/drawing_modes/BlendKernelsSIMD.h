@@ -0,0 +1,532 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BLEND_KERNELS_SIMD_H
+#define BLEND_KERNELS_SIMD_H
+
+
+/*!	The blend kernels for any vector width. The vector class \c V provides
+	the vector type, the number of B_RGBA32 pixels it holds, and the
+	operations on it; it is defined by the source files that instantiate
+	these templates, which are compiled for different instruction sets.
+
+	The channels are unpacked to 16 bit for blending. BLEND() fits into 16
+	bit lanes as it is, BLEND16() is computed with 32 bit products.
+*/
+
+
+#include <string.h>
+
+#include "BlendKernels.h"
+
+
+namespace {
+
+
+static const uint32 kAlphaMask = 0xff000000;
+
+
+/*!	Returns \a value in all four bytes of a pixel. */
+static inline uint32
+replicated(uint8 value)
+{
+	return value * 0x01010101u;
+}
+
+
+/*!	BLEND() on unpacked channels. (src - dst) * alpha + (dst << 8) is
+	always between 0 and 255 * 256, so it can be computed modulo 2^16.
+*/
+template<class V>
+static inline typename V::Type
+blend_channels(typename V::Type dst, typename V::Type src,
+	typename V::Type alpha)
+{
+	return V::ShiftRight16(V::Add16(V::Mul16(V::Sub16(src, dst), alpha),
+		V::ShiftLeft16(dst, 8)), 8);
+}
+
+
+/*!	BLEND16() on unpacked channels, \a alpha goes up to 255 * 255. It is
+	split into two halves that fit into signed 16 bit, so that MulAdd16()
+	can compute the products with the signed difference in 32 bit.
+*/
+template<class V>
+static inline typename V::Type
+blend16_channels(typename V::Type dst, typename V::Type src,
+	typename V::Type alpha)
+{
+	typedef typename V::Type Type;
+
+	Type alphaLow = V::ShiftRight16(alpha, 1);
+	Type alphaHigh = V::Sub16(alpha, alphaLow);
+	Type difference = V::Sub16(src, dst);
+
+	Type low = V::MulAdd16(V::InterleaveLow16(difference, difference),
+		V::InterleaveLow16(alphaLow, alphaHigh));
+	Type high = V::MulAdd16(V::InterleaveHigh16(difference, difference),
+		V::InterleaveHigh16(alphaLow, alphaHigh));
+
+	// the arithmetic shift rounds down like the scalar version
+	return V::Add16(dst, V::Pack32(V::ShiftRightArithmetic32(low, 16),
+		V::ShiftRightArithmetic32(high, 16)));
+}
+
+
+/*!	BLEND() for all pixels, with the alpha of every channel in the
+	corresponding byte of \a alpha.
+*/
+template<class V>
+static inline typename V::Type
+blend(typename V::Type dst, typename V::Type src, typename V::Type alpha)
+{
+	typename V::Type low = blend_channels<V>(V::UnpackLow8(dst),
+		V::UnpackLow8(src), V::UnpackLow8(alpha));
+	typename V::Type high = blend_channels<V>(V::UnpackHigh8(dst),
+		V::UnpackHigh8(src), V::UnpackHigh8(alpha));
+
+	return V::Or(V::Pack16(low, high), V::Set32(kAlphaMask));
+}
+
+
+/*!	BLEND16() for all pixels, the alpha of every channel is the product of
+	the corresponding bytes of \a alpha1 and \a alpha2.
+*/
+template<class V>
+static inline typename V::Type
+blend16(typename V::Type dst, typename V::Type src, typename V::Type alpha1,
+	typename V::Type alpha2)
+{
+	typename V::Type low = blend16_channels<V>(V::UnpackLow8(dst),
+		V::UnpackLow8(src),
+		V::Mul16(V::UnpackLow8(alpha1), V::UnpackLow8(alpha2)));
+	typename V::Type high = blend16_channels<V>(V::UnpackHigh8(dst),
+		V::UnpackHigh8(src),
+		V::Mul16(V::UnpackHigh8(alpha1), V::UnpackHigh8(alpha2)));
+
+	return V::Or(V::Pack16(low, high), V::Set32(kAlphaMask));
+}
+
+
+/*!	Converts colors in agg::rgba8 byte order to opaque B_RGBA32 pixels. */
+template<class V>
+static inline typename V::Type
+opaque_pixels(typename V::Type colors)
+{
+	typename V::Type redBlue = V::And(colors, V::Set32(0x00ff00ff));
+	return V::Or(V::Or(V::And(colors, V::Set32(0x0000ff00)),
+			V::Set32(kAlphaMask)),
+		V::Or(V::ShiftLeft32(redBlue, 16), V::ShiftRight32(redBlue, 16)));
+}
+
+
+/*!	Returns the alpha of \a colors in all bytes of their pixels. */
+template<class V>
+static inline typename V::Type
+replicated_alpha(typename V::Type colors)
+{
+	typename V::Type alpha = V::ShiftRight32(colors, 24);
+	alpha = V::Or(alpha, V::ShiftLeft32(alpha, 8));
+	return V::Or(alpha, V::ShiftLeft32(alpha, 16));
+}
+
+
+/*!	Returns the covers of subpixel anti-aliasing in the bytes of the
+	channels they apply to. The order is known at compile time, so that the
+	covers can be gathered without indexing.
+*/
+template<class V, int kBlue, int kRed>
+static inline typename V::Type
+load_subpixel_covers(const uint8* covers)
+{
+	uint32 values[V::kPixels];
+	for (int32 i = 0; i < V::kPixels; i++) {
+		values[i] = covers[kBlue] | (covers[1] << 8) | (covers[kRed] << 16);
+		covers += 3;
+	}
+
+	// the values are only assembled in registers, loading them from memory
+	// right after storing them would stall
+	return V::Set(values);
+}
+
+
+/*!	Calls \a block for every V::kPixels pixels of the span. The last pixels
+	are copied into a temporary block, so that they are blended by the same
+	code as the others; \a covers and \a colors may be \c NULL.
+*/
+template<class V, class Block>
+static inline void
+for_each_block(uint8* pixels, unsigned count, const uint8* covers,
+	int32 coversPerPixel, const uint32* colors, const Block& block)
+{
+	while (count >= (unsigned)V::kPixels) {
+		block(pixels, covers, colors);
+
+		pixels += V::kPixels * 4;
+		if (covers != NULL)
+			covers += V::kPixels * coversPerPixel;
+		if (colors != NULL)
+			colors += V::kPixels;
+		count -= V::kPixels;
+	}
+
+	if (count == 0)
+		return;
+
+	uint32 lastPixels[V::kPixels];
+	uint8 lastCovers[V::kPixels * 3];
+	uint32 lastColors[V::kPixels];
+	memset(lastCovers, 0, sizeof(lastCovers));
+	memset(lastColors, 0, sizeof(lastColors));
+
+	memcpy(lastPixels, pixels, count * 4);
+	if (covers != NULL)
+		memcpy(lastCovers, covers, count * coversPerPixel);
+	if (colors != NULL)
+		memcpy(lastColors, colors, count * 4);
+
+	block((uint8*)lastPixels, covers != NULL ? lastCovers : NULL,
+		colors != NULL ? lastColors : NULL);
+
+	memcpy(pixels, lastPixels, count * 4);
+}
+
+
+// #pragma mark - blocks
+
+
+template<class V>
+struct ConstantBlock {
+	typedef typename V::Type Type;
+
+	ConstantBlock(uint32 color, uint8 cover)
+		:
+		fColor(V::Set32(color)),
+		fCover(V::Set32(replicated(cover)))
+	{
+	}
+
+	void operator()(uint8* pixels, const uint8*, const uint32*) const
+	{
+		V::Store(pixels, blend<V>(V::Load(pixels), fColor, fCover));
+	}
+
+	Type	fColor;
+	Type	fCover;
+};
+
+
+template<class V>
+struct CoversBlock {
+	typedef typename V::Type Type;
+
+	CoversBlock(uint32 color)
+		:
+		fColor(V::Set32(color))
+	{
+	}
+
+	void operator()(uint8* pixels, const uint8* covers, const uint32*) const
+	{
+		Type cover = V::LoadCovers(covers);
+		Type opaque = V::Equal32(cover, V::Set32(0xffffffff));
+		Type transparent = V::Equal32(cover, V::Zero());
+
+		// the inside and the outside of a shape are the common case
+		if (V::All(opaque)) {
+			V::Store(pixels, fColor);
+			return;
+		}
+		if (V::All(transparent))
+			return;
+
+		Type dst = V::Load(pixels);
+		Type result = V::Select(opaque, fColor, blend<V>(dst, fColor, cover));
+		V::Store(pixels, V::Select(transparent, dst, result));
+	}
+
+	Type	fColor;
+};
+
+
+template<class V>
+struct Covers16Block {
+	typedef typename V::Type Type;
+
+	Covers16Block(uint32 color, uint8 alpha)
+		:
+		fColor(V::Set32(color)),
+		fAlpha(V::Set32(replicated(alpha))),
+		fOpaque(alpha == 255)
+	{
+	}
+
+	void operator()(uint8* pixels, const uint8* covers, const uint32*) const
+	{
+		Type cover = V::LoadCovers(covers);
+		Type transparent = V::Equal32(cover, V::Zero());
+		if (V::All(transparent))
+			return;
+
+		Type opaque = V::Equal32(cover, V::Set32(0xffffffff));
+		if (fOpaque && V::All(opaque)) {
+			V::Store(pixels, fColor);
+			return;
+		}
+
+		Type dst = V::Load(pixels);
+		Type result = blend16<V>(dst, fColor, fAlpha, cover);
+		if (fOpaque)
+			result = V::Select(opaque, fColor, result);
+		V::Store(pixels, V::Select(transparent, dst, result));
+	}
+
+	Type	fColor;
+	Type	fAlpha;
+	bool	fOpaque;
+};
+
+
+template<class V, int kBlue, int kRed>
+struct SubpixelBlock {
+	typedef typename V::Type Type;
+
+	SubpixelBlock(uint32 color)
+		:
+		fColor(V::Set32(color))
+	{
+	}
+
+	void operator()(uint8* pixels, const uint8* covers, const uint32*) const
+	{
+		V::Store(pixels, blend<V>(V::Load(pixels), fColor,
+			load_subpixel_covers<V, kBlue, kRed>(covers)));
+	}
+
+	Type	fColor;
+};
+
+
+template<class V, int kBlue, int kRed>
+struct Subpixel16Block {
+	typedef typename V::Type Type;
+
+	Subpixel16Block(uint32 color, uint8 alpha)
+		:
+		fColor(V::Set32(color)),
+		fAlpha(V::Set32(replicated(alpha)))
+	{
+	}
+
+	void operator()(uint8* pixels, const uint8* covers, const uint32*) const
+	{
+		V::Store(pixels, blend16<V>(V::Load(pixels), fColor, fAlpha,
+			load_subpixel_covers<V, kBlue, kRed>(covers)));
+	}
+
+	Type	fColor;
+	Type	fAlpha;
+};
+
+
+template<class V>
+struct ColorsBlock {
+	typedef typename V::Type Type;
+
+	ColorsBlock(uint8 cover, bool skipTransparent)
+		:
+		fCover(V::Set32(replicated(cover))),
+		fSkipTransparent(skipTransparent)
+	{
+	}
+
+	void operator()(uint8* pixels, const uint8* covers,
+		const uint32* colors) const
+	{
+		Type rawColors = V::Load(colors);
+		Type cover = covers != NULL ? V::LoadCovers(covers) : fCover;
+
+		Type keep = V::Equal32(cover, V::Zero());
+		if (fSkipTransparent) {
+			keep = V::Or(keep, V::Equal32(
+				V::And(rawColors, V::Set32(kAlphaMask)), V::Zero()));
+		}
+		if (V::All(keep))
+			return;
+
+		Type src = opaque_pixels<V>(rawColors);
+		Type opaque = V::Equal32(cover, V::Set32(0xffffffff));
+		if (V::All(opaque) && V::None(keep)) {
+			V::Store(pixels, src);
+			return;
+		}
+
+		Type dst = V::Load(pixels);
+		Type result = V::Select(opaque, src, blend<V>(dst, src, cover));
+		V::Store(pixels, V::Select(keep, dst, result));
+	}
+
+	Type	fCover;
+	bool	fSkipTransparent;
+};
+
+
+template<class V>
+struct Colors16Block {
+	typedef typename V::Type Type;
+
+	Colors16Block(uint8 alpha, uint8 cover)
+		:
+		fAlpha(V::Set32(replicated(alpha))),
+		fCover(V::Set32(replicated(cover)))
+	{
+	}
+
+	void operator()(uint8* pixels, const uint8* covers,
+		const uint32* colors) const
+	{
+		Type rawColors = V::Load(colors);
+		Type src = opaque_pixels<V>(rawColors);
+
+		Type alpha = fAlpha;
+		Type cover = fCover;
+		if (covers != NULL) {
+			alpha = replicated_alpha<V>(rawColors);
+			cover = V::LoadCovers(covers);
+		}
+
+		Type transparent = V::Or(V::Equal32(alpha, V::Zero()),
+			V::Equal32(cover, V::Zero()));
+		if (V::All(transparent))
+			return;
+
+		Type ones = V::Set32(0xffffffff);
+		Type opaque = V::And(V::Equal32(alpha, ones), V::Equal32(cover, ones));
+		if (V::All(opaque)) {
+			V::Store(pixels, src);
+			return;
+		}
+
+		Type dst = V::Load(pixels);
+		Type result = V::Select(opaque, src,
+			blend16<V>(dst, src, alpha, cover));
+		V::Store(pixels, V::Select(transparent, dst, result));
+	}
+
+	Type	fAlpha;
+	Type	fCover;
+};
+
+
+// #pragma mark - kernels
+
+
+template<class V>
+void
+simd_fill(uint8* pixels, unsigned count, uint32 color)
+{
+	typename V::Type vector = V::Set32(color);
+	for (; count >= (unsigned)V::kPixels; count -= V::kPixels) {
+		V::Store(pixels, vector);
+		pixels += V::kPixels * 4;
+	}
+	for (; count > 0; count--) {
+		*(uint32*)pixels = color;
+		pixels += 4;
+	}
+}
+
+
+template<class V>
+void
+simd_blend(uint8* pixels, unsigned count, uint32 color, uint8 cover)
+{
+	for_each_block<V>(pixels, count, NULL, 0, NULL,
+		ConstantBlock<V>(color, cover));
+}
+
+
+template<class V>
+void
+simd_blend_covers(uint8* pixels, unsigned count, uint32 color,
+	const uint8* covers)
+{
+	for_each_block<V>(pixels, count, covers, 1, NULL, CoversBlock<V>(color));
+}
+
+
+template<class V>
+void
+simd_blend16_covers(uint8* pixels, unsigned count, uint32 color, uint8 alpha,
+	const uint8* covers)
+{
+	if (alpha == 0)
+		return;
+
+	for_each_block<V>(pixels, count, covers, 1, NULL,
+		Covers16Block<V>(color, alpha));
+}
+
+
+template<class V>
+void
+simd_blend_subpixel(uint8* pixels, unsigned count, uint32 color,
+	const uint8* covers, int blue, int red)
+{
+	if (blue == 0) {
+		for_each_block<V>(pixels, count, covers, 3, NULL,
+			SubpixelBlock<V, 0, 2>(color));
+	} else {
+		for_each_block<V>(pixels, count, covers, 3, NULL,
+			SubpixelBlock<V, 2, 0>(color));
+	}
+}
+
+
+template<class V>
+void
+simd_blend16_subpixel(uint8* pixels, unsigned count, uint32 color,
+	uint8 alpha, const uint8* covers, int blue, int red)
+{
+	if (blue == 0) {
+		for_each_block<V>(pixels, count, covers, 3, NULL,
+			Subpixel16Block<V, 0, 2>(color, alpha));
+	} else {
+		for_each_block<V>(pixels, count, covers, 3, NULL,
+			Subpixel16Block<V, 2, 0>(color, alpha));
+	}
+}
+
+
+template<class V>
+void
+simd_blend_colors(uint8* pixels, unsigned count, const uint32* colors,
+	const uint8* covers, uint8 cover, bool skipTransparent)
+{
+	if (covers == NULL && cover == 0)
+		return;
+
+	for_each_block<V>(pixels, count, covers, 1, colors,
+		ColorsBlock<V>(cover, skipTransparent));
+}
+
+
+template<class V>
+void
+simd_blend16_colors(uint8* pixels, unsigned count, const uint32* colors,
+	const uint8* covers, uint8 alpha, uint8 cover)
+{
+	if (covers == NULL && (alpha == 0 || cover == 0))
+		return;
+
+	for_each_block<V>(pixels, count, covers, 1, colors,
+		Colors16Block<V>(alpha, cover));
+}
+
+
+}	// namespace
+
+
+#endif	// BLEND_KERNELS_SIMD_H
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	This file is compiled with SSE2 enabled, and must only be used when the
+	CPU supports it. All x86_64 CPUs do.
+*/
+
+
+#include <emmintrin.h>
+
+#include "BlendKernelsSIMD.h"
+
+
+namespace {
+
+
+struct SSE2Vector {
+	typedef __m128i Type;
+
+	static const int32 kPixels = 4;
+
+	static inline Type Load(const void* address)
+	{
+		return _mm_loadu_si128((const __m128i*)address);
+	}
+
+	static inline void Store(void* address, Type value)
+	{
+		_mm_storeu_si128((__m128i*)address, value);
+	}
+
+	static inline Type LoadCovers(const uint8* covers)
+	{
+		uint32 value;
+		memcpy(&value, covers, sizeof(value));
+
+		Type vector = _mm_cvtsi32_si128(value);
+		vector = _mm_unpacklo_epi8(vector, vector);
+		return _mm_unpacklo_epi16(vector, vector);
+	}
+
+	static inline Type Zero()
+	{
+		return _mm_setzero_si128();
+	}
+
+	static inline Type Set32(uint32 value)
+	{
+		return _mm_set1_epi32(value);
+	}
+
+	static inline Type And(Type a, Type b)
+	{
+		return _mm_and_si128(a, b);
+	}
+
+	static inline Type Or(Type a, Type b)
+	{
+		return _mm_or_si128(a, b);
+	}
+
+	static inline Type Select(Type mask, Type a, Type b)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	static inline Type Equal32(Type a, Type b)
+	{
+		return _mm_cmpeq_epi32(a, b);
+	}
+
+	static inline bool All(Type mask)
+	{
+		return _mm_movemask_epi8(mask) == 0xffff;
+	}
+
+	static inline bool None(Type mask)
+	{
+		return _mm_movemask_epi8(mask) == 0;
+	}
+
+	static inline Type ShiftLeft32(Type a, int count)
+	{
+		return _mm_slli_epi32(a, count);
+	}
+
+	static inline Type ShiftRight32(Type a, int count)
+	{
+		return _mm_srli_epi32(a, count);
+	}
+
+	static inline Type ShiftRightArithmetic32(Type a, int count)
+	{
+		return _mm_srai_epi32(a, count);
+	}
+
+	static inline Type UnpackLow8(Type a)
+	{
+		return _mm_unpacklo_epi8(a, _mm_setzero_si128());
+	}
+
+	static inline Type UnpackHigh8(Type a)
+	{
+		return _mm_unpackhi_epi8(a, _mm_setzero_si128());
+	}
+
+	static inline Type Pack16(Type low, Type high)
+	{
+		return _mm_packus_epi16(low, high);
+	}
+
+	static inline Type Pack32(Type low, Type high)
+	{
+		return _mm_packs_epi32(low, high);
+	}
+
+	static inline Type InterleaveLow16(Type a, Type b)
+	{
+		return _mm_unpacklo_epi16(a, b);
+	}
+
+	static inline Type InterleaveHigh16(Type a, Type b)
+	{
+		return _mm_unpackhi_epi16(a, b);
+	}
+
+	static inline Type Add16(Type a, Type b)
+	{
+		return _mm_add_epi16(a, b);
+	}
+
+	static inline Type Sub16(Type a, Type b)
+	{
+		return _mm_sub_epi16(a, b);
+	}
+
+	static inline Type Mul16(Type a, Type b)
+	{
+		return _mm_mullo_epi16(a, b);
+	}
+
+	static inline Type MulAdd16(Type a, Type b)
+	{
+		return _mm_madd_epi16(a, b);
+	}
+
+	static inline Type ShiftLeft16(Type a, int count)
+	{
+		return _mm_slli_epi16(a, count);
+	}
+
+	static inline Type ShiftRight16(Type a, int count)
+	{
+		return _mm_srli_epi16(a, count);
+	}
+};
+
+
+}	// namespace
+
+
+const blend_kernels gBlendKernelsSSE2 = {
+	&simd_fill<SSE2Vector>,
+	&simd_blend<SSE2Vector>,
+	&simd_blend_covers<SSE2Vector>,
+	&simd_blend16_covers<SSE2Vector>,
+	// Gathering the subpixel covers of only four pixels takes longer than
+	// blending them one by one.
+	NULL,
+	NULL,
+	&simd_blend_colors<SSE2Vector>,
+	&simd_blend16_colors<SSE2Vector>
+};
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * Vectorized versions of the most often used B_OP_COPY, B_OP_OVER and
+ * B_OP_ALPHA functions on B_RGBA32, using the blend kernels the CPU supports
+ * best. Each one produces exactly the same pixels as the scalar function it
+ * is named after.
+ *
+ */
+
+#ifndef DRAWING_MODE_SIMD_H
+#define DRAWING_MODE_SIMD_H
+
+#include "BlendKernels.h"
+#include "DrawingMode.h"
+#include "GlobalSubpixelSettings.h"
+
+// opaque_color
+static inline uint32
+opaque_color(const color_type& c)
+{
+	return c.b | (c.g << 8) | (c.r << 16) | 0xff000000;
+}
+
+// blend_hline_copy_solid_simd
+void
+blend_hline_copy_solid_simd(int x, int y, unsigned len,
+	const color_type& c, uint8 cover, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	uint8* p = buffer->row_ptr(y) + (x << 2);
+	if (cover == 255)
+		gBlendKernels->fill(p, len, opaque_color(c));
+	else
+		gBlendKernels->blend(p, len, opaque_color(c), cover);
+}
+
+// blend_hline_over_solid_simd
+void
+blend_hline_over_solid_simd(int x, int y, unsigned len,
+	const color_type& c, uint8 cover, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	if (pattern->IsSolidLow())
+		return;
+
+	blend_hline_copy_solid_simd(x, y, len, c, cover, buffer, pattern);
+}
+
+// blend_solid_hspan_copy_solid_simd
+void
+blend_solid_hspan_copy_solid_simd(int x, int y, unsigned len,
+	const color_type& c, const uint8* covers, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	gBlendKernels->blend_covers(buffer->row_ptr(y) + (x << 2), len,
+		opaque_color(c), covers);
+}
+
+// blend_solid_hspan_over_solid_simd
+void
+blend_solid_hspan_over_solid_simd(int x, int y, unsigned len,
+	const color_type& c, const uint8* covers, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	if (pattern->IsSolidLow())
+		return;
+
+	gBlendKernels->blend_covers(buffer->row_ptr(y) + (x << 2), len,
+		opaque_color(c), covers);
+}
+
+// blend_solid_hspan_alpha_co_solid_simd
+void
+blend_solid_hspan_alpha_co_solid_simd(int x, int y, unsigned len,
+	const color_type& c, const uint8* covers, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	gBlendKernels->blend16_covers(buffer->row_ptr(y) + (x << 2), len,
+		opaque_color(c), pattern->HighColor().alpha, covers);
+}
+
+// blend_solid_hspan_alpha_po_solid_simd
+void
+blend_solid_hspan_alpha_po_solid_simd(int x, int y, unsigned len,
+	const color_type& c, const uint8* covers, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	gBlendKernels->blend16_covers(buffer->row_ptr(y) + (x << 2), len,
+		opaque_color(c), c.a, covers);
+}
+
+// blend_solid_hspan_copy_solid_subpix_simd
+void
+blend_solid_hspan_copy_solid_subpix_simd(int x, int y, unsigned len,
+	const color_type& c, const uint8* covers, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	const int subpixelL = gSubpixelOrderingRGB ? 2 : 0;
+	const int subpixelR = gSubpixelOrderingRGB ? 0 : 2;
+	gBlendKernels->blend_subpixel(buffer->row_ptr(y) + (x << 2), len / 3,
+		opaque_color(c), covers, subpixelL, subpixelR);
+}
+
+// blend_solid_hspan_over_solid_subpix_simd
+void
+blend_solid_hspan_over_solid_subpix_simd(int x, int y, unsigned len,
+	const color_type& c, const uint8* covers, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	if (pattern->IsSolidLow())
+		return;
+
+	blend_solid_hspan_copy_solid_subpix_simd(x, y, len, c, covers, buffer,
+		pattern);
+}
+
+// blend_solid_hspan_alpha_co_solid_subpix_simd
+void
+blend_solid_hspan_alpha_co_solid_subpix_simd(int x, int y, unsigned len,
+	const color_type& c, const uint8* covers, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	// unlike B_OP_OVER, blue is blended with the right subpixel
+	const int subpixelL = gSubpixelOrderingRGB ? 2 : 0;
+	const int subpixelR = gSubpixelOrderingRGB ? 0 : 2;
+	gBlendKernels->blend16_subpixel(buffer->row_ptr(y) + (x << 2), len / 3,
+		opaque_color(c), pattern->HighColor().alpha, covers, subpixelR,
+		subpixelL);
+}
+
+// blend_solid_hspan_alpha_po_solid_subpix_simd
+void
+blend_solid_hspan_alpha_po_solid_subpix_simd(int x, int y, unsigned len,
+	const color_type& c, const uint8* covers, agg_buffer* buffer,
+	const PatternHandler* pattern)
+{
+	const int subpixelL = gSubpixelOrderingRGB ? 2 : 0;
+	const int subpixelR = gSubpixelOrderingRGB ? 0 : 2;
+	gBlendKernels->blend16_subpixel(buffer->row_ptr(y) + (x << 2), len / 3,
+		opaque_color(c), c.a, covers, subpixelR, subpixelL);
+}
+
+// blend_color_hspan_copy_solid_simd
+void
+blend_color_hspan_copy_solid_simd(int x, int y, unsigned len,
+	const color_type* colors, const uint8* covers, uint8 cover,
+	agg_buffer* buffer, const PatternHandler* pattern)
+{
+	gBlendKernels->blend_colors(buffer->row_ptr(y) + (x << 2), len,
+		(const uint32*)colors, covers, cover, false);
+}
+
+// blend_color_hspan_over_simd
+void
+blend_color_hspan_over_simd(int x, int y, unsigned len,
+	const color_type* colors, const uint8* covers, uint8 cover,
+	agg_buffer* buffer, const PatternHandler* pattern)
+{
+	gBlendKernels->blend_colors(buffer->row_ptr(y) + (x << 2), len,
+		(const uint32*)colors, covers, cover, true);
+}
+
+// blend_color_hspan_alpha_po_simd
+void
+blend_color_hspan_alpha_po_simd(int x, int y, unsigned len,
+	const color_type* colors, const uint8* covers, uint8 cover,
+	agg_buffer* buffer, const PatternHandler* pattern)
+{
+	// without covers, the alpha of the first color is used for all of them
+	gBlendKernels->blend16_colors(buffer->row_ptr(y) + (x << 2), len,
+		(const uint32*)colors, covers, colors->a, cover);
+}
+
+#endif // DRAWING_MODE_SIMD_H
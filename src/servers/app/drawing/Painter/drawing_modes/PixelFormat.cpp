@@ -54,6 +54,8 @@
 #include "DrawingModeSelectSUBPIX.h"
 #include "DrawingModeSubtractSUBPIX.h"
 
+#include "DrawingModeSIMD.h"
+
 #include "PatternHandler.h"
 
 // blend_pixel_empty
@@ -130,6 +132,15 @@ blend_color_vspan_empty(int x, int y, unsigned len,
 	printf("blend_color_vspan_empty()\n");
 }
 
+// replace_function
+template<typename Function>
+static inline void
+replace_function(Function& function, Function scalar, Function simd)
+{
+	if (function == scalar)
+		function = simd;
+}
+
 // #pragma mark -
 
 // constructor
@@ -361,4 +372,49 @@ fprintf(stderr, "PixelFormat::SetDrawingMode() - drawing_mode not implemented\n"
 //			return fDrawingModeBGRA32Copy;
 			break;
 	}
+
+	if (gBlendKernels != NULL)
+		_UseSIMDFunctions();
+}
+
+// _UseSIMDFunctions
+void
+PixelFormat::_UseSIMDFunctions()
+{
+	// Replace the scalar functions that have a vectorized version.
+	replace_function(fBlendHLine, blend_hline_copy_solid,
+		blend_hline_copy_solid_simd);
+	replace_function(fBlendHLine, blend_hline_over_solid,
+		blend_hline_over_solid_simd);
+
+	replace_function(fBlendSolidHSpan, blend_solid_hspan_copy_solid,
+		blend_solid_hspan_copy_solid_simd);
+	replace_function(fBlendSolidHSpan, blend_solid_hspan_over_solid,
+		blend_solid_hspan_over_solid_simd);
+	replace_function(fBlendSolidHSpan, blend_solid_hspan_alpha_co_solid,
+		blend_solid_hspan_alpha_co_solid_simd);
+	replace_function(fBlendSolidHSpan, blend_solid_hspan_alpha_po_solid,
+		blend_solid_hspan_alpha_po_solid_simd);
+
+	if (gBlendKernels->blend_subpixel != NULL) {
+		replace_function(fBlendSolidHSpanSubpix,
+			blend_solid_hspan_copy_solid_subpix,
+			blend_solid_hspan_copy_solid_subpix_simd);
+		replace_function(fBlendSolidHSpanSubpix,
+			blend_solid_hspan_over_solid_subpix,
+			blend_solid_hspan_over_solid_subpix_simd);
+		replace_function(fBlendSolidHSpanSubpix,
+			blend_solid_hspan_alpha_co_solid_subpix,
+			blend_solid_hspan_alpha_co_solid_subpix_simd);
+		replace_function(fBlendSolidHSpanSubpix,
+			blend_solid_hspan_alpha_po_solid_subpix,
+			blend_solid_hspan_alpha_po_solid_subpix_simd);
+	}
+
+	replace_function(fBlendColorHSpan, blend_color_hspan_copy_solid,
+		blend_color_hspan_copy_solid_simd);
+	replace_function(fBlendColorHSpan, blend_color_hspan_over,
+		blend_color_hspan_over_simd);
+	replace_function(fBlendColorHSpan, blend_color_hspan_alpha_po,
+		blend_color_hspan_alpha_po_simd);
 }
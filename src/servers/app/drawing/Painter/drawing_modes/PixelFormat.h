@@ -187,6 +187,8 @@ class PixelFormat {
 		fBlendSolidVSpan = T::blend_solid_vspan;
 		fBlendColorHSpan = T::blend_color_hspan;
 	}
+
+	void _UseSIMDFunctions();
 };
 
 // inlined functions
@@ -0,0 +1,299 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "UpdateQueue.h"
+
+#include <string.h>
+
+#include <Autolock.h>
+
+#include "HWInterface.h"
+#include "RenderingBuffer.h"
+#include "TiledRenderer.h"
+
+
+// used when the refresh rate of the display mode is unknown
+static const bigtime_t kDefaultFrameInterval = 1000000 / 60;
+static const bigtime_t kMinFrameInterval = 1000000 / 240;
+static const bigtime_t kMaxFrameInterval = 1000000 / 24;
+
+#ifdef PROFILE_MESSAGE_LOOP
+static const bigtime_t kProfileInterval = 5000000;
+#endif
+
+
+struct UpdateQueue::CopyTile {
+	CopyTile(UpdateQueue* queue, const BRegion& region)
+		:
+		fQueue(queue),
+		fRegion(region)
+	{
+	}
+
+	void operator()(TileContext&, const clipping_rect& tile)
+	{
+		fQueue->_CopyTile(fRegion, tile);
+	}
+
+	UpdateQueue*	fQueue;
+	const BRegion&	fRegion;
+};
+
+
+UpdateQueue::UpdateQueue(HWInterface* interface)
+	:
+	fInterface(interface),
+	fLock("update queue"),
+	fScheduled(false),
+	fThread(-1),
+	fLastFrame(0),
+	fProfileStart(system_time())
+{
+	memset(&fProfile, 0, sizeof(fProfile));
+
+	fSemaphore = create_sem(0, "update queue damage");
+	if (fSemaphore < 0)
+		return;
+
+	fThread = spawn_thread(&_ThreadEntry, "update queue",
+		B_URGENT_DISPLAY_PRIORITY, this);
+	if (fThread >= 0)
+		resume_thread(fThread);
+}
+
+
+UpdateQueue::~UpdateQueue()
+{
+	// deleting the semaphore makes the thread quit
+	delete_sem(fSemaphore);
+
+	if (fThread >= 0) {
+		status_t result;
+		wait_for_thread(fThread, &result);
+	}
+}
+
+
+status_t
+UpdateQueue::InitCheck() const
+{
+	if (fSemaphore < 0)
+		return fSemaphore;
+	if (fThread < 0)
+		return fThread;
+	return B_OK;
+}
+
+
+void
+UpdateQueue::AddRegion(const BRegion& region)
+{
+	if (region.CountRects() == 0)
+		return;
+
+	BAutolock _(fLock);
+
+	if (!fScheduled) {
+		fScheduled = true;
+		fDamage.time = system_time();
+		fDamage.rects = 0;
+		release_sem_etc(fSemaphore, 1, B_DO_NOT_RESCHEDULE);
+	}
+
+	fDamage.region.Include(&region);
+	fDamage.rects += region.CountRects();
+}
+
+
+void
+UpdateQueue::Flush()
+{
+	Damage damage;
+	if (!_TakeDamage(damage))
+		return;
+
+	if (fInterface->LockParallelAccess()) {
+		_CopyToFront(damage);
+		fInterface->UnlockParallelAccess();
+	}
+}
+
+
+/*!	Moves the pending damage into \a damage, and returns whether there was
+	any. The next damage will schedule another frame.
+*/
+bool
+UpdateQueue::_TakeDamage(Damage& damage)
+{
+	BAutolock _(fLock);
+
+	if (!fScheduled)
+		return false;
+
+	damage = fDamage;
+	fDamage.region.MakeEmpty();
+	fScheduled = false;
+	return true;
+}
+
+
+/*!	Lets the damage of the current frame accumulate until the next retrace.
+	Without a retrace semaphore, frames are just spaced by the refresh rate,
+	so that damage after a pause is copied right away.
+*/
+void
+UpdateQueue::_WaitForFrame()
+{
+	bigtime_t interval = _FrameInterval();
+	if (fInterface->WaitForRetrace(interval) == B_OK)
+		return;
+
+	snooze_until(fLastFrame + interval, B_SYSTEM_TIMEBASE);
+}
+
+
+bigtime_t
+UpdateQueue::_FrameInterval() const
+{
+	display_mode mode;
+	fInterface->GetMode(&mode);
+
+	// the pixel clock is in kHz
+	uint64 pixels = (uint64)mode.timing.h_total * mode.timing.v_total;
+	if (mode.timing.pixel_clock == 0 || pixels == 0)
+		return kDefaultFrameInterval;
+
+	bigtime_t interval = pixels * 1000 / mode.timing.pixel_clock;
+	return max_c(kMinFrameInterval, min_c(interval, kMaxFrameInterval));
+}
+
+
+/*!	Copies \a damage from the back buffer to the front buffer, and draws the
+	software cursor on top of it. Large regions are copied on all CPUs.
+	The parallel access lock of the HWInterface must be held.
+*/
+void
+UpdateQueue::_CopyToFront(Damage& damage)
+{
+	RenderingBuffer* frontBuffer = fInterface->FrontBuffer();
+	RenderingBuffer* backBuffer = fInterface->BackBuffer();
+	if (frontBuffer == NULL || backBuffer == NULL)
+		return;
+
+#ifdef PROFILE_MESSAGE_LOOP
+	bigtime_t start = system_time();
+#endif
+
+	// the mode might have changed since the damage was added
+	BRegion bounds(backBuffer->Bounds());
+	damage.region.IntersectWith(&bounds);
+	if (damage.region.CountRects() == 0)
+		return;
+
+	bool cursorLocked = fInterface->fFloatingOverlaysLock.Lock();
+
+	// the cursor is composited from the back buffer separately
+	IntRect cursorFrame = fInterface->_CursorFrame();
+	BRegion region(damage.region);
+	region.Exclude((clipping_rect)cursorFrame);
+
+	if (region.CountRects() > 0) {
+		TiledRenderer* renderer = TiledRenderer::Default();
+		CopyTile copyTile(this, region);
+		if (renderer == NULL
+			|| !renderer->Render(region.Frame(), region.FrameInt(), copyTile))
+			fInterface->_CopyBackToFront(region);
+	}
+
+	if (cursorFrame.IsValid()) {
+		BRegion cursorRegion((BRect)cursorFrame);
+		cursorRegion.IntersectWith(&damage.region);
+		if (cursorRegion.CountRects() > 0)
+			fInterface->_DrawCursor(IntRect(cursorRegion.Frame()));
+	}
+
+#ifdef PROFILE_MESSAGE_LOOP
+	// the cursor lock also serializes this with Flush()
+	_UpdateProfile(damage, start);
+#endif
+
+	if (cursorLocked)
+		fInterface->fFloatingOverlaysLock.Unlock();
+}
+
+
+/*!	Copies the part of \a region within \a tile; called from several threads
+	at once.
+*/
+void
+UpdateQueue::_CopyTile(const BRegion& region, const clipping_rect& tile)
+{
+	BRegion part;
+	part.Set(tile);
+	part.IntersectWith(&region);
+	fInterface->_CopyBackToFront(part);
+}
+
+
+void
+UpdateQueue::_UpdateProfile(const Damage& damage, bigtime_t start)
+{
+#ifdef PROFILE_MESSAGE_LOOP
+	bigtime_t now = system_time();
+	bigtime_t copyTime = now - start;
+	bigtime_t latency = now - damage.time;
+
+	int32 count = damage.region.CountRects();
+	for (int32 i = 0; i < count; i++) {
+		clipping_rect rect = damage.region.RectAtInt(i);
+		fProfile.copied_pixels += (int64)(rect.right - rect.left + 1)
+			* (rect.bottom - rect.top + 1);
+	}
+
+	fProfile.frames++;
+	fProfile.damage_rects += damage.rects;
+	fProfile.copied_rects += count;
+	fProfile.copy_time += copyTime;
+	fProfile.max_copy_time = max_c(fProfile.max_copy_time, copyTime);
+	fProfile.latency += latency;
+	fProfile.max_latency = max_c(fProfile.max_latency, latency);
+
+	if (now - fProfileStart >= kProfileInterval) {
+		print_frame_profile(fProfile, now - fProfileStart);
+		memset(&fProfile, 0, sizeof(fProfile));
+		fProfileStart = now;
+	}
+#endif
+}
+
+
+/*static*/ status_t
+UpdateQueue::_ThreadEntry(void* data)
+{
+	return ((UpdateQueue*)data)->_Thread();
+}
+
+
+status_t
+UpdateQueue::_Thread()
+{
+	while (acquire_sem(fSemaphore) == B_OK) {
+		_WaitForFrame();
+
+		Damage damage;
+		if (!_TakeDamage(damage))
+			continue;
+
+		if (fInterface->LockParallelAccess()) {
+			_CopyToFront(damage);
+			fInterface->UnlockParallelAccess();
+		}
+
+		fLastFrame = system_time();
+	}
+
+	return B_OK;
+}
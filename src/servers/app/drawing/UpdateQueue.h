@@ -0,0 +1,81 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef UPDATE_QUEUE_H
+#define UPDATE_QUEUE_H
+
+
+#include <Locker.h>
+#include <OS.h>
+#include <Region.h>
+
+#include "ProfileMessageSupport.h"
+
+
+class HWInterface;
+struct TileContext;
+
+
+/*!	Collects the areas of the back buffer that have been drawn to, and
+	copies them to the front buffer once per frame, right after the retrace
+	if the graphics driver supports waiting for it.
+
+	The damage of all windows within a frame is merged into a single region,
+	so that areas that are drawn to several times in a frame are only copied
+	once, and the cursor is only composited once.
+*/
+class UpdateQueue {
+public:
+								UpdateQueue(HWInterface* interface);
+								~UpdateQueue();
+
+			status_t			InitCheck() const;
+
+			void				AddRegion(const BRegion& region);
+
+			// copies the pending damage right away, the caller must not hold
+			// the parallel access lock of the HWInterface
+			void				Flush();
+
+private:
+			struct CopyTile;
+
+			struct Damage {
+				BRegion			region;
+				bigtime_t		time;
+					// when the first rect was added
+				int32			rects;
+					// how many rects were added
+			};
+
+			bool				_TakeDamage(Damage& damage);
+			void				_WaitForFrame();
+			bigtime_t			_FrameInterval() const;
+			void				_CopyToFront(Damage& damage);
+			void				_CopyTile(const BRegion& region,
+									const clipping_rect& tile);
+
+			void				_UpdateProfile(const Damage& damage,
+									bigtime_t start);
+
+	static	status_t			_ThreadEntry(void* data);
+			status_t			_Thread();
+
+private:
+			HWInterface*		fInterface;
+
+			BLocker				fLock;
+			Damage				fDamage;
+			bool				fScheduled;
+
+			sem_id				fSemaphore;
+			thread_id			fThread;
+			bigtime_t			fLastFrame;
+
+			frame_profile		fProfile;
+			bigtime_t			fProfileStart;
+};
+
+
+#endif	// UPDATE_QUEUE_H
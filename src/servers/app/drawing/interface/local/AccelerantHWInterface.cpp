@@ -203,7 +203,14 @@ AccelerantHWInterface::Initialize()
 			// _OpenAccelerant() failed, try to open next graphics card
 		}
 
-		return fCardFD >= 0 ? B_OK : fCardFD;
+		if (fCardFD < 0)
+			return fCardFD;
+
+		// without it, drawing is just copied to the screen right away
+		if (_StartUpdateQueue() != B_OK)
+			ATRACE(("Failed to start the update queue\n"));
+
+		return B_OK;
 	}
 	return ret;
 }
@@ -440,6 +447,8 @@ AccelerantHWInterface::_UpdateHooksAfterModeChange()
 status_t
 AccelerantHWInterface::Shutdown()
 {
+	_StopUpdateQueue();
+
 	if (fAccelerantHook != NULL) {
 		uninit_accelerant uninitAccelerant
 			= (uninit_accelerant)fAccelerantHook(B_UNINIT_ACCELERANT, NULL);
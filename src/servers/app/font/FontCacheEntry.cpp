@@ -26,6 +26,7 @@
 
 #include "FontCacheEntry.h"
 
+#include <limits.h>
 #include <string.h>
 
 #include <new>
@@ -34,7 +35,6 @@
 
 #include <agg_array.h>
 #include <utf8_functions.h>
-#include <util/OpenHashTable.h>
 
 #include "GlobalSubpixelSettings.h"
 
@@ -42,87 +42,232 @@
 BLocker FontCacheEntry::sUsageUpdateLock("FontCacheEntry usage lock");
 
 
+// The glyph table is read without holding any lock, so its slots and the
+// table itself are only accessed atomically.
+template<typename Type> static inline Type*
+atomic_pointer_get(Type* const* pointer)
+{
+#if LONG_MAX == INT_MAX
+	return (Type*)atomic_get((int32*)pointer);
+#else
+	return (Type*)atomic_get64((int64*)pointer);
+#endif
+}
+
+
+template<typename Type> static inline void
+atomic_pointer_set(Type** pointer, Type* value)
+{
+#if LONG_MAX == INT_MAX
+	atomic_set((int32*)pointer, (int32)value);
+#else
+	atomic_set64((int64*)pointer, (int64)value);
+#endif
+}
+
+
+/*!	Stores the glyphs of a FontCacheEntry.
+
+	The glyphs and their rendered data are allocated one after the other from
+	large chunks of memory, the glyph atlas, and are only freed together with
+	the pool. Lookups are done in an open addressing hash table that can be
+	read without locking: the writer, which has to hold the write lock of the
+	entry, only ever publishes complete glyphs into empty slots. When the table
+	needs to grow, a copy is published instead, and the old table is kept
+	until the pool is deleted, as readers might still be looking at it.
+*/
 class FontCacheEntry::GlyphCachePool {
 	// This class needs to be defined before any inline functions, as otherwise
 	// gcc2 will barf in debug mode.
-	struct GlyphHashTableDefinition {
-		typedef uint32		KeyType;
-		typedef	GlyphCache	ValueType;
-
-		size_t HashKey(uint32 key) const
-		{
-			return key;
-		}
+	struct GlyphTable {
+		GlyphTable*		previous;
+		uint32			size;
+		GlyphCache*		slots[1];
+	};
 
-		size_t Hash(GlyphCache* value) const
-		{
-			return value->glyph_index;
-		}
+	struct AtlasChunk {
+		AtlasChunk*		next;
+		size_t			size;
+		size_t			used;
+	};
 
-		bool Compare(uint32 key, GlyphCache* value) const
-		{
-			return value->glyph_index == key;
-		}
+	static const uint32 kInitialTableSize = 128;
+	static const size_t kAtlasChunkSize = 32 * 1024;
+	static const size_t kAtlasAlignment = 8;
+	static const size_t kAtlasChunkHeaderSize
+		= (sizeof(AtlasChunk) + kAtlasAlignment - 1) & ~(kAtlasAlignment - 1);
 
-		GlyphCache*& GetLink(GlyphCache* value) const
-		{
-			return value->hash_link;
-		}
-	};
 public:
 	GlyphCachePool()
+		:
+		fTable(NULL),
+		fCount(0),
+		fChunks(NULL)
 	{
 	}
 
 	~GlyphCachePool()
 	{
-		GlyphCache* glyph = fGlyphTable.Clear(true);
-		while (glyph != NULL) {
-			GlyphCache* next = glyph->hash_link;
-			delete glyph;
-			glyph = next;
+		GlyphTable* table = fTable;
+		while (table != NULL) {
+			GlyphTable* previous = table->previous;
+			free(table);
+			table = previous;
+		}
+
+		// the glyphs don't need to be destructed
+		AtlasChunk* chunk = fChunks;
+		while (chunk != NULL) {
+			AtlasChunk* next = chunk->next;
+			free(chunk);
+			chunk = next;
 		}
 	}
 
 	status_t Init()
 	{
-		return fGlyphTable.Init();
+		fTable = _CreateTable(kInitialTableSize);
+		if (fTable == NULL)
+			return B_NO_MEMORY;
+
+		return B_OK;
 	}
 
 	const GlyphCache* FindGlyph(uint32 glyphIndex) const
 	{
-		return fGlyphTable.Lookup(glyphIndex);
+		const GlyphTable* table = atomic_pointer_get(&fTable);
+		uint32 mask = table->size - 1;
+
+		// The table is never filled completely, so there always is an empty
+		// slot to end the search.
+		for (uint32 slot = glyphIndex & mask;; slot = (slot + 1) & mask) {
+			const GlyphCache* glyph = atomic_pointer_get(&table->slots[slot]);
+			if (glyph == NULL || glyph->glyph_index == glyphIndex)
+				return glyph;
+		}
 	}
 
-	GlyphCache* CacheGlyph(uint32 glyphIndex,
+	/*!	Allocates a new glyph and room for its data in the atlas. The glyph is
+		not visible to FindGlyph() before it's passed to CacheGlyph().
+	*/
+	GlyphCache* AllocateGlyph(uint32 glyphIndex,
 		uint32 dataSize, glyph_data_type dataType, const agg::rect_i& bounds,
 		float advanceX, float advanceY, float preciseAdvanceX,
 		float preciseAdvanceY, float insetLeft, float insetRight)
 	{
-		GlyphCache* glyph = fGlyphTable.Lookup(glyphIndex);
-		if (glyph != NULL)
+		if (FindGlyph(glyphIndex) != NULL)
+			return NULL;
+
+		void* glyph = _Allocate(sizeof(GlyphCache));
+		if (glyph == NULL)
 			return NULL;
 
-		glyph = new(std::nothrow) GlyphCache(glyphIndex, dataSize, dataType,
+		uint8* data = NULL;
+		if (dataSize > 0) {
+			data = (uint8*)_Allocate(dataSize);
+			if (data == NULL)
+				return NULL;
+		}
+
+		return new(glyph) GlyphCache(glyphIndex, data, dataSize, dataType,
 			bounds, advanceX, advanceY, preciseAdvanceX, preciseAdvanceY,
 			insetLeft, insetRight);
-		if (glyph == NULL || glyph->data == NULL) {
-			delete glyph;
+	}
+
+	/*!	Makes a glyph returned by AllocateGlyph() visible to readers. Its
+		data must already be complete at this point.
+	*/
+	const GlyphCache* CacheGlyph(GlyphCache* glyph)
+	{
+		if (glyph == NULL)
 			return NULL;
-		}
 
-		// TODO: The HashTable grows without bounds. We should cleanup
-		// older entries from time to time.
+		// Keep the load factor below 3/4; if the table cannot grow, the glyph
+		// can still be used, it's just not cached.
+		if ((fCount + 1) * 4 > fTable->size * 3 && !_Grow()
+			&& fCount + 2 > fTable->size) {
+			return glyph;
+		}
 
-		fGlyphTable.Insert(glyph);
+		// TODO: The atlas grows without bounds. We should cleanup older
+		// entries from time to time.
 
+		_Insert(fTable, glyph);
+		fCount++;
 		return glyph;
 	}
 
 private:
-	typedef BOpenHashTable<GlyphHashTableDefinition> GlyphTable;
+	static GlyphTable* _CreateTable(uint32 size)
+	{
+		GlyphTable* table = (GlyphTable*)calloc(1,
+			sizeof(GlyphTable) + (size - 1) * sizeof(GlyphCache*));
+		if (table == NULL)
+			return NULL;
+
+		table->size = size;
+		return table;
+	}
+
+	static void _Insert(GlyphTable* table, GlyphCache* glyph)
+	{
+		uint32 mask = table->size - 1;
+		uint32 slot = glyph->glyph_index & mask;
+		while (table->slots[slot] != NULL)
+			slot = (slot + 1) & mask;
+
+		atomic_pointer_set(&table->slots[slot], glyph);
+	}
+
+	bool _Grow()
+	{
+		GlyphTable* table = _CreateTable(fTable->size * 2);
+		if (table == NULL)
+			return false;
+
+		for (uint32 slot = 0; slot < fTable->size; slot++) {
+			if (fTable->slots[slot] != NULL)
+				_Insert(table, fTable->slots[slot]);
+		}
 
-	GlyphTable	fGlyphTable;
+		table->previous = fTable;
+		atomic_pointer_set(&fTable, table);
+		return true;
+	}
+
+	void* _Allocate(size_t size)
+	{
+		size = (size + kAtlasAlignment - 1) & ~(kAtlasAlignment - 1);
+
+		AtlasChunk* chunk = fChunks;
+		if (chunk == NULL || chunk->used + size > chunk->size) {
+			size_t chunkSize = max_c(size, kAtlasChunkSize);
+			chunk = (AtlasChunk*)malloc(kAtlasChunkHeaderSize + chunkSize);
+			if (chunk == NULL)
+				return NULL;
+
+			chunk->size = chunkSize;
+			chunk->used = 0;
+
+			if (fChunks != NULL && size > kAtlasChunkSize / 4) {
+				// Keep filling the current chunk, this one is used up anyway
+				chunk->next = fChunks->next;
+				fChunks->next = chunk;
+			} else {
+				chunk->next = fChunks;
+				fChunks = chunk;
+			}
+		}
+
+		void* buffer = (uint8*)chunk + kAtlasChunkHeaderSize + chunk->used;
+		chunk->used += size;
+		return buffer;
+	}
+
+private:
+	GlyphTable*	fTable;
+	uint32		fCount;
+	AtlasChunk*	fChunks;
 };
 
 
@@ -276,9 +421,9 @@ render_as_zero_width(uint32 glyphCode)
 
 
 const GlyphCache*
-FontCacheEntry::CachedGlyph(uint32 glyphCode)
+FontCacheEntry::CachedGlyph(uint32 glyphCode) const
 {
-	// Only requires a read lock.
+	// Does not require any lock, the entry only needs to stay referenced.
 	return fGlyphCache->FindGlyph(glyphCode);
 }
 
@@ -303,7 +448,8 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 	// glyph. The next time it will be found (by glyphCode).
 
 	// NOTE: Both this and the fallback FontCacheEntry are expected to be
-	// write-locked!
+	// write-locked! The write lock only serializes the creation of glyphs,
+	// CachedGlyph() may run concurrently.
 
 	const GlyphCache* glyph = fGlyphCache->FindGlyph(glyphCode);
 	if (glyph != NULL)
@@ -321,8 +467,9 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 	if (glyphIndex == 0) {
 		if (render_as_zero_width(glyphCode)) {
 			// cache and return a zero width glyph
-			return fGlyphCache->CacheGlyph(glyphCode, 0, glyph_data_invalid,
-				agg::rect_i(0, 0, -1, -1), 0, 0, 0, 0, 0, 0);
+			return fGlyphCache->CacheGlyph(fGlyphCache->AllocateGlyph(
+				glyphCode, 0, glyph_data_invalid, agg::rect_i(0, 0, -1, -1),
+				0, 0, 0, 0, 0, 0));
 		}
 
 		// reset to our engine
@@ -334,14 +481,18 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 	}
 
 	if (engine->PrepareGlyph(glyphIndex)) {
-		glyph = fGlyphCache->CacheGlyph(glyphCode,
+		GlyphCache* newGlyph = fGlyphCache->AllocateGlyph(glyphCode,
 			engine->DataSize(), engine->DataType(), engine->Bounds(),
 			engine->AdvanceX(), engine->AdvanceY(),
 			engine->PreciseAdvanceX(), engine->PreciseAdvanceY(),
 			engine->InsetLeft(), engine->InsetRight());
 
-		if (glyph != NULL)
-			engine->WriteGlyphTo(glyph->data);
+		if (newGlyph != NULL) {
+			// readers don't lock, so the data must be written before the
+			// glyph is published
+			engine->WriteGlyphTo(newGlyph->data);
+			glyph = fGlyphCache->CacheGlyph(newGlyph);
+		}
 	}
 
 	return glyph;
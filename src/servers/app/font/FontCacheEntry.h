@@ -41,14 +41,19 @@
 #include "Transformable.h"
 
 
+/*!	A glyph as it is stored in the glyph atlas of a FontCacheEntry. Both the
+	glyph and its data are never changed or freed as long as the entry exists,
+	so they can be used without holding the entry lock.
+*/
 struct GlyphCache {
-	GlyphCache(uint32 glyphIndex, uint32 dataSize, glyph_data_type dataType,
-			const agg::rect_i& bounds, float advanceX, float advanceY,
+	GlyphCache(uint32 glyphIndex, uint8* data, uint32 dataSize,
+			glyph_data_type dataType, const agg::rect_i& bounds,
+			float advanceX, float advanceY,
 			float preciseAdvanceX, float preciseAdvanceY,
 			float insetLeft, float insetRight)
 		:
 		glyph_index(glyphIndex),
-		data((uint8*)malloc(dataSize)),
+		data(data),
 		data_size(dataSize),
 		data_type(dataType),
 		bounds(bounds),
@@ -57,16 +62,10 @@ struct GlyphCache {
 		precise_advance_x(preciseAdvanceX),
 		precise_advance_y(preciseAdvanceY),
 		inset_left(insetLeft),
-		inset_right(insetRight),
-		hash_link(NULL)
+		inset_right(insetRight)
 	{
 	}
 
-	~GlyphCache()
-	{
-		free(data);
-	}
-
 	uint32			glyph_index;
 	uint8*			data;
 	uint32			data_size;
@@ -78,8 +77,6 @@ struct GlyphCache {
 	float			precise_advance_y;
 	float			inset_left;
 	float			inset_right;
-
-	GlyphCache*		hash_link;
 };
 
 class FontCache;
@@ -110,7 +107,7 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 			bool				HasGlyphs(const char* utf8String,
 									ssize_t glyphCount) const;
 
-			const GlyphCache*	CachedGlyph(uint32 glyphCode);
+			const GlyphCache*	CachedGlyph(uint32 glyphCode) const;
 			const GlyphCache*	CreateGlyph(uint32 glyphCode,
 									FontCacheEntry* fallbackEntry = NULL);
 			bool				CanCreateGlyph(uint32 glyphCode);
@@ -285,9 +285,10 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 		if (entry == NULL)
 			return false;
 		pCacheReference->SetTo(entry);
-		if (!pCacheReference->ReadLock())
-			return false;
-	} // else the entry was already used and is still locked
+	} // else the entry was already used and might still be locked
+
+	// Looking up cached glyphs does not need the entry lock, it's only
+	// acquired once the font engine is needed.
 
 	consumer.Start();
 
@@ -314,8 +315,13 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 			x = offsets[index].x;
 			y = offsets[index].y;
 		} else {
-			if (spacing == B_STRING_SPACING)
+			if (spacing == B_STRING_SPACING) {
+				if (!pCacheReference->WriteLocked()
+					&& !pCacheReference->ReadLock()) {
+					return false;
+				}
 				entry->GetKerning(lastCharCode, charCode, &advanceX, &advanceY);
+			}
 
 			x += advanceX;
 			y += advanceY;
@@ -379,12 +385,14 @@ GlyphLayoutEngine::_CreateGlyph(FontCacheReference& cacheReference,
 {
 	FontCacheEntry* entry = cacheReference.Entry();
 
-	// Avoid loading the fallbacks if our font can create the glyph.
-	if (entry->CanCreateGlyph(charCode)) {
-		if (cacheReference.WriteLock())
-			return entry->CreateGlyph(charCode);
+	// Creating a glyph needs the write lock anyway, and the font engine must
+	// not be used without holding a lock.
+	if (!cacheReference.WriteLock())
 		return NULL;
-	}
+
+	// Avoid loading the fallbacks if our font can create the glyph.
+	if (entry->CanCreateGlyph(charCode))
+		return entry->CreateGlyph(charCode);
 
 	if (fallbacks.IsEmpty())
 		PopulateFallbacks(fallbacks, font, forceVector);
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "acpi.h"
+
+#include <KernelExport.h>
+
+#include <boot/stage2.h>
+#include <boot/arch/x86/arch_numa.h>
+
+#include <string.h>
+
+
+//#define TRACE_NUMA
+#ifdef TRACE_NUMA
+#	define TRACE(x...) dprintf(x)
+#else
+#	define TRACE(x...) ;
+#endif
+
+
+static uint32 sProximityDomains[MAX_NUMA_NODES];
+static uint32 sNodeCount;
+
+
+/*!	Maps an ACPI proximity domain to a node number.
+	Returns -1 if there are too many domains.
+*/
+static int32
+node_for_proximity_domain(uint32 domain)
+{
+	for (uint32 i = 0; i < sNodeCount; i++) {
+		if (sProximityDomains[i] == domain)
+			return i;
+	}
+
+	if (sNodeCount == MAX_NUMA_NODES)
+		return -1;
+
+	sProximityDomains[sNodeCount] = domain;
+	return sNodeCount++;
+}
+
+
+static int32
+cpu_for_apic_id(uint32 apicID)
+{
+	for (uint32 i = 0; i < gKernelArgs.num_cpus; i++) {
+		if (gKernelArgs.arch_args.cpu_apic_id[i] == apicID)
+			return i;
+	}
+
+	return -1;
+}
+
+
+static bool
+set_cpu_node(uint32 apicID, uint32 domain)
+{
+	int32 node = node_for_proximity_domain(domain);
+	if (node < 0)
+		return false;
+
+	int32 cpu = cpu_for_apic_id(apicID);
+	if (cpu >= 0)
+		gKernelArgs.cpu_numa_node[cpu] = node;
+
+	TRACE("numa: APIC %" B_PRIu32 " (cpu %" B_PRId32 ") is in node %" B_PRId32
+		"\n", apicID, cpu, node);
+	return true;
+}
+
+
+static bool
+add_memory_range(uint64 start, uint64 size, uint32 domain)
+{
+	int32 node = node_for_proximity_domain(domain);
+	if (node < 0)
+		return false;
+
+	uint32 count = gKernelArgs.num_numa_memory_ranges;
+	if (count == MAX_NUMA_MEMORY_RANGES) {
+		dprintf("numa: too many memory ranges, ignoring %#" B_PRIx64 " - %#"
+			B_PRIx64 "\n", start, start + size);
+		return true;
+	}
+
+	gKernelArgs.numa_memory_range[count].start = start;
+	gKernelArgs.numa_memory_range[count].size = size;
+	gKernelArgs.numa_memory_range[count].node = node;
+	gKernelArgs.num_numa_memory_ranges = count + 1;
+
+	TRACE("numa: memory %#" B_PRIx64 " - %#" B_PRIx64 " is in node %" B_PRId32
+		"\n", start, start + size, node);
+	return true;
+}
+
+
+/*!	Reads the NUMA topology from the ACPI SRAT, if there is one. Must be
+	called after the APIC IDs of the CPUs are known.
+	Processors and memory ranges are assigned to nodes numbered in the order
+	their proximity domains appear in the table.
+*/
+void
+numa_init(void)
+{
+	gKernelArgs.num_numa_nodes = 0;
+	gKernelArgs.num_numa_memory_ranges = 0;
+	memset(gKernelArgs.cpu_numa_node, 0, sizeof(gKernelArgs.cpu_numa_node));
+
+	acpi_srat* srat = (acpi_srat*)acpi_find_table(ACPI_SRAT_SIGNATURE);
+	if (srat == NULL) {
+		TRACE("numa: no SRAT found\n");
+		return;
+	}
+
+	bool success = true;
+	uint8* entry = (uint8*)srat + sizeof(acpi_srat);
+	uint8* end = (uint8*)srat + srat->header.length;
+	while (success && entry + 2 <= end && entry[1] != 0) {
+		switch (entry[0]) {
+			case ACPI_SRAT_LOCAL_APIC_AFFINITY:
+			{
+				acpi_srat_local_apic_affinity* affinity
+					= (acpi_srat_local_apic_affinity*)entry;
+				if ((affinity->flags & ACPI_SRAT_AFFINITY_ENABLED) == 0)
+					break;
+
+				uint32 domain = affinity->proximity_domain_low
+					| (uint32)affinity->proximity_domain_high[0] << 8
+					| (uint32)affinity->proximity_domain_high[1] << 16
+					| (uint32)affinity->proximity_domain_high[2] << 24;
+				success = set_cpu_node(affinity->apic_id, domain);
+				break;
+			}
+
+			case ACPI_SRAT_LOCAL_X2_APIC_AFFINITY:
+			{
+				acpi_srat_local_x2_apic_affinity* affinity
+					= (acpi_srat_local_x2_apic_affinity*)entry;
+				if ((affinity->flags & ACPI_SRAT_AFFINITY_ENABLED) == 0)
+					break;
+
+				success = set_cpu_node(affinity->x2apic_id,
+					affinity->proximity_domain);
+				break;
+			}
+
+			case ACPI_SRAT_MEMORY_AFFINITY:
+			{
+				acpi_srat_memory_affinity* affinity
+					= (acpi_srat_memory_affinity*)entry;
+				if ((affinity->flags & ACPI_SRAT_AFFINITY_ENABLED) == 0
+					|| affinity->length_bytes == 0) {
+					break;
+				}
+
+				success = add_memory_range(affinity->base_address,
+					affinity->length_bytes, affinity->proximity_domain);
+				break;
+			}
+		}
+
+		entry += entry[1];
+	}
+
+	if (!success || sNodeCount < 2) {
+		// either there is nothing to gain, or we can't represent the topology
+		if (!success) {
+			dprintf("numa: more than %d proximity domains, ignoring SRAT\n",
+				MAX_NUMA_NODES);
+		}
+
+		gKernelArgs.num_numa_memory_ranges = 0;
+		memset(gKernelArgs.cpu_numa_node, 0,
+			sizeof(gKernelArgs.cpu_numa_node));
+		return;
+	}
+
+	gKernelArgs.num_numa_nodes = sNodeCount;
+	dprintf("numa: %" B_PRIu32 " nodes, %" B_PRIu32 " memory ranges\n",
+		sNodeCount, gKernelArgs.num_numa_memory_ranges);
+}
@@ -18,6 +18,7 @@
 #include <safemode.h>
 #include <boot/stage2.h>
 #include <boot/menu.h>
+#include <boot/arch/x86/arch_numa.h>
 #include <arch/x86/apic.h>
 #include <arch/x86/arch_cpu.h>
 #include <arch/x86/arch_smp.h>
@@ -659,8 +660,10 @@ smp_init(void)
 	// first try to find ACPI tables to get MP configuration as it handles
 	// physical as well as logical MP configurations as in multiple cpus,
 	// multiple cores or hyper threading.
-	if (smp_do_acpi_config() == B_OK)
+	if (smp_do_acpi_config() == B_OK) {
+		numa_init();
 		return;
+	}
 
 	// then try to find MPS tables and do configuration based on them
 	for (int32 i = 0; smp_scan_spots[i].length > 0; i++) {
@@ -376,9 +376,9 @@ X86PagingMethod64Bit::PageTableForAddress(uint64* virtualPMLTop,
 		mapCount++;
 	}
 
-	// No proper large page support at the moment, but they are used for the
-	// physical map area. Ensure that nothing tries to treat that as normal
-	// address space.
+	// Large pages are used for the physical map area, and the translation map
+	// splits its own ones before looking up their page table. Ensure that
+	// nothing tries to treat them as normal address space.
 	ASSERT(!(*pde & X86_64_PDE_LARGE_PAGE));
 
 	return (uint64*)pageMapper->GetPageTableAt(*pde & X86_64_PDE_ADDRESS_MASK);
@@ -33,6 +33,41 @@
 #endif
 
 
+// the flags of a large page entry that apply to the pages of its range
+static const uint64 kLargePageInheritedFlags = X86_64_PDE_PRESENT
+	| X86_64_PDE_WRITABLE | X86_64_PDE_USER | X86_64_PDE_WRITE_THROUGH
+	| X86_64_PDE_CACHING_DISABLED | X86_64_PDE_ACCESSED | X86_64_PDE_DIRTY
+	| X86_64_PDE_GLOBAL | X86_64_PDE_NOT_EXECUTABLE;
+
+
+static inline bool
+is_splittable_large_page(uint64 entry)
+{
+	const uint64 flags = X86_64_PDE_PRESENT | X86_64_PDE_LARGE_PAGE
+		| X86_64_PDE_SPLITTABLE;
+	return (entry & flags) == flags;
+}
+
+
+static inline uint64
+protection_flags(uint32 attributes)
+{
+	uint64 flags = 0;
+	if ((attributes & B_USER_PROTECTION) != 0) {
+		flags = X86_64_PTE_USER;
+		if ((attributes & B_WRITE_AREA) != 0)
+			flags |= X86_64_PTE_WRITABLE;
+		if ((attributes & B_EXECUTE_AREA) == 0
+			&& x86_check_feature(IA32_FEATURE_AMD_EXT_NX, FEATURE_EXT_AMD)) {
+			flags |= X86_64_PTE_NOT_EXECUTABLE;
+		}
+	} else if ((attributes & B_KERNEL_WRITE_AREA) != 0)
+		flags = X86_64_PTE_WRITABLE;
+
+	return flags;
+}
+
+
 // #pragma mark - X86VMTranslationMap64Bit
 
 
@@ -74,6 +109,10 @@ X86VMTranslationMap64Bit::~X86VMTranslationMap64Bit()
 					if ((virtualPageDir[k] & X86_64_PDE_PRESENT) == 0)
 						continue;
 
+					// the pages of large pages belong to their caches
+					if ((virtualPageDir[k] & X86_64_PDE_LARGE_PAGE) != 0)
+						continue;
+
 					address = virtualPageDir[k] & X86_64_PDE_ADDRESS_MASK;
 					page = vm_lookup_page(address / B_PAGE_SIZE);
 					if (page == NULL) {
@@ -107,6 +146,12 @@ X86VMTranslationMap64Bit::~X86VMTranslationMap64Bit()
 			vm_page_free_etc(NULL, page, &reservation);
 		}
 
+		// free the page tables that were kept for splitting large pages
+		while (vm_page* page = fSpareTables.RemoveHead()) {
+			DEBUG_PAGE_ACCESS_START(page);
+			vm_page_free_etc(NULL, page, &reservation);
+		}
+
 		vm_page_unreserve_pages(&reservation);
 
 		fPageMapper->Delete();
@@ -233,6 +278,82 @@ X86VMTranslationMap64Bit::Map(addr_t virtualAddress, phys_addr_t physicalAddress
 }
 
 
+size_t
+X86VMTranslationMap64Bit::LargePageSize() const
+{
+	return k64BitPageTableRange;
+}
+
+
+status_t
+X86VMTranslationMap64Bit::MapLargePage(addr_t virtualAddress,
+	phys_addr_t physicalAddress, uint32 attributes, uint32 memoryType,
+	vm_page_reservation* reservation)
+{
+	TRACE("X86VMTranslationMap64Bit::MapLargePage(%#" B_PRIxADDR ", %#"
+		B_PRIxPHYSADDR ")\n", virtualAddress, physicalAddress);
+
+	ASSERT(virtualAddress % k64BitPageTableRange == 0);
+	ASSERT(physicalAddress % k64BitPageTableRange == 0);
+
+	// The PAT bit is at a different position in large page entries, and we
+	// wouldn't be able to split them without further ado.
+	uint64 memoryTypeFlags
+		= X86PagingMethod64Bit::MemoryTypeToPageTableEntryFlags(memoryType);
+	if ((memoryTypeFlags & X86_64_PTE_PAT) != 0)
+		return B_NOT_SUPPORTED;
+
+	ThreadCPUPinner pinner(thread_get_current_thread());
+
+	uint64* pde = X86PagingMethod64Bit::PageDirectoryEntryForAddress(
+		fPagingStructures->VirtualPMLTop(), virtualAddress, fIsKernelMap,
+		true, reservation, fPageMapper, fMapCount);
+	ASSERT(pde != NULL);
+
+	// Every large page gets a page table assigned, so that it can be split
+	// later on without having to allocate memory. If there is an empty page
+	// table already, we take that one.
+	uint64 oldEntry = *pde;
+	vm_page* pageTable;
+	if ((oldEntry & X86_64_PDE_PRESENT) != 0) {
+		if ((oldEntry & X86_64_PDE_LARGE_PAGE) != 0)
+			return B_BUSY;
+
+		uint64* virtualPageTable = (uint64*)fPageMapper->GetPageTableAt(
+			oldEntry & X86_64_PDE_ADDRESS_MASK);
+		for (uint32 i = 0; i < k64BitTableEntryCount; i++) {
+			if ((virtualPageTable[i] & X86_64_PTE_PRESENT) != 0)
+				return B_BUSY;
+		}
+
+		pageTable = vm_lookup_page(
+			(oldEntry & X86_64_PDE_ADDRESS_MASK) / B_PAGE_SIZE);
+		fMapCount--;
+	} else {
+		pageTable = vm_page_allocate_page(reservation, PAGE_STATE_WIRED);
+		DEBUG_PAGE_ACCESS_END(pageTable);
+	}
+
+	fSpareTables.Add(pageTable);
+
+	X86PagingMethod64Bit::SetTableEntry(pde,
+		(physicalAddress & X86_64_PDE_ADDRESS_MASK)
+			| X86_64_PDE_PRESENT | X86_64_PDE_LARGE_PAGE
+			| X86_64_PDE_SPLITTABLE
+			| (fIsKernelMap ? X86_64_PDE_GLOBAL : 0)
+			| memoryTypeFlags | protection_flags(attributes));
+
+	// The processor might have cached the page table entry.
+	if ((oldEntry & X86_64_PDE_PRESENT) != 0)
+		InvalidatePage(virtualAddress);
+
+	fMapCount += k64BitTableEntryCount;
+	atomic_add(&gMappedLargePagesCount, 1);
+
+	return B_OK;
+}
+
+
 status_t
 X86VMTranslationMap64Bit::Unmap(addr_t start, addr_t end)
 {
@@ -246,9 +367,7 @@ X86VMTranslationMap64Bit::Unmap(addr_t start, addr_t end)
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
-		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
-			fPagingStructures->VirtualPMLTop(), start, fIsKernelMap, false,
-			NULL, fPageMapper, fMapCount);
+		uint64* pageTable = _PageTableForAddress(start);
 		if (pageTable == NULL) {
 			// Move on to the next page table.
 			start = ROUNDUP(start + 1, k64BitPageTableRange);
@@ -296,9 +415,7 @@ X86VMTranslationMap64Bit::DebugMarkRangePresent(addr_t start, addr_t end,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
-		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
-			fPagingStructures->VirtualPMLTop(), start, fIsKernelMap, false,
-			NULL, fPageMapper, fMapCount);
+		uint64* pageTable = _PageTableForAddress(start);
 		if (pageTable == NULL) {
 			// Move on to the next page table.
 			start = ROUNDUP(start + 1, k64BitPageTableRange);
@@ -347,9 +464,7 @@ X86VMTranslationMap64Bit::UnmapPage(VMArea* area, addr_t address,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	// Look up the page table for the virtual address.
-	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
-		fPagingStructures->VirtualPMLTop(), address, fIsKernelMap,
-		false, NULL, fPageMapper, fMapCount);
+	uint64* entry = _PageTableEntryForAddress(address);
 	if (entry == NULL)
 		return B_ENTRY_NOT_FOUND;
 
@@ -427,9 +542,19 @@ X86VMTranslationMap64Bit::UnmapPages(VMArea* area, addr_t base, size_t size,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
-		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
-			fPagingStructures->VirtualPMLTop(), start, fIsKernelMap, false,
-			NULL, fPageMapper, fMapCount);
+		// Large pages that are unmapped completely don't need to be split.
+		if (start % k64BitPageTableRange == 0
+			&& end - start >= k64BitPageTableRange - 1) {
+			uint64* pde = _PageDirectoryEntryForAddress(start);
+			if (pde != NULL && is_splittable_large_page(*pde)) {
+				_UnmapLargePage(area, pde, start, updatePageQueue,
+					deletingAddressSpace, &queue);
+				start += k64BitPageTableRange;
+				continue;
+			}
+		}
+
+		uint64* pageTable = _PageTableForAddress(start);
 		if (pageTable == NULL) {
 			// Move on to the next page table.
 			start = ROUNDUP(start + 1, k64BitPageTableRange);
@@ -557,24 +682,50 @@ X86VMTranslationMap64Bit::Protect(addr_t start, addr_t end, uint32 attributes,
 		", %#" B_PRIx32 ")\n", start, end, attributes);
 
 	// compute protection flags
-	uint64 newProtectionFlags = 0;
-	if ((attributes & B_USER_PROTECTION) != 0) {
-		newProtectionFlags = X86_64_PTE_USER;
-		if ((attributes & B_WRITE_AREA) != 0)
-			newProtectionFlags |= X86_64_PTE_WRITABLE;
-		if ((attributes & B_EXECUTE_AREA) == 0
-			&& x86_check_feature(IA32_FEATURE_AMD_EXT_NX, FEATURE_EXT_AMD)) {
-			newProtectionFlags |= X86_64_PTE_NOT_EXECUTABLE;
-		}
-	} else if ((attributes & B_KERNEL_WRITE_AREA) != 0)
-		newProtectionFlags = X86_64_PTE_WRITABLE;
+	uint64 newProtectionFlags = protection_flags(attributes);
+	uint64 memoryTypeFlags
+		= X86PagingMethod64Bit::MemoryTypeToPageTableEntryFlags(memoryType);
 
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
-		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
-			fPagingStructures->VirtualPMLTop(), start, fIsKernelMap, false,
-			NULL, fPageMapper, fMapCount);
+		uint64* pde = _PageDirectoryEntryForAddress(start);
+		if (pde != NULL && is_splittable_large_page(*pde)) {
+			// Large pages only need to be split if their protection actually
+			// changes for only a part of them.
+			addr_t largePageStart = ROUNDDOWN(start, k64BitPageTableRange);
+			uint64 entry = *pde;
+			if ((entry & (X86_64_PTE_PROTECTION_MASK
+					| X86_64_PTE_MEMORY_TYPE_MASK))
+					== (newProtectionFlags | memoryTypeFlags)) {
+				start = largePageStart + k64BitPageTableRange;
+				continue;
+			}
+
+			if (start == largePageStart
+				&& end - start >= k64BitPageTableRange - 1
+				&& (memoryTypeFlags & X86_64_PTE_PAT) == 0) {
+				uint64 oldEntry;
+				while (true) {
+					oldEntry = X86PagingMethod64Bit::TestAndSetTableEntry(pde,
+						(entry & ~(X86_64_PTE_PROTECTION_MASK
+								| X86_64_PTE_MEMORY_TYPE_MASK))
+							| newProtectionFlags | memoryTypeFlags,
+						entry);
+					if (oldEntry == entry)
+						break;
+					entry = oldEntry;
+				}
+
+				if ((oldEntry & X86_64_PDE_ACCESSED) != 0)
+					InvalidatePage(start);
+
+				start += k64BitPageTableRange;
+				continue;
+			}
+		}
+
+		uint64* pageTable = _PageTableForAddress(start);
 		if (pageTable == NULL) {
 			// Move on to the next page table.
 			start = ROUNDUP(start + 1, k64BitPageTableRange);
@@ -599,9 +750,7 @@ X86VMTranslationMap64Bit::Protect(addr_t start, addr_t end, uint32 attributes,
 					&pageTable[index],
 					(entry & ~(X86_64_PTE_PROTECTION_MASK
 							| X86_64_PTE_MEMORY_TYPE_MASK))
-						| newProtectionFlags
-						| X86PagingMethod64Bit::MemoryTypeToPageTableEntryFlags(
-							memoryType),
+						| newProtectionFlags | memoryTypeFlags,
 					entry);
 				if (oldEntry == entry)
 					break;
@@ -629,15 +778,32 @@ X86VMTranslationMap64Bit::ClearFlags(addr_t address, uint32 flags)
 
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
-	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
-		fPagingStructures->VirtualPMLTop(), address, fIsKernelMap,
-		false, NULL, fPageMapper, fMapCount);
-	if (entry == NULL)
-		return B_OK;
-
 	uint64 flagsToClear = ((flags & PAGE_MODIFIED) ? X86_64_PTE_DIRTY : 0)
 		| ((flags & PAGE_ACCESSED) ? X86_64_PTE_ACCESSED : 0);
 
+	// The flags of a large page are shared by all of its pages. Instead of
+	// splitting it, we pass them on to the other pages.
+	uint64* pde = _PageDirectoryEntryForAddress(address);
+	if (pde != NULL && is_splittable_large_page(*pde)) {
+		uint64 oldEntry = X86PagingMethod64Bit::ClearTableEntryFlags(pde,
+			flagsToClear);
+		if ((oldEntry & flagsToClear) != 0) {
+			InvalidatePage(address);
+
+			page_num_t firstPage
+				= (oldEntry & X86_64_PDE_ADDRESS_MASK) / B_PAGE_SIZE;
+			LargePageFlagsCleared(firstPage, k64BitTableEntryCount,
+				firstPage + VADDR_TO_PTE(address),
+				(oldEntry & flagsToClear & X86_64_PDE_ACCESSED) != 0,
+				(oldEntry & flagsToClear & X86_64_PDE_DIRTY) != 0);
+		}
+		return B_OK;
+	}
+
+	uint64* entry = _PageTableEntryForAddress(address);
+	if (entry == NULL)
+		return B_OK;
+
 	uint64 oldEntry = X86PagingMethod64Bit::ClearTableEntryFlags(entry,
 		flagsToClear);
 
@@ -660,9 +826,33 @@ X86VMTranslationMap64Bit::ClearAccessedAndModified(VMArea* area, addr_t address,
 	RecursiveLocker locker(fLock);
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
-	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
-		fPagingStructures->VirtualPMLTop(), address, fIsKernelMap,
-		false, NULL, fPageMapper, fMapCount);
+	// As in ClearFlags(), the flags of a large page are passed on to its other
+	// pages. It only needs to be split, if one of its pages shall be unmapped.
+	uint64* pde = _PageDirectoryEntryForAddress(address);
+	if (pde != NULL && is_splittable_large_page(*pde)
+		&& (!unmapIfUnaccessed || (*pde & X86_64_PDE_ACCESSED) != 0)) {
+		uint64 oldEntry = X86PagingMethod64Bit::ClearTableEntryFlags(pde,
+			X86_64_PDE_ACCESSED | X86_64_PDE_DIRTY);
+
+		pinner.Unlock();
+
+		bool accessed = (oldEntry & X86_64_PDE_ACCESSED) != 0;
+		_modified = (oldEntry & X86_64_PDE_DIRTY) != 0;
+
+		if (accessed || _modified) {
+			InvalidatePage(address);
+			Flush();
+
+			page_num_t firstPage
+				= (oldEntry & X86_64_PDE_ADDRESS_MASK) / B_PAGE_SIZE;
+			LargePageFlagsCleared(firstPage, k64BitTableEntryCount,
+				firstPage + VADDR_TO_PTE(address), accessed, _modified);
+		}
+
+		return accessed;
+	}
+
+	uint64* entry = _PageTableEntryForAddress(address);
 	if (entry == NULL)
 		return false;
 
@@ -799,3 +989,159 @@ X86VMTranslationMap64Bit::PagingStructures() const
 {
 	return fPagingStructures;
 }
+
+
+uint64*
+X86VMTranslationMap64Bit::_PageDirectoryEntryForAddress(addr_t virtualAddress)
+{
+	return X86PagingMethod64Bit::PageDirectoryEntryForAddress(
+		fPagingStructures->VirtualPMLTop(), virtualAddress, fIsKernelMap,
+		false, NULL, fPageMapper, fMapCount);
+}
+
+
+/*!	Returns the page table for the given virtual address, or \c NULL if there
+	is none. If the address is mapped by a large page, it is split first.
+	The caller must have pinned the current thread.
+*/
+uint64*
+X86VMTranslationMap64Bit::_PageTableForAddress(addr_t virtualAddress)
+{
+	uint64* pde = _PageDirectoryEntryForAddress(virtualAddress);
+	if (pde == NULL || (*pde & X86_64_PDE_PRESENT) == 0)
+		return NULL;
+
+	if ((*pde & X86_64_PDE_LARGE_PAGE) != 0) {
+		// Large pages that weren't mapped by us are used for the physical map
+		// area. Ensure that nothing tries to treat that as normal address
+		// space.
+		if ((*pde & X86_64_PDE_SPLITTABLE) == 0) {
+			ASSERT_PRINT(false, "virtual address: %#" B_PRIxADDR,
+				virtualAddress);
+			return NULL;
+		}
+
+		_SplitLargePage(pde, virtualAddress);
+	}
+
+	return (uint64*)fPageMapper->GetPageTableAt(*pde & X86_64_PDE_ADDRESS_MASK);
+}
+
+
+uint64*
+X86VMTranslationMap64Bit::_PageTableEntryForAddress(addr_t virtualAddress)
+{
+	uint64* pageTable = _PageTableForAddress(virtualAddress);
+	if (pageTable == NULL)
+		return NULL;
+
+	return &pageTable[VADDR_TO_PTE(virtualAddress)];
+}
+
+
+/*!	Replaces the large page entry \a pde with one of the page tables kept for
+	this purpose, mapping the same pages with the same flags.
+	The caller must have pinned the current thread.
+*/
+void
+X86VMTranslationMap64Bit::_SplitLargePage(uint64* pde, addr_t virtualAddress)
+{
+	RecursiveLocker locker(fLock);
+
+	uint64 entry = *pde;
+	if (!is_splittable_large_page(entry))
+		return;
+
+	TRACE("X86VMTranslationMap64Bit::_SplitLargePage(%#" B_PRIxADDR ")\n",
+		virtualAddress);
+
+	vm_page* page = fSpareTables.RemoveHead();
+	if (page == NULL) {
+		panic("X86VMTranslationMap64Bit::_SplitLargePage(): no page table "
+			"left for large page at %#" B_PRIxADDR, virtualAddress);
+		return;
+	}
+
+	phys_addr_t physicalPageTable
+		= (phys_addr_t)page->physical_page_number * B_PAGE_SIZE;
+	uint64* pageTable = (uint64*)fPageMapper->GetPageTableAt(
+		physicalPageTable);
+
+	// The processor may update the accessed and dirty flags of the large page
+	// in the meantime, so we have to retry until we catch a stable entry.
+	while (true) {
+		phys_addr_t physicalAddress = entry & X86_64_PDE_ADDRESS_MASK;
+		uint64 flags = entry & kLargePageInheritedFlags;
+		for (uint32 i = 0; i < k64BitTableEntryCount; i++)
+			pageTable[i] = (physicalAddress + i * B_PAGE_SIZE) | flags;
+
+		uint64 oldEntry = X86PagingMethod64Bit::TestAndSetTableEntry(pde,
+			(physicalPageTable & X86_64_PDE_ADDRESS_MASK)
+				| X86_64_PDE_PRESENT
+				| X86_64_PDE_WRITABLE
+				| X86_64_PDE_USER,
+			entry);
+		if (oldEntry == entry)
+			break;
+		entry = oldEntry;
+	}
+
+	fMapCount -= k64BitTableEntryCount - 1;
+	atomic_add(&gMappedLargePagesCount, -1);
+	atomic_add(&gLargePageSplitCount, 1);
+
+	// Make sure no CPU keeps using the large page translation alongside the
+	// new small ones.
+	if ((entry & X86_64_PDE_ACCESSED) != 0)
+		InvalidatePage(ROUNDDOWN(virtualAddress, k64BitPageTableRange));
+}
+
+
+/*!	Unmaps a complete large page, and calls PageUnmapped() for all of its
+	pages. The page table kept for the large page takes its place.
+	The caller must hold the lock, and must have pinned the current thread.
+*/
+void
+X86VMTranslationMap64Bit::_UnmapLargePage(VMArea* area, uint64* pde,
+	addr_t virtualAddress, bool updatePageQueue, bool deletingAddressSpace,
+	VMAreaMappings* mappingsQueue)
+{
+	vm_page* page = fSpareTables.RemoveHead();
+	ASSERT(page != NULL);
+
+	phys_addr_t physicalPageTable
+		= (phys_addr_t)page->physical_page_number * B_PAGE_SIZE;
+	memset(fPageMapper->GetPageTableAt(physicalPageTable), 0, B_PAGE_SIZE);
+
+	uint64 oldEntry = *pde;
+	while (true) {
+		uint64 entry = X86PagingMethod64Bit::TestAndSetTableEntry(pde,
+			(physicalPageTable & X86_64_PDE_ADDRESS_MASK)
+				| X86_64_PDE_PRESENT
+				| X86_64_PDE_WRITABLE
+				| X86_64_PDE_USER,
+			oldEntry);
+		if (entry == oldEntry)
+			break;
+		oldEntry = entry;
+	}
+
+	fMapCount -= k64BitTableEntryCount - 1;
+	atomic_add(&gMappedLargePagesCount, -1);
+
+	if ((oldEntry & X86_64_PDE_ACCESSED) != 0 && !deletingAddressSpace)
+		InvalidatePage(virtualAddress);
+
+	Flush();
+
+	if (area->cache_type == CACHE_TYPE_DEVICE)
+		return;
+
+	page_num_t firstPage = (oldEntry & X86_64_PDE_ADDRESS_MASK) / B_PAGE_SIZE;
+	for (uint32 i = 0; i < k64BitTableEntryCount; i++) {
+		PageUnmapped(area, firstPage + i,
+			(oldEntry & X86_64_PDE_ACCESSED) != 0,
+			(oldEntry & X86_64_PDE_DIRTY) != 0, updatePageQueue,
+			mappingsQueue);
+	}
+}
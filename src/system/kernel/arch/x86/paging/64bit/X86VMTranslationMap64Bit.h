@@ -7,6 +7,9 @@
 #define KERNEL_ARCH_X86_PAGING_64BIT_X86_VM_TRANSLATION_MAP_64BIT_H
 
 
+#include <util/DoublyLinkedList.h>
+#include <vm/vm_types.h>
+
 #include "paging/X86VMTranslationMap.h"
 
 
@@ -28,6 +31,12 @@ struct X86VMTranslationMap64Bit final : X86VMTranslationMap {
 									vm_page_reservation* reservation);
 	virtual	status_t			Unmap(addr_t start, addr_t end);
 
+	virtual	size_t				LargePageSize() const;
+	virtual	status_t			MapLargePage(addr_t virtualAddress,
+									phys_addr_t physicalAddress,
+									uint32 attributes, uint32 memoryType,
+									vm_page_reservation* reservation);
+
 	virtual	status_t			DebugMarkRangePresent(addr_t start, addr_t end,
 									bool markPresent);
 
@@ -64,8 +73,31 @@ struct X86VMTranslationMap64Bit final : X86VMTranslationMap {
 	inline	X86PagingStructures64Bit* PagingStructures64Bit() const
 									{ return fPagingStructures; }
 
+private:
+			typedef DoublyLinkedList<vm_page,
+				DoublyLinkedListMemberGetLink<vm_page, &vm_page::queue_link> >
+					PageTableList;
+
+private:
+			uint64*				_PageDirectoryEntryForAddress(
+									addr_t virtualAddress);
+			uint64*				_PageTableForAddress(addr_t virtualAddress);
+			uint64*				_PageTableEntryForAddress(
+									addr_t virtualAddress);
+
+			void				_SplitLargePage(uint64* pde,
+									addr_t virtualAddress);
+			void				_UnmapLargePage(VMArea* area, uint64* pde,
+									addr_t virtualAddress,
+									bool updatePageQueue,
+									bool deletingAddressSpace,
+									VMAreaMappings* mappingsQueue);
+
 private:
 			X86PagingStructures64Bit* fPagingStructures;
+			PageTableList		fSpareTables;
+				// one page table per large page mapping, to be able to split
+				// them without having to allocate memory
 			bool				fLA57;
 };
 
@@ -53,6 +53,9 @@
 #define X86_64_PDE_DIRTY				(1LL << 6)
 #define X86_64_PDE_LARGE_PAGE			(1LL << 7)
 #define X86_64_PDE_GLOBAL				(1LL << 8)
+#define X86_64_PDE_SPLITTABLE			(1LL << 9)
+	// software bit: large page that was mapped via MapLargePage(), and can be
+	// split into a page table
 #define X86_64_PDE_PAT					(1LL << 12)
 #define X86_64_PDE_NOT_EXECUTABLE		(1LL << 63)
 #define X86_64_PDE_ADDRESS_MASK			0x000ffffffffff000L
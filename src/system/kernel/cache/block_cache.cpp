@@ -16,6 +16,10 @@
 #include <fs_cache.h>
 
 #include <condition_variable.h>
+#ifndef BUILDING_USERLAND_FS_SERVER
+#	include <generic_syscall.h>
+#	include <kernel.h>
+#endif
 #include <lock.h>
 #include <low_resource_manager.h>
 #include <slab/Slab.h>
@@ -59,6 +63,15 @@
 static const bigtime_t kTransactionIdleTime = 2000000LL;
 	// a transaction is considered idle after 2 seconds of inactivity
 
+static const uint32 kPrefetchStreamCount = 4;
+	// number of concurrent access streams that are tracked per cache
+static const int32 kMaxPrefetchStride = 32;
+	// blocks further apart don't form a stream
+static const uint32 kMinPrefetchWindow = 2;
+static const uint32 kMaxPrefetchWindow = 64;
+static const uint32 kMaxStridedPrefetches = 16;
+	// upper limit of separate I/O requests for a single strided read-ahead
+
 
 namespace {
 
@@ -101,6 +114,8 @@ struct cached_block {
 	bool			discard : 1;
 	bool			busy_reading_waiters : 1;
 	bool			busy_writing_waiters : 1;
+	bool			prefetched : 1;
+		// Block has been read ahead, and was not accessed since
 	cache_transaction* transaction;
 		// This is the current active transaction, if any, the block is
 		// currently in (meaning was changed as a part of it).
@@ -169,18 +184,25 @@ cache_notification::operator delete(void* block)
 }
 
 
+static const uint32 kBlockTableShardShift = 4;
+static const uint32 kBlockTableShardCount = 1 << kBlockTableShardShift;
+	// number of independently locked segments of a block hash table
+
+
 struct BlockHash {
 	typedef off_t			KeyType;
 	typedef	cached_block	ValueType;
 
 	size_t HashKey(KeyType key) const
 	{
-		return key;
+		// the lower bits select the shard, and are therefore the same for
+		// all blocks within one table
+		return key >> kBlockTableShardShift;
 	}
 
 	size_t Hash(ValueType* block) const
 	{
-		return block->block_number;
+		return HashKey(block->block_number);
 	}
 
 	bool Compare(KeyType key, ValueType* block) const
@@ -194,7 +216,94 @@ struct BlockHash {
 	}
 };
 
-typedef BOpenHashTable<BlockHash> BlockTable;
+typedef BOpenHashTable<BlockHash> BlockHashTable;
+
+
+/*!	The block hash of a cache, partitioned into kBlockTableShardCount shards
+	that are each guarded by their own read/write lock.
+
+	All changes to the table (as well as the plain Lookup()) are still done
+	with the cache lock held; the shard locks only serialize them against
+	Acquire() and Release(), which allow getting and putting clean blocks
+	that are already in the cache to bypass the cache lock completely.
+
+	Blocks acquired that way stay in the unused list even when they are
+	referenced; anyone removing a block from the table needs to use
+	RemoveUnreferenced() to make sure no lock-free reference to it exists.
+*/
+class BlockTable {
+public:
+								BlockTable();
+								~BlockTable();
+
+			status_t			Init(size_t initialSize);
+
+			cached_block*		Lookup(off_t blockNumber) const;
+			void				Insert(cached_block* block);
+			void				Remove(cached_block* block);
+			bool				RemoveUnreferenced(cached_block* block);
+			cached_block*		Clear();
+
+			cached_block*		Acquire(off_t blockNumber);
+			bool				Release(off_t blockNumber);
+
+			uint64				Hits() const;
+
+	class Iterator {
+	public:
+		Iterator(BlockTable* table)
+			:
+			fTable(table),
+			fShard(0),
+			fIterator(&table->fShards[0].table)
+		{
+			_SkipEmptyShards();
+		}
+
+		bool HasNext() const
+		{
+			return fIterator.HasNext();
+		}
+
+		cached_block* Next()
+		{
+			cached_block* block = fIterator.Next();
+			_SkipEmptyShards();
+			return block;
+		}
+
+	private:
+		void _SkipEmptyShards()
+		{
+			while (!fIterator.HasNext() && ++fShard < kBlockTableShardCount) {
+				fIterator = BlockHashTable::Iterator(
+					&fTable->fShards[fShard].table);
+			}
+		}
+
+		BlockTable*				fTable;
+		uint32					fShard;
+		BlockHashTable::Iterator fIterator;
+	};
+
+private:
+	struct Shard {
+		rw_lock					lock;
+		BlockHashTable			table;
+		int64					hits;
+			// only those that did not need the cache lock
+	};
+
+	inline	Shard&				_ShardFor(off_t blockNumber)
+									{ return fShards[blockNumber
+										& (kBlockTableShardCount - 1)]; }
+	inline	const Shard&		_ShardFor(off_t blockNumber) const
+									{ return fShards[blockNumber
+										& (kBlockTableShardCount - 1)]; }
+
+private:
+			Shard				fShards[kBlockTableShardCount];
+};
 
 
 struct TransactionHash {
@@ -214,6 +323,18 @@ struct TransactionHash {
 typedef BOpenHashTable<TransactionHash> TransactionTable;
 
 
+/*!	A sequence of accesses to blocks that are \c stride blocks apart. */
+struct prefetch_stream {
+	off_t			last_block;
+	off_t			next_block;
+		// the first block in the direction of the stream that has not been
+		// read ahead yet
+	int32			stride;
+	int32			confirmed;
+	bigtime_t		last_used;
+};
+
+
 struct block_cache : DoublyLinkedListLinkImpl<block_cache> {
 	BlockTable*		hash;
 	mutex			lock;
@@ -245,6 +366,15 @@ struct block_cache : DoublyLinkedListLinkImpl<block_cache> {
 	NotificationList pending_notifications;
 	ConditionVariable condition_variable;
 
+	prefetch_stream	prefetch_streams[kPrefetchStreamCount];
+	uint32			prefetch_window;
+
+	uint64			hits;
+	uint64			misses;
+	uint64			prefetched_blocks;
+	uint64			prefetch_hits;
+	uint64			prefetch_wasted;
+
 					block_cache(int fd, off_t numBlocks, size_t blockSize,
 						bool readOnly);
 					~block_cache();
@@ -261,6 +391,10 @@ struct block_cache : DoublyLinkedListLinkImpl<block_cache> {
 	void			RemoveBlock(cached_block* block);
 	void			DiscardBlock(cached_block* block);
 
+	void			PrefetchHit(cached_block* block);
+	void			PrefetchWasted(cached_block* block);
+	void			GetStats(block_cache_stats& stats) const;
+
 private:
 	static void		_LowMemoryHandler(void* data, uint32 resources,
 						int32 level);
@@ -1129,6 +1263,187 @@ cached_block::CanBeWritten() const
 }
 
 
+//	#pragma mark - BlockTable
+
+
+BlockTable::BlockTable()
+{
+	for (uint32 i = 0; i < kBlockTableShardCount; i++) {
+		rw_lock_init(&fShards[i].lock, "block cache shard");
+		fShards[i].hits = 0;
+	}
+}
+
+
+BlockTable::~BlockTable()
+{
+	for (uint32 i = 0; i < kBlockTableShardCount; i++)
+		rw_lock_destroy(&fShards[i].lock);
+}
+
+
+status_t
+BlockTable::Init(size_t initialSize)
+{
+	initialSize /= kBlockTableShardCount;
+
+	for (uint32 i = 0; i < kBlockTableShardCount; i++) {
+		status_t status = fShards[i].table.Init(initialSize);
+		if (status != B_OK)
+			return status;
+	}
+
+	return B_OK;
+}
+
+
+/*!	The cache must be locked (or we must be in the kernel debugger). */
+cached_block*
+BlockTable::Lookup(off_t blockNumber) const
+{
+	return _ShardFor(blockNumber).table.Lookup(blockNumber);
+}
+
+
+/*!	The cache must be locked. */
+void
+BlockTable::Insert(cached_block* block)
+{
+	Shard& shard = _ShardFor(block->block_number);
+
+	WriteLocker _(shard.lock);
+	shard.table.Insert(block);
+}
+
+
+/*!	The cache must be locked. */
+void
+BlockTable::Remove(cached_block* block)
+{
+	Shard& shard = _ShardFor(block->block_number);
+
+	WriteLocker _(shard.lock);
+	shard.table.Remove(block);
+}
+
+
+/*!	Removes all blocks from the table, and returns them as a list linked
+	through cached_block::next.
+	The cache must be locked.
+*/
+cached_block*
+BlockTable::Clear()
+{
+	cached_block* first = NULL;
+
+	for (uint32 i = 0; i < kBlockTableShardCount; i++) {
+		WriteLocker _(fShards[i].lock);
+
+		cached_block* block = fShards[i].table.Clear(true);
+		while (block != NULL) {
+			cached_block* next = block->next;
+			block->next = first;
+			first = block;
+			block = next;
+		}
+	}
+
+	return first;
+}
+
+
+/*!	Removes the \a block from the table, but only if there is no reference
+	to it, and returns whether or not that was the case.
+	The cache must be locked.
+*/
+bool
+BlockTable::RemoveUnreferenced(cached_block* block)
+{
+	Shard& shard = _ShardFor(block->block_number);
+
+	WriteLocker _(shard.lock);
+	if (atomic_get(&block->ref_count) != 0)
+		return false;
+
+	shard.table.Remove(block);
+	return true;
+}
+
+
+/*!	Looks up the block \a blockNumber without the cache lock held, and adds a
+	reference to it. This only works if it is either referenced already, or
+	sitting in the unused list, and if it's not currently being read in; in
+	either case, the block cannot be removed from the table while we hold
+	the shard lock, nor after we've added our reference.
+	Returns \c NULL if the caller needs to take the slow path instead.
+*/
+cached_block*
+BlockTable::Acquire(off_t blockNumber)
+{
+	Shard& shard = _ShardFor(blockNumber);
+	ReadLocker _(shard.lock);
+
+	cached_block* block = shard.table.Lookup(blockNumber);
+	if (block == NULL || block->busy_reading || block->prefetched)
+		return NULL;
+
+	int32 count = atomic_get(&block->ref_count);
+	while (count > 0 || (count == 0 && block->unused)) {
+		int32 previous = atomic_test_and_set(&block->ref_count, count + 1,
+			count);
+		if (previous == count) {
+			atomic_add64(&shard.hits, 1);
+			return block;
+		}
+
+		count = previous;
+	}
+
+	return NULL;
+}
+
+
+/*!	Returns the number of lookups that were satisfied by Acquire(). */
+uint64
+BlockTable::Hits() const
+{
+	uint64 hits = 0;
+	for (uint32 i = 0; i < kBlockTableShardCount; i++)
+		hits += fShards[i].hits;
+
+	return hits;
+}
+
+
+/*!	Removes a reference from the block \a blockNumber without the cache lock
+	held. This only works if it's not the last reference, or if the block is
+	still in the unused list, as then there is nothing else to do.
+	Returns \c false if the caller needs to take the slow path instead.
+*/
+bool
+BlockTable::Release(off_t blockNumber)
+{
+	Shard& shard = _ShardFor(blockNumber);
+	ReadLocker _(shard.lock);
+
+	cached_block* block = shard.table.Lookup(blockNumber);
+	if (block == NULL)
+		return false;
+
+	int32 count = atomic_get(&block->ref_count);
+	while (count > 1 || (count == 1 && block->unused)) {
+		int32 previous = atomic_test_and_set(&block->ref_count, count - 1,
+			count);
+		if (previous == count)
+			return true;
+
+		count = previous;
+	}
+
+	return false;
+}
+
+
 //	#pragma mark - BlockWriter
 
 
@@ -1510,9 +1825,15 @@ BlockPrefetcher::Allocate()
 	for (size_t i = 0; i < finalNumBlocks; ++i) {
 		cached_block* block = fCache->NewBlock(fBlockNumber + i);
 		if (block == NULL) {
-			_RemoveAllocated(0, i);
+			_RemoveAllocated(i, i);
 			return B_NO_MEMORY;
 		}
+
+		// The block must be busy before it becomes visible, as it could
+		// otherwise be acquired without the cache lock
+		mark_block_busy_reading(fCache, block);
+		block->prefetched = true;
+		fCache->prefetched_blocks++;
 		fCache->hash->Insert(block);
 
 		block->unused = true;
@@ -1541,7 +1862,6 @@ BlockPrefetcher::ReadAsync(MutexLocker& cacheLocker)
 	for (size_t i = 0; i < fNumAllocated; ++i) {
 		vecs[i].base = reinterpret_cast<generic_addr_t>(fBlocks[i]->current_data);
 		vecs[i].length = blockSize;
-		mark_block_busy_reading(fCache, fBlocks[i]);
 	}
 
 	IORequest* request = new IORequest;
@@ -1612,16 +1932,23 @@ BlockPrefetcher::_RemoveAllocated(size_t unbusyCount, size_t removeCount)
 
 	ASSERT_LOCKED_MUTEX(&fCache->lock);
 
-	for (size_t i = 0; i < unbusyCount; ++i)
-		mark_block_unbusy_reading(fCache, fBlocks[i]);
-
+	// The blocks must have left the hash before they become unbusy, so that
+	// they cannot be acquired in the mean time
 	for (size_t i = 0; i < removeCount; ++i) {
 		ASSERT(fBlocks[i]->is_dirty == false && fBlocks[i]->unused == true);
 
 		fCache->unused_blocks.Remove(fBlocks[i]);
 		fCache->unused_block_count--;
 
-		fCache->RemoveBlock(fBlocks[i]);
+		fCache->hash->Remove(fBlocks[i]);
+		fCache->PrefetchWasted(fBlocks[i]);
+	}
+
+	for (size_t i = 0; i < unbusyCount; ++i)
+		mark_block_unbusy_reading(fCache, fBlocks[i]);
+
+	for (size_t i = 0; i < removeCount; ++i) {
+		fCache->FreeBlock(fBlocks[i]);
 		fBlocks[i] = NULL;
 	}
 
@@ -1654,8 +1981,15 @@ block_cache::block_cache(int _fd, off_t numBlocks, size_t blockSize,
 	last_block_write(0),
 	last_block_write_duration(0),
 	num_dirty_blocks(0),
-	read_only(readOnly)
+	read_only(readOnly),
+	prefetch_window(kMinPrefetchWindow),
+	hits(0),
+	misses(0),
+	prefetched_blocks(0),
+	prefetch_hits(0),
+	prefetch_wasted(0)
 {
+	memset(prefetch_streams, 0, sizeof(prefetch_streams));
 }
 
 
@@ -1686,7 +2020,7 @@ block_cache::Init()
 	if (buffer_cache == NULL)
 		return B_NO_MEMORY;
 
-	hash = new BlockTable();
+	hash = new(std::nothrow) BlockTable();
 	if (hash == NULL || hash->Init(1024) != B_OK)
 		return B_NO_MEMORY;
 
@@ -1789,6 +2123,7 @@ block_cache::NewBlock(off_t blockNumber)
 	block->discard = false;
 	block->busy_reading_waiters = false;
 	block->busy_writing_waiters = false;
+	block->prefetched = false;
 #if BLOCK_CACHE_DEBUG_CHANGED
 	block->compare = NULL;
 #endif
@@ -1833,10 +2168,16 @@ block_cache::RemoveUnusedBlocks(int32 count, int32 minSecondsOld)
 			BlockWriter::WriteBlock(this, block);
 		}
 
+		if (!hash->RemoveUnreferenced(block)) {
+			// the block has been acquired without the cache lock
+			continue;
+		}
+
 		// remove block from lists
 		iterator.Remove();
 		unused_block_count--;
-		RemoveBlock(block);
+		PrefetchWasted(block);
+		FreeBlock(block);
 
 		if (--count <= 0)
 			break;
@@ -1873,6 +2214,54 @@ block_cache::DiscardBlock(cached_block* block)
 }
 
 
+/*!	Called when a block that has been read ahead is accessed for the first
+	time. The read-ahead window grows additively with every hit, and shrinks
+	multiplicatively with every prefetched block that had to be thrown away
+	without having been used.
+*/
+void
+block_cache::PrefetchHit(cached_block* block)
+{
+	ASSERT(block->prefetched);
+
+	block->prefetched = false;
+	prefetch_hits++;
+
+	if (prefetch_window < kMaxPrefetchWindow)
+		prefetch_window++;
+}
+
+
+/*!	Must be called for every unused block that is removed from the cache. */
+void
+block_cache::PrefetchWasted(cached_block* block)
+{
+	if (!block->prefetched)
+		return;
+
+	block->prefetched = false;
+	prefetch_wasted++;
+
+	prefetch_window = max_c(prefetch_window / 2, kMinPrefetchWindow);
+}
+
+
+void
+block_cache::GetStats(block_cache_stats& stats) const
+{
+	stats.block_size = block_size;
+	stats.max_blocks = max_blocks;
+	stats.unused_blocks = unused_block_count;
+	stats.dirty_blocks = num_dirty_blocks;
+	stats.hits = hits + hash->Hits();
+	stats.misses = misses;
+	stats.prefetched_blocks = prefetched_blocks;
+	stats.prefetch_hits = prefetch_hits;
+	stats.prefetch_wasted = prefetch_wasted;
+	stats.prefetch_window = prefetch_window;
+}
+
+
 void
 block_cache::_LowMemoryHandler(void* data, uint32 resources, int32 level)
 {
@@ -1936,10 +2325,15 @@ block_cache::_GetUnusedBlock()
 		if (block->is_dirty && !block->busy_writing && !block->discard)
 			BlockWriter::WriteBlock(this, block);
 
+		if (!hash->RemoveUnreferenced(block)) {
+			// the block has been acquired without the cache lock
+			continue;
+		}
+
 		// remove block from lists
 		iterator.Remove();
 		unused_block_count--;
-		hash->Remove(block);
+		PrefetchWasted(block);
 
 		ASSERT(block->original_data == NULL && block->parent_data == NULL);
 		block->unused = false;
@@ -2087,7 +2481,10 @@ put_cached_block(block_cache* cache, cached_block* block)
 		return;
 	}
 
-	if (--block->ref_count == 0
+	// The reference count is also changed without the cache lock held, see
+	// BlockTable::Acquire(). A block acquired that way is still in the unused
+	// list, and there is nothing left to do for it.
+	if (atomic_add(&block->ref_count, -1) == 1 && !block->unused
 		&& block->transaction == NULL && block->previous_transaction == NULL) {
 		// This block is not used anymore, and not part of any transaction
 		block->is_writing = false;
@@ -2134,10 +2531,12 @@ put_cached_block(block_cache* cache, off_t blockNumber)
 		not already in the cache. The block you retrieve may contain random
 		data. If \c true, the cache will be temporarily unlocked while the
 		block is read in.
+	\param _prefetched if not \c NULL, tells you whether or not the block has
+		been read ahead, and this is the first time it was accessed.
 */
 static status_t
 get_cached_block(block_cache* cache, off_t blockNumber, bool* _allocated,
-	bool readBlock, cached_block** _block)
+	bool readBlock, cached_block** _block, bool* _prefetched = NULL)
 {
 	ASSERT_LOCKED_MUTEX(&cache->lock);
 
@@ -2168,6 +2567,18 @@ retry:
 		goto retry;
 	}
 
+	if (_prefetched != NULL)
+		*_prefetched = block->prefetched;
+
+	if (*_allocated) {
+		if (readBlock)
+			cache->misses++;
+	} else {
+		cache->hits++;
+		if (block->prefetched)
+			cache->PrefetchHit(block);
+	}
+
 	if (block->unused) {
 		//TRACE(("remove block %" B_PRIdOFF " from unused\n", blockNumber));
 		block->unused = false;
@@ -2202,7 +2613,7 @@ retry:
 		mark_block_unbusy_reading(cache, block);
 	}
 
-	block->ref_count++;
+	atomic_add(&block->ref_count, 1);
 	block->last_accessed = system_time() / 1000000L;
 
 	*_block = block;
@@ -2210,6 +2621,149 @@ retry:
 }
 
 
+#ifndef BUILDING_USERLAND_FS_SERVER
+/*!	Reads \a count blocks starting at \a blockNumber that are \a stride blocks
+	apart asynchronously into the cache, as long as they aren't cached yet.
+	The cache must be locked, but will be unlocked upon return.
+*/
+static void
+read_ahead_blocks(block_cache* cache, off_t blockNumber, int32 stride,
+	uint32 count, MutexLocker& locker)
+{
+	if (stride == 1) {
+		BlockPrefetcher* prefetcher = new(std::nothrow) BlockPrefetcher(cache,
+			blockNumber, count);
+		if (prefetcher == NULL)
+			return;
+
+		if (prefetcher->Allocate() != B_OK
+			|| prefetcher->NumAllocated() == 0) {
+			delete prefetcher;
+			return;
+		}
+
+		prefetcher->ReadAsync(locker);
+		return;
+	}
+
+	// There is no way to combine strided blocks into a single request
+	count = min_c(count, kMaxStridedPrefetches);
+
+	for (uint32 i = 0; i < count; i++, blockNumber += stride) {
+		if (!locker.IsLocked())
+			locker.Lock();
+
+		BlockPrefetcher* prefetcher = new(std::nothrow) BlockPrefetcher(cache,
+			blockNumber, 1);
+		if (prefetcher == NULL)
+			return;
+
+		if (prefetcher->Allocate() != B_OK
+			|| prefetcher->NumAllocated() == 0) {
+			delete prefetcher;
+			continue;
+		}
+
+		prefetcher->ReadAsync(locker);
+	}
+}
+
+
+/*!	Tries to match the access to \a blockNumber with one of the streams of
+	sequential or strided accesses the cache has seen lately, and reads ahead
+	of a stream once it has been confirmed.
+	This is only called for blocks that had to be read in, or that had been
+	read ahead, so that we don't spend any time on blocks that are cached
+	anyway.
+	The cache must be locked, but may be unlocked upon return.
+*/
+static void
+read_ahead(block_cache* cache, off_t blockNumber, MutexLocker& locker)
+{
+	ASSERT_LOCKED_MUTEX(&cache->lock);
+
+	prefetch_stream* stream = NULL;
+	prefetch_stream* oldest = &cache->prefetch_streams[0];
+
+	for (uint32 i = 0; i < kPrefetchStreamCount; i++) {
+		prefetch_stream& candidate = cache->prefetch_streams[i];
+		off_t distance = blockNumber - candidate.last_block;
+
+		if (distance == 0 || distance > kMaxPrefetchStride
+			|| distance < -kMaxPrefetchStride) {
+			if (candidate.last_used < oldest->last_used)
+				oldest = &candidate;
+			continue;
+		}
+
+		stream = &candidate;
+		if (distance == stream->stride)
+			stream->confirmed++;
+		else {
+			stream->stride = distance;
+			stream->confirmed = 0;
+			stream->next_block = blockNumber + distance;
+		}
+		break;
+	}
+
+	if (stream == NULL) {
+		// start a new stream
+		stream = oldest;
+		stream->stride = 0;
+		stream->confirmed = 0;
+		stream->next_block = blockNumber;
+	}
+
+	stream->last_block = blockNumber;
+	stream->last_used = system_time();
+
+	if (stream->confirmed == 0)
+		return;
+
+	// Only read ahead once less than half of the window is left in front of
+	// the stream, so that we don't issue a request for every single block
+	int32 stride = stream->stride;
+	int64 ahead = (stream->next_block - blockNumber) / stride;
+	if (ahead <= 0) {
+		stream->next_block = blockNumber + stride;
+		ahead = 0;
+	}
+
+	uint32 window = cache->prefetch_window;
+	if (ahead >= window / 2)
+		return;
+
+	uint32 count = window - ahead;
+	off_t start = stream->next_block;
+
+	// stay within the bounds of the device
+	if (stride > 0) {
+		if (start >= cache->max_blocks)
+			return;
+		count = min_c(count, (cache->max_blocks - 1 - start) / stride + 1);
+	} else {
+		if (start < 0)
+			return;
+		count = min_c(count, start / -stride + 1);
+	}
+
+	stream->next_block = start + (off_t)count * stride;
+
+	TRACE(("read_ahead: stream %p, stride %" B_PRId32 ", %" B_PRIu32
+		" blocks from %" B_PRIdOFF "\n", stream, stride, count, start));
+
+	if (stride == -1) {
+		// read the range in ascending order
+		start -= count - 1;
+		stride = 1;
+	}
+
+	read_ahead_blocks(cache, start, stride, count, locker);
+}
+#endif	// !BUILDING_USERLAND_FS_SERVER
+
+
 /*!	Returns the writable block data for the requested blockNumber.
 	If \a cleared is true, the block is not read from disk; an empty block
 	is returned.
@@ -2374,14 +2928,14 @@ static void
 dump_block(cached_block* block)
 {
 	kprintf("%08lx %9" B_PRIdOFF " %08lx %08lx %08lx %5" B_PRId32 " %6" B_PRId32
-		" %c%c%c%c%c%c %08lx %08lx\n",
+		" %c%c%c%c%c%c%c %08lx %08lx\n",
 		(addr_t)block, block->block_number,
 		(addr_t)block->current_data, (addr_t)block->original_data,
 		(addr_t)block->parent_data, block->ref_count, block->LastAccess(),
 		block->busy_reading ? 'r' : '-', block->busy_writing ? 'w' : '-',
 		block->is_writing ? 'W' : '-', block->is_dirty ? 'D' : '-',
 		block->unused ? 'U' : '-', block->discard ? 'D' : '-',
-		(addr_t)block->transaction,
+		block->prefetched ? 'P' : '-', (addr_t)block->transaction,
 		(addr_t)block->previous_transaction);
 }
 
@@ -2411,6 +2965,8 @@ dump_block_long(cached_block* block)
 		kprintf(" unused");
 	if (block->discard)
 		kprintf(" discard");
+	if (block->prefetched)
+		kprintf(" prefetched");
 	kprintf("\n");
 	if (block->transaction != NULL) {
 		kprintf(" transaction:   %p (%" B_PRId32 ")\n", block->transaction,
@@ -2501,6 +3057,11 @@ dump_cache(int argc, char** argv)
 		cache->busy_reading_waiters ? "has" : "no");
 	kprintf(" busy_writing: %" B_PRIu32 ", %s waiters\n", cache->busy_writing_count,
 		cache->busy_writing_waiters ? "has" : "no");
+	kprintf(" hits:         %" B_PRIu64 ", misses: %" B_PRIu64 "\n",
+		cache->hits + cache->hash->Hits(), cache->misses);
+	kprintf(" prefetched:   %" B_PRIu64 ", %" B_PRIu64 " hits, %" B_PRIu64
+		" wasted, window %" B_PRIu32 "\n", cache->prefetched_blocks,
+		cache->prefetch_hits, cache->prefetch_wasted, cache->prefetch_window);
 
 	if (!cache->pending_notifications.IsEmpty()) {
 		kprintf(" pending notifications:\n");
@@ -2535,7 +3096,7 @@ dump_cache(int argc, char** argv)
 	if (showBlocks) {
 		kprintf(" blocks:\n");
 		kprintf("address  block no. current  original parent    refs access "
-			"flags transact prev. trans\n");
+			"flags   transact prev. trans\n");
 	}
 
 	uint32 referenced = 0;
@@ -2621,7 +3182,7 @@ dump_transaction(int argc, char** argv)
 
 	kprintf(" blocks:\n");
 	kprintf("address  block no. current  original parent    refs access "
-		"flags transact prev. trans\n");
+		"flags   transact prev. trans\n");
 
 	cached_block* block = transaction->first_block;
 	while (block != NULL) {
@@ -2645,13 +3206,18 @@ static int
 dump_caches(int argc, char** argv)
 {
 	kprintf("Block caches:\n");
+	kprintf("  address         fd    hits  misses prefetch  p-hits  wasted\n");
 	DoublyLinkedList<block_cache>::Iterator i = sCaches.GetIterator();
 	while (i.HasNext()) {
 		block_cache* cache = i.Next();
 		if (cache == (block_cache*)&sMarkCache)
 			continue;
 
-		kprintf("  %p\n", cache);
+		kprintf("  %p %4d %7" B_PRIu64 " %7" B_PRIu64 " %8" B_PRIu64 " %7"
+			B_PRIu64 " %7" B_PRIu64 "\n", cache, cache->fd,
+			cache->hits + cache->hash->Hits(), cache->misses,
+			cache->prefetched_blocks, cache->prefetch_hits,
+			cache->prefetch_wasted);
 	}
 
 	return 0;
@@ -2968,6 +3534,56 @@ wait_for_notifications(block_cache* cache)
 }
 
 
+#ifndef BUILDING_USERLAND_FS_SERVER
+static status_t
+block_cache_control(const char* subsystem, uint32 function, void* buffer,
+	size_t bufferSize)
+{
+	switch (function) {
+		case BLOCK_CACHE_GET_STATS:
+		{
+			// Fills the buffer with the statistics of as many caches as
+			// fit, and returns the number of caches there are
+			if (buffer != NULL && !IS_USER_ADDRESS(buffer))
+				return B_BAD_ADDRESS;
+
+			block_cache_stats* userStats = (block_cache_stats*)buffer;
+			size_t maxCount = buffer != NULL
+				? bufferSize / sizeof(block_cache_stats) : 0;
+			int32 count = 0;
+
+			MutexLocker locker(sCachesLock);
+
+			DoublyLinkedList<block_cache>::Iterator iterator
+				= sCaches.GetIterator();
+			while (iterator.HasNext()) {
+				block_cache* cache = iterator.Next();
+				if (cache == (block_cache*)&sMarkCache)
+					continue;
+
+				if ((size_t)count < maxCount) {
+					block_cache_stats stats;
+					{
+						MutexLocker cacheLocker(&cache->lock);
+						cache->GetStats(stats);
+					}
+
+					if (user_memcpy(&userStats[count], &stats,
+							sizeof(block_cache_stats)) != B_OK)
+						return B_BAD_ADDRESS;
+				}
+				count++;
+			}
+
+			return count;
+		}
+	}
+
+	return B_BAD_HANDLER;
+}
+#endif	// !BUILDING_USERLAND_FS_SERVER
+
+
 status_t
 block_cache_init(void)
 {
@@ -3022,6 +3638,10 @@ block_cache_init(void)
 #	endif
 #endif	// DEBUG_BLOCK_CACHE
 
+#ifndef BUILDING_USERLAND_FS_SERVER
+	register_generic_syscall(BLOCK_CACHE_SYSCALLS, block_cache_control, 1, 0);
+#endif
+
 	return B_OK;
 }
 
@@ -3663,7 +4283,7 @@ block_cache_delete(void* _cache, bool allowWrites)
 
 	// free all blocks
 
-	cached_block* block = cache->hash->Clear(true);
+	cached_block* block = cache->hash->Clear();
 	while (block != NULL) {
 		cached_block* next = block->next;
 		cache->FreeBlock(block);
@@ -3804,10 +4424,11 @@ block_cache_discard(void* _cache, off_t blockNumber, size_t numBlocks)
 
 		ASSERT(block->previous_transaction == NULL);
 
-		if (block->unused) {
+		if (block->unused && cache->hash->RemoveUnreferenced(block)) {
 			cache->unused_blocks.Remove(block);
 			cache->unused_block_count--;
-			cache->RemoveBlock(block);
+			cache->PrefetchWasted(block);
+			cache->FreeBlock(block);
 		} else {
 			if (block->transaction != NULL && block->parent_data != NULL
 				&& block->parent_data != block->current_data) {
@@ -3899,12 +4520,29 @@ status_t
 block_cache_get_etc(void* _cache, off_t blockNumber, const void** _block)
 {
 	block_cache* cache = (block_cache*)_cache;
+
+#if !BLOCK_CACHE_DEBUG_CHANGED
+	if (blockNumber >= 0 && blockNumber < cache->max_blocks) {
+		// try the fast path first
+		cached_block* block = cache->hash->Acquire(blockNumber);
+		if (block != NULL) {
+			// Note, we don't update the last access time here, as that would
+			// break the order of the unused list
+			TB(Get(cache, block));
+
+			*_block = block->current_data;
+			return B_OK;
+		}
+	}
+#endif
+
 	MutexLocker locker(&cache->lock);
 	bool allocated;
+	bool prefetched;
 
 	cached_block* block;
 	status_t status = get_cached_block(cache, blockNumber, &allocated, true,
-		&block);
+		&block, &prefetched);
 	if (status != B_OK)
 		return status;
 
@@ -3917,6 +4555,12 @@ block_cache_get_etc(void* _cache, off_t blockNumber, const void** _block)
 	TB(Get(cache, block));
 
 	*_block = block->current_data;
+
+#ifndef BUILDING_USERLAND_FS_SERVER
+	if (allocated || prefetched)
+		read_ahead(cache, blockNumber, locker);
+#endif
+
 	return B_OK;
 }
 
@@ -3966,6 +4610,15 @@ void
 block_cache_put(void* _cache, off_t blockNumber)
 {
 	block_cache* cache = (block_cache*)_cache;
+
+#if !BLOCK_CACHE_DEBUG_CHANGED && !BLOCK_CACHE_BLOCK_TRACING
+	// try the fast path first (it would bypass the tracing, though)
+	if (blockNumber >= 0 && blockNumber < cache->max_blocks
+		&& cache->hash->Release(blockNumber)) {
+		return;
+	}
+#endif
+
 	MutexLocker locker(&cache->lock);
 
 	put_cached_block(cache, blockNumber);
@@ -9,6 +9,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include <KernelExport.h>
 #include <fs_cache.h>
@@ -104,6 +105,14 @@ static void add_to_iovec(generic_io_vec* vecs, uint32 &index, uint32 max,
 	generic_addr_t address, generic_size_t size);
 
 
+struct wired_file_pages {
+	VMCache*		cache;
+	uint32			count;
+	vm_page*		pages[MAX_IO_VECS];
+	addr_t			addresses[MAX_IO_VECS];
+	void*			handles[MAX_IO_VECS];
+};
+
 static struct cache_module_info* sCacheModule;
 
 
@@ -156,16 +165,15 @@ PrecacheIO::Prepare(vm_page_reservation* reservation)
 		return B_NO_MEMORY;
 
 	// allocate pages for the cache and mark them busy
-	uint32 i = 0;
-	for (generic_size_t pos = 0; pos < fSize; pos += B_PAGE_SIZE) {
-		vm_page* page = vm_page_allocate_page(reservation,
-			PAGE_STATE_CACHED | VM_PAGE_ALLOC_BUSY);
+	vm_page_allocate_pages(reservation, PAGE_STATE_CACHED | VM_PAGE_ALLOC_BUSY,
+		fPages, fPageCount);
 
-		fCache->InsertPage(page, fOffset + pos);
+	for (uint32 i = 0; i < fPageCount; i++) {
+		vm_page* page = fPages[i];
+		fCache->InsertPage(page, fOffset + i * B_PAGE_SIZE);
 
 		add_to_iovec(fVecs, fVecCount, fPageCount,
 			page->physical_page_number * B_PAGE_SIZE, B_PAGE_SIZE);
-		fPages[i++] = page;
 	}
 
 #if DEBUG_PAGE_ACCESS
@@ -393,9 +401,11 @@ read_into_cache(file_cache_ref* ref, void* cookie, off_t offset,
 	int32 pageIndex = 0;
 
 	// allocate pages for the cache and mark them busy
+	vm_page_allocate_pages(reservation, PAGE_STATE_CACHED | VM_PAGE_ALLOC_BUSY,
+		pages, numBytes / B_PAGE_SIZE);
+
 	for (generic_size_t pos = 0; pos < numBytes; pos += B_PAGE_SIZE) {
-		vm_page* page = pages[pageIndex++] = vm_page_allocate_page(
-			reservation, PAGE_STATE_CACHED | VM_PAGE_ALLOC_BUSY);
+		vm_page* page = pages[pageIndex++];
 
 		cache->InsertPage(page, offset + pos);
 
@@ -512,16 +522,18 @@ write_to_cache(file_cache_ref* ref, void* cookie, off_t offset,
 	bool writeThrough = false;
 
 	// allocate pages for the cache and mark them busy
+	// TODO: if space is becoming tight, and this cache is already grown
+	//	big - shouldn't we better steal the pages directly in that case?
+	//	(a working set like approach for the file cache)
+	// TODO: the pages we allocate here should have been reserved upfront
+	//	in cache_io()
+	vm_page_allocate_pages(reservation,
+		(writeThrough ? PAGE_STATE_CACHED : PAGE_STATE_MODIFIED)
+			| VM_PAGE_ALLOC_BUSY,
+		pages, numBytes / B_PAGE_SIZE);
+
 	for (generic_size_t pos = 0; pos < numBytes; pos += B_PAGE_SIZE) {
-		// TODO: if space is becoming tight, and this cache is already grown
-		//	big - shouldn't we better steal the pages directly in that case?
-		//	(a working set like approach for the file cache)
-		// TODO: the pages we allocate here should have been reserved upfront
-		//	in cache_io()
-		vm_page* page = pages[pageIndex++] = vm_page_allocate_page(
-			reservation,
-			(writeThrough ? PAGE_STATE_CACHED : PAGE_STATE_MODIFIED)
-				| VM_PAGE_ALLOC_BUSY);
+		vm_page* page = pages[pageIndex++];
 
 		page->modified = !writeThrough;
 
@@ -1054,6 +1066,191 @@ cache_prefetch(dev_t mountID, ino_t vnodeID, off_t offset, size_t size)
 }
 
 
+/*!	Makes sure the range of \a vnode starting at \a offset is in the file
+	cache, and wires the pages backing it, so that their contents can be
+	passed on without being copied, for example to the network stack.
+	At most \a *_vecCount (and \c MAX_IO_VECS) pages are wired at once.
+	\a _size and \a _vecCount are set to what could actually be wired; a size
+	of zero means \a offset is beyond the end of the file.
+	While the pages are wired, they cannot be removed from the cache; the
+	returned \a _wiredCookie must be passed to file_cache_unwire_pages() when
+	they are no longer needed.
+
+	Returns \c B_NOT_SUPPORTED if the file has no file cache, or if physical
+	pages cannot be mapped permanently on this architecture.
+*/
+extern "C" status_t
+file_cache_wire_pages(struct vnode* vnode, void* cookie, off_t offset,
+	size_t* _size, iovec* vecs, uint32* _vecCount, void** _wiredCookie)
+{
+#ifndef KERNEL_PMAP_BASE
+	// Without a physical memory map, we would have to keep the physical page
+	// mapper's slots for as long as the pages are in use.
+	return B_NOT_SUPPORTED;
+#else
+	if (offset < 0)
+		return B_BAD_VALUE;
+
+	VMCache* cache;
+	if (vfs_get_vnode_cache(vnode, &cache, false) != B_OK)
+		return B_NOT_SUPPORTED;
+
+	file_cache_ref* ref = NULL;
+	if (cache->type == CACHE_TYPE_VNODE)
+		ref = ((VMVnodeCache*)cache)->FileCacheRef();
+	if (ref == NULL || ref->disabled_count > 0) {
+		cache->ReleaseRef();
+		return B_NOT_SUPPORTED;
+	}
+
+	int32 pageOffset = offset & (B_PAGE_SIZE - 1);
+	size_t maxPages = min_c(*_vecCount, (uint32)MAX_IO_VECS);
+
+	size_t size = *_size;
+	const off_t fileSize = cache->virtual_end;
+	if (offset >= fileSize)
+		size = 0;
+	else if ((off_t)(offset + size) > fileSize)
+		size = fileSize - offset;
+	if (size > maxPages * B_PAGE_SIZE - pageOffset)
+		size = maxPages * B_PAGE_SIZE - pageOffset;
+
+	*_vecCount = 0;
+	*_wiredCookie = NULL;
+
+	if (size == 0) {
+		cache->ReleaseRef();
+		*_size = 0;
+		return B_OK;
+	}
+
+	// read in what isn't cached yet, without copying it anywhere
+	size_t bytesRead = size;
+	status_t status = cache_io(ref, cookie, offset, 0, &bytesRead, false);
+	if (status != B_OK) {
+		cache->ReleaseRef();
+		return status;
+	}
+
+	wired_file_pages* wired = new(std::nothrow) wired_file_pages;
+	if (wired == NULL) {
+		cache->ReleaseRef();
+		return B_NO_MEMORY;
+	}
+
+	wired->cache = cache;
+		// we keep the reference we got
+	wired->count = 0;
+
+	off_t pageBase = offset - pageOffset;
+	size_t bytesWired = 0;
+
+	AutoLocker<VMCache> locker(cache);
+
+	while (bytesWired < size) {
+		vm_page* page = cache->LookupPage(
+			pageBase + (off_t)wired->count * B_PAGE_SIZE);
+		if (page != NULL && page->busy) {
+			cache->WaitForPageEvents(page, PAGE_EVENT_NOT_BUSY, true);
+			continue;
+		}
+		if (page == NULL) {
+			// The page has been stolen again, or could not be cached at all.
+			// Just return what we have so far.
+			break;
+		}
+
+		addr_t address;
+		void* handle;
+		if (vm_get_physical_page(page->physical_page_number * B_PAGE_SIZE,
+				&address, &handle) != B_OK) {
+			break;
+		}
+
+		DEBUG_PAGE_ACCESS_START(page);
+
+		if (!page->IsMapped())
+			atomic_add(&gMappedPagesCount, 1);
+		page->IncrementWiredCount();
+
+		// a wired page must not stay in the cached queue
+		if (page->State() == PAGE_STATE_CACHED
+			|| page->State() == PAGE_STATE_INACTIVE) {
+			vm_page_set_state(page, PAGE_STATE_ACTIVE);
+		}
+
+		DEBUG_PAGE_ACCESS_END(page);
+
+		size_t bytes = min_c(size - bytesWired,
+			(size_t)(B_PAGE_SIZE - pageOffset));
+
+		vecs[wired->count].iov_base = (void*)(address + pageOffset);
+		vecs[wired->count].iov_len = bytes;
+
+		wired->pages[wired->count] = page;
+		wired->addresses[wired->count] = address;
+		wired->handles[wired->count] = handle;
+		wired->count++;
+
+		bytesWired += bytes;
+		pageOffset = 0;
+	}
+
+	locker.Unlock();
+
+	if (wired->count == 0) {
+		// we couldn't keep anything in the cache (low memory?)
+		delete wired;
+		cache->ReleaseRef();
+		return B_BUSY;
+	}
+
+	*_size = bytesWired;
+	*_vecCount = wired->count;
+	*_wiredCookie = wired;
+	return B_OK;
+#endif
+}
+
+
+/*!	Releases the pages wired by file_cache_wire_pages() again.
+	May be called from any thread context.
+*/
+extern "C" void
+file_cache_unwire_pages(void* wiredCookie)
+{
+	wired_file_pages* wired = (wired_file_pages*)wiredCookie;
+	if (wired == NULL)
+		return;
+
+	VMCache* cache = wired->cache;
+
+	for (uint32 i = 0; i < wired->count; i++)
+		vm_put_physical_page(wired->addresses[i], wired->handles[i]);
+
+	cache->Lock();
+
+	for (uint32 i = 0; i < wired->count; i++) {
+		vm_page* page = wired->pages[i];
+		bool orphaned = page->CacheRef() == NULL;
+			// the file might have been truncated in the mean time
+
+		page->DecrementWiredCount();
+		if (!page->IsMapped()) {
+			atomic_add(&gMappedPagesCount, -1);
+
+			if (orphaned) {
+				DEBUG_PAGE_ACCESS_START(page);
+				vm_page_free(NULL, page);
+			}
+		}
+	}
+
+	cache->ReleaseRefAndUnlock();
+	delete wired;
+}
+
+
 extern "C" void
 cache_node_opened(struct vnode* vnode, VMCache* cache,
 	dev_t mountID, ino_t parentID, ino_t vnodeID, const char* name)
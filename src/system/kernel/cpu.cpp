@@ -29,6 +29,7 @@
 /* global per-cpu structure */
 cpu_ent gCPU[SMP_MAX_CPUS];
 CPUSet gCPUEnabled;
+int32 gNUMANodeCount = 1;
 
 uint32 gCPUCacheLevelCount;
 static cpu_topology_node sCPUTopology;
@@ -152,6 +153,11 @@ cpu_preboot_init_percpu(kernel_args *args, int curr_cpu)
 	gCPU[curr_cpu].cpu_num = curr_cpu;
 	gCPUEnabled.SetBitAtomic(curr_cpu);
 
+	if (args->num_numa_nodes > 1) {
+		gNUMANodeCount = args->num_numa_nodes;
+		gCPU[curr_cpu].numa_node = args->cpu_numa_node[curr_cpu];
+	}
+
 	list_init(&gCPU[curr_cpu].irqs);
 	B_INITIALIZE_SPINLOCK(&gCPU[curr_cpu].irqs_lock);
 
@@ -18,6 +18,7 @@
 #include <syscall_utils.h>
 
 #include <fd.h>
+#include <file_cache.h>
 #include <kernel.h>
 #include <lock.h>
 #include <syscall_restart.h>
@@ -32,6 +33,8 @@
 #define MAX_SOCKET_ADDRESS_LENGTH	(sizeof(sockaddr_storage))
 #define MAX_SOCKET_OPTION_LENGTH	128
 #define MAX_ANCILLARY_DATA_LENGTH	1024
+#define SENDFILE_CHUNK_PAGES		32
+#define SENDFILE_CHUNK_SIZE			(SENDFILE_CHUNK_PAGES * B_PAGE_SIZE)
 
 #define GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor)	\
 	do {												\
@@ -691,6 +694,145 @@ common_get_next_socket_stat(int family, uint32 *cookie, struct net_stat *stat)
 }
 
 
+/*!	Passes up to \a length bytes of the file \a in starting at \a pos
+	directly from the file cache to the socket \a out, without copying.
+*/
+static ssize_t
+send_file_pages(file_descriptor* out, file_descriptor* in, off_t pos,
+	size_t length)
+{
+	struct vnode* vnode = fd_vnode(in);
+	if (vnode == NULL)
+		return B_NOT_SUPPORTED;
+
+	iovec vecs[SENDFILE_CHUNK_PAGES];
+	uint32 vecCount = SENDFILE_CHUNK_PAGES;
+	void* wiredCookie;
+	status_t status = file_cache_wire_pages(vnode, in->cookie, pos, &length,
+		vecs, &vecCount, &wiredCookie);
+	if (status != B_OK)
+		return status;
+	if (length == 0)
+		return 0;
+
+	// the stack takes over the wired pages in any case
+	return sStackInterface->send_external(FD_SOCKET(out), vecs, vecCount,
+		&file_cache_unwire_pages, wiredCookie, 0);
+}
+
+
+/*!	Copies up to \a length bytes of the file \a in starting at \a pos to
+	\a out, using the given \a buffer.
+*/
+static ssize_t
+copy_file_data(file_descriptor* out, file_descriptor* in, off_t pos,
+	size_t length, void* buffer)
+{
+	status_t status = in->ops->fd_read(in, pos, buffer, &length);
+	if (status != B_OK)
+		return status;
+	if (length == 0)
+		return 0;
+
+	off_t outPos = out->pos;
+	status = out->ops->fd_write(out, outPos, buffer, &length);
+	if (status != B_OK)
+		return status;
+
+	if (outPos != -1) {
+		out->pos = (out->open_mode & O_APPEND) != 0
+			? out->ops->fd_seek(out, 0, SEEK_END) : outPos + length;
+	}
+
+	return length;
+}
+
+
+/*!	Sends \a count bytes of the file \a inFD to \a outFD, starting at
+	\a *_offset, or at the current file position if \a _offset is \c NULL.
+	If \a outFD is a stream socket, and the file is cached, the data is
+	passed from the file cache to the network stack without being copied.
+	Everything else is copied through a kernel buffer.
+*/
+static ssize_t
+common_sendfile(int outFD, int inFD, off_t* _offset, size_t count, bool kernel)
+{
+	io_context* context = get_current_io_context(kernel);
+
+	FileDescriptorPutter in(get_fd(context, inFD));
+	FileDescriptorPutter out(get_fd(context, outFD));
+	if (!in.IsSet() || !out.IsSet())
+		return EBADF;
+
+	if ((in->open_mode & O_RWMASK) == O_WRONLY || in->ops->fd_read == NULL
+		|| (out->open_mode & O_RWMASK) == O_RDONLY
+		|| out->ops->fd_write == NULL) {
+		return EBADF;
+	}
+
+	off_t pos;
+	if (_offset != NULL)
+		pos = *_offset;
+	else if (in->pos != -1)
+		pos = in->pos;
+	else
+		return ESPIPE;
+
+	if (pos < 0)
+		return B_BAD_VALUE;
+	if (count > SSIZE_MAX)
+		count = SSIZE_MAX;
+
+	bool zeroCopy = out->ops == &sSocketFDOps;
+	MemoryDeleter bufferDeleter;
+
+	size_t bytesSent = 0;
+	ssize_t result = B_OK;
+
+	while (bytesSent < count) {
+		size_t length = min_c(count - bytesSent, SENDFILE_CHUNK_SIZE);
+
+		result = B_NOT_SUPPORTED;
+		if (zeroCopy) {
+			result = send_file_pages(out.Get(), in.Get(), pos, length);
+			if (result == B_NOT_SUPPORTED)
+				zeroCopy = false;
+		}
+
+		if (result < 0 && result != B_INTERRUPTED
+			&& result != B_WOULD_BLOCK && result != EPIPE) {
+			// fall back to copying
+			if (!bufferDeleter.IsSet()) {
+				bufferDeleter.SetTo(malloc(SENDFILE_CHUNK_SIZE));
+				if (!bufferDeleter.IsSet()) {
+					result = B_NO_MEMORY;
+					break;
+				}
+			}
+
+			result = copy_file_data(out.Get(), in.Get(), pos, length,
+				bufferDeleter.Get());
+		}
+
+		if (result <= 0)
+			break;
+
+		pos += result;
+		bytesSent += result;
+	}
+
+	if (bytesSent == 0 && result < 0)
+		return result;
+
+	if (_offset != NULL)
+		*_offset = pos;
+	else
+		in->pos = pos;
+
+	return bytesSent;
+}
+
+
 // #pragma mark - kernel sockets API
 
 
@@ -1309,6 +1451,32 @@ _user_socketpair(int family, int type, int protocol, int *userSocketVector)
 }
 
 
+ssize_t
+_user_sendfile(int outFD, int inFD, off_t *userOffset, size_t count)
+{
+	off_t offset;
+	if (userOffset != NULL) {
+		if (!IS_USER_ADDRESS(userOffset)
+			|| user_memcpy(&offset, userOffset, sizeof(off_t)) != B_OK) {
+			return B_BAD_ADDRESS;
+		}
+	}
+
+	SyscallRestartWrapper<ssize_t> result;
+	result = common_sendfile(outFD, inFD, userOffset != NULL ? &offset : NULL,
+		count, false);
+	if (result < 0)
+		return result;
+
+	if (userOffset != NULL
+		&& user_memcpy(userOffset, &offset, sizeof(off_t)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	return result;
+}
+
+
 status_t
 _user_get_next_socket_stat(int family, uint32 *_cookie, struct net_stat *_stat)
 {
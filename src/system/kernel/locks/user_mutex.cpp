@@ -12,6 +12,7 @@
 
 #include <condition_variable.h>
 #include <kernel.h>
+#include <kscheduler.h>
 #include <lock.h>
 #include <smp.h>
 #include <syscall_restart.h>
@@ -29,6 +30,10 @@
  * a "read" lock before initiating a wait, and an unblocker acquires a "write"
  * lock. That way, unblockers can be sure that no waiters will start waiting
  * during unblock, and they can thus safely (without races) unset WAITING.
+ *
+ * For priority inheriting mutexes, the entry also remembers the owner that
+ * inherited a priority through it, and the highest priority of its waiters.
+ * These are protected by the inheritance_lock.
  */
 struct UserMutexEntry {
 	generic_addr_t		address;
@@ -37,6 +42,10 @@ struct UserMutexEntry {
 
 	rw_lock				lock;
 	ConditionVariable	condition;
+
+	mutex				inheritance_lock;
+	thread_id			inheriting_thread;
+	int32				inherited_priority;
 };
 
 struct UserMutexHashDefinition {
@@ -291,6 +300,9 @@ get_user_mutex_entry(struct user_mutex_context* context,
 	entry->ref_count = 1;
 	rw_lock_init(&entry->lock, "UserMutexEntry lock");
 	entry->condition.Init(entry, kUserMutexEntryType);
+	mutex_init(&entry->inheritance_lock, "UserMutexEntry inheritance lock");
+	entry->inheriting_thread = -1;
+	entry->inherited_priority = -1;
 
 	context->table.Insert(entry);
 	return entry;
@@ -321,10 +333,99 @@ put_user_mutex_entry(struct user_mutex_context* context, UserMutexEntry* entry)
 	tableWriteLocker.Unlock();
 
 	rw_lock_destroy(&entry->lock);
+	mutex_destroy(&entry->inheritance_lock);
 	delete entry;
 }
 
 
+// #pragma mark - priority inheritance
+
+
+/*!	Returns the priority of the thread that inherited a priority through the
+	given entry to what it would be without it.
+	The entry's inheritance_lock must be held.
+*/
+static void
+user_mutex_drop_inherited_priority_locked(UserMutexEntry* entry)
+{
+	if (entry->inheriting_thread < 0)
+		return;
+
+	Thread* thread = Thread::Get(entry->inheriting_thread);
+	entry->inheriting_thread = -1;
+	if (thread == NULL)
+		return;
+	BReference<Thread> threadReference(thread, true);
+
+	ThreadLocker threadLocker(thread);
+	if (--thread->inherited_priority_count == 0)
+		scheduler_set_thread_priority(thread, thread->base_priority);
+}
+
+
+/*!	Lets the owner of the mutex run with at least the given priority, until
+	it unlocks the mutex, or until nobody is waiting for it anymore.
+	The entry must be locked, so that the owner cannot unlock the mutex in
+	the meantime.
+*/
+static void
+user_mutex_inherit_priority(UserMutexEntry* entry, thread_id ownerID,
+	int32 priority)
+{
+	if (ownerID < 0)
+		return;
+
+	Thread* owner = Thread::Get(ownerID);
+	if (owner == NULL)
+		return;
+	BReference<Thread> ownerReference(owner, true);
+
+	// the owner ID comes from userland, so it could be anyone
+	Thread* thread = thread_get_current_thread();
+	if (owner != thread && (thread_is_idle_thread(owner)
+			|| !thread_check_permissions(thread, owner, false))) {
+		return;
+	}
+
+	MutexLocker inheritanceLocker(entry->inheritance_lock);
+	if (priority > entry->inherited_priority)
+		entry->inherited_priority = priority;
+
+	if (entry->inheriting_thread != ownerID) {
+		// A previous owner must not keep the priority it inherited through
+		// this mutex.
+		user_mutex_drop_inherited_priority_locked(entry);
+	}
+
+	ThreadLocker ownerLocker(owner);
+	if (priority <= owner->priority)
+		return;
+
+	if (entry->inheriting_thread != ownerID) {
+		if (owner->inherited_priority_count++ == 0)
+			owner->base_priority = owner->priority;
+		entry->inheriting_thread = ownerID;
+	}
+
+	scheduler_set_thread_priority(owner, priority);
+}
+
+
+/*!	Drops the inherited priority of the owner of the mutex, and forgets
+	about the waiters' priorities if none are left.
+	The entry must be write locked.
+*/
+static void
+user_mutex_drop_inherited_priority(UserMutexEntry* entry)
+{
+	MutexLocker inheritanceLocker(entry->inheritance_lock);
+	user_mutex_drop_inherited_priority_locked(entry);
+
+	if (entry->condition.EntriesCount() == 0)
+		entry->inherited_priority = -1;
+}
+
+
 static status_t
 user_mutex_wait_locked(UserMutexEntry* entry,
 	uint32 flags, bigtime_t timeout, ReadLocker& locker)
@@ -363,19 +464,40 @@ user_mutex_prepare_to_lock(UserMutexEntry* entry, int32* mutex, bool isWired)
 
 
 static status_t
-user_mutex_lock_locked(UserMutexEntry* entry, int32* mutex,
+user_mutex_lock_locked(UserMutexEntry* entry, int32* mutex, thread_id owner,
 	uint32 flags, bigtime_t timeout, ReadLocker& locker, bool isWired)
 {
 	if (user_mutex_prepare_to_lock(entry, mutex, isWired))
 		return B_OK;
 
+	const bool inheritPriority = (flags & B_USER_MUTEX_PRIO_INHERIT) != 0;
+	Thread* thread = thread_get_current_thread();
+	if (inheritPriority)
+		user_mutex_inherit_priority(entry, owner, thread->priority);
+
 	status_t error = user_mutex_wait_locked(entry, flags, timeout, locker);
 
+	if (error == B_OK && inheritPriority) {
+		// The mutex has been handed over to us, so we inherit the priority
+		// of the threads still waiting for it.
+		ReadLocker entryLocker(entry->lock);
+		if (entry->condition.EntriesCount() > 0) {
+			user_mutex_inherit_priority(entry, thread->id,
+				entry->inherited_priority);
+		}
+	}
+
 	// possibly unset waiting flag
 	if (error != B_OK && entry->condition.EntriesCount() == 0) {
 		WriteLocker writeLocker(entry->lock);
-		if (entry->condition.EntriesCount() == 0)
+		if (entry->condition.EntriesCount() == 0) {
 			user_atomic_and(mutex, ~(int32)B_USER_MUTEX_WAITING, isWired);
+
+			// the owner will not unblock anyone, so it has to drop the
+			// inherited priority now
+			if (inheritPriority)
+				user_mutex_drop_inherited_priority(entry);
+		}
 	}
 
 	return error;
@@ -386,6 +508,11 @@ static void
 user_mutex_unblock(UserMutexEntry* entry, int32* mutex, uint32 flags, bool isWired)
 {
 	WriteLocker entryLocker(entry->lock);
+
+	// the current owner is releasing the mutex
+	if ((flags & B_USER_MUTEX_PRIO_INHERIT) != 0)
+		user_mutex_drop_inherited_priority(entry);
+
 	if (entry->condition.EntriesCount() == 0) {
 		// Nobody is actually waiting at present.
 		user_atomic_and(mutex, ~(int32)B_USER_MUTEX_WAITING, isWired);
@@ -409,8 +536,14 @@ user_mutex_unblock(UserMutexEntry* entry, int32* mutex, uint32 flags, bool isWir
 			user_atomic_and(mutex, ~(int32)B_USER_MUTEX_LOCKED, isWired);
 	}
 
-	if (entry->condition.EntriesCount() == 0)
+	if (entry->condition.EntriesCount() == 0) {
 		user_atomic_and(mutex, ~(int32)B_USER_MUTEX_WAITING, isWired);
+
+		if ((flags & B_USER_MUTEX_PRIO_INHERIT) != 0) {
+			MutexLocker inheritanceLocker(entry->inheritance_lock);
+			entry->inherited_priority = -1;
+		}
+	}
 }
 
 
@@ -517,7 +650,7 @@ private:
 
 
 static status_t
-user_mutex_lock(int32* mutex, const char* name, uint32 flags, bigtime_t timeout)
+user_mutex_lock(int32* mutex, thread_id owner, uint32 flags, bigtime_t timeout)
 {
 	UserMutexContextFetcher contextFetcher(mutex, flags);
 	if (contextFetcher.InitCheck() != B_OK)
@@ -531,7 +664,7 @@ user_mutex_lock(int32* mutex, const char* name, uint32 flags, bigtime_t timeout)
 	status_t error = B_OK;
 	{
 		ReadLocker entryLocker(entry->lock);
-		error = user_mutex_lock_locked(entry, mutex,
+		error = user_mutex_lock_locked(entry, mutex, owner,
 			flags, timeout, entryLocker, contextFetcher.IsWired());
 	}
 	put_user_mutex_entry(contextFetcher.Context(), entry);
@@ -600,13 +733,30 @@ _user_mutex_lock(int32* mutex, const char* name, uint32 flags,
 
 	syscall_restart_handle_timeout_pre(flags, timeout);
 
-	status_t error = user_mutex_lock(mutex, name, flags | B_CAN_INTERRUPT,
+	status_t error = user_mutex_lock(mutex, -1,
+		(flags & ~(uint32)B_USER_MUTEX_PRIO_INHERIT) | B_CAN_INTERRUPT,
 		timeout);
 
 	return syscall_restart_handle_timeout_post(error, timeout);
 }
 
 
+status_t
+_user_mutex_lock_inherit(int32* mutex, thread_id owner, uint32 flags,
+	bigtime_t timeout)
+{
+	if (mutex == NULL || !IS_USER_ADDRESS(mutex) || (addr_t)mutex % 4 != 0)
+		return B_BAD_ADDRESS;
+
+	syscall_restart_handle_timeout_pre(flags, timeout);
+
+	status_t error = user_mutex_lock(mutex, owner,
+		flags | B_USER_MUTEX_PRIO_INHERIT | B_CAN_INTERRUPT, timeout);
+
+	return syscall_restart_handle_timeout_post(error, timeout);
+}
+
+
 status_t
 _user_mutex_unblock(int32* mutex, uint32 flags)
 {
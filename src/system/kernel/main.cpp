@@ -98,9 +98,14 @@ extern "C" int
 _start(kernel_args *bootKernelArgs, int currentCPU)
 {
 	if (bootKernelArgs->version == CURRENT_KERNEL_ARGS_VERSION
-		&& bootKernelArgs->kernel_args_size == kernel_args_size_v1) {
-		sKernelArgs.ucode_data = NULL;
-		sKernelArgs.ucode_data_size = 0;
+		&& (bootKernelArgs->kernel_args_size == kernel_args_size_v1
+			|| bootKernelArgs->kernel_args_size == kernel_args_size_v2)) {
+		if (bootKernelArgs->kernel_args_size == kernel_args_size_v1) {
+			sKernelArgs.ucode_data = NULL;
+			sKernelArgs.ucode_data_size = 0;
+		}
+		sKernelArgs.num_numa_nodes = 0;
+		sKernelArgs.num_numa_memory_ranges = 0;
 	} else if (bootKernelArgs->kernel_args_size != sizeof(kernel_args)
 		|| bootKernelArgs->version != CURRENT_KERNEL_ARGS_VERSION) {
 		// This is something we cannot handle right now - release kernels
@@ -89,6 +89,9 @@ public:
 
 	inline	void		PushFront(Element* element, unsigned int priority);
 	inline	void		PushBack(Element* elementt, unsigned int priority);
+	template<typename Compare>
+	inline	void		PushSorted(Element* element, unsigned int priority,
+							Compare compare);
 
 	inline	void		Remove(Element* element);
 
@@ -332,6 +335,43 @@ RUN_QUEUE_CLASS_NAME::PushBack(Element* element,
 }
 
 
+/*!	Inserts the element before the first element of the same priority that
+	\a compare does not order before it.
+*/
+RUN_QUEUE_TEMPLATE_LIST
+template<typename Compare>
+void
+RUN_QUEUE_CLASS_NAME::PushSorted(Element* element, unsigned int priority,
+	Compare compare)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	Element* next = fHeads[priority];
+	while (next != NULL && !compare(element, next))
+		next = sGetLink(next)->fNext;
+
+	if (next == NULL) {
+		PushBack(element, priority);
+		return;
+	}
+	if (next == fHeads[priority]) {
+		PushFront(element, priority);
+		return;
+	}
+
+	RunQueueLink<Element>* elementLink = sGetLink(element);
+	RunQueueLink<Element>* nextLink = sGetLink(next);
+	ASSERT(elementLink->fPrevious == NULL);
+	ASSERT(elementLink->fNext == NULL);
+
+	elementLink->fPriority = priority;
+	elementLink->fPrevious = nextLink->fPrevious;
+	elementLink->fNext = next;
+	sGetLink(nextLink->fPrevious)->fNext = element;
+	nextLink->fPrevious = element;
+}
+
+
 RUN_QUEUE_TEMPLATE_LIST
 void
 RUN_QUEUE_CLASS_NAME::Remove(Element* element)
@@ -17,6 +17,7 @@
 #include <OS.h>
 
 #include <AutoDeleter.h>
+#include <commpage.h>
 #include <cpu.h>
 #include <debug.h>
 #include <int.h>
@@ -28,12 +29,18 @@
 #include <smp.h>
 #include <timer.h>
 #include <util/Random.h>
+#include <util/ThreadAutoLock.h>
+
+#ifdef _COMPAT_MODE
+#	include <commpage_compat.h>
+#endif
 
 #include "scheduler_common.h"
 #include "scheduler_cpu.h"
 #include "scheduler_locking.h"
 #include "scheduler_modes.h"
 #include "scheduler_profiler.h"
+#include "scheduler_statistics.h"
 #include "scheduler_thread.h"
 #include "scheduler_tracing.h"
 
@@ -74,6 +81,19 @@ static scheduler_mode_operations* sSchedulerModes[] = {
 static int32* sCPUToCore;
 static int32* sCPUToPackage;
 
+// The IDs of the threads running on each CPU, exported via the commpage, so
+// that userland can tell whether the owner of a lock is running.
+static uint8* sCPUThreads;
+#ifdef _COMPAT_MODE
+static uint8* sCPUThreadsCompat;
+#endif
+
+// Protects the deadline load of the cores during admission control.
+static spinlock sDeadlineLock = B_SPINLOCK_INITIALIZER;
+
+static const bigtime_t kMinimalDeadlinePeriod = 100;
+static const bigtime_t kMaximalDeadlinePeriod = 10000000;
+
 
 static void enqueue(Thread* thread, bool newOne);
 
@@ -108,6 +128,13 @@ enqueue(Thread* thread, bool newOne)
 		ASSERT(thread->previous_cpu != NULL);
 		ASSERT(threadData->Core() != NULL);
 		targetCPU = &gCPUEntries[thread->previous_cpu->cpu_num];
+	} else if (threadData->HasDeadline()
+		&& threadData->DeadlineCore()->CPUCount() > 0
+		&& (threadData->GetCPUMask().IsEmpty()
+			|| threadData->GetCPUMask().Matches(
+				threadData->DeadlineCore()->CPUMask()))) {
+		// deadline threads stay on the core they were admitted to
+		targetCore = threadData->DeadlineCore();
 	} else if (gSingleCore) {
 		targetCore = &gCoreEntries[0];
 	} else if (threadData->Core() != NULL
@@ -127,9 +154,12 @@ enqueue(Thread* thread, bool newOne)
 	NotifySchedulerListeners(&SchedulerListener::ThreadEnqueuedInRunQueue,
 		thread);
 
+	// If the CPU runs another deadline thread, it has to compare deadlines.
 	int32 heapPriority = CPUPriorityHeap::GetKey(targetCPU);
 	if (threadPriority > heapPriority
 		|| (threadPriority == heapPriority && rescheduleNeeded)
+		|| (threadPriority == kDeadlinePriority
+			&& heapPriority == kDeadlinePriority)
 		|| wasRunQueueEmpty) {
 
 		if (targetCPU->ID() == smp_get_current_cpu()) {
@@ -219,6 +249,53 @@ scheduler_set_thread_priority(Thread *thread, int32 priority)
 }
 
 
+/*!	Moves a thread whose effective priority changed to its new position.
+	The thread's scheduler lock must be held.
+*/
+static void
+update_thread_position(Thread* thread)
+{
+	ThreadData* threadData = thread->scheduler_data;
+
+	if (thread->state == B_THREAD_RUNNING) {
+		CPUEntry* cpu = &gCPUEntries[thread->cpu->cpu_num];
+
+		CoreCPUHeapLocker _(threadData->Core());
+		cpu->UpdatePriority(threadData->GetEffectivePriority());
+		return;
+	}
+
+	if (thread->state != B_THREAD_READY)
+		return;
+
+	T(RemoveThread(thread));
+	NotifySchedulerListeners(&SchedulerListener::ThreadRemovedFromRunQueue,
+		thread);
+
+	if (threadData->Dequeue())
+		enqueue(thread, true);
+}
+
+
+/*!	Timer hook that gives a throttled deadline thread a new budget, at the
+	start of its next period.
+*/
+int32
+Scheduler::replenish_deadline_budget(timer* event)
+{
+	ThreadData* threadData = (ThreadData*)event->user_data;
+	Thread* thread = threadData->GetThread();
+
+	SpinLocker locker(thread->scheduler_lock);
+	SchedulerModeLocker modeLocker;
+
+	if (threadData->ReplenishBudget())
+		update_thread_position(thread);
+
+	return B_HANDLED_INTERRUPT;
+}
+
+
 void
 scheduler_reschedule_ici()
 {
@@ -280,6 +357,19 @@ scheduler_new_thread_entry(Thread* thread)
 }
 
 
+static inline void
+set_cpu_thread(int32 cpu, thread_id thread)
+{
+	if (sCPUThreads == NULL)
+		return;
+
+	*(int32*)(sCPUThreads + cpu * COMMPAGE_CPU_THREAD_STRIDE) = thread;
+#ifdef _COMPAT_MODE
+	*(int32*)(sCPUThreadsCompat + cpu * COMMPAGE_CPU_THREAD_STRIDE) = thread;
+#endif
+}
+
+
 /*!	Switches the currently running thread.
 	This is a service function for scheduler implementations.
 
@@ -304,6 +394,8 @@ switch_thread(Thread* fromThread, Thread* toThread)
 	cpu->running_thread = toThread;
 	cpu->previous_thread = fromThread;
 
+	set_cpu_thread(cpu->cpu_num, toThread->id);
+
 	arch_thread_set_current_thread(toThread);
 	arch_thread_context_switch(fromThread, toThread);
 
@@ -452,6 +544,8 @@ reschedule(int32 nextState)
 	ASSERT(nextThreadData->Core() == core);
 	nextThread->state = B_THREAD_RUNNING;
 	nextThreadData->StartCPUTime();
+	if (nextThread != oldThread)
+		nextThreadData->StartsRunning(thisCPU);
 
 	// track CPU activity
 	cpu->TrackActivity(oldThreadData, nextThreadData);
@@ -527,6 +621,14 @@ scheduler_on_thread_init(Thread* thread)
 void
 scheduler_on_thread_destroy(Thread* thread)
 {
+	ThreadData* threadData = thread->scheduler_data;
+	if (threadData->HasDeadline()) {
+		InterruptsSpinLocker _(sDeadlineLock);
+		threadData->DeadlineCore()->ChangeDeadlineLoad(
+			-threadData->DeadlineLoad());
+	}
+	threadData->CancelReplenishTimer();
+
 	delete thread->scheduler_data;
 }
 
@@ -718,7 +820,7 @@ init()
 		PackageEntry* package = &gPackageEntries[sCPUToPackage[i]];
 
 		package->Init(sCPUToPackage[i]);
-		core->Init(sCPUToCore[i], package);
+		core->Init(sCPUToCore[i], package, gCPU[i].numa_node);
 		gCPUEntries[i].Init(i, core);
 
 		core->AddCPU(&gCPUEntries[i]);
@@ -748,9 +850,17 @@ scheduler_init()
 	if (result != B_OK)
 		panic("scheduler_init: failed to initialize scheduler\n");
 
+	sCPUThreads = (uint8*)allocate_commpage_entry(COMMPAGE_ENTRY_CPU_THREADS,
+		cpuCount * COMMPAGE_CPU_THREAD_STRIDE);
+#ifdef _COMPAT_MODE
+	sCPUThreadsCompat = (uint8*)allocate_commpage_compat_entry(
+		COMMPAGE_ENTRY_CPU_THREADS, cpuCount * COMMPAGE_CPU_THREAD_STRIDE);
+#endif
+
 	scheduler_set_operation_mode(SCHEDULER_MODE_LOW_LATENCY);
 
 	init_debug_commands();
+	init_stats();
 
 #if SCHEDULER_TRACING
 	add_debugger_command_etc("scheduler", &cmd_scheduler,
@@ -856,6 +966,138 @@ _user_estimate_max_scheduling_latency(thread_id id)
 }
 
 
+/*!	Returns the core with the most deadline bandwidth left that has CPUs in
+	\a mask, and that can take another \a load, or \c NULL if there is none.
+	The bandwidth the thread uses on its current core counts as available.
+	sDeadlineLock must be held.
+*/
+static CoreEntry*
+choose_deadline_core(ThreadData* threadData, const CPUSet& mask, int32 load)
+{
+	CoreEntry* oldCore = threadData->HasDeadline()
+		? threadData->DeadlineCore() : NULL;
+	const bool useMask = !mask.IsEmpty();
+
+	CoreEntry* core = NULL;
+	int32 mostAvailable = 0;
+	for (int32 i = 0; i < gCoreCount; i++) {
+		CoreEntry* candidate = &gCoreEntries[i];
+		if (candidate->CPUCount() == 0
+			|| (useMask && !mask.Matches(candidate->CPUMask()))) {
+			continue;
+		}
+
+		int32 available = kMaxDeadlineLoad * candidate->CPUCount()
+			- candidate->DeadlineLoad();
+		if (candidate == oldCore)
+			available += threadData->DeadlineLoad();
+		if (available >= load && available > mostAvailable) {
+			core = candidate;
+			mostAvailable = available;
+		}
+	}
+
+	return core;
+}
+
+
+/*!	Sets the CPU affinity of the given \a thread. A deadline thread is moved
+	to another core if the one it was admitted to has no CPU in \a mask.
+	If no core in \a mask can take its load, \c B_BUSY is returned, and the
+	affinity is left unchanged.
+	The caller must hold the thread's lock.
+*/
+status_t
+scheduler_set_thread_affinity(Thread* thread, const CPUSet& mask)
+{
+	ThreadData* threadData = thread->scheduler_data;
+
+	InterruptsSpinLocker schedulerLocker(thread->scheduler_lock);
+	if (!threadData->HasDeadline()) {
+		thread->cpumask = mask;
+		return B_OK;
+	}
+
+	CPUSet enabledMask = mask.And(gCPUEnabled);
+	CoreEntry* oldCore = threadData->DeadlineCore();
+	if (enabledMask.IsEmpty() || enabledMask.Matches(oldCore->CPUMask())) {
+		thread->cpumask = mask;
+		return B_OK;
+	}
+
+	SpinLocker deadlineLocker(sDeadlineLock);
+	CoreEntry* core = choose_deadline_core(threadData, enabledMask,
+		threadData->DeadlineLoad());
+	if (core == NULL)
+		return B_BUSY;
+
+	core->ChangeDeadlineLoad(threadData->DeadlineLoad());
+	oldCore->ChangeDeadlineLoad(-threadData->DeadlineLoad());
+	deadlineLocker.Unlock();
+
+	SchedulerModeLocker modeLocker;
+	thread->cpumask = mask;
+	threadData->SetDeadlineCore(core);
+	update_thread_position(thread);
+
+	return B_OK;
+}
+
+
+/*!	Makes the thread a deadline thread, that gets \a runtime of CPU time
+	within \a deadline after the start of each \a period. It is admitted to
+	the core with the most bandwidth left, if any core can take it.
+	A \a runtime of 0 makes it a normal thread again.
+*/
+status_t
+_user_set_thread_deadline(thread_id id, bigtime_t runtime, bigtime_t deadline,
+	bigtime_t period)
+{
+	if (runtime < 0 || (runtime > 0 && (runtime > deadline
+			|| deadline > period || period < kMinimalDeadlinePeriod
+			|| period > kMaximalDeadlinePeriod))) {
+		return B_BAD_VALUE;
+	}
+
+	Thread* thread = Thread::GetAndLock(id);
+	if (thread == NULL)
+		return B_BAD_THREAD_ID;
+	BReference<Thread> threadReference(thread, true);
+	ThreadLocker threadLocker(thread, true);
+
+	if (thread_is_idle_thread(thread) || !thread_check_permissions(
+			thread_get_current_thread(), thread, false)) {
+		return B_NOT_ALLOWED;
+	}
+
+	ThreadData* threadData = thread->scheduler_data;
+	int32 load = runtime > 0 ? (runtime * kMaxLoad + period - 1) / period : 0;
+
+	InterruptsSpinLocker schedulerLocker(thread->scheduler_lock);
+	SpinLocker deadlineLocker(sDeadlineLock);
+
+	CoreEntry* oldCore = threadData->HasDeadline()
+		? threadData->DeadlineCore() : NULL;
+	CoreEntry* core = NULL;
+	if (runtime > 0) {
+		core = choose_deadline_core(threadData, threadData->GetCPUMask(),
+			load);
+		if (core == NULL)
+			return B_BUSY;
+		core->ChangeDeadlineLoad(load);
+	}
+	if (oldCore != NULL)
+		oldCore->ChangeDeadlineLoad(-threadData->DeadlineLoad());
+	deadlineLocker.Unlock();
+
+	SchedulerModeLocker modeLocker;
+	threadData->SetDeadline(runtime, deadline, period, core, load);
+	update_thread_position(thread);
+
+	return B_OK;
+}
+
+
 status_t
 _user_set_scheduler_mode(int32 mode)
 {
@@ -42,6 +42,14 @@ const int kVeryHighLoad = (kMaxLoad + kHighLoad) / 2;
 
 const int kLoadDifference = kMaxLoad * 20 / 100;
 
+// Threads of the deadline class run at a priority above all priorities that
+// can be set, as long as they have budget left. Among themselves they are
+// ordered by their deadlines.
+const int32 kDeadlinePriority = THREAD_MAX_SET_PRIORITY + 1;
+
+// The share of each CPU that admission control hands out to deadline threads.
+const int kMaxDeadlineLoad = kMaxLoad * 80 / 100;
+
 extern bool gSingleCore;
 extern bool gTrackCoreLoad;
 extern bool gTrackCPULoad;
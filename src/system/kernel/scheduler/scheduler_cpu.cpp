@@ -130,7 +130,10 @@ void
 CPUEntry::PushFront(ThreadData* thread, int32 priority)
 {
 	SCHEDULER_ENTER_FUNCTION();
-	fRunQueue.PushFront(thread, priority);
+	if (priority == kDeadlinePriority)
+		fRunQueue.PushSorted(thread, priority, &ThreadData::HasEarlierDeadline);
+	else
+		fRunQueue.PushFront(thread, priority);
 }
 
 
@@ -138,7 +141,10 @@ void
 CPUEntry::PushBack(ThreadData* thread, int32 priority)
 {
 	SCHEDULER_ENTER_FUNCTION();
-	fRunQueue.PushBack(thread, priority);
+	if (priority == kDeadlinePriority)
+		fRunQueue.PushSorted(thread, priority, &ThreadData::HasEarlierDeadline);
+	else
+		fRunQueue.PushBack(thread, priority);
 }
 
 
@@ -240,11 +246,21 @@ CPUEntry::ChooseNextThread(ThreadData* oldThread, bool putAtBack)
 	if (sharedThread != NULL)
 		sharedPriority = sharedThread->GetEffectivePriority();
 
+	// deadline threads of the same priority are ordered by their deadlines
+	bool preferShared = sharedPriority > pinnedPriority
+		|| (sharedPriority == kDeadlinePriority
+			&& pinnedPriority == kDeadlinePriority
+			&& ThreadData::HasEarlierDeadline(sharedThread, pinnedThread));
+
 	int32 rest = std::max(pinnedPriority, sharedPriority);
+	if (oldPriority == kDeadlinePriority && rest == kDeadlinePriority) {
+		putAtBack = ThreadData::HasEarlierDeadline(
+			preferShared ? sharedThread : pinnedThread, oldThread);
+	}
 	if (oldPriority > rest || (!putAtBack && oldPriority == rest))
 		return oldThread;
 
-	if (sharedPriority > pinnedPriority) {
+	if (preferShared) {
 		fCore->Remove(sharedThread);
 		return sharedThread;
 	}
@@ -402,6 +418,7 @@ CPUPriorityHeap::Dump()
 
 CoreEntry::CoreEntry()
 	:
+	fNUMANode(0),
 	fCPUCount(0),
 	fIdleCPUCount(0),
 	fThreadCount(0),
@@ -410,7 +427,8 @@ CoreEntry::CoreEntry()
 	fCurrentLoad(0),
 	fLoadMeasurementEpoch(0),
 	fHighLoad(false),
-	fLastLoadUpdate(0)
+	fLastLoadUpdate(0),
+	fDeadlineLoad(0)
 {
 	B_INITIALIZE_SPINLOCK(&fCPULock);
 	B_INITIALIZE_SPINLOCK(&fQueueLock);
@@ -420,10 +438,11 @@ CoreEntry::CoreEntry()
 
 
 void
-CoreEntry::Init(int32 id, PackageEntry* package)
+CoreEntry::Init(int32 id, PackageEntry* package, int32 numaNode)
 {
 	fCoreID = id;
 	fPackage = package;
+	fNUMANode = numaNode;
 }
 
 
@@ -432,7 +451,10 @@ CoreEntry::PushFront(ThreadData* thread, int32 priority)
 {
 	SCHEDULER_ENTER_FUNCTION();
 
-	fRunQueue.PushFront(thread, priority);
+	if (priority == kDeadlinePriority)
+		fRunQueue.PushSorted(thread, priority, &ThreadData::HasEarlierDeadline);
+	else
+		fRunQueue.PushFront(thread, priority);
 	atomic_add(&fThreadCount, 1);
 }
 
@@ -442,7 +464,10 @@ CoreEntry::PushBack(ThreadData* thread, int32 priority)
 {
 	SCHEDULER_ENTER_FUNCTION();
 
-	fRunQueue.PushBack(thread, priority);
+	if (priority == kDeadlinePriority)
+		fRunQueue.PushSorted(thread, priority, &ThreadData::HasEarlierDeadline);
+	else
+		fRunQueue.PushBack(thread, priority);
 	atomic_add(&fThreadCount, 1);
 }
 
@@ -20,6 +20,7 @@
 #include "scheduler_common.h"
 #include "scheduler_modes.h"
 #include "scheduler_profiler.h"
+#include "scheduler_statistics.h"
 
 
 namespace Scheduler {
@@ -38,7 +39,7 @@ class PackageEntry;
 // One queue per schedulable target per core. Additionally, each
 // logical processor has its sPinnedRunQueues used for scheduling
 // pinned threads.
-class ThreadRunQueue : public RunQueue<ThreadData, THREAD_MAX_SET_PRIORITY> {
+class ThreadRunQueue : public RunQueue<ThreadData, kDeadlinePriority> {
 public:
 						void			Dump() const;
 };
@@ -126,10 +127,13 @@ class CoreEntry : public MinMaxHeapLinkImpl<CoreEntry, int32>,
 public:
 										CoreEntry();
 
-						void			Init(int32 id, PackageEntry* package);
+						void			Init(int32 id, PackageEntry* package,
+											int32 numaNode);
 
 	inline				int32			ID() const	{ return fCoreID; }
 	inline				PackageEntry*	Package() const	{ return fPackage; }
+	inline				int32			NUMANode() const
+											{ return fNUMANode; }
 	inline				int32			CPUCount() const
 											{ return fCPUCount; }
 	inline				const CPUSet&	CPUMask() const
@@ -168,6 +172,11 @@ public:
 	inline				void			CPUGoesIdle(CPUEntry* cpu);
 	inline				void			CPUWakesUp(CPUEntry* cpu);
 
+	inline				int32			DeadlineLoad() const
+											{ return fDeadlineLoad; }
+	inline				void			ChangeDeadlineLoad(int32 delta)
+											{ fDeadlineLoad += delta; }
+
 						void			AddCPU(CPUEntry* cpu);
 						void			RemoveCPU(CPUEntry* cpu,
 											ThreadProcessing&
@@ -183,6 +192,7 @@ private:
 
 						int32			fCoreID;
 						PackageEntry*	fPackage;
+						int32			fNUMANode;
 
 						int32			fCPUCount;
 						CPUSet			fCPUSet;
@@ -204,6 +214,8 @@ private:
 						bigtime_t		fLastLoadUpdate;
 						rw_spinlock		fLoadLock;
 
+						int32			fDeadlineLoad;
+
 						friend class DebugDumper;
 } CACHE_LINE_ALIGN;
 
@@ -303,7 +315,8 @@ inline void
 CPUEntry::LockRunQueue()
 {
 	SCHEDULER_ENTER_FUNCTION();
-	acquire_spinlock(&fQueueLock);
+	acquire_scheduler_spinlock(&fQueueLock,
+		SCHEDULER_STATS_LOCK_CPU_RUN_QUEUE);
 }
 
 
@@ -327,7 +340,7 @@ inline void
 CoreEntry::LockCPUHeap()
 {
 	SCHEDULER_ENTER_FUNCTION();
-	acquire_spinlock(&fCPULock);
+	acquire_scheduler_spinlock(&fCPULock, SCHEDULER_STATS_LOCK_CPU_HEAP);
 }
 
 
@@ -359,7 +372,8 @@ inline void
 CoreEntry::LockRunQueue()
 {
 	SCHEDULER_ENTER_FUNCTION();
-	acquire_spinlock(&fQueueLock);
+	acquire_scheduler_spinlock(&fQueueLock,
+		SCHEDULER_STATS_LOCK_CORE_RUN_QUEUE);
 }
 
 
@@ -0,0 +1,314 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Scheduler statistics that can be turned on at run time.
+
+	Whenever a thread starts running after it had been waiting in a run
+	queue, an event with the time it waited is written into a ring buffer of
+	the CPU it runs on. Userland reads the events via the SCHEDULER_STATS
+	generic syscall, and computes per thread latency histograms from them.
+	The CPUs also count migrations, and how often and how long they had to
+	wait for the run queue and CPU heap spinlocks.
+*/
+
+
+#include "scheduler_statistics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <cpu.h>
+#include <generic_syscall.h>
+#include <kernel.h>
+#include <lock.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+
+
+namespace Scheduler {
+
+bool gSchedulerStatsEnabled;
+
+}	// namespace Scheduler
+
+using namespace Scheduler;
+
+
+static const uint32 kEventBufferSize = 4096;
+static const uint32 kReadChunkSize = 32;
+
+
+struct CPUStats {
+	spinlock					lock;
+	uint32						first;
+	uint32						count;
+	scheduler_stats_event*		events;
+
+	scheduler_stats_cpu_info	info;
+} CACHE_LINE_ALIGN;
+
+
+static CPUStats* sCPUStats;
+static int32 sCPUCount;
+static mutex sStatsLock = MUTEX_INITIALIZER("scheduler stats");
+
+
+static status_t
+allocate_stats()
+{
+	CPUStats* stats = (CPUStats*)memalign(CACHE_LINE_SIZE,
+		sizeof(CPUStats) * sCPUCount);
+	if (stats == NULL)
+		return B_NO_MEMORY;
+
+	memset(stats, 0, sizeof(CPUStats) * sCPUCount);
+
+	for (int32 i = 0; i < sCPUCount; i++) {
+		B_INITIALIZE_SPINLOCK(&stats[i].lock);
+		stats[i].events = (scheduler_stats_event*)malloc(
+			sizeof(scheduler_stats_event) * kEventBufferSize);
+		if (stats[i].events == NULL) {
+			for (int32 j = 0; j < i; j++)
+				free(stats[j].events);
+			free(stats);
+			return B_NO_MEMORY;
+		}
+	}
+
+	sCPUStats = stats;
+	return B_OK;
+}
+
+
+static status_t
+set_enabled(bool enabled)
+{
+	MutexLocker locker(sStatsLock);
+
+	if (enabled == gSchedulerStatsEnabled)
+		return B_OK;
+
+	if (!enabled) {
+		// The buffers are never freed, as a CPU might still be recording.
+		gSchedulerStatsEnabled = false;
+		return B_OK;
+	}
+
+	if (sCPUStats == NULL) {
+		status_t status = allocate_stats();
+		if (status != B_OK)
+			return status;
+	}
+
+	for (int32 i = 0; i < sCPUCount; i++) {
+		CPUStats& stats = sCPUStats[i];
+
+		InterruptsSpinLocker _(stats.lock);
+		stats.first = 0;
+		stats.count = 0;
+		memset(&stats.info, 0, sizeof(stats.info));
+	}
+
+	memory_write_barrier();
+	gSchedulerStatsEnabled = true;
+	return B_OK;
+}
+
+
+static status_t
+read_events(scheduler_stats_event* events, uint32& count)
+{
+	MutexLocker locker(sStatsLock);
+
+	uint32 read = 0;
+	for (int32 i = 0; sCPUStats != NULL && i < sCPUCount; i++) {
+		CPUStats& stats = sCPUStats[i];
+
+		while (read < count) {
+			// copy the events in chunks, since we cannot access userland
+			// memory with interrupts disabled
+			scheduler_stats_event chunk[kReadChunkSize];
+			uint32 chunkCount;
+
+			InterruptsSpinLocker spinLocker(stats.lock);
+			chunkCount = std::min(std::min(stats.count, kReadChunkSize),
+				count - read);
+			for (uint32 j = 0; j < chunkCount; j++) {
+				chunk[j] = stats.events[stats.first];
+				stats.first = (stats.first + 1) % kEventBufferSize;
+			}
+			stats.count -= chunkCount;
+			spinLocker.Unlock();
+
+			if (chunkCount == 0)
+				break;
+
+			if (user_memcpy(events + read, chunk,
+					sizeof(scheduler_stats_event) * chunkCount) != B_OK) {
+				return B_BAD_ADDRESS;
+			}
+			read += chunkCount;
+		}
+	}
+
+	count = read;
+	return B_OK;
+}
+
+
+static status_t
+scheduler_stats_syscall(const char* subsystem, uint32 function,
+	void* buffer, size_t bufferSize)
+{
+	if (!IS_USER_ADDRESS(buffer))
+		return B_BAD_ADDRESS;
+
+	switch (function) {
+		case SCHEDULER_STATS_SET_ENABLED:
+		{
+			uint32 enabled;
+			if (bufferSize != sizeof(enabled))
+				return B_BAD_VALUE;
+			if (geteuid() != 0)
+				return B_NOT_ALLOWED;
+			if (user_memcpy(&enabled, buffer, sizeof(enabled)) != B_OK)
+				return B_BAD_ADDRESS;
+
+			return set_enabled(enabled != 0);
+		}
+
+		case SCHEDULER_STATS_GET_INFO:
+		{
+			if (bufferSize != sizeof(scheduler_stats_info))
+				return B_BAD_VALUE;
+
+			scheduler_stats_info info;
+			info.enabled = gSchedulerStatsEnabled;
+			info.cpu_count = sCPUCount;
+			info.buffer_size = kEventBufferSize;
+
+			return user_memcpy(buffer, &info, sizeof(info));
+		}
+
+		case SCHEDULER_STATS_GET_CPU_INFO:
+		{
+			// fills in as many CPUs as fit into the buffer
+			int32 count = std::min(sCPUCount,
+				int32(bufferSize / sizeof(scheduler_stats_cpu_info)));
+			if (count == 0)
+				return B_BAD_VALUE;
+
+			MutexLocker locker(sStatsLock);
+
+			scheduler_stats_cpu_info* infos
+				= (scheduler_stats_cpu_info*)buffer;
+			for (int32 i = 0; i < count; i++) {
+				scheduler_stats_cpu_info info = {};
+				if (sCPUStats != NULL) {
+					InterruptsSpinLocker _(sCPUStats[i].lock);
+					info = sCPUStats[i].info;
+				}
+
+				if (user_memcpy(infos + i, &info, sizeof(info)) != B_OK)
+					return B_BAD_ADDRESS;
+			}
+
+			return B_OK;
+		}
+
+		case SCHEDULER_STATS_READ_EVENTS:
+		{
+			scheduler_stats_read_events args;
+			if (bufferSize != sizeof(args))
+				return B_BAD_VALUE;
+			if (geteuid() != 0)
+				return B_NOT_ALLOWED;
+			if (user_memcpy(&args, buffer, sizeof(args)) != B_OK
+				|| !IS_USER_ADDRESS(args.events)) {
+				return B_BAD_ADDRESS;
+			}
+
+			status_t status = read_events(args.events, args.count);
+			if (status != B_OK)
+				return status;
+
+			return user_memcpy(
+				&((scheduler_stats_read_events*)buffer)->count, &args.count,
+				sizeof(args.count));
+		}
+	}
+
+	return B_BAD_VALUE;
+}
+
+
+//	#pragma mark -
+
+
+void
+Scheduler::init_stats()
+{
+	sCPUCount = smp_get_num_cpus();
+
+	register_generic_syscall(SCHEDULER_STATS, &scheduler_stats_syscall, 1, 0);
+}
+
+
+/*!	Called with interrupts disabled, when \a thread is about to run on
+	\a cpu after it had been put into a run queue at \a readyTime.
+*/
+void
+Scheduler::record_thread_scheduled(Thread* thread, int32 cpu,
+	bigtime_t readyTime, bool wokenUp)
+{
+	CPUStats& stats = sCPUStats[cpu];
+	bigtime_t now = system_time();
+	int32 previousCPU = thread->previous_cpu != NULL
+		? thread->previous_cpu->cpu_num : -1;
+
+	SpinLocker _(stats.lock);
+
+	stats.info.events++;
+	if (previousCPU >= 0 && previousCPU != cpu)
+		stats.info.migrations++;
+
+	if (stats.count == kEventBufferSize) {
+		// overwrite the oldest event, the latest ones are more interesting
+		stats.first = (stats.first + 1) % kEventBufferSize;
+		stats.count--;
+		stats.info.lost_events++;
+	}
+
+	scheduler_stats_event& event
+		= stats.events[(stats.first + stats.count) % kEventBufferSize];
+	event.thread = thread->id;
+	event.cpu = cpu;
+	event.previous_cpu = previousCPU;
+	event.time = now;
+	event.latency = now - readyTime;
+	event.priority = thread->priority;
+	event.flags = wokenUp ? SCHEDULER_STATS_EVENT_WAKEUP : 0;
+	stats.count++;
+}
+
+
+/*!	Called with interrupts disabled after the current CPU had to wait for
+	one of the scheduler's spinlocks.
+*/
+void
+Scheduler::record_lock_contention(int32 lock, nanotime_t waitTime)
+{
+	CPUStats& stats = sCPUStats[smp_get_current_cpu()];
+
+	// set_enabled() resets the counters from another CPU
+	SpinLocker _(stats.lock);
+
+	stats.info.lock_contended[lock]++;
+	stats.info.lock_wait_time[lock] += waitTime;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef KERNEL_SCHEDULER_STATISTICS_H
+#define KERNEL_SCHEDULER_STATISTICS_H
+
+
+#include <OS.h>
+
+#include <scheduler_stats.h>
+#include <smp.h>
+
+
+namespace BKernel {
+	struct Thread;
+}
+
+using BKernel::Thread;
+
+
+namespace Scheduler {
+
+
+/*!	Scheduler statistics are always compiled in, but only recorded while
+	they are enabled from userland; otherwise they cost a single test of this
+	flag at each place they would be recorded.
+*/
+extern bool gSchedulerStatsEnabled;
+
+
+void		init_stats();
+
+void		record_thread_scheduled(Thread* thread, int32 cpu,
+				bigtime_t readyTime, bool wokenUp);
+void		record_lock_contention(int32 lock, nanotime_t waitTime);
+
+
+inline void
+acquire_scheduler_spinlock(spinlock* lock, int32 type)
+{
+	if (__builtin_expect(!gSchedulerStatsEnabled, true)) {
+		acquire_spinlock(lock);
+		return;
+	}
+
+	if (try_acquire_spinlock(lock))
+		return;
+
+	nanotime_t start = system_time_nsecs();
+	acquire_spinlock(lock);
+	record_lock_contention(type, system_time_nsecs() - start);
+}
+
+
+}	// namespace Scheduler
+
+
+#endif	// KERNEL_SCHEDULER_STATISTICS_H
@@ -28,6 +28,21 @@ ThreadData::_InitBase()
 	fEnqueued = false;
 	fReady = false;
 
+	fReadyTime = 0;
+	fWokenUp = false;
+
+	fDeadlineRuntime = 0;
+	fRelativeDeadline = 0;
+	fDeadlinePeriod = 0;
+	fDeadlineLoad = 0;
+	fDeadlineCore = NULL;
+	fPeriodStart = 0;
+	fAbsoluteDeadline = 0;
+	fRemainingBudget = 0;
+	fThrottled = false;
+	fReplenishTimerPending = false;
+	fReplenishTimerUsed = false;
+
 	fPriorityPenalty = 0;
 	fAdditionalPenalty = 0;
 
@@ -48,7 +63,35 @@ ThreadData::_ChooseCore() const
 	SCHEDULER_ENTER_FUNCTION();
 
 	ASSERT(!gSingleCore);
-	return gCurrentMode->choose_core(this);
+	CoreEntry* core = gCurrentMode->choose_core(this);
+
+	// Keep the thread on the NUMA node its memory is on, unless that node
+	// is considerably busier than the core the scheduler mode chose.
+	int32 node = fThread->numa_node;
+	if (gNUMANodeCount == 1 || node < 0 || core->NUMANode() == node)
+		return core;
+
+	CPUSet mask = GetCPUMask();
+	const bool useMask = !mask.IsEmpty();
+
+	CoreEntry* nodeCore = NULL;
+	for (int32 i = 0; i < gCoreCount; i++) {
+		CoreEntry* candidate = &gCoreEntries[i];
+		if (candidate->NUMANode() != node || candidate->CPUCount() == 0
+			|| (useMask && !mask.Matches(candidate->CPUMask()))) {
+			continue;
+		}
+
+		if (nodeCore == NULL || candidate->GetLoad() < nodeCore->GetLoad())
+			nodeCore = candidate;
+	}
+
+	if (nodeCore != NULL
+		&& nodeCore->GetLoad() < core->GetLoad() + kLoadDifference) {
+		return nodeCore;
+	}
+
+	return core;
 }
 
 
@@ -155,6 +198,16 @@ ThreadData::Dump() const
 		fCore != NULL ? fCore->ID() : -1);
 	if (fCore != NULL && HasCacheExpired())
 		kprintf("\tcache affinity has expired\n");
+
+	if (HasDeadline()) {
+		kprintf("\tdeadline:\t\truntime %" B_PRId64 " us, deadline %" B_PRId64
+			" us, period %" B_PRId64 " us, core %" B_PRId32 "\n",
+			fDeadlineRuntime, fRelativeDeadline, fDeadlinePeriod,
+			fDeadlineCore->ID());
+		kprintf("\tabsolute_deadline:\t%" B_PRId64 "%s\n", fAbsoluteDeadline,
+			fThrottled ? " (throttled)" : "");
+		kprintf("\tremaining_budget:\t%" B_PRId64 " us\n", fRemainingBudget);
+	}
 }
 
 
@@ -219,6 +272,58 @@ ThreadData::ComputeQuantum() const
 }
 
 
+/*!	Makes the thread a deadline thread, or a normal one again if \a runtime
+	is 0. Admission control has to be done by the caller.
+	The thread's scheduler lock must be held.
+*/
+void
+ThreadData::SetDeadline(bigtime_t runtime, bigtime_t deadline,
+	bigtime_t period, CoreEntry* core, int32 load)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	fDeadlineRuntime = runtime;
+	fRelativeDeadline = deadline;
+	fDeadlinePeriod = runtime != 0 ? period : 0;
+	fDeadlineLoad = runtime != 0 ? load : 0;
+	fDeadlineCore = runtime != 0 ? core : NULL;
+	fThrottled = false;
+
+	if (HasDeadline())
+		_StartDeadlinePeriod(system_time());
+	_ComputeEffectivePriority();
+}
+
+
+/*!	Called by the replenish timer, with the thread's scheduler lock held.
+	Returns whether the thread's effective priority changed.
+*/
+bool
+ThreadData::ReplenishBudget()
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	fReplenishTimerPending = false;
+	if (!HasDeadline() || !fThrottled)
+		return false;
+
+	_StartDeadlinePeriod(system_time());
+	return true;
+}
+
+
+/*!	Called when the thread is destroyed. Must not be called with the
+	thread's scheduler lock held, as it waits for a timer hook that might be
+	running on another CPU to finish.
+*/
+void
+ThreadData::CancelReplenishTimer()
+{
+	if (fReplenishTimerUsed)
+		cancel_timer(&fReplenishTimer);
+}
+
+
 void
 ThreadData::UnassignCore(bool running)
 {
@@ -300,7 +405,10 @@ ThreadData::_ComputeEffectivePriority() const
 
 	if (IsIdle())
 		fEffectivePriority = B_IDLE_PRIORITY;
-	else if (IsRealTime())
+	else if (HasDeadline()) {
+		fEffectivePriority
+			= fThrottled ? B_LOWEST_ACTIVE_PRIORITY : kDeadlinePriority;
+	} else if (IsRealTime())
 		fEffectivePriority = GetPriority();
 	else {
 		fEffectivePriority = GetPriority();
@@ -312,7 +420,8 @@ ThreadData::_ComputeEffectivePriority() const
 		ASSERT(fEffectivePriority >= B_LOWEST_ACTIVE_PRIORITY);
 	}
 
-	fBaseQuantum = sQuantumLengths[GetEffectivePriority()];
+	fBaseQuantum = sQuantumLengths[
+		std::min(GetEffectivePriority(), int32(THREAD_MAX_SET_PRIORITY))];
 }
 
 
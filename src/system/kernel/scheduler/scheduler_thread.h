@@ -7,6 +7,7 @@
 
 
 #include <thread.h>
+#include <timer.h>
 #include <util/AutoLock.h>
 
 #include "scheduler_common.h"
@@ -78,6 +79,22 @@ public:
 	inline	void		Enqueue(bool& wasRunQueueEmpty);
 	inline	bool		Dequeue();
 
+	inline	void		StartsRunning(int32 cpu);
+
+	inline	bool		HasDeadline() const	{ return fDeadlinePeriod != 0; }
+	inline	CoreEntry*	DeadlineCore() const	{ return fDeadlineCore; }
+	inline	void		SetDeadlineCore(CoreEntry* core)
+							{ fDeadlineCore = core; }
+	inline	int32		DeadlineLoad() const	{ return fDeadlineLoad; }
+			void		SetDeadline(bigtime_t runtime, bigtime_t deadline,
+							bigtime_t period, CoreEntry* core, int32 load);
+			bool		ReplenishBudget();
+			void		CancelReplenishTimer();
+
+	static	bool		HasEarlierDeadline(ThreadData* a, ThreadData* b)
+							{ return a->fAbsoluteDeadline
+								< b->fAbsoluteDeadline; }
+
 	inline	void		UpdateActivity(bigtime_t active);
 
 	inline	bool		IsEnqueued() const	{ return fEnqueued; }
@@ -94,6 +111,11 @@ private:
 	inline	void		_IncreasePenalty();
 	inline	int32		_GetPenalty() const;
 
+	inline	void		_BecomesReady(bool wokenUp);
+
+	inline	void		_StartDeadlinePeriod(bigtime_t now);
+	inline	void		_ChargeBudget(bigtime_t timeUsed);
+
 			void		_ComputeNeededLoad();
 
 			void		_ComputeEffectivePriority() const;
@@ -112,6 +134,24 @@ private:
 			bool		fEnqueued;
 			bool		fReady;
 
+			bigtime_t	fReadyTime;
+			bool		fWokenUp;
+
+			bigtime_t	fDeadlineRuntime;
+			bigtime_t	fRelativeDeadline;
+			bigtime_t	fDeadlinePeriod;
+			int32		fDeadlineLoad;
+			CoreEntry*	fDeadlineCore;
+
+			bigtime_t	fPeriodStart;
+			bigtime_t	fAbsoluteDeadline;
+			bigtime_t	fRemainingBudget;
+			bool		fThrottled;
+
+			timer		fReplenishTimer;
+			bool		fReplenishTimerPending;
+			bool		fReplenishTimerUsed;
+
 			Thread*		fThread;
 
 			int32		fPriorityPenalty;
@@ -140,6 +180,9 @@ public:
 };
 
 
+int32 replenish_deadline_budget(timer* event);
+
+
 inline int32
 ThreadData::_GetMinimalPriority() const
 {
@@ -284,6 +327,9 @@ ThreadData::GetQuantumLeft()
 {
 	SCHEDULER_ENTER_FUNCTION();
 
+	if (HasDeadline() && !fThrottled)
+		return fRemainingBudget;
+
 	bigtime_t stolenTime = std::min(fStolenTime, gCurrentMode->minimal_quantum);
 	ASSERT(stolenTime >= 0);
 	fStolenTime -= stolenTime;
@@ -309,8 +355,18 @@ ThreadData::HasQuantumEnded(bool wasPreempted, bool hasYielded)
 {
 	SCHEDULER_ENTER_FUNCTION();
 
-	bigtime_t timeUsed = system_time() - fQuantumStart;
+	bigtime_t now = system_time();
+	bigtime_t timeUsed = now - fQuantumStart;
 	ASSERT(timeUsed >= 0);
+
+	if (HasDeadline() && !fThrottled) {
+		// the thread keeps running while it has budget left, and is then
+		// ordered by its deadline anyway
+		fQuantumStart = now;
+		_ChargeBudget(timeUsed);
+		return fThrottled;
+	}
+
 	fTimeUsed += timeUsed;
 
 	bigtime_t timeLeft = ComputeQuantum() - fTimeUsed;
@@ -386,6 +442,7 @@ ThreadData::PutBack()
 	SCHEDULER_ENTER_FUNCTION();
 
 	int32 priority = GetEffectivePriority();
+	_BecomesReady(false);
 
 	if (fThread->pinned_to_cpu > 0) {
 		ASSERT(fThread->cpu != NULL);
@@ -411,6 +468,19 @@ ThreadData::Enqueue(bool& wasRunQueueEmpty)
 {
 	SCHEDULER_ENTER_FUNCTION();
 
+	_BecomesReady(!fReady);
+
+	if (!fReady && HasDeadline() && !fThrottled) {
+		// Start a new period, if the thread could otherwise use more than its
+		// bandwidth until its current deadline.
+		bigtime_t now = system_time();
+		if (now >= fAbsoluteDeadline
+			|| fRemainingBudget * fRelativeDeadline
+				> (fAbsoluteDeadline - now) * fDeadlineRuntime) {
+			_StartDeadlinePeriod(now);
+		}
+	}
+
 	if (!fReady) {
 		if (gTrackCoreLoad) {
 			bigtime_t timeSlept = system_time() - fWentSleep;
@@ -454,6 +524,80 @@ ThreadData::Enqueue(bool& wasRunQueueEmpty)
 }
 
 
+/*!	Reports the time the thread spent in the run queue to the scheduler
+	statistics, if they are enabled.
+	Must be called before the thread's \c previous_cpu is updated.
+*/
+inline void
+ThreadData::StartsRunning(int32 cpu)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	if (fReadyTime == 0)
+		return;
+
+	if (gSchedulerStatsEnabled && !IsIdle())
+		record_thread_scheduled(fThread, cpu, fReadyTime, fWokenUp);
+	fReadyTime = 0;
+}
+
+
+inline void
+ThreadData::_BecomesReady(bool wokenUp)
+{
+	// A thread that is moved to another run queue keeps its original time.
+	if (__builtin_expect(!gSchedulerStatsEnabled, true) || fReadyTime != 0)
+		return;
+
+	fReadyTime = system_time();
+	fWokenUp = wokenUp;
+}
+
+
+inline void
+ThreadData::_StartDeadlinePeriod(bigtime_t now)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	fPeriodStart = now;
+	fAbsoluteDeadline = now + fRelativeDeadline;
+	fRemainingBudget = fDeadlineRuntime;
+
+	if (fThrottled) {
+		fThrottled = false;
+		_ComputeEffectivePriority();
+	}
+}
+
+
+/*!	Once the budget is used up, the thread only runs at the lowest priority
+	until it is replenished at the start of the next period.
+*/
+inline void
+ThreadData::_ChargeBudget(bigtime_t timeUsed)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	fRemainingBudget -= timeUsed;
+	if (fRemainingBudget > 0)
+		return;
+
+	fThrottled = true;
+	_ComputeEffectivePriority();
+
+	// A timer might still be pending, if the parameters have been changed
+	// in the meantime. It will replenish the budget a bit too early or late.
+	if (fReplenishTimerPending)
+		return;
+
+	fReplenishTimer.user_data = this;
+	fReplenishTimerPending = true;
+	fReplenishTimerUsed = true;
+	add_timer(&fReplenishTimer, &replenish_deadline_budget,
+		fPeriodStart + fDeadlinePeriod, B_ONE_SHOT_ABSOLUTE_TIMER);
+}
+
+
 inline bool
 ThreadData::Dequeue()
 {
@@ -11,6 +11,7 @@
 
 #include <algorithm>
 
+#include <arch/cpu.h>
 #include <int.h>
 #include <slab/Slab.h>
 #include <smp.h>
@@ -39,12 +40,28 @@ public:
 };
 
 
-struct depot_cpu_store {
+// The store of a CPU is only ever used with interrupts disabled by the CPU it
+// belongs to, so its lock is not contended, and doesn't share a cache line
+// with any other CPU. Other CPUs only lock it to empty the depot.
+struct CACHE_LINE_ALIGN depot_cpu_store {
+	spinlock		lock;
 	DepotMagazine*	loaded;
 	DepotMagazine*	previous;
+
+	uint64			alloc_hits;
+	uint64			alloc_misses;
+	uint64			free_hits;
+	uint64			free_misses;
 };
 
 
+// number of times the depot lock must have been found contended before the
+// magazines of a depot grow
+static const size_t kMagazineResizeContention = 16;
+// limit for growing magazines, relative to their initial capacity
+static const size_t kMaxMagazineCapacityFactor = 4;
+
+
 RANGE_MARKER_FUNCTION_BEGIN(SlabObjectDepot)
 
 
@@ -131,12 +148,33 @@ empty_magazine(object_depot* depot, DepotMagazine* magazine, uint32 flags)
 }
 
 
+/*!	Locks the depot, and makes the magazines of a hot depot larger, so that
+	its CPUs need to come back to the depot less often.
+*/
+static void
+lock_depot(object_depot* depot)
+{
+	if (try_acquire_spinlock(&depot->inner_lock))
+		return;
+
+	acquire_spinlock(&depot->inner_lock);
+
+	if (++depot->contention_count >= kMagazineResizeContention) {
+		// only new magazines get the new capacity
+		depot->contention_count = 0;
+		depot->magazine_capacity = std::min(depot->magazine_capacity * 2,
+			depot->max_magazine_capacity);
+	}
+}
+
+
 static bool
 exchange_with_full(object_depot* depot, DepotMagazine*& magazine)
 {
 	ASSERT(magazine->IsEmpty());
 
-	SpinLocker _(depot->inner_lock);
+	lock_depot(depot);
+	SpinLocker _(depot->inner_lock, true);
 
 	if (depot->full == NULL)
 		return false;
@@ -156,7 +194,8 @@ exchange_with_empty(object_depot* depot, DepotMagazine*& magazine,
 {
 	ASSERT(magazine == NULL || magazine->IsFull());
 
-	SpinLocker _(depot->inner_lock);
+	lock_depot(depot);
+	SpinLocker _(depot->inner_lock, true);
 
 	if (depot->empty == NULL)
 		return false;
@@ -187,10 +226,23 @@ push_empty_magazine(object_depot* depot, DepotMagazine* magazine)
 }
 
 
+/*!	Disables interrupts, and locks the store of the current CPU.
+*/
 static inline depot_cpu_store*
-object_depot_cpu(object_depot* depot)
+lock_depot_cpu_store(object_depot* depot, cpu_status& state)
+{
+	state = disable_interrupts();
+	depot_cpu_store* store = &depot->stores[smp_get_current_cpu()];
+	acquire_spinlock(&store->lock);
+	return store;
+}
+
+
+static inline void
+unlock_depot_cpu_store(depot_cpu_store* store, cpu_status state)
 {
-	return &depot->stores[smp_get_current_cpu()];
+	release_spinlock(&store->lock);
+	restore_interrupts(state);
 }
 
 
@@ -207,21 +259,30 @@ object_depot_init(object_depot* depot, size_t capacity, size_t maxCount,
 	depot->full_count = depot->empty_count = 0;
 	depot->max_count = maxCount;
 	depot->magazine_capacity = capacity;
+	depot->min_magazine_capacity = capacity;
+	depot->max_magazine_capacity = capacity * kMaxMagazineCapacityFactor;
+	depot->contention_count = 0;
 
-	rw_lock_init(&depot->outer_lock, "object depot");
 	B_INITIALIZE_SPINLOCK(&depot->inner_lock);
 
 	int cpuCount = smp_get_num_cpus();
-	depot->stores = (depot_cpu_store*)slab_internal_alloc(
-		sizeof(depot_cpu_store) * cpuCount, flags);
-	if (depot->stores == NULL) {
-		rw_lock_destroy(&depot->outer_lock);
-		return B_NO_MEMORY;
+	size_t storesSize = sizeof(depot_cpu_store) * cpuCount;
+	if ((flags & CACHE_DURING_BOOT) != 0)
+		depot->stores = (depot_cpu_store*)slab_internal_alloc(storesSize, flags);
+	else {
+		depot->stores = (depot_cpu_store*)memalign_etc(CACHE_LINE_SIZE,
+			storesSize, flags);
 	}
+	if (depot->stores == NULL)
+		return B_NO_MEMORY;
 
 	for (int i = 0; i < cpuCount; i++) {
-		depot->stores[i].loaded = NULL;
-		depot->stores[i].previous = NULL;
+		depot_cpu_store& store = depot->stores[i];
+		B_INITIALIZE_SPINLOCK(&store.lock);
+		store.loaded = NULL;
+		store.previous = NULL;
+		store.alloc_hits = store.alloc_misses = 0;
+		store.free_hits = store.free_misses = 0;
 	}
 
 	depot->cookie = cookie;
@@ -237,18 +298,14 @@ object_depot_destroy(object_depot* depot, uint32 flags)
 	object_depot_make_empty(depot, flags);
 
 	slab_internal_free(depot->stores, flags);
-
-	rw_lock_destroy(&depot->outer_lock);
 }
 
 
 void*
 object_depot_obtain(object_depot* depot)
 {
-	ReadLocker readLocker(depot->outer_lock);
-	InterruptsLocker interruptsLocker;
-
-	depot_cpu_store* store = object_depot_cpu(depot);
+	cpu_status state;
+	depot_cpu_store* store = lock_depot_cpu_store(depot, state);
 
 	// To better understand both the Alloc() and Free() logic refer to
 	// Bonwick's ``Magazines and Vmem'' [in 2001 USENIX proceedings]
@@ -257,30 +314,37 @@ object_depot_obtain(object_depot* depot)
 	// if it's not empty, or from the previous magazine if it's full
 	// and finally from the Slab if the magazine depot has no full magazines.
 
-	if (store->loaded == NULL)
-		return NULL;
+	void* object = NULL;
 
-	while (true) {
-		if (!store->loaded->IsEmpty())
-			return store->loaded->Pop();
+	while (store->loaded != NULL) {
+		if (!store->loaded->IsEmpty()) {
+			object = store->loaded->Pop();
+			break;
+		}
 
 		if (store->previous
 			&& (store->previous->IsFull()
 				|| exchange_with_full(depot, store->previous))) {
 			std::swap(store->previous, store->loaded);
 		} else
-			return NULL;
+			break;
 	}
+
+	if (object != NULL)
+		store->alloc_hits++;
+	else
+		store->alloc_misses++;
+
+	unlock_depot_cpu_store(store, state);
+	return object;
 }
 
 
 void
 object_depot_store(object_depot* depot, void* object, uint32 flags)
 {
-	ReadLocker readLocker(depot->outer_lock);
-	InterruptsLocker interruptsLocker;
-
-	depot_cpu_store* store = object_depot_cpu(depot);
+	cpu_status state;
+	depot_cpu_store* store = lock_depot_cpu_store(depot, state);
 
 	// We try to add the object to the loaded magazine if we have one
 	// and it's not full, or to the previous one if it is empty. If
@@ -288,8 +352,11 @@ object_depot_store(object_depot* depot, void* object, uint32 flags)
 	// we return the object directly to the slab.
 
 	while (true) {
-		if (store->loaded != NULL && store->loaded->Push(object))
+		if (store->loaded != NULL && store->loaded->Push(object)) {
+			store->free_hits++;
+			unlock_depot_cpu_store(store, state);
 			return;
+		}
 
 		DepotMagazine* freeMagazine = NULL;
 		if ((store->previous != NULL && store->previous->IsEmpty())
@@ -298,20 +365,16 @@ object_depot_store(object_depot* depot, void* object, uint32 flags)
 
 			if (freeMagazine != NULL) {
 				// Free the magazine that didn't have space in the list
-				interruptsLocker.Unlock();
-				readLocker.Unlock();
+				unlock_depot_cpu_store(store, state);
 
 				empty_magazine(depot, freeMagazine, flags);
 
-				readLocker.Lock();
-				interruptsLocker.Lock();
-
-				store = object_depot_cpu(depot);
+				store = lock_depot_cpu_store(depot, state);
 			}
 		} else {
 			// allocate a new empty magazine
-			interruptsLocker.Unlock();
-			readLocker.Unlock();
+			store->free_misses++;
+			unlock_depot_cpu_store(store, state);
 
 			DepotMagazine* magazine = alloc_magazine(depot, flags);
 			if (magazine == NULL) {
@@ -319,11 +382,9 @@ object_depot_store(object_depot* depot, void* object, uint32 flags)
 				return;
 			}
 
-			readLocker.Lock();
-			interruptsLocker.Lock();
+			store = lock_depot_cpu_store(depot, state);
 
 			push_empty_magazine(depot, magazine);
-			store = object_depot_cpu(depot);
 		}
 	}
 }
@@ -332,8 +393,6 @@ object_depot_store(object_depot* depot, void* object, uint32 flags)
 void
 object_depot_make_empty(object_depot* depot, uint32 flags)
 {
-	WriteLocker writeLocker(depot->outer_lock);
-
 	// collect the store magazines
 
 	DepotMagazine* storeMagazines = NULL;
@@ -341,6 +400,7 @@ object_depot_make_empty(object_depot* depot, uint32 flags)
 	int cpuCount = smp_get_num_cpus();
 	for (int i = 0; i < cpuCount; i++) {
 		depot_cpu_store& store = depot->stores[i];
+		InterruptsSpinLocker storeLocker(store.lock);
 
 		if (store.loaded) {
 			_push(storeMagazines, store.loaded);
@@ -355,13 +415,21 @@ object_depot_make_empty(object_depot* depot, uint32 flags)
 
 	// detach the depot's full and empty magazines
 
+	InterruptsSpinLocker locker(depot->inner_lock);
+
 	DepotMagazine* fullMagazines = depot->full;
 	depot->full = NULL;
+	depot->full_count = 0;
 
 	DepotMagazine* emptyMagazines = depot->empty;
 	depot->empty = NULL;
+	depot->empty_count = 0;
 
-	writeLocker.Unlock();
+	// we are asked to give back memory -- start over with small magazines
+	depot->magazine_capacity = depot->min_magazine_capacity;
+	depot->contention_count = 0;
+
+	locker.Unlock();
 
 	// free all magazines
 
@@ -381,11 +449,10 @@ object_depot_make_empty(object_depot* depot, uint32 flags)
 bool
 object_depot_contains_object(object_depot* depot, void* object)
 {
-	WriteLocker writeLocker(depot->outer_lock);
-
 	int cpuCount = smp_get_num_cpus();
 	for (int i = 0; i < cpuCount; i++) {
 		depot_cpu_store& store = depot->stores[i];
+		InterruptsSpinLocker storeLocker(store.lock);
 
 		if (store.loaded != NULL && !store.loaded->IsEmpty()) {
 			if (store.loaded->ContainsObject(object))
@@ -398,6 +465,8 @@ object_depot_contains_object(object_depot* depot, void* object)
 		}
 	}
 
+	InterruptsSpinLocker locker(depot->inner_lock);
+
 	for (DepotMagazine* magazine = depot->full; magazine != NULL;
 			magazine = magazine->next) {
 		if (magazine->ContainsObject(object))
@@ -410,6 +479,26 @@ object_depot_contains_object(object_depot* depot, void* object)
 #endif // PARANOID_KERNEL_FREE
 
 
+/*!	Sums up the hit counts of the stores of all CPUs. The stores are not
+	locked, so the result is only a snapshot.
+*/
+void
+object_depot_get_stats(object_depot* depot, object_depot_stats* stats)
+{
+	stats->alloc_hits = stats->alloc_misses = 0;
+	stats->free_hits = stats->free_misses = 0;
+
+	int cpuCount = smp_get_num_cpus();
+	for (int i = 0; i < cpuCount; i++) {
+		depot_cpu_store& store = depot->stores[i];
+		stats->alloc_hits += store.alloc_hits;
+		stats->alloc_misses += store.alloc_misses;
+		stats->free_hits += store.free_hits;
+		stats->free_misses += store.free_misses;
+	}
+}
+
+
 // #pragma mark - private kernel API
 
 
@@ -419,14 +508,20 @@ dump_object_depot(object_depot* depot)
 	kprintf("  full:     %p, count %lu\n", depot->full, depot->full_count);
 	kprintf("  empty:    %p, count %lu\n", depot->empty, depot->empty_count);
 	kprintf("  max full: %lu\n", depot->max_count);
-	kprintf("  capacity: %lu\n", depot->magazine_capacity);
+	kprintf("  capacity: %lu (%lu - %lu)\n", depot->magazine_capacity,
+		depot->min_magazine_capacity, depot->max_magazine_capacity);
 	kprintf("  stores:\n");
 
 	int cpuCount = smp_get_num_cpus();
 
 	for (int i = 0; i < cpuCount; i++) {
-		kprintf("  [%d] loaded:   %p\n", i, depot->stores[i].loaded);
-		kprintf("      previous: %p\n", depot->stores[i].previous);
+		depot_cpu_store& store = depot->stores[i];
+		kprintf("  [%d] loaded:   %p\n", i, store.loaded);
+		kprintf("      previous: %p\n", store.previous);
+		kprintf("      alloc:    %" B_PRIu64 " hits, %" B_PRIu64 " misses\n",
+			store.alloc_hits, store.alloc_misses);
+		kprintf("      free:     %" B_PRIu64 " hits, %" B_PRIu64 " misses\n",
+			store.free_hits, store.free_misses);
 	}
 }
 
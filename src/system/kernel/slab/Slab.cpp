@@ -277,6 +277,35 @@ dump_slabs(int argc, char* argv[])
 }
 
 
+static int
+dump_slab_stats(int argc, char* argv[])
+{
+	kprintf("%*s %22s %8s %12s %5s %12s %5s\n",
+		B_PRINTF_POINTER_WIDTH + 2, "address", "name", "capacity", "allocs",
+		"hit%", "frees", "hit%");
+
+	ObjectCacheList::Iterator it = sObjectCaches.GetIterator();
+
+	while (it.HasNext()) {
+		ObjectCache* cache = it.Next();
+		if ((cache->flags & CACHE_NO_DEPOT) != 0)
+			continue;
+
+		object_depot_stats stats;
+		object_depot_get_stats(&cache->depot, &stats);
+
+		uint64 allocs = stats.alloc_hits + stats.alloc_misses;
+		uint64 frees = stats.free_hits + stats.free_misses;
+		kprintf("%p %22s %8lu %12" B_PRIu64 " %5" B_PRIu64 " %12" B_PRIu64 " %5"
+			B_PRIu64 "\n", cache, cache->name, cache->depot.magazine_capacity,
+			allocs, allocs != 0 ? stats.alloc_hits * 100 / allocs : 0, frees,
+			frees != 0 ? stats.free_hits * 100 / frees : 0);
+	}
+
+	return 0;
+}
+
+
 static int
 dump_cache_info(int argc, char* argv[])
 {
@@ -1380,6 +1409,8 @@ slab_init_post_area()
 	MemoryManager::InitPostArea();
 
 	add_debugger_command("slabs", dump_slabs, "list all object caches");
+	add_debugger_command("slab_stats", dump_slab_stats,
+		"list the per-CPU depot hit rates of all object caches");
 	add_debugger_command("slab_cache", dump_cache_info,
 		"dump information about a specific object cache");
 	add_debugger_command("slab_depot", dump_object_depot,
@@ -172,10 +172,13 @@ Thread::Thread(const char* name, thread_id threadID, struct cpu_ent* cpu)
 	team_next(NULL),
 	priority(-1),
 	io_priority(-1),
+	inherited_priority_count(0),
+	base_priority(-1),
 	cpu(cpu),
 	previous_cpu(NULL),
 	cpumask(),
 	pinned_to_cpu(0),
+	numa_node(-1),
 	sig_block_mask(0),
 	sigsuspend_original_unblocked_mask(0),
 	user_signal_context(NULL),
@@ -934,6 +937,11 @@ thread_create_thread(const ThreadCreationAttributes& attributes, bool kernel)
 			(int32)THREAD_MAX_SET_PRIORITY);
 	thread->state = B_THREAD_SUSPENDED;
 
+	// new threads are likely to work on the memory of their creator
+	Thread* currentThread = thread_get_current_thread();
+	if (currentThread != NULL)
+		thread->numa_node = currentThread->numa_node;
+
 	thread->sig_block_mask = attributes.signal_mask;
 
 	// init debug structure
@@ -1800,6 +1808,7 @@ _dump_thread_info(Thread *thread, bool shortInfo)
 	else
 		kprintf("\n");
 	kprintf("cpumask:            %#" B_PRIx32 "\n", thread->cpumask.Bits(0));
+	kprintf("numa_node:          %" B_PRId32 "\n", thread->numa_node);
 	kprintf("sig_pending:        %#" B_PRIx64 " (blocked: %#" B_PRIx64
 		", before sigsuspend(): %#" B_PRIx64 ")\n",
 		(int64)thread->ThreadPendingSignals(),
@@ -2732,6 +2741,28 @@ thread_set_io_priority(int32 priority)
 }
 
 
+/*!	Restricts the current thread to the CPUs in \a mask, and moves it over to
+	one of them if necessary.
+*/
+void
+thread_set_cpu_affinity(const CPUSet& mask)
+{
+	Thread* thread = thread_get_current_thread();
+	ThreadLocker threadLocker(thread);
+
+	if (scheduler_set_thread_affinity(thread, mask) != B_OK) {
+		// a deadline thread that no core in the mask can take keeps its
+		// affinity
+		return;
+	}
+
+	threadLocker.Unlock();
+
+	if (!mask.GetBit(thread->cpu->cpu_num))
+		thread_yield();
+}
+
+
 status_t
 thread_init(kernel_args *args)
 {
@@ -3067,7 +3098,7 @@ user_unblock_thread(thread_id threadID, status_t status)
 }
 
 
-static bool
+bool
 thread_check_permissions(const Thread* currentThread, const Thread* thread,
 	bool kernel)
 {
@@ -3356,6 +3387,16 @@ thread_set_thread_priority(thread_id id, int32 priority, bool kernel)
 			thread_get_current_thread(), thread, kernel))
 		return B_NOT_ALLOWED;
 
+	if (thread->inherited_priority_count > 0) {
+		// The thread runs with an inherited priority; the new priority only
+		// takes effect when that is dropped, unless it is higher.
+		int32 oldPriority = thread->base_priority;
+		thread->base_priority = priority;
+		if (priority > thread->priority)
+			scheduler_set_thread_priority(thread, priority);
+		return oldPriority;
+	}
+
 	return scheduler_set_thread_priority(thread, priority);
 }
 
@@ -3984,7 +4025,10 @@ _user_set_thread_affinity(thread_id id, const void* userMask, size_t size)
 		return B_BAD_THREAD_ID;
 	BReference<Thread> threadReference(thread, true);
 	ThreadLocker threadLocker(thread, true);
-	memcpy(&thread->cpumask, &mask, sizeof(mask));
+
+	status_t status = scheduler_set_thread_affinity(thread, mask);
+	if (status != B_OK)
+		return status;
 
 	// check if running on masked cpu
 	if (!thread->cpumask.GetBit(thread->cpu->cpu_num))
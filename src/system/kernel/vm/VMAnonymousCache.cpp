@@ -1020,6 +1020,51 @@ VMAnonymousCache::Fault(struct VMAddressSpace* aspace, off_t offset)
 }
 
 
+status_t
+VMAnonymousCache::PrepareLargePage(struct VMAddressSpace* aspace, off_t offset,
+	off_t size)
+{
+	// the guard pages need to fault individually
+	if (fGuardedSize > 0)
+		return B_NOT_SUPPORTED;
+
+	// swapped out pages have to be read back individually
+	if (fAllocatedSwapSize > 0) {
+		for (off_t pageOffset = offset; pageOffset < offset + size;
+				pageOffset += B_PAGE_SIZE) {
+			if (HasPage(pageOffset))
+				return B_BUSY;
+		}
+	}
+
+	if (!fCanOvercommit)
+		return B_OK;
+
+	// commit the memory for all new pages at once, keeping the precommitted
+	// pages intact
+	off_t commitment = ((off_t)page_count + fPrecommittedPages) * B_PAGE_SIZE
+		+ size;
+	if (commitment <= committed_size)
+		return B_OK;
+
+	off_t needed = commitment - committed_size;
+	off_t swapReserved = swap_space_reserve(needed);
+	if (swapReserved < needed) {
+		int priority = aspace == VMAddressSpace::Kernel()
+			? VM_PRIORITY_SYSTEM : VM_PRIORITY_USER;
+		if (vm_try_reserve_memory(needed - swapReserved, priority, 0)
+				!= B_OK) {
+			swap_space_unreserve(swapReserved);
+			return B_NO_MEMORY;
+		}
+	}
+
+	fCommittedSwapSize += swapReserved;
+	committed_size += needed;
+	return B_OK;
+}
+
+
 void
 VMAnonymousCache::Merge(VMCache* _source)
 {
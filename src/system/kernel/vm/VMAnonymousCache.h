@@ -74,6 +74,9 @@ public:
 
 	virtual	status_t			Fault(struct VMAddressSpace* aspace,
 									off_t offset);
+	virtual	status_t			PrepareLargePage(
+									struct VMAddressSpace* aspace,
+									off_t offset, off_t size);
 
 	virtual	void				Merge(VMCache* source);
 
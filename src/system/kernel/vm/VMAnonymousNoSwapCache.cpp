@@ -182,6 +182,36 @@ VMAnonymousNoSwapCache::Fault(struct VMAddressSpace* aspace, off_t offset)
 }
 
 
+status_t
+VMAnonymousNoSwapCache::PrepareLargePage(struct VMAddressSpace* aspace,
+	off_t offset, off_t size)
+{
+	// the guard pages need to fault individually
+	if (fGuardedSize > 0)
+		return B_NOT_SUPPORTED;
+
+	if (!fCanOvercommit)
+		return B_OK;
+
+	// commit the memory for all new pages at once, keeping the precommitted
+	// pages intact
+	off_t commitment = ((off_t)page_count + fPrecommittedPages) * B_PAGE_SIZE
+		+ size;
+	if (commitment <= committed_size)
+		return B_OK;
+
+	int priority = aspace == VMAddressSpace::Kernel()
+		? VM_PRIORITY_SYSTEM : VM_PRIORITY_USER;
+	if (vm_try_reserve_memory(commitment - committed_size, priority, 0)
+			!= B_OK) {
+		return B_NO_MEMORY;
+	}
+
+	committed_size = commitment;
+	return B_OK;
+}
+
+
 void
 VMAnonymousNoSwapCache::Merge(VMCache* _source)
 {
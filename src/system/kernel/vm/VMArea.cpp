@@ -32,6 +32,7 @@ VMArea::VMArea(VMAddressSpace* addressSpace, uint32 wiring, uint32 protection)
 	cache(NULL),
 	cache_offset(0),
 	cache_type(0),
+	fault_around_pages(0),
 	page_protections(NULL),
 	address_space(addressSpace)
 {
@@ -1098,6 +1098,44 @@ VMCache::SetMinimalCommitment(off_t commitment, int priority)
 }
 
 
+/*!	If \a page is mapped in an address range wired by lock_memory(), prepares
+	\a waiter for waiting until that range is unwired again, and returns
+	\c true.
+	If one of the areas the page is mapped in could not be checked, because
+	its cache is locked by someone else, \a _retry is set to \c true.
+	The page's \a cache must be locked.
+*/
+static bool
+add_waiter_if_page_locked(VMCache* cache, vm_page* page,
+	VMAreaUnwiredWaiter& waiter, bool& _retry)
+{
+	_retry = false;
+
+	vm_page_mappings::Iterator iterator = page->mappings.GetIterator();
+	while (vm_page_mapping* mapping = iterator.Next()) {
+		VMArea* area = mapping->area;
+		VMCache* areaCache = area->cache;
+
+		// the wired ranges are protected by the area's cache lock
+		if (areaCache != cache && !areaCache->TryLock()) {
+			_retry = true;
+			continue;
+		}
+
+		addr_t address = area->Base()
+			+ ((page->cache_offset << PAGE_SHIFT) - area->cache_offset);
+		bool wired = area->AddWaiterIfWired(&waiter, address, B_PAGE_SIZE);
+
+		if (areaCache != cache)
+			areaCache->Unlock();
+		if (wired)
+			return true;
+	}
+
+	return false;
+}
+
+
 bool
 VMCache::_FreePageRange(VMCachePagesTree::Iterator it,
 	page_num_t* toPage = NULL, page_num_t* freedPages = NULL)
@@ -1122,17 +1160,51 @@ VMCache::_FreePageRange(VMCachePagesTree::Iterator it,
 			return true;
 		}
 
+		if (page->WiredCount() > 0) {
+			// A page wired by lock_memory() must stay mapped, or it could
+			// never be unwired again. That wiring only lasts as long as an
+			// I/O operation, so we wait for it, like resize_area() does.
+			VMAreaUnwiredWaiter waiter;
+			bool retry;
+			if (add_waiter_if_page_locked(this, page, waiter, retry)) {
+				Unlock();
+				waiter.waitEntry.Wait();
+				Lock();
+				return true;
+			}
+			if (retry) {
+				Unlock();
+				snooze(1000);
+				Lock();
+				return true;
+			}
+		}
+
 		// remove the page and put it into the free queue
 		DEBUG_PAGE_ACCESS_START(page);
 		vm_remove_all_page_mappings(page);
-		ASSERT(page->WiredCount() == 0);
-			// TODO: Find a real solution! If the page is wired
-			// temporarily (e.g. by lock_memory()), we actually must not
-			// unmap it!
+
+		bool wired = page->WiredCount() > 0;
+		if (wired) {
+			// The page is still wired temporarily by
+			// file_cache_wire_pages() while the network stack sends it. We
+			// must not wait for that, as a stalled peer could block us
+			// forever, so we just orphan the page: it is no longer part of
+			// the cache, and is freed by whoever unwires it last.
+			vm_page_set_state(page, PAGE_STATE_WIRED);
+		}
+
 		RemovePage(page);
 			// Note: When iterating through a IteratableSplayTree
 			// removing the current node is safe.
 
+		if (wired) {
+			DEBUG_PAGE_ACCESS_END(page);
+			if (freedPages != NULL)
+				(*freedPages)++;
+			continue;
+		}
+
 		vm_page_free(this, page);
 		if (freedPages != NULL)
 			(*freedPages)++;
@@ -1382,6 +1454,25 @@ VMCache::Fault(struct VMAddressSpace *aspace, off_t offset)
 }
 
 
+/*!	Prepares the cache for getting a physically contiguous run of pages
+	inserted at once, so that they can be mapped as a large page.
+	The cache must be locked, and must not contain any pages in the given
+	range. The implementation commits the memory needed for the pages.
+
+	@param aspace The address space the pages will be mapped in.
+	@param offset The cache offset of the first page.
+	@param size The size of the range.
+	@return \c B_OK, if the pages can be inserted, another error code
+		otherwise. The default implementation returns \c B_NOT_SUPPORTED.
+*/
+status_t
+VMCache::PrepareLargePage(struct VMAddressSpace* aspace, off_t offset,
+	off_t size)
+{
+	return B_NOT_SUPPORTED;
+}
+
+
 void
 VMCache::Merge(VMCache* source)
 {
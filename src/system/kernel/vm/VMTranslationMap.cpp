@@ -39,6 +39,36 @@ VMTranslationMap::DebugMarkRangePresent(addr_t start, addr_t end,
 }
 
 
+/*!	Returns the size of the large pages the translation map can map via
+	MapLargePage(), or \c 0, if it doesn't support large pages.
+	The default implementation returns \c 0.
+*/
+size_t
+VMTranslationMap::LargePageSize() const
+{
+	return 0;
+}
+
+
+/*!	Maps a physically contiguous run of pages the size of a large page at once.
+	Both \a virtualAddress and \a physicalAddress must be aligned to
+	LargePageSize(). The caller must have reserved the pages needed to map the
+	range in \a reservation.
+
+	The large page remains to be treated as individual pages by the rest of
+	the VM, i.e. all operations on single pages work as before; the
+	implementation splits the large page into small ones where needed.
+	The default implementation returns \c B_NOT_SUPPORTED.
+*/
+status_t
+VMTranslationMap::MapLargePage(addr_t virtualAddress,
+	phys_addr_t physicalAddress, uint32 attributes, uint32 memoryType,
+	vm_page_reservation* reservation)
+{
+	return B_NOT_SUPPORTED;
+}
+
+
 /*!	Unmaps a range of pages of an area.
 
 	The default implementation just iterates over all virtual pages of the
@@ -342,6 +372,32 @@ VMTranslationMap::UnaccessedPageUnmapped(VMArea* area, page_num_t pageNumber)
 }
 
 
+/*!	Called when the accessed or modified flags of a large page mapping have
+	been cleared on behalf of the page \a exceptPage only.
+	Since the flags are shared by all pages of the large page, they are
+	transferred to the other pages, so that they don't get lost.
+	The cache of the pages must be locked.
+*/
+void
+VMTranslationMap::LargePageFlagsCleared(page_num_t firstPage,
+	page_num_t pageCount, page_num_t exceptPage, bool accessed, bool modified)
+{
+	for (page_num_t i = 0; i < pageCount; i++) {
+		if (firstPage + i == exceptPage)
+			continue;
+
+		vm_page* page = vm_lookup_page(firstPage + i);
+		if (page == NULL)
+			continue;
+
+		if (accessed)
+			page->accessed = true;
+		if (modified)
+			page->modified = true;
+	}
+}
+
+
 // #pragma mark - ReverseMappingInfoCallback
 
 
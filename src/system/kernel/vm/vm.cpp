@@ -254,8 +254,18 @@ static off_t sAvailableMemory;
 static off_t sNeededMemory;
 
 static uint32 sPageFaults;
+static uint32 sFaultAroundFaults;
+static uint32 sFaultAroundPages;
 static VMPhysicalPageMapper* sPhysicalPageMapper;
 
+// bounds of the per-area window of pages mapped around a fault
+static const uint16 kFaultAroundMinPages = 2;
+static const uint16 kFaultAroundMaxPages = 16;
+
+// time to wait before trying to allocate a large page again after a failure
+static const bigtime_t kLargePageRetryDelay = 100000;
+static bigtime_t sLastLargePageFailure;
+
 
 // function declarations
 static void delete_area(VMAddressSpace* addressSpace, VMArea* area,
@@ -1053,6 +1063,8 @@ cut_area(VMAddressSpace* addressSpace, VMArea* area, addr_t address,
 		secondArea->cache->Commit(secondCommit, priority);
 	}
 
+	secondArea->fault_around_pages = atomic_get(&area->fault_around_pages);
+
 	if (_secondArea != NULL)
 		*_secondArea = secondArea;
 
@@ -1645,6 +1657,7 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 	}
 
 	physical_address_restrictions stackPhysicalRestrictions;
+	virtual_address_restrictions largePageRestrictions;
 	bool doReserveMemory = false;
 	addr_t reservedMemory = 0;
 	switch (wiring) {
@@ -1787,6 +1800,20 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 		&& wait_if_address_range_is_wired(addressSpace,
 			(addr_t)virtualAddressRestrictions->address, size, &locker));
 
+	// Align areas that shall be mapped with large pages accordingly, so that
+	// as much of them as possible can be.
+	if ((protection & B_LARGE_PAGES_AREA) != 0 && wiring == B_NO_LOCK
+		&& virtualAddressRestrictions->address_specification
+			!= B_EXACT_ADDRESS) {
+		size_t largePageSize = addressSpace->TranslationMap()->LargePageSize();
+		if (largePageSize != 0 && size >= largePageSize
+			&& virtualAddressRestrictions->alignment < largePageSize) {
+			largePageRestrictions = *virtualAddressRestrictions;
+			largePageRestrictions.alignment = largePageSize;
+			virtualAddressRestrictions = &largePageRestrictions;
+		}
+	}
+
 	// create an anonymous cache
 	// if it's a stack, make sure that two pages are available at least
 	status = VMCacheFactory::CreateAnonymousCache(cache, canOvercommit,
@@ -1822,7 +1849,11 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 
 		case B_FULL_LOCK:
 		{
-			// Allocate and map all pages for this area
+			// Allocate and map all pages for this area, allocating the pages
+			// in batches
+			vm_page* pages[32];
+			uint32 pageCount = 0;
+			uint32 pageIndex = 0;
 
 			off_t offset = 0;
 			for (addr_t address = area->Base();
@@ -1838,14 +1869,25 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 #	endif
 					continue;
 #endif
-				vm_page* page = vm_page_allocate_page(&reservation,
-					PAGE_STATE_WIRED | pageAllocFlags);
+				if (pageIndex == pageCount) {
+					pageCount = std::min((size_t)B_COUNT_OF(pages),
+						(area->Base() + area->Size() - address) / B_PAGE_SIZE);
+					pageIndex = 0;
+					vm_page_allocate_pages(&reservation,
+						PAGE_STATE_WIRED | pageAllocFlags, pages, pageCount);
+				}
+
+				vm_page* page = pages[pageIndex++];
 				cache->InsertPage(page, offset);
 				map_page(area, page, address, protection, &reservation);
 
 				DEBUG_PAGE_ACCESS_END(page);
 			}
 
+			// free the pages we didn't need (for guard pages)
+			while (pageIndex < pageCount)
+				vm_page_free_etc(NULL, pages[pageIndex++], &reservation);
+
 			break;
 		}
 
@@ -2238,11 +2280,13 @@ vm_create_vnode_cache(struct vnode* vnode, struct VMCache** cache)
 
 
 /*!	\a cache must be locked. The area's address space must be read-locked.
+	Returns the number of pages that have been mapped.
 */
-static void
+static int32
 pre_map_area_pages(VMArea* area, VMCache* cache,
 	vm_page_reservation* reservation, int32 maxCount)
 {
+	int32 mapped = 0;
 	addr_t baseAddress = area->Base();
 	addr_t cacheOffset = area->cache_offset;
 	page_num_t firstPage = cacheOffset / B_PAGE_SIZE;
@@ -2263,8 +2307,11 @@ pre_map_area_pages(VMArea* area, VMCache* cache,
 			baseAddress + (page->cache_offset * B_PAGE_SIZE - cacheOffset),
 			B_READ_AREA | B_KERNEL_READ_AREA, reservation);
 		maxCount--;
+		mapped++;
 		DEBUG_PAGE_ACCESS_END(page);
 	}
+
+	return mapped;
 }
 
 
@@ -2419,8 +2466,13 @@ _vm_map_file(team_id team, const char* name, void** _address,
 
 	if (status == B_OK && (protection & B_READ_AREA) != 0) {
 		// Pre-map at most 10MB worth of pages.
-		pre_map_area_pages(area, cache, &reservation,
+		int32 mapped = pre_map_area_pages(area, cache, &reservation,
 			(10LL * 1024 * 1024) / B_PAGE_SIZE);
+
+		// If the file is in the cache already, its pages will likely be
+		// needed as well, so we map more of them at once when faulting.
+		area->fault_around_pages
+			= mapped > 0 ? kFaultAroundMaxPages : kFaultAroundMinPages;
 	}
 
 	cache->Unlock();
@@ -2652,6 +2704,7 @@ vm_clone_area(team_id team, const char* name, void** address,
 	}
 
 	newArea->cache_type = sourceArea->cache_type;
+	newArea->fault_around_pages = atomic_get(&sourceArea->fault_around_pages);
 	return newArea->id;
 }
 
@@ -3030,6 +3083,8 @@ vm_copy_area(team_id team, const char* name, void** _address,
 		return status;
 	}
 
+	target->fault_around_pages = atomic_get(&source->fault_around_pages);
+
 	if (targetPageProtections != NULL) {
 		target->page_protections = targetPageProtections;
 
@@ -4239,12 +4294,18 @@ struct PageFaultContext {
 	bool					restart;
 	bool					pageAllocated;
 
+	// large page run allocated while unlocked, kept across restarts
+	vm_page*				largePageRun;
+	bool					largePageFailed;
+
 
 	PageFaultContext(VMAddressSpace* addressSpace, bool isWrite)
 		:
 		addressSpaceLocker(addressSpace, true),
 		map(addressSpace->TranslationMap()),
-		isWrite(isWrite)
+		isWrite(isWrite),
+		largePageRun(NULL),
+		largePageFailed(false)
 	{
 	}
 
@@ -4252,6 +4313,12 @@ struct PageFaultContext {
 	{
 		UnlockAll();
 		vm_page_unreserve_pages(&reservation);
+
+		if (largePageRun != NULL) {
+			page_num_t count = map->LargePageSize() / B_PAGE_SIZE;
+			for (page_num_t i = 0; i < count; i++)
+				vm_page_free(NULL, &largePageRun[i]);
+		}
 	}
 
 	void Prepare(VMCache* topCache, off_t cacheOffset)
@@ -4415,6 +4482,302 @@ fault_get_page(PageFaultContext& context)
 }
 
 
+static void
+free_page_mappings(VMAreaMappings& mappings, uint32 flags)
+{
+	while (vm_page_mapping* mapping = mappings.RemoveHead()) {
+		vm_free_page_mapping(mapping->page->physical_page_number, mapping,
+			flags);
+	}
+}
+
+
+/*!	Tries to resolve the fault by mapping a whole large page, which is only
+	possible if nothing has been faulted in in its range yet.
+	Returns \c B_OK with \c context.restart set to \c true, if the function
+	had to unlock the address space and all caches and is supposed to be called
+	again. Returns \c B_OK with \c context.restart set to \c false, if the
+	large page has been mapped. Any other return value means that the fault
+	has to be resolved the usual way; the locking state is unchanged then.
+	The address space and the top cache must be locked.
+*/
+static status_t
+fault_large_page(PageFaultContext& context, VMArea* area, addr_t address,
+	uint32 protection)
+{
+	VMTranslationMap* map = context.map;
+	VMCache* cache = context.topCache;
+
+	size_t largePageSize = map->LargePageSize();
+	if (largePageSize == 0 || context.largePageFailed)
+		return B_NOT_SUPPORTED;
+
+	addr_t base = ROUNDDOWN(address, largePageSize);
+	if (base < area->Base()
+		|| base + (largePageSize - 1) > area->Base() + (area->Size() - 1)
+		|| area->wiring != B_NO_LOCK || area->page_protections != NULL
+		|| area->cache_type != CACHE_TYPE_RAM || area->MemoryType() != 0
+		|| cache->source != NULL) {
+		return B_NOT_SUPPORTED;
+	}
+
+	off_t offset = base - area->Base() + area->cache_offset;
+	page_num_t firstPage = offset >> PAGE_SHIFT;
+	page_num_t pageCount = largePageSize / B_PAGE_SIZE;
+
+	vm_page* page = cache->pages.GetIterator(firstPage, true, true).Next();
+	if (page != NULL && page->cache_offset < firstPage + pageCount)
+		return B_BUSY;
+
+	bool isKernelSpace = area->address_space == VMAddressSpace::Kernel();
+
+	if (context.largePageRun == NULL) {
+		// Don't bother trying again right away, if physical memory is too
+		// fragmented.
+		if (system_time() - sLastLargePageFailure < kLargePageRetryDelay)
+			return B_NO_MEMORY;
+
+		// Looking for a page run is expensive, so do it unlocked.
+		context.UnlockAll();
+
+		physical_address_restrictions restrictions = {};
+		restrictions.alignment = largePageSize;
+		context.largePageRun = vm_page_allocate_page_run(
+			PAGE_STATE_WIRED | VM_PAGE_ALLOC_CLEAR | VM_PAGE_ALLOC_DONT_WAIT,
+			pageCount, &restrictions,
+			isKernelSpace ? VM_PRIORITY_SYSTEM : VM_PRIORITY_USER);
+		if (context.largePageRun == NULL) {
+			context.largePageFailed = true;
+			sLastLargePageFailure = system_time();
+			atomic_add(&gLargePageAllocationFailures, 1);
+		}
+
+		context.restart = true;
+		return B_OK;
+	}
+
+	// Allocate all page mappings beforehand, so that there is nothing to be
+	// undone after the large page has been mapped.
+	uint32 allocationFlags = CACHE_DONT_WAIT_FOR_MEMORY
+		| (isKernelSpace ? CACHE_DONT_LOCK_KERNEL_SPACE : 0);
+	vm_page* run = context.largePageRun;
+	VMAreaMappings mappings;
+	for (page_num_t i = 0; i < pageCount; i++) {
+		vm_page_mapping* mapping = allocate_page_mapping(
+			run[i].physical_page_number, allocationFlags);
+		if (mapping == NULL) {
+			free_page_mappings(mappings, allocationFlags);
+			return B_NO_MEMORY;
+		}
+
+		mapping->page = &run[i];
+		mapping->area = area;
+		mappings.Add(mapping);
+	}
+
+	status_t status = cache->PrepareLargePage(area->address_space, offset,
+		largePageSize);
+	if (status == B_OK) {
+		map->Lock();
+		status = map->MapLargePage(base,
+			run[0].physical_page_number * B_PAGE_SIZE, protection,
+			area->MemoryType(), &context.reservation);
+		if (status != B_OK)
+			map->Unlock();
+	}
+	if (status != B_OK) {
+		free_page_mappings(mappings, allocationFlags);
+		return status;
+	}
+
+	for (page_num_t i = 0; i < pageCount; i++) {
+		vm_page_mapping* mapping = mappings.RemoveHead();
+		cache->InsertPage(mapping->page, offset + i * B_PAGE_SIZE);
+		mapping->page->mappings.Add(mapping);
+		area->mappings.Add(mapping);
+	}
+
+	map->Unlock();
+
+	for (page_num_t i = 0; i < pageCount; i++) {
+		vm_page_set_state(&run[i], PAGE_STATE_ACTIVE);
+		DEBUG_PAGE_ACCESS_END(&run[i]);
+	}
+
+	atomic_add(&gMappedPagesCount, pageCount);
+	context.largePageRun = NULL;
+	return B_OK;
+}
+
+
+/*!	Maps the given resident pages of \a area read-only in one translation map
+	transaction, skipping those that are mapped already.
+	Returns the number of pages that have been mapped.
+*/
+static int32
+map_fault_around_pages(PageFaultContext& context, VMArea* area,
+	vm_page** pages, int32 count, addr_t start, addr_t end)
+{
+	bool isKernelSpace = area->address_space == VMAddressSpace::Kernel();
+	uint32 allocationFlags = CACHE_DONT_WAIT_FOR_MEMORY
+		| (isKernelSpace ? CACHE_DONT_LOCK_KERNEL_SPACE : 0);
+
+	vm_page_mapping* mappings[kFaultAroundMaxPages];
+	for (int32 i = 0; i < count; i++) {
+		mappings[i] = allocate_page_mapping(pages[i]->physical_page_number,
+			allocationFlags);
+		if (mappings[i] == NULL) {
+			count = i;
+			break;
+		}
+	}
+
+	// Mapping the pages might need new page tables, if the window crosses
+	// the page table of the faulting page.
+	VMTranslationMap* map = context.map;
+	vm_page_reservation reservation;
+	bool reserved = vm_page_try_reserve_pages(&reservation,
+		map->MaxPagesNeededToMap(start, end),
+		isKernelSpace ? VM_PRIORITY_SYSTEM : VM_PRIORITY_USER);
+
+	bool pageMapped[kFaultAroundMaxPages];
+	bool wasMapped[kFaultAroundMaxPages];
+	int32 mapped = 0;
+
+	map->Lock();
+
+	for (int32 i = 0; i < count; i++) {
+		pageMapped[i] = false;
+		if (!reserved)
+			continue;
+
+		vm_page* page = pages[i];
+		addr_t pageAddress = area->Base()
+			+ (((off_t)page->cache_offset << PAGE_SHIFT) - area->cache_offset);
+
+		uint32 protection = get_area_page_protection(area, pageAddress)
+			& ~(B_WRITE_AREA | B_KERNEL_WRITE_AREA);
+		if ((protection & (B_READ_AREA | B_KERNEL_READ_AREA)) == 0)
+			continue;
+
+		phys_addr_t physicalAddress;
+		uint32 flags;
+		if (map->Query(pageAddress, &physicalAddress, &flags) == B_OK
+			&& (flags & PAGE_PRESENT) != 0) {
+			continue;
+		}
+
+		DEBUG_PAGE_ACCESS_START(page);
+
+		map->Map(pageAddress, page->physical_page_number * B_PAGE_SIZE,
+			protection, area->MemoryType(), &reservation);
+
+		wasMapped[i] = page->IsMapped();
+		if (!wasMapped[i])
+			atomic_add(&gMappedPagesCount, 1);
+
+		mappings[i]->page = page;
+		mappings[i]->area = area;
+		page->mappings.Add(mappings[i]);
+		area->mappings.Add(mappings[i]);
+		pageMapped[i] = true;
+		mapped++;
+	}
+
+	map->Unlock();
+
+	if (reserved)
+		vm_page_unreserve_pages(&reservation);
+
+	for (int32 i = 0; i < count; i++) {
+		vm_page* page = pages[i];
+		if (!pageMapped[i]) {
+			vm_free_page_mapping(page->physical_page_number, mappings[i],
+				allocationFlags);
+			continue;
+		}
+
+		// see map_page()
+		if (!wasMapped[i] && (page->State() == PAGE_STATE_CACHED
+				|| page->State() == PAGE_STATE_INACTIVE)) {
+			vm_page_set_state(page, PAGE_STATE_ACTIVE);
+		}
+		DEBUG_PAGE_ACCESS_END(page);
+	}
+
+	return mapped;
+}
+
+
+/*!	Maps the resident pages around the page that has just been mapped for a
+	read fault at \a address read-only, all in one go, so that accessing them
+	doesn't cause faults of their own.
+	The window of pages is adjusted per area: it grows as long as there are
+	pages to map, and shrinks otherwise.
+	The address space and the caches from the top cache down to the cache of
+	\c context.page must be locked.
+*/
+static void
+fault_around(PageFaultContext& context, VMArea* area, addr_t address)
+{
+	VMCache* cache = context.page->Cache();
+	int32 windowPages = atomic_get(&area->fault_around_pages);
+	size_t windowSize = (size_t)windowPages * B_PAGE_SIZE;
+
+	// center the window on the faulting page, within the area
+	size_t areaOffset = address - area->Base();
+	size_t startOffset = areaOffset > windowSize / 2
+		? areaOffset - windowSize / 2 : 0;
+	size_t endOffset = std::min(startOffset + windowSize, area->Size());
+
+	page_num_t endPage = (area->cache_offset + endOffset) >> PAGE_SHIFT;
+	vm_page* pages[kFaultAroundMaxPages];
+	int32 count = 0;
+
+	for (VMCachePagesTree::Iterator it = cache->pages.GetIterator(
+				(area->cache_offset + startOffset) >> PAGE_SHIFT, true, true);
+			vm_page* page = it.Next();) {
+		if (page->cache_offset >= endPage)
+			break;
+		if (page == context.page || page->busy)
+			continue;
+
+		// the page must not be shadowed by a page in one of the upper caches
+		off_t cacheOffset = (off_t)page->cache_offset << PAGE_SHIFT;
+		bool shadowed = false;
+		for (VMCache* upperCache = context.topCache; upperCache != cache;
+				upperCache = upperCache->source) {
+			if (upperCache->LookupPage(cacheOffset) != NULL
+				|| upperCache->HasPage(cacheOffset)) {
+				shadowed = true;
+				break;
+			}
+		}
+		if (!shadowed)
+			pages[count++] = page;
+	}
+
+	int32 mapped = 0;
+	if (count > 0) {
+		mapped = map_fault_around_pages(context, area, pages, count,
+			area->Base() + startOffset, area->Base() + endOffset - 1);
+	}
+
+	if (mapped > 0) {
+		atomic_add((int32*)&sFaultAroundFaults, 1);
+		atomic_add((int32*)&sFaultAroundPages, mapped);
+	}
+
+	// If another fault has changed the window in the mean time, we leave it
+	// alone.
+	int32 newWindowPages = mapped > 0
+		? std::min(windowPages * 2, (int32)kFaultAroundMaxPages)
+		: std::max(windowPages / 2, (int32)kFaultAroundMinPages);
+	atomic_test_and_set(&area->fault_around_pages, newWindowPages,
+		windowPages);
+}
+
+
 /*!	Makes sure the address in the given address space is mapped.
 
 	\param addressSpace The address space.
@@ -4535,6 +4898,16 @@ vm_soft_fault(VMAddressSpace* addressSpace, addr_t originalAddress,
 				break;
 		}
 
+		// Areas that asked for it are mapped with large pages, if possible.
+		if ((area->protection & B_LARGE_PAGES_AREA) != 0 && wirePage == NULL) {
+			status = fault_large_page(context, area, address, protection);
+			if (status == B_OK) {
+				if (context.restart)
+					continue;
+				break;
+			}
+		}
+
 		// The top most cache has no fault handler, so let's see if the cache or
 		// its sources already have the page we're searching for (we're going
 		// from top to bottom).
@@ -4658,6 +5031,13 @@ vm_soft_fault(VMAddressSpace* addressSpace, addr_t originalAddress,
 		} else if (context.page->State() == PAGE_STATE_INACTIVE)
 			vm_page_set_state(context.page, PAGE_STATE_ACTIVE);
 
+		// map the resident neighbours of the page, too, if they are likely to
+		// be accessed soon
+		if (mapPage && !isWrite && wirePage == NULL
+			&& atomic_get(&area->fault_around_pages) > 0) {
+			fault_around(context, area, address);
+		}
+
 		// also wire the page, if requested
 		if (wirePage != NULL && status == B_OK) {
 			increment_page_wired_count(context.page);
@@ -5622,7 +6002,7 @@ unlock_memory_etc(team_id team, void* address, size_t numBytes, uint32 flags)
 					"space %p, address: %#" B_PRIxADDR, addressSpace,
 					nextAddress);
 				error = B_BAD_VALUE;
-				break;
+					// keep going, so that the other pages don't stay wired
 			}
 		}
 
@@ -5639,9 +6019,6 @@ unlock_memory_etc(team_id team, void* address, size_t numBytes, uint32 flags)
 			range->~VMAreaWiredRange();
 			free_etc(range, mallocFlags);
 		}
-
-		if (error != B_OK)
-			break;
 	}
 
 	// get rid of the address space reference lock_memory_etc() acquired
@@ -6606,6 +6983,21 @@ _user_memory_advice(void* _address, size_t size, uint32 advice)
 }
 
 
+status_t
+_user_get_vm_fault_stats(struct vm_fault_stats* userStats, size_t size)
+{
+	if (userStats == NULL || !IS_USER_ADDRESS(userStats))
+		return B_BAD_ADDRESS;
+
+	vm_fault_stats stats;
+	stats.page_faults = sPageFaults;
+	stats.fault_around_faults = sFaultAroundFaults;
+	stats.fault_around_pages = sFaultAroundPages;
+
+	return user_memcpy(userStats, &stats, std::min(size, sizeof(stats)));
+}
+
+
 status_t
 _user_get_memory_properties(team_id teamID, const void* address,
 	uint32* _protected, uint32* _lock)
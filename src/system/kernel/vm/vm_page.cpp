@@ -101,16 +101,26 @@ static const int32 kPageUsageAdvance = 3;
 static const int32 kPageUsageDecline = 1;
 
 int32 gMappedPagesCount;
+int32 gMappedLargePagesCount;
+int32 gLargePageSplitCount;
+int32 gLargePageAllocationFailures;
 
 static VMPageQueue sPageQueues[PAGE_STATE_FIRST_UNQUEUED];
 
-static VMPageQueue& sFreePageQueue = sPageQueues[PAGE_STATE_FREE];
-static VMPageQueue& sClearPageQueue = sPageQueues[PAGE_STATE_CLEAR];
 static VMPageQueue& sModifiedPageQueue = sPageQueues[PAGE_STATE_MODIFIED];
 static VMPageQueue& sInactivePageQueue = sPageQueues[PAGE_STATE_INACTIVE];
 static VMPageQueue& sActivePageQueue = sPageQueues[PAGE_STATE_ACTIVE];
 static VMPageQueue& sCachedPageQueue = sPageQueues[PAGE_STATE_CACHED];
 
+// The free and clear pages are kept in one queue per NUMA node; the
+// PAGE_STATE_FREE and PAGE_STATE_CLEAR entries of sPageQueues are unused.
+static VMPageQueue sFreePageQueues[MAX_NUMA_NODES];
+static VMPageQueue sClearPageQueues[MAX_NUMA_NODES];
+static int32 sNUMANodeCount = 1;
+static uint8* sPageNUMANodes;
+	// NUMA node of each page in sPages, only used with more than one node
+static page_num_t sNUMANodePages[MAX_NUMA_NODES];
+
 static vm_page *sPages;
 static page_num_t sPhysicalPageOffset;
 static page_num_t sNumPages;
@@ -257,6 +267,79 @@ static DaemonCondition sPageWriterCondition;
 static DaemonCondition sPageDaemonCondition;
 
 
+// Per-CPU cache of free and clear pages. Allocating and freeing single pages
+// usually only needs to lock the cache of the current CPU; the global free and
+// clear queues are only touched to refill or drain a cache in batches.
+// The pages in a cache keep their free or clear state, but are marked busy,
+// so that the page run allocator leaves them alone. A cache only holds pages
+// of the NUMA node of its CPU.
+struct CACHE_LINE_ALIGN PageCPUCache {
+	void Init(int32 node)
+	{
+		B_INITIALIZE_SPINLOCK(&lock);
+		this->node = node;
+		new(&freePages) VMPageQueue::PageList;
+		new(&clearPages) VMPageQueue::PageList;
+		freeCount = 0;
+		clearCount = 0;
+	}
+
+	uint32 Add(vm_page* page)
+	{
+		if (page->State() == PAGE_STATE_CLEAR) {
+			clearPages.Add(page, false);
+			return ++clearCount;
+		}
+
+		freePages.Add(page, false);
+		return ++freeCount;
+	}
+
+	vm_page* RemoveHead(bool clear)
+	{
+		vm_page* page = clear ? clearPages.RemoveHead() : freePages.RemoveHead();
+		if (page == NULL) {
+			page = clear ? freePages.RemoveHead() : clearPages.RemoveHead();
+			clear = !clear;
+		}
+		if (page != NULL) {
+			if (clear)
+				clearCount--;
+			else
+				freeCount--;
+		}
+
+		return page;
+	}
+
+	void RemoveTail(bool clear, VMPageQueue::PageList& pages, uint32 count)
+	{
+		VMPageQueue::PageList& list = clear ? clearPages : freePages;
+		uint32& listCount = clear ? clearCount : freeCount;
+
+		for (; count > 0 && listCount > 0; count--, listCount--)
+			pages.Add(list.RemoveTail(), false);
+	}
+
+	spinlock				lock;
+	VMPageQueue::PageList	freePages;
+	VMPageQueue::PageList	clearPages;
+	uint32					freeCount;
+	uint32					clearCount;
+	int32					node;
+};
+
+// number of pages a per-CPU cache is refilled or drained by at once
+static const uint32 kPageCPUCacheBatchSize = 32;
+// number of free (and clear) pages a per-CPU cache may hold
+static const uint32 kPageCPUCacheMaxPages = 2 * kPageCPUCacheBatchSize;
+
+static PageCPUCache sPageCPUCaches[SMP_MAX_CPUS];
+static bool sPageCPUCachesEnabled;
+
+static page_num_t count_page_cpu_cache_pages();
+
+
 #if PAGE_ALLOCATION_TRACING
 
 namespace PageAllocationTracing {
@@ -829,8 +912,6 @@ find_page(int argc, char **argv)
 		const char*	name;
 		VMPageQueue*	queue;
 	} pageQueueInfos[] = {
-		{ "free",		&sFreePageQueue },
-		{ "clear",		&sClearPageQueue },
 		{ "modified",	&sModifiedPageQueue },
 		{ "active",		&sActivePageQueue },
 		{ "inactive",	&sInactivePageQueue },
@@ -860,6 +941,19 @@ find_page(int argc, char **argv)
 		}
 	}
 
+	for (i = 0; i < 2 * sNUMANodeCount; i++) {
+		VMPageQueue* queue = i % 2 == 0
+			? &sFreePageQueues[i / 2] : &sClearPageQueues[i / 2];
+		VMPageQueue::Iterator it = queue->GetIterator();
+		while (vm_page* p = it.Next()) {
+			if (p == page) {
+				kprintf("found page %p in queue %p (%s, node %d)\n", page,
+					queue, i % 2 == 0 ? "free" : "clear", i / 2);
+				return 0;
+			}
+		}
+	}
+
 	kprintf("page %p isn't in any queue\n", page);
 
 	return 0;
@@ -1058,6 +1152,8 @@ static int
 dump_page_queue(int argc, char **argv)
 {
 	struct VMPageQueue *queue;
+	int32 queueCount = 1;
+		// the free and clear queues exist once per NUMA node
 
 	if (argc < 2) {
 		kprintf("usage: page_queue <address/name> [list]\n");
@@ -1066,11 +1162,13 @@ dump_page_queue(int argc, char **argv)
 
 	if (strlen(argv[1]) >= 2 && argv[1][0] == '0' && argv[1][1] == 'x')
 		queue = (VMPageQueue*)strtoul(argv[1], NULL, 16);
-	else if (!strcmp(argv[1], "free"))
-		queue = &sFreePageQueue;
-	else if (!strcmp(argv[1], "clear"))
-		queue = &sClearPageQueue;
-	else if (!strcmp(argv[1], "modified"))
+	else if (!strcmp(argv[1], "free")) {
+		queue = sFreePageQueues;
+		queueCount = sNUMANodeCount;
+	} else if (!strcmp(argv[1], "clear")) {
+		queue = sClearPageQueues;
+		queueCount = sNUMANodeCount;
+	} else if (!strcmp(argv[1], "modified"))
 		queue = &sModifiedPageQueue;
 	else if (!strcmp(argv[1], "active"))
 		queue = &sActivePageQueue;
@@ -1083,19 +1181,23 @@ dump_page_queue(int argc, char **argv)
 		return 0;
 	}
 
-	kprintf("queue = %p, queue->head = %p, queue->tail = %p, queue->count = %"
-		B_PRIuPHYSADDR "\n", queue, queue->Head(), queue->Tail(),
-		queue->Count());
-
-	if (argc == 3) {
-		struct vm_page *page = queue->Head();
-
-		kprintf("page        cache       type       state  wired  usage\n");
-		for (page_num_t i = 0; page; i++, page = queue->Next(page)) {
-			kprintf("%p  %p  %-7s %8s  %5d  %5d\n", page, page->Cache(),
-				vm_cache_type_to_string(page->Cache()->type),
-				page_state_to_string(page->State()),
-				page->WiredCount(), page->usage_count);
+	for (int32 node = 0; node < queueCount; node++, queue++) {
+		if (queueCount > 1)
+			kprintf("node %" B_PRId32 ": ", node);
+		kprintf("queue = %p, queue->head = %p, queue->tail = %p, "
+			"queue->count = %" B_PRIuPHYSADDR "\n", queue, queue->Head(),
+			queue->Tail(), queue->Count());
+
+		if (argc == 3) {
+			struct vm_page *page = queue->Head();
+
+			kprintf("page        cache       type       state  wired  usage\n");
+			for (page_num_t i = 0; page; i++, page = queue->Next(page)) {
+				kprintf("%p  %p  %-7s %8s  %5d  %5d\n", page, page->Cache(),
+					vm_cache_type_to_string(page->Cache()->type),
+					page_state_to_string(page->State()),
+					page->WiredCount(), page->usage_count);
+			}
 		}
 	}
 	return 0;
@@ -1186,6 +1288,9 @@ dump_page_stats(int argc, char **argv)
 	kprintf("unsatisfied page reservations: %" B_PRId32 "\n",
 		sUnsatisfiedPageReservations);
 	kprintf("mapped pages: %" B_PRId32 "\n", gMappedPagesCount);
+	kprintf("mapped large pages: %" B_PRId32 " (splits: %" B_PRId32
+		", allocation failures: %" B_PRId32 ")\n", gMappedLargePagesCount,
+		gLargePageSplitCount, gLargePageAllocationFailures);
 	kprintf("longest free pages run: %" B_PRIuPHYSADDR " pages (at %"
 		B_PRIuPHYSADDR ")\n", longestFreeRun.Length(),
 		sPages[longestFreeRun.start].physical_page_number);
@@ -1202,10 +1307,16 @@ dump_page_stats(int argc, char **argv)
 			waiter->requested, waiter->reserved, waiter->dontTouch);
 	}
 
-	kprintf("\nfree queue: %p, count = %" B_PRIuPHYSADDR "\n", &sFreePageQueue,
-		sFreePageQueue.Count());
-	kprintf("clear queue: %p, count = %" B_PRIuPHYSADDR "\n", &sClearPageQueue,
-		sClearPageQueue.Count());
+	kprintf("\n");
+	for (int32 i = 0; i < sNUMANodeCount; i++) {
+		kprintf("node %" B_PRId32 ":\n", i);
+		kprintf("  free queue: %p, count = %" B_PRIuPHYSADDR "\n",
+			&sFreePageQueues[i], sFreePageQueues[i].Count());
+		kprintf("  clear queue: %p, count = %" B_PRIuPHYSADDR "\n",
+			&sClearPageQueues[i], sClearPageQueues[i].Count());
+	}
+	kprintf("per-CPU caches: count = %" B_PRIuPHYSADDR "\n",
+		count_page_cpu_cache_pages());
 	kprintf("modified queue: %p, count = %" B_PRIuPHYSADDR " (%" B_PRId32
 		" temporary, %" B_PRIuPHYSADDR " swappable, " "inactive: %"
 		B_PRIuPHYSADDR ")\n", &sModifiedPageQueue, sModifiedPageQueue.Count(),
@@ -1551,6 +1662,280 @@ unreserve_pages(uint32 count)
 }
 
 
+//	#pragma mark - NUMA nodes
+
+
+static inline int32
+page_numa_node(vm_page* page)
+{
+	return sPageNUMANodes != NULL ? sPageNUMANodes[page - sPages] : 0;
+}
+
+
+/*!	Returns the free or clear queue of the NUMA node  page belongs to.
+*/
+static inline VMPageQueue&
+free_page_queue(vm_page* page, bool clear)
+{
+	int32 node = page_numa_node(page);
+	return clear ? sClearPageQueues[node] : sFreePageQueues[node];
+}
+
+
+/*!	Returns the number of pages in the free or clear queues of all nodes.
+*/
+static page_num_t
+count_free_queue_pages(bool clear)
+{
+	page_num_t count = 0;
+	for (int32 i = 0; i < sNUMANodeCount; i++)
+		count += clear ? sClearPageQueues[i].Count() : sFreePageQueues[i].Count();
+
+	return count;
+}
+
+
+/*!	Returns the NUMA node the current thread should get its pages from.
+	That is the node the thread has been given explicitly, or else the node
+	of the current CPU. A userland thread without a node is bound to the node
+	it first allocates memory on, so that the scheduler keeps it close to its
+	memory.
+*/
+static int32
+preferred_numa_node()
+{
+	if (sNUMANodeCount == 1)
+		return 0;
+
+	Thread* thread = thread_get_current_thread();
+	if (thread != NULL && thread->numa_node >= 0
+		&& thread->numa_node < sNUMANodeCount) {
+		return thread->numa_node;
+	}
+
+	int32 node = gCPU[smp_get_current_cpu()].numa_node;
+	if (thread != NULL && thread->team != NULL
+		&& thread->team->id != B_SYSTEM_TEAM) {
+		thread->numa_node = node;
+	}
+
+	return node;
+}
+
+
+//	#pragma mark - per-CPU page caches
+
+
+/*!	Returns the number of free and clear pages in the per-CPU caches. The
+	caches are not locked, so the value is only a snapshot.
+*/
+static page_num_t
+count_page_cpu_cache_pages()
+{
+	page_num_t count = 0;
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++)
+		count += sPageCPUCaches[i].freeCount + sPageCPUCaches[i].clearCount;
+
+	return count;
+}
+
+
+static inline PageCPUCache*
+lock_page_cpu_cache(cpu_status& state)
+{
+	state = disable_interrupts();
+	PageCPUCache* cache = &sPageCPUCaches[smp_get_current_cpu()];
+	acquire_spinlock(&cache->lock);
+	return cache;
+}
+
+
+static inline void
+unlock_page_cpu_cache(PageCPUCache* cache, cpu_status state)
+{
+	release_spinlock(&cache->lock);
+	restore_interrupts(state);
+}
+
+
+/*!	Moves pages that have been taken out of a per-CPU cache to the given
+	global queue.
+	The free/clear page queues must be locked.
+*/
+static void
+return_cpu_cache_pages(VMPageQueue& queue, VMPageQueue::PageList& pages)
+{
+	InterruptsSpinLocker locker(queue.GetLock());
+
+	while (vm_page* page = pages.RemoveTail()) {
+		page->busy = false;
+		queue.Prepend(page);
+	}
+}
+
+
+/*!	Moves the pages of all per-CPU caches back to the global free and clear
+	queues. Pages that are freed concurrently may end up in a per-CPU cache
+	again, though.
+	The free/clear page queues must be write-locked.
+*/
+static void
+drain_page_cpu_caches()
+{
+	if (!sPageCPUCachesEnabled)
+		return;
+
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		PageCPUCache& cache = sPageCPUCaches[i];
+		VMPageQueue::PageList freePages;
+		VMPageQueue::PageList clearPages;
+
+		InterruptsSpinLocker locker(cache.lock);
+		cache.RemoveTail(false, freePages, cache.freeCount);
+		cache.RemoveTail(true, clearPages, cache.clearCount);
+		locker.Unlock();
+
+		return_cpu_cache_pages(sFreePageQueues[cache.node], freePages);
+		return_cpu_cache_pages(sClearPageQueues[cache.node], clearPages);
+	}
+}
+
+
+/*!	Moves a batch of pages from the free or clear queue of \a node --
+	depending on \a clear, falling back to the other one -- to the cache of
+	the current CPU.
+	Returns \c false, if both queues were empty.
+*/
+static bool
+refill_page_cpu_cache(bool clear, int32 node)
+{
+	VMPageQueue::PageList pages;
+	VMPageQueue* queue = NULL;
+	uint32 count = 0;
+
+	ReadLocker locker(sFreePageQueuesLock);
+
+	for (int32 i = 0; i < 2 && count == 0; i++, clear = !clear) {
+		queue = clear ? &sClearPageQueues[node] : &sFreePageQueues[node];
+		InterruptsSpinLocker queueLocker(queue->GetLock());
+
+		for (; count < kPageCPUCacheBatchSize; count++) {
+			vm_page* page = queue->RemoveHead();
+			if (page == NULL)
+				break;
+
+			page->busy = true;
+			pages.Add(page);
+		}
+	}
+
+	locker.Unlock();
+
+	if (count == 0)
+		return false;
+
+	cpu_status state;
+	PageCPUCache* cache = lock_page_cpu_cache(state);
+
+	if (cache->node == node) {
+		while (vm_page* page = pages.RemoveTail())
+			cache->Add(page);
+	}
+
+	unlock_page_cpu_cache(cache, state);
+
+	if (!pages.IsEmpty()) {
+		// we have been moved to a CPU of another node in the meantime
+		locker.Lock();
+		return_cpu_cache_pages(*queue, pages);
+	}
+
+	return true;
+}
+
+
+/*!	Takes up to \a count free pages out of the cache of the current CPU,
+	refilling it as needed. Clear pages are preferred, if \a clear is \c true.
+	Nothing is taken if the current CPU does not belong to NUMA node \a node.
+	The pages are removed from their queue, but retain their free or clear
+	state, and are still marked busy.
+	Returns the number of pages that could be taken.
+*/
+static uint32
+allocate_pages_from_cpu_cache(bool clear, int32 node, vm_page** pages,
+	uint32 count)
+{
+	if (!sPageCPUCachesEnabled)
+		return 0;
+
+	uint32 allocated = 0;
+	while (true) {
+		cpu_status state;
+		PageCPUCache* cache = lock_page_cpu_cache(state);
+		if (cache->node != node) {
+			unlock_page_cpu_cache(cache, state);
+			return allocated;
+		}
+
+		for (; allocated < count; allocated++) {
+			vm_page* page = cache->RemoveHead(clear);
+			if (page == NULL)
+				break;
+
+			pages[allocated] = page;
+		}
+
+		unlock_page_cpu_cache(cache, state);
+
+		if (allocated == count || !refill_page_cpu_cache(clear, node))
+			return allocated;
+	}
+}
+
+
+/*!	Puts a page that is being freed into the cache of the current CPU, and
+	drains the cache by a batch, if it has grown too large. Pages of another
+	NUMA node go directly to the queue of their node.
+*/
+static void
+free_page_to_cpu_cache(vm_page* page, bool clear)
+{
+	// Mark the page busy before it becomes free, so that it's never seen as
+	// free and not busy outside of the global queues.
+	page->busy = true;
+	page->SetState(clear ? PAGE_STATE_CLEAR : PAGE_STATE_FREE);
+
+	DEBUG_PAGE_ACCESS_END(page);
+
+	VMPageQueue::PageList pages;
+
+	cpu_status state;
+	PageCPUCache* cache = lock_page_cpu_cache(state);
+
+	if (cache->node != page_numa_node(page))
+		pages.Add(page);
+	else if (cache->Add(page) > kPageCPUCacheMaxPages)
+		cache->RemoveTail(clear, pages, kPageCPUCacheBatchSize);
+
+	unlock_page_cpu_cache(cache, state);
+
+	if (pages.IsEmpty())
+		return;
+
+	ReadLocker locker(sFreePageQueuesLock);
+	return_cpu_cache_pages(free_page_queue(page, clear), pages);
+	locker.Unlock();
+
+	if (!clear)
+		sFreePageCondition.NotifyAll();
+}
+
+
+//	#pragma mark -
+
+
 static void
 free_page(vm_page* page, bool clear)
 {
@@ -1601,16 +1986,21 @@ free_page(vm_page* page, bool clear)
 	page->allocation_tracking_info.Clear();
 #endif
 
+	if (sPageCPUCachesEnabled) {
+		free_page_to_cpu_cache(page, clear);
+		return;
+	}
+
 	ReadLocker locker(sFreePageQueuesLock);
 
 	DEBUG_PAGE_ACCESS_END(page);
 
 	if (clear) {
 		page->SetState(PAGE_STATE_CLEAR);
-		sClearPageQueue.PrependUnlocked(page);
+		free_page_queue(page, true).PrependUnlocked(page);
 	} else {
 		page->SetState(PAGE_STATE_FREE);
-		sFreePageQueue.PrependUnlocked(page);
+		free_page_queue(page, false).PrependUnlocked(page);
 		sFreePageCondition.NotifyAll();
 	}
 
@@ -1778,6 +2168,8 @@ mark_page_range_in_use(page_num_t startPage, page_num_t length, bool wired)
 
 	WriteLocker locker(sFreePageQueuesLock);
 
+	drain_page_cpu_caches();
+
 	for (page_num_t i = 0; i < length; i++) {
 		vm_page *page = &sPages[startPage + i];
 		switch (page->State()) {
@@ -1790,9 +2182,8 @@ mark_page_range_in_use(page_num_t startPage, page_num_t length, bool wired)
 				ASSERT(gKernelStartup);
 
 				DEBUG_PAGE_ACCESS_START(page);
-				VMPageQueue& queue = page->State() == PAGE_STATE_FREE
-					? sFreePageQueue : sClearPageQueue;
-				queue.Remove(page);
+				free_page_queue(page, page->State() == PAGE_STATE_CLEAR)
+					.Remove(page);
 				page->SetState(wired ? PAGE_STATE_WIRED : PAGE_STATE_UNUSED);
 				page->busy = false;
 				atomic_add(&sUnreservedFreePages, -1);
@@ -1832,8 +2223,9 @@ page_scrubber(void *unused)
 	TRACE(("page_scrubber starting...\n"));
 
 	ConditionVariableEntry entry;
+	int32 node = 0;
 	for (;;) {
-		while (sFreePageQueue.Count() == 0
+		while (count_free_queue_pages(false) == 0
 				|| atomic_get(&sUnreservedFreePages)
 					< (int32)sFreePagesTarget) {
 			sFreePageCondition.Add(&entry);
@@ -1855,8 +2247,15 @@ page_scrubber(void *unused)
 
 		vm_page *page[SCRUB_SIZE];
 		int32 scrubCount = 0;
+		for (int32 i = 0; i < sNUMANodeCount; i++) {
+			// take turns with the nodes
+			node = (node + 1) % sNUMANodeCount;
+			if (sFreePageQueues[node].Count() != 0)
+				break;
+		}
+
 		for (int32 i = 0; i < reserved; i++) {
-			page[i] = sFreePageQueue.RemoveHeadUnlocked();
+			page[i] = sFreePageQueues[node].RemoveHeadUnlocked();
 			if (page[i] == NULL)
 				break;
 
@@ -1888,7 +2287,7 @@ page_scrubber(void *unused)
 			page[i]->SetState(PAGE_STATE_CLEAR);
 			page[i]->busy = false;
 			DEBUG_PAGE_ACCESS_END(page[i]);
-			sClearPageQueue.PrependUnlocked(page[i]);
+			sClearPageQueues[node].PrependUnlocked(page[i]);
 		}
 
 		locker.Unlock();
@@ -2693,7 +3092,7 @@ free_cached_pages(uint32 pagesToFree, bool dontWait)
 			ReadLocker locker(sFreePageQueuesLock);
 			page->SetState(PAGE_STATE_FREE);
 			DEBUG_PAGE_ACCESS_END(page);
-			sFreePageQueue.PrependUnlocked(page);
+			free_page_queue(page, false).PrependUnlocked(page);
 			locker.Unlock();
 
 			TA(StolenPage());
@@ -3401,11 +3800,22 @@ vm_page_init(kernel_args *args)
 	sInactivePageQueue.Init("inactive pages queue");
 	sActivePageQueue.Init("active pages queue");
 	sCachedPageQueue.Init("cached pages queue");
-	sFreePageQueue.Init("free pages queue");
-	sClearPageQueue.Init("clear pages queue");
+
+	if (args->num_numa_nodes > 1)
+		sNUMANodeCount = std::min(args->num_numa_nodes, (uint32)MAX_NUMA_NODES);
+
+	for (int32 i = 0; i < sNUMANodeCount; i++) {
+		sFreePageQueues[i].Init("free pages queue");
+		sClearPageQueues[i].Init("clear pages queue");
+	}
 
 	new (&sPageReservationWaiters) PageReservationWaiterList;
 
+	for (int32 i = 0; i < SMP_MAX_CPUS; i++) {
+		sPageCPUCaches[i].Init(sNUMANodeCount > 1
+			? std::min((int32)args->cpu_numa_node[i], sNUMANodeCount - 1) : 0);
+	}
+
 	// map in the new free page table
 	sPages = (vm_page *)vm_allocate_early(args, sNumPages * sizeof(vm_page),
 		~0L, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA, 0);
@@ -3414,10 +3824,33 @@ vm_page_init(kernel_args *args)
 		" (size %#" B_PRIxPHYSADDR ")\n", sPages, sNumPages,
 		(phys_addr_t)(sNumPages * sizeof(vm_page))));
 
+	if (sNUMANodeCount > 1) {
+		// remember the node of each page; memory the firmware didn't assign
+		// to a node is accounted to the first one
+		sPageNUMANodes = (uint8*)vm_allocate_early(args, sNumPages,
+			~0L, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA, 0);
+		memset(sPageNUMANodes, 0, sNumPages);
+
+		for (uint32 i = 0; i < args->num_numa_memory_ranges; i++) {
+			const numa_addr_range& range = args->numa_memory_range[i];
+			page_num_t start = std::max((page_num_t)(range.start / B_PAGE_SIZE),
+				sPhysicalPageOffset);
+			page_num_t end = std::min(
+				(page_num_t)((range.start + range.size) / B_PAGE_SIZE),
+				sPhysicalPageOffset + sNumPages);
+			if (range.node >= (uint32)sNUMANodeCount)
+				continue;
+
+			for (page_num_t page = start; page < end; page++)
+				sPageNUMANodes[page - sPhysicalPageOffset] = range.node;
+		}
+	}
+
 	// initialize the free page table
 	for (uint32 i = 0; i < sNumPages; i++) {
 		sPages[i].Init(sPhysicalPageOffset + i);
-		sFreePageQueue.Append(&sPages[i]);
+		free_page_queue(&sPages[i], false).Append(&sPages[i]);
+		sNUMANodePages[page_numa_node(&sPages[i])]++;
 
 #if VM_PAGE_ALLOCATION_TRACKING_AVAILABLE
 		sPages[i].allocation_tracking_info.Clear();
@@ -3572,6 +4005,9 @@ vm_page_init_post_thread(kernel_args *args)
 		B_NORMAL_PRIORITY, NULL);
 	resume_thread(thread);
 
+	// from now on, single pages are allocated and freed via the per-CPU caches
+	sPageCPUCachesEnabled = true;
+
 	return B_OK;
 }
 
@@ -3650,6 +4086,73 @@ vm_page_try_reserve_pages(vm_page_reservation* reservation, uint32 count,
 }
 
 
+/*!	Prepares a page that has just been taken out of the free or clear queues,
+	or out of a per-CPU cache, for the allocation \a flags.
+	Returns the previous state of the page.
+*/
+static inline int
+init_allocated_page(vm_page* page, uint32 flags)
+{
+	if (page->CacheRef() != NULL)
+		panic("supposed to be free page %p has cache @! page %p; cache _cache", page, page);
+
+	DEBUG_PAGE_ACCESS_START(page);
+
+	// The state must be changed before the busy flag, see PageCPUCache.
+	int oldPageState = page->State();
+	page->SetState(flags & VM_PAGE_ALLOC_STATE);
+	page->busy = (flags & VM_PAGE_ALLOC_BUSY) != 0;
+	page->usage_count = 0;
+	page->accessed = false;
+	page->modified = false;
+
+	return oldPageState;
+}
+
+
+static inline void
+finish_allocated_page(vm_page* page, uint32 flags, int oldPageState)
+{
+	// clear the page, if we had to take it from the free queue and a clear
+	// page was requested
+	if ((flags & VM_PAGE_ALLOC_CLEAR) != 0 && oldPageState != PAGE_STATE_CLEAR)
+		clear_page(page);
+
+#if VM_PAGE_ALLOCATION_TRACKING_AVAILABLE
+	page->allocation_tracking_info.Init(
+		TA(AllocatePage(page->physical_page_number)));
+#else
+	TA(AllocatePage(page->physical_page_number));
+#endif
+}
+
+
+/*!	Removes a page from the free or clear queues, depending on \a clear,
+	falling back to the other one. The queues of NUMA node \a node are tried
+	first, those of the other nodes after that.
+	The free/clear page queues must be locked.
+*/
+static vm_page*
+remove_free_queue_page(bool clear, int32 node)
+{
+	for (int32 i = 0; i < sNUMANodeCount; i++) {
+		int32 current = (node + i) % sNUMANodeCount;
+		VMPageQueue& queue = clear
+			? sClearPageQueues[current] : sFreePageQueues[current];
+		VMPageQueue& otherQueue = clear
+			? sFreePageQueues[current] : sClearPageQueues[current];
+
+		vm_page* page = queue.RemoveHeadUnlocked();
+		if (page == NULL)
+			page = otherQueue.RemoveHeadUnlocked();
+		if (page != NULL)
+			return page;
+	}
+
+	return NULL;
+}
+
+
 vm_page *
 vm_page_allocate_page(vm_page_reservation* reservation, uint32 flags)
 {
@@ -3660,35 +4163,30 @@ vm_page_allocate_page(vm_page_reservation* reservation, uint32 flags)
 	ASSERT(reservation->count > 0);
 	reservation->count--;
 
-	VMPageQueue* queue;
-	VMPageQueue* otherQueue;
+	bool clear = (flags & VM_PAGE_ALLOC_CLEAR) != 0;
+	int32 node = preferred_numa_node();
+	vm_page* page;
+	int oldPageState;
 
-	if ((flags & VM_PAGE_ALLOC_CLEAR) != 0) {
-		queue = &sClearPageQueue;
-		otherQueue = &sFreePageQueue;
+	if (allocate_pages_from_cpu_cache(clear, node, &page, 1) == 1) {
+		oldPageState = init_allocated_page(page, flags);
 	} else {
-		queue = &sFreePageQueue;
-		otherQueue = &sClearPageQueue;
-	}
-
-	ReadLocker locker(sFreePageQueuesLock);
-
-	vm_page* page = queue->RemoveHeadUnlocked();
-	if (page == NULL) {
-		// if the primary queue was empty, grab the page from the
-		// secondary queue
-		page = otherQueue->RemoveHeadUnlocked();
+		ReadLocker locker(sFreePageQueuesLock);
 
+		// if the queues of the preferred node are empty, grab the page from
+		// another node
+		page = remove_free_queue_page(clear, node);
 		if (page == NULL) {
 			// Unlikely, but possible: the page we have reserved has moved
-			// between the queues after we checked the first queue. Grab the
-			// write locker to make sure this doesn't happen again.
+			// between the queues after we checked them, or it is sitting in
+			// the cache of another CPU. Grab the write locker to make sure
+			// this doesn't happen again.
 			locker.Unlock();
 			WriteLocker writeLocker(sFreePageQueuesLock);
 
-			page = queue->RemoveHead();
-			if (page == NULL)
-				otherQueue->RemoveHead();
+			drain_page_cpu_caches();
+
+			page = remove_free_queue_page(clear, node);
 
 			if (page == NULL) {
 				panic("Had reserved page, but there is none!");
@@ -3698,38 +4196,57 @@ vm_page_allocate_page(vm_page_reservation* reservation, uint32 flags)
 			// downgrade to read lock
 			locker.Lock();
 		}
+
+		oldPageState = init_allocated_page(page, flags);
+
+		locker.Unlock();
 	}
 
-	if (page->CacheRef() != NULL)
-		panic("supposed to be free page %p has cache @! page %p; cache _cache", page, page);
+	if (pageState < PAGE_STATE_FIRST_UNQUEUED)
+		sPageQueues[pageState].AppendUnlocked(page);
 
-	DEBUG_PAGE_ACCESS_START(page);
+	finish_allocated_page(page, flags, oldPageState);
 
-	int oldPageState = page->State();
-	page->SetState(pageState);
-	page->busy = (flags & VM_PAGE_ALLOC_BUSY) != 0;
-	page->usage_count = 0;
-	page->accessed = false;
-	page->modified = false;
+	return page;
+}
 
-	locker.Unlock();
 
-	if (pageState < PAGE_STATE_FIRST_UNQUEUED)
-		sPageQueues[pageState].AppendUnlocked(page);
+/*!	Allocates \a count pages at once, as if vm_page_allocate_page() had been
+	called for each of them, but more efficiently, as the pages are mostly
+	taken from the page cache of the current CPU in one go.
+	\a reservation must hold at least \a count pages.
+*/
+void
+vm_page_allocate_pages(vm_page_reservation* reservation, uint32 flags,
+	vm_page** pages, uint32 count)
+{
+	uint32 pageState = flags & VM_PAGE_ALLOC_STATE;
+	ASSERT(pageState != PAGE_STATE_FREE);
+	ASSERT(pageState != PAGE_STATE_CLEAR);
 
-	// clear the page, if we had to take it from the free queue and a clear
-	// page was requested
-	if ((flags & VM_PAGE_ALLOC_CLEAR) != 0 && oldPageState != PAGE_STATE_CLEAR)
-		clear_page(page);
+	ASSERT(reservation->count >= count);
 
-#if VM_PAGE_ALLOCATION_TRACKING_AVAILABLE
-	page->allocation_tracking_info.Init(
-		TA(AllocatePage(page->physical_page_number)));
-#else
-	TA(AllocatePage(page->physical_page_number));
-#endif
+	uint32 allocated = allocate_pages_from_cpu_cache(
+		(flags & VM_PAGE_ALLOC_CLEAR) != 0, preferred_numa_node(), pages,
+		count);
+	reservation->count -= allocated;
 
-	return page;
+	VMPageQueue::PageList queuePages;
+	for (uint32 i = 0; i < allocated; i++) {
+		vm_page* page = pages[i];
+		int oldPageState = init_allocated_page(page, flags);
+		if (pageState < PAGE_STATE_FIRST_UNQUEUED)
+			queuePages.Add(page);
+
+		finish_allocated_page(page, flags, oldPageState);
+	}
+
+	if (pageState < PAGE_STATE_FIRST_UNQUEUED && allocated > 0)
+		sPageQueues[pageState].AppendUnlocked(queuePages, allocated);
+
+	// get the remaining pages from the global queues
+	for (uint32 i = allocated; i < count; i++)
+		pages[i] = vm_page_allocate_page(reservation, flags);
 }
 
 
@@ -3743,14 +4260,14 @@ allocate_page_run_cleanup(VMPageQueue::PageList& freePages,
 		page->busy = false;
 		page->SetState(PAGE_STATE_FREE);
 		DEBUG_PAGE_ACCESS_END(page);
-		sFreePageQueue.PrependUnlocked(page);
+		free_page_queue(page, false).PrependUnlocked(page);
 	}
 
 	while (vm_page* page = clearPages.RemoveTail()) {
 		page->busy = false;
 		page->SetState(PAGE_STATE_CLEAR);
 		DEBUG_PAGE_ACCESS_END(page);
-		sClearPageQueue.PrependUnlocked(page);
+		free_page_queue(page, true).PrependUnlocked(page);
 	}
 
 	sFreePageCondition.NotifyAll();
@@ -3796,15 +4313,21 @@ allocate_page_run(page_num_t start, page_num_t length, uint32 flags,
 		bool pageAllocated = true;
 		bool noPage = false;
 		vm_page& page = sPages[start + i];
+		if (page.busy && (page.State() == PAGE_STATE_FREE
+				|| page.State() == PAGE_STATE_CLEAR)) {
+			// the page has just been freed into a per-CPU cache
+			break;
+		}
+
 		switch (page.State()) {
 			case PAGE_STATE_CLEAR:
 				DEBUG_PAGE_ACCESS_START(&page);
-				sClearPageQueue.Remove(&page);
+				free_page_queue(&page, true).Remove(&page);
 				clearPages.Add(&page);
 				break;
 			case PAGE_STATE_FREE:
 				DEBUG_PAGE_ACCESS_START(&page);
-				sFreePageQueue.Remove(&page);
+				free_page_queue(&page, false).Remove(&page);
 				freePages.Add(&page);
 				break;
 			case PAGE_STATE_CACHED:
@@ -3925,8 +4448,9 @@ allocate_page_run(page_num_t start, page_num_t length, uint32 flags,
 
 	\param flags Page allocation flags. Encodes the state the function shall
 		set the allocated pages to, whether the pages shall be marked busy
-		(VM_PAGE_ALLOC_BUSY), and whether the pages shall be cleared
-		(VM_PAGE_ALLOC_CLEAR).
+		(VM_PAGE_ALLOC_BUSY), whether the pages shall be cleared
+		(VM_PAGE_ALLOC_CLEAR), and whether the function may wait for pages to
+		become available (not if VM_PAGE_ALLOC_DONT_WAIT is given).
 	\param length The number of contiguous pages to allocate.
 	\param restrictions Restrictions to the physical addresses of the page run
 		to allocate, including \c low_address, the first acceptable physical
@@ -3979,10 +4503,17 @@ vm_page_allocate_page_run(uint32 flags, page_num_t length,
 	}
 
 	vm_page_reservation reservation;
-	vm_page_reserve_pages(&reservation, length, priority);
+	if ((flags & VM_PAGE_ALLOC_DONT_WAIT) != 0) {
+		if (!vm_page_try_reserve_pages(&reservation, length, priority))
+			return NULL;
+	} else
+		vm_page_reserve_pages(&reservation, length, priority);
 
 	WriteLocker freeClearQueueLocker(sFreePageQueuesLock);
 
+	// The pages in the per-CPU caches are free, but not available for runs.
+	drain_page_cpu_caches();
+
 	// First we try to get a run with free pages only. If that fails, we also
 	// consider cached pages. If there are only few free pages and many cached
 	// ones, the odds are that we won't find enough contiguous ones, so we skip
@@ -4016,11 +4547,14 @@ vm_page_allocate_page_run(uint32 flags, page_num_t length,
 				continue;
 			}
 
-			dprintf("vm_page_allocate_page_run(): Failed to allocate run of "
-				"length %" B_PRIuPHYSADDR " (%" B_PRIuPHYSADDR " %"
-				B_PRIuPHYSADDR ") in second iteration (align: %" B_PRIuPHYSADDR
-				" boundary: %" B_PRIuPHYSADDR ")!\n", length, requestedStart,
-				end, restrictions->alignment, restrictions->boundary);
+			if ((flags & VM_PAGE_ALLOC_DONT_WAIT) == 0) {
+				dprintf("vm_page_allocate_page_run(): Failed to allocate run "
+					"of length %" B_PRIuPHYSADDR " (%" B_PRIuPHYSADDR " %"
+					B_PRIuPHYSADDR ") in second iteration (align: %"
+					B_PRIuPHYSADDR " boundary: %" B_PRIuPHYSADDR ")!\n",
+					length, requestedStart, end, restrictions->alignment,
+					restrictions->boundary);
+			}
 
 			freeClearQueueLocker.Unlock();
 			vm_page_unreserve_pages(&reservation);
@@ -4031,9 +4565,10 @@ vm_page_allocate_page_run(uint32 flags, page_num_t length,
 		page_num_t i;
 		for (i = 0; i < length; i++) {
 			uint32 pageState = sPages[start + i].State();
-			if (pageState != PAGE_STATE_FREE
-				&& pageState != PAGE_STATE_CLEAR
-				&& (pageState != PAGE_STATE_CACHED || !useCached)) {
+			if ((pageState != PAGE_STATE_FREE
+					&& pageState != PAGE_STATE_CLEAR
+					&& (pageState != PAGE_STATE_CACHED || !useCached))
+				|| (pageState != PAGE_STATE_CACHED && sPages[start + i].busy)) {
 				foundRun = false;
 				break;
 			}
@@ -4228,8 +4763,8 @@ vm_page_get_stats(system_info *info)
 	//	active + inactive + unused + wired + modified + cached + free + clear
 	// So taking out the cached (including modified non-temporary), free and
 	// clear ones leaves us with all used pages.
-	uint32 subtractPages = info->cached_pages + sFreePageQueue.Count()
-		+ sClearPageQueue.Count();
+	uint32 subtractPages = info->cached_pages + count_free_queue_pages(false)
+		+ count_free_queue_pages(true) + count_page_cpu_cache_pages();
 	info->used_pages = subtractPages > info->max_pages
 		? 0 : info->max_pages - subtractPages;
 
@@ -4246,6 +4781,41 @@ vm_page_get_stats(system_info *info)
 }
 
 
+status_t
+_user_get_vm_numa_stats(struct vm_numa_node_stats* userStats,
+	uint32* _userCount)
+{
+	uint32 count;
+	if (userStats == NULL || !IS_USER_ADDRESS(userStats)
+		|| _userCount == NULL || !IS_USER_ADDRESS(_userCount)
+		|| user_memcpy(&count, _userCount, sizeof(count)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	vm_numa_node_stats stats[MAX_NUMA_NODES];
+	for (int32 i = 0; i < sNUMANodeCount; i++) {
+		stats[i].total_pages = sNUMANodePages[i];
+		stats[i].free_pages = sFreePageQueues[i].Count()
+			+ sClearPageQueues[i].Count();
+	}
+
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		const PageCPUCache& cache = sPageCPUCaches[i];
+		stats[cache.node].free_pages += cache.freeCount + cache.clearCount;
+	}
+
+	count = std::min(count, (uint32)sNUMANodeCount);
+	if (user_memcpy(userStats, stats, sizeof(vm_numa_node_stats) * count)
+			!= B_OK
+		|| user_memcpy(_userCount, &sNUMANodeCount, sizeof(uint32)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	return B_OK;
+}
+
+
 /*!	Returns the greatest address within the last page of accessible physical
 	memory.
 	The value is inclusive, i.e. in case of a 32 bit phys_addr_t 0xffffffff
@@ -0,0 +1,1090 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	A thread-caching allocator.
+
+	Small allocations (up to kMaxSmallSize) are served from size classes.
+	Every thread owns a cache with a list of free objects per size class;
+	allocating and freeing an object from the cache does not need any lock.
+	When a cache list runs empty, it is refilled with a batch of objects from
+	the thread's arena, and when it grows too long, a batch is returned.
+
+	Arenas own segments: kSegmentSize sized, kSegmentSize aligned mappings
+	that are divided into units of kUnitSize. A span consists of one or more
+	contiguous units, and holds the objects of a single size class. The
+	segment header at the start of every segment describes its spans, so
+	that the span of an object is found by masking its address.
+
+	When all objects of a span are freed, its units are returned to the
+	segment. Once they make up more than a quarter of the arena (and at least
+	kMinDirtyBytes), the pages of half of them are handed back to the system,
+	and segments that ended up completely unused are unmapped.
+
+	Larger allocations get a mapping of their own, which can be resized in
+	place by realloc(). Its header is stored in front of the allocation,
+	again found by masking the address.
+*/
+
+
+#include "heap.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "os.h"
+
+
+namespace BPrivate {
+namespace TCache {
+
+
+static const size_t kSegmentSize = 1024 * 1024;
+static const size_t kUnitSize = 64 * 1024;
+static const uint32_t kUnitsPerSegment = kSegmentSize / kUnitSize;
+static const size_t kSegmentHeaderSize = 4096;
+
+static const uint32_t kSizeClassCount = 52;
+static const size_t kMinAlignment = 16;
+static const size_t kMaxSmallSize = 256 * 1024;
+static const size_t kMaxSmallAlignment = 4096;
+static const size_t kMaxLookupSize = 8192;
+
+static const size_t kHugeHeaderSize = 64;
+static const uint32_t kMaxCachedHugeBlocks = 8;
+static const size_t kMaxCachedHugeBlockSize = 2 * 1024 * 1024;
+
+static const uint32_t kMaxArenas = 32;
+static const size_t kMinDirtyBytes = 2 * 1024 * 1024;
+
+static const size_t kMaxBatchBytes = 32 * 1024;
+static const uint32_t kMaxBatchCount = 64;
+static const size_t kMaxThreadCacheSize = 1024 * 1024;
+static const size_t kThreadCacheChunkSize = 64 * 1024;
+
+static const uint32_t kSegmentMagic = 'tcsg';
+static const uint32_t kHugeMagic = 'tchg';
+
+
+struct Arena;
+
+enum {
+	SPAN_FREE = 0,
+	SPAN_IN_USE,
+	SPAN_TAIL
+};
+
+struct Span {
+	Span*		next;
+	Span*		previous;
+	void*		freeList;
+	uint8_t*	start;
+	uint32_t	objectSize;
+	uint32_t	capacity;
+	uint32_t	usedCount;
+	uint32_t	freshCount;
+		// objects that have been handed out from the span at least once
+	uint8_t		sizeClass;
+	uint8_t		unitCount;
+	uint8_t		headUnit;
+		// index of the first unit of the span this unit belongs to
+	uint8_t		state;
+	bool		partial;
+		// whether the span is in its arena's partial span list
+};
+
+struct Segment {
+	uint32_t	magic;
+	uint32_t	freeUnits;
+	uint32_t	dirtyUnits;
+		// free units whose pages have not been released yet
+	uint32_t	freeUnitCount;
+	Arena*		arena;
+	Segment*	next;
+	Segment*	previous;
+	Span		spans[kUnitsPerSegment];
+};
+
+struct HugeBlock {
+	uint32_t	magic;
+	uint8_t*	base;
+	size_t		mapSize;
+};
+
+struct CachedHugeBlock {
+	uint8_t*	base;
+	size_t		mapSize;
+};
+
+struct Arena {
+	os_lock		lock;
+	Segment*	segments;
+	Span*		partialSpans[kSizeClassCount];
+	size_t		dirtyBytes;
+	size_t		mappedBytes;
+	size_t		usedBytes;
+	size_t		usedObjects;
+	size_t		objectCapacity;
+};
+
+struct CacheBin {
+	void*		objects;
+	uint32_t	count;
+};
+
+struct ThreadCache {
+	ThreadCache*	next;
+	Arena*			arena;
+	size_t			size;
+	CacheBin		bins[kSizeClassCount];
+};
+
+
+static ThreadCache* const kNoThreadCache = (ThreadCache*)~(uintptr_t)0;
+	// marks a thread that is about to exit
+
+static uint32_t sClassSizes[kSizeClassCount];
+static uint32_t sClassBatchCounts[kSizeClassCount];
+static uint8_t sClassUnitCounts[kSizeClassCount];
+static uint8_t sSizeClassTable[kMaxLookupSize / kMinAlignment + 1];
+
+static Arena sArenas[kMaxArenas];
+static uint32_t sArenaCount;
+static int sNextArena;
+
+static os_lock sThreadCacheLock;
+static ThreadCache* sFreeThreadCaches;
+
+static os_lock sHugeLock;
+static size_t sHugeMappedBytes;
+static size_t sHugeUsedBytes;
+static size_t sHugeCount;
+static CachedHugeBlock sCachedHugeBlocks[kMaxCachedHugeBlocks];
+static uint32_t sCachedHugeBlockCount;
+
+static bool sInitialized;
+
+
+static inline uint32_t
+count_bits(uint32_t bits)
+{
+	uint32_t count = 0;
+	while (bits != 0) {
+		bits &= bits - 1;
+		count++;
+	}
+
+	return count;
+}
+
+
+static inline size_t
+round_up(size_t size, size_t alignment)
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+
+static inline uint32_t
+size_class_for(size_t size)
+{
+	if (size <= kMaxLookupSize)
+		return sSizeClassTable[(size + kMinAlignment - 1) / kMinAlignment];
+
+	uint32_t sizeClass = sSizeClassTable[kMaxLookupSize / kMinAlignment];
+	while (sClassSizes[sizeClass] < size)
+		sizeClass++;
+
+	return sizeClass;
+}
+
+
+static inline Segment*
+segment_for(void* address)
+{
+	// Allocations never start at the beginning of a segment, but a huge
+	// allocation with a large alignment may start at the end of one,
+	// see allocate_huge().
+	return (Segment*)(((uintptr_t)address - 1) & ~(uintptr_t)(kSegmentSize - 1));
+}
+
+
+static inline Span*
+span_for(Segment* segment, void* address)
+{
+	uint32_t unit = ((uintptr_t)address - (uintptr_t)segment) / kUnitSize;
+	return &segment->spans[segment->spans[unit].headUnit];
+}
+
+
+static void
+init_size_classes()
+{
+	// 16 byte steps up to 128 bytes, then four classes per power of two
+	for (uint32_t i = 0; i < kSizeClassCount; i++) {
+		size_t size;
+		if (i < 8)
+			size = (i + 1) * kMinAlignment;
+		else {
+			uint32_t shift = (i - 8) / 4;
+			size = ((size_t)128 << shift) + ((i - 8) % 4 + 1) * (32 << shift);
+		}
+		sClassSizes[i] = size;
+
+		uint32_t batchCount = kMaxBatchBytes / size;
+		if (batchCount < 1)
+			batchCount = 1;
+		else if (batchCount > kMaxBatchCount)
+			batchCount = kMaxBatchCount;
+		sClassBatchCounts[i] = batchCount;
+
+		// use as few units as possible, while wasting at most one eighth of
+		// the span; even a span in the first unit must hold an object
+		uint32_t unitCount = 1;
+		for (; unitCount < kUnitsPerSegment; unitCount++) {
+			size_t spanSize = unitCount * kUnitSize;
+			if (spanSize - kSegmentHeaderSize >= size
+				&& spanSize % size <= spanSize / 8) {
+				break;
+			}
+		}
+		sClassUnitCounts[i] = unitCount;
+	}
+
+	uint32_t sizeClass = 0;
+	for (uint32_t i = 0; i <= kMaxLookupSize / kMinAlignment; i++) {
+		while (sClassSizes[sizeClass] < i * kMinAlignment)
+			sizeClass++;
+		sSizeClassTable[i] = sizeClass;
+	}
+}
+
+
+//	#pragma mark - spans
+
+
+static void
+add_partial_span(Arena* arena, Span* span)
+{
+	Span*& head = arena->partialSpans[span->sizeClass];
+	span->previous = NULL;
+	span->next = head;
+	if (head != NULL)
+		head->previous = span;
+	head = span;
+	span->partial = true;
+}
+
+
+static void
+remove_partial_span(Arena* arena, Span* span)
+{
+	if (span->previous != NULL)
+		span->previous->next = span->next;
+	else
+		arena->partialSpans[span->sizeClass] = span->next;
+	if (span->next != NULL)
+		span->next->previous = span->previous;
+	span->partial = false;
+}
+
+
+static int32_t
+find_free_units(uint32_t freeUnits, uint32_t count)
+{
+	uint32_t mask = (1U << count) - 1;
+	for (uint32_t i = 0; i + count <= kUnitsPerSegment; i++) {
+		if (((freeUnits >> i) & mask) == mask)
+			return i;
+	}
+
+	return -1;
+}
+
+
+static Segment*
+create_segment(Arena* arena)
+{
+	Segment* segment = (Segment*)os_map(kSegmentSize, kSegmentSize);
+	if (segment == NULL)
+		return NULL;
+
+	// the mapping is already cleared
+	segment->magic = kSegmentMagic;
+	segment->freeUnits = (1U << kUnitsPerSegment) - 1;
+	segment->freeUnitCount = kUnitsPerSegment;
+	segment->arena = arena;
+
+	segment->next = arena->segments;
+	if (arena->segments != NULL)
+		arena->segments->previous = segment;
+	arena->segments = segment;
+
+	arena->mappedBytes += kSegmentSize;
+	return segment;
+}
+
+
+static void
+delete_segment(Arena* arena, Segment* segment)
+{
+	if (segment->previous != NULL)
+		segment->previous->next = segment->next;
+	else
+		arena->segments = segment->next;
+	if (segment->next != NULL)
+		segment->next->previous = segment->previous;
+
+	arena->dirtyBytes -= count_bits(segment->dirtyUnits) * kUnitSize;
+	arena->mappedBytes -= kSegmentSize;
+	os_unmap(segment, kSegmentSize);
+}
+
+
+/*!	Gives the pages of free units back to the system, and unmaps unused
+	segments, until at most \a keepBytes of dirty units are left. One unused
+	segment is always kept.
+*/
+static void
+release_dirty_units(Arena* arena, size_t keepBytes)
+{
+	bool keepSegment = true;
+
+	Segment* segment = arena->segments;
+	while (segment != NULL && arena->dirtyBytes > keepBytes) {
+		Segment* next = segment->next;
+
+		if (segment->freeUnitCount == kUnitsPerSegment) {
+			if (!keepSegment) {
+				delete_segment(arena, segment);
+				segment = next;
+				continue;
+			}
+			keepSegment = false;
+		}
+
+		uint32_t dirtyUnits = segment->dirtyUnits;
+		uint32_t unit = 0;
+		while (dirtyUnits != 0) {
+			if ((dirtyUnits & 1) == 0) {
+				dirtyUnits >>= 1;
+				unit++;
+				continue;
+			}
+
+			uint32_t count = 0;
+			while ((dirtyUnits & 1) != 0) {
+				dirtyUnits >>= 1;
+				count++;
+			}
+
+			uint8_t* start = (uint8_t*)segment + unit * kUnitSize;
+			uint8_t* end = start + count * kUnitSize;
+			if (unit == 0)
+				start += kSegmentHeaderSize;
+			os_release(start, end - start);
+
+			unit += count;
+		}
+
+		arena->dirtyBytes -= count_bits(segment->dirtyUnits) * kUnitSize;
+		segment->dirtyUnits = 0;
+		segment = next;
+	}
+}
+
+
+static Span*
+create_span(Arena* arena, uint32_t sizeClass)
+{
+	uint32_t unitCount = sClassUnitCounts[sizeClass];
+
+	Segment* segment = arena->segments;
+	int32_t firstUnit = -1;
+	for (; segment != NULL; segment = segment->next) {
+		if (segment->freeUnitCount < unitCount)
+			continue;
+
+		firstUnit = find_free_units(segment->freeUnits, unitCount);
+		if (firstUnit >= 0)
+			break;
+	}
+
+	if (segment == NULL) {
+		segment = create_segment(arena);
+		if (segment == NULL)
+			return NULL;
+		firstUnit = 0;
+	}
+
+	uint32_t mask = ((1U << unitCount) - 1) << firstUnit;
+	arena->dirtyBytes -= count_bits(segment->dirtyUnits & mask) * kUnitSize;
+	segment->dirtyUnits &= ~mask;
+	segment->freeUnits &= ~mask;
+	segment->freeUnitCount -= unitCount;
+
+	uint8_t* start = (uint8_t*)segment + firstUnit * kUnitSize;
+	uint8_t* end = start + unitCount * kUnitSize;
+	if (firstUnit == 0)
+		start += kSegmentHeaderSize;
+
+	Span* span = &segment->spans[firstUnit];
+	span->freeList = NULL;
+	span->start = start;
+	span->objectSize = sClassSizes[sizeClass];
+	span->capacity = (end - start) / span->objectSize;
+	span->usedCount = 0;
+	span->freshCount = 0;
+	span->sizeClass = sizeClass;
+	span->unitCount = unitCount;
+	span->headUnit = firstUnit;
+	span->state = SPAN_IN_USE;
+
+	for (uint32_t i = 1; i < unitCount; i++) {
+		segment->spans[firstUnit + i].headUnit = firstUnit;
+		segment->spans[firstUnit + i].state = SPAN_TAIL;
+	}
+
+	arena->objectCapacity += span->capacity;
+	add_partial_span(arena, span);
+	return span;
+}
+
+
+static void
+delete_span(Arena* arena, Segment* segment, Span* span)
+{
+	if (span->partial)
+		remove_partial_span(arena, span);
+	arena->objectCapacity -= span->capacity;
+
+	uint32_t mask = ((1U << span->unitCount) - 1) << span->headUnit;
+	for (uint32_t i = 0; i < span->unitCount; i++)
+		segment->spans[span->headUnit + i].state = SPAN_FREE;
+
+	segment->freeUnits |= mask;
+	segment->dirtyUnits |= mask;
+	segment->freeUnitCount += span->unitCount;
+	arena->dirtyBytes += span->unitCount * kUnitSize;
+
+	if (arena->dirtyBytes > kMinDirtyBytes
+		&& arena->dirtyBytes > arena->mappedBytes / 4)
+		release_dirty_units(arena, arena->mappedBytes / 8);
+}
+
+
+//	#pragma mark - arenas
+
+
+/*!	Takes up to \a count objects of the given size class from the arena, and
+	returns them as a list linked through their first word.
+	The arena must be locked.
+*/
+static uint32_t
+arena_allocate(Arena* arena, uint32_t sizeClass, void** _objects,
+	uint32_t count)
+{
+	void* objects = NULL;
+	uint32_t allocated = 0;
+
+	while (allocated < count) {
+		Span* span = arena->partialSpans[sizeClass];
+		if (span == NULL) {
+			span = create_span(arena, sizeClass);
+			if (span == NULL)
+				break;
+		}
+
+		while (allocated < count && span->usedCount < span->capacity) {
+			void* object = span->freeList;
+			if (object != NULL)
+				span->freeList = *(void**)object;
+			else
+				object = span->start + span->freshCount++ * span->objectSize;
+
+			*(void**)object = objects;
+			objects = object;
+			span->usedCount++;
+			allocated++;
+		}
+
+		if (span->usedCount == span->capacity)
+			remove_partial_span(arena, span);
+	}
+
+	arena->usedObjects += allocated;
+	arena->usedBytes += allocated * sClassSizes[sizeClass];
+
+	*_objects = objects;
+	return allocated;
+}
+
+
+/*!	Returns an object to its span. The arena must be locked.
+*/
+static void
+arena_free(Arena* arena, Segment* segment, void* object)
+{
+	Span* span = span_for(segment, object);
+	if (span->state != SPAN_IN_USE || span->usedCount == 0)
+		os_panic("free(): invalid address");
+
+	*(void**)object = span->freeList;
+	span->freeList = object;
+	span->usedCount--;
+
+	arena->usedObjects--;
+	arena->usedBytes -= span->objectSize;
+
+	if (span->usedCount == 0) {
+		// keep the span if it is the only one left for its size class
+		Span* head = arena->partialSpans[span->sizeClass];
+		bool otherSpans = span->partial
+			? head != span || span->next != NULL : head != NULL;
+		if (otherSpans) {
+			delete_span(arena, segment, span);
+			return;
+		}
+	}
+
+	if (!span->partial)
+		add_partial_span(arena, span);
+}
+
+
+static void
+free_objects(void* objects)
+{
+	Arena* lockedArena = NULL;
+
+	while (objects != NULL) {
+		void* next = *(void**)objects;
+
+		Segment* segment = segment_for(objects);
+		if (segment->arena != lockedArena) {
+			if (lockedArena != NULL)
+				os_lock_unlock(lockedArena->lock);
+			lockedArena = segment->arena;
+			os_lock_lock(lockedArena->lock);
+		}
+
+		arena_free(lockedArena, segment, objects);
+		objects = next;
+	}
+
+	if (lockedArena != NULL)
+		os_lock_unlock(lockedArena->lock);
+}
+
+
+//	#pragma mark - huge allocations
+
+
+static void*
+allocate_huge(size_t size, size_t alignment)
+{
+	if (size > ~(size_t)0 / 4 || alignment > ~(size_t)0 / 4)
+		return NULL;
+
+	// The header must be within the segment sized block that contains the
+	// first byte of the allocation. If the alignment is larger than that,
+	// the allocation starts at the end of the first block.
+	size_t offset = alignment > kHugeHeaderSize ? alignment : kHugeHeaderSize;
+	size_t mapAlignment = alignment > kSegmentSize ? alignment : kSegmentSize;
+	size_t mapSize = round_up(offset + size, os_page_size());
+
+	// reuse a recently freed mapping that is not much larger, if possible
+	uint8_t* base = NULL;
+	os_lock_lock(sHugeLock);
+	if (mapAlignment == kSegmentSize) {
+		for (uint32_t i = 0; i < sCachedHugeBlockCount; i++) {
+			CachedHugeBlock& cached = sCachedHugeBlocks[i];
+			if (cached.mapSize >= mapSize
+				&& cached.mapSize - mapSize <= mapSize / 2) {
+				base = cached.base;
+				mapSize = cached.mapSize;
+				cached = sCachedHugeBlocks[--sCachedHugeBlockCount];
+				break;
+			}
+		}
+	}
+	os_lock_unlock(sHugeLock);
+
+	bool mapped = false;
+	if (base == NULL) {
+		base = (uint8_t*)os_map(mapSize, mapAlignment);
+		if (base == NULL)
+			return NULL;
+		mapped = true;
+	}
+
+	uint8_t* address = base + offset;
+	HugeBlock* block = (HugeBlock*)segment_for(address);
+	block->magic = kHugeMagic;
+	block->base = base;
+	block->mapSize = mapSize;
+
+	os_lock_lock(sHugeLock);
+	if (mapped)
+		sHugeMappedBytes += mapSize;
+	sHugeUsedBytes += mapSize - offset;
+	sHugeCount++;
+	os_lock_unlock(sHugeLock);
+
+	return address;
+}
+
+
+static HugeBlock*
+huge_block_for(void* address)
+{
+	HugeBlock* block = (HugeBlock*)segment_for(address);
+	if (block->magic != kHugeMagic)
+		os_panic("free(): invalid address");
+
+	return block;
+}
+
+
+static void
+free_huge(void* address)
+{
+	HugeBlock* block = huge_block_for(address);
+	uint8_t* base = block->base;
+	size_t mapSize = block->mapSize;
+	block->magic = 0;
+
+	os_lock_lock(sHugeLock);
+	sHugeUsedBytes -= base + mapSize - (uint8_t*)address;
+	sHugeCount--;
+
+	// keep a few mappings around, replacing the oldest one if needed
+	if (mapSize <= kMaxCachedHugeBlockSize) {
+		CachedHugeBlock evicted = { NULL, 0 };
+		if (sCachedHugeBlockCount == kMaxCachedHugeBlocks) {
+			evicted = sCachedHugeBlocks[0];
+			memmove(&sCachedHugeBlocks[0], &sCachedHugeBlocks[1],
+				(kMaxCachedHugeBlocks - 1) * sizeof(CachedHugeBlock));
+			sCachedHugeBlockCount--;
+		}
+
+		sCachedHugeBlocks[sCachedHugeBlockCount].base = base;
+		sCachedHugeBlocks[sCachedHugeBlockCount].mapSize = mapSize;
+		sCachedHugeBlockCount++;
+
+		base = evicted.base;
+		mapSize = evicted.mapSize;
+	}
+
+	if (base != NULL)
+		sHugeMappedBytes -= mapSize;
+	os_lock_unlock(sHugeLock);
+
+	if (base != NULL)
+		os_unmap(base, mapSize);
+}
+
+
+/*!	Tries to resize a huge allocation without moving it.
+*/
+static bool
+resize_huge(void* address, size_t newSize)
+{
+	if (newSize > ~(size_t)0 / 4)
+		return false;
+
+	HugeBlock* block = huge_block_for(address);
+	size_t offset = (uint8_t*)address - block->base;
+	size_t mapSize = round_up(offset + newSize, os_page_size());
+	if (mapSize == block->mapSize)
+		return true;
+
+	if (!os_resize(block->base, block->mapSize, mapSize))
+		return false;
+
+	os_lock_lock(sHugeLock);
+	sHugeMappedBytes += mapSize - block->mapSize;
+	sHugeUsedBytes += mapSize - block->mapSize;
+	os_lock_unlock(sHugeLock);
+
+	block->mapSize = mapSize;
+	return true;
+}
+
+
+//	#pragma mark - thread caches
+
+
+static ThreadCache*
+create_thread_cache()
+{
+	os_lock_lock(sThreadCacheLock);
+
+	if (sFreeThreadCaches == NULL) {
+		uint8_t* chunk = (uint8_t*)os_map(kThreadCacheChunkSize, 0);
+		if (chunk != NULL) {
+			for (size_t offset = 0; offset + sizeof(ThreadCache)
+					<= kThreadCacheChunkSize; offset += sizeof(ThreadCache)) {
+				ThreadCache* cache = (ThreadCache*)(chunk + offset);
+				cache->next = sFreeThreadCaches;
+				sFreeThreadCaches = cache;
+			}
+		}
+	}
+
+	ThreadCache* cache = sFreeThreadCaches;
+	if (cache != NULL)
+		sFreeThreadCaches = cache->next;
+
+	os_lock_unlock(sThreadCacheLock);
+
+	if (cache == NULL)
+		return NULL;
+
+	memset(cache, 0, sizeof(ThreadCache));
+
+	// Userland cannot cheaply find out on which CPU it runs, so the threads
+	// are spread over the arenas instead.
+	cache->arena = &sArenas[
+		(uint32_t)os_atomic_add(&sNextArena, 1) % sArenaCount];
+
+	os_set_thread_cache(cache);
+	return cache;
+}
+
+
+static inline ThreadCache*
+get_thread_cache()
+{
+	ThreadCache* cache = (ThreadCache*)os_get_thread_cache();
+	if (cache == NULL)
+		return create_thread_cache();
+	if (cache == kNoThreadCache)
+		return NULL;
+
+	return cache;
+}
+
+
+static void
+flush_bin(ThreadCache* cache, uint32_t sizeClass, uint32_t count)
+{
+	CacheBin& bin = cache->bins[sizeClass];
+
+	void* objects = bin.objects;
+	void* last = objects;
+	for (uint32_t i = 1; i < count; i++)
+		last = *(void**)last;
+
+	bin.objects = *(void**)last;
+	bin.count -= count;
+	cache->size -= count * sClassSizes[sizeClass];
+
+	*(void**)last = NULL;
+	free_objects(objects);
+}
+
+
+/*!	Halves all lists of the cache, once it holds more than
+	kMaxThreadCacheSize bytes.
+*/
+static void
+scavenge_thread_cache(ThreadCache* cache)
+{
+	for (uint32_t i = 0; i < kSizeClassCount; i++) {
+		if (cache->bins[i].count > 0)
+			flush_bin(cache, i, (cache->bins[i].count + 1) / 2);
+	}
+}
+
+
+static void*
+refill_thread_cache(ThreadCache* cache, uint32_t sizeClass)
+{
+	Arena* arena = cache->arena;
+	void* objects;
+
+	os_lock_lock(arena->lock);
+	uint32_t count = arena_allocate(arena, sizeClass, &objects,
+		sClassBatchCounts[sizeClass]);
+	os_lock_unlock(arena->lock);
+
+	if (count == 0)
+		return NULL;
+
+	CacheBin& bin = cache->bins[sizeClass];
+	bin.objects = *(void**)objects;
+	bin.count = count - 1;
+	cache->size += (count - 1) * sClassSizes[sizeClass];
+
+	return objects;
+}
+
+
+static void*
+allocate_uncached(uint32_t sizeClass)
+{
+	Arena* arena = &sArenas[0];
+	void* object;
+
+	os_lock_lock(arena->lock);
+	uint32_t count = arena_allocate(arena, sizeClass, &object, 1);
+	os_lock_unlock(arena->lock);
+
+	return count != 0 ? object : NULL;
+}
+
+
+static void
+thread_exit_hook(void* /*cache*/)
+{
+	heap_thread_exit();
+}
+
+
+//	#pragma mark - public API
+
+
+bool
+heap_init()
+{
+	if (sInitialized)
+		return true;
+
+	init_size_classes();
+
+	int cpuCount = os_cpu_count();
+	sArenaCount = cpuCount < (int)kMaxArenas ? cpuCount : kMaxArenas;
+	if (sArenaCount < 1)
+		sArenaCount = 1;
+
+	for (uint32_t i = 0; i < sArenaCount; i++) {
+		memset(&sArenas[i], 0, sizeof(Arena));
+		os_lock_init(sArenas[i].lock, "heap arena");
+	}
+
+	os_lock_init(sThreadCacheLock, "heap thread caches");
+	os_lock_init(sHugeLock, "heap huge allocations");
+
+	sInitialized = true;
+
+	os_init(&thread_exit_hook);
+	return true;
+}
+
+
+bool
+heap_initialized()
+{
+	return sInitialized;
+}
+
+
+void*
+heap_malloc(size_t size)
+{
+	if (size > kMaxSmallSize)
+		return allocate_huge(size, 0);
+
+	uint32_t sizeClass = size_class_for(size);
+
+	ThreadCache* cache = get_thread_cache();
+	if (cache == NULL)
+		return allocate_uncached(sizeClass);
+
+	CacheBin& bin = cache->bins[sizeClass];
+	void* object = bin.objects;
+	if (object == NULL)
+		return refill_thread_cache(cache, sizeClass);
+
+	bin.objects = *(void**)object;
+	bin.count--;
+	cache->size -= sClassSizes[sizeClass];
+	return object;
+}
+
+
+void*
+heap_memalign(size_t alignment, size_t size)
+{
+	if (alignment <= kMinAlignment)
+		return heap_malloc(size);
+
+	// objects of power of two sizes are aligned to their size up to the
+	// alignment of the spans
+	if (alignment <= kMaxSmallAlignment && size <= kMaxSmallSize) {
+		size_t objectSize = alignment;
+		while (objectSize < size)
+			objectSize <<= 1;
+		if (objectSize <= kMaxSmallSize)
+			return heap_malloc(objectSize);
+	}
+
+	return allocate_huge(size, alignment);
+}
+
+
+void
+heap_free(void* address)
+{
+	if (address == NULL)
+		return;
+
+	Segment* segment = segment_for(address);
+	if (segment->magic != kSegmentMagic) {
+		free_huge(address);
+		return;
+	}
+
+	Span* span = span_for(segment, address);
+	uint32_t sizeClass = span->sizeClass;
+
+	ThreadCache* cache = get_thread_cache();
+	if (cache == NULL) {
+		Arena* arena = segment->arena;
+		os_lock_lock(arena->lock);
+		arena_free(arena, segment, address);
+		os_lock_unlock(arena->lock);
+		return;
+	}
+
+	CacheBin& bin = cache->bins[sizeClass];
+	*(void**)address = bin.objects;
+	bin.objects = address;
+	bin.count++;
+	cache->size += span->objectSize;
+
+	if (bin.count > 2 * sClassBatchCounts[sizeClass])
+		flush_bin(cache, sizeClass, sClassBatchCounts[sizeClass]);
+	else if (cache->size > kMaxThreadCacheSize)
+		scavenge_thread_cache(cache);
+}
+
+
+void*
+heap_realloc(void* address, size_t newSize)
+{
+	Segment* segment = segment_for(address);
+	size_t oldSize;
+
+	if (segment->magic == kSegmentMagic) {
+		oldSize = span_for(segment, address)->objectSize;
+		if (newSize <= oldSize && (newSize > oldSize / 2 || oldSize <= 128))
+			return address;
+	} else {
+		HugeBlock* block = huge_block_for(address);
+		oldSize = block->base + block->mapSize - (uint8_t*)address;
+
+		// huge allocations are resized in place whenever possible, unless
+		// they shrink so much that they would better be moved into a span
+		if (newSize > kMaxSmallSize || newSize > oldSize / 2) {
+			if (resize_huge(address, newSize))
+				return address;
+			if (newSize <= oldSize)
+				return address;
+		}
+	}
+
+	void* newAddress = heap_malloc(newSize);
+	if (newAddress == NULL) {
+		// shrinking cannot fail
+		return newSize <= oldSize ? address : NULL;
+	}
+
+	memcpy(newAddress, address, newSize < oldSize ? newSize : oldSize);
+	heap_free(address);
+	return newAddress;
+}
+
+
+size_t
+heap_usable_size(void* address)
+{
+	Segment* segment = segment_for(address);
+	if (segment->magic == kSegmentMagic)
+		return span_for(segment, address)->objectSize;
+
+	HugeBlock* block = huge_block_for(address);
+	return block->base + block->mapSize - (uint8_t*)address;
+}
+
+
+void
+heap_thread_exit()
+{
+	ThreadCache* cache = (ThreadCache*)os_get_thread_cache();
+	if (cache == NULL || cache == kNoThreadCache)
+		return;
+
+	// anything the thread frees from now on goes directly to the arenas
+	os_set_thread_cache(kNoThreadCache);
+
+	for (uint32_t i = 0; i < kSizeClassCount; i++)
+		free_objects(cache->bins[i].objects);
+
+	os_lock_lock(sThreadCacheLock);
+	cache->next = sFreeThreadCaches;
+	sFreeThreadCaches = cache;
+	os_lock_unlock(sThreadCacheLock);
+}
+
+
+void
+heap_before_fork()
+{
+	os_lock_lock(sThreadCacheLock);
+	os_lock_lock(sHugeLock);
+	for (uint32_t i = 0; i < sArenaCount; i++)
+		os_lock_lock(sArenas[i].lock);
+}
+
+
+void
+heap_after_fork_parent()
+{
+	for (uint32_t i = 0; i < sArenaCount; i++)
+		os_lock_unlock(sArenas[i].lock);
+	os_lock_unlock(sHugeLock);
+	os_lock_unlock(sThreadCacheLock);
+}
+
+
+void
+heap_after_fork_child()
+{
+	// The caches of the other threads are lost, but the memory they hold
+	// remains allocated.
+	for (uint32_t i = 0; i < sArenaCount; i++)
+		os_lock_init(sArenas[i].lock, "heap arena");
+	os_lock_init(sHugeLock, "heap huge allocations");
+	os_lock_init(sThreadCacheLock, "heap thread caches");
+}
+
+
+void
+heap_get_stats(heap_stats& stats)
+{
+	memset(&stats, 0, sizeof(heap_stats));
+
+	for (uint32_t i = 0; i < sArenaCount; i++) {
+		Arena& arena = sArenas[i];
+		os_lock_lock(arena.lock);
+		stats.mapped_bytes += arena.mappedBytes;
+		stats.used_bytes += arena.usedBytes;
+		stats.used_objects += arena.usedObjects;
+		stats.free_objects += arena.objectCapacity - arena.usedObjects;
+		os_lock_unlock(arena.lock);
+	}
+
+	os_lock_lock(sHugeLock);
+	stats.mapped_bytes += sHugeMappedBytes;
+	stats.used_bytes += sHugeUsedBytes;
+	stats.used_objects += sHugeCount;
+	os_lock_unlock(sHugeLock);
+}
+
+
+}	// namespace TCache
+}	// namespace BPrivate
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef MALLOC_TCACHE_HEAP_H
+#define MALLOC_TCACHE_HEAP_H
+
+
+#include <stddef.h>
+
+
+namespace BPrivate {
+namespace TCache {
+
+
+struct heap_stats {
+	size_t	mapped_bytes;
+	size_t	used_bytes;
+	size_t	used_objects;
+	size_t	free_objects;
+};
+
+
+bool		heap_init();
+bool		heap_initialized();
+
+void*		heap_malloc(size_t size);
+void*		heap_memalign(size_t alignment, size_t size);
+void		heap_free(void* address);
+void*		heap_realloc(void* address, size_t newSize);
+size_t		heap_usable_size(void* address);
+
+void		heap_thread_exit();
+void		heap_before_fork();
+void		heap_after_fork_parent();
+void		heap_after_fork_child();
+
+void		heap_get_stats(heap_stats& stats);
+
+
+}	// namespace TCache
+}	// namespace BPrivate
+
+
+#endif	// MALLOC_TCACHE_HEAP_H
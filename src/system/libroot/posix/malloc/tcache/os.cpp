@@ -0,0 +1,314 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "os.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __HAIKU__
+#	include <TLS.h>
+
+#	include <libroot_private.h>
+#	include <tls.h>
+#else
+#	include <stdio.h>
+#	include <stdlib.h>
+#endif
+
+
+#ifndef __HAIKU__
+extern "C" void __heap_before_fork(void);
+extern "C" void __heap_after_fork_child(void);
+extern "C" void __heap_after_fork_parent(void);
+#endif
+
+
+namespace BPrivate {
+namespace TCache {
+
+
+#ifdef __HAIKU__
+
+
+void
+os_init(void (*threadExitHook)(void* threadCache))
+{
+	// libroot calls __heap_thread_exit() itself
+}
+
+
+void
+os_panic(const char* message)
+{
+	debugger(message);
+}
+
+
+size_t
+os_page_size()
+{
+	return B_PAGE_SIZE;
+}
+
+
+int
+os_cpu_count()
+{
+	system_info info;
+	if (get_system_info(&info) != B_OK)
+		return 1;
+
+	return info.cpu_count;
+}
+
+
+int
+os_atomic_add(int* value, int addValue)
+{
+	return atomic_add((int32*)value, addValue);
+}
+
+
+void*
+os_map(size_t size, size_t alignment)
+{
+	uint32 protection = B_READ_AREA | B_WRITE_AREA;
+	if (__gABIVersion < B_HAIKU_ABI_GCC_2_HAIKU)
+		protection |= B_EXECUTE_AREA;
+
+	// There is no way to ask for an aligned area from userland, so we
+	// allocate a larger one, and cut off what we don't need on both ends
+	size_t mapSize = size + (alignment > B_PAGE_SIZE ? alignment : 0);
+	void* base;
+	area_id area = create_area("heap", &base, B_RANDOMIZED_ANY_ADDRESS,
+		mapSize, B_NO_LOCK, protection);
+	if (area < 0)
+		return NULL;
+
+	addr_t address = (addr_t)base;
+	if (alignment > B_PAGE_SIZE) {
+		address = (address + alignment - 1) & ~(addr_t)(alignment - 1);
+		if (address != (addr_t)base)
+			munmap(base, address - (addr_t)base);
+		if ((addr_t)base + mapSize != address + size)
+			munmap((void*)(address + size), (addr_t)base + mapSize
+				- (address + size));
+	}
+
+	return (void*)address;
+}
+
+
+void
+os_unmap(void* address, size_t size)
+{
+	munmap(address, size);
+}
+
+
+void
+os_release(void* address, size_t size)
+{
+	madvise(address, size, MADV_FREE);
+}
+
+
+bool
+os_resize(void* address, size_t oldSize, size_t newSize)
+{
+	area_id area = area_for(address);
+	if (area < 0)
+		return false;
+
+	return resize_area(area, newSize) == B_OK;
+}
+
+
+void
+os_lock_init(os_lock& lock, const char* name)
+{
+	mutex_init_etc(&lock, name, MUTEX_FLAG_ADAPTIVE);
+}
+
+
+void
+os_lock_lock(os_lock& lock)
+{
+	mutex_lock(&lock);
+}
+
+
+void
+os_lock_unlock(os_lock& lock)
+{
+	mutex_unlock(&lock);
+}
+
+
+void*
+os_get_thread_cache()
+{
+	return tls_get(TLS_MALLOC_SLOT);
+}
+
+
+void
+os_set_thread_cache(void* threadCache)
+{
+	tls_set(TLS_MALLOC_SLOT, threadCache);
+}
+
+
+#else	// !__HAIKU__
+
+
+static __thread void* sThreadCache;
+static pthread_key_t sThreadCacheKey;
+
+
+void
+os_init(void (*threadExitHook)(void* threadCache))
+{
+	// the key is only used to be notified when a thread exits
+	if (pthread_key_create(&sThreadCacheKey, threadExitHook) != 0
+		|| pthread_atfork(&__heap_before_fork, &__heap_after_fork_parent,
+			&__heap_after_fork_child) != 0) {
+		fprintf(stderr, "tcache: could not initialize the heap\n");
+		abort();
+	}
+}
+
+
+void
+os_panic(const char* message)
+{
+	fprintf(stderr, "tcache: %s\n", message);
+	abort();
+}
+
+
+size_t
+os_page_size()
+{
+	return sysconf(_SC_PAGESIZE);
+}
+
+
+int
+os_cpu_count()
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
+
+int
+os_atomic_add(int* value, int addValue)
+{
+	return __sync_fetch_and_add(value, addValue);
+}
+
+
+void*
+os_map(size_t size, size_t alignment)
+{
+	size_t mapSize = size + (alignment > os_page_size() ? alignment : 0);
+	void* base = mmap(NULL, mapSize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED)
+		return NULL;
+
+	uintptr_t address = (uintptr_t)base;
+	if (alignment > os_page_size()) {
+		address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		if (address != (uintptr_t)base)
+			munmap(base, address - (uintptr_t)base);
+		if ((uintptr_t)base + mapSize != address + size)
+			munmap((void*)(address + size), (uintptr_t)base + mapSize
+				- (address + size));
+	}
+
+	return (void*)address;
+}
+
+
+void
+os_unmap(void* address, size_t size)
+{
+	munmap(address, size);
+}
+
+
+void
+os_release(void* address, size_t size)
+{
+#ifdef MADV_FREE
+	madvise(address, size, MADV_FREE);
+#else
+	madvise(address, size, MADV_DONTNEED);
+#endif
+}
+
+
+bool
+os_resize(void* address, size_t oldSize, size_t newSize)
+{
+	if (newSize < oldSize) {
+		munmap((char*)address + newSize, oldSize - newSize);
+		return true;
+	}
+
+#ifdef MREMAP_MAYMOVE
+	// without MREMAP_MAYMOVE, this only succeeds in place
+	return mremap(address, oldSize, newSize, 0) != MAP_FAILED;
+#else
+	return false;
+#endif
+}
+
+
+void
+os_lock_init(os_lock& lock, const char* /*name*/)
+{
+	pthread_mutex_init(&lock, NULL);
+}
+
+
+void
+os_lock_lock(os_lock& lock)
+{
+	pthread_mutex_lock(&lock);
+}
+
+
+void
+os_lock_unlock(os_lock& lock)
+{
+	pthread_mutex_unlock(&lock);
+}
+
+
+void*
+os_get_thread_cache()
+{
+	return sThreadCache;
+}
+
+
+void
+os_set_thread_cache(void* threadCache)
+{
+	sThreadCache = threadCache;
+	pthread_setspecific(sThreadCacheKey, threadCache);
+}
+
+
+#endif	// !__HAIKU__
+
+
+}	// namespace TCache
+}	// namespace BPrivate
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef MALLOC_TCACHE_OS_H
+#define MALLOC_TCACHE_OS_H
+
+
+/*!	The services the allocator needs from the operating system. Besides
+	Haiku, they are also implemented for POSIX systems, so that the
+	allocator can be built for the build platform and compared against its
+	native allocator.
+*/
+
+
+#include <stddef.h>
+
+#ifdef __HAIKU__
+#	include <OS.h>
+#	include <locks.h>
+#else
+#	include <pthread.h>
+#	include <stdint.h>
+#endif
+
+
+namespace BPrivate {
+namespace TCache {
+
+
+#ifdef __HAIKU__
+typedef mutex os_lock;
+#else
+typedef pthread_mutex_t os_lock;
+#endif
+
+
+void		os_init(void (*threadExitHook)(void* threadCache));
+void		os_panic(const char* message);
+
+size_t		os_page_size();
+int			os_cpu_count();
+int			os_atomic_add(int* value, int addValue);
+
+void*		os_map(size_t size, size_t alignment);
+void		os_unmap(void* address, size_t size);
+void		os_release(void* address, size_t size);
+bool		os_resize(void* address, size_t oldSize, size_t newSize);
+
+void		os_lock_init(os_lock& lock, const char* name);
+void		os_lock_lock(os_lock& lock);
+void		os_lock_unlock(os_lock& lock);
+
+void*		os_get_thread_cache();
+void		os_set_thread_cache(void* threadCache);
+
+
+}	// namespace TCache
+}	// namespace BPrivate
+
+
+#endif	// MALLOC_TCACHE_OS_H
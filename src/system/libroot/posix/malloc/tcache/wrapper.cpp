@@ -0,0 +1,269 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "heap.h"
+
+#ifdef __HAIKU__
+#	include <OS.h>
+
+#	include <errno_private.h>
+#	include <user_thread.h>
+#else
+#	include <unistd.h>
+
+typedef int status_t;
+
+#	define B_OK					0
+#	define B_NO_MEMORY			ENOMEM
+#	define B_BAD_VALUE			EINVAL
+#	define B_PAGE_SIZE			sysconf(_SC_PAGESIZE)
+#	define __set_errno(error)	(errno = (error))
+#	define defer_signals()		do {} while (false)
+#	define undefer_signals()	do {} while (false)
+#endif
+
+
+using namespace BPrivate::TCache;
+
+
+#ifdef __HAIKU__
+#	define INIT_HEAP()	do {} while (false)
+#else
+	// Outside of Haiku, we might be preloaded into a process that never
+	// calls __init_heap()
+#	define INIT_HEAP() \
+		do { \
+			if (!heap_initialized()) \
+				heap_init(); \
+		} while (false)
+#endif
+
+
+extern "C" status_t
+__init_heap(void)
+{
+	return heap_init() ? B_OK : B_NO_MEMORY;
+}
+
+
+extern "C" void
+__heap_terminate_after()
+{
+}
+
+
+extern "C" void
+__heap_before_fork(void)
+{
+	heap_before_fork();
+}
+
+
+extern "C" void
+__heap_after_fork_child(void)
+{
+	heap_after_fork_child();
+}
+
+
+extern "C" void
+__heap_after_fork_parent(void)
+{
+	heap_after_fork_parent();
+}
+
+
+extern "C" void
+__heap_thread_init(void)
+{
+}
+
+
+extern "C" void
+__heap_thread_exit(void)
+{
+	defer_signals();
+	heap_thread_exit();
+	undefer_signals();
+}
+
+
+//	#pragma mark - public functions
+
+
+extern "C" void*
+malloc(size_t size)
+{
+	INIT_HEAP();
+
+	defer_signals();
+	void* address = heap_malloc(size);
+	undefer_signals();
+
+	if (address == NULL)
+		__set_errno(B_NO_MEMORY);
+
+	return address;
+}
+
+
+extern "C" void*
+calloc(size_t elementCount, size_t elementSize)
+{
+	size_t size = elementCount * elementSize;
+	if (elementCount != 0 && size / elementCount != elementSize) {
+		__set_errno(B_NO_MEMORY);
+		return NULL;
+	}
+
+	void* address = malloc(size);
+	if (address != NULL)
+		memset(address, 0, size);
+
+	return address;
+}
+
+
+extern "C" void
+free(void* address)
+{
+	if (address == NULL)
+		return;
+
+	defer_signals();
+	heap_free(address);
+	undefer_signals();
+}
+
+
+extern "C" void*
+memalign(size_t alignment, size_t size)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		__set_errno(B_BAD_VALUE);
+		return NULL;
+	}
+
+	INIT_HEAP();
+
+	defer_signals();
+	void* address = heap_memalign(alignment, size);
+	undefer_signals();
+
+	if (address == NULL)
+		__set_errno(B_NO_MEMORY);
+
+	return address;
+}
+
+
+extern "C" void*
+aligned_alloc(size_t alignment, size_t size)
+{
+	if (alignment == 0 || size % alignment != 0) {
+		__set_errno(B_BAD_VALUE);
+		return NULL;
+	}
+	return memalign(alignment, size);
+}
+
+
+extern "C" int
+posix_memalign(void** _pointer, size_t alignment, size_t size)
+{
+	// the alignment must be a power of two multiple of sizeof(void*)
+	if (alignment == 0 || (alignment & (sizeof(void*) - 1)) != 0
+		|| (alignment & (alignment - 1)) != 0)
+		return B_BAD_VALUE;
+
+	INIT_HEAP();
+
+	defer_signals();
+	void* pointer = heap_memalign(alignment, size);
+	undefer_signals();
+
+	if (pointer == NULL)
+		return B_NO_MEMORY;
+
+	*_pointer = pointer;
+	return 0;
+}
+
+
+extern "C" void*
+valloc(size_t size)
+{
+	return memalign(B_PAGE_SIZE, size);
+}
+
+
+extern "C" void*
+realloc(void* address, size_t newSize)
+{
+	if (address == NULL)
+		return malloc(newSize);
+
+	if (newSize == 0) {
+		free(address);
+		return NULL;
+	}
+
+	defer_signals();
+	void* newAddress = heap_realloc(address, newSize);
+	undefer_signals();
+
+	if (newAddress == NULL)
+		__set_errno(B_NO_MEMORY);
+
+	return newAddress;
+}
+
+
+extern "C" size_t
+malloc_usable_size(void* address)
+{
+	if (address == NULL)
+		return 0;
+
+	return heap_usable_size(address);
+}
+
+
+//	#pragma mark - BeOS specific extensions
+
+
+struct mstats {
+	size_t bytes_total;
+	size_t chunks_used;
+	size_t bytes_used;
+	size_t chunks_free;
+	size_t bytes_free;
+};
+
+
+extern "C" struct mstats mstats(void);
+
+extern "C" struct mstats
+mstats(void)
+{
+	INIT_HEAP();
+
+	heap_stats heapStats;
+	heap_get_stats(heapStats);
+
+	// objects in the thread caches count as used
+	struct mstats stats;
+	stats.bytes_total = heapStats.mapped_bytes;
+	stats.chunks_used = heapStats.used_objects;
+	stats.bytes_used = heapStats.used_bytes;
+	stats.chunks_free = heapStats.free_objects;
+	stats.bytes_free = heapStats.mapped_bytes - heapStats.used_bytes;
+	return stats;
+}
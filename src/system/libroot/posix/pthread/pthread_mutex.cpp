@@ -13,6 +13,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <arch_cpu_defs.h>
+#include <commpage_defs.h>
 #include <syscalls.h>
 #include <user_mutex_defs.h>
 #include <time_private.h>
@@ -21,13 +23,99 @@
 #define MUTEX_TYPE_BITS		0x0000000f
 #define MUTEX_TYPE(mutex)	((mutex)->flags & MUTEX_TYPE_BITS)
 
+#define MAX_SPINS			2000
+	// Critical sections that take longer are not worth spinning for.
+#define MAX_OWNER_WAITS		100
+
+
+extern "C" const void* __gCommPageAddress;
+extern "C" int32 __gCPUCount;
+
 
 static const pthread_mutexattr pthread_mutexattr_default = {
 	PTHREAD_MUTEX_DEFAULT,
-	false
+	false,
+	PTHREAD_PRIO_NONE
 };
 
 
+/*!	Returns whether the given thread is currently running on any CPU, as
+	published by the scheduler in the commpage.
+*/
+static bool
+thread_is_running(thread_id thread)
+{
+	const addr_t* commPage = (const addr_t*)__gCommPageAddress;
+	const uint8* cpuThreads = (const uint8*)commPage
+		+ commPage[COMMPAGE_ENTRY_CPU_THREADS];
+
+	for (int32 i = 0; i < __gCPUCount; i++) {
+		int32* cpuThread
+			= (int32*)(cpuThreads + i * COMMPAGE_CPU_THREAD_STRIDE);
+		if (atomic_get(cpuThread) == thread)
+			return true;
+	}
+
+	return false;
+}
+
+
+/*!	Tries to lock the mutex by spinning as long as its owner is running on
+	another CPU, as it is then likely to unlock it soon. Blocking in the
+	kernel would take much longer.
+	Returns whether the mutex could be locked.
+*/
+static bool
+mutex_spin(pthread_mutex_t* mutex)
+{
+	if (__gCPUCount < 2)
+		return false;
+
+	for (int32 i = 0; i < MAX_SPINS; i++) {
+		int32 value = atomic_get((int32*)&mutex->lock);
+		if (value == 0) {
+			if (atomic_test_and_set((int32*)&mutex->lock,
+					B_USER_MUTEX_LOCKED, 0) == 0) {
+				return true;
+			}
+			continue;
+		}
+
+		// If there are waiters already, the mutex will be handed over to
+		// one of them.
+		if ((value & B_USER_MUTEX_WAITING) != 0)
+			return false;
+
+		// The owner might not have been set yet, right after the mutex has
+		// been locked.
+		thread_id owner = mutex->owner;
+		if (owner >= 0 && !thread_is_running(owner))
+			return false;
+
+		SPINLOCK_PAUSE();
+	}
+
+	return false;
+}
+
+
+/*!	Returns the owner of the locked mutex, for the kernel to let it inherit
+	our priority.
+*/
+static thread_id
+mutex_owner(pthread_mutex_t* mutex)
+{
+	// The owner is set right after the mutex has been locked.
+	thread_id owner = mutex->owner;
+	for (int32 i = 0; owner < 0 && i < MAX_OWNER_WAITS; i++) {
+		SPINLOCK_PAUSE();
+		owner = mutex->owner;
+	}
+
+	return owner;
+}
+
+
 int
 pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* _attr)
 {
@@ -37,7 +125,9 @@ pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* _attr)
 	mutex->lock = 0;
 	mutex->owner = -1;
 	mutex->owner_count = 0;
-	mutex->flags = attr->type | (attr->process_shared ? MUTEX_FLAG_SHARED : 0);
+	mutex->flags = attr->type | (attr->process_shared ? MUTEX_FLAG_SHARED : 0)
+		| (attr->protocol == PTHREAD_PRIO_INHERIT
+			? MUTEX_FLAG_PRIO_INHERIT : 0);
 
 	return 0;
 }
@@ -75,7 +165,7 @@ __pthread_mutex_lock(pthread_mutex_t* mutex, uint32 flags, bigtime_t timeout)
 
 	// set the locked flag
 	const int32 oldValue = atomic_test_and_set((int32*)&mutex->lock, B_USER_MUTEX_LOCKED, 0);
-	if (oldValue != 0) {
+	if (oldValue != 0 && (timeout < 0 || !mutex_spin(mutex))) {
 		// someone else has the lock or is at least waiting for it
 		if (timeout < 0)
 			return EBUSY;
@@ -85,7 +175,13 @@ __pthread_mutex_lock(pthread_mutex_t* mutex, uint32 flags, bigtime_t timeout)
 		// we have to call the kernel
 		status_t error;
 		do {
-			error = _kern_mutex_lock((int32*)&mutex->lock, NULL, flags, timeout);
+			if ((mutex->flags & MUTEX_FLAG_PRIO_INHERIT) != 0) {
+				error = _kern_mutex_lock_inherit((int32*)&mutex->lock,
+					mutex_owner(mutex), flags, timeout);
+			} else {
+				error = _kern_mutex_lock((int32*)&mutex->lock, NULL, flags,
+					timeout);
+			}
 		} while (error == B_INTERRUPTED);
 
 		if (error != B_OK)
@@ -171,7 +267,9 @@ pthread_mutex_unlock(pthread_mutex_t* mutex)
 		~(int32)B_USER_MUTEX_LOCKED);
 	if ((oldValue & B_USER_MUTEX_WAITING) != 0) {
 		_kern_mutex_unblock((int32*)&mutex->lock,
-			(mutex->flags & MUTEX_FLAG_SHARED) ? B_USER_MUTEX_SHARED : 0);
+			((mutex->flags & MUTEX_FLAG_SHARED) ? B_USER_MUTEX_SHARED : 0)
+			| ((mutex->flags & MUTEX_FLAG_PRIO_INHERIT)
+				? B_USER_MUTEX_PRIO_INHERIT : 0));
 	}
 
 	if (MUTEX_TYPE(mutex) == PTHREAD_MUTEX_ERRORCHECK
@@ -24,6 +24,7 @@ pthread_mutexattr_init(pthread_mutexattr_t *_mutexAttr)
 
 	attr->type = PTHREAD_MUTEX_DEFAULT;
 	attr->process_shared = false;
+	attr->protocol = PTHREAD_PRIO_NONE;
 
 	*_mutexAttr = attr;
 	return B_OK;
@@ -150,9 +151,7 @@ pthread_mutexattr_getprotocol(const pthread_mutexattr_t *_mutexAttr,
 		return B_BAD_VALUE;
 	}
 
-	*_protocol = 0;
-		// not implemented
-
+	*_protocol = attr->protocol;
 	return B_OK;
 }
 
@@ -165,6 +164,15 @@ pthread_mutexattr_setprotocol(pthread_mutexattr_t *_mutexAttr, int protocol)
 	if (_mutexAttr == NULL || (attr = *_mutexAttr) == NULL)
 		return B_BAD_VALUE;
 
-	// not implemented
-	return B_NOT_ALLOWED;
+	switch (protocol) {
+		case PTHREAD_PRIO_NONE:
+		case PTHREAD_PRIO_INHERIT:
+			attr->protocol = protocol;
+			return B_OK;
+		case PTHREAD_PRIO_PROTECT:
+			// not implemented
+			return ENOTSUP;
+		default:
+			return B_BAD_VALUE;
+	}
 }
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	This file is compiled with AVX2 enabled, and must only be used when the
+	CPU supports it.
+*/
+
+
+#include <immintrin.h>
+
+#include "string_functions.h"
+#include "string_simd.h"
+
+
+namespace {
+
+
+struct AVX2Vector {
+	typedef __m256i Type;
+
+	static const size_t kSize = 32;
+	static const uint32_t kFullMask = 0xffffffff;
+
+	static inline Type Load(const void* address)
+	{
+		return _mm256_load_si256((const __m256i*)address);
+	}
+
+	static inline Type LoadUnaligned(const void* address)
+	{
+		return _mm256_loadu_si256((const __m256i*)address);
+	}
+
+	static inline Type Set(int c)
+	{
+		return _mm256_set1_epi8((char)c);
+	}
+
+	static inline uint32_t Equal(Type a, Type b)
+	{
+		return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+	}
+};
+
+
+}	// namespace
+
+
+const string_functions gStringFunctionsAVX2 = {
+	&simd_strlen<AVX2Vector>,
+	&simd_memchr<AVX2Vector>,
+	&simd_memcmp<AVX2Vector>,
+	&simd_strchr<AVX2Vector>,
+	&simd_strrchr<AVX2Vector>,
+	&simd_strcmp<AVX2Vector>,
+	&simd_memmem<AVX2Vector>,
+	&simd_strstr<AVX2Vector>
+};
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	The public string functions call the implementation that suits the CPU
+	best. The SSE2 versions are always available on x86_64, and are used
+	until the CPU features have been checked, so that the functions can be
+	used at any time during the initialization of libroot.
+*/
+
+
+#include <cpuid.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "string_functions.h"
+
+
+static const string_functions* sStringFunctions = &gStringFunctionsSSE2;
+
+
+static bool
+cpu_supports_avx2()
+{
+	uint32_t eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+		return false;
+
+	// the OS must have enabled saving the AVX state, too
+	if ((ecx & bit_OSXSAVE) == 0 || (ecx & bit_AVX) == 0)
+		return false;
+
+	uint32_t xcr0Low, xcr0High;
+	asm volatile("xgetbv" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0));
+	if ((xcr0Low & 0x6) != 0x6)
+		return false;
+
+	if (__get_cpuid_max(0, NULL) < 7)
+		return false;
+
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return (ebx & bit_AVX2) != 0;
+}
+
+
+static void __attribute__((constructor))
+init_string_functions()
+{
+	if (cpu_supports_avx2())
+		sStringFunctions = &gStringFunctionsAVX2;
+}
+
+
+//	#pragma mark -
+
+
+extern "C" size_t
+strlen(const char* string)
+{
+	return sStringFunctions->strlen(string);
+}
+
+
+extern "C" void*
+memchr(const void* buffer, int c, size_t length)
+{
+	return sStringFunctions->memchr(buffer, c, length);
+}
+
+
+extern "C" int
+memcmp(const void* a, const void* b, size_t length)
+{
+	return sStringFunctions->memcmp(a, b, length);
+}
+
+
+extern "C" char*
+strchr(const char* string, int c)
+{
+	return sStringFunctions->strchr(string, c);
+}
+
+
+extern "C" char*
+index(const char* string, int c)
+{
+	return sStringFunctions->strchr(string, c);
+}
+
+
+extern "C" char*
+strrchr(const char* string, int c)
+{
+	return sStringFunctions->strrchr(string, c);
+}
+
+
+extern "C" char*
+rindex(const char* string, int c)
+{
+	return sStringFunctions->strrchr(string, c);
+}
+
+
+extern "C" int
+strcmp(const char* a, const char* b)
+{
+	return sStringFunctions->strcmp(a, b);
+}
+
+
+extern "C" void*
+memmem(const void* haystack, size_t haystackLength, const void* needle,
+	size_t needleLength)
+{
+	return sStringFunctions->memmem(haystack, haystackLength, needle,
+		needleLength);
+}
+
+
+extern "C" char*
+strstr(const char* haystack, const char* needle)
+{
+	return sStringFunctions->strstr(haystack, needle);
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef LIBROOT_STRING_X86_64_STRING_FUNCTIONS_H
+#define LIBROOT_STRING_X86_64_STRING_FUNCTIONS_H
+
+
+#include <stddef.h>
+
+
+struct string_functions {
+	size_t	(*strlen)(const char* string);
+	void*	(*memchr)(const void* buffer, int c, size_t length);
+	int		(*memcmp)(const void* a, const void* b, size_t length);
+	char*	(*strchr)(const char* string, int c);
+	char*	(*strrchr)(const char* string, int c);
+	int		(*strcmp)(const char* a, const char* b);
+	void*	(*memmem)(const void* haystack, size_t haystackLength,
+				const void* needle, size_t needleLength);
+	char*	(*strstr)(const char* haystack, const char* needle);
+};
+
+
+extern const string_functions gStringFunctionsSSE2;
+extern const string_functions gStringFunctionsAVX2;
+
+
+#endif	// LIBROOT_STRING_X86_64_STRING_FUNCTIONS_H
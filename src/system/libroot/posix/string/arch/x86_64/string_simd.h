@@ -0,0 +1,374 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef LIBROOT_STRING_X86_64_STRING_SIMD_H
+#define LIBROOT_STRING_X86_64_STRING_SIMD_H
+
+
+/*!	String functions for any vector width. The vector class \c V provides
+	the vector type, its size, and the operations on it; it is defined by the
+	source files that instantiate these templates, which are compiled for
+	different instruction sets.
+
+	Strings of unknown length are scanned in aligned blocks: an aligned
+	block never crosses a page boundary, and therefore never touches an
+	unmapped page, even if it extends beyond the end of the string.
+*/
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+namespace {
+
+
+static const size_t kPageSize = 4096;
+
+
+template<class V>
+static inline bool
+crosses_page(const uint8_t* address)
+{
+	return ((uintptr_t)address & (kPageSize - 1)) > kPageSize - V::kSize;
+}
+
+
+template<class V>
+size_t
+simd_strlen(const char* string)
+{
+	const typename V::Type zero = V::Set(0);
+
+	uintptr_t offset = (uintptr_t)string & (V::kSize - 1);
+	const char* block = string - offset;
+
+	uint32_t mask = V::Equal(V::Load(block), zero) >> offset;
+	if (mask != 0)
+		return __builtin_ctz(mask);
+
+	while (true) {
+		block += V::kSize;
+		mask = V::Equal(V::Load(block), zero);
+		if (mask != 0)
+			return block + __builtin_ctz(mask) - string;
+	}
+}
+
+
+/*!	Like strnlen(), it does not access any block that starts after
+	\a maxLength bytes.
+*/
+template<class V>
+size_t
+simd_strnlen(const char* string, size_t maxLength)
+{
+	if (maxLength == 0)
+		return 0;
+
+	const typename V::Type zero = V::Set(0);
+
+	uintptr_t offset = (uintptr_t)string & (V::kSize - 1);
+	const char* block = string - offset;
+
+	size_t length;
+	uint32_t mask = V::Equal(V::Load(block), zero) >> offset;
+	if (mask != 0) {
+		length = __builtin_ctz(mask);
+		return length < maxLength ? length : maxLength;
+	}
+
+	while ((size_t)(block + V::kSize - string) < maxLength) {
+		block += V::kSize;
+		mask = V::Equal(V::Load(block), zero);
+		if (mask != 0) {
+			length = block + __builtin_ctz(mask) - string;
+			return length < maxLength ? length : maxLength;
+		}
+	}
+
+	return maxLength;
+}
+
+
+template<class V>
+void*
+simd_memchr(const void* buffer, int c, size_t length)
+{
+	if (length == 0)
+		return NULL;
+
+	const uint8_t* start = (const uint8_t*)buffer;
+	const uint8_t* end = start + length;
+	if (length > UINTPTR_MAX - (uintptr_t)start) {
+		// the length is often just used as "unlimited"
+		end = (const uint8_t*)UINTPTR_MAX;
+	}
+
+	const typename V::Type needle = V::Set(c);
+
+	uintptr_t offset = (uintptr_t)start & (V::kSize - 1);
+	const uint8_t* block = start - offset;
+
+	uint32_t mask = V::Equal(V::Load(block), needle) >> offset;
+	if (mask != 0) {
+		const uint8_t* found = start + __builtin_ctz(mask);
+		return found < end ? (void*)found : NULL;
+	}
+
+	for (block += V::kSize; block < end; block += V::kSize) {
+		mask = V::Equal(V::Load(block), needle);
+		if (mask != 0) {
+			const uint8_t* found = block + __builtin_ctz(mask);
+			return found < end ? (void*)found : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+
+template<class V>
+int
+simd_memcmp(const void* _a, const void* _b, size_t length)
+{
+	const uint8_t* a = (const uint8_t*)_a;
+	const uint8_t* b = (const uint8_t*)_b;
+	size_t i = 0;
+
+	if (length >= V::kSize) {
+		for (; i + V::kSize <= length; i += V::kSize) {
+			uint32_t mask = V::Equal(V::LoadUnaligned(a + i),
+				V::LoadUnaligned(b + i)) ^ V::kFullMask;
+			if (mask != 0) {
+				i += __builtin_ctz(mask);
+				return a[i] - b[i];
+			}
+		}
+
+		if (i == length)
+			return 0;
+
+		// compare the rest as one block that overlaps the previous one
+		i = length - V::kSize;
+		uint32_t mask = V::Equal(V::LoadUnaligned(a + i),
+			V::LoadUnaligned(b + i)) ^ V::kFullMask;
+		if (mask != 0) {
+			i += __builtin_ctz(mask);
+			return a[i] - b[i];
+		}
+		return 0;
+	}
+
+	for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+		uint64_t valueA;
+		uint64_t valueB;
+		__builtin_memcpy(&valueA, a + i, sizeof(uint64_t));
+		__builtin_memcpy(&valueB, b + i, sizeof(uint64_t));
+		if (valueA != valueB) {
+			// the first differing byte decides in big endian order
+			valueA = __builtin_bswap64(valueA);
+			valueB = __builtin_bswap64(valueB);
+			return valueA < valueB ? -1 : 1;
+		}
+	}
+
+	for (; i < length; i++) {
+		if (a[i] != b[i])
+			return a[i] - b[i];
+	}
+
+	return 0;
+}
+
+
+template<class V>
+char*
+simd_strchr(const char* string, int c)
+{
+	const typename V::Type needle = V::Set(c);
+	const typename V::Type zero = V::Set(0);
+
+	uintptr_t offset = (uintptr_t)string & (V::kSize - 1);
+	const char* block = string - offset;
+	const char* base = string;
+
+	typename V::Type data = V::Load(block);
+	uint32_t mask
+		= (V::Equal(data, needle) | V::Equal(data, zero)) >> offset;
+
+	while (mask == 0) {
+		block += V::kSize;
+		base = block;
+		data = V::Load(block);
+		mask = V::Equal(data, needle) | V::Equal(data, zero);
+	}
+
+	const char* found = base + __builtin_ctz(mask);
+	return *found == (char)c ? (char*)found : NULL;
+}
+
+
+template<class V>
+char*
+simd_strrchr(const char* string, int c)
+{
+	if ((char)c == '\0')
+		return (char*)string + simd_strlen<V>(string);
+
+	const typename V::Type needle = V::Set(c);
+	const typename V::Type zero = V::Set(0);
+
+	uintptr_t offset = (uintptr_t)string & (V::kSize - 1);
+	const char* block = string - offset;
+	const char* base = string;
+	const char* last = NULL;
+
+	typename V::Type data = V::Load(block);
+	uint32_t matches = V::Equal(data, needle) >> offset;
+	uint32_t zeros = V::Equal(data, zero) >> offset;
+
+	while (true) {
+		if (zeros != 0) {
+			// ignore the matches after the end of the string
+			matches &= (zeros & (0 - zeros)) - 1;
+			if (matches != 0)
+				last = base + 31 - __builtin_clz(matches);
+			return (char*)last;
+		}
+
+		if (matches != 0)
+			last = base + 31 - __builtin_clz(matches);
+
+		block += V::kSize;
+		base = block;
+		data = V::Load(block);
+		matches = V::Equal(data, needle);
+		zeros = V::Equal(data, zero);
+	}
+}
+
+
+template<class V>
+int
+simd_strcmp(const char* _a, const char* _b)
+{
+	const uint8_t* a = (const uint8_t*)_a;
+	const uint8_t* b = (const uint8_t*)_b;
+	const typename V::Type zero = V::Set(0);
+
+	while (true) {
+		// The strings are usually not aligned the same way, so we use
+		// unaligned loads, unless one of them would cross into the next
+		// page, which might not be mapped.
+		if (crosses_page<V>(a) || crosses_page<V>(b)) {
+			for (size_t i = 0; i < V::kSize; i++) {
+				if (a[i] != b[i] || a[i] == '\0')
+					return a[i] - b[i];
+			}
+		} else {
+			typename V::Type dataA = V::LoadUnaligned(a);
+			uint32_t mask = (V::Equal(dataA, V::LoadUnaligned(b))
+				^ V::kFullMask) | V::Equal(dataA, zero);
+			if (mask != 0) {
+				size_t i = __builtin_ctz(mask);
+				return a[i] - b[i];
+			}
+		}
+
+		a += V::kSize;
+		b += V::kSize;
+	}
+}
+
+
+/*!	Looks for the first and the last byte of the needle at once for every
+	position in a block, and only compares the rest at positions where both
+	match.
+*/
+template<class V>
+void*
+simd_memmem(const void* _haystack, size_t haystackLength, const void* _needle,
+	size_t needleLength)
+{
+	const uint8_t* haystack = (const uint8_t*)_haystack;
+	const uint8_t* needle = (const uint8_t*)_needle;
+
+	if (needleLength == 0)
+		return (void*)haystack;
+	if (haystackLength < needleLength)
+		return NULL;
+	if (needleLength == 1)
+		return simd_memchr<V>(haystack, needle[0], haystackLength);
+
+	const typename V::Type first = V::Set(needle[0]);
+	const typename V::Type last = V::Set(needle[needleLength - 1]);
+
+	size_t i = 0;
+	for (; i + needleLength - 1 + V::kSize <= haystackLength; i += V::kSize) {
+		uint32_t mask = V::Equal(V::LoadUnaligned(haystack + i), first)
+			& V::Equal(V::LoadUnaligned(haystack + i + needleLength - 1),
+				last);
+		while (mask != 0) {
+			size_t position = i + __builtin_ctz(mask);
+			if (simd_memcmp<V>(haystack + position + 1, needle + 1,
+					needleLength - 2) == 0) {
+				return (void*)(haystack + position);
+			}
+			mask &= mask - 1;
+		}
+	}
+
+	for (; i + needleLength <= haystackLength; i++) {
+		if (haystack[i] == needle[0]
+			&& haystack[i + needleLength - 1] == needle[needleLength - 1]
+			&& simd_memcmp<V>(haystack + i + 1, needle + 1,
+				needleLength - 2) == 0) {
+			return (void*)(haystack + i);
+		}
+	}
+
+	return NULL;
+}
+
+
+/*!	Searches the haystack in chunks, so that its length does not have to be
+	known in advance.
+*/
+template<class V>
+char*
+simd_strstr(const char* haystack, const char* needle)
+{
+	static const size_t kChunkSize = 4096;
+
+	size_t needleLength = simd_strlen<V>(needle);
+	if (needleLength == 0)
+		return (char*)haystack;
+	if (needleLength == 1)
+		return simd_strchr<V>(haystack, needle[0]);
+
+	size_t searched = 0;
+	size_t length = 0;
+	while (true) {
+		size_t chunkLength = simd_strnlen<V>(haystack + length, kChunkSize);
+		length += chunkLength;
+
+		if (length >= needleLength) {
+			void* found = simd_memmem<V>(haystack + searched,
+				length - searched, needle, needleLength);
+			if (found != NULL)
+				return (char*)found;
+			searched = length - needleLength + 1;
+		}
+
+		if (chunkLength < kChunkSize)
+			return NULL;
+	}
+}
+
+
+}	// namespace
+
+
+#endif	// LIBROOT_STRING_X86_64_STRING_SIMD_H
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <emmintrin.h>
+
+#include "string_functions.h"
+#include "string_simd.h"
+
+
+namespace {
+
+
+struct SSE2Vector {
+	typedef __m128i Type;
+
+	static const size_t kSize = 16;
+	static const uint32_t kFullMask = 0xffff;
+
+	static inline Type Load(const void* address)
+	{
+		return _mm_load_si128((const __m128i*)address);
+	}
+
+	static inline Type LoadUnaligned(const void* address)
+	{
+		return _mm_loadu_si128((const __m128i*)address);
+	}
+
+	static inline Type Set(int c)
+	{
+		return _mm_set1_epi8((char)c);
+	}
+
+	static inline uint32_t Equal(Type a, Type b)
+	{
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+	}
+};
+
+
+}	// namespace
+
+
+const string_functions gStringFunctionsSSE2 = {
+	&simd_strlen<SSE2Vector>,
+	&simd_memchr<SSE2Vector>,
+	&simd_memcmp<SSE2Vector>,
+	&simd_strchr<SSE2Vector>,
+	&simd_strrchr<SSE2Vector>,
+	&simd_strcmp<SSE2Vector>,
+	&simd_memmem<SSE2Vector>,
+	&simd_strstr<SSE2Vector>
+};
@@ -1207,6 +1207,7 @@ void _kern_mount() {}
 void _kern_move_partition() {}
 void _kern_munlock() {}
 void _kern_mutex_lock() {}
+void _kern_mutex_lock_inherit() {}
 void _kern_mutex_sem_acquire() {}
 void _kern_mutex_sem_release() {}
 void _kern_mutex_switch_lock() {}
@@ -1272,6 +1273,7 @@ void _kern_select() {}
 void _kern_send() {}
 void _kern_send_data() {}
 void _kern_send_signal() {}
+void _kern_sendfile() {}
 void _kern_sendmsg() {}
 void _kern_sendto() {}
 void _kern_set_area_protection() {}
@@ -1292,6 +1294,7 @@ void _kern_set_sem_owner() {}
 void _kern_set_signal_mask() {}
 void _kern_set_signal_stack() {}
 void _kern_set_thread_affinity() {}
+void _kern_set_thread_deadline() {}
 void _kern_set_thread_priority() {}
 void _kern_set_timer() {}
 void _kern_set_timezone() {}
@@ -2412,6 +2415,7 @@ void semget() {}
 void semop() {}
 void send_data() {}
 void send_signal() {}
+void sendfile() {}
 void set_alarm() {}
 void set_area_protection() {}
 void set_dateformats() {}
@@ -2422,6 +2426,7 @@ void set_real_time_clock() {}
 void set_scheduler_mode() {}
 void set_sem_owner() {}
 void set_signal_stack() {}
+void set_thread_deadline() {}
 void set_thread_priority() {}
 void setbuf() {}
 void setbuffer() {}
@@ -1136,6 +1136,7 @@ void _kern_mount() {}
 void _kern_move_partition() {}
 void _kern_munlock() {}
 void _kern_mutex_lock() {}
+void _kern_mutex_lock_inherit() {}
 void _kern_mutex_sem_acquire() {}
 void _kern_mutex_sem_release() {}
 void _kern_mutex_switch_lock() {}
@@ -1201,6 +1202,7 @@ void _kern_select() {}
 void _kern_send() {}
 void _kern_send_data() {}
 void _kern_send_signal() {}
+void _kern_sendfile() {}
 void _kern_sendmsg() {}
 void _kern_sendto() {}
 void _kern_set_area_protection() {}
@@ -1221,6 +1223,7 @@ void _kern_set_sem_owner() {}
 void _kern_set_signal_mask() {}
 void _kern_set_signal_stack() {}
 void _kern_set_thread_affinity() {}
+void _kern_set_thread_deadline() {}
 void _kern_set_thread_priority() {}
 void _kern_set_timer() {}
 void _kern_set_timezone() {}
@@ -2390,6 +2393,7 @@ void send_authentication_request_to_registrar__8BPrivateRQ28BPrivate8KMessageT1(
 void send_data() {}
 void send_request_to_launch_daemon__8BPrivateRQ28BPrivate8KMessageT1() {}
 void send_signal() {}
+void sendfile() {}
 void setMbCurMax__Q38BPrivate7Libroot21LocaleCtypeDataBridgeUs() {}
 void set_alarm() {}
 void set_area_protection() {}
@@ -2403,6 +2407,7 @@ void set_registrar_authentication_port__8BPrivatel() {}
 void set_scheduler_mode() {}
 void set_sem_owner() {}
 void set_signal_stack() {}
+void set_thread_deadline() {}
 void set_terminate__FPFv_v() {}
 void set_thread_priority() {}
 void set_timezone() {}
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * This file may be used under the terms of the MIT License.
+ */
+
+
+/*!	Lets several threads create, fsync(), and unlink files in the same
+	directory, in order to measure how well the journal coalesces concurrent
+	log writes (group commit).
+	Use the "group_commit_latency" mount parameter to change the latency
+	window of the file system under test.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+extern const char* __progname;
+
+static const char* sDirectory = "/boot/home";
+static int32 sIterations = 1000;
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-t max-threads] [-n iterations] "
+		"[directory]\n"
+		"Creates, syncs, and removes files from the given number of threads "
+		"at the\nsame time. The directory defaults to %s.\n", __progname,
+		sDirectory);
+	exit(exitCode);
+}
+
+
+static void*
+worker(void* _index)
+{
+	int32 index = (int32)(addr_t)_index;
+	char path[B_PATH_NAME_LENGTH];
+
+	for (int32 i = 0; i < sIterations; i++) {
+		snprintf(path, sizeof(path), "%s/fsync-bench-%" B_PRId32 "-%" B_PRId32,
+			sDirectory, index, i);
+
+		int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+		if (fd < 0) {
+			fprintf(stderr, "%s: could not create \"%s\": %s\n", __progname,
+				path, strerror(errno));
+			return (void*)(addr_t)errno;
+		}
+
+		if (fsync(fd) != 0) {
+			fprintf(stderr, "%s: fsync failed: %s\n", __progname,
+				strerror(errno));
+		}
+		close(fd);
+
+		if (unlink(path) != 0) {
+			fprintf(stderr, "%s: could not remove \"%s\": %s\n", __progname,
+				path, strerror(errno));
+			return (void*)(addr_t)errno;
+		}
+	}
+
+	return NULL;
+}
+
+
+static bool
+run(int32 threadCount)
+{
+	pthread_t threads[threadCount];
+
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		if (pthread_create(&threads[i], NULL, &worker, (void*)(addr_t)i)
+				!= 0) {
+			fprintf(stderr, "%s: could not create thread\n", __progname);
+			threadCount = i;
+			break;
+		}
+	}
+
+	bool success = true;
+	for (int32 i = 0; i < threadCount; i++) {
+		void* result;
+		pthread_join(threads[i], &result);
+		if (result != NULL)
+			success = false;
+	}
+
+	bigtime_t time = system_time() - start;
+	int64 operations = (int64)threadCount * sIterations;
+
+	printf("%3" B_PRId32 " threads: %8" B_PRId64 " files in %6" B_PRId64
+		" ms, %8.1f files/s\n", threadCount, operations, time / 1000,
+		operations * 1000000.0 / time);
+
+	return success;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	system_info info;
+	get_system_info(&info);
+	int32 maxThreads = info.cpu_count * 4;
+
+	int option;
+	while ((option = getopt(argc, argv, "ht:n:")) != -1) {
+		switch (option) {
+			case 't':
+				maxThreads = strtol(optarg, NULL, 0);
+				break;
+			case 'n':
+				sIterations = strtol(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	if (optind < argc)
+		sDirectory = argv[optind];
+
+	if (maxThreads < 1 || sIterations < 1)
+		usage(1);
+
+	for (int32 threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+		if (!run(threadCount))
+			return 1;
+	}
+
+	return 0;
+}
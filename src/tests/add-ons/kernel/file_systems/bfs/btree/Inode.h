@@ -47,6 +47,8 @@ class Inode {
 		bool IsDirectory() const { return true; }
 		bool IsIndex() const { return is_index(Mode()); }
 
+		void WriteLockInTransaction(Transaction&) {}
+
 		void AssertReadLocked() { ASSERT_READ_LOCKED_RW_LOCK(&fLock); }
 		void AssertWriteLocked() { ASSERT_WRITE_LOCKED_RW_LOCK(&fLock); }
 
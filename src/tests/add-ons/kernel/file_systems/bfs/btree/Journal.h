@@ -57,6 +57,11 @@ class Transaction {
 			return fVolume;
 		}
 
+		bool HasParent() const
+		{
+			return false;
+		}
+
 		status_t WriteBlocks(off_t blockNumber, const uint8* buffer,
 			size_t numBlocks = 1)
 		{
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * This file may be used under the terms of the MIT License.
+ */
+
+
+/*!	Compares building a B+tree by inserting the keys one by one against
+	building it bottom-up via BPlusTree::BulkLoad(), and verifies that both
+	trees contain the same entries.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <List.h>
+#include <OS.h>
+
+#include "BPlusTree.h"
+#include "Inode.h"
+#include "Volume.h"
+
+
+struct tree_entry {
+	int64	key;
+	off_t	value;
+};
+
+// from cache.cpp
+extern BList gBlocks;
+
+static int32 sNumKeys = 1000000;
+static int32 sDuplicates = 1;
+
+
+static void
+usage(char* program)
+{
+	fprintf(stderr, "usage: %s [-n num-keys] [-d duplicates]\n"
+		"Builds an int64 index with the given number of keys, and every key\n"
+		"appearing about the given number of times, once using\n"
+		"BPlusTree::Insert(), and once using BPlusTree::BulkLoad().\n",
+		program);
+	exit(1);
+}
+
+
+static void
+reset_cache(Volume* volume)
+{
+	shutdown_cache(volume->Device(), volume->BlockSize());
+	gBlocks.MakeEmpty();
+}
+
+
+static void
+check_tree(BPlusTree& tree, Inode& inode, tree_entry* entries,
+	const char* name)
+{
+	bool errorsFound = false;
+	if (tree.Validate(false, errorsFound) != B_OK || errorsFound) {
+		fprintf(stderr, "%s: tree is corrupt!\n", name);
+		exit(1);
+	}
+
+	TreeIterator iterator(&tree);
+	int64 key;
+	uint16 keyLength;
+	off_t value;
+	int32 count = 0;
+	while (iterator.GetNextEntry(&key, &keyLength, sizeof(key), &value)
+			== B_OK) {
+		if (count >= sNumKeys || keyLength != sizeof(int64)
+			|| key != entries[count].key || value != entries[count].value) {
+			fprintf(stderr, "%s: entry %" B_PRId32 " does not match!\n", name,
+				count);
+			exit(1);
+		}
+		count++;
+	}
+	if (count != sNumKeys) {
+		fprintf(stderr, "%s: found %" B_PRId32 " of %" B_PRId32 " entries!\n",
+			name, count, sNumKeys);
+		exit(1);
+	}
+
+	printf("%s: %" B_PRId64 " nodes, %" B_PRId64 " bytes\n", name,
+		inode.Size() / tree.NodeSize(), inode.Size());
+}
+
+
+static int
+compare_entries(const void* _a, const void* _b)
+{
+	const tree_entry* a = (const tree_entry*)_a;
+	const tree_entry* b = (const tree_entry*)_b;
+
+	if (a->key != b->key)
+		return a->key < b->key ? -1 : 1;
+	if (a->value != b->value)
+		return a->value < b->value ? -1 : 1;
+	return 0;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	char* program = argv[0];
+
+	while (*++argv) {
+		char* arg = *argv;
+		if (*arg != '-' || arg[1] == '\0' || argv[1] == NULL)
+			usage(program);
+
+		switch (arg[1]) {
+			case 'n':
+				sNumKeys = strtol(*++argv, NULL, 0);
+				break;
+			case 'd':
+				sDuplicates = strtol(*++argv, NULL, 0);
+				break;
+			default:
+				usage(program);
+		}
+	}
+	if (sNumKeys < 1 || sDuplicates < 1)
+		usage(program);
+
+	tree_entry* entries = (tree_entry*)malloc(sNumKeys * sizeof(tree_entry));
+	if (entries == NULL) {
+		fprintf(stderr, "%s: out of memory\n", program);
+		return 1;
+	}
+
+	srand(42);
+	for (int32 i = 0; i < sNumKeys; i++) {
+		entries[i].key = ((int64)rand() << 16 ^ rand()) % (sNumKeys
+			/ sDuplicates + 1);
+		entries[i].value = i + 1;
+	}
+
+	// Insert the keys one by one
+
+	bigtime_t insertTime;
+	{
+		Inode inode("insert.data", S_LONG_LONG_INDEX | S_ALLOW_DUPS);
+		rw_lock_write_lock(&inode.Lock());
+		Volume* volume = inode.GetVolume();
+		Transaction transaction(volume, 0);
+		init_cache(volume->Device(), volume->BlockSize());
+
+		BPlusTree tree(transaction, &inode);
+		if (tree.InitCheck() != B_OK) {
+			fprintf(stderr, "%s: could not create tree\n", program);
+			return 1;
+		}
+
+		bigtime_t start = system_time();
+		for (int32 i = 0; i < sNumKeys; i++) {
+			status_t status = tree.Insert(transaction, entries[i].key,
+				entries[i].value);
+			if (status != B_OK) {
+				fprintf(stderr, "%s: insert failed: %s\n", program,
+					strerror(status));
+				return 1;
+			}
+		}
+		insertTime = system_time() - start;
+
+		transaction.Done();
+
+		qsort(entries, sNumKeys, sizeof(tree_entry), &compare_entries);
+		check_tree(tree, inode, entries, "insert");
+		reset_cache(volume);
+	}
+
+	// Bulk load the same keys in random order again
+
+	for (int32 i = sNumKeys; i-- > 1;) {
+		int32 j = rand() % (i + 1);
+		tree_entry temp = entries[i];
+		entries[i] = entries[j];
+		entries[j] = temp;
+	}
+
+	bigtime_t bulkTime;
+	{
+		Inode inode("bulk.data", S_LONG_LONG_INDEX | S_ALLOW_DUPS);
+		rw_lock_write_lock(&inode.Lock());
+		Volume* volume = inode.GetVolume();
+		Transaction transaction(volume, 0);
+		init_cache(volume->Device(), volume->BlockSize());
+
+		BPlusTree tree(transaction, &inode);
+		if (tree.InitCheck() != B_OK) {
+			fprintf(stderr, "%s: could not create tree\n", program);
+			return 1;
+		}
+
+		TreeLoader loader((size_t)sNumKeys * 32 + 1024 * 1024);
+
+		bigtime_t start = system_time();
+		for (int32 i = 0; i < sNumKeys; i++) {
+			status_t status = loader.Add((uint8*)&entries[i].key,
+				sizeof(int64), entries[i].value);
+			if (status != B_OK) {
+				fprintf(stderr, "%s: adding key failed: %s\n", program,
+					strerror(status));
+				return 1;
+			}
+		}
+
+		status_t status = tree.BulkLoad(transaction, loader);
+		if (status != B_OK) {
+			fprintf(stderr, "%s: bulk load failed: %s\n", program,
+				strerror(status));
+			return 1;
+		}
+		bulkTime = system_time() - start;
+
+		transaction.Done();
+
+		qsort(entries, sNumKeys, sizeof(tree_entry), &compare_entries);
+		check_tree(tree, inode, entries, "bulk load");
+		reset_cache(volume);
+	}
+
+	printf("%" B_PRId32 " keys: insert %" B_PRId64 " ms, bulk load %" B_PRId64
+		" ms (%.1fx)\n", sNumKeys, insertTime / 1000, bulkTime / 1000,
+		1.0 * insertTime / bulkTime);
+
+	free(entries);
+	return 0;
+}
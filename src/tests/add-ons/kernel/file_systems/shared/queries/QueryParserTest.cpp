@@ -4,6 +4,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #define DEBUG_QUERY
 #define PRINT(expr) printf expr
@@ -104,6 +105,12 @@ struct Query::QueryPolicy {
 		return 0;
 	}
 
+	static status_t IndexEstimateEntries(Index& index, const void* key,
+		size_t keyLength, off_t* _before, off_t* _equal, off_t* _total)
+	{
+		return B_NOT_SUPPORTED;
+	}
+
 	static type_code IndexGetType(Index& index)
 	{
 		return 0;
@@ -145,6 +152,11 @@ struct Query::QueryPolicy {
 		return B_OK;
 	}
 
+	static ino_t IndexIteratorGetNodeID(IndexIterator* indexIterator)
+	{
+		return 0;
+	}
+
 	static void IndexIteratorSkipDuplicates(IndexIterator* indexIterator)
 	{
 	}
@@ -191,6 +203,12 @@ struct Query::QueryPolicy {
 	{
 		return 0;
 	}
+
+	static status_t ContextGetEntry(Context* context, ino_t id,
+		NodeHolder& holder, Entry** _entry)
+	{
+		return B_NOT_SUPPORTED;
+	}
 };
 
 
@@ -232,18 +250,33 @@ Query::_Init(const char* queryString, uint32 flags, port_id port, uint32 token)
 }
 
 
-int
-main(int argc, char* argv[])
+static void
+parse_queries(int first, int argc, char* argv[], uint32 flags)
 {
-	for (int i = 1; i < argc; i++) {
+	for (int i = first; i < argc; i++) {
 		Query* query;
-		status_t error = Query::Create(NULL, argv[i], 0, 0, 0, query);
+		status_t error = Query::Create(NULL, argv[i], flags, 0, 0, query);
 		if (error != B_OK) {
-			fprintf(stderr, "Error creating query %d: %s\n", i - 1, strerror(error));
+			fprintf(stderr, "Error creating query %d: %s\n", i - first,
+				strerror(error));
 			continue;
 		}
 		delete query;
 	}
+}
+
+
+int
+main(int argc, char* argv[])
+{
+	// "-p" additionally parses all queries again, and dumps their plans
+	bool debugPlan = argc > 1 && strcmp(argv[1], "-p") == 0;
+	int first = debugPlan ? 2 : 1;
+
+	parse_queries(first, argc, argv, 0);
+
+	if (debugPlan)
+		parse_queries(first, argc, argv, B_QUERY_DEBUG_PLAN);
 
 	return 0;
 }
@@ -40,7 +40,10 @@ send_debug_message(team_id team, int32 code)
 void
 usage()
 {
-	fprintf(stderr, "usage: %s -[ab] <team-id> [...]\n", __progname);
+	fprintf(stderr, "usage: %s -[abl] [<team-id> ...]\n"
+		"  -a\tdump the allocator of the teams\n"
+		"  -b\tdump the bitmaps of the teams\n"
+		"  -l\tdump and reset the window lock statistics\n", __progname);
 	exit(1);
 }
 
@@ -53,15 +56,18 @@ main(int argc, char** argv)
 
 	bool dumpAllocator = false;
 	bool dumpBitmaps = false;
+	bool dumpLockStatistics = false;
 
 	int32 i = 1;
-	while (argv[i][0] == '-') {
+	while (i < argc && argv[i][0] == '-') {
 		const char* arg = &argv[i][1];
 		while (arg[0]) {
 			if (arg[0] == 'a')
 				dumpAllocator = true;
 			else if (arg[0] == 'b')
 				dumpBitmaps = true;
+			else if (arg[0] == 'l')
+				dumpLockStatistics = true;
 			else
 				usage();
 
@@ -81,5 +87,9 @@ main(int argc, char** argv)
 			send_debug_message(team, AS_DUMP_BITMAPS);
 	}
 
+	// the lock statistics are not per team
+	if (dumpLockStatistics)
+		send_debug_message(0, AS_DUMP_LOCK_STATISTICS);
+
 	return 0;
 }
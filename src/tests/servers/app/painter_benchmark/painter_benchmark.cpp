@@ -0,0 +1,346 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Draws large primitives with the Painter into a memory buffer, once on the
+	calling thread only, and once in tiles on all CPUs. Prints the throughput
+	of both, and how much their results differ.
+*/
+
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GradientRadial.h>
+#include <OS.h>
+#include <Region.h>
+
+#include "GlobalFontManager.h"
+#include "MallocBuffer.h"
+#include "Painter.h"
+#include "ServerBitmap.h"
+#include "TiledRenderer.h"
+
+
+extern const char* __progname;
+
+static const int32 kStarPoints = 200;
+
+static int32 sWidth = 1920;
+static int32 sHeight = 1200;
+static bigtime_t sDuration = 2000000;
+static UtilityBitmap* sBitmap;
+
+
+struct benchmark {
+	const char*	name;
+	void		(*draw)(Painter& painter, int32 iteration);
+};
+
+
+static BRect
+frame(int32 iteration)
+{
+	// move the primitive a bit, so that every iteration differs
+	BRect rect(0, 0, sWidth - 1, sHeight - 1);
+	rect.InsetBy(iteration % 16, iteration % 16);
+	return rect;
+}
+
+
+static rgb_color
+color(int32 iteration, uint8 alpha = 255)
+{
+	return make_color(iteration * 13, 255 - iteration * 7, 128, alpha);
+}
+
+
+static int32
+make_star(BPoint* points, int32 iteration)
+{
+	BRect rect = frame(iteration);
+	BPoint center((rect.left + rect.right) / 2, (rect.top + rect.bottom) / 2);
+
+	for (int32 i = 0; i < kStarPoints; i++) {
+		float angle = i * 2 * M_PI / kStarPoints;
+		float scale = i % 2 == 0 ? 0.5 : 0.35;
+		points[i].x = center.x + cosf(angle) * rect.Width() * scale;
+		points[i].y = center.y + sinf(angle) * rect.Height() * scale;
+	}
+	return kStarPoints;
+}
+
+
+static void
+fill_ellipse(Painter& painter, int32 iteration)
+{
+	painter.SetDrawingMode(B_OP_COPY);
+	painter.SetHighColor(color(iteration));
+	painter.DrawEllipse(frame(iteration), true);
+}
+
+
+static void
+blend_ellipse(Painter& painter, int32 iteration)
+{
+	painter.SetDrawingMode(B_OP_ALPHA);
+	painter.SetBlendingMode(B_CONSTANT_ALPHA, B_ALPHA_OVERLAY);
+	painter.SetHighColor(color(iteration, 128));
+	painter.DrawEllipse(frame(iteration), true);
+}
+
+
+static void
+fill_gradient(Painter& painter, int32 iteration)
+{
+	BRect rect = frame(iteration);
+	BGradientRadial gradient(rect.LeftTop() + BPoint(rect.Width() / 2,
+		rect.Height() / 2), rect.Width() / 2);
+	gradient.AddColor(color(iteration), 0);
+	gradient.AddColor(color(iteration + 10), 255);
+
+	painter.SetDrawingMode(B_OP_COPY);
+	painter.FillEllipse(rect, gradient);
+}
+
+
+static void
+fill_polygon(Painter& painter, int32 iteration)
+{
+	BPoint points[kStarPoints];
+	int32 count = make_star(points, iteration);
+
+	painter.SetDrawingMode(B_OP_COPY);
+	painter.SetHighColor(color(iteration));
+	painter.DrawPolygon(points, count, true, true);
+}
+
+
+static void
+stroke_polygon(Painter& painter, int32 iteration)
+{
+	BPoint points[kStarPoints];
+	int32 count = make_star(points, iteration);
+
+	painter.SetDrawingMode(B_OP_COPY);
+	painter.SetHighColor(color(iteration));
+	painter.SetPenSize(8);
+	painter.DrawPolygon(points, count, false, true);
+	painter.SetPenSize(1);
+}
+
+
+static void
+scale_bitmap(Painter& painter, int32 iteration)
+{
+	// B_OP_OVER is not handled by the specialized bilinear scaler
+	painter.SetDrawingMode(B_OP_OVER);
+	painter.DrawBitmap(sBitmap, sBitmap->Bounds(), frame(iteration),
+		B_FILTER_BITMAP_BILINEAR);
+}
+
+
+static const benchmark kBenchmarks[] = {
+	{ "fill", &fill_ellipse },
+	{ "blend", &blend_ellipse },
+	{ "gradient", &fill_gradient },
+	{ "polygon", &fill_polygon },
+	{ "stroke", &stroke_polygon },
+	{ "bitmap", &scale_bitmap },
+};
+static const int32 kBenchmarkCount
+	= sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
+
+
+static UtilityBitmap*
+create_bitmap()
+{
+	UtilityBitmap* bitmap = new UtilityBitmap(BRect(0, 0, 255, 255), B_RGBA32,
+		0);
+	if (bitmap->Bits() == NULL)
+		return NULL;
+
+	for (int32 y = 0; y < 256; y++) {
+		uint8* bits = bitmap->Bits() + y * bitmap->BytesPerRow();
+		for (int32 x = 0; x < 256; x++) {
+			bits[0] = x;
+			bits[1] = y;
+			bits[2] = x ^ y;
+			bits[3] = (x / 32 + y / 32) % 2 == 0 ? 255 : 96;
+			bits += 4;
+		}
+	}
+	return bitmap;
+}
+
+
+static void
+clear(MallocBuffer& buffer)
+{
+	memset(buffer.Bits(), 0, buffer.BytesPerRow() * buffer.Height());
+}
+
+
+static double
+run(Painter& painter, const benchmark& test, bool tiled)
+{
+	painter.SetTiledRendering(tiled);
+
+	int32 iterations = 0;
+	bigtime_t start = system_time();
+	bigtime_t elapsed;
+	do {
+		test.draw(painter, iterations++);
+		elapsed = system_time() - start;
+	} while (elapsed < sDuration);
+
+	return iterations * 1000000.0 / elapsed;
+}
+
+
+/*!	Draws the first iteration of \a test once serially and once in tiles,
+	and counts the pixels that differ. Tile borders may be anti-aliased a
+	tiny bit differently.
+*/
+static void
+compare(Painter& painter, MallocBuffer& buffer, const benchmark& test,
+	int32& differentPixels, int32& maxDifference)
+{
+	size_t size = buffer.BytesPerRow() * buffer.Height();
+	uint8* serial = (uint8*)malloc(size);
+	if (serial == NULL) {
+		differentPixels = -1;
+		return;
+	}
+
+	clear(buffer);
+	painter.SetTiledRendering(false);
+	test.draw(painter, 0);
+	memcpy(serial, buffer.Bits(), size);
+
+	clear(buffer);
+	painter.SetTiledRendering(true);
+	test.draw(painter, 0);
+
+	const uint8* tiled = (const uint8*)buffer.Bits();
+	differentPixels = 0;
+	maxDifference = 0;
+	for (size_t i = 0; i < size; i += 4) {
+		int32 difference = 0;
+		for (int32 channel = 0; channel < 4; channel++) {
+			difference = max_c(difference,
+				abs(serial[i + channel] - tiled[i + channel]));
+		}
+		if (difference > 0)
+			differentPixels++;
+		maxDifference = max_c(maxDifference, difference);
+	}
+
+	free(serial);
+}
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-w width] [-h height] [-d seconds] "
+		"[benchmark ...]\nBenchmarks:", __progname);
+	for (int32 i = 0; i < kBenchmarkCount; i++)
+		fprintf(stderr, " %s", kBenchmarks[i].name);
+	fprintf(stderr, "\n");
+	exit(exitCode);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int option;
+	while ((option = getopt(argc, argv, "w:h:d:")) != -1) {
+		switch (option) {
+			case 'w':
+				sWidth = strtol(optarg, NULL, 0);
+				break;
+			case 'h':
+				sHeight = strtol(optarg, NULL, 0);
+				break;
+			case 'd':
+				sDuration = strtol(optarg, NULL, 0) * 1000000LL;
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	if (sWidth < 64 || sHeight < 64 || sDuration <= 0)
+		usage(1);
+
+	for (int32 arg = optind; arg < argc; arg++) {
+		bool found = false;
+		for (int32 i = 0; i < kBenchmarkCount; i++) {
+			if (strcmp(argv[arg], kBenchmarks[i].name) == 0)
+				found = true;
+		}
+		if (!found)
+			usage(1);
+	}
+
+	// the Painter's text renderer needs the default font
+	gFontManager = new GlobalFontManager;
+	if (gFontManager->InitCheck() != B_OK) {
+		fprintf(stderr, "%s: could not initialize the font manager\n",
+			__progname);
+		return 1;
+	}
+
+	sBitmap = create_bitmap();
+	MallocBuffer buffer(sWidth, sHeight);
+	if (sBitmap == NULL || buffer.InitCheck() != B_OK) {
+		fprintf(stderr, "%s: out of memory\n", __progname);
+		return 1;
+	}
+
+	BRegion clipping(BRect(0, 0, sWidth - 1, sHeight - 1));
+
+	Painter painter;
+	painter.AttachToBuffer(&buffer);
+	painter.ConstrainClipping(&clipping);
+
+	TiledRenderer* renderer = TiledRenderer::Default();
+	printf("%" B_PRId32 "x%" B_PRId32 " pixels, %" B_PRId32 " threads\n",
+		sWidth, sHeight, renderer != NULL ? renderer->CountThreads() : 1);
+	printf("benchmark      serial/s    tiled/s  speedup  differing pixels\n");
+
+	for (int32 i = 0; i < kBenchmarkCount; i++) {
+		const benchmark& test = kBenchmarks[i];
+
+		bool selected = optind == argc;
+		for (int32 arg = optind; arg < argc; arg++) {
+			if (strcmp(argv[arg], test.name) == 0)
+				selected = true;
+		}
+		if (!selected)
+			continue;
+
+		int32 differentPixels;
+		int32 maxDifference;
+		compare(painter, buffer, test, differentPixels, maxDifference);
+
+		double serial = run(painter, test, false);
+		double tiled = run(painter, test, true);
+
+		printf("%-12s %10.1f %10.1f %7.2fx  %" B_PRId32 " (max. %" B_PRId32
+			")\n", test.name, serial, tiled, tiled / serial, differentPixels,
+			maxDifference);
+	}
+
+	painter.DetachFromBuffer();
+	sBitmap->ReleaseReference();
+	return 0;
+}
@@ -0,0 +1,550 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares the vectorized drawing mode functions of the app_server against
+	the scalar ones they replace, and measures their throughput.
+
+	Every kernel set the CPU supports is tested on random spans, and the
+	resulting pixels have to be exactly the same, including those around the
+	span. The covers and colors are placed right in front of an inaccessible
+	page, so that reading beyond their end is caught as well.
+*/
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cpuid.h>
+
+#include "DrawingModeAlphaCOSolid.h"
+#include "DrawingModeAlphaCOSolidSUBPIX.h"
+#include "DrawingModeAlphaPOSolid.h"
+#include "DrawingModeAlphaPOSolidSUBPIX.h"
+#include "DrawingModeCopySolid.h"
+#include "DrawingModeCopySolidSUBPIX.h"
+#include "DrawingModeOverSolid.h"
+#include "DrawingModeOverSolidSUBPIX.h"
+
+#include "DrawingModeSIMD.h"
+
+
+// the app_server sets this up in the Painter
+const blend_kernels* gBlendKernels;
+
+extern const char* __progname;
+
+static const unsigned kMaxLength = 256;
+static const unsigned kWidth = kMaxLength + 16;
+static const unsigned kBenchmarkLength = 1024;
+
+struct implementation {
+	const char*				name;
+	const blend_kernels*	kernels;
+};
+
+struct line_function {
+	const char*				name;
+	PixelFormat::blend_line	scalar;
+	PixelFormat::blend_line	simd;
+};
+
+struct solid_span_function {
+	const char*						name;
+	PixelFormat::blend_solid_span	scalar;
+	PixelFormat::blend_solid_span	simd;
+	bool							subpixel;
+};
+
+struct color_span_function {
+	const char*						name;
+	PixelFormat::blend_color_span	scalar;
+	PixelFormat::blend_color_span	simd;
+};
+
+static const line_function kLineFunctions[] = {
+	{ "hline_copy_solid", &blend_hline_copy_solid,
+		&blend_hline_copy_solid_simd },
+	{ "hline_over_solid", &blend_hline_over_solid,
+		&blend_hline_over_solid_simd },
+};
+
+static const solid_span_function kSolidSpanFunctions[] = {
+	{ "solid_hspan_copy_solid", &blend_solid_hspan_copy_solid,
+		&blend_solid_hspan_copy_solid_simd, false },
+	{ "solid_hspan_over_solid", &blend_solid_hspan_over_solid,
+		&blend_solid_hspan_over_solid_simd, false },
+	{ "solid_hspan_alpha_co_solid", &blend_solid_hspan_alpha_co_solid,
+		&blend_solid_hspan_alpha_co_solid_simd, false },
+	{ "solid_hspan_alpha_po_solid", &blend_solid_hspan_alpha_po_solid,
+		&blend_solid_hspan_alpha_po_solid_simd, false },
+	{ "solid_hspan_copy_solid_subpix", &blend_solid_hspan_copy_solid_subpix,
+		&blend_solid_hspan_copy_solid_subpix_simd, true },
+	{ "solid_hspan_over_solid_subpix", &blend_solid_hspan_over_solid_subpix,
+		&blend_solid_hspan_over_solid_subpix_simd, true },
+	{ "solid_hspan_alpha_co_solid_subpix",
+		&blend_solid_hspan_alpha_co_solid_subpix,
+		&blend_solid_hspan_alpha_co_solid_subpix_simd, true },
+	{ "solid_hspan_alpha_po_solid_subpix",
+		&blend_solid_hspan_alpha_po_solid_subpix,
+		&blend_solid_hspan_alpha_po_solid_subpix_simd, true },
+};
+
+static const color_span_function kColorSpanFunctions[] = {
+	{ "color_hspan_copy_solid", &blend_color_hspan_copy_solid,
+		&blend_color_hspan_copy_solid_simd },
+	{ "color_hspan_over", &blend_color_hspan_over,
+		&blend_color_hspan_over_simd },
+	{ "color_hspan_alpha_po", &blend_color_hspan_alpha_po,
+		&blend_color_hspan_alpha_po_simd },
+};
+
+#define COUNT_OF(array) (sizeof(array) / sizeof(array[0]))
+
+static implementation sImplementations[2];
+static int sImplementationCount;
+static int sErrors;
+static unsigned sSeed;
+
+static size_t sPageSize;
+static uint8* sCovers;
+static color_type* sColors;
+
+static uint8 sScalarBits[kWidth * 4];
+static uint8 sSIMDBits[kWidth * 4];
+static agg_buffer sScalarBuffer;
+static agg_buffer sSIMDBuffer;
+
+
+static bool
+cpu_supports_sse2()
+{
+#ifdef __x86_64__
+	return true;
+#else
+	uint32_t eax, ebx, ecx, edx;
+	return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0
+		&& (edx & bit_SSE2) != 0;
+#endif
+}
+
+
+static bool
+cpu_supports_avx2()
+{
+	uint32_t eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0
+		|| (ecx & bit_OSXSAVE) == 0 || (ecx & bit_AVX) == 0)
+		return false;
+
+	uint32_t xcr0Low, xcr0High;
+	asm volatile("xgetbv" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0));
+	if ((xcr0Low & 0x6) != 0x6 || __get_cpuid_max(0, NULL) < 7)
+		return false;
+
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return (ebx & bit_AVX2) != 0;
+}
+
+
+/*!	Returns a buffer of \a size bytes that ends right in front of an
+	inaccessible page.
+*/
+static uint8*
+guarded_buffer(size_t size)
+{
+	size_t pages = (size + sPageSize - 1) / sPageSize;
+	uint8* area = (uint8*)mmap(NULL, (pages + 1) * sPageSize,
+		PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (area == MAP_FAILED)
+		return NULL;
+
+	mprotect(area + pages * sPageSize, sPageSize, PROT_NONE);
+	return area + pages * sPageSize - size;
+}
+
+
+/*!	Returns a random value that is 0 or 255 more often than not, as those
+	take shortcuts in the drawing modes.
+*/
+static uint8
+random_value()
+{
+	switch (rand() % 4) {
+		case 0:
+			return 0;
+		case 1:
+			return 255;
+		default:
+			return rand();
+	}
+}
+
+
+static rgb_color
+random_color()
+{
+	return make_color(rand(), rand(), rand(), random_value());
+}
+
+
+/*!	Fills the lines of both buffers with the same random pixels. */
+static void
+randomize_bits()
+{
+	for (unsigned i = 0; i < sizeof(sScalarBits); i += 4) {
+		sScalarBits[i + 0] = rand();
+		sScalarBits[i + 1] = rand();
+		sScalarBits[i + 2] = rand();
+		sScalarBits[i + 3] = random_value();
+	}
+	memcpy(sSIMDBits, sScalarBits, sizeof(sScalarBits));
+}
+
+
+/*!	Returns the \a count covers at the end of the guarded buffer. */
+static const uint8*
+random_covers(unsigned count)
+{
+	uint8* covers = sCovers + kMaxLength * 3 - count;
+	for (unsigned i = 0; i < count; i++)
+		covers[i] = random_value();
+	return covers;
+}
+
+
+/*!	Returns the \a count colors at the end of the guarded buffer. */
+static const color_type*
+random_colors(unsigned count)
+{
+	color_type* colors = sColors + kMaxLength - count;
+	for (unsigned i = 0; i < count; i++) {
+		colors[i] = color_type(rand() & 0xff, rand() & 0xff, rand() & 0xff,
+			random_value());
+	}
+	return colors;
+}
+
+
+static void
+random_pattern(PatternHandler& pattern)
+{
+	pattern.SetColors(random_color(), random_color());
+	pattern.SetPattern(rand() % 8 == 0 ? B_SOLID_LOW : B_SOLID_HIGH);
+}
+
+
+/*!	The subpixel kernels are left out where they would be slower than the
+	scalar code, the app_server does not use those functions then.
+*/
+static bool
+supports(const implementation& implementation,
+	const solid_span_function& function)
+{
+	return !function.subpixel
+		|| implementation.kernels->blend_subpixel != NULL;
+}
+
+
+static void
+check(const implementation& implementation, const char* function,
+	unsigned x, unsigned length)
+{
+	if (memcmp(sScalarBits, sSIMDBits, sizeof(sScalarBits)) == 0)
+		return;
+
+	if (sErrors++ >= 20)
+		return;
+
+	unsigned pixel = 0;
+	while (memcmp(sScalarBits + pixel * 4, sSIMDBits + pixel * 4, 4) == 0)
+		pixel++;
+
+	const uint8* expected = sScalarBits + pixel * 4;
+	const uint8* got = sSIMDBits + pixel * 4;
+	fprintf(stderr, "%s: %s %s() failed, x %u, length %u, seed %u: pixel %u "
+		"is %02x%02x%02x%02x, expected %02x%02x%02x%02x\n", __progname,
+		implementation.name, function, x, length, sSeed, pixel, got[3], got[2],
+		got[1], got[0], expected[3], expected[2], expected[1], expected[0]);
+}
+
+
+static void
+fuzz(const implementation& implementation, int rounds)
+{
+	gBlendKernels = implementation.kernels;
+
+	PatternHandler pattern;
+
+	for (int round = 0; round < rounds; round++) {
+		unsigned length = 1 + rand() % kMaxLength;
+		unsigned x = rand() % (kWidth - length + 1);
+		gSubpixelOrderingRGB = (rand() & 1) != 0;
+		random_pattern(pattern);
+
+		rgb_color highColor = pattern.HighColor();
+		color_type color(highColor.red, highColor.green, highColor.blue,
+			highColor.alpha);
+		uint8 cover = random_value();
+
+		for (size_t i = 0; i < COUNT_OF(kLineFunctions); i++) {
+			const line_function& function = kLineFunctions[i];
+
+			randomize_bits();
+			function.scalar(x, 0, length, color, cover, &sScalarBuffer,
+				&pattern);
+			function.simd(x, 0, length, color, cover, &sSIMDBuffer, &pattern);
+			check(implementation, function.name, x, length);
+		}
+
+		for (size_t i = 0; i < COUNT_OF(kSolidSpanFunctions); i++) {
+			const solid_span_function& function = kSolidSpanFunctions[i];
+			if (!supports(implementation, function))
+				continue;
+
+			unsigned count = function.subpixel ? length * 3 : length;
+			const uint8* covers = random_covers(count);
+
+			randomize_bits();
+			function.scalar(x, 0, count, color, covers, &sScalarBuffer,
+				&pattern);
+			function.simd(x, 0, count, color, covers, &sSIMDBuffer, &pattern);
+			check(implementation, function.name, x, length);
+		}
+
+		for (size_t i = 0; i < COUNT_OF(kColorSpanFunctions); i++) {
+			const color_span_function& function = kColorSpanFunctions[i];
+			const color_type* colors = random_colors(length);
+			const uint8* covers = rand() % 3 == 0
+				? NULL : random_covers(length);
+
+			randomize_bits();
+			function.scalar(x, 0, length, colors, covers, cover,
+				&sScalarBuffer, &pattern);
+			function.simd(x, 0, length, colors, covers, cover, &sSIMDBuffer,
+				&pattern);
+			check(implementation, function.name, x, length);
+		}
+	}
+}
+
+
+static double
+now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1000000000.0;
+}
+
+
+/*!	Runs \a draw until a quarter of a second has passed, and returns the
+	number of pixels it processed per second.
+*/
+template<typename Draw>
+static double
+measure(Draw draw)
+{
+	uint64_t pixels = 0;
+	double start = now();
+	double elapsed;
+	do {
+		for (int i = 0; i < 1000; i++)
+			draw();
+		pixels += 1000 * kBenchmarkLength;
+		elapsed = now() - start;
+	} while (elapsed < 0.25);
+
+	return pixels / elapsed;
+}
+
+
+static void
+print_result(const char* function, const char* implementation,
+	double pixelsPerSecond, double scalarPixelsPerSecond)
+{
+	printf("%-34s %-6s %10.1f %7.2fx\n", function, implementation,
+		pixelsPerSecond / 1000000, pixelsPerSecond / scalarPixelsPerSecond);
+}
+
+
+static void
+benchmark()
+{
+	uint8* bits = (uint8*)malloc(kBenchmarkLength * 4);
+	uint8* covers = (uint8*)malloc(kBenchmarkLength * 3);
+	color_type* colors
+		= (color_type*)malloc(kBenchmarkLength * sizeof(color_type));
+	if (bits == NULL || covers == NULL || colors == NULL) {
+		fprintf(stderr, "%s: out of memory\n", __progname);
+		exit(1);
+	}
+
+	// anti-aliased edges on both ends, and mostly opaque pixels in between
+	for (unsigned i = 0; i < kBenchmarkLength * 3; i++)
+		covers[i] = i < 16 || i >= kBenchmarkLength * 3 - 16 ? i * 16 : 255;
+	for (unsigned i = 0; i < kBenchmarkLength; i++)
+		colors[i] = color_type(i, i * 3, i * 7, i % 64 == 0 ? 128 : 255);
+	memset(bits, 0x80, kBenchmarkLength * 4);
+
+	agg_buffer buffer(bits, kBenchmarkLength, 1, kBenchmarkLength * 4);
+	color_type color(40, 80, 120, 160);
+
+	PatternHandler pattern;
+	pattern.SetHighColor(make_color(40, 80, 120, 160));
+
+	printf("%-34s %-6s %10s %8s\n", "function", "impl", "Mpixels/s",
+		"speedup");
+
+	for (size_t i = 0; i < COUNT_OF(kLineFunctions); i++) {
+		const line_function& function = kLineFunctions[i];
+		double scalar = measure([&]() {
+			function.scalar(0, 0, kBenchmarkLength, color, 128, &buffer,
+				&pattern);
+		});
+		print_result(function.name, "scalar", scalar, scalar);
+
+		for (int j = 0; j < sImplementationCount; j++) {
+			gBlendKernels = sImplementations[j].kernels;
+			double simd = measure([&]() {
+				function.simd(0, 0, kBenchmarkLength, color, 128, &buffer,
+					&pattern);
+			});
+			print_result(function.name, sImplementations[j].name, simd,
+				scalar);
+		}
+	}
+
+	for (size_t i = 0; i < COUNT_OF(kSolidSpanFunctions); i++) {
+		const solid_span_function& function = kSolidSpanFunctions[i];
+		unsigned count = function.subpixel
+			? kBenchmarkLength * 3 : kBenchmarkLength;
+
+		double scalar = measure([&]() {
+			function.scalar(0, 0, count, color, covers, &buffer, &pattern);
+		});
+		print_result(function.name, "scalar", scalar, scalar);
+
+		for (int j = 0; j < sImplementationCount; j++) {
+			if (!supports(sImplementations[j], function))
+				continue;
+
+			gBlendKernels = sImplementations[j].kernels;
+			double simd = measure([&]() {
+				function.simd(0, 0, count, color, covers, &buffer, &pattern);
+			});
+			print_result(function.name, sImplementations[j].name, simd,
+				scalar);
+		}
+	}
+
+	for (size_t i = 0; i < COUNT_OF(kColorSpanFunctions); i++) {
+		const color_span_function& function = kColorSpanFunctions[i];
+		double scalar = measure([&]() {
+			function.scalar(0, 0, kBenchmarkLength, colors, covers, 255,
+				&buffer, &pattern);
+		});
+		print_result(function.name, "scalar", scalar, scalar);
+
+		for (int j = 0; j < sImplementationCount; j++) {
+			gBlendKernels = sImplementations[j].kernels;
+			double simd = measure([&]() {
+				function.simd(0, 0, kBenchmarkLength, colors, covers, 255,
+					&buffer, &pattern);
+			});
+			print_result(function.name, sImplementations[j].name, simd,
+				scalar);
+		}
+	}
+
+	free(bits);
+	free(covers);
+	free(colors);
+}
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-b] [-r rounds] [-s seed]\n"
+		"  -b  measures the throughput instead of comparing the results\n",
+		__progname);
+	exit(exitCode);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	bool runBenchmark = false;
+	int rounds = 5000;
+	sSeed = time(NULL);
+
+	int option;
+	while ((option = getopt(argc, argv, "hbr:s:")) != -1) {
+		switch (option) {
+			case 'b':
+				runBenchmark = true;
+				break;
+			case 'r':
+				rounds = strtol(optarg, NULL, 0);
+				break;
+			case 's':
+				sSeed = strtoul(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	srand(sSeed);
+	sPageSize = sysconf(_SC_PAGESIZE);
+
+	if (cpu_supports_sse2()) {
+		sImplementations[sImplementationCount++]
+			= { "SSE2", &gBlendKernelsSSE2 };
+	} else
+		printf("SSE2 is not supported, skipping it.\n");
+	if (cpu_supports_avx2()) {
+		sImplementations[sImplementationCount++]
+			= { "AVX2", &gBlendKernelsAVX2 };
+	} else
+		printf("AVX2 is not supported, skipping it.\n");
+
+	if (runBenchmark) {
+		benchmark();
+		return 0;
+	}
+
+	sCovers = guarded_buffer(kMaxLength * 3);
+	sColors = (color_type*)guarded_buffer(kMaxLength * sizeof(color_type));
+	if (sCovers == NULL || sColors == NULL) {
+		fprintf(stderr, "%s: out of memory\n", __progname);
+		return 1;
+	}
+
+	sScalarBuffer.attach(sScalarBits, kWidth, 1, kWidth * 4);
+	sSIMDBuffer.attach(sSIMDBits, kWidth, 1, kWidth * 4);
+
+	for (int i = 0; i < sImplementationCount; i++)
+		fuzz(sImplementations[i], rounds);
+
+	if (sErrors != 0) {
+		fprintf(stderr, "%s: %d errors\n", __progname, sErrors);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Draws text with the Painter into memory buffers, once on a single thread,
+	and once on as many threads as there are CPUs, all of them using the same
+	font. Prints the glyph throughput of both.
+*/
+
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+#include <Region.h>
+
+#include "GlobalFontManager.h"
+#include "MallocBuffer.h"
+#include "Painter.h"
+#include "ServerFont.h"
+
+
+extern const char* __progname;
+
+static const char* kText = "The quick brown fox jumps over the lazy dog. "
+	"0123456789 THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG!";
+
+// more different sizes than the font cache keeps entries for
+static const int32 kUncachedSizes = 48;
+
+static int32 sWidth = 800;
+static int32 sHeight = 600;
+static bigtime_t sDuration = 2000000;
+
+
+struct benchmark {
+	const char*	name;
+	void		(*setup)(ServerFont& font, int32 iteration);
+};
+
+
+struct thread_data {
+	const benchmark*	test;
+	MallocBuffer*		buffer;
+	int64				glyphs;
+	status_t			status;
+};
+
+
+static void
+cached_text(ServerFont& font, int32 iteration)
+{
+	font.SetSize(12);
+	font.SetSpacing(B_BITMAP_SPACING);
+}
+
+
+static void
+kerned_text(ServerFont& font, int32 iteration)
+{
+	font.SetSize(12);
+	font.SetSpacing(B_STRING_SPACING);
+}
+
+
+static void
+uncached_text(ServerFont& font, int32 iteration)
+{
+	// every size needs its own font cache entry, and all of its glyphs are
+	// rendered again
+	font.SetSize(8 + (iteration % kUncachedSizes) / 2.0);
+	font.SetSpacing(B_BITMAP_SPACING);
+}
+
+
+static const benchmark kBenchmarks[] = {
+	{ "cached", &cached_text },
+	{ "kerning", &kerned_text },
+	{ "uncached", &uncached_text },
+};
+static const int32 kBenchmarkCount
+	= sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
+
+
+static status_t
+draw_text(void* _data)
+{
+	thread_data& data = *(thread_data*)_data;
+	data.glyphs = 0;
+
+	BRegion clipping(BRect(0, 0, sWidth - 1, sHeight - 1));
+	ServerFont font;
+	uint32 length = strlen(kText);
+
+	Painter painter;
+	painter.AttachToBuffer(data.buffer);
+	painter.ConstrainClipping(&clipping);
+	painter.SetDrawingMode(B_OP_OVER);
+	painter.SetHighColor(make_color(0, 0, 0, 255));
+
+	int32 iteration = 0;
+	bigtime_t start = system_time();
+	do {
+		data.test->setup(font, iteration);
+		painter.SetFont(font);
+
+		// move the text a bit, so that every iteration differs
+		BPoint baseLine(iteration % 16, 0);
+		while (baseLine.y < sHeight) {
+			baseLine.y += font.Size() + 2;
+			painter.DrawString(kText, length, baseLine, NULL);
+			data.glyphs += length;
+		}
+		iteration++;
+	} while (system_time() - start < sDuration);
+
+	painter.DetachFromBuffer();
+	return B_OK;
+}
+
+
+/*!	Runs \a test on \a threadCount threads at the same time, and returns the
+	number of glyphs drawn per second by all of them, or a negative value on
+	error.
+*/
+static double
+run(const benchmark& test, thread_data* data, int32 threadCount)
+{
+	thread_id threads[B_MAX_CPU_COUNT];
+	for (int32 i = 0; i < threadCount; i++) {
+		data[i].test = &test;
+		threads[i] = spawn_thread(&draw_text, "draw text", B_NORMAL_PRIORITY,
+			&data[i]);
+		if (threads[i] < 0)
+			return -1;
+	}
+
+	bigtime_t start = system_time();
+	for (int32 i = 0; i < threadCount; i++)
+		resume_thread(threads[i]);
+
+	int64 glyphs = 0;
+	for (int32 i = 0; i < threadCount; i++) {
+		wait_for_thread(threads[i], &data[i].status);
+		glyphs += data[i].glyphs;
+	}
+
+	return glyphs * 1000000.0 / (system_time() - start);
+}
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-w width] [-h height] [-d seconds] "
+		"[-t threads] [benchmark ...]\nBenchmarks:", __progname);
+	for (int32 i = 0; i < kBenchmarkCount; i++)
+		fprintf(stderr, " %s", kBenchmarks[i].name);
+	fprintf(stderr, "\n");
+	exit(exitCode);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	system_info info;
+	get_system_info(&info);
+	int32 threadCount = info.cpu_count;
+
+	int option;
+	while ((option = getopt(argc, argv, "w:h:d:t:")) != -1) {
+		switch (option) {
+			case 'w':
+				sWidth = strtol(optarg, NULL, 0);
+				break;
+			case 'h':
+				sHeight = strtol(optarg, NULL, 0);
+				break;
+			case 'd':
+				sDuration = strtol(optarg, NULL, 0) * 1000000LL;
+				break;
+			case 't':
+				threadCount = strtol(optarg, NULL, 0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	if (sWidth < 64 || sHeight < 64 || sDuration <= 0 || threadCount < 1
+		|| threadCount > B_MAX_CPU_COUNT)
+		usage(1);
+
+	for (int32 arg = optind; arg < argc; arg++) {
+		bool found = false;
+		for (int32 i = 0; i < kBenchmarkCount; i++) {
+			if (strcmp(argv[arg], kBenchmarks[i].name) == 0)
+				found = true;
+		}
+		if (!found)
+			usage(1);
+	}
+
+	gFontManager = new GlobalFontManager;
+	if (gFontManager->InitCheck() != B_OK) {
+		fprintf(stderr, "%s: could not initialize the font manager\n",
+			__progname);
+		return 1;
+	}
+
+	// every thread draws into its own buffer
+	MallocBuffer* buffers[B_MAX_CPU_COUNT];
+	thread_data data[B_MAX_CPU_COUNT];
+	for (int32 i = 0; i < threadCount; i++) {
+		buffers[i] = new MallocBuffer(sWidth, sHeight);
+		if (buffers[i]->InitCheck() != B_OK) {
+			fprintf(stderr, "%s: out of memory\n", __progname);
+			return 1;
+		}
+		data[i].buffer = buffers[i];
+	}
+
+	printf("%" B_PRId32 "x%" B_PRId32 " pixels, %" B_PRId32 " threads\n",
+		sWidth, sHeight, threadCount);
+	printf("benchmark    1 thread glyphs/s  all glyphs/s  speedup\n");
+
+	for (int32 i = 0; i < kBenchmarkCount; i++) {
+		const benchmark& test = kBenchmarks[i];
+
+		bool selected = optind == argc;
+		for (int32 arg = optind; arg < argc; arg++) {
+			if (strcmp(argv[arg], test.name) == 0)
+				selected = true;
+		}
+		if (!selected)
+			continue;
+
+		double single = run(test, data, 1);
+		double all = run(test, data, threadCount);
+		if (single <= 0 || all <= 0) {
+			fprintf(stderr, "%s: could not start the drawing threads\n",
+				__progname);
+			return 1;
+		}
+
+		printf("%-12s %19.0f %13.0f %7.2fx\n", test.name, single, all,
+			all / single);
+	}
+
+	for (int32 i = 0; i < threadCount; i++)
+		delete buffers[i];
+	return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how block_cache_get()/block_cache_put() of blocks that are
+	already in the cache scale with the number of threads.
+*/
+
+
+#define write_pos	block_cache_write_pos
+#define read_pos	block_cache_read_pos
+
+#include "block_cache.cpp"
+
+#undef write_pos
+#undef read_pos
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static const size_t kBlockSize = 2048;
+
+static off_t sNumBlocks = 65536;
+static off_t sWorkingSet = 1024;
+static int32 sIterations = 1000000;
+static block_cache* sCache;
+
+
+ssize_t
+block_cache_write_pos(int fd, off_t offset, const void* buffer, size_t size)
+{
+	return size;
+}
+
+
+ssize_t
+block_cache_read_pos(int fd, off_t offset, void* buffer, size_t size)
+{
+	memset(buffer, (uint8)(offset / kBlockSize), size);
+	return size;
+}
+
+
+static status_t
+stress_thread(void* data)
+{
+	uint32 seed = (uint32)(addr_t)data;
+
+	for (int32 i = 0; i < sIterations; i++) {
+		seed = seed * 1103515245 + 12345;
+		off_t blockNumber = (seed >> 8) % sWorkingSet;
+
+		const uint8* block = (const uint8*)block_cache_get(sCache,
+			blockNumber);
+		if (block == NULL)
+			return B_NO_MEMORY;
+
+		if (block[0] != (uint8)blockNumber) {
+			fprintf(stderr, "block %" B_PRIdOFF " has wrong contents!\n",
+				blockNumber);
+			block_cache_put(sCache, blockNumber);
+			return B_BAD_DATA;
+		}
+
+		block_cache_put(sCache, blockNumber);
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+run_stress(int32 threadCount)
+{
+	thread_id threads[threadCount];
+
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		threads[i] = spawn_thread(&stress_thread, "block cache stress",
+			B_NORMAL_PRIORITY, (void*)(addr_t)(i + 1));
+		if (threads[i] < 0)
+			return threads[i];
+	}
+	for (int32 i = 0; i < threadCount; i++)
+		resume_thread(threads[i]);
+
+	status_t result = B_OK;
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t threadResult;
+		wait_for_thread(threads[i], &threadResult);
+		if (threadResult != B_OK)
+			result = threadResult;
+	}
+
+	bigtime_t duration = system_time() - start;
+	if (result != B_OK)
+		return result;
+
+	double operations = (double)sIterations * threadCount;
+	printf("%7" B_PRId32 " %12.0f %12.1f\n", threadCount,
+		operations * 1000000.0 / duration,
+		(double)duration * 1000.0 / sIterations);
+	return B_OK;
+}
+
+
+static void
+usage(const char* programName)
+{
+	fprintf(stderr, "Usage: %s [-t <max-threads>] [-n <iterations>] "
+		"[-w <working-set>]\n"
+		"  -t  maximum number of concurrent threads (default: CPU count)\n"
+		"  -n  number of get/put pairs per thread\n"
+		"  -w  number of distinct blocks accessed\n", programName);
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	system_info info;
+	get_system_info(&info);
+	int32 maxThreads = info.cpu_count;
+
+	int option;
+	while ((option = getopt(argc, argv, "t:n:w:h")) != -1) {
+		switch (option) {
+			case 't':
+				maxThreads = atol(optarg);
+				break;
+			case 'n':
+				sIterations = atol(optarg);
+				break;
+			case 'w':
+				sWorkingSet = strtoll(optarg, NULL, 0);
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if (maxThreads < 1 || sIterations < 1 || sWorkingSet < 1
+		|| sWorkingSet > sNumBlocks) {
+		usage(argv[0]);
+	}
+
+	block_cache_init();
+
+	sCache = (block_cache*)block_cache_create(-1, sNumBlocks, kBlockSize,
+		true);
+	if (sCache == NULL) {
+		fprintf(stderr, "Could not create block cache!\n");
+		return 1;
+	}
+
+	// warm up the cache, so that we only measure lookups
+	for (off_t blockNumber = 0; blockNumber < sWorkingSet; blockNumber++) {
+		if (block_cache_get(sCache, blockNumber) == NULL) {
+			fprintf(stderr, "Could not read block %" B_PRIdOFF "\n",
+				blockNumber);
+			return 1;
+		}
+		block_cache_put(sCache, blockNumber);
+	}
+
+	printf("threads      ops/sec  ns/op/thread\n");
+
+	// double the thread count, but always end with maxThreads
+	for (int32 threads = 1;; threads = min_c(threads * 2, maxThreads)) {
+		status_t status = run_stress(threads);
+		if (status != B_OK) {
+			fprintf(stderr, "Stress run failed: %s\n", strerror(status));
+			return 1;
+		}
+		if (threads == maxThreads)
+			break;
+	}
+
+	block_cache_delete(sCache, false);
+	return 0;
+}
@@ -8,9 +8,11 @@
 #include <syscalls.h>
 #include <generic_syscall.h>
 
+#include <block_cache.h>
 #include <file_cache.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 
@@ -20,14 +22,66 @@ extern const char *__progname;
 void
 usage()
 {
-	fprintf(stderr, "usage: %s [clear | unset | set <module-name>]\n", __progname);
+	fprintf(stderr, "usage: %s [clear | unset | set <module-name> | stats]\n", __progname);
 	exit(0);
 }
 
 
+int
+dump_block_cache_stats()
+{
+	int32 count = _kern_generic_syscall(BLOCK_CACHE_SYSCALLS,
+		BLOCK_CACHE_GET_STATS, NULL, 0);
+	if (count < 0) {
+		fprintf(stderr, "%s: The block cache syscalls are not available on this system.\n", __progname);
+		return 1;
+	}
+
+	block_cache_stats *stats = (block_cache_stats *)malloc(
+		count * sizeof(block_cache_stats));
+	if (stats == NULL && count > 0) {
+		fprintf(stderr, "%s: out of memory\n", __progname);
+		return 1;
+	}
+
+	int32 available = _kern_generic_syscall(BLOCK_CACHE_SYSCALLS,
+		BLOCK_CACHE_GET_STATS, stats, count * sizeof(block_cache_stats));
+	if (available < 0) {
+		fprintf(stderr, "%s: getting the block cache statistics failed: %s\n",
+			__progname, strerror(available));
+		free(stats);
+		return 1;
+	}
+	if (available < count)
+		count = available;
+
+	printf("block size     blocks  unused   dirty         hits       misses"
+		"   prefetched       p-hits       wasted window\n");
+
+	for (int32 i = 0; i < count; i++) {
+		printf("%10lu %10lld %7lu %7lu %12llu %12llu %12llu %12llu %12llu %6lu\n",
+			(unsigned long)stats[i].block_size, (long long)stats[i].max_blocks,
+			(unsigned long)stats[i].unused_blocks,
+			(unsigned long)stats[i].dirty_blocks,
+			(unsigned long long)stats[i].hits,
+			(unsigned long long)stats[i].misses,
+			(unsigned long long)stats[i].prefetched_blocks,
+			(unsigned long long)stats[i].prefetch_hits,
+			(unsigned long long)stats[i].prefetch_wasted,
+			(unsigned long)stats[i].prefetch_window);
+	}
+
+	free(stats);
+	return 0;
+}
+
+
 int
 main(int argc, char **argv)
 {
+	if (argc == 2 && !strcmp(argv[1], "stats"))
+		return dump_block_cache_stats();
+
 	uint32 version = 0;
 	status_t status = _kern_generic_syscall(CACHE_SYSCALLS, B_SYSCALL_INFO, &version, sizeof(version));
 	if (status != B_OK) {
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Runs periodic threads against CPU hogs of a higher priority, and counts
+	how often they miss their deadlines, first with a normal priority, then
+	as deadline threads. Also checks that admission control rejects threads
+	once the CPUs are fully booked, also when the threads are moved to another
+	CPU.
+*/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <OS.h>
+#include <scheduler.h>
+
+#include <syscalls.h>
+
+
+extern const char* __progname;
+
+static const int kMaxThreads = 64;
+
+static bigtime_t sRuntime = 1000;
+static bigtime_t sPeriod = 5000;
+static bigtime_t sDuration = 3000000;
+static int sThreadCount = 2;
+
+static volatile bool sStop;
+
+
+struct periodic_result {
+	bool		use_deadline;
+	status_t	status;
+	int64		periods;
+	int64		misses;
+	bigtime_t	max_lateness;
+};
+
+
+static bigtime_t
+thread_cpu_time()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return time.tv_sec * 1000000LL + time.tv_nsec / 1000;
+}
+
+
+static status_t
+hog_thread(void*)
+{
+	while (!sStop)
+		;
+	return B_OK;
+}
+
+
+static status_t
+periodic_thread(void* _result)
+{
+	periodic_result* result = (periodic_result*)_result;
+
+	if (result->use_deadline) {
+		result->status = set_thread_deadline(find_thread(NULL), sRuntime,
+			sPeriod, sPeriod);
+		if (result->status != B_OK)
+			return result->status;
+	}
+
+	// use a bit less than the budget, to leave room for the overhead
+	const bigtime_t work = sRuntime * 8 / 10;
+
+	bigtime_t release = system_time() + sPeriod;
+	while (!sStop) {
+		snooze_until(release, B_SYSTEM_TIMEBASE);
+
+		bigtime_t end = thread_cpu_time() + work;
+		while (thread_cpu_time() < end)
+			;
+
+		bigtime_t lateness = system_time() - (release + sPeriod);
+		if (lateness > 0) {
+			result->misses++;
+			if (lateness > result->max_lateness)
+				result->max_lateness = lateness;
+		}
+		result->periods++;
+
+		release += sPeriod;
+		if (release < system_time()) {
+			// skip the periods we missed completely
+			bigtime_t behind = system_time() - release;
+			release += (behind / sPeriod + 1) * sPeriod;
+		}
+	}
+
+	return B_OK;
+}
+
+
+static void
+run(const char* name, bool useDeadline)
+{
+	system_info info;
+	get_system_info(&info);
+
+	thread_id hogs[kMaxThreads];
+	thread_id threads[kMaxThreads];
+	periodic_result results[kMaxThreads];
+
+	sStop = false;
+
+	// the hogs would starve the periodic threads without a deadline
+	int hogCount = info.cpu_count < kMaxThreads ? info.cpu_count : kMaxThreads;
+	for (int i = 0; i < hogCount; i++) {
+		hogs[i] = spawn_thread(&hog_thread, "hog", B_URGENT_DISPLAY_PRIORITY,
+			NULL);
+		resume_thread(hogs[i]);
+	}
+
+	for (int i = 0; i < sThreadCount; i++) {
+		memset(&results[i], 0, sizeof(periodic_result));
+		results[i].use_deadline = useDeadline;
+		threads[i] = spawn_thread(&periodic_thread, "periodic",
+			B_DISPLAY_PRIORITY, &results[i]);
+		resume_thread(threads[i]);
+	}
+
+	snooze(sDuration);
+	sStop = true;
+
+	status_t status;
+	for (int i = 0; i < sThreadCount; i++)
+		wait_for_thread(threads[i], &status);
+	for (int i = 0; i < hogCount; i++)
+		wait_for_thread(hogs[i], &status);
+
+	for (int i = 0; i < sThreadCount; i++) {
+		if (results[i].status != B_OK) {
+			printf("%-8s thread %d: could not set deadline: %s\n", name, i,
+				strerror(results[i].status));
+			continue;
+		}
+
+		printf("%-8s thread %d: %" B_PRId64 " periods, %" B_PRId64 " missed "
+			"(%.1f%%), maximum lateness %" B_PRIdBIGTIME " us\n", name, i,
+			results[i].periods, results[i].misses,
+			results[i].periods > 0
+				? results[i].misses * 100.0 / results[i].periods : 0.0,
+			results[i].max_lateness);
+	}
+}
+
+
+static status_t
+sleeping_thread(void*)
+{
+	while (!sStop)
+		snooze(10000);
+	return B_OK;
+}
+
+
+/*!	Books half of a CPU for as many threads as there are CPUs twice. Only
+	some of them may be admitted.
+*/
+static void
+admission()
+{
+	system_info info;
+	get_system_info(&info);
+
+	int count = info.cpu_count * 2;
+	if (count > kMaxThreads)
+		count = kMaxThreads;
+
+	thread_id threads[kMaxThreads];
+	bool isAdmitted[kMaxThreads];
+	sStop = false;
+
+	int admitted = 0;
+	for (int i = 0; i < count; i++) {
+		threads[i] = spawn_thread(&sleeping_thread, "sleeping",
+			B_NORMAL_PRIORITY, NULL);
+		resume_thread(threads[i]);
+
+		status_t status = set_thread_deadline(threads[i], sPeriod / 2,
+			sPeriod, sPeriod);
+		isAdmitted[i] = status == B_OK;
+		if (status == B_OK)
+			admitted++;
+		else if (status != B_BUSY) {
+			printf("admission: unexpected error: %s\n", strerror(status));
+			break;
+		}
+	}
+
+	// Moving the threads over to the first CPU must only work as long as its
+	// core has bandwidth left.
+	uint32 mask[8] = { 1 };
+	int moved = 0;
+	int busy = 0;
+	for (int i = 0; i < count; i++) {
+		if (!isAdmitted[i])
+			continue;
+
+		status_t status = _kern_set_thread_affinity(threads[i], mask,
+			sizeof(mask));
+		if (status == B_OK)
+			moved++;
+		else if (status == B_BUSY)
+			busy++;
+		else {
+			printf("admission: unexpected affinity error: %s\n",
+				strerror(status));
+			break;
+		}
+	}
+
+	sStop = true;
+	status_t status;
+	for (int i = 0; i < count; i++)
+		wait_for_thread(threads[i], &status);
+
+	printf("admission: %d of %d threads with 50%% of a CPU admitted "
+		"(%" B_PRId32 " CPUs)%s\n", admitted, count, info.cpu_count,
+		admitted < count ? "" : ", FAILED");
+	printf("admission: %d threads moved to CPU 0, %d rejected%s\n", moved,
+		busy, moved > 0 && moved + busy == admitted ? "" : ", FAILED");
+
+	// the bandwidth must have been released with the threads
+	thread_id thread = spawn_thread(&sleeping_thread, "sleeping",
+		B_NORMAL_PRIORITY, NULL);
+	sStop = false;
+	resume_thread(thread);
+	status = set_thread_deadline(thread, sPeriod / 2, sPeriod, sPeriod);
+	sStop = true;
+	wait_for_thread(thread, NULL);
+
+	printf("admission: after the threads are gone: %s\n", strerror(status));
+}
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-r runtime] [-p period] [-t threads] "
+		"[-d seconds]\n"
+		"Times are in microseconds, the deadline is the end of the period.\n",
+		__progname);
+	exit(exitCode);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int option;
+	while ((option = getopt(argc, argv, "hr:p:t:d:")) != -1) {
+		switch (option) {
+			case 'r':
+				sRuntime = strtoll(optarg, NULL, 0);
+				break;
+			case 'p':
+				sPeriod = strtoll(optarg, NULL, 0);
+				break;
+			case 't':
+				sThreadCount = strtol(optarg, NULL, 0);
+				break;
+			case 'd':
+				sDuration = strtoll(optarg, NULL, 0) * 1000000LL;
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	if (sRuntime <= 0 || sPeriod < sRuntime || sThreadCount < 1
+		|| sThreadCount > kMaxThreads || sDuration <= 0) {
+		usage(1);
+	}
+
+	// make sure we get to stop the hogs
+	set_thread_priority(find_thread(NULL), B_REAL_TIME_PRIORITY);
+
+	run("normal", false);
+	run("deadline", true);
+	admission();
+
+	return 0;
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares random accesses to a large area with and without the
+	B_LARGE_PAGES_AREA hint, which should show the cost of TLB misses, and
+	verifies that the contents of a large page area survive partially
+	changing its protection, resizing it, and copy-on-write after fork().
+*/
+
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <vm_defs.h>
+
+
+extern const char* __progname;
+
+static const size_t kLargePageSize = 2 * 1024 * 1024;
+
+static size_t sAreaSize = 256 * 1024 * 1024;
+static int32 sAccesses = 16 * 1024 * 1024;
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-s megabytes] [-n accesses]\n"
+		"Measures random accesses to an area with and without large pages, "
+		"and tests\nthe integrity of large page areas.\n", __progname);
+	exit(exitCode);
+}
+
+
+static inline uint32
+pattern(size_t index)
+{
+	return (uint32)(index * 2654435761UL);
+}
+
+
+static area_id
+create_test_area(uint32** _address, size_t size, bool largePages)
+{
+	area_id area = create_area(largePages ? "large pages" : "small pages",
+		(void**)_address, B_ANY_ADDRESS, size, B_NO_LOCK,
+		B_READ_AREA | B_WRITE_AREA | (largePages ? B_LARGE_PAGES_AREA : 0));
+	if (area < 0) {
+		fprintf(stderr, "%s: could not create area: %s\n", __progname,
+			strerror(area));
+		exit(1);
+	}
+
+	return area;
+}
+
+
+static bool
+verify(const char* test, const uint32* data, size_t size)
+{
+	for (size_t i = 0; i < size / sizeof(uint32); i++) {
+		if (data[i] != pattern(i)) {
+			fprintf(stderr, "%s: %s: data mismatch at offset %#zx\n",
+				__progname, test, i * sizeof(uint32));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static void
+fill(uint32* data, size_t size)
+{
+	for (size_t i = 0; i < size / sizeof(uint32); i++)
+		data[i] = pattern(i);
+}
+
+
+static void
+benchmark(bool largePages)
+{
+	uint32* data;
+	area_id area = create_test_area(&data, sAreaSize, largePages);
+
+	bigtime_t start = system_time();
+	fill(data, sAreaSize);
+	bigtime_t faultTime = system_time() - start;
+
+	// visit the area in random order, one access per page
+	size_t pageCount = sAreaSize / B_PAGE_SIZE;
+	uint32 random = 0x12345678;
+	uint32 sum = 0;
+
+	start = system_time();
+	for (int32 i = 0; i < sAccesses; i++) {
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		size_t page = random % pageCount;
+		sum += data[page * (B_PAGE_SIZE / sizeof(uint32))
+			+ (random >> 24) % (B_PAGE_SIZE / sizeof(uint32))];
+	}
+	bigtime_t accessTime = system_time() - start;
+
+	printf("%s: populated in %" B_PRId64 " ms, %" B_PRId32 " random accesses "
+		"in %" B_PRId64 " ms (%.1f ns per access, sum %" B_PRIx32 ")\n",
+		largePages ? "large pages" : "small pages", faultTime / 1000,
+		sAccesses, accessTime / 1000, accessTime * 1000.0 / sAccesses, sum);
+
+	delete_area(area);
+}
+
+
+static bool
+test_partial_protection()
+{
+	size_t size = 4 * kLargePageSize;
+	uint32* data;
+	area_id area = create_test_area(&data, size, true);
+	fill(data, size);
+
+	// protect a single page in the middle of a large page
+	uint8* page = (uint8*)data + kLargePageSize + 5 * B_PAGE_SIZE;
+	if (mprotect(page, B_PAGE_SIZE, PROT_READ) != 0) {
+		fprintf(stderr, "%s: mprotect() failed: %s\n", __progname,
+			strerror(errno));
+		return false;
+	}
+
+	bool success = verify("partial protection", data, size);
+
+	// the neighbours of the page must still be writable
+	uint32* previous = (uint32*)(page - B_PAGE_SIZE);
+	uint32* next = (uint32*)(page + B_PAGE_SIZE);
+	*previous = pattern(previous - data);
+	*next = pattern(next - data);
+
+	if (mprotect(page, B_PAGE_SIZE, PROT_READ | PROT_WRITE) != 0)
+		success = false;
+
+	// change the protection of the whole area back and forth
+	if (set_area_protection(area, B_READ_AREA) != B_OK
+		|| !verify("area protection", data, size)
+		|| set_area_protection(area, B_READ_AREA | B_WRITE_AREA) != B_OK) {
+		success = false;
+	}
+
+	delete_area(area);
+	return success;
+}
+
+
+static bool
+test_resize()
+{
+	size_t size = 4 * kLargePageSize;
+	uint32* data;
+	area_id area = create_test_area(&data, size, true);
+	fill(data, size);
+
+	size_t newSize = 2 * kLargePageSize + 3 * B_PAGE_SIZE;
+	status_t status = resize_area(area, newSize);
+	if (status != B_OK) {
+		fprintf(stderr, "%s: resize_area() failed: %s\n", __progname,
+			strerror(status));
+		delete_area(area);
+		return false;
+	}
+
+	bool success = verify("resize", data, newSize);
+	delete_area(area);
+	return success;
+}
+
+
+static bool
+test_fork()
+{
+	size_t size = 4 * kLargePageSize;
+	uint32* data;
+	area_id area = create_test_area(&data, size, true);
+	fill(data, size);
+
+	pid_t child = fork();
+	if (child < 0) {
+		fprintf(stderr, "%s: fork() failed: %s\n", __progname,
+			strerror(errno));
+		delete_area(area);
+		return false;
+	}
+
+	if (child == 0) {
+		// overwrite every other page in the child
+		bool success = verify("fork (child)", data, size);
+		for (size_t offset = 0; offset < size; offset += 2 * B_PAGE_SIZE)
+			data[offset / sizeof(uint32)] = ~pattern(offset / sizeof(uint32));
+		_exit(success ? 0 : 1);
+	}
+
+	int childStatus;
+	if (waitpid(child, &childStatus, 0) != child || !WIFEXITED(childStatus)
+		|| WEXITSTATUS(childStatus) != 0) {
+		fprintf(stderr, "%s: the child failed\n", __progname);
+		delete_area(area);
+		return false;
+	}
+
+	// the parent must not see the changes of the child
+	bool success = verify("fork (parent)", data, size);
+	delete_area(area);
+	return success;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int option;
+	while ((option = getopt(argc, argv, "hs:n:")) != -1) {
+		switch (option) {
+			case 's':
+				sAreaSize = strtoul(optarg, NULL, 0) * 1024 * 1024;
+				break;
+			case 'n':
+				sAccesses = strtol(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	if (sAreaSize < kLargePageSize || sAccesses < 1)
+		usage(1);
+
+	if (!test_partial_protection() || !test_resize() || !test_fork())
+		return 1;
+	printf("All tests passed.\n");
+
+	benchmark(false);
+	benchmark(true);
+
+	return 0;
+}
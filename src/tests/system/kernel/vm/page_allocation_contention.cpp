@@ -0,0 +1,158 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how well page allocation scales with the number of threads:
+	every thread repeatedly creates an area, faults in all of its pages, and
+	deletes it again, so that pages are allocated and freed concurrently on
+	all CPUs.
+*/
+
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+extern const char* __progname;
+
+static const int32 kMaxThreads = 256;
+
+static size_t sAreaSize = 4 * 1024 * 1024;
+static int32 sIterations = 256;
+
+
+struct thread_args {
+	int32		index;
+	status_t	result;
+};
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-t threads] [-s kilobytes] [-i iterations]\n"
+		"Faults in and frees pages from several threads at once, and reports "
+		"the number\nof pages allocated per second. The number of threads "
+		"defaults to the number of\nCPUs, and the test is repeated with one "
+		"thread for comparison.\n", __progname);
+	exit(exitCode);
+}
+
+
+static status_t
+fault_pages(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+	args->result = B_OK;
+
+	for (int32 i = 0; i < sIterations; i++) {
+		uint8* address;
+		area_id area = create_area("page allocation contention",
+			(void**)&address, B_ANY_ADDRESS, sAreaSize, B_NO_LOCK,
+			B_READ_AREA | B_WRITE_AREA);
+		if (area < 0) {
+			args->result = area;
+			break;
+		}
+
+		for (size_t offset = 0; offset < sAreaSize; offset += B_PAGE_SIZE)
+			address[offset] = (uint8)(args->index + i);
+
+		delete_area(area);
+	}
+
+	return args->result;
+}
+
+
+static bool
+run(int32 threadCount)
+{
+	thread_id threads[kMaxThreads];
+	thread_args args[kMaxThreads];
+
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		args[i].index = i;
+		threads[i] = spawn_thread(&fault_pages, "fault pages",
+			B_NORMAL_PRIORITY, &args[i]);
+		if (threads[i] < 0) {
+			fprintf(stderr, "%s: could not spawn thread: %s\n", __progname,
+				strerror(threads[i]));
+			return false;
+		}
+	}
+
+	for (int32 i = 0; i < threadCount; i++)
+		resume_thread(threads[i]);
+
+	bool success = true;
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t returnValue;
+		wait_for_thread(threads[i], &returnValue);
+		if (args[i].result != B_OK) {
+			fprintf(stderr, "%s: thread %" B_PRId32 " failed: %s\n",
+				__progname, i, strerror(args[i].result));
+			success = false;
+		}
+	}
+
+	bigtime_t time = system_time() - start;
+	if (!success)
+		return false;
+
+	int64 pages = (int64)threadCount * sIterations * (sAreaSize / B_PAGE_SIZE);
+	printf("%2" B_PRId32 " threads: %" B_PRId64 " pages in %" B_PRId64 " ms, "
+		"%.0f pages/s\n", threadCount, pages, time / 1000,
+		pages * 1000000.0 / time);
+	return true;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	system_info info;
+	get_system_info(&info);
+	int32 threadCount = info.cpu_count;
+
+	int option;
+	while ((option = getopt(argc, argv, "ht:s:i:")) != -1) {
+		switch (option) {
+			case 't':
+				threadCount = strtol(optarg, NULL, 0);
+				break;
+			case 's':
+				sAreaSize = strtoul(optarg, NULL, 0) * 1024;
+				break;
+			case 'i':
+				sIterations = strtol(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	sAreaSize = (sAreaSize + B_PAGE_SIZE - 1) & ~(B_PAGE_SIZE - 1);
+	if (threadCount < 1 || threadCount > kMaxThreads || sAreaSize == 0
+		|| sIterations < 1)
+		usage(1);
+
+	if (!run(1))
+		return 1;
+	if (threadCount > 1 && !run(threadCount))
+		return 1;
+
+	return 0;
+}
@@ -0,0 +1,503 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Allocator benchmarks modeled after the classic larson and xmalloc-test
+	benchmarks, and a fragmentation test.
+
+	The program only uses POSIX functionality, so that it can also be run on
+	the build platform, where it can be compared against other allocators by
+	preloading them.
+*/
+
+
+#include <getopt.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __HAIKU__
+#	include <OS.h>
+#endif
+
+
+static const int kMaxThreads = 256;
+static const int kLarsonSlots = 1000;
+static const int kLarsonRounds = 10000;
+static const int kBatchSize = 100;
+static const int kMaxQueuedBatches = 64;
+static const int kFragmentationObjects = 100000;
+
+static const char* sProgramName;
+static int sThreadCount;
+static double sDuration = 2.0;
+static size_t sMinSize = 16;
+static size_t sMaxSize = 1024;
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-t threads] [-d seconds] [-m min-size] "
+		"[-M max-size] [test...]\n"
+		"Runs the larson, xmalloc, and fragmentation allocator benchmarks, or "
+		"the given\nones. The number of threads defaults to the number of "
+		"CPUs.\n", sProgramName);
+	exit(exitCode);
+}
+
+
+static double
+current_time()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+
+static inline uint32_t
+next_random(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+
+static inline size_t
+random_size(uint32_t& state)
+{
+	return sMinSize + next_random(state) % (sMaxSize - sMinSize + 1);
+}
+
+
+static size_t
+resident_size()
+{
+#ifdef __HAIKU__
+	size_t size = 0;
+	ssize_t cookie = 0;
+	area_info info;
+	while (get_next_area_info(B_CURRENT_TEAM, &cookie, &info) == B_OK)
+		size += info.ram_size;
+	return size;
+#else
+	FILE* file = fopen("/proc/self/statm", "r");
+	if (file == NULL)
+		return 0;
+
+	unsigned long pages = 0;
+	unsigned long resident = 0;
+	if (fscanf(file, "%lu %lu", &pages, &resident) != 2)
+		resident = 0;
+	fclose(file);
+	return resident * sysconf(_SC_PAGESIZE);
+#endif
+}
+
+
+static bool
+run_threads(void* (*function)(void*), void** args, int count)
+{
+	pthread_t threads[kMaxThreads];
+
+	for (int i = 0; i < count; i++) {
+		if (pthread_create(&threads[i], NULL, function, args[i]) != 0) {
+			fprintf(stderr, "%s: could not create thread\n", sProgramName);
+			for (int j = 0; j < i; j++)
+				pthread_join(threads[j], NULL);
+			return false;
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+		pthread_join(threads[i], NULL);
+
+	return true;
+}
+
+
+//	#pragma mark - larson
+
+
+/*!	Every thread repeatedly replaces random objects in its array of slots.
+	After each round, the threads exit, and new threads take over the arrays
+	of their neighbours, so that objects are freed by other threads than the
+	ones that allocated them.
+*/
+
+
+struct larson_args {
+	void**		slots;
+	uint32_t	random;
+	uint64_t	operations;
+	double		end;
+	bool		done;
+};
+
+
+static void*
+larson_thread(void* _args)
+{
+	larson_args* args = (larson_args*)_args;
+
+	for (int i = 0; i < kLarsonRounds; i++) {
+		int slot = next_random(args->random) % kLarsonSlots;
+		free(args->slots[slot]);
+
+		size_t size = random_size(args->random);
+		char* object = (char*)malloc(size);
+		if (object == NULL) {
+			fprintf(stderr, "%s: out of memory\n", sProgramName);
+			exit(1);
+		}
+		object[0] = (char)i;
+		object[size - 1] = (char)i;
+		args->slots[slot] = object;
+	}
+
+	args->operations += kLarsonRounds;
+	args->done = current_time() >= args->end;
+	return NULL;
+}
+
+
+static bool
+larson()
+{
+	larson_args args[kMaxThreads];
+	void* threadArgs[kMaxThreads];
+
+	double start = current_time();
+
+	for (int i = 0; i < sThreadCount; i++) {
+		args[i].slots = (void**)calloc(kLarsonSlots, sizeof(void*));
+		if (args[i].slots == NULL)
+			return false;
+		args[i].random = 0x9e3779b9 * (i + 1);
+		args[i].operations = 0;
+		args[i].end = start + sDuration;
+		threadArgs[i] = &args[i];
+	}
+
+	int generations = 0;
+	while (true) {
+		if (!run_threads(&larson_thread, threadArgs, sThreadCount))
+			return false;
+		generations++;
+
+		if (args[0].done)
+			break;
+
+		// pass the slots on to the next thread
+		void** firstSlots = args[0].slots;
+		for (int i = 0; i < sThreadCount - 1; i++)
+			args[i].slots = args[i + 1].slots;
+		args[sThreadCount - 1].slots = firstSlots;
+	}
+
+	double time = current_time() - start;
+
+	uint64_t operations = 0;
+	for (int i = 0; i < sThreadCount; i++) {
+		operations += args[i].operations;
+		for (int j = 0; j < kLarsonSlots; j++)
+			free(args[i].slots[j]);
+		free(args[i].slots);
+	}
+
+	printf("larson: %.0f operations/s (%d generations)\n", operations / time,
+		generations);
+	return true;
+}
+
+
+//	#pragma mark - xmalloc
+
+
+/*!	Half of the threads allocate objects, and pass them in batches to the
+	other half that frees them.
+*/
+
+
+struct batch_queue {
+	pthread_mutex_t	lock;
+	pthread_cond_t	condition;
+	void**			batches[kMaxQueuedBatches];
+	int				count;
+	int				producers;
+};
+
+
+struct xmalloc_args {
+	batch_queue*	queue;
+	bool			producer;
+	uint32_t		random;
+	uint64_t		operations;
+	double			end;
+};
+
+
+static void*
+xmalloc_producer(void* _args)
+{
+	xmalloc_args* args = (xmalloc_args*)_args;
+	batch_queue* queue = args->queue;
+
+	while (current_time() < args->end) {
+		void** batch = (void**)malloc(kBatchSize * sizeof(void*));
+		if (batch == NULL)
+			exit(1);
+
+		for (int i = 0; i < kBatchSize; i++) {
+			size_t size = random_size(args->random);
+			char* object = (char*)malloc(size);
+			if (object == NULL) {
+				fprintf(stderr, "%s: out of memory\n", sProgramName);
+				exit(1);
+			}
+			object[0] = (char)i;
+			batch[i] = object;
+		}
+		args->operations += kBatchSize;
+
+		pthread_mutex_lock(&queue->lock);
+		while (queue->count == kMaxQueuedBatches)
+			pthread_cond_wait(&queue->condition, &queue->lock);
+		queue->batches[queue->count++] = batch;
+		pthread_cond_broadcast(&queue->condition);
+		pthread_mutex_unlock(&queue->lock);
+	}
+
+	pthread_mutex_lock(&queue->lock);
+	queue->producers--;
+	pthread_cond_broadcast(&queue->condition);
+	pthread_mutex_unlock(&queue->lock);
+	return NULL;
+}
+
+
+static void*
+xmalloc_consumer(void* _args)
+{
+	xmalloc_args* args = (xmalloc_args*)_args;
+	batch_queue* queue = args->queue;
+
+	while (true) {
+		pthread_mutex_lock(&queue->lock);
+		while (queue->count == 0 && queue->producers > 0)
+			pthread_cond_wait(&queue->condition, &queue->lock);
+		if (queue->count == 0) {
+			pthread_mutex_unlock(&queue->lock);
+			break;
+		}
+		void** batch = queue->batches[--queue->count];
+		pthread_cond_broadcast(&queue->condition);
+		pthread_mutex_unlock(&queue->lock);
+
+		for (int i = 0; i < kBatchSize; i++)
+			free(batch[i]);
+		free(batch);
+		args->operations += kBatchSize;
+	}
+
+	return NULL;
+}
+
+
+static void*
+xmalloc_thread(void* _args)
+{
+	xmalloc_args* args = (xmalloc_args*)_args;
+	if (args->producer)
+		return xmalloc_producer(args);
+
+	return xmalloc_consumer(args);
+}
+
+
+static bool
+xmalloc()
+{
+	int threadCount = sThreadCount < 2 ? 2 : sThreadCount & ~1;
+
+	batch_queue queue;
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.condition, NULL);
+	queue.count = 0;
+	queue.producers = threadCount / 2;
+
+	xmalloc_args args[kMaxThreads];
+	void* threadArgs[kMaxThreads];
+
+	double start = current_time();
+
+	for (int i = 0; i < threadCount; i++) {
+		args[i].queue = &queue;
+		args[i].producer = i % 2 == 0;
+		args[i].random = 0x9e3779b9 * (i + 1);
+		args[i].operations = 0;
+		args[i].end = start + sDuration;
+		threadArgs[i] = &args[i];
+	}
+
+	bool success = run_threads(&xmalloc_thread, threadArgs, threadCount);
+
+	double time = current_time() - start;
+
+	pthread_cond_destroy(&queue.condition);
+	pthread_mutex_destroy(&queue.lock);
+
+	if (!success)
+		return false;
+
+	uint64_t operations = 0;
+	for (int i = 0; i < threadCount; i++)
+		operations += args[i].operations;
+
+	printf("xmalloc: %.0f operations/s (%d producers, %d consumers)\n",
+		operations / time, threadCount / 2, threadCount / 2);
+	return true;
+}
+
+
+//	#pragma mark - fragmentation
+
+
+/*!	Allocates many objects, frees every other one of them, and then
+	allocates larger objects, which cannot reuse the holes. The resident size
+	is compared to the memory actually in use after each phase.
+*/
+static bool
+fragmentation()
+{
+	void** objects = (void**)calloc(kFragmentationObjects, sizeof(void*));
+	size_t* sizes = (size_t*)calloc(kFragmentationObjects, sizeof(size_t));
+	if (objects == NULL || sizes == NULL)
+		return false;
+
+	size_t baseSize = resident_size();
+	uint32_t random = 0x12345678;
+	size_t liveSize = 0;
+	double start = current_time();
+
+	for (int round = 0; round < 4; round++) {
+		size_t sizeFactor = 1 << round;
+
+		for (int i = 0; i < kFragmentationObjects; i++) {
+			if (objects[i] != NULL)
+				continue;
+
+			size_t size = random_size(random) * sizeFactor;
+			objects[i] = malloc(size);
+			if (objects[i] == NULL) {
+				fprintf(stderr, "%s: out of memory\n", sProgramName);
+				return false;
+			}
+			memset(objects[i], 0x55, size);
+			sizes[i] = size;
+			liveSize += size;
+		}
+
+		for (int i = round % 2; i < kFragmentationObjects; i += 2) {
+			free(objects[i]);
+			objects[i] = NULL;
+			liveSize -= sizes[i];
+		}
+
+		size_t residentSize = resident_size() - baseSize;
+		printf("fragmentation: round %d: %zu KB live, %zu KB resident "
+			"(%.2f)\n", round, liveSize / 1024, residentSize / 1024,
+			liveSize != 0 ? (double)residentSize / liveSize : 0.0);
+	}
+
+	for (int i = 0; i < kFragmentationObjects; i++)
+		free(objects[i]);
+
+	printf("fragmentation: %.0f ms, %zu KB resident after freeing "
+		"everything\n", (current_time() - start) * 1000,
+		(resident_size() - baseSize) / 1024);
+
+	free(objects);
+	free(sizes);
+	return true;
+}
+
+
+//	#pragma mark -
+
+
+struct benchmark {
+	const char*	name;
+	bool		(*function)();
+};
+
+static const benchmark kBenchmarks[] = {
+	{ "larson", &larson },
+	{ "xmalloc", &xmalloc },
+	{ "fragmentation", &fragmentation }
+};
+static const int kBenchmarkCount = sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
+
+
+int
+main(int argc, char** argv)
+{
+	sProgramName = argv[0];
+
+	long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+	sThreadCount = cpuCount > 0 ? cpuCount : 1;
+
+	int option;
+	while ((option = getopt(argc, argv, "ht:d:m:M:")) != -1) {
+		switch (option) {
+			case 't':
+				sThreadCount = strtol(optarg, NULL, 0);
+				break;
+			case 'd':
+				sDuration = strtod(optarg, NULL);
+				break;
+			case 'm':
+				sMinSize = strtoul(optarg, NULL, 0);
+				break;
+			case 'M':
+				sMaxSize = strtoul(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	if (sThreadCount > kMaxThreads)
+		sThreadCount = kMaxThreads;
+	if (sThreadCount < 1 || sDuration <= 0 || sMinSize == 0
+		|| sMaxSize < sMinSize)
+		usage(1);
+
+	printf("%d threads, %zu - %zu bytes\n", sThreadCount, sMinSize, sMaxSize);
+
+	for (int i = 0; i < kBenchmarkCount; i++) {
+		bool run = optind == argc;
+		for (int j = optind; j < argc; j++) {
+			if (strcmp(argv[j], kBenchmarks[i].name) == 0)
+				run = true;
+		}
+
+		if (run && !kBenchmarks[i].function())
+			return 1;
+	}
+
+	return 0;
+}
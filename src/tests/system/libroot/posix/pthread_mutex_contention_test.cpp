@@ -0,0 +1,349 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures pthread mutexes under contention, with critical sections of
+	different lengths, and checks whether priority inheritance prevents a
+	priority inversion.
+
+	It only uses POSIX functions besides setting thread priorities, so that
+	the results can be compared against other systems.
+*/
+
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __HAIKU__
+#	include <OS.h>
+#endif
+
+
+extern const char* __progname;
+
+static const int kMaxThreads = 64;
+
+static int sThreadCount;
+static int sDuration = 2;
+
+static pthread_mutex_t sMutex;
+static volatile bool sStop;
+static volatile uint64_t sCounter;
+
+
+struct thread_args {
+	int			work;
+	uint64_t	operations;
+};
+
+struct waiter_result {
+	bool		priority_set;
+	uint64_t	locks;
+	uint64_t	total_wait;
+	uint64_t	max_wait;
+};
+
+
+static uint64_t
+now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1000000ULL + time.tv_nsec / 1000;
+}
+
+
+static void
+busy_work(int iterations)
+{
+	for (volatile int i = 0; i < iterations; i++)
+		;
+}
+
+
+static void
+busy_wait(uint64_t microseconds)
+{
+	uint64_t end = now() + microseconds;
+	while (now() < end)
+		;
+}
+
+
+static bool
+set_priority(bool high)
+{
+#ifdef __HAIKU__
+	set_thread_priority(find_thread(NULL),
+		high ? B_URGENT_DISPLAY_PRIORITY : B_LOW_PRIORITY);
+	return true;
+#else
+	// only real-time priorities are strict enough for the test
+	struct sched_param param;
+	param.sched_priority = high ? 20 : 10;
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+}
+
+
+static bool
+set_medium_priority()
+{
+#ifdef __HAIKU__
+	set_thread_priority(find_thread(NULL), B_NORMAL_PRIORITY);
+	return true;
+#else
+	struct sched_param param;
+	param.sched_priority = 15;
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+}
+
+
+static void
+init_mutex(int protocol)
+{
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_setprotocol(&attributes, protocol);
+	pthread_mutex_init(&sMutex, &attributes);
+	pthread_mutexattr_destroy(&attributes);
+}
+
+
+//	#pragma mark - throughput
+
+
+static void*
+lock_loop(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+
+	while (!sStop) {
+		pthread_mutex_lock(&sMutex);
+		sCounter++;
+		busy_work(args->work);
+		pthread_mutex_unlock(&sMutex);
+
+		// some work outside of the critical section
+		busy_work(args->work);
+		args->operations++;
+	}
+
+	return NULL;
+}
+
+
+static void
+throughput(const char* name, int threadCount, int work)
+{
+	pthread_t threads[kMaxThreads];
+	thread_args args[kMaxThreads];
+
+	init_mutex(PTHREAD_PRIO_NONE);
+	sStop = false;
+
+	for (int i = 0; i < threadCount; i++) {
+		args[i].work = work;
+		args[i].operations = 0;
+		pthread_create(&threads[i], NULL, &lock_loop, &args[i]);
+	}
+
+	uint64_t start = now();
+	sleep(sDuration);
+	sStop = true;
+
+	uint64_t operations = 0;
+	uint64_t minOperations = UINT64_MAX;
+	for (int i = 0; i < threadCount; i++) {
+		pthread_join(threads[i], NULL);
+		operations += args[i].operations;
+		if (args[i].operations < minOperations)
+			minOperations = args[i].operations;
+	}
+	uint64_t time = now() - start;
+
+	pthread_mutex_destroy(&sMutex);
+
+	// the share of the slowest thread shows how fair the mutex is
+	printf("%-8s %2d threads: %10.0f locks/s, slowest thread %5.1f%%\n", name,
+		threadCount, operations * 1000000.0 / time,
+		operations > 0 ? minOperations * 100.0 * threadCount / operations
+			: 0.0);
+}
+
+
+//	#pragma mark - priority inversion
+
+
+static void*
+low_priority_owner(void* _args)
+{
+	set_priority(false);
+
+	while (!sStop) {
+		pthread_mutex_lock(&sMutex);
+		busy_wait(1000);
+		pthread_mutex_unlock(&sMutex);
+		usleep(1000);
+	}
+
+	return NULL;
+}
+
+
+static void*
+medium_priority_hog(void* _args)
+{
+	set_medium_priority();
+
+	while (!sStop)
+		busy_work(1000);
+
+	return NULL;
+}
+
+
+static void*
+high_priority_waiter(void* _result)
+{
+	waiter_result* result = (waiter_result*)_result;
+	result->priority_set = set_priority(true);
+	if (!result->priority_set)
+		return NULL;
+
+	while (!sStop) {
+		usleep(2000);
+
+		uint64_t start = now();
+		pthread_mutex_lock(&sMutex);
+		uint64_t wait = now() - start;
+		pthread_mutex_unlock(&sMutex);
+
+		if (wait > result->max_wait)
+			result->max_wait = wait;
+		result->total_wait += wait;
+		result->locks++;
+	}
+
+	return NULL;
+}
+
+
+static void
+inversion(const char* name, int protocol)
+{
+	init_mutex(protocol);
+	sStop = false;
+
+	// The medium priority threads keep all CPUs busy, so that the low
+	// priority owner only gets to run when it inherits a higher priority.
+	pthread_t hogs[kMaxThreads];
+	pthread_t owner;
+	pthread_t waiter;
+	waiter_result result = {};
+
+	pthread_create(&owner, NULL, &low_priority_owner, NULL);
+	usleep(10000);
+	for (int i = 0; i < sThreadCount; i++)
+		pthread_create(&hogs[i], NULL, &medium_priority_hog, NULL);
+	pthread_create(&waiter, NULL, &high_priority_waiter, &result);
+
+	sleep(sDuration);
+	sStop = true;
+
+	pthread_join(waiter, NULL);
+	for (int i = 0; i < sThreadCount; i++)
+		pthread_join(hogs[i], NULL);
+	pthread_join(owner, NULL);
+	pthread_mutex_destroy(&sMutex);
+
+	if (!result.priority_set) {
+		printf("%-8s skipped, real-time priorities are not available\n",
+			name);
+		return;
+	}
+
+	printf("%-8s %" PRIu64 " locks, average wait %" PRIu64 " us, "
+		"maximum %" PRIu64 " us\n", name, result.locks,
+		result.locks > 0 ? result.total_wait / result.locks : 0,
+		result.max_wait);
+}
+
+
+//	#pragma mark -
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-t threads] [-d seconds] [test ...]\n"
+		"Tests: uncontended, short, long, inversion, inherit\n"
+		"The number of threads defaults to the number of CPUs.\n",
+		__progname);
+	exit(exitCode);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	sThreadCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+	int option;
+	while ((option = getopt(argc, argv, "ht:d:")) != -1) {
+		switch (option) {
+			case 't':
+				sThreadCount = strtol(optarg, NULL, 0);
+				break;
+			case 'd':
+				sDuration = strtol(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	if (sThreadCount < 1 || sThreadCount > kMaxThreads || sDuration < 1)
+		usage(1);
+
+	static const char* kTests[] = { "uncontended", "short", "long",
+		"inversion", "inherit" };
+	const char** tests = kTests;
+	int testCount = sizeof(kTests) / sizeof(kTests[0]);
+	if (optind < argc) {
+		tests = (const char**)argv + optind;
+		testCount = argc - optind;
+	}
+
+	int threadCount = sThreadCount > 1 ? sThreadCount : 2;
+	for (int i = 0; i < testCount; i++) {
+		if (strcmp(tests[i], "uncontended") == 0)
+			throughput("uncontended", 1, 0);
+		else if (strcmp(tests[i], "short") == 0)
+			throughput("short", threadCount, 20);
+		else if (strcmp(tests[i], "long") == 0)
+			throughput("long", threadCount, 5000);
+		else if (strcmp(tests[i], "inversion") == 0)
+			inversion("inversion", PTHREAD_PRIO_NONE);
+		else if (strcmp(tests[i], "inherit") == 0)
+			inversion("inherit", PTHREAD_PRIO_INHERIT);
+		else
+			usage(1);
+	}
+
+	return 0;
+}
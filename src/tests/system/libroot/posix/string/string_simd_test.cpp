@@ -0,0 +1,510 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares the vectorized x86_64 string functions against simple reference
+	implementations, and measures their throughput.
+
+	The strings are placed at all alignments, and also right in front of an
+	inaccessible page, so that reading beyond the end of a string is caught
+	as well.
+*/
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cpuid.h>
+
+#include "string_functions.h"
+
+
+extern const char* __progname;
+
+static const size_t kMaxLength = 8192;
+
+struct implementation {
+	const char*				name;
+	const string_functions*	functions;
+};
+
+static implementation sImplementations[2];
+static int sImplementationCount;
+
+static size_t sPageSize;
+static uint32_t sSeed = 1;
+static int sErrors;
+
+
+static uint32_t
+random_value()
+{
+	sSeed = sSeed * 1103515245 + 12345;
+	return sSeed >> 8;
+}
+
+
+static bool
+cpu_supports_avx2()
+{
+	uint32_t eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0
+		|| (ecx & bit_OSXSAVE) == 0 || (ecx & bit_AVX) == 0)
+		return false;
+
+	uint32_t xcr0Low, xcr0High;
+	asm volatile("xgetbv" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0));
+	if ((xcr0Low & 0x6) != 0x6 || __get_cpuid_max(0, NULL) < 7)
+		return false;
+
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return (ebx & bit_AVX2) != 0;
+}
+
+
+/*!	Returns a page aligned buffer of at least \a size bytes that is followed
+	by an inaccessible page.
+*/
+static uint8_t*
+guarded_buffer(size_t size, size_t& _size)
+{
+	size_t pages = (size + sPageSize - 1) / sPageSize;
+	uint8_t* area = (uint8_t*)mmap(NULL, (pages + 1) * sPageSize,
+		PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (area == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+
+	mprotect(area + pages * sPageSize, sPageSize, PROT_NONE);
+	_size = pages * sPageSize;
+	return area;
+}
+
+
+/*!	Places a string of \a length bytes either at the given alignment from
+	the start of the buffer, or so that its terminator is the last accessible
+	byte.
+*/
+static char*
+place_string(uint8_t* buffer, size_t bufferSize, size_t length,
+	size_t alignment)
+{
+	if (random_value() % 2 == 0)
+		return (char*)buffer + bufferSize - length - 1;
+
+	return (char*)buffer + alignment;
+}
+
+
+//	#pragma mark - reference implementations
+
+
+static size_t
+reference_strlen(const char* string)
+{
+	size_t length = 0;
+	while (string[length] != '\0')
+		length++;
+	return length;
+}
+
+
+static const void*
+reference_memchr(const void* buffer, int c, size_t length)
+{
+	const uint8_t* bytes = (const uint8_t*)buffer;
+	for (size_t i = 0; i < length; i++) {
+		if (bytes[i] == (uint8_t)c)
+			return bytes + i;
+	}
+	return NULL;
+}
+
+
+static int
+reference_memcmp(const void* _a, const void* _b, size_t length)
+{
+	const uint8_t* a = (const uint8_t*)_a;
+	const uint8_t* b = (const uint8_t*)_b;
+	for (size_t i = 0; i < length; i++) {
+		if (a[i] != b[i])
+			return a[i] - b[i];
+	}
+	return 0;
+}
+
+
+static const char*
+reference_strchr(const char* string, int c)
+{
+	while (true) {
+		if (*string == (char)c)
+			return string;
+		if (*string == '\0')
+			return NULL;
+		string++;
+	}
+}
+
+
+static const char*
+reference_strrchr(const char* string, int c)
+{
+	const char* last = NULL;
+	while (true) {
+		if (*string == (char)c)
+			last = string;
+		if (*string == '\0')
+			return last;
+		string++;
+	}
+}
+
+
+static int
+reference_strcmp(const char* _a, const char* _b)
+{
+	const uint8_t* a = (const uint8_t*)_a;
+	const uint8_t* b = (const uint8_t*)_b;
+	while (*a != '\0' && *a == *b) {
+		a++;
+		b++;
+	}
+	return *a - *b;
+}
+
+
+static const void*
+reference_memmem(const void* _haystack, size_t haystackLength,
+	const void* needle, size_t needleLength)
+{
+	const uint8_t* haystack = (const uint8_t*)_haystack;
+	for (size_t i = 0; i + needleLength <= haystackLength; i++) {
+		if (reference_memcmp(haystack + i, needle, needleLength) == 0)
+			return haystack + i;
+	}
+	return NULL;
+}
+
+
+static const char*
+reference_strstr(const char* haystack, const char* needle)
+{
+	return (const char*)reference_memmem(haystack, reference_strlen(haystack),
+		needle, reference_strlen(needle));
+}
+
+
+//	#pragma mark - fuzzer
+
+
+static int
+sign(int value)
+{
+	return value < 0 ? -1 : value > 0 ? 1 : 0;
+}
+
+
+static void
+failed(const implementation& implementation, const char* function,
+	size_t length, size_t alignment)
+{
+	if (sErrors++ < 20) {
+		fprintf(stderr, "%s: %s %s() failed, length %zu, alignment %zu, "
+			"seed %u\n", __progname, implementation.name, function, length,
+			alignment, sSeed);
+	}
+}
+
+
+/*!	Fills the buffer with characters from a small alphabet, so that matches
+	are frequent.
+*/
+static void
+fill(uint8_t* buffer, size_t length, int alphabet)
+{
+	for (size_t i = 0; i < length; i++)
+		buffer[i] = 'a' + random_value() % alphabet;
+	if (random_value() % 4 == 0) {
+		// make sure that signedness bugs show up
+		for (size_t i = 0; i < length; i += 1 + random_value() % 16)
+			buffer[i] = 0x80 + random_value() % 0x80;
+	}
+}
+
+
+static void
+fuzz(const implementation& implementation, size_t length, size_t alignment)
+{
+	const string_functions& functions = *implementation.functions;
+
+	static size_t sBufferSize;
+	static uint8_t* sBufferA = guarded_buffer(kMaxLength + 128, sBufferSize);
+	static uint8_t* sBufferB = guarded_buffer(kMaxLength + 128, sBufferSize);
+
+	char* string = place_string(sBufferA, sBufferSize, length, alignment);
+	char* other = place_string(sBufferB, sBufferSize, length,
+		random_value() % 64);
+	alignment = (uintptr_t)string % 64;
+
+	int alphabet = 1 + random_value() % 8;
+	fill((uint8_t*)string, length, alphabet);
+	string[length] = '\0';
+
+	// put garbage after the end of the string that must be ignored
+	char* end = (char*)sBufferA + sBufferSize;
+	for (char* garbage = string + length + 1; garbage < end
+			&& garbage < string + length + 65; garbage++) {
+		*garbage = random_value() % 4 == 0 ? '\0' : 'a' + random_value() % 8;
+	}
+
+	int c = length > 0 && random_value() % 2 == 0
+		? (uint8_t)string[random_value() % length] : 'a' + random_value() % 10;
+	if (random_value() % 16 == 0)
+		c = 0;
+
+	if (functions.strlen(string) != reference_strlen(string))
+		failed(implementation, "strlen", length, alignment);
+	if (functions.memchr(string, c, length)
+			!= reference_memchr(string, c, length))
+		failed(implementation, "memchr", length, alignment);
+	if (reference_memchr(string, c, length + 1) != NULL
+		&& functions.memchr(string, c, SIZE_MAX)
+			!= reference_memchr(string, c, length + 1))
+		failed(implementation, "memchr unlimited", length, alignment);
+	if (functions.strchr(string, c) != reference_strchr(string, c))
+		failed(implementation, "strchr", length, alignment);
+	if (functions.strrchr(string, c) != reference_strrchr(string, c))
+		failed(implementation, "strrchr", length, alignment);
+
+	// compare against a copy with an optional difference
+	memcpy(other, string, length + 1);
+	if (length > 0 && random_value() % 2 == 0)
+		other[random_value() % length] = 'a' + random_value() % 8;
+	if (random_value() % 8 == 0)
+		other[random_value() % (length + 1)] = '\0';
+
+	if (sign(functions.memcmp(string, other, length))
+			!= sign(reference_memcmp(string, other, length)))
+		failed(implementation, "memcmp", length, alignment);
+	if (sign(functions.strcmp(string, other))
+			!= sign(reference_strcmp(string, other))
+		|| sign(functions.strcmp(other, string))
+			!= sign(reference_strcmp(other, string)))
+		failed(implementation, "strcmp", length, alignment);
+
+	// search for a part of the string, or for a random needle
+	size_t needleLength = random_value() % 40;
+	if (needleLength > length)
+		needleLength = length;
+	char needle[64];
+	if (random_value() % 2 == 0 && length > 0) {
+		size_t start = random_value() % (length - needleLength + 1);
+		memcpy(needle, string + start, needleLength);
+		if (needleLength > 0 && random_value() % 2 == 0)
+			needle[random_value() % needleLength] = 'a' + random_value() % 8;
+	} else
+		fill((uint8_t*)needle, needleLength, alphabet);
+	needle[needleLength] = '\0';
+
+	if (functions.memmem(string, length, needle, needleLength)
+			!= reference_memmem(string, length, needle, needleLength))
+		failed(implementation, "memmem", length, alignment);
+	if (functions.strstr(string, needle) != reference_strstr(string, needle))
+		failed(implementation, "strstr", length, alignment);
+}
+
+
+static void
+fuzz(int rounds)
+{
+	for (int implementation = 0; implementation < sImplementationCount;
+			implementation++) {
+		for (int round = 0; round < rounds; round++) {
+			size_t length;
+			switch (random_value() % 4) {
+				case 0:
+					length = random_value() % 16;
+					break;
+				case 1:
+					length = random_value() % 128;
+					break;
+				case 2:
+					length = random_value() % 1024;
+					break;
+				default:
+					length = random_value() % kMaxLength;
+					break;
+			}
+
+			fuzz(sImplementations[implementation], length,
+				random_value() % 64);
+		}
+	}
+}
+
+
+//	#pragma mark - benchmark
+
+
+static uint64_t
+now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+
+template<typename Function>
+static double
+measure(size_t length, Function function)
+{
+	size_t iterations = 1 + (64 << 20) / (length + 16);
+	uint64_t start = now();
+	for (size_t i = 0; i < iterations; i++)
+		function();
+	uint64_t time = now() - start;
+
+	// in MB/s
+	return (double)length * iterations * 1000 / time;
+}
+
+
+static void
+benchmark()
+{
+	static const size_t kLengths[] = { 8, 32, 128, 512, 4096, 65536 };
+	static const size_t kLengthCount = sizeof(kLengths) / sizeof(kLengths[0]);
+	static const size_t kBufferSize = 65536 + 128;
+
+	char* a = (char*)malloc(kBufferSize);
+	char* b = (char*)malloc(kBufferSize);
+
+	printf("%-10s %-6s %6s %5s %10s\n", "function", "impl", "length",
+		"align", "MB/s");
+
+	for (int implementation = 0; implementation < sImplementationCount;
+			implementation++) {
+		const string_functions& functions
+			= *sImplementations[implementation].functions;
+		const char* name = sImplementations[implementation].name;
+
+		for (size_t i = 0; i < kLengthCount; i++) {
+			size_t length = kLengths[i];
+			for (size_t alignment = 0; alignment < 64; alignment += 31) {
+				char* string = a + alignment;
+				char* other = b + (alignment + 5) % 64;
+				memset(string, 'a', length);
+				string[length] = '\0';
+				memcpy(other, string, length + 1);
+				const char* needle = "aab";
+
+				static volatile uintptr_t sink __attribute__((unused));
+				double results[8];
+				results[0] = measure(length, [&]() {
+					sink = functions.strlen(string); });
+				results[1] = measure(length, [&]() {
+					sink = (uintptr_t)functions.memchr(string, 'b', length); });
+				results[2] = measure(length, [&]() {
+					sink = functions.memcmp(string, other, length); });
+				results[3] = measure(length, [&]() {
+					sink = (uintptr_t)functions.strchr(string, 'b'); });
+				results[4] = measure(length, [&]() {
+					sink = (uintptr_t)functions.strrchr(string, 'b'); });
+				results[5] = measure(length, [&]() {
+					sink = functions.strcmp(string, other); });
+				results[6] = measure(length, [&]() {
+					sink = (uintptr_t)functions.memmem(string, length, needle,
+						3); });
+				results[7] = measure(length, [&]() {
+					sink = (uintptr_t)functions.strstr(string, needle); });
+
+				static const char* kNames[] = { "strlen", "memchr", "memcmp",
+					"strchr", "strrchr", "strcmp", "memmem", "strstr" };
+				for (int function = 0; function < 8; function++) {
+					printf("%-10s %-6s %6zu %5zu %10.0f\n", kNames[function],
+						name, length, alignment, results[function]);
+				}
+			}
+		}
+	}
+
+	free(a);
+	free(b);
+}
+
+
+//	#pragma mark -
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-b] [-r rounds] [-s seed]\n"
+		"Tests the vectorized string functions against reference "
+		"implementations.\n"
+		"  -b  measure the throughput instead\n", __progname);
+	exit(exitCode);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	bool runBenchmark = false;
+	int rounds = 20000;
+
+	int option;
+	while ((option = getopt(argc, argv, "hbr:s:")) != -1) {
+		switch (option) {
+			case 'b':
+				runBenchmark = true;
+				break;
+			case 'r':
+				rounds = strtol(optarg, NULL, 0);
+				break;
+			case 's':
+				sSeed = strtoul(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	sPageSize = sysconf(_SC_PAGESIZE);
+
+	sImplementations[sImplementationCount++]
+		= { "SSE2", &gStringFunctionsSSE2 };
+	if (cpu_supports_avx2()) {
+		sImplementations[sImplementationCount++]
+			= { "AVX2", &gStringFunctionsAVX2 };
+	} else
+		printf("AVX2 is not supported, skipping it.\n");
+
+	if (runBenchmark) {
+		benchmark();
+		return 0;
+	}
+
+	fuzz(rounds);
+	if (sErrors != 0) {
+		fprintf(stderr, "%s: %d errors\n", __progname, sErrors);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
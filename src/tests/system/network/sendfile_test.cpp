@@ -0,0 +1,221 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Sends a file over a TCP loopback connection and a UNIX socket pair using
+	sendfile(), and verifies what arrives on the other end.
+	TCP uses the zero-copy path, the UNIX sockets the copying fallback.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const size_t kFileSize = 1024 * 1024 + 123;
+static const off_t kOffset = 4000;
+
+
+struct send_args {
+	int		socket;
+	int		file;
+	ssize_t	result;
+};
+
+
+static uint8
+pattern(off_t offset)
+{
+	return (uint8)(offset * 7 + (offset >> 12));
+}
+
+
+static void*
+sender(void* _args)
+{
+	send_args* args = (send_args*)_args;
+
+	off_t offset = kOffset;
+	size_t left = kFileSize - kOffset;
+	args->result = 0;
+
+	while (left > 0) {
+		ssize_t bytesSent = sendfile(args->socket, args->file, &offset, left);
+		if (bytesSent <= 0) {
+			args->result = bytesSent < 0 ? -errno : -EIO;
+			break;
+		}
+
+		left -= bytesSent;
+		args->result += bytesSent;
+	}
+
+	if (args->result >= 0 && offset != (off_t)kFileSize) {
+		fprintf(stderr, "offset was not updated correctly\n");
+		args->result = -EINVAL;
+	}
+
+	close(args->socket);
+	return NULL;
+}
+
+
+static bool
+transfer(const char* name, int out, int in, int file)
+{
+	send_args args = { out, file, 0 };
+
+	// the file position must not be changed
+	lseek(file, 0, SEEK_SET);
+
+	bigtime_t start = system_time();
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, &sender, &args) != 0) {
+		fprintf(stderr, "%s: could not create thread\n", name);
+		return false;
+	}
+
+	uint8 buffer[65536];
+	off_t offset = kOffset;
+	bool success = true;
+
+	while (true) {
+		ssize_t bytesRead = read(in, buffer, sizeof(buffer));
+		if (bytesRead < 0) {
+			fprintf(stderr, "%s: read failed: %s\n", name, strerror(errno));
+			success = false;
+			break;
+		}
+		if (bytesRead == 0)
+			break;
+
+		for (ssize_t i = 0; success && i < bytesRead; i++) {
+			if (buffer[i] != pattern(offset + i)) {
+				fprintf(stderr, "%s: data mismatch at offset %lld\n", name,
+					(long long)(offset + i));
+				success = false;
+			}
+		}
+		offset += bytesRead;
+	}
+
+	pthread_join(thread, NULL);
+	close(in);
+
+	bigtime_t time = system_time() - start;
+
+	if (args.result < 0) {
+		fprintf(stderr, "%s: sendfile failed: %s\n", name,
+			strerror(-args.result));
+		return false;
+	}
+	if (offset != (off_t)kFileSize) {
+		fprintf(stderr, "%s: received %lld bytes, expected %lld\n", name,
+			(long long)(offset - kOffset), (long long)(kFileSize - kOffset));
+		return false;
+	}
+	if (lseek(file, 0, SEEK_CUR) != 0) {
+		fprintf(stderr, "%s: file position was changed\n", name);
+		return false;
+	}
+
+	if (success) {
+		printf("%s: %lld bytes in %lld us\n", name,
+			(long long)(kFileSize - kOffset), (long long)time);
+	}
+	return success;
+}
+
+
+static bool
+connect_tcp(int& out, int& in)
+{
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0)
+		return false;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addressLength = sizeof(address);
+
+	if (bind(listener, (sockaddr*)&address, addressLength) != 0
+		|| getsockname(listener, (sockaddr*)&address, &addressLength) != 0
+		|| listen(listener, 1) != 0) {
+		close(listener);
+		return false;
+	}
+
+	out = socket(AF_INET, SOCK_STREAM, 0);
+	if (out < 0 || connect(out, (sockaddr*)&address, addressLength) != 0) {
+		close(listener);
+		return false;
+	}
+
+	in = accept(listener, NULL, NULL);
+	close(listener);
+	return in >= 0;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	char path[] = "/tmp/sendfile_test_XXXXXX";
+	int file = mkstemp(path);
+	if (file < 0) {
+		fprintf(stderr, "could not create file: %s\n", strerror(errno));
+		return 1;
+	}
+	unlink(path);
+
+	uint8* data = (uint8*)malloc(kFileSize);
+	if (data == NULL)
+		return 1;
+	for (size_t i = 0; i < kFileSize; i++)
+		data[i] = pattern(i);
+
+	if (write(file, data, kFileSize) != (ssize_t)kFileSize) {
+		fprintf(stderr, "could not write file: %s\n", strerror(errno));
+		return 1;
+	}
+	free(data);
+
+	int out;
+	int in;
+	if (!connect_tcp(out, in)) {
+		fprintf(stderr, "could not connect TCP sockets: %s\n",
+			strerror(errno));
+		return 1;
+	}
+	if (!transfer("tcp", out, in, file))
+		return 1;
+
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+		fprintf(stderr, "could not create socket pair: %s\n",
+			strerror(errno));
+		return 1;
+	}
+	if (!transfer("unix", sockets[0], sockets[1], file))
+		return 1;
+
+	close(file);
+	printf("All tests passed.\n");
+	return 0;
+}
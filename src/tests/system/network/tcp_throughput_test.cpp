@@ -0,0 +1,254 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the TCP throughput over the loopback interface.
+	The MTU of the loopback interface can be lowered to that of an ethernet
+	link, in order to see how segmentation offload, and receive coalescing
+	affect the throughput of the stack.
+*/
+
+
+#include <errno.h>
+#include <getopt.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/sockio.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+extern const char* __progname;
+
+static const char* kInterface = "loop";
+
+static off_t sTotalBytes = 256 * 1024 * 1024;
+static size_t sWriteSize = 65536;
+
+
+struct send_args {
+	int		socket;
+	status_t	result;
+};
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(stderr, "usage: %s [-m mtu] [-s megabytes] [-w write-size]\n"
+		"Sends data over a TCP connection on the loopback interface, and "
+		"reports the\nthroughput. If an MTU is given, the loopback interface "
+		"uses it during the test.\n", __progname);
+	exit(exitCode);
+}
+
+
+static status_t
+set_mtu(int mtu, int* _previous)
+{
+	int socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if (socket < 0)
+		return errno;
+
+	ifreq request;
+	memset(&request, 0, sizeof(request));
+	strlcpy(request.ifr_name, kInterface, IF_NAMESIZE);
+
+	status_t status = B_OK;
+	if (_previous != NULL) {
+		if (ioctl(socket, SIOCGIFMTU, &request, sizeof(request)) < 0)
+			status = errno;
+		else
+			*_previous = request.ifr_mtu;
+	}
+
+	request.ifr_mtu = mtu;
+	if (status == B_OK && ioctl(socket, SIOCSIFMTU, &request,
+			sizeof(request)) < 0)
+		status = errno;
+
+	close(socket);
+	return status;
+}
+
+
+static void*
+sender(void* _args)
+{
+	send_args* args = (send_args*)_args;
+	args->result = B_OK;
+
+	uint8* buffer = (uint8*)malloc(sWriteSize);
+	if (buffer == NULL) {
+		args->result = B_NO_MEMORY;
+		close(args->socket);
+		return NULL;
+	}
+	memset(buffer, 0x55, sWriteSize);
+
+	off_t left = sTotalBytes;
+	while (left > 0) {
+		ssize_t bytesWritten = write(args->socket, buffer,
+			min_c((off_t)sWriteSize, left));
+		if (bytesWritten <= 0) {
+			args->result = bytesWritten < 0 ? errno : B_IO_ERROR;
+			break;
+		}
+
+		left -= bytesWritten;
+	}
+
+	free(buffer);
+	close(args->socket);
+	return NULL;
+}
+
+
+static bool
+connect_tcp(int& out, int& in)
+{
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0)
+		return false;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addressLength = sizeof(address);
+
+	if (bind(listener, (sockaddr*)&address, addressLength) != 0
+		|| getsockname(listener, (sockaddr*)&address, &addressLength) != 0
+		|| listen(listener, 1) != 0) {
+		close(listener);
+		return false;
+	}
+
+	out = socket(AF_INET, SOCK_STREAM, 0);
+	if (out < 0 || connect(out, (sockaddr*)&address, addressLength) != 0) {
+		close(listener);
+		return false;
+	}
+
+	in = accept(listener, NULL, NULL);
+	close(listener);
+	return in >= 0;
+}
+
+
+static bool
+run()
+{
+	int out;
+	int in;
+	if (!connect_tcp(out, in)) {
+		fprintf(stderr, "%s: could not connect TCP sockets: %s\n",
+			__progname, strerror(errno));
+		return false;
+	}
+
+	send_args args = { out, B_OK };
+
+	bigtime_t start = system_time();
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, &sender, &args) != 0) {
+		fprintf(stderr, "%s: could not create thread\n", __progname);
+		close(out);
+		close(in);
+		return false;
+	}
+
+	uint8 buffer[65536];
+	off_t received = 0;
+
+	while (true) {
+		ssize_t bytesRead = read(in, buffer, sizeof(buffer));
+		if (bytesRead < 0) {
+			fprintf(stderr, "%s: read failed: %s\n", __progname,
+				strerror(errno));
+			break;
+		}
+		if (bytesRead == 0)
+			break;
+
+		received += bytesRead;
+	}
+
+	pthread_join(thread, NULL);
+	close(in);
+
+	bigtime_t time = system_time() - start;
+
+	if (args.result != B_OK) {
+		fprintf(stderr, "%s: write failed: %s\n", __progname,
+			strerror(args.result));
+		return false;
+	}
+	if (received != sTotalBytes) {
+		fprintf(stderr, "%s: received %lld bytes, expected %lld\n",
+			__progname, (long long)received, (long long)sTotalBytes);
+		return false;
+	}
+
+	printf("%lld bytes in %lld ms, %.1f MB/s\n", (long long)received,
+		(long long)time / 1000, received * 1000000.0 / time / 1048576);
+	return true;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int mtu = 0;
+
+	int option;
+	while ((option = getopt(argc, argv, "hm:s:w:")) != -1) {
+		switch (option) {
+			case 'm':
+				mtu = strtol(optarg, NULL, 0);
+				break;
+			case 's':
+				sTotalBytes = strtoll(optarg, NULL, 0) * 1024 * 1024;
+				break;
+			case 'w':
+				sWriteSize = strtoul(optarg, NULL, 0);
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	if (sTotalBytes <= 0 || sWriteSize == 0)
+		usage(1);
+
+	int previousMTU = 0;
+	if (mtu != 0) {
+		status_t status = set_mtu(mtu, &previousMTU);
+		if (status != B_OK) {
+			fprintf(stderr, "%s: could not set MTU of %s: %s\n", __progname,
+				kInterface, strerror(status));
+			return 1;
+		}
+	}
+
+	bool success = run();
+
+	if (mtu != 0)
+		set_mtu(previousMTU, NULL);
+
+	return success ? 0 : 1;
+}
@@ -17,15 +17,20 @@ namespace FSShell {
 fssh_status_t
 command_checkfs(int argc, const char* const* argv)
 {
-	if (argc == 2 && !strcmp(argv[1], "--help")) {
-		fssh_dprintf("Usage: %s [-c]\n"
-			"  -c  Check only; don't perform any changes\n", argv[0]);
-		return B_OK;
-	}
-
 	bool checkOnly = false;
-	if (argc == 2 && !strcmp(argv[1], "-c"))
-		checkOnly = true;
+	bool parallel = false;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-c"))
+			checkOnly = true;
+		else if (!strcmp(argv[i], "-p"))
+			parallel = true;
+		else {
+			fssh_dprintf("Usage: %s [-c] [-p]\n"
+				"  -c  Check only; don't perform any changes\n"
+				"  -p  Check the inodes in parallel\n", argv[0]);
+			return strcmp(argv[i], "--help") ? B_BAD_VALUE : B_OK;
+		}
+	}
 
 	int rootDir = _kern_open_dir(-1, "/myfs");
 	if (rootDir < 0)
@@ -39,6 +44,8 @@ command_checkfs(int argc, const char* const* argv)
 		result.flags |= BFS_FIX_BITMAP_ERRORS | BFS_REMOVE_WRONG_TYPES
 			| BFS_REMOVE_INVALID | BFS_FIX_NAME_MISMATCHES | BFS_FIX_BPLUSTREES;
 	}
+	if (parallel)
+		result.flags |= BFS_CHECK_IN_PARALLEL;
 
 	// start checking
 	fssh_status_t status = _kern_ioctl(rootDir, BFS_IOCTL_START_CHECKING,